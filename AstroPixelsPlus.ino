@@ -60,6 +60,8 @@
 #endif
 #define USE_MDNS
 #define USE_WIFI_WEB
+// USE_LEGACY_WEB_PAGES (flash-table setup pages under /legacy) is set by the
+// astropixelsplus-legacy-pages env in platformio.ini.
 #define USE_WIFI_MARCDUINO
 // #define LIVE_STREAM
 #endif
@@ -103,7 +105,6 @@
 #define PREFERENCE_WIFI_PASS "pass"
 #define PREFERENCE_WIFI_AP "ap"
 
-#define PREFERENCE_MARCSERIAL1 "mserial1"
 #define PREFERENCE_MARCSERIAL2 "mserial2"
 #define PREFERENCE_MARCSERIAL_PASS "mserialpass"
 #define PREFERENCE_MARCSERIAL_ENABLED "mserial"
@@ -113,8 +114,12 @@
 #define PREFERENCE_BODY_LINK_ENABLED  "mbodylink"
 #define PREFERENCE_BODY_WIFI_ENABLED  "mbodywifi"
 #define PREFERENCE_BODY_PEER_IP      "bodypeerip"
+#define PREFERENCE_BODY_FRAMED        "mbodyframe"
+#define PREFERENCE_BODY_UART_BAUD     "mbodybaud"
 #define BODY_LINK_ENABLED             true   // on by default in this fork
 #define BODY_WIFI_ENABLED             true   // WiFi fallback enabled by default
+#define BODY_FRAMED_ENABLED           true   // offer framed UDP; peers that ignore it stay on text
+#define BODY_UART_BAUD                0      // rate to negotiate on the body UART; 0 keeps mserial2
 
 // Dynamic wiring config — slot counts and offsets for servoSettings[].
 // NUM_PANEL_SLOTS + NUM_HOLO_SLOTS must equal SizeOfArray(servoSettings); a
@@ -139,12 +144,14 @@
 #define PREFERENCE_MARCSOUND_RANDOM_MAX "mrandommax"
 #define PREFERENCE_MARCSOUND_LOCAL_ENABLED "msoundlocal"
 #define PREFERENCE_DROID_NAME "dname"
-#define PREFERENCE_DROID_NAME "dname"
 
 #define PREFERENCE_BADMOTIVATOR_ENABLED "badmot"
 #define PREFERENCE_FIRESTRIP_ENABLED "firest"
 #define PREFERENCE_CBI_ENABLED "cbienb"
 #define PREFERENCE_DATAPANEL_ENABLED "dpenab"
+#define PREFERENCE_LED_RENDER_TASK "ledrtask"
+#define PREFERENCE_HOLO_BOOT_LOOP "holo_boot_loop"
+#define PREFERENCE_DOME_HAPPY_SOUND "dm_happy_sound"
 ////////////////////////////////
 
 #define CONSOLE_BUFFER_SIZE 300
@@ -229,6 +236,8 @@ extern "C" esp_err_t esp_core_dump_image_check(void) __attribute__((weak));
 #include "LITTLEFS.h"
 #endif
 #include "FS.h"
+#include "LedFrameGate.h"
+#include "LedPalette.h"
 
 ////////////////////////////////
 
@@ -281,31 +290,33 @@ extern "C" esp_err_t esp_core_dump_image_check(void) __attribute__((weak));
 
 ////////////////////////////////
 
+// Every LED output below is wrapped by LedFrameGate.h so frames identical to
+// the last one pushed are not re-sent over RMT (see /api/health led_frames).
 #if defined(USE_RSERIES_RLD_CURVED)
-LogicEngineCurvedRLD<PIN_REAR_LOGIC, PIN_REAR_LOGIC_CLOCK> RLD(LogicEngineRLDDefault, 3);
+LED_FRAME_GATED(LogicEngineCurvedRLD<PIN_REAR_LOGIC, PIN_REAR_LOGIC_CLOCK>) RLD(LED_FRAME_GATE_NAME("rld") LogicEngineRLDDefault, 3);
 #elif defined(USE_RSERIES_RLD)
-LogicEngineDeathStarRLD<PIN_REAR_LOGIC> RLD(LogicEngineRLDDefault, 3);
+LED_FRAME_GATED(LogicEngineDeathStarRLD<PIN_REAR_LOGIC>) RLD(LED_FRAME_GATE_NAME("rld") LogicEngineRLDDefault, 3);
 #else
-AstroPixelRLD<PIN_REAR_LOGIC> RLD(LogicEngineRLDDefault, 3);
+LED_FRAME_GATED(AstroPixelRLD<PIN_REAR_LOGIC>) RLD(LED_FRAME_GATE_NAME("rld") LogicEngineRLDDefault, 3);
 #endif
 
 #ifdef USE_RSERIES_FLD
-LogicEngineDeathStarFLD<PIN_FRONT_LOGIC> FLD(LogicEngineFLDDefault, 1);
+LED_FRAME_GATED(LogicEngineDeathStarFLD<PIN_FRONT_LOGIC>) FLD(LED_FRAME_GATE_NAME("fld") LogicEngineFLDDefault, 1);
 #else
-AstroPixelFLD<PIN_FRONT_LOGIC> FLD(LogicEngineFLDDefault, 1);
+LED_FRAME_GATED(AstroPixelFLD<PIN_FRONT_LOGIC>) FLD(LED_FRAME_GATE_NAME("fld") LogicEngineFLDDefault, 1);
 #endif
 
-AstroPixelFrontPSI<PIN_FRONT_PSI> frontPSI(LogicEngineFrontPSIDefault, 4);
-AstroPixelRearPSI<PIN_REAR_PSI> rearPSI(LogicEngineRearPSIDefault, 5);
+LED_FRAME_GATED(AstroPixelFrontPSI<PIN_FRONT_PSI>) frontPSI(LED_FRAME_GATE_NAME("front_psi") LogicEngineFrontPSIDefault, 4);
+LED_FRAME_GATED(AstroPixelRearPSI<PIN_REAR_PSI>) rearPSI(LED_FRAME_GATE_NAME("rear_psi") LogicEngineRearPSIDefault, 5);
 
 #if USE_HOLO_TEMPLATE
-HoloLights<PIN_FRONT_HOLO, NEO_GRB> frontHolo(1);
-HoloLights<PIN_REAR_HOLO, NEO_GRB> rearHolo(2);
-HoloLights<PIN_TOP_HOLO, NEO_GRB> topHolo(3);
+LED_FRAME_GATED(HoloLights<PIN_FRONT_HOLO, NEO_GRB>) frontHolo(LED_FRAME_GATE_NAME("front_holo") 1);
+LED_FRAME_GATED(HoloLights<PIN_REAR_HOLO, NEO_GRB>) rearHolo(LED_FRAME_GATE_NAME("rear_holo") 2);
+LED_FRAME_GATED(HoloLights<PIN_TOP_HOLO, NEO_GRB>) topHolo(LED_FRAME_GATE_NAME("top_holo") 3);
 #else
-HoloLights frontHolo(PIN_FRONT_HOLO, HoloLights::kRGB, 1);
-HoloLights rearHolo(PIN_REAR_HOLO, HoloLights::kRGB, 2);
-HoloLights topHolo(PIN_TOP_HOLO, HoloLights::kRGB, 3);
+LED_FRAME_GATED(HoloLights) frontHolo(LED_FRAME_GATE_NAME("front_holo") PIN_FRONT_HOLO, HoloLights::kRGB, 1);
+LED_FRAME_GATED(HoloLights) rearHolo(LED_FRAME_GATE_NAME("rear_holo") PIN_REAR_HOLO, HoloLights::kRGB, 2);
+LED_FRAME_GATED(HoloLights) topHolo(LED_FRAME_GATE_NAME("top_holo") PIN_TOP_HOLO, HoloLights::kRGB, 3);
 #endif
 
 #if AP_ENABLE_FIRESTRIP
@@ -471,7 +482,25 @@ ServoDispatchDirect<SizeOfArray(servoSettings)> servoDispatch(servoSettings);
 ServoDispatchPCA9685<SizeOfArray(servoSettings)> servoDispatch(servoSettings);
 #endif
 ServoSequencer servoSequencer(servoDispatch);
-AnimationPlayer player(servoSequencer);
+
+// Sequence steps select logic/holo effects, so with the render task running
+// they hold the display lock (LedRenderTask.h) while they step; the rest of
+// AnimatedEvent::process() does not.
+class DisplayLockedAnimationPlayer : public AnimationPlayer
+{
+public:
+    DisplayLockedAnimationPlayer(ServoSequencer &sequencer) :
+        AnimationPlayer(sequencer)
+    {
+    }
+
+    virtual void animate() override
+    {
+        LedDisplayGuard displayGuard;
+        AnimationPlayer::animate();
+    }
+};
+DisplayLockedAnimationPlayer player(servoSequencer);
 
 // Dynamic wiring config — apply per-slot PCA9685 channel assignments and
 // active/inactive state from NVS, overriding the PROGMEM defaults eagerly copied
@@ -493,6 +522,17 @@ static LogCapture logCapture(Serial);
 static esp_reset_reason_t sBootResetReason = ESP_RST_UNKNOWN;
 static bool sBootCoreDumpPresent = false;
 
+// setup() phase timings and the start-up work deferred past the first frame;
+// reported by /api/diag/boot.
+#include "BootSchedule.h"
+static BootTimeline sBootTimeline;
+static BootScheduler sBootSched;
+#ifdef USE_WIFI_WEB
+static int sBootTaskWifi = -1;
+static int sBootTaskWeb = -1;
+static int sBootTaskMdns = -1;
+#endif
+
 #ifndef USE_I2C_ADDRESS
 #include "WiringCommissioning.h"
 #endif
@@ -565,14 +605,20 @@ enum
     PLASMA,
     METABALLS,
     FRACTAL,
-    FADEANDSCROLL
+    FADEANDSCROLL,
+    LOGICSPRITE,
+    LOGICTEXTSTRIP
 };
 
+#include "LogicSpriteStore.h"
+#include "LogicTextStrip.h"
 #include "effects/BitmapEffect.h"
 #include "effects/FadeAndScrollEffect.h"
 #include "effects/FractalEffect.h"
 #include "effects/MeatBallsEffect.h"
 #include "effects/PlasmaEffect.h"
+#include "effects/SpriteEffect.h"
+#include "effects/TextStripEffect.h"
 
 ////////////////////////////////
 // Standard LogicEngine sequences are in the range 0-99. Custom sequences start at 100
@@ -581,7 +627,9 @@ static const LogicEffect sCustomLogicEffects[] = {
     LogicEffectPlasma,
     LogicEffectMetaBalls,
     LogicEffectFractal,
-    LogicEffectFadeAndScroll};
+    LogicEffectFadeAndScroll,
+    LogicEffectSprite,
+    LogicEffectTextStrip};
 
 LogicEffect CustomLogicEffectSelector(unsigned selectSequence)
 {
@@ -592,10 +640,133 @@ LogicEffect CustomLogicEffectSelector(unsigned selectSequence)
     return LogicEffectDefaultSelector(selectSequence);
 }
 
+// Scroll text left through the glyph strip cache (LogicTextStrip.h). The strip
+// is rasterised here, once per message; the effect only blits columns.
+static bool selectLogicTextStripStep(LogicEngineRenderer &r, const char *text, uint8_t red, uint8_t green,
+                                     uint8_t blue, uint16_t stepMs, uint8_t duration)
+{
+    uint32_t start = micros();
+    if (!logicTextStripBind(&r, text, r.height(), red, green, blue, stepMs))
+    {
+        logCapture.printf("[Text] strip build failed; using ReelTwo text\n");
+        return false;
+    }
+    sLogicTextStripStats.lastBuildUs = micros() - start;
+    r.selectSequence(LOGICTEXTSTRIP, LogicEngineRenderer::kDefault, 0, duration);
+    return true;
+}
+
+// DT: text; `speed` is the DT: speed field.
+static void selectLogicTextStripRgb(LogicEngineRenderer &r, const char *text, uint8_t red, uint8_t green,
+                                    uint8_t blue, uint8_t speed, uint8_t duration)
+{
+    if (!selectLogicTextStripStep(r, text, red, green, blue, logicTextStepMs(speed), duration))
+        r.selectScrollTextLeft(text, LogicEngineRenderer::kDefault, speed, duration);
+}
+
+// Firmware status text (boot, sleep/wake, OTA failure). `speed` keeps the
+// kStatusScrollSpeedScale meaning it had with ReelTwo's selectScrollTextLeft,
+// and is passed through unchanged if the strip cannot be built.
+static void selectLogicTextStrip(LogicEngineRenderer &r, const char *text, LogicEngineRenderer::ColorVal color,
+                                 uint8_t speed, uint8_t duration)
+{
+    const char *name;
+    switch (color)
+    {
+        case LogicEngineRenderer::kRed:    name = "RED"; break;
+        case LogicEngineRenderer::kOrange: name = "ORANGE"; break;
+        case LogicEngineRenderer::kYellow: name = "YELLOW"; break;
+        case LogicEngineRenderer::kGreen:  name = "GREEN"; break;
+        case LogicEngineRenderer::kPurple: name = "PURPLE"; break;
+        case LogicEngineRenderer::kBlue:
+        default:                           name = "BLUE"; break;
+    }
+    const LedNamedColor *c = ledPaletteFindNamedColor(name);
+    if (!selectLogicTextStripStep(r, text, c->r, c->g, c->b, logicTextStatusStepMs(speed), duration))
+        r.selectScrollTextLeft(text, color, speed, duration);
+}
+
 ////////////////////////////////
 
 Preferences preferences;
 
+// RAM copy of the preferences, loaded once in setup(). Text values are read
+// from the web task while the loop task may be writing them, hence the lock.
+static portMUX_TYPE sConfigRegistryMux = portMUX_INITIALIZER_UNLOCKED;
+#define CONFIG_REGISTRY_LOCK() portENTER_CRITICAL(&sConfigRegistryMux)
+#define CONFIG_REGISTRY_UNLOCK() portEXIT_CRITICAL(&sConfigRegistryMux)
+#include "ConfigRegistry.h"
+
+static bool configPrefsLoadInt(const ConfigKeyDef &def, int32_t &value)
+{
+    switch (preferences.getType(def.key))
+    {
+        case PT_U8:
+        case PT_I8:
+            value = preferences.getUChar(def.key, 0);
+            return true;
+        case PT_I32:
+        case PT_U32:
+            value = preferences.getInt(def.key, 0);
+            return true;
+        case PT_STR:
+        {
+            // Older /api/pref builds stored holo_boot_loop, dm_happy_sound and
+            // ledrtask as "true"/"false" strings that getBool() never saw.
+            String text = preferences.getString(def.key, "");
+            value = (text == "true") ? 1 : text.toInt();
+            return true;
+        }
+        default:
+            return false;
+    }
+}
+
+static bool configPrefsLoadText(const ConfigKeyDef &def, char *text, size_t size)
+{
+    if (preferences.getType(def.key) != PT_STR)
+        return false;
+    strlcpy(text, preferences.getString(def.key, "").c_str(), size);
+    return true;
+}
+
+static bool configPrefsSaveInt(const ConfigKeyDef &def, int32_t value)
+{
+    // NVS entries are typed; drop a legacy string entry before the typed write.
+    PreferenceType want = (def.type == kConfigBool) ? PT_U8 : PT_I32;
+    PreferenceType have = preferences.getType(def.key);
+    if (have != PT_INVALID && have != want)
+        preferences.remove(def.key);
+    if (def.type == kConfigBool)
+        return preferences.putBool(def.key, value != 0) != 0;
+    return preferences.putInt(def.key, value) != 0;
+}
+
+static bool configPrefsSaveText(const ConfigKeyDef &def, const char *text)
+{
+    return preferences.putString(def.key, text) == strlen(text);
+}
+
+static bool configPrefsClear()
+{
+    return preferences.clear();
+}
+
+static const ConfigStore kConfigPrefsStore = {
+    configPrefsLoadInt,
+    configPrefsLoadText,
+    configPrefsSaveInt,
+    configPrefsSaveText,
+    configPrefsClear
+};
+
+String configGetString(ConfigKeyId id)
+{
+    char text[CONFIG_REGISTRY_MAX_TEXT + 1];
+    configGetText(id, text, sizeof(text));
+    return String(text);
+}
+
 ////////////////////////////////
 
 bool mountReadOnlyFileSystem()
@@ -621,6 +792,7 @@ void reboot()
 #ifdef USE_DROID_REMOTE
     DisconnectRemote();
 #endif
+    domeElementStatusPersistNow();
     unmountFileSystems();
     preferences.end();
     ESP.restart();
@@ -759,23 +931,30 @@ bool otaInProgress;
 
 #ifdef USE_WIFI_WEB
 static bool sAsyncWebStarted;
+// Set from the WiFi event task on every connect; mainLoop() re-binds the body
+// link and mDNS once the "mdns" boot task has done the first bind.
+static volatile bool sWifiReconnectPending;
 #endif
 
 bool soundLocalEnabled;
 bool sSleepModeActive;
 uint32_t sSleepModeSinceMs;
 uint32_t sSleepEnforceAtMs;
+// Scroll speed scale for the boot and sleep/wake banners (larger is slower,
+// see logicTextStatusStepMs); the banners finish inside kSleepTransitionScrollMs.
 static const uint8_t kStatusScrollSpeedScale = 4;
 static const uint32_t kSleepTransitionScrollMs = 5200;
 bool sWakeTransitionPending;
 uint32_t sWakeTransitionAtMs;
 uint32_t sMinFreeHeap = 0;
+uint32_t sBootFreeHeap = 0;
 static bool sSoundInitPending;
-static uint32_t sSoundInitAtMs;
 static uint8_t sSoundInitAttempts;
 static MarcSound::Module sSoundInitModule;
 static int sSoundInitStartup;
 static float sSoundInitVolume;
+// Set by the config listener when the random interval changes; applied by mainLoop().
+static volatile bool sSoundRandomDirty;
 
 // Body link state — not persisted, reset on reboot
 static uint32_t sBodyLastSeenMs  = 0;   // millis() when last #PAHB received (0=never)
@@ -824,9 +1003,20 @@ struct VisualAuthoringHoloTelemetry
     uint32_t rejectCount = 0;
     uint32_t lastAppliedMs = 0;
 };
+struct VisualAuthoringSpriteTelemetry
+{
+    char lastCmd[64] = "";
+    char target[8] = "";
+    char name[LOGIC_SPRITE_MAX_NAME + 1] = "";
+    uint8_t duration = 0;
+    uint32_t applyCount = 0;
+    uint32_t rejectCount = 0;
+    uint32_t lastAppliedMs = 0;
+};
 static VisualAuthoringLogicTelemetry sVisualAuthoringLogic;
 static VisualAuthoringTextTelemetry sVisualAuthoringText;
 static VisualAuthoringHoloTelemetry sVisualAuthoringHolo;
+static VisualAuthoringSpriteTelemetry sVisualAuthoringSprite;
 #include "BodyLinkWiFi.h"
 #include "DomeSequences.h"
 bool dome_PiesOpen   = false;
@@ -839,7 +1029,9 @@ AnimationStep dome_pendingAnim = nullptr;
 
 static bool bodyLinkConnected()
 {
-    return sBodyLastSeenMs > 0 && (millis() - sBodyLastSeenMs) < 5000;
+    uint32_t now = millis();
+    return bodyLinkFailoverPathAlive(sBodyFailover, kBodyLinkPathUart, now) ||
+           bodyLinkFailoverPathAlive(sBodyFailover, kBodyLinkPathWifi, now);
 }
 
 static bool isMoodResetCommand(const char *cmd)
@@ -885,9 +1077,50 @@ static const char *currentMoodName()
 #define MARCDUINO_INGRESS_IMPLEMENTATION
 #include "MarcduinoIngress.h"
 
+// Resends a command that went out on a path that has since died.
+static void bodyLinkReplayCommand(uint8_t path, const char *cmd, void *)
+{
+    if (path == kBodyLinkPathUart && COMMAND_SERIAL)
+    {
+        COMMAND_SERIAL.print(cmd);
+        COMMAND_SERIAL.print('\r');
+    }
+    else if (path == kBodyLinkPathWifi)
+    {
+        bodyLinkWiFiSendUDP(cmd);
+    }
+}
+
+// Re-evaluates UART/WiFi liveness (BodyLinkFailover.h). Runs every mainLoop()
+// pass, so a dead path is noticed as soon as its deadline passes rather than
+// on the next heartbeat. Loop task only; sendBodyCommand() may also run on
+// the web task and just reads the result.
+static void bodyLinkFailoverPoll()
+{
+    if (!configGetBool(kCfgBodyLinkEnabled))
+        return;
+    uint8_t before = sBodyFailover.active;
+    uint32_t failovers = sBodyFailover.stats.failovers;
+    uint32_t replayed = sBodyFailover.stats.replayed;
+    uint8_t after = bodyLinkFailoverUpdate(sBodyFailover, millis(), bodyLinkWifiUsable(),
+                                           bodyLinkReplayCommand, nullptr);
+    if (sBodyFailover.stats.failovers != failovers)
+    {
+        logCapture.printf("[BodyLink] %s lost after %u ms of silence, now %s\n",
+                          before == kBodyLinkPathUart ? "UART" : "WiFi",
+                          (unsigned)sBodyFailover.stats.lastDetectMs, bodyLinkGetTransportName());
+    }
+    if (after != before && sBodyFailover.stats.replayed != replayed)
+    {
+        logCapture.printf("[BodyLink] replayed %u command(s) on %s\n",
+                          (unsigned)(sBodyFailover.stats.replayed - replayed), bodyLinkGetTransportName());
+    }
+}
+
 static void sendBodyCommand(const char* cmd)
 {
     if (cmd == nullptr || *cmd == '\0') return;
+    if (!configGetBool(kCfgBodyLinkEnabled)) return;
 
     if (sSuppressBodyLinkEgress)
     {
@@ -897,15 +1130,109 @@ static void sendBodyCommand(const char* cmd)
     }
 
     BodyLinkTransport transport = bodyLinkActiveTransport();
+    uint8_t path = kBodyLinkPathNone;
     if (transport == BODY_LINK_UART && COMMAND_SERIAL)
     {
         COMMAND_SERIAL.print(cmd);
         COMMAND_SERIAL.print('\r');
+        path = kBodyLinkPathUart;
     }
     else if (transport == BODY_LINK_WIFI)
     {
-        bodyLinkWiFiSendUDP(cmd);
+        if (bodyLinkWiFiSendUDP(cmd))
+            path = kBodyLinkPathWifi;
     }
+    // Kept for replay; with no path up it waits for the next one.
+    bodyLinkFailoverNoteTx(sBodyFailover, path, cmd, millis());
+}
+
+// Body-link UART receive path (BodyLinkUart.h). Serial2's driver event task
+// frames incoming bytes as they arrive; handleBodySerial() only drains
+// complete frames into ingress. Build with AP_BODY_LINK_UART_EVENTS=0 to feed
+// the same reader from mainLoop() instead.
+#ifndef AP_BODY_LINK_UART_EVENTS
+#define AP_BODY_LINK_UART_EVENTS 1
+#endif
+#define BODY_LINK_UART_RX_BUFFER 1024
+static portMUX_TYPE sBodyUartMux = portMUX_INITIALIZER_UNLOCKED;
+#define BODY_LINK_UART_LOCK() portENTER_CRITICAL(&sBodyUartMux)
+#define BODY_LINK_UART_UNLOCK() portEXIT_CRITICAL(&sBodyUartMux)
+#include "BodyLinkUart.h"
+
+static BodyLinkUartReader sBodyUart;
+static BodyLinkUartBaud sBodyUartBaud;
+static uint32_t sBodyUartHeartbeatsSeen = 0;
+
+static void bodyLinkUartPump()
+{
+    uint8_t buf[64];
+    size_t avail;
+    while ((avail = COMMAND_SERIAL.available()) > 0)
+    {
+        size_t n = COMMAND_SERIAL.readBytes(buf, avail < sizeof(buf) ? avail : sizeof(buf));
+        if (n == 0)
+            break;
+        bodyLinkUartFeed(sBodyUart, buf, n, millis());
+    }
+}
+
+#if AP_BODY_LINK_UART_EVENTS
+static void bodyLinkUartOnError(hardwareSerial_error_t error)
+{
+    switch (error)
+    {
+        case UART_BREAK_ERROR: bodyLinkUartNoteError(sBodyUart, kBodyLinkUartBreak); break;
+        case UART_BUFFER_FULL_ERROR: bodyLinkUartNoteError(sBodyUart, kBodyLinkUartBufferFull); break;
+        case UART_FIFO_OVF_ERROR: bodyLinkUartNoteError(sBodyUart, kBodyLinkUartFifoOverflow); break;
+        case UART_FRAME_ERROR: bodyLinkUartNoteError(sBodyUart, kBodyLinkUartFrameError); break;
+        case UART_PARITY_ERROR: bodyLinkUartNoteError(sBodyUart, kBodyLinkUartParityError); break;
+        default: break;
+    }
+}
+#endif
+
+// Called from setup() right after COMMAND_SERIAL.begin() when the body link
+// is enabled.
+static void bodyLinkUartBegin()
+{
+    bodyLinkUartReset(sBodyUart);
+    bodyLinkUartBaudInit(sBodyUartBaud, configGetInt(kCfgMarcSerial2Baud), configGetInt(kCfgBodyUartBaud));
+#if AP_BODY_LINK_UART_EVENTS
+    COMMAND_SERIAL.onReceiveError(bodyLinkUartOnError);
+    COMMAND_SERIAL.onReceive(bodyLinkUartPump);
+#endif
+}
+
+static void bodyLinkUartSetBaud(uint32_t rate, const char *reason)
+{
+    COMMAND_SERIAL.flush();
+    COMMAND_SERIAL.updateBaudRate(rate);
+    logCapture.printf("[BodyLink] UART now %u baud (%s)\n", (unsigned)rate, reason);
+}
+
+static String bodyLinkUartBuildJson()
+{
+    const BodyLinkUartStats &st = sBodyUart.stats;
+    String json = "{\"events\":" + String(AP_BODY_LINK_UART_EVENTS ? "true" : "false");
+    json += ",\"baud\":" + String(sBodyUartBaud.currentBaud);
+    json += ",\"target_baud\":" + String(sBodyUartBaud.targetBaud);
+    json += ",\"baud_state\":\"" + String(bodyLinkUartBaudStateName(sBodyUartBaud.state)) + "\"";
+    json += ",\"baud_offers\":" + String(sBodyUartBaud.offers);
+    json += ",\"baud_negotiations\":" + String(sBodyUartBaud.negotiations);
+    json += ",\"baud_reverts\":" + String(sBodyUartBaud.reverts);
+    json += ",\"rx_bytes\":" + String(st.rxBytes);
+    json += ",\"frames\":" + String(st.frames);
+    json += ",\"heartbeats\":" + String(st.heartbeats);
+    json += ",\"overlong\":" + String(st.overlong);
+    json += ",\"garbage\":" + String(st.garbage);
+    json += ",\"ring_overflow\":" + String(st.ringOverflow);
+    json += ",\"ring_peak\":" + String(st.ringPeak);
+    json += ",\"frame_errors\":" + String(st.frameErrors);
+    json += ",\"parity_errors\":" + String(st.parityErrors);
+    json += ",\"fifo_overflows\":" + String(st.fifoOverflows);
+    json += ",\"buffer_full\":" + String(st.bufferFull);
+    json += ",\"breaks\":" + String(st.breaks) + "}";
+    return json;
 }
 
 static void handleBodySerial()
@@ -914,49 +1241,45 @@ static void handleBodySerial()
     static bool sBodyLinkInitDone = false;
     if (!sBodyLinkInitDone)
     {
-        sBodyLinkEnabled = preferences.getBool(PREFERENCE_BODY_LINK_ENABLED, BODY_LINK_ENABLED);
+        sBodyLinkEnabled = configGetBool(kCfgBodyLinkEnabled);
         sBodyLinkInitDone = true;
     }
     if (!sBodyLinkEnabled) return;
-    static char sBuf[65];  // 64 data + 1 null terminator
-    static uint8_t sBufLen = 0;
-    while (COMMAND_SERIAL.available())
+#if !AP_BODY_LINK_UART_EVENTS
+    bodyLinkUartPump();
+#endif
+
+    // Heartbeats carry the time the reader saw them, not the time this pass
+    // got round to them.
+    uint32_t heartbeats = sBodyUart.stats.heartbeats;
+    uint32_t heartbeatMs = sBodyUart.lastHeartbeatMs;
+    while (sBodyUartHeartbeatsSeen != heartbeats)
     {
-        char c = (char)COMMAND_SERIAL.read();
-        if (c == '\r' || c == '\n')
-        {
-            if (sBufLen > 0)
-            {
-                sBuf[sBufLen] = '\0';
-                uint32_t now = millis();
-                if (strcmp(sBuf, "#PAHB") == 0)
-                {
-                    bodyLinkMarkUartHeartbeat(now);
-                }
-                else
-                {
-                    bodyLinkMarkUartActivity(now);
-                    marcduinoIngressAdmit(kMarcduinoIngressBodyLinkUart, sBuf);
-                    // UART bursts can contain many Marcduino frames before the
-                    // next mainLoop() pass. Pump after each complete frame so a
-                    // dense body choreography cannot fill the shared ingress queue.
-                    drainMarcduinoCommandQueue();
-                }
-                sBufLen = 0;
-            }
-        }
-        else if (sBufLen < sizeof(sBuf) - 1)
-        {
-            sBuf[sBufLen++] = c;
-        }
-        else
+        sBodyUartHeartbeatsSeen++;
+        bodyLinkMarkUartHeartbeat(heartbeatMs);
+    }
+
+    BodyLinkUartFrame frame;
+    while (bodyLinkUartPop(sBodyUart, frame))
+    {
+        bodyLinkMarkUartActivity(frame.rxMs);
+        if (strncmp(frame.text, "#PABR", 5) == 0)
         {
-            // Buffer overflow — discard and reset
-            DEBUG_PRINTLN(F("[BodyLink] Buffer overflow - command discarded"));
-            sBuf[0] = '\0';
-            sBufLen = 0;
+            uint32_t rate = bodyLinkUartBaudAccept(sBodyUartBaud, strtoul(frame.text + 5, nullptr, 10), millis());
+            if (rate != 0)
+                bodyLinkUartSetBaud(rate, "negotiated");
+            continue;
         }
+        marcduinoIngressAdmit(kMarcduinoIngressBodyLinkUart, frame.text);
+        // UART bursts can contain many Marcduino frames before the next
+        // mainLoop() pass. Pump after each complete frame so a dense body
+        // choreography cannot fill the shared ingress queue.
+        drainMarcduinoCommandQueue();
     }
+
+    uint32_t revert = bodyLinkUartBaudPoll(sBodyUartBaud, millis(), sBodyUart.lastHeartbeatMs);
+    if (revert != 0)
+        bodyLinkUartSetBaud(revert, "no heartbeat at negotiated rate");
 }
 
 static void handleBodyLinkHeartbeat()
@@ -965,11 +1288,13 @@ static void handleBodyLinkHeartbeat()
     static bool sBodyLinkInitDone = false;
     if (!sBodyLinkInitDone)
     {
-        sBodyLinkEnabled = preferences.getBool(PREFERENCE_BODY_LINK_ENABLED, BODY_LINK_ENABLED);
+        sBodyLinkEnabled = configGetBool(kCfgBodyLinkEnabled);
         sBodyLinkInitDone = true;
     }
     if (!sBodyLinkEnabled) return;
 
+    bodyLinkFailoverPoll();
+
     // Connection state tracking for logging
     static bool sPrevConnected = false;
     bool nowConnected = bodyLinkConnected();
@@ -991,25 +1316,35 @@ static void handleBodyLinkHeartbeat()
         sPrevTransport = transport;
     }
 
+    // Adaptive: every 250 ms while idle, once a second while commands are
+    // flowing. The gate advances even when UDP delivery fails, which keeps
+    // network errors from turning into UART spam.
     uint32_t now = millis();
-    if (now - sBodyLastTxMs >= 1000)
+    if (transport != BODY_LINK_DISCONNECTED && bodyLinkFailoverHeartbeatDue(sBodyFailover, now))
     {
         if (transport == BODY_LINK_UART && COMMAND_SERIAL)
         {
             COMMAND_SERIAL.print("#APHB\r");
-            sBodyLastTxMs = now;
+            if (bodyLinkFailoverHeartbeatRequestDue(sBodyFailover, kBodyLinkPathUart, now))
+                COMMAND_SERIAL.printf("#APHI%u\r", (unsigned)BODY_LINK_HB_REQUEST_MS);
+            if (bodyLinkUartBaudOfferDue(sBodyUartBaud, now, true))
+                COMMAND_SERIAL.printf("#APBR%u\r", (unsigned)sBodyUartBaud.targetBaud);
         }
         else if (transport == BODY_LINK_WIFI)
         {
-            bodyLinkWiFiSendUDP("#APHB");
+            bodyLinkWiFiSendHeartbeat();
+            if (bodyLinkFailoverHeartbeatRequestDue(sBodyFailover, kBodyLinkPathWifi, now))
+            {
+                char request[16];
+                snprintf(request, sizeof(request), "#APHI%u", (unsigned)BODY_LINK_HB_REQUEST_MS);
+                bodyLinkWiFiSendUDP(request);
+            }
             // Also emit on UART TX so the body's periodic 150ms RX-only probe
             // window can detect the dome and trigger UART transport recovery.
             if (COMMAND_SERIAL)
                 COMMAND_SERIAL.print("#APHB\r");
-            // Always advance the timestamp so the 1-second gate closes even
-            // when UDP delivery fails — prevents UART spam on network errors.
-            sBodyLastTxMs = now;
         }
+        sBodyLastTxMs = now;
     }
 }
 
@@ -1071,84 +1406,220 @@ SMQAddress sRemoteAddress;
 
 ////////////////////////////////
 
-void scan_i2c()
+#ifndef USE_I2C_ADDRESS
+// Probes one address and prints what answered; true if a device did.
+static bool scan_i2c_address(byte address)
 {
-    unsigned nDevices = 0;
-    Serial.println(F("==========================================="));
-    Serial.println(F("Scanning I2C addresses 0x01-0x7E..."));
-    Serial.println(F("Expected: 0x40 (Panels), 0x41 (Holos)"));
-    Serial.println(F("==========================================="));
+    String name = "<unknown>";
+    Wire.beginTransmission(address);
+    byte error = Wire.endTransmission();
+    if (address == 0x70)
+    {
+        // All call address for PCA9685
+        name = "PCA9685:all";
+    }
+    if (address == 0x40)
+    {
+        // Adafruit PCA9685 - Panels Controller
+        name = "PCA9685 (Panels) ← EXPECTED";
+    }
+    if (address == 0x41)
+    {
+        // Adafruit PCA9685 - Holos Controller
+        name = "PCA9685 (Holos) ← EXPECTED";
+    }
+    if (address == 0x14)
+    {
+        // IA-Parts magic panel
+        name = "IA-Parts Magic Panel";
+    }
+    if (address == 0x20)
+    {
+        // IA-Parts periscope
+        name = "IA-Parts Periscope";
+    }
+    if (address == 0x16)
+    {
+        // PSIPro
+        name = "PSIPro";
+    }
 
-    for (byte address = 1; address < 127; address++)
+    if (error == 0)
     {
-        String name = "<unknown>";
-        Wire.beginTransmission(address);
-        byte error = Wire.endTransmission();
-        if (address == 0x70)
-        {
-            // All call address for PCA9685
-            name = "PCA9685:all";
-        }
-        if (address == 0x40)
-        {
-            // Adafruit PCA9685 - Panels Controller
-            name = "PCA9685 (Panels) ← EXPECTED";
-        }
-        if (address == 0x41)
-        {
-            // Adafruit PCA9685 - Holos Controller
-            name = "PCA9685 (Holos) ← EXPECTED";
-        }
-        if (address == 0x14)
-        {
-            // IA-Parts magic panel
-            name = "IA-Parts Magic Panel";
-        }
-        if (address == 0x20)
-        {
-            // IA-Parts periscope
-            name = "IA-Parts Periscope";
-        }
-        if (address == 0x16)
-        {
-            // PSIPro
-            name = "PSIPro";
-        }
+        Serial.print(F("✓ I2C device found at address 0x"));
+        if (address < 16)
+            Serial.print(F("0"));
+        Serial.print(address, HEX);
+        Serial.print(F(" "));
+        Serial.println(name);
+        return true;
+    }
+    else if (error == 4)
+    {
+        Serial.print(F("✗ Unknown error at address 0x"));
+        if (address < 16)
+            Serial.print(F("0"));
+        Serial.println(address, HEX);
+    }
+    return false;
+}
 
-        if (error == 0)
-        {
-            Serial.print(F("✓ I2C device found at address 0x"));
-            if (address < 16)
-                Serial.print(F("0"));
-            Serial.print(address, HEX);
-            Serial.print(F(" "));
-            Serial.println(name);
-            nDevices++;
-        }
-        else if (error == 4)
-        {
-            Serial.print(F("✗ Unknown error at address 0x"));
-            if (address < 16)
-                Serial.print(F("0"));
-            Serial.println(address, HEX);
-        }
+// Deferred boot task: the I2C diagnostics printout, 16 addresses per
+// mainLoop() pass. Panels and holos are already live by then; the scan is
+// only a report (/api/diag/i2c probes on demand).
+static BootTaskResult bootTaskI2cScan(uint32_t &retryMs)
+{
+    static byte sAddress = 1;
+    static unsigned sDevices = 0;
+    if (sAddress == 1)
+    {
+        Serial.println(F("\n=== I2C DIAGNOSTICS ==="));
+        Serial.println(F("==========================================="));
+        Serial.println(F("Scanning I2C addresses 0x01-0x7E..."));
+        Serial.println(F("Expected: 0x40 (Panels), 0x41 (Holos)"));
+        Serial.println(F("==========================================="));
+    }
+    for (byte end = sAddress + 16 < 127 ? sAddress + 16 : 127; sAddress < end; sAddress++)
+    {
+        if (scan_i2c_address(sAddress))
+            sDevices++;
+    }
+    if (sAddress < 127)
+    {
+        retryMs = 0;
+        return kBootTaskYield;
     }
     Serial.println(F("==========================================="));
-    if (nDevices == 0)
+    if (sDevices == 0)
         Serial.println(F("❌ NO I2C DEVICES FOUND!"));
     else
     {
         Serial.print(F("✓ Found "));
-        Serial.print(nDevices);
+        Serial.print(sDevices);
         Serial.println(F(" I2C device(s)"));
     }
     Serial.println(F("==========================================\n"));
+    Serial.println(F("=== END I2C DIAGNOSTICS ===\n"));
+    return kBootTaskDone;
+}
+#endif
+
+// Deferred boot task: the sound module handshake, five tries a second apart.
+static BootTaskResult bootTaskSound(uint32_t &retryMs)
+{
+    if (!sMarcSound.begin(sSoundInitModule, SOUND_SERIAL, sSoundInitStartup))
+    {
+        if (++sSoundInitAttempts >= 5)
+        {
+            sSoundInitPending = false;
+            DEBUG_PRINTLN(F("FAILED TO INITALIZE SOUND MODULE"));
+            return kBootTaskFailed;
+        }
+        retryMs = 1000;
+        return kBootTaskRetry;
+    }
+    sMarcSound.setVolume(sSoundInitVolume);
+    sMarcSound.playStartSound();
+    sMarcSound.setRandomMin(configGetInt(kCfgSoundRandomMin));
+    sMarcSound.setRandomMax(configGetInt(kCfgSoundRandomMax));
+    if (configGetInt(kCfgSoundRandom))
+        sMarcSound.startRandomInSeconds(13);
+    sSoundInitPending = false;
+    DEBUG_PRINTLN(F("Sound module initialized (deferred)"));
+    return kBootTaskDone;
+}
+
+#ifdef USE_WIFI_WEB
+// Deferred boot task: WiFi bring-up. The connected callback only flags the
+// link; the "web" and "mdns" tasks below wait for it.
+static BootTaskResult bootTaskWifi(uint32_t &)
+{
+    // In preparation for adding WiFi settings web page
+    wifiAccess.setNetworkCredentials(
+        configGetString(kCfgWifiSsid),
+        configGetString(kCfgWifiPass),
+        configGetBool(kCfgWifiAccessPoint),
+        configGetBool(kCfgWifiEnabled));
+    // Keep WiFi fully awake to avoid multi-second UI/API latency spikes
+    // seen with default ESP32 modem sleep in STA mode.
+    WiFi.setSleep(false);
+    // CRITICAL: setNetworkCredentials changes WiFi mode to STA
+    // If remote is enabled, we need APSTA mode for ESP-NOW, so override it here
+    if (remoteEnabled)
+    {
+        WiFi.mode(WIFI_MODE_APSTA);
+    }
+#ifdef USE_WIFI_MARCDUINO
+    wifiMarcduinoReceiver.setEnabled(configGetBool(kCfgMarcWifiEnabled));
+    if (wifiMarcduinoReceiver.enabled())
+    {
+        wifiMarcduinoReceiver.setCommandHandler([](const char *cmd)
+                                                {
+            printf("cmd: %s\n", cmd);
+            marcduinoIngressAdmit(kMarcduinoIngressWifiMarcduino, cmd);
+            if (configGetBool(kCfgMarcWifiSerialPass))
+            {
+                COMMAND_SERIAL.print(cmd); COMMAND_SERIAL.print('\r');
+            } });
+    }
+#endif
+    wifiAccess.notifyWifiConnected([](WifiAccess &wifi)
+                                   {
+                                       wifiActive = true;
+                                       WiFi.setSleep(false);
+                                       Serial.print("Connect to http://");
+                                       Serial.println(wifi.getIPAddress());
+                                       // Runs on the WiFi event task: leave the re-bind
+                                       // (and the boot scheduler) to mainLoop().
+                                       sWifiReconnectPending = true;
+                                   });
+    wifiAccess.notifyWifiDisconnected([](WifiAccess &)
+                                      {
+                                          wifiActive = false;
+                                      });
+    bodyLinkWiFiInit();
+    return kBootTaskDone;
 }
 
+static BootTaskResult bootTaskWeb(uint32_t &retryMs)
+{
+    if (!wifiActive)
+    {
+        retryMs = 100;
+        return kBootTaskYield;
+    }
+    if (!sAsyncWebStarted)
+    {
+        initAsyncWeb();
+        sAsyncWebStarted = true;
+    }
+    return kBootTaskDone;
+}
+
+// Body link UDP listener and the mDNS responder, once the web server is up.
+static BootTaskResult bootTaskMdns(uint32_t &retryMs)
+{
+    if (!wifiActive)
+    {
+        retryMs = 100;
+        return kBootTaskYield;
+    }
+    // This bind covers the connect that got us here.
+    sWifiReconnectPending = false;
+    bodyLinkWiFiInit();
+    bodyLinkSetupMDNS();
+    return kBootTaskDone;
+}
+#endif
+
 ////////////////////////////////
 
 void setup()
 {
+    bootTimelineReset(sBootTimeline, micros());
+    ledDisplayLockInit();
+    bootSchedReset(sBootSched, []() -> uint32_t { return micros(); });
+    bootTimelinePhase(sBootTimeline, "console", micros());
     REELTWO_READY();
     sBootResetReason = esp_reset_reason();
     sBootCoreDumpPresent = coreDumpImagePresent();
@@ -1156,27 +1627,43 @@ void setup()
         resetReasonName(sBootResetReason),
         (int)sBootResetReason,
         sBootCoreDumpPresent ? "true" : "false");
-
+    // Heap left once global construction is done. Static initialisers that
+    // allocate show up as a lower number; compare builds with and without
+    // USE_LEGACY_WEB_PAGES to see what the /legacy pages cost.
+    sBootFreeHeap = ESP.getFreeHeap();
+    logCapture.printf("[Boot] heap at setup: free=%u largest=%u\n",
+        (unsigned)sBootFreeHeap, (unsigned)ESP.getMaxAllocHeap());
+
+    bootTimelinePhase(sBootTimeline, "config", micros());
     if (!preferences.begin("astro", false))
     {
         DEBUG_PRINTLN(F("Failed to init prefs"));
     }
+    configRegistryBegin(kConfigPrefsStore);
+    logCapture.printf("[Config] %u keys, %u from NVS, %u out of range\n",
+        (unsigned)kConfigKeyCount, (unsigned)sConfigStats.loaded, (unsigned)sConfigStats.rejected);
+    configSubscribe(kCfgSoundLocalEnabled, [](ConfigKeyId id, void *)
+    {
+        soundLocalEnabled = configGetBool(id);
+    }, nullptr);
+    configSubscribe(kCfgSoundRandomMin, [](ConfigKeyId, void *) { sSoundRandomDirty = true; }, nullptr);
+    configSubscribe(kCfgSoundRandomMax, [](ConfigKeyId, void *) { sSoundRandomDirty = true; }, nullptr);
     {
         String savedMood = preferences.getString("cmood", "");
         if (isMoodResetCommand(savedMood.c_str()))
             strlcpy(sCurrentMoodCmd, savedMood.c_str(), sizeof(sCurrentMoodCmd));
     }
 #ifdef USE_WIFI
-    wifiEnabled = preferences.getBool(PREFERENCE_WIFI_ENABLED, WIFI_ENABLED);
+    wifiEnabled = configGetBool(kCfgWifiEnabled);
     wifiActive = false;
     otaInProgress = false;
 #ifdef USE_DROID_REMOTE
-    remoteEnabled = remoteActive = preferences.getBool(PREFERENCE_REMOTE_ENABLED, REMOTE_ENABLED);
+    remoteEnabled = remoteActive = configGetBool(kCfgRemoteEnabled);
 #else
     remoteEnabled = remoteActive = false;
 #endif
 #endif
-    soundLocalEnabled = preferences.getBool(PREFERENCE_MARCSOUND_LOCAL_ENABLED, MARC_SOUND_LOCAL_ENABLED);
+    soundLocalEnabled = configGetBool(kCfgSoundLocalEnabled);
     sSleepModeActive = false;
     sSleepModeSinceMs = 0;
     sSleepEnforceAtMs = 0;
@@ -1186,8 +1673,9 @@ void setup()
     String droidName = getConfiguredDroidName();
     PrintReelTwoInfo(Serial, droidName.c_str());
 
-    bool serial2Enabled = preferences.getBool(PREFERENCE_MARCSERIAL_ENABLED, MARC_SERIAL_ENABLED);
-    bool bodyLinkEnabled = preferences.getBool(PREFERENCE_BODY_LINK_ENABLED, BODY_LINK_ENABLED);
+    bootTimelinePhase(sBootTimeline, "serial2", micros());
+    bool serial2Enabled = configGetBool(kCfgMarcSerialEnabled);
+    bool bodyLinkEnabled = configGetBool(kCfgBodyLinkEnabled);
 
     // Body link depends on Serial2 transport. If user disabled mserial but kept
     // body link enabled, keep Serial2 active to avoid a broken heartbeat link.
@@ -1199,32 +1687,37 @@ void setup()
 
     if (serial2Enabled)
     {
-        COMMAND_SERIAL.begin(preferences.getInt(PREFERENCE_MARCSERIAL2, MARC_SERIAL2_BAUD_RATE), SERIAL_8N1, SERIAL2_RX_PIN, SERIAL2_TX_PIN);
+        if (bodyLinkEnabled)
+            COMMAND_SERIAL.setRxBufferSize(BODY_LINK_UART_RX_BUFFER);
+        COMMAND_SERIAL.begin(configGetInt(kCfgMarcSerial2Baud), SERIAL_8N1, SERIAL2_RX_PIN, SERIAL2_TX_PIN);
         if (bodyLinkEnabled)
         {
             // Body link enabled — disable Reeltwo stream handling to prevent race conditions
             marcduinoSerial.setStream(nullptr, nullptr);
-            // handleBodySerial() in mainLoop() reads manually
+            // Serial2's event task frames input; handleBodySerial() drains it
+            bodyLinkUartBegin();
         }
         else
         {
             // Body link disabled — use legacy Reeltwo stream handler
-            // if (preferences.getBool(PREFERENCE_MARCSERIAL_PASS, MARC_SERIAL_PASS))
             marcduinoSerial.setStream(&COMMAND_SERIAL, &Serial);
         }
     }
+    bootTimelinePhase(sBootTimeline, "filesystem", micros());
     if (!mountReadOnlyFileSystem())
     {
         DEBUG_PRINTLN(F("Failed to mount read only filesystem"));
     }
+    domeElementStatusLoad();
+    logCapture.printf("[DomeStatus] status table loaded from %s\n",
+                      sDomeElementStatusPersist.source);
 
 #ifndef USE_I2C_ADDRESS
+    bootTimelinePhase(sBootTimeline, "wiring", micros());
     Wire.begin();
-    Serial.println(F("\n=== I2C DIAGNOSTICS ==="));
     Serial.println(F("Initializing I2C on SDA=21, SCL=22"));
-    delay(100); // Give I2C time to settle
-    scan_i2c();
-    Serial.println(F("=== END I2C DIAGNOSTICS ===\n"));
+    // The bus scan is only a printout; it runs after the first frame.
+    bootSchedAdd(sBootSched, "i2c_scan", bootTaskI2cScan, 0, 0, 0);
 
     // Apply per-slot wiring overrides BEFORE SetupEvent::ready() — that call
     // triggers the first PCA9685 I2C write, so any setServo() updates must be
@@ -1233,6 +1726,7 @@ void setup()
     holoConfigLoad();
     domeApplyDisabledPanelOverlay();
 #endif
+    bootTimelinePhase(sBootTimeline, "servos", micros());
     SetupEvent::ready();
     loadPersistedPanelCalibration();
 
@@ -1245,6 +1739,7 @@ void setup()
 
 
 #ifdef USE_LCD_SCREEN
+    bootTimelinePhase(sBootTimeline, "lcd", micros());
     sDisplay.setEnabled(sDisplay.begin(SSD1306_SWITCHCAPVCC, SCREEN_ADDRESS));
     if (sDisplay.isEnabled())
     {
@@ -1253,8 +1748,9 @@ void setup()
         sDisplay.setRotation(2);
     }
 #endif
-    MarcSound::Module soundPlayer = (MarcSound::Module)preferences.getInt(PREFERENCE_MARCSOUND, MARC_SOUND_PLAYER);
-    int soundStartup = preferences.getInt(PREFERENCE_MARCSOUND_STARTUP, MARC_SOUND_STARTUP);
+    bootTimelinePhase(sBootTimeline, "sound", micros());
+    MarcSound::Module soundPlayer = (MarcSound::Module)configGetInt(kCfgSoundModule);
+    int soundStartup = configGetInt(kCfgSoundStartup);
     sSoundInitPending = false;
     sSoundInitAttempts = 0;
     if (!soundLocalEnabled)
@@ -1265,12 +1761,14 @@ void setup()
     {
         SOUND_SERIAL.begin(SOUND_BAUD, SERIAL_8N1, SOUND_RX_PIN, SOUND_TX_PIN);
         sSoundInitPending = true;
-        sSoundInitAtMs = millis() + 3000;
         sSoundInitModule = soundPlayer;
         sSoundInitStartup = soundStartup;
-        sSoundInitVolume = preferences.getInt(PREFERENCE_MARCSOUND_VOLUME, MARC_SOUND_VOLUME) / 1000.0f;
+        sSoundInitVolume = configGetInt(kCfgSoundVolume) / 1000.0f;
+        // The module needs a few seconds after power-up before it answers.
+        bootSchedAdd(sBootSched, "sound", bootTaskSound, 0, millis() + 3000, 0);
         DEBUG_PRINTLN(F("Sound module initialization scheduled (deferred)"));
     }
+    bootTimelinePhase(sBootTimeline, "logic", micros());
     // Assign servos to holo projectors
     frontHolo.assignServos(&servoDispatch, 13, 14);
     // Second PCA9685 controller
@@ -1289,20 +1787,21 @@ void setup()
     // Shows droid name on both logic displays during boot
     // Initialize LED effects before WiFi starts
     String bootScroll = "... " + droidName + " ...";
-    RLD.selectScrollTextLeft(bootScroll.c_str(), LogicEngineRenderer::kBlue, kStatusScrollSpeedScale, 15);
-    FLD.selectScrollTextLeft(bootScroll.c_str(), LogicEngineRenderer::kBlue, kStatusScrollSpeedScale, 15);
     RLD.setLogicEffectSelector(CustomLogicEffectSelector);
     FLD.setLogicEffectSelector(CustomLogicEffectSelector);
+    selectLogicTextStrip(RLD, bootScroll.c_str(), LogicEngineRenderer::kBlue, kStatusScrollSpeedScale, 15);
+    selectLogicTextStrip(FLD, bootScroll.c_str(), LogicEngineRenderer::kBlue, kStatusScrollSpeedScale, 15);
     frontPSI.setLogicEffectSelector(CustomLogicEffectSelector);
     rearPSI.setLogicEffectSelector(CustomLogicEffectSelector);
 
 #ifdef USE_WIFI
+    bootTimelinePhase(sBootTimeline, "remote", micros());
     if (remoteEnabled)
     {
 #ifdef USE_SMQ
         WiFi.mode(WIFI_MODE_APSTA);
-        if (SMQ::init(preferences.getString(PREFERENCE_REMOTE_HOSTNAME, SMQ_HOSTNAME),
-                      preferences.getString(PREFERENCE_REMOTE_SECRET, SMQ_SECRET)))
+        if (SMQ::init(configGetString(kCfgRemoteHostname),
+                      configGetString(kCfgRemoteSecret)))
         {
             SMQLMK key;
             if (preferences.getBytes(PREFERENCE_REMOTE_LMK, &key, sizeof(SMQLMK)) == sizeof(SMQLMK))
@@ -1324,8 +1823,8 @@ void setup()
                 }
             }
             printf("Droid Remote Enabled %s:%s\n",
-                   preferences.getString(PREFERENCE_REMOTE_HOSTNAME, SMQ_HOSTNAME).c_str(),
-                   preferences.getString(PREFERENCE_REMOTE_SECRET, SMQ_SECRET).c_str());
+                   configGetString(kCfgRemoteHostname).c_str(),
+                   configGetString(kCfgRemoteSecret).c_str());
             SMQ::setHostPairingCallback([](SMQHost *host)
                                         {
                 if (host == nullptr)
@@ -1390,68 +1889,20 @@ void setup()
         }
 #endif
     }
+#ifdef USE_WIFI_WEB
+    // WiFi, the web server and mDNS come up after the first frame; the web
+    // server and mDNS wait for the connection. See bootTaskWifi().
+    sAsyncWebStarted = false;
     if (wifiEnabled)
     {
-#ifdef USE_WIFI_WEB
-        // In preparation for adding WiFi settings web page
-        wifiAccess.setNetworkCredentials(
-            preferences.getString(PREFERENCE_WIFI_SSID, WIFI_AP_NAME),
-            preferences.getString(PREFERENCE_WIFI_PASS, WIFI_AP_PASSPHRASE),
-            preferences.getBool(PREFERENCE_WIFI_AP, WIFI_ACCESS_POINT),
-            preferences.getBool(PREFERENCE_WIFI_ENABLED, WIFI_ENABLED));
-        // Keep WiFi fully awake to avoid multi-second UI/API latency spikes
-        // seen with default ESP32 modem sleep in STA mode.
-        WiFi.setSleep(false);
-        // CRITICAL: setNetworkCredentials changes WiFi mode to STA
-        // If remote is enabled, we need APSTA mode for ESP-NOW, so override it here
-        if (remoteEnabled)
-        {
-            WiFi.mode(WIFI_MODE_APSTA);
-        }
-#ifdef USE_WIFI_MARCDUINO
-        wifiMarcduinoReceiver.setEnabled(preferences.getBool(PREFERENCE_MARCWIFI_ENABLED, MARC_WIFI_ENABLED));
-        if (wifiMarcduinoReceiver.enabled())
-        {
-            wifiMarcduinoReceiver.setCommandHandler([](const char *cmd)
-                                                    {
-                printf("cmd: %s\n", cmd);
-                marcduinoIngressAdmit(kMarcduinoIngressWifiMarcduino, cmd);
-                if (preferences.getBool(PREFERENCE_MARCWIFI_SERIAL_PASS, MARC_WIFI_SERIAL_PASS))
-                {
-                    COMMAND_SERIAL.print(cmd); COMMAND_SERIAL.print('\r');
-                } });
-        }
-#endif
-        wifiAccess.notifyWifiConnected([](WifiAccess &wifi)
-                                       {
-                                           wifiActive = true;
-                                           WiFi.setSleep(false);
-                                           Serial.print("Connect to http://");
-                                           Serial.println(wifi.getIPAddress());
-#ifdef USE_WIFI_WEB
-                                           if (!sAsyncWebStarted)
-                                           {
-                                               initAsyncWeb();
-                                               sAsyncWebStarted = true;
-                                           }
-#endif
-                                           bodyLinkWiFiInit();
-                                           bodyLinkSetupMDNS();
-                                       });
-        wifiAccess.notifyWifiDisconnected([](WifiAccess &)
-                                          {
-                                              wifiActive = false;
-                                          });
-        bodyLinkWiFiInit();
-#endif
+        sBootTaskWifi = bootSchedAdd(sBootSched, "wifi", bootTaskWifi, 0, 0, 0);
+        sBootTaskWeb = bootSchedAdd(sBootSched, "web", bootTaskWeb, bootSchedBit(sBootTaskWifi), 0, 0);
+        sBootTaskMdns = bootSchedAdd(sBootSched, "mdns", bootTaskMdns, bootSchedBit(sBootTaskWeb), 0, 0);
     }
 #endif
-#ifdef USE_WIFI_WEB
-    sAsyncWebStarted = false;
 #endif
 
-    // DEBUG TEMP: Deferring web server creation until WiFi connected
-    // Logic effect selectors initialized after WiFi connects (see callback above)
+    bootTimelinePhase(sBootTimeline, "tasks", micros());
 #ifdef USE_WIFI
     xTaskCreatePinnedToCore(
         eventLoopTask,
@@ -1462,17 +1913,31 @@ void setup()
         &eventTask,
         0);
 #endif
+    if (configGetBool(kCfgLedRenderTask))
+    {
+        if (ledRenderTaskBegin())
+            logCapture.println("[LED] Render task running on core 0");
+        else
+            logCapture.println("[LED] Render task unavailable, rendering on loop core");
+    }
     DEBUG_PRINTLN(F("Ready"));
-    if (preferences.getBool("holo_boot_loop", true))
+    if (configGetBool(kCfgHoloBootLoop))
+    {
+        LedDisplayGuard displayGuard;
         CommandEvent::process(F("HPS9"));
+    }
     if (soundLocalEnabled && !sSoundInitPending)
     {
         sMarcSound.playStartSound();
-        sMarcSound.setRandomMin(preferences.getInt(PREFERENCE_MARCSOUND_RANDOM_MIN, MARC_SOUND_RANDOM_MIN));
-        sMarcSound.setRandomMax(preferences.getInt(PREFERENCE_MARCSOUND_RANDOM_MAX, MARC_SOUND_RANDOM_MAX));
-        if (preferences.getInt(PREFERENCE_MARCSOUND_RANDOM, MARC_SOUND_RANDOM))
+        sMarcSound.setRandomMin(configGetInt(kCfgSoundRandomMin));
+        sMarcSound.setRandomMax(configGetInt(kCfgSoundRandomMax));
+        if (configGetInt(kCfgSoundRandom))
             sMarcSound.startRandomInSeconds(13);
     }
+    bootTimelineSetupDone(sBootTimeline, micros());
+    logCapture.printf("[Boot] setup done in %u ms, %u tasks deferred\n",
+        (unsigned)((sBootTimeline.setupDoneUs - sBootTimeline.setupStartUs) / 1000),
+        (unsigned)sBootSched.count);
 }
 
 ////////////////
@@ -1509,14 +1974,17 @@ MARCDUINO_ACTION(WifiToggle, #APWIFI, ({
                      }
                      if (wifiEnabled != wifiSetting)
                      {
-                         if (wifiSetting)
+                         const char *errMsg = "";
+                         if (!configSetBool(kCfgWifiEnabled, wifiSetting, errMsg))
+                         {
+                             logCapture.printf("[Config] wifi: %s\n", errMsg);
+                         }
+                         else if (wifiSetting)
                          {
-                             preferences.putBool(PREFERENCE_WIFI_ENABLED, true);
                              DEBUG_PRINTLN(F("WiFi Enabled"));
                          }
                          else
                          {
-                             preferences.putBool(PREFERENCE_WIFI_ENABLED, false);
                              DEBUG_PRINTLN(F("WiFi Disabled"));
                          }
                          reboot();
@@ -1544,14 +2012,17 @@ MARCDUINO_ACTION(RemoteToggle, #APREMOTE, ({
                      }
                      if (remoteEnabled != remoteSetting)
                      {
-                         if (remoteSetting)
+                         const char *errMsg = "";
+                         if (!configSetBool(kCfgRemoteEnabled, remoteSetting, errMsg))
+                         {
+                             logCapture.printf("[Config] remote: %s\n", errMsg);
+                         }
+                         else if (remoteSetting)
                          {
-                             preferences.putBool(PREFERENCE_REMOTE_ENABLED, true);
                              DEBUG_PRINTLN(F("Remote Enabled"));
                          }
                          else
                          {
-                             preferences.putBool(PREFERENCE_REMOTE_ENABLED, false);
                              DEBUG_PRINTLN(F("Remote Disabled"));
                          }
                          reboot();
@@ -1563,11 +2034,18 @@ MARCDUINO_ACTION(RemoteToggle, #APREMOTE, ({
 
 MARCDUINO_ACTION(RemoteName, #APRNAME, ({
                      String newHostname = String(Marcduino::getCommand());
-                     if (preferences.getString(PREFERENCE_REMOTE_HOSTNAME, SMQ_HOSTNAME) != newHostname)
+                     const char *errMsg = "";
+                     if (configGetString(kCfgRemoteHostname) != newHostname)
                      {
-                         preferences.putString(PREFERENCE_REMOTE_HOSTNAME, newHostname);
-                         printf("Changed.\n");
-                         reboot();
+                         if (!configSetText(kCfgRemoteHostname, newHostname.c_str(), errMsg))
+                         {
+                             printf("%s\n", errMsg);
+                         }
+                         else
+                         {
+                             printf("Changed.\n");
+                             reboot();
+                         }
                      }
                  }))
 
@@ -1575,11 +2053,18 @@ MARCDUINO_ACTION(RemoteName, #APRNAME, ({
 
 MARCDUINO_ACTION(RemoteSecret, #APRSECRET, ({
                      String newSecret = String(Marcduino::getCommand());
-                     if (preferences.getString(PREFERENCE_REMOTE_SECRET, SMQ_SECRET) != newSecret)
+                     const char *errMsg = "";
+                     if (configGetString(kCfgRemoteSecret) != newSecret)
                      {
-                         preferences.putString(PREFERENCE_REMOTE_SECRET, newSecret);
-                         printf("Changed.\n");
-                         reboot();
+                         if (!configSetText(kCfgRemoteSecret, newSecret.c_str(), errMsg))
+                         {
+                             printf("%s\n", errMsg);
+                         }
+                         else
+                         {
+                             printf("Changed.\n");
+                             reboot();
+                         }
                      }
                  }))
 
@@ -1609,7 +2094,8 @@ MARCDUINO_ACTION(RemoteUnpair, #APUNPAIR, ({
 ////////////////
 
 MARCDUINO_ACTION(ClearPrefs, #APZERO, ({
-                     preferences.clear();
+                     const char *errMsg = "";
+                     configRegistryReset(errMsg);
                      DEBUG_PRINT(F("Clearing preferences. "));
                      reboot();
                  }))
@@ -1738,7 +2224,7 @@ static bool domePanelSlotDisabled(uint16_t slot, bool statusOk,
 
     const char *id = domePanelSlotElementId(slot);
     if (id == nullptr) return true;
-    int index = domeElementStatusIndexOf(String(id));
+    int index = domeElementStatusIndexOf(id);
     if (index < 0 || index >= DOME_ELEMENT_STATUS_MAX_ELEMENTS) return true;
     return statuses[index].disabled;
 }
@@ -1756,8 +2242,8 @@ static void domeCutPanelServoPwm(uint16_t slot)
 
 static void domeApplyDisabledPanelOverlay()
 {
-    DomeElementStatusSnapshot statuses[DOME_ELEMENT_STATUS_MAX_ELEMENTS];
-    bool statusOk = domeElementStatusReadAll(statuses, DOME_ELEMENT_STATUS_MAX_ELEMENTS);
+    bool statusOk = false;
+    const DomeElementStatusSnapshot *statuses = domeElementStatusCached(statusOk);
     if (!statusOk)
     {
         logCapture.println("[DomeStatus] WARNING: status unavailable; disabling all panel servo slots");
@@ -1796,7 +2282,7 @@ static void domeReloadPanelRoutingWithDisabledOverlay()
 
 String getConfiguredDroidName()
 {
-    String name = preferences.getString(PREFERENCE_DROID_NAME, AP_DROID_NAME);
+    String name = configGetString(kCfgDroidName);
     name.trim();
     if (name.length() == 0)
     {
@@ -1828,6 +2314,7 @@ bool shouldBlockCommandDuringSleep(const char *cmd)
 
 static void applySoftSleepOutputs()
 {
+    LedDisplayGuard displayGuard;
     sMarcSound.suspendRandom();
     sMarcSound.stop();
 
@@ -1846,6 +2333,7 @@ static void applySoftSleepOutputs()
 
 static void applySoftWakeOutputs()
 {
+    LedDisplayGuard displayGuard;
     sMarcSound.resumeRandomInSeconds(2);
     Marcduino::processCommand(player, ":SE14");
     Marcduino::processCommand(player, "@0P1");
@@ -1855,12 +2343,13 @@ bool enterSoftSleepMode(bool fromPeer)
 {
     if (sSleepModeActive) return false;
 
+    LedDisplayGuard displayGuard;
     sWakeTransitionPending = false;
     sWakeTransitionAtMs = 0;
     Marcduino::processCommand(player, ":SE10");
     Marcduino::processCommand(player, "*ST00");
-    FLD.selectScrollTextLeft("GOING TO SLEEP...", LogicEngineRenderer::kBlue, kStatusScrollSpeedScale, 6);
-    RLD.selectScrollTextLeft("GOING TO SLEEP...", LogicEngineRenderer::kBlue, kStatusScrollSpeedScale, 6);
+    selectLogicTextStrip(FLD, "GOING TO SLEEP...", LogicEngineRenderer::kBlue, kStatusScrollSpeedScale, 6);
+    selectLogicTextStrip(RLD, "GOING TO SLEEP...", LogicEngineRenderer::kBlue, kStatusScrollSpeedScale, 6);
 
     sSleepModeActive = true;
     sSleepModeSinceMs = millis();
@@ -1875,9 +2364,10 @@ bool exitSoftSleepMode(bool fromPeer)
 {
     if (!sSleepModeActive) return false;
 
+    LedDisplayGuard displayGuard;
     sSleepEnforceAtMs = 0;
-    FLD.selectScrollTextLeft("WAKING UP...", LogicEngineRenderer::kGreen, kStatusScrollSpeedScale, 6);
-    RLD.selectScrollTextLeft("WAKING UP...", LogicEngineRenderer::kGreen, kStatusScrollSpeedScale, 6);
+    selectLogicTextStrip(FLD, "WAKING UP...", LogicEngineRenderer::kGreen, kStatusScrollSpeedScale, 6);
+    selectLogicTextStrip(RLD, "WAKING UP...", LogicEngineRenderer::kGreen, kStatusScrollSpeedScale, 6);
     sWakeTransitionPending = true;
     sWakeTransitionAtMs = millis() + kSleepTransitionScrollMs;
 
@@ -1943,8 +2433,18 @@ static void cancelPanelRelease(uint32_t mask)
 
 void mainLoop()
 {
-    drainMarcduinoCommandQueue();
+    ledRenderNoteMainLoop();
+    {
+        LedDisplayGuard displayGuard;
+        drainMarcduinoCommandQueue();
+    }
     AnimatedEvent::process();
+    if (bootTimelineFirstFrame(sBootTimeline, micros()))
+    {
+        bootSchedRelease(sBootSched, millis());
+        logCapture.printf("[Boot] first frame %u ms after setup() started\n",
+            (unsigned)((sBootTimeline.firstFrameUs - sBootTimeline.setupStartUs) / 1000));
+    }
 
     // Hand a pending dome sequence to `player` here, outside player.animate(),
     // so it runs as DO_* steps driven by future AnimatedEvent::process() calls
@@ -1954,12 +2454,14 @@ void mainLoop()
         logCapture.printf("[DOME] dispatching pendingAnim\n");
         AnimationStep anim = dome_pendingAnim;
         dome_pendingAnim = nullptr;
+        LedDisplayGuard displayGuard;
         player.animateOnce(anim);
     }
 
     handleBodySerial();
     bodyLinkWiFiRx();
     handleBodyLinkHeartbeat();
+    bodyLinkWiFiFlush();
 
     if (sSleepModeActive && sSleepEnforceAtMs != 0 && (int32_t)(millis() - sSleepEnforceAtMs) >= 0)
     {
@@ -1991,37 +2493,36 @@ void mainLoop()
         sMinFreeHeap = freeHeapNow;
     }
 
-    if (sSoundInitPending && (int32_t)(millis() - sSoundInitAtMs) >= 0)
+    // Deferred start-up work (BootSchedule.h), one step per pass once the
+    // first frame is out.
+    int bootTask = bootSchedStep(sBootSched, millis());
+    if (bootTask >= 0 && sBootSched.tasks[bootTask].state >= kBootTaskComplete)
     {
-        if (sMarcSound.begin(sSoundInitModule, SOUND_SERIAL, sSoundInitStartup))
-        {
-            sMarcSound.setVolume(sSoundInitVolume);
-            sMarcSound.playStartSound();
-            sMarcSound.setRandomMin(preferences.getInt(PREFERENCE_MARCSOUND_RANDOM_MIN, MARC_SOUND_RANDOM_MIN));
-            sMarcSound.setRandomMax(preferences.getInt(PREFERENCE_MARCSOUND_RANDOM_MAX, MARC_SOUND_RANDOM_MAX));
-            if (preferences.getInt(PREFERENCE_MARCSOUND_RANDOM, MARC_SOUND_RANDOM))
-                sMarcSound.startRandomInSeconds(13);
-            sSoundInitPending = false;
-            DEBUG_PRINTLN(F("Sound module initialized (deferred)"));
-        }
-        else
-        {
-            sSoundInitAttempts++;
-            if (sSoundInitAttempts >= 5)
-            {
-                sSoundInitPending = false;
-                DEBUG_PRINTLN(F("FAILED TO INITALIZE SOUND MODULE"));
-            }
-            else
-            {
-                sSoundInitAtMs = millis() + 1000;
-            }
-        }
+        const BootTask &task = sBootSched.tasks[bootTask];
+        logCapture.printf("[Boot] %s %s at %u ms (%u us)\n", task.name, bootTaskStateName(task.state),
+            (unsigned)task.endMs, (unsigned)task.runUs);
     }
+#ifdef USE_WIFI_WEB
+    if (sWifiReconnectPending && bootSchedFinished(sBootSched, sBootTaskMdns))
+    {
+        sWifiReconnectPending = false;
+        bodyLinkWiFiInit();
+        bodyLinkSetupMDNS();
+    }
+#endif
 
+    if (sSoundRandomDirty && !sSoundInitPending)
+    {
+        sSoundRandomDirty = false;
+        sMarcSound.setRandomMin(configGetInt(kCfgSoundRandomMin));
+        sMarcSound.setRandomMax(configGetInt(kCfgSoundRandomMax));
+    }
     sMarcSound.idle();
 #ifdef USE_MENUS
-    sDisplay.process();
+    {
+        LedDisplayGuard displayGuard;
+        sDisplay.process();
+    }
 #endif
 
 
@@ -2030,7 +2531,7 @@ void mainLoop()
 
         int ch = Serial.read();
         // ================================================================
-        if (preferences.getBool(PREFERENCE_MARCSERIAL_PASS, MARC_SERIAL_PASS))
+        if (configGetBool(kCfgMarcSerialPass))
         {
             COMMAND_SERIAL.write(ch); // send it out COMMAND_SERIAL
         }
@@ -9,15 +9,28 @@
 #include <Update.h>
 #include <Wire.h>
 #include <WiFi.h>
+#include <esp_ota_ops.h>
 #include <ctype.h>
 #include <string.h>
+#include <memory>
 #include "SPIFFS.h"
+#include "ChunkedJsonStream.h"
 #include "LogCapture.h"
 #include "WiringConfig.h"
 #include "WiringCommissioning.h"
 #include "GeneratedDomeLayout.h"
 #include "DomeElementStatus.h"
 #include "DomeLayoutTemplateStore.h"
+#include "DomeLayoutWriter.h"
+#include "LedFrameGate.h"
+#include "LogicSpriteStore.h"
+#include "WebAssetStore.h"
+#include "OtaStream.h"
+#include "DeltaPatch.h"
+#include "BootSchedule.h"
+#ifdef USE_LEGACY_WEB_PAGES
+#include "WebPages.h"
+#endif
 
 // Gadget includes for extern declarations
 #if AP_ENABLE_FIRESTRIP
@@ -36,9 +49,10 @@
 // Forward declarations — these are defined in AstroPixelsPlus.ino
 extern void reboot();
 extern void unmountFileSystems();
+extern bool mountReadOnlyFileSystem();
 
 // Globals defined in .ino that we need access to
-extern AnimationPlayer player;
+extern DisplayLockedAnimationPlayer player;
 extern Preferences preferences;
 extern bool wifiEnabled;
 extern bool remoteEnabled;
@@ -47,6 +61,7 @@ extern bool soundLocalEnabled;
 extern bool sSleepModeActive;
 extern uint32_t sSleepModeSinceMs;
 extern uint32_t sMinFreeHeap;
+extern uint32_t sBootFreeHeap;
 extern uint32_t sBodyLastSeenMs;
 extern uint32_t sBodyHeartbeatRx;
 extern uint32_t sBodyLastTxMs;
@@ -62,12 +77,7 @@ extern bool shouldBlockCommandDuringSleep(const char *cmd);
 extern bool enterSoftSleepMode(bool fromPeer = false);
 extern bool exitSoftSleepMode(bool fromPeer = false);
 extern String getConfiguredDroidName();
-
-// Gadget preference constants (must match AstroPixelsPlus.ino)
-#define PREFERENCE_BADMOTIVATOR_ENABLED "badmot"
-#define PREFERENCE_FIRESTRIP_ENABLED "firest"
-#define PREFERENCE_CBI_ENABLED "cbienb"
-#define PREFERENCE_DATAPANEL_ENABLED "dpenab"
+extern String configGetString(ConfigKeyId id);
 
 #ifdef USE_DROID_REMOTE
 extern bool sRemoteConnected;
@@ -126,7 +136,8 @@ static uint32_t i2cProbeFailures = 0;
 
 // Forward declarations
 static void broadcastState();
-static void broadcastOtaProgress(float progress);
+static void broadcastOtaProgress(float progress, uint32_t kbps = 0);
+static void broadcastElementStatusDelta(const int *changed, int changedCount);
 
 static String otaJson(bool ok, const String &error = "")
 {
@@ -142,6 +153,255 @@ static void markOtaUploadFailed(int status, const char *error)
     otaUploadError = error;
 }
 
+// ---------------------------------------------------------------
+// Firmware OTA pipeline (OtaStream.h). With AP_OTA_WRITER_TASK the
+// Update.write() calls run on a small task, so a sector erase
+// overlaps with receiving the next sector instead of holding up
+// async_tcp; 0 writes inline from the upload handler.
+// ---------------------------------------------------------------
+#ifndef AP_OTA_WRITER_TASK
+#define AP_OTA_WRITER_TASK 1
+#endif
+#define OTA_WRITER_TASK_STACK 3072
+
+struct OtaWriteJob
+{
+    const uint8_t *data;
+    size_t len;
+};
+
+static OtaStream sOtaStream;
+static uint32_t sOtaRequestBase = 0;    // offset the current request started at
+static String sOtaLastDigest;
+static QueueHandle_t sOtaWriteQueue = nullptr;
+static SemaphoreHandle_t sOtaWriteDone = nullptr;
+static volatile bool sOtaWriteOk = true;
+
+static void otaWriterTaskLoop(void *)
+{
+    OtaWriteJob job;
+    for (;;)
+    {
+        if (xQueueReceive(sOtaWriteQueue, &job, portMAX_DELAY) != pdTRUE)
+            continue;
+        sOtaWriteOk = Update.write((uint8_t *)job.data, job.len) == job.len;
+        xSemaphoreGive(sOtaWriteDone);
+    }
+}
+
+static bool otaWriterSubmit(void *, const uint8_t *block, size_t len)
+{
+    if (sOtaWriteQueue != nullptr)
+    {
+        OtaWriteJob job = {block, len};
+        return xQueueSend(sOtaWriteQueue, &job, portMAX_DELAY) == pdTRUE;
+    }
+    sOtaWriteOk = Update.write((uint8_t *)block, len) == len;
+    return true;
+}
+
+static bool otaWriterReclaim(void *)
+{
+    if (sOtaWriteQueue != nullptr)
+        xSemaphoreTake(sOtaWriteDone, portMAX_DELAY);
+    return sOtaWriteOk;
+}
+
+static const OtaStreamSink kOtaWriterSink = {otaWriterSubmit, otaWriterReclaim, nullptr};
+
+// Started on the first firmware upload and kept; it sleeps on its queue.
+static void otaWriterBegin()
+{
+#if AP_OTA_WRITER_TASK
+    if (sOtaWriteQueue != nullptr)
+        return;
+    QueueHandle_t queue = xQueueCreate(1, sizeof(OtaWriteJob));
+    sOtaWriteDone = xSemaphoreCreateBinary();
+    if (queue == nullptr || sOtaWriteDone == nullptr)
+    {
+        logCapture.println("[OTA] Writer task unavailable, writing inline");
+        return;
+    }
+    sOtaWriteQueue = queue;
+    if (xTaskCreatePinnedToCore(otaWriterTaskLoop, "OtaWriter", OTA_WRITER_TASK_STACK,
+                                NULL, 2, NULL, 0) != pdPASS)
+    {
+        sOtaWriteQueue = nullptr;
+        vQueueDelete(queue);
+        logCapture.println("[OTA] Writer task unavailable, writing inline");
+    }
+#endif
+}
+
+static uint32_t otaQueryUInt(AsyncWebServerRequest *request, const char *name)
+{
+    if (!request->hasParam(name))
+        return 0;
+    return strtoul(request->getParam(name)->value().c_str(), nullptr, 10);
+}
+
+// Held by the upload handlers (async_tcp) for each chunk and by the loop while
+// it expires a parked session, so the two never touch sOtaStream at once.
+static SemaphoreHandle_t sOtaSessionLock = nullptr;
+
+class OtaSessionGuard
+{
+public:
+    explicit OtaSessionGuard(TickType_t wait = portMAX_DELAY) :
+        fHeld(sOtaSessionLock != nullptr && xSemaphoreTake(sOtaSessionLock, wait) == pdTRUE)
+    {
+    }
+
+    ~OtaSessionGuard()
+    {
+        if (fHeld)
+            xSemaphoreGive(sOtaSessionLock);
+    }
+
+    bool held() const { return fHeld; }
+
+private:
+    OtaSessionGuard(const OtaSessionGuard &);
+    OtaSessionGuard &operator=(const OtaSessionGuard &);
+
+    bool fHeld;
+};
+
+// Drops an interrupted session nobody came back for. Returns true if one was
+// dropped; the caller decides whether SPIFFS goes back up.
+static bool otaExpireSession(uint32_t now)
+{
+    if (!otaStreamExpired(sOtaStream, now))
+        return false;
+    otaStreamAbort(sOtaStream, kOtaWriterSink);
+    Update.abort();
+    otaInProgress = false;
+    logCapture.printf("Update session expired at %u bytes\n", sOtaStream.received);
+    return true;
+}
+
+static String otaStatusBuildJson()
+{
+    const OtaStreamStats &st = sOtaStream.stats;
+    uint32_t now = millis();
+    uint32_t idle = now - sOtaStream.lastChunkMs;
+    String json = "{\"active\":" + String(sOtaStream.active ? "true" : "false");
+    json += ",\"offset\":" + String(sOtaStream.received);
+    json += ",\"size\":" + String(sOtaStream.size);
+    json += ",\"written\":" + String(sOtaStream.written);
+    json += ",\"blocks\":" + String(st.blocks);
+    json += ",\"kbps\":" + String(otaStreamKbps(sOtaStream));
+    json += ",\"elapsed_ms\":" + String(st.elapsedMs);
+    json += ",\"stalls\":" + String(st.stalls);
+    json += ",\"stall_ms\":" + String(st.stallMs);
+    json += ",\"max_gap_ms\":" + String(st.maxGapMs);
+    json += ",\"resumes\":" + String(st.resumes);
+    json += ",\"resume_window_ms\":" +
+            String(sOtaStream.active && idle < OTA_STREAM_RESUME_WINDOW_MS ? OTA_STREAM_RESUME_WINDOW_MS - idle : 0);
+    json += ",\"sha256\":\"" + sOtaLastDigest + "\"";
+    json += ",\"writer_task\":" + String(sOtaWriteQueue != nullptr ? "true" : "false") + "}";
+    return json;
+}
+
+// ---------------------------------------------------------------
+// Delta firmware upload (DeltaPatch.h). The patch is applied while
+// it streams in: old bytes are read from the running partition,
+// new bytes go through sOtaStream into the OTA slot, so the target
+// digest is checked exactly as for a full image.
+// ---------------------------------------------------------------
+static DeltaPatch sDeltaPatch;
+static const esp_partition_t *sDeltaBase = nullptr;
+
+static bool deltaReadRunning(void *, uint32_t offset, uint8_t *buf, size_t len)
+{
+    return esp_partition_read(sDeltaBase, offset, buf, len) == ESP_OK;
+}
+
+static bool deltaWriteNew(void *, const uint8_t *data, size_t len)
+{
+    return otaStreamWrite(sOtaStream, kOtaWriterSink, data, len, millis()) == kOtaStreamOk;
+}
+
+static const DeltaPatchIo kDeltaPatchIo = {deltaReadRunning, deltaWriteNew, nullptr};
+
+// The patch only applies to the exact image it was built against. Hashing
+// the ~1.3 MB running image when a patch header arrives would stall
+// async_tcp, so asyncWebLoop() hashes it once per boot, a slice per pass, and
+// the upload only compares digests.
+#define DELTA_BASE_HASH_SLICE 16384
+static DeltaPatchBaseHash sDeltaBaseHash;
+static bool sDeltaBaseHashStarted = false;
+static bool sDeltaBaseHashFailed = false;
+
+static void deltaBaseHashStep()
+{
+    if (sDeltaBaseHash.ready || sDeltaBaseHashFailed || otaInProgress)
+        return;
+    if (!sDeltaBaseHashStarted)
+    {
+        sDeltaBase = esp_ota_get_running_partition();
+        uint32_t size = 0;
+        if (sDeltaBase == nullptr || !deltaPatchImageLength(kDeltaPatchIo, sDeltaBase->size, size))
+        {
+            sDeltaBaseHashFailed = true;
+            logCapture.println("Delta update: running image header unreadable, delta uploads disabled");
+            return;
+        }
+        deltaPatchBaseHashBegin(sDeltaBaseHash, size);
+        sDeltaBaseHashStarted = true;
+    }
+    if (!deltaPatchBaseHashStep(sDeltaBaseHash, kDeltaPatchIo, DELTA_BASE_HASH_SLICE))
+    {
+        sDeltaBaseHashFailed = true;
+        logCapture.println("Delta update: reading the running image failed");
+    }
+}
+
+// Called once the patch header is in: checks the base and opens the
+// OTA slot and stream for the new image.
+static bool deltaUploadStart(uint32_t now)
+{
+    const DeltaPatchHeader &header = sDeltaPatch.header;
+    if (!sDeltaBaseHash.ready)
+    {
+        markOtaUploadFailed(503, sDeltaBaseHashFailed ? "running firmware digest unavailable"
+                                                      : "running firmware digest not ready, retry shortly");
+        return false;
+    }
+    if (!deltaPatchBaseMatches(sDeltaBaseHash, header))
+    {
+        logCapture.println("Delta update: patch was not built against the running firmware");
+        markOtaUploadFailed(409, "patch base does not match the running firmware");
+        return false;
+    }
+    char hex[SHA256_HEX_LEN + 1];
+    sha256ToHex(header.newSha, hex);
+    otaWriterBegin();
+    sOtaWriteOk = true;
+    otaStreamBegin(sOtaStream, header.newSize, hex, now);
+    if (!Update.begin(header.newSize, U_FLASH))
+    {
+        Update.printError(Serial);
+        logCapture.println("Update begin failed");
+        otaStreamAbort(sOtaStream, kOtaWriterSink);
+        markOtaUploadFailed(413, "firmware image rejected or too large for OTA slot");
+        return false;
+    }
+    logCapture.printf("Delta update: %u -> %u bytes, base verified\n", header.oldSize, header.newSize);
+    return true;
+}
+
+static void deltaUploadFail(int status, const char *error)
+{
+    logCapture.printf("Delta update failed: %s\n", error);
+    if (sOtaStream.active)
+    {
+        otaStreamAbort(sOtaStream, kOtaWriterSink);
+        Update.abort();
+    }
+    markOtaUploadFailed(status, error);
+}
+
 static bool isAsciiPrintable(char c)
 {
     return c >= 32 && c <= 126;
@@ -223,88 +483,6 @@ static bool guardSleep(AsyncWebServerRequest *request, const char *cmd)
     return false;
 }
 
-static bool isSensitivePrefKey(const String &key)
-{
-    return key == "pass" || key == "rsecret";
-}
-
-static bool isAllowedPrefKey(const String &key)
-{
-    return key == "wifi" || key == "ap" || key == "ssid" || key == "pass" ||
-           key == "remote" || key == "rhost" || key == "rsecret" ||
-           key == "mserial2" || key == "mserialpass" || key == "mserial" ||
-           key == "mwifi" || key == "mwifipass" ||
-           key == "msound" || key == "msoundser" || key == "mvolume" ||
-           key == "msoundstart" || key == "mrandom" || key == "mrandommin" ||
-           key == "mrandommax" || key == "msoundlocal" ||
-           key == "dname" ||
-           key == "mbodylink" || key == "mbodywifi" || key == "bodypeerip" ||
-           key == PREFERENCE_BADMOTIVATOR_ENABLED || key == PREFERENCE_FIRESTRIP_ENABLED ||
-           key == PREFERENCE_CBI_ENABLED || key == PREFERENCE_DATAPANEL_ENABLED ||
-           key == "holo_boot_loop" || key == "dm_happy_sound";
-}
-
-static size_t maxPrefValueLen(const String &key)
-{
-    if (key == "ssid" || key == "rhost") return 32;
-    if (key == "pass" || key == "rsecret") return 64;
-    if (key == "dname") return 24;
-    if (key == "bodypeerip") return 15;
-    return 16;
-}
-
-static bool defaultBoolForPrefKey(const String &key)
-{
-    if (key == "wifi") return WIFI_ENABLED;
-    if (key == "ap") return WIFI_ACCESS_POINT;
-    if (key == "remote") return REMOTE_ENABLED;
-    if (key == "msoundlocal") return MARC_SOUND_LOCAL_ENABLED;
-    if (key == "mserialpass") return MARC_SERIAL_PASS;
-    if (key == "mserial") return MARC_SERIAL_ENABLED;
-    if (key == "mwifi") return MARC_WIFI_ENABLED;
-    if (key == "mwifipass") return MARC_WIFI_SERIAL_PASS;
-    if (key == "mbodylink") return BODY_LINK_ENABLED;
-    if (key == "mbodywifi") return BODY_WIFI_ENABLED;
-    if (key == PREFERENCE_BADMOTIVATOR_ENABLED) return AP_ENABLE_BADMOTIVATOR;
-    if (key == PREFERENCE_FIRESTRIP_ENABLED) return AP_ENABLE_FIRESTRIP;
-    if (key == PREFERENCE_CBI_ENABLED) return AP_ENABLE_CBI;
-    if (key == PREFERENCE_DATAPANEL_ENABLED) return AP_ENABLE_DATAPANEL;
-    if (key == "holo_boot_loop") return true;
-    if (key == "dm_happy_sound") return true;
-    return false;
-}
-
-static bool isIntegerPrefKey(const String &key)
-{
-    return key == "mserial2" || key == "msound" || key == "msoundser" ||
-           key == "mvolume" || key == "msoundstart" || key == "mrandom" ||
-           key == "mrandommin" || key == "mrandommax";
-}
-
-static int defaultIntForPrefKey(const String &key)
-{
-    if (key == "mserial2") return MARC_SERIAL2_BAUD_RATE;
-    if (key == "msound") return MARC_SOUND_PLAYER;
-    if (key == "msoundser") return MARC_SOUND_SERIAL;
-    if (key == "mvolume") return MARC_SOUND_VOLUME;
-    if (key == "msoundstart") return MARC_SOUND_STARTUP;
-    if (key == "mrandom") return MARC_SOUND_RANDOM;
-    if (key == "mrandommin") return MARC_SOUND_RANDOM_MIN;
-    if (key == "mrandommax") return MARC_SOUND_RANDOM_MAX;
-    return 0;
-}
-
-static bool parseIntegerPrefValue(const String &val, int &out)
-{
-    if (val.length() == 0) return false;
-    for (size_t i = 0; i < val.length(); i++)
-    {
-        if (!isdigit((unsigned char)val[i])) return false;
-    }
-    out = val.toInt();
-    return true;
-}
-
 static String jsonEscape(const String &in)
 {
     String out;
@@ -380,7 +558,7 @@ static String buildStateJson()
     json += ",\"sleepSinceMs\":" + String(sSleepModeSinceMs);
     json += ",\"mood\":{\"command\":\"" + String(sCurrentMoodCmd) + "\"";
     json += ",\"name\":\"" + String(currentMoodName()) + "\"}";
-    int soundPref = preferences.getInt("msound", MARC_SOUND_PLAYER);
+    int soundPref = configGetInt(kCfgSoundModule);
     bool soundModuleEnabled = (soundLocalEnabled && soundPref != 0);
     json += ",\"soundModuleEnabled\":" + String(soundModuleEnabled ? "true" : "false");
 #ifdef USE_DROID_REMOTE
@@ -396,11 +574,12 @@ static String buildStateJson()
     json += ",\"minFreeHeap\":" + String(sMinFreeHeap);
     json += ",\"i2c_probe_failures\":" + String(i2cProbeFailures);
     // Body link status (for real-time WebSocket updates)
-    bool bodyLinkPrefEnabled = preferences.getBool("mbodylink", BODY_LINK_ENABLED);
+    bool bodyLinkPrefEnabled = configGetBool(kCfgBodyLinkEnabled);
     json += ",\"body_link\":{\"enabled\":" + String(bodyLinkPrefEnabled ? "true" : "false");
     json += ",\"connected\":" + String(bodyLinkConnected() ? "true" : "false");
     json += ",\"transport\":\"" + String(bodyLinkGetTransportName()) + "\"";
     json += ",\"wifi_enabled\":" + String(bodyLinkWifiEnabled() ? "true" : "false");
+    json += ",\"framed\":" + String(sBodyFramed ? "true" : "false");
     json += ",\"peer_ip\":\"" + jsonEscape(bodyLinkGetPeerIP()) + "\"}";
     json += ",\"droidName\":\"" + jsonEscape(droidName) + "\"";
 
@@ -421,20 +600,14 @@ static String buildStateJson()
     return json;
 }
 
-static int domeLayoutPanelSlotForId(const char *id)
-{
-    if (!id) return -1;
-    for (int i = 0; i < NUM_PANEL_SLOTS; i++)
-    {
-        if (strcmp(id, kPanelSlotLabels[i]) == 0) return i;
-    }
-    return -1;
-}
+// Layout ids resolve to panel slots through the generated id index, which is
+// built from kPanelSlotLabels.
+static_assert(DomeLayout::kPanelSlotCount == NUM_PANEL_SLOTS,
+              "GeneratedDomeLayout.h panel slots are stale; rerun tools/generate_dome_layout_header.py");
 
-static bool domeLayoutPanelActive(const char *id)
+static bool domeLayoutPanelSlotActive(int slot)
 {
-    int slot = domeLayoutPanelSlotForId(id);
-    if (slot < 0) return false;
+    if (slot < 0 || slot >= NUM_PANEL_SLOTS) return false;
 #ifndef USE_I2C_ADDRESS
     return wiringCommissioningPanelSlotActive(slot);
 #else
@@ -442,105 +615,11 @@ static bool domeLayoutPanelActive(const char *id)
 #endif
 }
 
-static void domeLayoutAppendStringArray(String &json, const char *field,
-                                        const char *const *values, size_t count)
-{
-    json += ",\"";
-    json += field;
-    json += "\":[";
-    for (size_t i = 0; i < count; i++)
-    {
-        if (i > 0) json += ',';
-        json += '"';
-        json += jsonEscape(String(values[i]));
-        json += '"';
-    }
-    json += ']';
-}
-
-static void domeLayoutAppendPoint(String &json, const char *field,
-                                  const DomeLayout::DomeLayoutPoint &point)
-{
-    if (!point.present) return;
-    json += ",\"";
-    json += field;
-    json += "\":{\"x\":";
-    json += String(point.x, 1);
-    json += ",\"y\":";
-    json += String(point.y, 1);
-    json += '}';
-}
-
-static void domeLayoutAppendGeometry(String &json,
-                                     const DomeLayout::DomeLayoutElement &element)
-{
-    if (!element.inLayout) return;
-    json += ",\"geometry\":{\"type\":\"";
-    switch (element.geometryType)
-    {
-        case DomeLayout::DomeLayoutGeometryType::SvgPath:
-            json += "svg_path\",\"d\":\"";
-            json += jsonEscape(String(element.svgPath ? element.svgPath : ""));
-            json += '"';
-            break;
-        case DomeLayout::DomeLayoutGeometryType::Circle:
-            json += "circle\",\"cx\":";
-            json += String(element.cx, 1);
-            json += ",\"cy\":";
-            json += String(element.cy, 1);
-            json += ",\"r\":";
-            json += String(element.r, 1);
-            break;
-        case DomeLayout::DomeLayoutGeometryType::Ellipse:
-            json += "ellipse\",\"cx\":";
-            json += String(element.cx, 1);
-            json += ",\"cy\":";
-            json += String(element.cy, 1);
-            json += ",\"rx\":";
-            json += String(element.rx, 1);
-            json += ",\"ry\":";
-            json += String(element.ry, 1);
-            json += ",\"rotation\":";
-            json += String(element.rotation, 1);
-            break;
-        case DomeLayout::DomeLayoutGeometryType::Point:
-            json += "point\",\"cx\":";
-            json += String(element.cx, 1);
-            json += ",\"cy\":";
-            json += String(element.cy, 1);
-            json += ",\"r\":";
-            json += String(element.r, 1);
-            break;
-    }
-    json += '}';
-}
-
-static void domeLayoutAppendCallout(String &json,
-                                    const DomeLayout::DomeLayoutCallout &callout)
-{
-    if (!callout.present) return;
-    json += ",\"callout\":{\"x\":";
-    json += String(callout.x, 1);
-    json += ",\"y\":";
-    json += String(callout.y, 1);
-    json += ",\"r\":";
-    json += String(callout.r, 1);
-    if (callout.connectorPresent)
-    {
-        json += ",\"connector_to\":{\"x\":";
-        json += String(callout.connectorX, 1);
-        json += ",\"y\":";
-        json += String(callout.connectorY, 1);
-        json += '}';
-    }
-    json += '}';
-}
-
-static bool domeLayoutReadStatusForId(const String &id,
-                                      const DomeElementStatusSnapshot *statuses,
-                                      bool statusOk,
-                                      bool &disabled,
-                                      String &reason)
+static bool domeLayoutReadStatusAt(int index,
+                                   const DomeElementStatusSnapshot *statuses,
+                                   bool statusOk,
+                                   bool &disabled,
+                                   String &reason)
 {
     disabled = false;
     reason = "";
@@ -550,311 +629,480 @@ static bool domeLayoutReadStatusForId(const String &id,
         reason = "status unavailable";
         return false;
     }
-    int index = domeElementStatusIndexOf(id);
     if (index < 0 || index >= DOME_ELEMENT_STATUS_MAX_ELEMENTS) return false;
     disabled = statuses[index].disabled;
     reason = statuses[index].reason;
     return true;
 }
 
-static bool domeLayoutElementCarriesActive(const String &id)
+// ---------------------------------------------------------------
+// Dome layout response cache
+// ---------------------------------------------------------------
+// The template part of /api/dome/layout (geometry, labels, aliases) only
+// changes when the template is swapped, so it is composed once and kept as a
+// flat string with splice points. Each request re-emits the static bytes and
+// fills in the small runtime overlay (active, disabled, disabled_reason,
+// runtime_state_ts) at the splice points. The ETag ties the static hash to the
+// overlay generations so unchanged layouts revalidate with a 304.
+
+#define DOME_LAYOUT_SPLICE_TS -2
+
+struct DomeLayoutSplice
+{
+    uint32_t offset;
+    int8_t statusIndex;   // DOME_LAYOUT_SPLICE_TS for runtime_state_ts
+    int8_t panelSlot;
+    bool hasActive;
+};
+
+struct DomeLayoutCache
+{
+    bool valid;
+    bool custom;
+    bool compiled;
+    uint32_t compiledBytes;
+    String staticJson;
+    DomeLayoutSplice splices[DOME_LAYOUT_TEMPLATE_MAX_ELEMENTS + 1];
+    uint8_t spliceCount;
+    uint32_t staticHash;
+    uint32_t templateGeneration;
+    uint32_t activeMask;
+    uint32_t activeWiringGeneration;
+    bool activeMaskValid;
+    uint32_t overlayStatusGeneration;
+    uint32_t overlayWiringGeneration;
+    uint32_t overlayTs;
+    uint32_t builds;
+    uint32_t lastBuildUs;
+    uint32_t served;
+    uint32_t notModified;
+};
+
+static_assert(NUM_PANEL_SLOTS <= 32, "dome layout active mask holds 32 panel slots");
+
+static DomeLayoutCache sDomeLayoutCache;
+static uint32_t sDomeLayoutBootNonce = 0;
+
+static bool domeLayoutCacheAddSplice(int statusIndex, int panelSlot, bool hasActive)
+{
+    DomeLayoutCache &cache = sDomeLayoutCache;
+    if (cache.spliceCount >= sizeof(cache.splices) / sizeof(cache.splices[0])) return false;
+    DomeLayoutSplice &splice = cache.splices[cache.spliceCount++];
+    splice.offset = cache.staticJson.length();
+    splice.statusIndex = (int8_t)statusIndex;
+    splice.panelSlot = (int8_t)panelSlot;
+    splice.hasActive = hasActive;
+    return true;
+}
+
+// One index probe yields the status index, panel slot and commandable flag
+// that the overlay needs for this element.
+static bool domeLayoutCacheAddElementSplice(const char *id, bool commandable)
 {
-    return domeLayoutTemplateIsCommandableId(id);
+    const DomeLayout::DomeLayoutIdIndexEntry *entry = DomeLayout::findId(id);
+    if (!entry) return domeLayoutCacheAddSplice(-1, -1, false);
+    bool hasActive = commandable && DomeLayout::kElements[entry->elementIndex].commandable;
+    return domeLayoutCacheAddSplice(entry->elementIndex, entry->panelSlot, hasActive);
 }
 
-static bool domeLayoutTemplateFindElementFieldBool(const String &objectJson,
-                                                   const char *wantedKey,
-                                                   bool &out)
+static void domeLayoutCacheSinkWrite(void *, const char *data, size_t len)
 {
-    const char *p = objectJson.c_str();
-    String errMsg;
-    if (!domeLayoutTemplateExpectChar(p, '{', errMsg)) return false;
-    while (true)
+    sDomeLayoutCache.staticJson.concat(data, len);
+}
+
+static bool domeLayoutCacheSinkSplice(void *, const char *id, bool commandable)
+{
+    if (id == nullptr) return domeLayoutCacheAddSplice(DOME_LAYOUT_SPLICE_TS, -1, false);
+    return domeLayoutCacheAddElementSplice(id, commandable);
+}
+
+// Renders the static part from element records through DomeLayoutWriter.h.
+// Bundled MK4 and compiled custom templates both come through here, so they
+// serve identically.
+static void domeLayoutBuildStatic(const DomeLayoutStaticMeta &meta, size_t count,
+                                  DomeLayoutElementAtFn elementAt, void *ctx)
+{
+    static const DomeLayoutSink sink = {
+        domeLayoutCacheSinkWrite, domeLayoutCacheSinkSplice, nullptr
+    };
+    sDomeLayoutCache.staticJson.reserve(2048 + (count * 320));
+    domeLayoutWriteStatic(sink, meta, count, elementAt, ctx);
+}
+
+static void domeLayoutBundledElementAt(void *, size_t index, DomeLayout::DomeLayoutElement &out)
+{
+    out = DomeLayout::kElements[index];
+}
+
+static void domeLayoutBuildBundledStatic()
+{
+    static const DomeLayoutStaticMeta meta = {
+        DomeLayout::kSchemaRevision, DomeLayout::kTemplateId, DomeLayout::kTemplateName,
+        DomeLayout::kTemplateRevision, DomeLayout::kModel, DomeLayout::kSource,
+        "bundled", DomeLayout::kCoordinateSpaceViewBox
+    };
+    domeLayoutBuildStatic(meta, DomeLayout::kElementCount, domeLayoutBundledElementAt, nullptr);
+}
+
+struct DomeLayoutCompiledView
+{
+    const uint8_t *blob;
+    const DomeLayoutCompiledHeader *header;
+    const char *aliases[DOME_LAYOUT_COMPILED_MAX_ALIASES];
+    const char *capabilities[DOME_LAYOUT_COMPILED_MAX_CAPABILITIES];
+};
+
+static void domeLayoutCompiledElementAt(void *ctx, size_t index, DomeLayout::DomeLayoutElement &out)
+{
+    DomeLayoutCompiledView *view = (DomeLayoutCompiledView *)ctx;
+    domeLayoutCompiledElement(view->blob, *view->header, index, out, view->aliases, view->capabilities);
+}
+
+static void domeLayoutBuildCompiledStatic(const uint8_t *blob, const DomeLayoutCompiledHeader &header)
+{
+    DomeLayoutStaticMeta meta = {
+        header.schemaRevision,
+        domeLayoutCompiledString(blob, header, header.templateId),
+        domeLayoutCompiledString(blob, header, header.templateName),
+        header.templateRevision,
+        domeLayoutCompiledString(blob, header, header.model),
+        domeLayoutCompiledString(blob, header, header.source),
+        "custom",
+        domeLayoutCompiledString(blob, header, header.viewBox)
+    };
+    DomeLayoutCompiledView view = {};
+    view.blob = blob;
+    view.header = &header;
+    domeLayoutBuildStatic(meta, header.elementCount, domeLayoutCompiledElementAt, &view);
+}
+
+// Builds the custom static part from the compiled records, compiling the
+// installed JSON first when no fresh compiled file exists. A template that
+// cannot be compiled (invalid, or no heap for the compiler) is not served;
+// the caller falls back to bundled MK4.
+static bool domeLayoutBuildCustomStatic(String &errMsg)
+{
+    DomeLayoutCache &cache = sDomeLayoutCache;
+    uint8_t *blob = nullptr;
+    size_t len = 0;
+    DomeLayoutCompiledHeader header;
+    String compiledErr;
+    bool haveBlob = domeLayoutTemplateLoadCompiled(blob, len, header, compiledErr);
+    if (!haveBlob)
+        haveBlob = domeLayoutTemplateCompileInstalled(blob, len, header, errMsg);
+    if (!haveBlob)
+        return false;
+    domeLayoutBuildCompiledStatic(blob, header);
+    free(blob);
+    cache.compiled = true;
+    cache.compiledBytes = len;
+    return true;
+}
+
+static uint32_t domeLayoutFnv1a(const String &text)
+{
+    uint32_t hash = 2166136261UL;
+    const char *p = text.c_str();
+    for (size_t i = 0; i < text.length(); i++)
     {
-        domeLayoutTemplateSkipWs(p);
-        if (*p == '}') return false;
-        String key;
-        if (!domeLayoutTemplateParseJsonString(p, key, errMsg)) return false;
-        if (!domeLayoutTemplateExpectChar(p, ':', errMsg)) return false;
-        if (key == wantedKey)
+        hash ^= (uint8_t)p[i];
+        hash *= 16777619UL;
+    }
+    return hash;
+}
+
+// Rebuilds the static part when the template selection or custom file
+// changed since the last build. Custom templates are validated here once;
+// a template that no longer validates falls back to bundled MK4.
+static void domeLayoutCacheEnsureStatic()
+{
+    DomeLayoutCache &cache = sDomeLayoutCache;
+    if (cache.valid && cache.templateGeneration == sDomeLayoutTemplateGeneration) return;
+
+    uint32_t startUs = micros();
+    if (sDomeLayoutBootNonce == 0) sDomeLayoutBootNonce = esp_random() | 1;
+    cache.templateGeneration = sDomeLayoutTemplateGeneration;
+    cache.custom = false;
+    cache.compiled = false;
+    cache.compiledBytes = 0;
+    if (domeLayoutTemplateIsCustomSelected())
+    {
+        String errMsg;
+        cache.staticJson = "";
+        cache.spliceCount = 0;
+        cache.custom = domeLayoutBuildCustomStatic(errMsg);
+        if (!cache.custom)
         {
-            return domeLayoutTemplateParseBool(p, out);
+            logCapture.printf("[API] custom dome layout rejected at serve time: %s\n",
+                              errMsg.c_str());
         }
-        if (!domeLayoutTemplateSkipJsonValue(p, errMsg)) return false;
-        domeLayoutTemplateSkipWs(p);
-        if (*p == ',') { p++; continue; }
-        if (*p == '}') return false;
-        return false;
     }
+    if (!cache.custom)
+    {
+        cache.staticJson = "";
+        cache.spliceCount = 0;
+        domeLayoutBuildBundledStatic();
+    }
+    cache.staticHash = domeLayoutFnv1a(cache.staticJson);
+    cache.valid = true;
+    cache.builds++;
+    cache.lastBuildUs = micros() - startUs;
 }
 
-static int domeLayoutTemplateFindElementsKey(const String &json)
+// Refreshes the per-slot active mask and the overlay timestamp. Both only
+// move when wiring or element status generations move, which keeps the body
+// byte-identical for a given ETag.
+static void domeLayoutCacheEnsureOverlay()
 {
-    const char *p = json.c_str();
-    String errMsg;
-    if (!domeLayoutTemplateExpectChar(p, '{', errMsg)) return -1;
-    while (true)
+    DomeLayoutCache &cache = sDomeLayoutCache;
+#ifndef USE_I2C_ADDRESS
+    uint32_t wiringGeneration = sWiringConfigGeneration;
+#else
+    uint32_t wiringGeneration = 0;
+#endif
+    if (!cache.activeMaskValid || cache.activeWiringGeneration != wiringGeneration)
     {
-        domeLayoutTemplateSkipWs(p);
-        if (*p == '}') return -1;
-        const char *keyStart = p;
-        String key;
-        if (!domeLayoutTemplateParseJsonString(p, key, errMsg)) return -1;
-        if (!domeLayoutTemplateExpectChar(p, ':', errMsg)) return -1;
-        if (key == "elements") return keyStart - json.c_str();
-        if (!domeLayoutTemplateSkipJsonValue(p, errMsg)) return -1;
-        domeLayoutTemplateSkipWs(p);
-        if (*p == ',') { p++; continue; }
-        if (*p == '}') return -1;
-        return -1;
+        cache.activeMask = 0;
+        for (int slot = 0; slot < NUM_PANEL_SLOTS; slot++)
+        {
+            if (domeLayoutPanelSlotActive(slot)) cache.activeMask |= (1UL << slot);
+        }
+        cache.activeWiringGeneration = wiringGeneration;
+        cache.activeMaskValid = true;
+    }
+    uint32_t statusGeneration = domeElementStatusGeneration();
+    if (cache.overlayTs == 0 ||
+        cache.overlayStatusGeneration != statusGeneration ||
+        cache.overlayWiringGeneration != wiringGeneration)
+    {
+        cache.overlayStatusGeneration = statusGeneration;
+        cache.overlayWiringGeneration = wiringGeneration;
+        cache.overlayTs = millis() | 1;
     }
 }
 
-static bool domeLayoutTemplateFindArrayEnd(const String &json, int arrayStart,
-                                           int &arrayEnd)
+static String domeLayoutCacheETag()
 {
-    if (arrayStart < 0 || arrayStart >= (int)json.length() ||
-        json[arrayStart] != '[') return false;
-    const char *p = json.c_str() + arrayStart;
-    String errMsg;
-    if (!domeLayoutTemplateSkipJsonArray(p, errMsg)) return false;
-    arrayEnd = p - json.c_str();
-    return true;
+    const DomeLayoutCache &cache = sDomeLayoutCache;
+    char tag[64];
+    snprintf(tag, sizeof(tag), "\"dl%08lx-%04lx-%lu-%lu\"",
+             (unsigned long)cache.staticHash,
+             (unsigned long)(sDomeLayoutBootNonce & 0xFFFF),
+             (unsigned long)cache.overlayStatusGeneration,
+             (unsigned long)cache.overlayWiringGeneration);
+    return String(tag);
 }
 
-static bool domeLayoutTemplateAppendComposedElement(String &out,
-                                                    const String &elementJson,
-                                                    const DomeElementStatusSnapshot *statuses,
-                                                    bool statusOk)
+static void domeLayoutAppendOverlay(String &json, const DomeLayoutSplice &splice,
+                                    const DomeElementStatusSnapshot *statuses,
+                                    bool statusOk)
 {
-    String errMsg;
-    String id;
-    if (!domeLayoutTemplateFindRootString(elementJson, "id", id, errMsg)) return false;
-    bool commandable = false;
-    domeLayoutTemplateFindElementFieldBool(elementJson, "commandable", commandable);
-
-    int closeAt = elementJson.lastIndexOf('}');
-    if (closeAt < 0) return false;
-    out += elementJson.substring(0, closeAt);
-    if (commandable && domeLayoutElementCarriesActive(id))
+    if (splice.hasActive)
     {
-        out += ",\"active\":";
-        out += domeLayoutPanelActive(id.c_str()) ? "true" : "false";
+        json += ",\"active\":";
+        bool active = splice.panelSlot >= 0 &&
+                      (sDomeLayoutCache.activeMask & (1UL << splice.panelSlot)) != 0;
+        json += active ? "true" : "false";
     }
-
     bool disabled = false;
     String reason;
-    domeLayoutReadStatusForId(id, statuses, statusOk, disabled, reason);
-    out += ",\"disabled\":";
-    out += disabled ? "true" : "false";
-    out += ",\"disabled_reason\":";
+    domeLayoutReadStatusAt(splice.statusIndex, statuses, statusOk, disabled, reason);
+    json += ",\"disabled\":";
+    json += disabled ? "true" : "false";
+    json += ",\"disabled_reason\":";
     if (disabled && reason.length() > 0)
     {
-        out += '"';
-        out += jsonEscape(reason);
-        out += '"';
+        json += '"';
+        json += jsonEscape(reason);
+        json += '"';
     }
     else
     {
-        out += "null";
+        json += "null";
     }
-    out += '}';
-    return true;
 }
 
-static bool domeLayoutBuildCustomLayoutJson(const String &templateJson,
-                                            String &out,
-                                            String &errMsg)
+// ---------------------------------------------------------------
+// Chunked JSON responses
+// ---------------------------------------------------------------
+// Large GET bodies are written piece by piece into the TCP send buffer
+// (ChunkedJsonStream.h) rather than built as one String first, so they no
+// longer need a body-sized contiguous heap block. A stream formats pieces
+// into a small scratch String; the dome layout borrows its static text from
+// the layout cache instead of copying it.
+
+enum HttpStreamRoute
 {
-    DomeLayoutTemplateInfo info = {};
-    if (!domeLayoutTemplateValidateJson(templateJson, info, errMsg)) return false;
+    kHttpStreamDomeLayout,
+    kHttpStreamLogs,
+    kHttpStreamDiagI2C,
+    kHttpStreamPanelsConfig,
+    kHttpStreamHolosConfig,
+    kHttpStreamRouteCount,
+};
 
-    int keyAt = domeLayoutTemplateFindElementsKey(templateJson);
-    if (keyAt < 0)
-    {
-        errMsg = "custom template missing elements array";
-        return false;
+static const char *const kHttpStreamRouteNames[kHttpStreamRouteCount] = {
+    "dome_layout", "logs", "diag_i2c", "panels_config", "holos_config",
+};
+
+static ChunkedJsonStats sHttpStreamStats[kHttpStreamRouteCount];
+
+struct HttpJsonStream
+{
+    ChunkedJsonCursor cursor;
+    HttpStreamRoute route;
+    String scratch;
+    uint32_t step;
+    uint32_t next;    // route cursor: log line count, config slot
+    uint32_t last;
+    uint32_t guard;   // layout cache build the borrowed text belongs to
+    bool flag;        // forceScan for diag, "comma needed" for logs
+    WiringConfigSnapshot wiring;
+
+    explicit HttpJsonStream(HttpStreamRoute r)
+        : route(r), step(0), next(0), last(0), guard(0), flag(false) {}
+    // Released by the web server when the response ends or the client goes.
+    ~HttpJsonStream() { chunkedJsonRecord(sHttpStreamStats[route], cursor); }
+};
+
+static ChunkedJsonStep httpJsonStreamScratch(HttpJsonStream &stream, ChunkedJsonPiece &piece,
+                                             ChunkedJsonStep step)
+{
+    piece.data = stream.scratch.c_str();
+    piece.len = stream.scratch.length();
+    piece.owned = true;
+    return step;
+}
+
+static bool httpJsonStreamValid(const HttpJsonStream &stream)
+{
+    return stream.route != kHttpStreamDomeLayout || sDomeLayoutCache.builds == stream.guard;
+}
+
+static AsyncWebServerResponse *beginHttpJsonStream(AsyncWebServerRequest *request,
+                                                   HttpJsonStream *stream,
+                                                   ChunkedJsonNextFn next)
+{
+    chunkedJsonBegin(stream->cursor, next, stream);
+    std::shared_ptr<HttpJsonStream> shared(stream);
+    return request->beginChunkedResponse("application/json",
+        [shared, request](uint8_t *buffer, size_t maxLen, size_t) -> size_t
+        {
+            // A template swap between chunks frees the text a borrowed
+            // piece points into; end the body instead of reading it.
+            if (!httpJsonStreamValid(*shared)) chunkedJsonAbort(shared->cursor);
+            size_t written = chunkedJsonFillChunk(shared->cursor, buffer, maxLen);
+            if (written != kChunkedJsonDrop) return written;
+            // Reset rather than send the terminating chunk, so the client
+            // sees a failed transfer instead of truncated JSON. abort()
+            // queues the disconnect to async_tcp, so the request and this
+            // response outlive the callback.
+            request->client()->abort();
+            return RESPONSE_TRY_AGAIN;
+        });
+}
+
+// Alternates static cache text and per-splice overlay: even steps borrow the
+// text before splice step/2, odd steps format that splice's overlay.
+static ChunkedJsonStep domeLayoutStreamNext(void *ctx, ChunkedJsonPiece &piece)
+{
+    HttpJsonStream &stream = *(HttpJsonStream *)ctx;
+    const DomeLayoutCache &cache = sDomeLayoutCache;
+    uint32_t splice = stream.step / 2;
+    bool overlay = (stream.step & 1) != 0;
+    stream.step++;
+    if (!overlay)
+    {
+        uint32_t from = splice == 0 ? 0 : cache.splices[splice - 1].offset;
+        uint32_t to = splice < cache.spliceCount ? cache.splices[splice].offset
+                                                 : cache.staticJson.length();
+        piece.data = cache.staticJson.c_str() + from;
+        piece.len = to - from;
+        piece.owned = false;
+        return splice < cache.spliceCount ? kChunkedJsonMore : kChunkedJsonLast;
     }
-    int colonAt = templateJson.indexOf(':', keyAt);
-    if (colonAt < 0)
+    const DomeLayoutSplice &entry = cache.splices[splice];
+    stream.scratch = "";
+    if (entry.statusIndex == DOME_LAYOUT_SPLICE_TS)
     {
-        errMsg = "custom template elements array is malformed";
-        return false;
+        stream.scratch += cache.overlayTs;
     }
-    int arrayStart = colonAt + 1;
-    while (arrayStart < (int)templateJson.length() &&
-           isspace((unsigned char)templateJson[arrayStart])) arrayStart++;
-    int arrayEnd = -1;
-    if (!domeLayoutTemplateFindArrayEnd(templateJson, arrayStart, arrayEnd))
+    else
     {
-        errMsg = "custom template elements array is malformed";
-        return false;
+        bool statusOk = false;
+        const DomeElementStatusSnapshot *statuses = domeElementStatusCached(statusOk);
+        domeLayoutAppendOverlay(stream.scratch, entry, statuses, statusOk);
     }
+    return httpJsonStreamScratch(stream, piece, kChunkedJsonMore);
+}
 
-    DomeElementStatusSnapshot statuses[DOME_ELEMENT_STATUS_MAX_ELEMENTS];
-    bool statusOk = domeElementStatusReadAll(statuses, DOME_ELEMENT_STATUS_MAX_ELEMENTS);
-
-    out = "";
-    out.reserve(templateJson.length() + 2048);
-    out += templateJson.substring(0, keyAt);
-    out += "\"layout_source\":\"custom\",\"runtime_state_ts\":";
-    out += millis();
-    out += ",\"elements\":[";
-
-    const char *p = templateJson.c_str() + arrayStart + 1;
-    bool first = true;
-    while (true)
-    {
-        domeLayoutTemplateSkipWs(p);
-        if (*p == ']') break;
-        const char *elementStart = p;
-        if (!domeLayoutTemplateSkipJsonObject(p, errMsg)) return false;
-        String elementJson = templateJson.substring(elementStart - templateJson.c_str(),
-                                                    p - templateJson.c_str());
-        if (!first) out += ',';
-        if (!domeLayoutTemplateAppendComposedElement(out, elementJson,
-                                                     statuses, statusOk))
-        {
-            errMsg = "custom template element composition failed";
-            return false;
-        }
-        first = false;
-        domeLayoutTemplateSkipWs(p);
-        if (*p == ',')
-        {
-            p++;
-            continue;
-        }
-        if (*p == ']') break;
-        errMsg = "expected ',' or ']' in custom elements array";
-        return false;
+static bool domeLayoutETagMatches(const String &ifNoneMatch, const String &etag)
+{
+    int start = 0;
+    while (start < (int)ifNoneMatch.length())
+    {
+        int comma = ifNoneMatch.indexOf(',', start);
+        if (comma < 0) comma = ifNoneMatch.length();
+        String candidate = ifNoneMatch.substring(start, comma);
+        candidate.trim();
+        if (candidate.startsWith("W/")) candidate = candidate.substring(2);
+        if (candidate == "*" || candidate == etag) return true;
+        start = comma + 1;
     }
-
-    out += "]";
-    out += templateJson.substring(arrayEnd);
-    return true;
+    return false;
 }
 
-static String buildBundledDomeLayoutJson()
+// Request-scoped body buffer for POST /api/prefs. capacity is 0 when the
+// body exceeds CONFIG_REGISTRY_MAX_BATCH_BYTES; data has one spare byte for
+// the terminator the in-place parser needs.
+struct PrefsBatchUpload
 {
-    DomeElementStatusSnapshot statuses[DOME_ELEMENT_STATUS_MAX_ELEMENTS];
-    bool statusOk = domeElementStatusReadAll(statuses, DOME_ELEMENT_STATUS_MAX_ELEMENTS);
-
-    String json = "{";
-    json.reserve(2048 + (DomeLayout::kElementCount * 360));
-    json += "\"schema_revision\":";
-    json += DomeLayout::kSchemaRevision;
-    json += ",\"template_id\":\"";
-    json += jsonEscape(String(DomeLayout::kTemplateId));
-    json += "\",\"template_name\":\"";
-    json += jsonEscape(String(DomeLayout::kTemplateName));
-    json += "\",\"template_revision\":";
-    json += DomeLayout::kTemplateRevision;
-    json += ",\"model\":\"";
-    json += jsonEscape(String(DomeLayout::kModel));
-    json += "\",\"source\":\"";
-    json += jsonEscape(String(DomeLayout::kSource));
-    json += "\",\"layout_source\":\"bundled\",\"coordinate_space\":{\"viewBox\":\"";
-    json += jsonEscape(String(DomeLayout::kCoordinateSpaceViewBox));
-    json += "\"},\"runtime_state_ts\":";
-    json += millis();
-    json += ",\"elements\":[";
-
-    for (size_t i = 0; i < DomeLayout::kElementCount; i++)
-    {
-        const DomeLayout::DomeLayoutElement &element = DomeLayout::kElements[i];
-        if (i > 0) json += ',';
-        json += "{\"id\":\"";
-        json += jsonEscape(String(element.id));
-        json += "\",\"label\":\"";
-        json += jsonEscape(String(element.label));
-        json += "\",\"element_type\":\"";
-        json += jsonEscape(String(element.elementType));
-        json += "\",\"panel_kind\":";
-        if (element.panelKind)
-        {
-            json += '"';
-            json += jsonEscape(String(element.panelKind));
-            json += '"';
-        }
-        else
-        {
-            json += "null";
-        }
-        json += ",\"mounted_on\":";
-        if (element.mountedOn)
-        {
-            json += '"';
-            json += jsonEscape(String(element.mountedOn));
-            json += '"';
-        }
-        else
-        {
-            json += "null";
-        }
-        json += ",\"in_layout\":";
-        json += element.inLayout ? "true" : "false";
-        json += ",\"commandable\":";
-        json += element.commandable ? "true" : "false";
-        if (element.commandable && domeLayoutElementCarriesActive(String(element.id)))
-        {
-            json += ",\"active\":";
-            json += domeLayoutPanelActive(element.id) ? "true" : "false";
-        }
-        json += ",\"disabled\":";
-        bool disabled = false;
-        String reason;
-        domeLayoutReadStatusForId(String(element.id), statuses, statusOk, disabled, reason);
-        json += disabled ? "true" : "false";
-        json += ",\"disabled_reason\":";
-        if (disabled && reason.length() > 0)
-        {
-            json += '"';
-            json += jsonEscape(reason);
-            json += '"';
-        }
-        else
-        {
-            json += "null";
-        }
-        domeLayoutAppendStringArray(json, "aliases", element.aliases, element.aliasCount);
-        domeLayoutAppendStringArray(json, "capabilities", element.capabilities,
-                                    element.capabilityCount);
-        json += ",\"render_order\":";
-        json += element.renderOrder;
-        domeLayoutAppendGeometry(json, element);
-        domeLayoutAppendPoint(json, "label_anchor", element.labelAnchor);
-        domeLayoutAppendCallout(json, element.callout);
-        json += '}';
-    }
-
-    json += "]}";
-    return json;
+    size_t len;
+    size_t total;
+    size_t capacity;
+    char data[];
+};
+
+// Body collector for the element-status POST and PATCH routes. Status
+// updates are small; cap at 4 KiB to match the wiring config endpoints while
+// still allowing several annotated elements at once.
+static void receiveDomeElementStatusBody(AsyncWebServerRequest *request, uint8_t *data,
+                                         size_t len, size_t index, size_t total)
+{
+    if (total > 4096) return;
+    if (index == 0)
+    {
+        request->_tempObject = new String();
+        ((String *)request->_tempObject)->reserve(total + 1);
+    }
+    String *body = (String *)request->_tempObject;
+    if (body) body->concat((const char *)data, len);
 }
 
-static String buildDomeLayoutJson()
+static void handleDomeLayoutGet(AsyncWebServerRequest *request)
 {
-    if (domeLayoutTemplateIsCustomSelected())
+    domeLayoutCacheEnsureStatic();
+    domeLayoutCacheEnsureOverlay();
+    String etag = domeLayoutCacheETag();
+    const AsyncWebHeader *ifNoneMatch = request->getHeader("If-None-Match");
+    AsyncWebServerResponse *response;
+    if (ifNoneMatch && domeLayoutETagMatches(ifNoneMatch->value(), etag))
+    {
+        sDomeLayoutCache.notModified++;
+        response = request->beginResponse(304);
+    }
+    else
     {
-        String customJson;
-        String errMsg;
-        if (domeLayoutTemplateReadFile(customJson, errMsg))
-        {
-            String composed;
-            if (domeLayoutBuildCustomLayoutJson(customJson, composed, errMsg))
-            {
-                return composed;
-            }
-            logCapture.printf("[API] custom dome layout rejected at serve time: %s\n",
-                              errMsg.c_str());
-        }
-        else
-        {
-            logCapture.printf("[API] custom dome layout unavailable: %s\n",
-                              errMsg.c_str());
-        }
+        sDomeLayoutCache.served++;
+        HttpJsonStream *stream = new HttpJsonStream(kHttpStreamDomeLayout);
+        stream->guard = sDomeLayoutCache.builds;
+        response = beginHttpJsonStream(request, stream, domeLayoutStreamNext);
     }
-    return buildBundledDomeLayoutJson();
+    response->addHeader("ETag", etag);
+    response->addHeader("Cache-Control", "no-cache");
+    // Base generation for PATCH /api/dome/element-status.
+    response->addHeader("X-Element-Status-Generation", String(domeElementStatusGeneration()));
+    request->send(response);
 }
 
 
@@ -957,15 +1205,62 @@ static void refreshI2CHealthCache(bool force = false)
     lastI2CScanMs = now;
 }
 
-static String buildI2CDiagnosticsJson(bool forceScan = false)
+// /api/diag/i2c is streamed in three parts so no part needs more than a few
+// hundred bytes: scan summary and devices, per-board probe state, operator
+// faults/hints. Part 0 refreshes the probe cache.
+static const int kI2CDiagnosticsParts = 3;
+
+static void appendI2CDiagnosticsPart(int part, bool forceScan, String &json)
 {
-    refreshI2CHealthCache(forceScan);
-    uint32_t now = millis();
-    uint32_t scanAgeMs = (now >= lastI2CScanMs) ? (now - lastI2CScanMs) : 0;
-    uint32_t deepScanAgeMs = (lastI2CDeepScanMs > 0 && now >= lastI2CDeepScanMs) ? (now - lastI2CDeepScanMs) : 0;
+    if (part == 0)
+    {
+        refreshI2CHealthCache(forceScan);
+        uint32_t now = millis();
+        uint32_t scanAgeMs = (now >= lastI2CScanMs) ? (now - lastI2CScanMs) : 0;
+        uint32_t deepScanAgeMs = (lastI2CDeepScanMs > 0 && now >= lastI2CDeepScanMs) ? (now - lastI2CDeepScanMs) : 0;
+        json += "{";
+        json += "\"scan_age_ms\":" + String(scanAgeMs);
+        json += ",\"scan_mode\":\"" + String(cachedLastScanWasDeep ? "deep" : "quick") + "\"";
+        json += ",\"deep_scan_age_ms\":" + String(deepScanAgeMs);
+        json += ",\"scan_duration_us\":" + String(cachedI2CScanDurationUs);
+        json += ",\"device_count\":" + String(cachedI2CDeviceCount);
+        json += ",\"devices\":" + cachedI2CDevicesJson;
+        json += ",\"probe_failures\":" + String(i2cProbeFailures);
+        return;
+    }
+    if (part == 1)
+    {
+        json += ",\"code_histogram\":{";
+        json += "\"0\":" + String(i2cCodeHistogram[0]);
+        json += ",\"1\":" + String(i2cCodeHistogram[1]);
+        json += ",\"2\":" + String(i2cCodeHistogram[2]);
+        json += ",\"3\":" + String(i2cCodeHistogram[3]);
+        json += ",\"4\":" + String(i2cCodeHistogram[4]);
+        json += ",\"other\":" + String(i2cCodeHistogram[5]);
+        json += "}";
+
+        json += ",\"panels\":{";
+        json += "\"addr\":\"0x40\"";
+        json += ",\"ok\":" + String(cachedPanelsOk ? "true" : "false");
+        json += ",\"last_code\":" + String(cachedPanelsCode);
+        json += ",\"last_ok_ms\":" + String(cachedPanelsLastOkMs);
+        json += ",\"last_fail_ms\":" + String(cachedPanelsLastFailMs);
+        json += ",\"consecutive_failures\":" + String(cachedPanelsConsecutiveFailures);
+        json += "}";
+
+        json += ",\"holos\":{";
+        json += "\"addr\":\"0x41\"";
+        json += ",\"ok\":" + String(cachedHolosOk ? "true" : "false");
+        json += ",\"last_code\":" + String(cachedHolosCode);
+        json += ",\"last_ok_ms\":" + String(cachedHolosLastOkMs);
+        json += ",\"last_fail_ms\":" + String(cachedHolosLastFailMs);
+        json += ",\"consecutive_failures\":" + String(cachedHolosConsecutiveFailures);
+        json += "}";
+        return;
+    }
+
     bool has40 = (cachedI2CDevicesJson.indexOf("\"0x40\"") >= 0);
     bool has41 = (cachedI2CDevicesJson.indexOf("\"0x41\"") >= 0);
-
     String faults = "[";
     String hints = "[";
     bool firstFault = true;
@@ -1017,43 +1312,6 @@ static String buildI2CDiagnosticsJson(bool forceScan = false)
     faults += "]";
     hints += "]";
 
-    String json = "{";
-    json.reserve(1024);
-    json += "\"scan_age_ms\":" + String(scanAgeMs);
-    json += ",\"scan_mode\":\"" + String(cachedLastScanWasDeep ? "deep" : "quick") + "\"";
-    json += ",\"deep_scan_age_ms\":" + String(deepScanAgeMs);
-    json += ",\"scan_duration_us\":" + String(cachedI2CScanDurationUs);
-    json += ",\"device_count\":" + String(cachedI2CDeviceCount);
-    json += ",\"devices\":" + cachedI2CDevicesJson;
-    json += ",\"probe_failures\":" + String(i2cProbeFailures);
-
-    json += ",\"code_histogram\":{";
-    json += "\"0\":" + String(i2cCodeHistogram[0]);
-    json += ",\"1\":" + String(i2cCodeHistogram[1]);
-    json += ",\"2\":" + String(i2cCodeHistogram[2]);
-    json += ",\"3\":" + String(i2cCodeHistogram[3]);
-    json += ",\"4\":" + String(i2cCodeHistogram[4]);
-    json += ",\"other\":" + String(i2cCodeHistogram[5]);
-    json += "}";
-
-    json += ",\"panels\":{";
-    json += "\"addr\":\"0x40\"";
-    json += ",\"ok\":" + String(cachedPanelsOk ? "true" : "false");
-    json += ",\"last_code\":" + String(cachedPanelsCode);
-    json += ",\"last_ok_ms\":" + String(cachedPanelsLastOkMs);
-    json += ",\"last_fail_ms\":" + String(cachedPanelsLastFailMs);
-    json += ",\"consecutive_failures\":" + String(cachedPanelsConsecutiveFailures);
-    json += "}";
-
-    json += ",\"holos\":{";
-    json += "\"addr\":\"0x41\"";
-    json += ",\"ok\":" + String(cachedHolosOk ? "true" : "false");
-    json += ",\"last_code\":" + String(cachedHolosCode);
-    json += ",\"last_ok_ms\":" + String(cachedHolosLastOkMs);
-    json += ",\"last_fail_ms\":" + String(cachedHolosLastFailMs);
-    json += ",\"consecutive_failures\":" + String(cachedHolosConsecutiveFailures);
-    json += "}";
-
     json += ",\"operator\":{";
     json += "\"faults\":" + faults;
     json += ",\"hints\":" + hints;
@@ -1067,15 +1325,280 @@ static String buildI2CDiagnosticsJson(bool forceScan = false)
     json += "}";
     json += "}";
     json += "}";
-    return json;
 }
 
+static ChunkedJsonStep diagI2CStreamNext(void *ctx, ChunkedJsonPiece &piece)
+{
+    HttpJsonStream &stream = *(HttpJsonStream *)ctx;
+    stream.scratch = "";
+    appendI2CDiagnosticsPart((int)stream.step, stream.flag, stream.scratch);
+    stream.step++;
+    return httpJsonStreamScratch(stream, piece,
+        stream.step < (uint32_t)kI2CDiagnosticsParts ? kChunkedJsonMore : kChunkedJsonLast);
+}
+
+// One piece per log line. Lines are addressed by running count, fixed when
+// the body starts, so lines logged while it is sent do not shift the window;
+// lines overwritten in the ring meanwhile are skipped.
+static ChunkedJsonStep logsStreamNext(void *ctx, ChunkedJsonPiece &piece)
+{
+    HttpJsonStream &stream = *(HttpJsonStream *)ctx;
+    stream.scratch = "";
+    if (stream.step == 0)
+    {
+        stream.step = 1;
+        stream.last = logCapture.totalCount();
+        stream.next = stream.last - (uint32_t)logCapture.lineCount() + 1;
+        stream.scratch += "{\"lines\":[";
+        return httpJsonStreamScratch(stream, piece, kChunkedJsonMore);
+    }
+    while (stream.next <= stream.last)
+    {
+        const char *line = logCapture.getLineByCount(stream.next++);
+        if (line[0] == '\0') continue;
+        if (stream.flag) stream.scratch += ',';
+        stream.flag = true;
+        stream.scratch += '"';
+        stream.scratch += jsonEscape(String(line));
+        stream.scratch += '"';
+        return httpJsonStreamScratch(stream, piece, kChunkedJsonMore);
+    }
+    stream.scratch += "]}";
+    return httpJsonStreamScratch(stream, piece, kChunkedJsonLast);
+}
+
+static ChunkedJsonStep wiringConfigStreamNext(void *ctx, ChunkedJsonPiece &piece)
+{
+    HttpJsonStream &stream = *(HttpJsonStream *)ctx;
+    WiringBoardId board = stream.route == kHttpStreamPanelsConfig ? kWiringBoardPanels
+                                                                  : kWiringBoardHolos;
+    stream.scratch = "";
+    if (stream.step == 0)
+    {
+        stream.step = 1;
+        wiringCommissioningReadConfig(board, stream.wiring);
+        wiringCommissioningAppendConfigHead(board, stream.scratch);
+        return httpJsonStreamScratch(stream, piece, kChunkedJsonMore);
+    }
+    if (stream.next < (uint32_t)wiringBoardSpec(board).slotCount)
+    {
+        wiringCommissioningAppendConfigSlot(board, stream.wiring, (int)stream.next, stream.scratch);
+        stream.next++;
+        return httpJsonStreamScratch(stream, piece, kChunkedJsonMore);
+    }
+    stream.scratch += "]}";
+    return httpJsonStreamScratch(stream, piece, kChunkedJsonLast);
+}
+
+static void sendWiringConfigStream(AsyncWebServerRequest *request, HttpStreamRoute route)
+{
+    request->send(beginHttpJsonStream(request, new HttpJsonStream(route), wiringConfigStreamNext));
+}
+
+// ---------------------------------------------------------------
+// Static files
+// ---------------------------------------------------------------
+// `make buildfs` stages data/ through tools/build_web_assets.py: assets a
+// page references get content-hashed names (style.1a2b3c4d.css) and text
+// files are stored only as .gz. A hashed name never changes content, so it
+// is sent immutable for a year; pages keep their names and revalidate
+// against the build id in /webfs.id. An image packed straight from data/
+// has neither and is served uncompressed, as before.
+
+struct StaticAssetState
+{
+    bool loaded;
+    String buildETag;   // "w<build id>"; empty without /webfs.id
+    uint32_t served;
+    uint32_t gzipServed;
+    uint32_t notModified;
+};
+
+static StaticAssetState sStaticAssets;
+
+static const char *staticAssetContentType(const String &path)
+{
+    if (path.endsWith(".html")) return "text/html";
+    if (path.endsWith(".css")) return "text/css";
+    if (path.endsWith(".js")) return "application/javascript";
+    if (path.endsWith(".json")) return "application/json";
+    if (path.endsWith(".png")) return "image/png";
+    if (path.endsWith(".ico")) return "image/x-icon";
+    if (path.endsWith(".svg")) return "image/svg+xml";
+    return "text/plain";
+}
+
+// Hash part of name.<8 hex>.ext, or empty for an unhashed name.
+static String staticAssetHash(const String &path)
+{
+    int ext = path.lastIndexOf('.');
+    int dot = ext > 0 ? path.lastIndexOf('.', ext - 1) : -1;
+    if (dot < 0 || ext - dot != 9) return String();
+    for (int i = dot + 1; i < ext; i++)
+    {
+        char c = path[i];
+        if (!((c >= '0' && c <= '9') || (c >= 'a' && c <= 'f'))) return String();
+    }
+    return path.substring(dot + 1, ext);
+}
+
+static void handleStaticAsset(AsyncWebServerRequest *request)
+{
+    String path = request->url();
+    if (path.endsWith("/")) path += "index.html";
+    if (request->method() != HTTP_GET || path.indexOf("..") >= 0)
+    {
+        request->send(404);
+        return;
+    }
+    if (!sStaticAssets.loaded)
+    {
+        sStaticAssets.loaded = true;
+        File id = SPIFFS.open("/webfs.id", "r");
+        if (id)
+        {
+            String build = id.readStringUntil('\n');
+            build.trim();
+            if (build.length() > 0) sStaticAssets.buildETag = "\"w" + build + "\"";
+            id.close();
+        }
+    }
+
+    String gzPath = path + ".gz";
+    const AsyncWebHeader *acceptEncoding = request->getHeader("Accept-Encoding");
+    bool acceptsGzip = acceptEncoding && acceptEncoding->value().indexOf("gzip") >= 0;
+    bool gzip = SPIFFS.exists(gzPath) && (acceptsGzip || !SPIFFS.exists(path));
+    if (!gzip && !SPIFFS.exists(path))
+    {
+        request->send(404);
+        return;
+    }
+
+    String hash = staticAssetHash(path);
+    String etag = hash.length() > 0 ? "\"" + hash + "\"" : sStaticAssets.buildETag;
+    const char *cacheControl = hash.length() > 0 ? "public, max-age=31536000, immutable" : "no-cache";
+    const AsyncWebHeader *ifNoneMatch = request->getHeader("If-None-Match");
+    if (etag.length() > 0 && ifNoneMatch && domeLayoutETagMatches(ifNoneMatch->value(), etag))
+    {
+        sStaticAssets.notModified++;
+        AsyncWebServerResponse *response = request->beginResponse(304);
+        response->addHeader("ETag", etag);
+        response->addHeader("Cache-Control", cacheControl);
+        request->send(response);
+        return;
+    }
+
+    // Passing the .gz path itself keeps the file response from second-guessing
+    // the encoding; the content type comes from the served name.
+    AsyncWebServerResponse *response =
+        request->beginResponse(SPIFFS, gzip ? gzPath : path, staticAssetContentType(path));
+    if (gzip) response->addHeader("Content-Encoding", "gzip");
+    if (etag.length() > 0) response->addHeader("ETag", etag);
+    response->addHeader("Cache-Control", cacheControl);
+    sStaticAssets.served++;
+    if (gzip) sStaticAssets.gzipServed++;
+    request->send(response);
+}
+
+#ifdef USE_LEGACY_WEB_PAGES
+// ---------------------------------------------------------------
+// Legacy setup pages
+// ---------------------------------------------------------------
+// WebPages.h renders a page from its flash tables one control at a time, so
+// the only RAM a request holds is the stream's scratch piece.
+
+static ChunkedJsonStats sLegacyWebStats;
+
+struct LegacyWebResponse
+{
+    ChunkedJsonCursor cursor;
+    LegacyWebStream page;
+
+    ~LegacyWebResponse() { chunkedJsonRecord(sLegacyWebStats, cursor); }
+};
+
+static void handleLegacyWebPage(AsyncWebServerRequest *request)
+{
+    const LegacyWebPage *page = legacyWebFindPage(request->url().c_str());
+    if (page == nullptr)
+    {
+        request->send(404, "text/plain", "Not found");
+        return;
+    }
+    std::shared_ptr<LegacyWebResponse> shared(new LegacyWebResponse());
+    legacyWebBegin(shared->page, page);
+    chunkedJsonBegin(shared->cursor, legacyWebPageNext, &shared->page);
+    AsyncWebServerResponse *response = request->beginChunkedResponse("text/html",
+        [shared](uint8_t *buffer, size_t maxLen, size_t) -> size_t
+        {
+            return chunkedJsonFill(shared->cursor, buffer, maxLen);
+        });
+    response->addHeader("Cache-Control", "no-cache");
+    request->send(response);
+}
+#endif
+
 static void scheduleReboot(uint32_t delayMs)
 {
     rebootScheduled = true;
     rebootAtMs = millis() + delayMs;
 }
 
+// ---------------------------------------------------------------
+// Build boot timeline JSON string (BootSchedule.h)
+// ---------------------------------------------------------------
+// Times are milliseconds since the app started unless the key ends in _us;
+// 0 means "not yet".
+static String buildBootDiagJson()
+{
+    const BootTimeline &t = sBootTimeline;
+    const BootScheduler &s = sBootSched;
+    String json = "{";
+    json.reserve(1024);
+    json += "\"setup_start_ms\":" + String(t.setupStartUs / 1000);
+    json += ",\"setup_done_ms\":" + String(t.setupDoneUs / 1000);
+    json += ",\"first_frame_ms\":" + String(t.firstFrameUs / 1000);
+    json += ",\"time_to_first_frame_ms\":" +
+        String(t.firstFrameUs != 0 ? (t.firstFrameUs - t.setupStartUs) / 1000 : 0);
+    json += ",\"phases\":[";
+    for (int i = 0; i < t.count; i++)
+    {
+        if (i > 0) json += ",";
+        json += "{\"name\":\"" + String(t.phases[i].name) + "\"";
+        json += ",\"start_us\":" + String(t.phases[i].startUs - t.setupStartUs);
+        json += ",\"duration_us\":" + String(t.phases[i].durUs) + "}";
+    }
+    json += "],\"phases_dropped\":" + String(t.dropped);
+    json += ",\"deferred\":{\"released_ms\":" + String(s.releasedMs);
+    json += ",\"done_ms\":" + String(s.doneMs);
+    json += ",\"pending\":" + String(s.pending);
+    json += ",\"max_step_us\":" + String(s.maxStepUs);
+    json += ",\"tasks\":[";
+    for (int i = 0; i < s.count; i++)
+    {
+        const BootTask &task = s.tasks[i];
+        if (i > 0) json += ",";
+        json += "{\"name\":\"" + String(task.name) + "\"";
+        json += ",\"state\":\"" + String(bootTaskStateName(task.state)) + "\"";
+        json += ",\"after\":[";
+        bool first = true;
+        for (int d = 0; d < i; d++)
+        {
+            if ((task.deps & bootSchedBit(d)) == 0) continue;
+            if (!first) json += ",";
+            first = false;
+            json += "\"" + String(s.tasks[d].name) + "\"";
+        }
+        json += "],\"calls\":" + String(task.calls);
+        json += ",\"failed_attempts\":" + String(task.attempts);
+        json += ",\"first_run_ms\":" + String(task.firstRunMs);
+        json += ",\"end_ms\":" + String(task.endMs);
+        json += ",\"run_us\":" + String(task.runUs) + "}";
+    }
+    json += "]}}";
+    return json;
+}
+
 // ---------------------------------------------------------------
 // Build health JSON string
 // ---------------------------------------------------------------
@@ -1099,7 +1622,7 @@ static String buildHealthJson()
     // sMarcSound is the global MarcSound instance in .ino
     // We can't easily check module state from here without another extern,
     // so we report it based on preference config
-    int soundPref = preferences.getInt("msound", MARC_SOUND_PLAYER);
+    int soundPref = configGetInt(kCfgSoundModule);
     bool soundEnabled = (soundLocalEnabled && soundPref != 0);
     json += ",\"sound_module\":" + String(soundEnabled ? "true" : "false");
     json += ",\"sound_local_enabled\":" + String(soundLocalEnabled ? "true" : "false");
@@ -1137,6 +1660,55 @@ static String buildHealthJson()
     json += ",\"last_applied_ms\":" + String(sVisualPresetLastAppliedMs);
     json += ",\"age_ms\":" + String(sVisualPresetLastAppliedMs > 0 ? (uint32_t)(nowMs - sVisualPresetLastAppliedMs) : 0);
     json += "}";
+    json += ",\"element_status\":{";
+    json += "\"source\":\"" + String(sDomeElementStatusPersist.source ? sDomeElementStatusPersist.source : "none") + "\"";
+    json += ",\"ok\":" + String(sDomeElementStatusTableOk ? "true" : "false");
+    json += ",\"generation\":" + String(domeElementStatusGeneration());
+    json += ",\"dirty\":" + String(sDomeElementStatusPersist.dirty ? "true" : "false");
+    json += ",\"saves\":" + String(sDomeElementStatusPersist.saves);
+    json += ",\"flushes\":" + String(sDomeElementStatusPersist.flushes);
+    json += ",\"flush_failures\":" + String(sDomeElementStatusPersist.flushFailures);
+    json += ",\"last_flush_us\":" + String(sDomeElementStatusPersist.lastFlushUs);
+    json += ",\"blob_bytes\":" + String(sDomeElementStatusPersist.blobBytes);
+    json += "}";
+    json += ",\"dome_layout_cache\":{";
+    json += "\"source\":\"" + String(!sDomeLayoutCache.valid ? "none" : (sDomeLayoutCache.custom ? "custom" : "bundled")) + "\"";
+    json += ",\"builds\":" + String(sDomeLayoutCache.builds);
+    json += ",\"last_build_us\":" + String(sDomeLayoutCache.lastBuildUs);
+    json += ",\"static_bytes\":" + String(sDomeLayoutCache.staticJson.length());
+    json += ",\"compiled\":" + String(sDomeLayoutCache.compiled ? "true" : "false");
+    json += ",\"compiled_bytes\":" + String(sDomeLayoutCache.compiledBytes);
+    json += ",\"served\":" + String(sDomeLayoutCache.served);
+    json += ",\"not_modified\":" + String(sDomeLayoutCache.notModified);
+    json += "}";
+    json += ",\"http_streams\":{";
+    for (int i = 0; i < kHttpStreamRouteCount; i++)
+    {
+        const ChunkedJsonStats &stream = sHttpStreamStats[i];
+        if (i > 0) json += ",";
+        json += "\"" + String(kHttpStreamRouteNames[i]) + "\":{";
+        json += "\"responses\":" + String(stream.responses);
+        json += ",\"aborted\":" + String(stream.aborted);
+        json += ",\"last_bytes\":" + String(stream.lastBodyBytes);
+        json += ",\"peak_body_bytes\":" + String(stream.peakBodyBytes);
+        json += ",\"peak_piece_bytes\":" + String(stream.peakPieceBytes);
+        json += "}";
+    }
+    json += "}";
+    json += ",\"static_assets\":{";
+    json += "\"staged\":" + String(sStaticAssets.buildETag.length() > 0 ? "true" : "false");
+    json += ",\"served\":" + String(sStaticAssets.served);
+    json += ",\"gzip\":" + String(sStaticAssets.gzipServed);
+    json += ",\"not_modified\":" + String(sStaticAssets.notModified);
+    json += "}";
+#ifdef USE_LEGACY_WEB_PAGES
+    json += ",\"legacy_pages\":{";
+    json += "\"responses\":" + String(sLegacyWebStats.responses);
+    json += ",\"aborted\":" + String(sLegacyWebStats.aborted);
+    json += ",\"peak_body_bytes\":" + String(sLegacyWebStats.peakBodyBytes);
+    json += ",\"peak_piece_bytes\":" + String(sLegacyWebStats.peakPieceBytes);
+    json += "}";
+#endif
 
     json += ",\"visual_authoring\":{";
     json += "\"logic\":{";
@@ -1160,6 +1732,14 @@ static String buildHealthJson()
     json += ",\"reject_count\":" + String(sVisualAuthoringText.rejectCount);
     json += ",\"last_applied_ms\":" + String(sVisualAuthoringText.lastAppliedMs);
     json += ",\"age_ms\":" + String(sVisualAuthoringText.lastAppliedMs > 0 ? (uint32_t)(nowMs - sVisualAuthoringText.lastAppliedMs) : 0);
+    json += ",\"strip\":{";
+    json += "\"builds\":" + String(sLogicTextStripStats.builds);
+    json += ",\"build_failures\":" + String(sLogicTextStripStats.buildFailures);
+    json += ",\"truncated\":" + String(sLogicTextStripStats.truncated);
+    json += ",\"blits\":" + String(sLogicTextStripStats.blits);
+    json += ",\"last_build_us\":" + String(sLogicTextStripStats.lastBuildUs);
+    json += ",\"last_columns\":" + String(sLogicTextStripStats.lastColumns);
+    json += "}";
     json += "},\"holo\":{";
     json += "\"last_cmd\":\"" + jsonEscape(String(sVisualAuthoringHolo.lastCmd)) + "\"";
     json += ",\"target\":\"" + jsonEscape(String(sVisualAuthoringHolo.target)) + "\"";
@@ -1170,18 +1750,43 @@ static String buildHealthJson()
     json += ",\"reject_count\":" + String(sVisualAuthoringHolo.rejectCount);
     json += ",\"last_applied_ms\":" + String(sVisualAuthoringHolo.lastAppliedMs);
     json += ",\"age_ms\":" + String(sVisualAuthoringHolo.lastAppliedMs > 0 ? (uint32_t)(nowMs - sVisualAuthoringHolo.lastAppliedMs) : 0);
-    json += "}}";
+    json += "},\"sprite\":{";
+    json += "\"last_cmd\":\"" + jsonEscape(String(sVisualAuthoringSprite.lastCmd)) + "\"";
+    json += ",\"target\":\"" + jsonEscape(String(sVisualAuthoringSprite.target)) + "\"";
+    json += ",\"name\":\"" + jsonEscape(String(sVisualAuthoringSprite.name)) + "\"";
+    json += ",\"duration\":" + String(sVisualAuthoringSprite.duration);
+    json += ",\"apply_count\":" + String(sVisualAuthoringSprite.applyCount);
+    json += ",\"reject_count\":" + String(sVisualAuthoringSprite.rejectCount);
+    json += ",\"last_applied_ms\":" + String(sVisualAuthoringSprite.lastAppliedMs);
+    json += ",\"age_ms\":" + String(sVisualAuthoringSprite.lastAppliedMs > 0 ? (uint32_t)(nowMs - sVisualAuthoringSprite.lastAppliedMs) : 0);
+    json += ",\"cache\":{";
+    json += "\"hits\":" + String(sLogicSpriteCacheHits);
+    json += ",\"misses\":" + String(sLogicSpriteCacheMisses);
+    json += ",\"frames_decoded\":" + String(sLogicSpriteFramesDecoded);
+    json += ",\"decode_errors\":" + String(sLogicSpriteDecodeErrors);
+    json += "}}}";
 
     json += ",\"i2c_devices\":" + cachedI2CDevicesJson;
     json += ",\"min_free_heap\":" + String(sMinFreeHeap);
+    json += ",\"boot_free_heap\":" + String(sBootFreeHeap);
     json += ",\"i2c_probe_failures\":" + String(i2cProbeFailures);
     json += ",\"cmd_queue\":{";
     json += "\"depth\":" + String(sMarcduinoQueueCount);
     json += ",\"capacity\":" + String(SizeOfArray(sMarcduinoQueue));
     json += ",\"queue_full_count\":" + String(sMarcduinoQueueFullCount);
     json += "}";
+    json += ",\"led_frames\":" + ledFrameGateBuildJson();
+    json += ",\"led_render\":" + ledRenderTaskBuildJson();
+    json += ",\"config\":{\"keys\":" + String((int)kConfigKeyCount);
+    json += ",\"loaded\":" + String(sConfigStats.loaded);
+    json += ",\"rejected\":" + String(sConfigStats.rejected);
+    json += ",\"writes\":" + String(sConfigStats.writes);
+    json += ",\"write_errors\":" + String(sConfigStats.writeErrors);
+    json += ",\"notifications\":" + String(sConfigStats.notifications);
+    json += ",\"batches\":" + String(sConfigStats.batches);
+    json += ",\"rollbacks\":" + String(sConfigStats.rollbacks) + "}";
     // Body link status
-    bool bodyLinkPrefEnabled = preferences.getBool("mbodylink", BODY_LINK_ENABLED);
+    bool bodyLinkPrefEnabled = configGetBool(kCfgBodyLinkEnabled);
     json += ",\"body_link\":{";
     json += "\"enabled\":" + String(bodyLinkPrefEnabled ? "true" : "false");
     json += ",\"connected\":" + String(bodyLinkConnected() ? "true" : "false");
@@ -1193,30 +1798,34 @@ static String buildHealthJson()
     json += ",\"uart_hb_age_ms\":" + String(bodyLinkUartHeartbeatAgeMs());
     json += ",\"wifi_hb_age_ms\":" + String(bodyLinkWifiHeartbeatAgeMs());
     json += ",\"peer_source\":\"" + String(bodyLinkGetPeerSource()) + "\"";
+    json += ",\"framing\":" + bodyLinkFramingBuildJson();
+    json += ",\"uart\":" + bodyLinkUartBuildJson();
+    json += ",\"failover\":" + bodyLinkFailoverBuildJson();
+    json += ",\"resolver\":" + bodyLinkResolverBuildJson();
     json += "}";
 
     // Gadget status
     json += ",\"gadgets\":{";
 #if AP_ENABLE_BADMOTIVATOR
-    bool badmotEnabled = preferences.getBool(PREFERENCE_BADMOTIVATOR_ENABLED, AP_ENABLE_BADMOTIVATOR);
+    bool badmotEnabled = configGetBool(kCfgBadMotivatorEnabled);
     json += "\"badmotivator\":{\"enabled\":" + String(badmotEnabled ? "true" : "false") + ",\"present\":true}";
 #else
     json += "\"badmotivator\":{\"enabled\":false,\"present\":false}";
 #endif
 #if AP_ENABLE_FIRESTRIP
-    bool firestripEnabled = preferences.getBool(PREFERENCE_FIRESTRIP_ENABLED, AP_ENABLE_FIRESTRIP);
+    bool firestripEnabled = configGetBool(kCfgFireStripEnabled);
     json += ",\"firestrip\":{\"enabled\":" + String(firestripEnabled ? "true" : "false") + ",\"present\":true}";
 #else
     json += ",\"firestrip\":{\"enabled\":false,\"present\":false}";
 #endif
 #if AP_ENABLE_CBI
-    bool cbiEnabled = preferences.getBool(PREFERENCE_CBI_ENABLED, AP_ENABLE_CBI);
+    bool cbiEnabled = configGetBool(kCfgCbiEnabled);
     json += ",\"cbi\":{\"enabled\":" + String(cbiEnabled ? "true" : "false") + ",\"present\":true}";
 #else
     json += ",\"cbi\":{\"enabled\":false,\"present\":false}";
 #endif
 #if AP_ENABLE_DATAPANEL
-    bool datapanelEnabled = preferences.getBool(PREFERENCE_DATAPANEL_ENABLED, AP_ENABLE_DATAPANEL);
+    bool datapanelEnabled = configGetBool(kCfgDataPanelEnabled);
     json += ",\"datapanel\":{\"enabled\":" + String(datapanelEnabled ? "true" : "false") + ",\"present\":true}";
 #else
     json += ",\"datapanel\":{\"enabled\":false,\"present\":false}";
@@ -1233,12 +1842,17 @@ static String buildHealthJson()
 // ---------------------------------------------------------------
 static void initAsyncWeb()
 {
+    sOtaSessionLock = xSemaphoreCreateMutex();
+
     // Attach WebSocket
     ws.onEvent(onWsEvent);
     asyncServer.addHandler(&ws);
 
-    // ---- Static files from SPIFFS ----
-    asyncServer.serveStatic("/", SPIFFS, "/").setDefaultFile("index.html");
+    // ---- Static files from SPIFFS (anything no route claims) ----
+    asyncServer.onNotFound(handleStaticAsset);
+#ifdef USE_LEGACY_WEB_PAGES
+    asyncServer.on(LEGACY_WEB_ROOT, HTTP_GET, handleLegacyWebPage);
+#endif
 
     // ---- REST API: Send Marcduino command ----
     asyncServer.on("/api/cmd", HTTP_POST, [](AsyncWebServerRequest *request)
@@ -1267,29 +1881,26 @@ static void initAsyncWeb()
 
     asyncServer.on("/api/diag/i2c", HTTP_GET, [](AsyncWebServerRequest *request)
     {
-        bool forceScan = request->hasParam("force") && request->getParam("force")->value() == "1";
-        request->send(200, "application/json", buildI2CDiagnosticsJson(forceScan));
+        HttpJsonStream *stream = new HttpJsonStream(kHttpStreamDiagI2C);
+        stream->flag = request->hasParam("force") && request->getParam("force")->value() == "1";
+        request->send(beginHttpJsonStream(request, stream, diagI2CStreamNext));
+    });
+
+    asyncServer.on("/api/diag/boot", HTTP_GET, [](AsyncWebServerRequest *request)
+    {
+        request->send(200, "application/json", buildBootDiagJson());
     });
 
     // ---- REST API: Get log lines ----
     asyncServer.on("/api/logs", HTTP_GET, [](AsyncWebServerRequest *request)
     {
-        String json = "{\"lines\":[";
-        int count = logCapture.lineCount();
-        for (int i = 0; i < count; i++)
-        {
-            if (i > 0) json += ",";
-            // Escape special chars in log line
-            String line = logCapture.getLine(i);
-            json += "\"" + jsonEscape(line) + "\"";
-        }
-        json += "]}";
-        request->send(200, "application/json", json);
+        request->send(beginHttpJsonStream(request, new HttpJsonStream(kHttpStreamLogs),
+                                          logsStreamNext));
     });
 
     // ---- REST API: Read preferences ----
-    // Boolean preference keys — stored with putBool, read with getBool
-    // These must be handled separately from string preferences
+    // Served from the config registry's RAM copy; types and defaults come
+    // from the schema in ConfigRegistry.h.
     asyncServer.on("/api/pref", HTTP_GET, [](AsyncWebServerRequest *request)
     {
         if (!request->hasParam("keys"))
@@ -1309,32 +1920,32 @@ static void initAsyncWeb()
             key.trim();
             if (key.length() > 0)
             {
-                if (!isAllowedPrefKey(key))
+                ConfigKeyId id = configFindKey(key.c_str());
+                if (id == kConfigKeyCount || configKeyDef(id).type == kConfigBlob)
                 {
                     request->send(400, "application/json", "{\"error\":\"invalid key\"}");
                     return;
                 }
-                if (!first) json += ",";
-                first = false;
-                // Boolean keys: firmware uses getBool/putBool for these
-                if (key == "wifi" || key == "ap" || key == "remote" || key == "msoundlocal" ||
-                    key == "mserialpass" || key == "mserial" || key == "mwifi" || key == "mwifipass" ||
-                    key == PREFERENCE_BADMOTIVATOR_ENABLED || key == PREFERENCE_FIRESTRIP_ENABLED ||
-                    key == PREFERENCE_CBI_ENABLED || key == PREFERENCE_DATAPANEL_ENABLED ||
-                    key == "mbodylink" || key == "mbodywifi")
-                {
-                    bool val = preferences.getBool(key.c_str(), defaultBoolForPrefKey(key));
-                    json += "\"" + jsonEscape(key) + "\":" + (val ? "true" : "false");
-                }
-                else if (isIntegerPrefKey(key))
+                // Sensitive keys are write-only; leave them out as /api/prefs does.
+                if (configKeyDef(id).flags & kConfigSensitive)
                 {
-                    int val = preferences.getInt(key.c_str(), defaultIntForPrefKey(key));
-                    json += "\"" + jsonEscape(key) + "\":" + String(val);
+                    start = comma + 1;
+                    continue;
                 }
-                else
+                if (!first) json += ",";
+                first = false;
+                json += "\"" + jsonEscape(key) + "\":";
+                switch (configKeyDef(id).type)
                 {
-                    String val = preferences.getString(key.c_str(), "");
-                    json += "\"" + jsonEscape(key) + "\":\"" + jsonEscape(val) + "\"";
+                    case kConfigBool:
+                        json += configGetBool(id) ? "true" : "false";
+                        break;
+                    case kConfigInt:
+                        json += String(configGetInt(id));
+                        break;
+                    default:
+                        json += "\"" + jsonEscape(configGetString(id)) + "\"";
+                        break;
                 }
             }
             start = comma + 1;
@@ -1344,6 +1955,8 @@ static void initAsyncWeb()
     });
 
     // ---- REST API: Set preference ----
+    // Validated against the schema (booleans 1/0/true/false, integer bounds,
+    // text length), written through to NVS and applied to the RAM copy.
     asyncServer.on("/api/pref", HTTP_POST, [](AsyncWebServerRequest *request)
     {
         if (request->hasParam("key", true) && request->hasParam("val", true))
@@ -1358,85 +1971,201 @@ static void initAsyncWeb()
                 return;
             }
 
+            const char *errMsg = "";
+            bool rebootRequired = false;
             // Special key: factory reset
             if (key == "_clear")
             {
                 logCapture.println("[API] Factory reset — clearing all preferences");
-                preferences.clear();
+                if (!configRegistryReset(errMsg))
+                {
+                    request->send(500, "application/json", "{\"error\":\"" + String(errMsg) + "\"}");
+                    return;
+                }
+            }
+            else
+            {
+                ConfigKeyId id = configFindKey(key.c_str());
+                if (id == kConfigKeyCount || configKeyDef(id).type == kConfigBlob)
+                {
+                    request->send(400, "application/json", "{\"error\":\"key not allowed\"}");
+                    return;
+                }
+                if (!configSetFromText(id, val.c_str(), errMsg))
+                {
+                    request->send(400, "application/json", "{\"error\":\"" + String(errMsg) + "\"}");
+                    return;
+                }
+                const ConfigKeyDef &def = configKeyDef(id);
+                rebootRequired = (def.flags & kConfigReboot) != 0;
+                if (def.flags & kConfigSensitive)
+                    logCapture.printf("[API] pref: %s = <redacted>\n", key.c_str());
+                else
+                    logCapture.printf("[API] pref: %s = %s\n", key.c_str(), val.c_str());
+            }
+
+            bool needsReboot = request->hasParam("reboot", true) &&
+                               request->getParam("reboot", true)->value() == "1";
+            request->send(200, "application/json", rebootRequired ?
+                "{\"ok\":true,\"reboot_required\":true}" : "{\"ok\":true}");
+            if (needsReboot)
+            {
+                scheduleReboot(500);
+            }
+        }
+        else
+        {
+            request->send(400, "application/json", "{\"error\":\"missing key/val params\"}");
+        }
+    });
+
+    // ---- REST API: Bulk preferences ----
+    // GET returns every non-sensitive key in one object. POST takes a JSON
+    // object of key/value pairs, validates all of them before anything is
+    // written and applies the batch through configApplyBatch().
+    asyncServer.on("/api/prefs", HTTP_GET, [](AsyncWebServerRequest *request)
+    {
+        String json;
+        json.reserve(768);
+        json = "{";
+        bool first = true;
+        for (int i = 0; i < kConfigKeyCount; i++)
+        {
+            ConfigKeyId id = ConfigKeyId(i);
+            const ConfigKeyDef &def = configKeyDef(id);
+            if (def.type == kConfigBlob || (def.flags & kConfigSensitive))
+                continue;
+            if (!first) json += ",";
+            first = false;
+            json += "\"" + String(def.key) + "\":";
+            if (def.type == kConfigBool)
+                json += configGetBool(id) ? "true" : "false";
+            else if (def.type == kConfigInt)
+                json += String(configGetInt(id));
+            else
+                json += "\"" + jsonEscape(configGetString(id)) + "\"";
+        }
+        json += "}";
+        request->send(200, "application/json", json);
+    });
+
+    asyncServer.on("/api/prefs", HTTP_POST,
+        [](AsyncWebServerRequest *request)
+        {
+            PrefsBatchUpload *upload = (PrefsBatchUpload *)request->_tempObject;
+            if (!upload || upload->total == 0)
+            {
+                if (upload) { free(upload); request->_tempObject = nullptr; }
+                request->send(400, "application/json", "{\"error\":\"empty body\"}");
+                return;
             }
-            else if (!isAllowedPrefKey(key))
+            if (upload->len != upload->total)
             {
-                request->send(400, "application/json", "{\"error\":\"key not allowed\"}");
+                free(upload);
+                request->_tempObject = nullptr;
+                request->send(413, "application/json", "{\"error\":\"body too large\"}");
                 return;
             }
-            else if (val.length() > maxPrefValueLen(key))
+            upload->data[upload->len] = '\0';
+
+            ConfigBatchEntry entries[kConfigKeyCount];
+            uint8_t count = 0;
+            uint8_t invalid = 0;
+            const char *errMsg = "";
+            if (!configParseBatch(upload->data, entries, kConfigKeyCount, count, invalid, errMsg))
             {
-                request->send(400, "application/json", "{\"error\":\"value too long\"}");
+                free(upload);
+                request->_tempObject = nullptr;
+                request->send(400, "application/json", "{\"error\":\"" + String(errMsg) + "\"}");
                 return;
             }
-            // Boolean keys — firmware uses getBool/putBool
-            else if (key == "wifi" || key == "ap" || key == "remote" || key == "msoundlocal" ||
-                     key == "mserialpass" || key == "mserial" || key == "mwifi" || key == "mwifipass" ||
-                     key == "mbodylink" || key == "mbodywifi" ||
-                     key == PREFERENCE_BADMOTIVATOR_ENABLED || key == PREFERENCE_FIRESTRIP_ENABLED ||
-                     key == PREFERENCE_CBI_ENABLED || key == PREFERENCE_DATAPANEL_ENABLED)
+            if (invalid > 0)
             {
-                bool bval = (val == "1" || val == "true");
-                preferences.putBool(key.c_str(), bval);
-                if (key == "msoundlocal")
-                {
-                    soundLocalEnabled = bval;
-                }
-                if (key == PREFERENCE_BADMOTIVATOR_ENABLED || key == PREFERENCE_FIRESTRIP_ENABLED ||
-                    key == PREFERENCE_CBI_ENABLED || key == PREFERENCE_DATAPANEL_ENABLED)
+                String json = "{\"error\":\"invalid preferences\",\"keys\":{";
+                bool first = true;
+                for (uint8_t i = 0; i < count; i++)
                 {
-                    // Just store the preference value, actual enable/disable happens on next reboot
-                    // or could be handled dynamically if needed
-                    logCapture.printf("[API] pref (gadget): %s = %s\n", key.c_str(), bval ? "true" : "false");
+                    if (!entries[i].error) continue;
+                    if (!first) json += ",";
+                    first = false;
+                    json += "\"" + jsonEscape(entries[i].key) + "\":\"" + String(entries[i].error) + "\"";
                 }
-                logCapture.printf("[API] pref (bool): %s = %s\n", key.c_str(), bval ? "true" : "false");
+                json += "}}";
+                free(upload);
+                request->_tempObject = nullptr;
+                request->send(400, "application/json", json);
+                return;
             }
-            else if (isIntegerPrefKey(key))
+            if (!configApplyBatch(entries, count, errMsg))
             {
-                int ival = 0;
-                if (!parseIntegerPrefValue(val, ival))
-                {
-                    request->send(400, "application/json", "{\"error\":\"invalid integer value\"}");
-                    return;
-                }
-                preferences.putInt(key.c_str(), ival);
-                logCapture.printf("[API] pref (int): %s = %d\n", key.c_str(), ival);
+                free(upload);
+                request->_tempObject = nullptr;
+                logCapture.printf("[API] prefs: batch of %u rolled back (%s)\n", count, errMsg);
+                request->send(500, "application/json", "{\"error\":\"" + String(errMsg) + "\"}");
+                return;
             }
-            else
+
+            String changed;
+            String reboot;
+            String logLine;
+            for (uint8_t i = 0; i < count; i++)
             {
-                preferences.putString(key.c_str(), val);
-                if (isSensitivePrefKey(key))
-                    logCapture.printf("[API] pref: %s = <redacted>\n", key.c_str());
-                else
-                    logCapture.printf("[API] pref: %s = %s\n", key.c_str(), val.c_str());
+                const ConfigBatchEntry &entry = entries[i];
+                if (!entry.changed) continue;
+                const ConfigKeyDef &def = configKeyDef(entry.id);
+                String quoted = "\"" + String(def.key) + "\"";
+                if (changed.length()) changed += ",";
+                changed += quoted;
+                if (def.flags & kConfigReboot)
+                {
+                    if (reboot.length()) reboot += ",";
+                    reboot += quoted;
+                }
+                if (logLine.length()) logLine += ", ";
+                logLine += String(def.key) + "=" +
+                           ((def.flags & kConfigSensitive) ? "<redacted>" : entry.text);
             }
+            free(upload);
+            request->_tempObject = nullptr;
+            if (logLine.length())
+                logCapture.printf("[API] prefs: %s\n", logLine.c_str());
 
-            bool needsReboot = request->hasParam("reboot", true) &&
-                               request->getParam("reboot", true)->value() == "1";
-            request->send(200, "application/json", "{\"ok\":true}");
+            bool needsReboot = request->hasParam("reboot") &&
+                               request->getParam("reboot")->value() == "1";
+            request->send(200, "application/json",
+                "{\"ok\":true,\"changed\":[" + changed + "],\"reboot_required\":[" + reboot + "]}");
             if (needsReboot)
             {
                 scheduleReboot(500);
             }
-        }
-        else
+        },
+        NULL,
+        [](AsyncWebServerRequest *request, uint8_t *data, size_t len,
+           size_t index, size_t total)
         {
-            request->send(400, "application/json", "{\"error\":\"missing key/val params\"}");
-        }
-    });
+            if (index == 0)
+            {
+                // Oversized bodies keep a header-only buffer so the handler can
+                // answer 413; malloc'd so the server's cleanup can free() it.
+                size_t capacity = total > CONFIG_REGISTRY_MAX_BATCH_BYTES ? 0 : total;
+                PrefsBatchUpload *upload = (PrefsBatchUpload *)malloc(sizeof(PrefsBatchUpload) + capacity + 1);
+                if (upload) { upload->len = 0; upload->total = total; upload->capacity = capacity; }
+                request->_tempObject = upload;
+            }
+            PrefsBatchUpload *upload = (PrefsBatchUpload *)request->_tempObject;
+            if (upload && index + len <= upload->capacity)
+            {
+                memcpy(upload->data + index, data, len);
+                upload->len = index + len;
+            }
+        });
 
     // ---- REST API: Dynamic wiring config (panels) ----
     // GET returns current channel/active per slot (NVS or MK4 defaults).
     // POST saves and live-applies the routing state via WiringCommissioning.
     asyncServer.on("/api/panels/config", HTTP_GET, [](AsyncWebServerRequest *request)
     {
-        request->send(200, "application/json",
-            wiringCommissioningBuildConfigJson(kWiringBoardPanels));
+        sendWiringConfigStream(request, kHttpStreamPanelsConfig);
     });
 
     asyncServer.on("/api/panels/config", HTTP_POST,
@@ -1471,8 +2200,7 @@ static void initAsyncWeb()
     // ---- REST API: Dynamic wiring config (holos) ----
     asyncServer.on("/api/holos/config", HTTP_GET, [](AsyncWebServerRequest *request)
     {
-        request->send(200, "application/json",
-            wiringCommissioningBuildConfigJson(kWiringBoardHolos));
+        sendWiringConfigStream(request, kHttpStreamHolosConfig);
     });
 
     asyncServer.on("/api/holos/config", HTTP_POST,
@@ -1502,9 +2230,11 @@ static void initAsyncWeb()
     // ---- REST API: Dome layout read model ----
     // External editors consume this composed model instead of stitching
     // together template geometry, wiring state, and maintenance status.
+    // Clients should revalidate with If-None-Match; unchanged layouts get a
+    // bodyless 304.
     asyncServer.on("/api/dome/layout", HTTP_GET, [](AsyncWebServerRequest *request)
     {
-        request->send(200, "application/json", buildDomeLayoutJson());
+        handleDomeLayoutGet(request);
     });
 
     // ---- REST API: Dome layout template management ----
@@ -1527,6 +2257,7 @@ static void initAsyncWeb()
         {
             SPIFFS.remove(DOME_LAYOUT_TEMPLATE_TMP_PATH);
         }
+        domeLayoutTemplateRemoveCompiled();
         bool selectedOk = domeLayoutTemplateSetCustomSelected(false);
         if (!removed || !selectedOk)
         {
@@ -1563,10 +2294,8 @@ static void initAsyncWeb()
             bool selectCustom = source == "custom";
             if (selectCustom)
             {
-                String customJson;
                 DomeLayoutTemplateInfo info = {};
-                if (!domeLayoutTemplateReadFile(customJson, errMsg) ||
-                    !domeLayoutTemplateValidateJson(customJson, info, errMsg))
+                if (!domeLayoutTemplateValidateFile(info, errMsg))
                 {
                     request->send(400, "application/json",
                         String("{\"error\":\"") + jsonEscape(errMsg) + "\"}");
@@ -1629,6 +2358,13 @@ static void initAsyncWeb()
                               "{\"error\":\"template selection save failed\"}");
                 return;
             }
+            // Compile now so the first serve and later checks read records,
+            // not JSON. A failure here only costs a lazy compile later.
+            uint8_t *blob = nullptr;
+            size_t blobLen = 0;
+            DomeLayoutCompiledHeader header;
+            if (domeLayoutTemplateCompileInstalled(blob, blobLen, header, errMsg)) free(blob);
+            else logCapture.printf("[API] dome/layout-template compile failed: %s\n", errMsg.c_str());
             logCapture.printf("[API] dome/layout-template installed: %s rev %d\n",
                               info.templateId.c_str(), info.templateRevision);
             request->send(200, "application/json",
@@ -1650,6 +2386,169 @@ static void initAsyncWeb()
             if (body) body->concat((const char *)data, len);
         });
 
+    // ---- REST API: Logic sprite animations ----
+    // Binary .lsa uploads (see LogicSpriteStore.h), played with DA:<target>:<name>.
+    asyncServer.on("/api/sprites", HTTP_GET, [](AsyncWebServerRequest *request)
+    {
+        request->send(200, "application/json", logicSpriteListJson());
+    });
+
+    asyncServer.on("/api/sprites", HTTP_DELETE, [](AsyncWebServerRequest *request)
+    {
+        String name = request->hasParam("name") ? request->getParam("name")->value() : String();
+        if (!logicSpriteValidName(name.c_str()))
+        {
+            request->send(400, "application/json", "{\"error\":\"invalid sprite name\"}");
+            return;
+        }
+        if (!logicSpriteRemove(name.c_str()))
+        {
+            request->send(404, "application/json", "{\"error\":\"sprite not found\"}");
+            return;
+        }
+        logCapture.printf("[API] sprite removed: %s\n", name.c_str());
+        request->send(200, "application/json", "{\"ok\":true}");
+    });
+
+    asyncServer.on("/api/sprites", HTTP_POST,
+        [](AsyncWebServerRequest *request)
+        {
+            LogicSpriteUpload *upload = (LogicSpriteUpload *)request->_tempObject;
+            String name = request->hasParam("name") ? request->getParam("name")->value() : String();
+            String errMsg;
+            bool ok = false;
+            int status = 400;
+            if (upload && upload->total > upload->capacity) { errMsg = "sprite too large"; status = 413; }
+            else if (!upload || upload->len == 0) errMsg = "empty body";
+            else if (upload->len != upload->total) errMsg = "sprite body incomplete";
+            else ok = logicSpriteWrite(name.c_str(), upload->data, upload->len, errMsg);
+            if (upload) { free(upload); request->_tempObject = nullptr; }
+            if (!ok)
+            {
+                logCapture.printf("[API] sprite rejected: %s\n", errMsg.c_str());
+                request->send(status, "application/json",
+                    String("{\"error\":\"") + jsonEscape(errMsg) + "\"}");
+                return;
+            }
+            logCapture.printf("[API] sprite installed: %s\n", name.c_str());
+            request->send(200, "application/json",
+                String("{\"ok\":true,\"name\":\"") + jsonEscape(name) + "\"}");
+        },
+        NULL,
+        [](AsyncWebServerRequest *request, uint8_t *data, size_t len,
+           size_t index, size_t total)
+        {
+            if (index == 0)
+            {
+                // Oversized bodies keep a header-only buffer so the handler can
+                // answer 413; malloc'd so the server's cleanup can free() it.
+                size_t capacity = total > LOGIC_SPRITE_MAX_BYTES ? 0 : total;
+                LogicSpriteUpload *upload = (LogicSpriteUpload *)malloc(sizeof(LogicSpriteUpload) + capacity);
+                if (upload) { upload->len = 0; upload->total = total; upload->capacity = capacity; }
+                request->_tempObject = upload;
+            }
+            LogicSpriteUpload *upload = (LogicSpriteUpload *)request->_tempObject;
+            if (upload && index + len <= upload->capacity)
+            {
+                memcpy(upload->data + index, data, len);
+                upload->len = index + len;
+            }
+        });
+
+    // ---- REST API: Web assets (per-file SPIFFS updates) ----
+    // tools/web_asset_sync.py compares GET /api/assets with a staged build,
+    // uploads the changed files one at a time, then commits the build id and
+    // the files to drop. User data (dome layout template, sprites) is never
+    // listed or writable here.
+    asyncServer.on("/api/assets", HTTP_GET, [](AsyncWebServerRequest *request)
+    {
+        request->send(200, "application/json", webAssetListJson());
+    });
+
+    asyncServer.on("/api/assets/file", HTTP_POST,
+        [](AsyncWebServerRequest *request)
+        {
+            String path = request->hasParam("path") ? request->getParam("path")->value() : String();
+            if (otaInProgress)
+            {
+                webAssetRelease(request);
+                request->send(409, "application/json", otaJson(false, "firmware or filesystem update in progress"));
+                return;
+            }
+            // An empty file has no body, so the body handler never began it.
+            if (request->contentLength() == 0)
+                webAssetBegin(request, path, 0, request->hasParam("sha256") ? request->getParam("sha256")->value() : String());
+            if (!webAssetOwnedBy(request))
+            {
+                request->send(409, "application/json", otaJson(false, "another asset upload is in progress"));
+                return;
+            }
+            if (!webAssetFinish())
+            {
+                logCapture.printf("[API] asset %s rejected: %s\n", path.c_str(), sWebAssetUpload.error.c_str());
+                request->send(sWebAssetUpload.httpStatus, "application/json",
+                              otaJson(false, jsonEscape(sWebAssetUpload.error)));
+                webAssetRelease(request);
+                return;
+            }
+            logCapture.printf("[API] asset installed: %s (%u bytes)\n", path.c_str(), sWebAssetUpload.size);
+            String json = "{\"ok\":true,\"path\":\"" + jsonEscape(path) + "\"";
+            if (sWebAssetUpload.manifestError.length() == 0)
+            {
+                json += ",\"manifest\":true}";
+            }
+            else
+            {
+                // Installed all the same; only the digest record is missing.
+                logCapture.printf("[API] asset manifest not updated: %s\n", sWebAssetUpload.manifestError.c_str());
+                json += ",\"manifest\":false,\"warning\":\"" + jsonEscape(sWebAssetUpload.manifestError) + "\"}";
+            }
+            webAssetRelease(request);
+            request->send(200, "application/json", json);
+        },
+        NULL,
+        [](AsyncWebServerRequest *request, uint8_t *data, size_t len,
+           size_t index, size_t total)
+        {
+            if (otaInProgress)
+                return;
+            if (index == 0)
+            {
+                String path = request->hasParam("path") ? request->getParam("path")->value() : String();
+                String sha256 = request->hasParam("sha256") ? request->getParam("sha256")->value() : String();
+                webAssetBegin(request, path, total, sha256);
+                // A client that drops before its answer must not keep the session.
+                if (webAssetOwnedBy(request))
+                    request->onDisconnect([request]() { webAssetRelease(request); });
+            }
+            if (webAssetOwnedBy(request))
+                webAssetWrite(data, len);
+        });
+
+    asyncServer.on("/api/assets/commit", HTTP_POST, [](AsyncWebServerRequest *request)
+    {
+        if (otaInProgress)
+        {
+            request->send(409, "application/json", otaJson(false, "firmware or filesystem update in progress"));
+            return;
+        }
+        String build = request->hasParam("build", true) ? request->getParam("build", true)->value() : String();
+        String remove = request->hasParam("remove", true) ? request->getParam("remove", true)->value() : String();
+        String errMsg;
+        int httpStatus;
+        if (!webAssetCommit(build, remove, errMsg, httpStatus))
+        {
+            logCapture.printf("[API] asset commit failed: %s\n", errMsg.c_str());
+            request->send(httpStatus, "application/json", otaJson(false, jsonEscape(errMsg)));
+            return;
+        }
+        // Pages revalidate against the new build id from here on.
+        sStaticAssets.loaded = false;
+        sStaticAssets.buildETag = "";
+        logCapture.printf("[API] web assets committed: build %s\n", build.c_str());
+        request->send(200, "application/json", webAssetListJson());
+    });
+
     // ---- REST API: Dome element status ----
     // Operator maintenance flags for the layout contract and panel-servo
     // safety. Disabled panel elements remain visible in the layout but are
@@ -1686,33 +2585,85 @@ static void initAsyncWeb()
                     String("{\"error\":\"") + jsonEscape(errMsg) + "\"}");
                 return;
             }
-            if (!domeElementStatusSaveUpdates(updates, updateCount))
+            int changed[DOME_ELEMENT_STATUS_MAX_ELEMENTS];
+            int changedCount = 0;
+            if (!domeElementStatusSaveUpdates(updates, updateCount, changed, &changedCount))
             {
-                logCapture.println("[API] Error: dome/element-status NVS save failed "
-                                    "(flash full or NVS corrupt — investigate)");
-                request->send(500, "application/json", "{\"error\":\"NVS save failed\"}");
+                logCapture.println("[API] Error: dome/element-status save failed "
+                                    "(out of memory staging the NVS write); status unchanged");
+                request->send(500, "application/json", "{\"error\":\"status save failed\"}");
                 return;
             }
-            logCapture.printf("[API] dome/element-status saved: %d update(s)\n",
-                              updateCount);
-            domeReloadPanelRoutingWithDisabledOverlay();
+            logCapture.printf("[API] dome/element-status saved: %d update(s), %d changed\n",
+                              updateCount, changedCount);
+            if (changedCount > 0)
+            {
+                domeReloadPanelRoutingWithDisabledOverlay();
+                broadcastElementStatusDelta(changed, changedCount);
+            }
             request->send(200, "application/json",
-                String("{\"ok\":true,\"updated\":") + updateCount + "}");
+                String("{\"ok\":true,\"updated\":") + updateCount +
+                ",\"changed\":" + changedCount +
+                ",\"generation\":" + domeElementStatusGeneration() + "}");
         },
         NULL,
-        [](AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total)
+        receiveDomeElementStatusBody);
+
+    // Incremental edit for concurrent operators: the body names the status
+    // generation it was based on and is refused with 409 (plus the current
+    // table to rebase on) if another save landed first.
+    asyncServer.on("/api/dome/element-status", HTTP_PATCH,
+        [](AsyncWebServerRequest *request)
         {
-            // Status updates are small; cap at 4 KiB to match the wiring config
-            // endpoints while still allowing several annotated elements at once.
-            if (total > 4096) return;
-            if (index == 0)
+            String *body = (String *)request->_tempObject;
+            if (!body || body->length() == 0)
             {
-                request->_tempObject = new String();
-                ((String *)request->_tempObject)->reserve(total + 1);
+                logCapture.println("[API] dome/element-status patch rejected: empty body");
+                request->send(400, "application/json", "{\"error\":\"empty body\"}");
+                if (body) { delete body; request->_tempObject = nullptr; }
+                return;
             }
-            String *body = (String *)request->_tempObject;
-            if (body) body->concat((const char *)data, len);
-        });
+
+            int changed[DOME_ELEMENT_STATUS_MAX_ELEMENTS];
+            int changedCount = 0;
+            String errMsg;
+            DomeElementStatusPatchResult result = domeElementStatusPatch(*body, changed, changedCount, errMsg);
+            delete body;
+            request->_tempObject = nullptr;
+            if (result == kDomeElementStatusPatchInvalid)
+            {
+                logCapture.printf("[API] dome/element-status patch rejected: %s\n", errMsg.c_str());
+                request->send(400, "application/json",
+                    String("{\"error\":\"") + jsonEscape(errMsg) + "\"}");
+                return;
+            }
+            if (result == kDomeElementStatusPatchStale)
+            {
+                logCapture.printf("[API] dome/element-status patch conflict: %s\n", errMsg.c_str());
+                String current = domeElementStatusBuildJson(jsonEscape);
+                request->send(409, "application/json",
+                    String("{\"error\":\"stale generation\",") + current.substring(1));
+                return;
+            }
+            if (result == kDomeElementStatusPatchSaveFailed)
+            {
+                logCapture.println("[API] Error: dome/element-status patch failed "
+                                    "(out of memory staging the NVS write); status unchanged");
+                request->send(500, "application/json", "{\"error\":\"status save failed\"}");
+                return;
+            }
+            logCapture.printf("[API] dome/element-status patched: %d changed\n", changedCount);
+            if (changedCount > 0)
+            {
+                domeReloadPanelRoutingWithDisabledOverlay();
+                broadcastElementStatusDelta(changed, changedCount);
+            }
+            request->send(200, "application/json",
+                String("{\"ok\":true,\"changed\":") + changedCount +
+                ",\"generation\":" + domeElementStatusGeneration() + "}");
+        },
+        NULL,
+        receiveDomeElementStatusBody);
 
     // ---- REST API: Raw servo test (no slot routing, direct PCA9685 write) ----
     // Implemented by WiringCommissioning so route code does not own board
@@ -1980,6 +2931,16 @@ static void initAsyncWeb()
     });
 
     // ---- Firmware upload (OTA via web) ----
+    // Optional query params: size (image bytes), sha256 (hex digest, checked
+    // before the image is committed) and offset (resume an interrupted upload
+    // at GET /api/ota/status "offset"; the body then carries the rest).
+    asyncServer.on("/api/ota/status", HTTP_GET, [](AsyncWebServerRequest *request)
+    {
+        OtaSessionGuard sessionGuard;
+        otaExpireSession(millis());
+        request->send(200, "application/json", otaStatusBuildJson());
+    });
+
     asyncServer.on("/upload/firmware", HTTP_POST,
         // Response handler (called after upload completes)
         [](AsyncWebServerRequest *request)
@@ -1989,15 +2950,19 @@ static void initAsyncWeb()
             {
                 if (otaUploadError.length() == 0)
                     otaUploadError = "firmware update failed";
-                request->send(otaUploadHttpStatus, "application/json", otaJson(false, otaUploadError));
-                FLD.selectSequence(LogicEngineDefaults::FAILURE);
-                FLD.setTextMessage("Flash Fail");
-                FLD.selectSequence(LogicEngineDefaults::TEXTSCROLLLEFT,
-                                   LogicEngineRenderer::kRed, 1, 0);
+                String json = "{\"ok\":false,\"error\":\"" + otaUploadError + "\"";
+                if (sOtaStream.active)
+                    json += ",\"offset\":" + String(sOtaStream.received);
+                request->send(otaUploadHttpStatus, "application/json", json + "}");
+                {
+                    LedDisplayGuard displayGuard;
+                    FLD.selectSequence(LogicEngineDefaults::FAILURE);
+                    selectLogicTextStrip(FLD, "Flash Fail", LogicEngineRenderer::kRed, 1, 0);
+                }
             }
             else
             {
-                request->send(200, "application/json", otaJson(true));
+                request->send(200, "application/json", "{\"ok\":true,\"sha256\":\"" + sOtaLastDigest + "\"}");
                 scheduleReboot(1000);
             }
         },
@@ -2005,25 +2970,63 @@ static void initAsyncWeb()
         [](AsyncWebServerRequest *request, const String &filename,
            size_t index, uint8_t *data, size_t len, bool final)
         {
+            OtaSessionGuard sessionGuard;
+            uint32_t now = millis();
             if (index == 0)
             {
-                // First chunk — start the update
+                otaExpireSession(now);
                 otaInProgress = true;
                 otaUploadFailed = false;
                 otaUploadHttpStatus = 500;
                 otaUploadError = "";
-                unmountFileSystems();
-                FLD.selectSequence(LogicEngineDefaults::NORMAL);
-                RLD.selectSequence(LogicEngineDefaults::NORMAL);
-                FLD.setEffectWidthRange(0);
-                RLD.setEffectWidthRange(0);
-                logCapture.printf("Update: %s\n", filename.c_str());
-                if (!Update.begin(UPDATE_SIZE_UNKNOWN, U_FLASH))
+                uint32_t offset = otaQueryUInt(request, "offset");
+                uint32_t size = otaQueryUInt(request, "size");
+                String sha256 = request->hasParam("sha256") ? request->getParam("sha256")->value() : String("");
+                sOtaRequestBase = offset;
+                if (offset > 0)
                 {
-                    Update.printError(Serial);
-                    logCapture.println("Update begin failed");
-                    markOtaUploadFailed(413, "firmware image rejected or too large for OTA slot");
-                    return;
+                    OtaStreamResult result = otaStreamResume(sOtaStream, offset, size, sha256.c_str(), now);
+                    if (result != kOtaStreamOk)
+                    {
+                        logCapture.printf("Update resume at %u rejected: %s\n", offset, otaStreamResultText(result));
+                        markOtaUploadFailed(409, otaStreamResultText(result));
+                        return;
+                    }
+                    logCapture.printf("Update resumed at %u bytes\n", offset);
+                }
+                else
+                {
+                    if (sOtaStream.active)
+                    {
+                        otaStreamAbort(sOtaStream, kOtaWriterSink);
+                        Update.abort();
+                        logCapture.println("Update: interrupted session discarded");
+                    }
+                    unmountFileSystems();
+                    {
+                        LedDisplayGuard displayGuard;
+                        FLD.selectSequence(LogicEngineDefaults::NORMAL);
+                        RLD.selectSequence(LogicEngineDefaults::NORMAL);
+                        FLD.setEffectWidthRange(0);
+                        RLD.setEffectWidthRange(0);
+                    }
+                    logCapture.printf("Update: %s\n", filename.c_str());
+                    sOtaLastDigest = "";
+                    otaWriterBegin();
+                    sOtaWriteOk = true;
+                    if (!otaStreamBegin(sOtaStream, size, sha256.c_str(), now))
+                    {
+                        markOtaUploadFailed(400, "sha256 must be 64 hex digits");
+                        return;
+                    }
+                    if (!Update.begin(size != 0 ? size : UPDATE_SIZE_UNKNOWN, U_FLASH))
+                    {
+                        Update.printError(Serial);
+                        logCapture.println("Update begin failed");
+                        otaStreamAbort(sOtaStream, kOtaWriterSink);
+                        markOtaUploadFailed(413, "firmware image rejected or too large for OTA slot");
+                        return;
+                    }
                 }
             }
             if (otaUploadFailed)
@@ -2032,28 +3035,174 @@ static void initAsyncWeb()
             }
             if (len)
             {
-                if (Update.write(data, len) != len)
+                OtaStreamResult result = otaStreamWrite(sOtaStream, kOtaWriterSink, data, len, now);
+                if (result != kOtaStreamOk)
                 {
                     Update.printError(Serial);
-                    logCapture.println("Update write failed");
-                    markOtaUploadFailed(413, "firmware image write failed or exceeded OTA slot");
+                    logCapture.printf("Update write failed: %s\n", otaStreamResultText(result));
+                    otaStreamAbort(sOtaStream, kOtaWriterSink);
+                    Update.abort();
+                    markOtaUploadFailed(413, otaStreamResultText(result));
                     return;
                 }
-                // Show progress on logic displays + broadcast to WS clients
-                if (request->contentLength() > 0)
+                // Show progress on logic displays + broadcast to WS clients,
+                // at most every OTA_STREAM_PROGRESS_MS.
+                uint32_t total = sOtaStream.size != 0 ? sOtaStream.size : sOtaRequestBase + request->contentLength();
+                if (total > 0 && otaStreamProgressDue(sOtaStream, now))
                 {
-                    float range = (float)(index + len) / (float)request->contentLength();
+                    float range = (float)sOtaStream.received / (float)total;
+                    if (range > 1.0f)
+                        range = 1.0f;
+                    {
+                        LedDisplayGuard displayGuard;
+                        FLD.setEffectWidthRange(range);
+                        RLD.setEffectWidthRange(range);
+                    }
+                    broadcastOtaProgress(range, otaStreamKbps(sOtaStream));
+                }
+            }
+            if (final)
+            {
+                OtaStreamResult result = otaStreamFinish(sOtaStream, kOtaWriterSink);
+                const OtaStreamStats &st = sOtaStream.stats;
+                if (sOtaStream.haveDigest)
+                {
+                    char hex[SHA256_HEX_LEN + 1];
+                    sha256ToHex(sOtaStream.digest, hex);
+                    sOtaLastDigest = hex;
+                }
+                logCapture.printf("Update complete: %u bytes, %u KB/s, %u ms stalled, %u resumes, sha256 %s\n",
+                                  sOtaStream.received, otaStreamKbps(sOtaStream), st.stallMs, st.resumes,
+                                  sOtaLastDigest.c_str());
+                if (result != kOtaStreamOk)
+                {
+                    logCapture.printf("Update rejected: %s\n", otaStreamResultText(result));
+                    Update.abort();
+                    markOtaUploadFailed(result == kOtaStreamWriteFailed ? 500 : 400, otaStreamResultText(result));
+                    return;
+                }
+                if (Update.end(true))
+                {
+                    logCapture.println("Update Success. Rebooting...");
+                }
+                else
+                {
+                    Update.printError(Serial);
+                    markOtaUploadFailed(500, "firmware update finalize failed");
+                }
+            }
+        });
+
+    // ---- Delta firmware upload ----
+    // Multipart field "patch" from tools/firmware_delta.py. 409 when the
+    // patch was built against a different image than the one running.
+    asyncServer.on("/upload/firmware-delta", HTTP_POST,
+        [](AsyncWebServerRequest *request)
+        {
+            otaInProgress = false;
+            if (otaUploadFailed || Update.hasError())
+            {
+                if (otaUploadError.length() == 0)
+                    otaUploadError = "firmware update failed";
+                request->send(otaUploadHttpStatus, "application/json", otaJson(false, otaUploadError));
+                {
+                    LedDisplayGuard displayGuard;
+                    FLD.selectSequence(LogicEngineDefaults::FAILURE);
+                    selectLogicTextStrip(FLD, "Flash Fail", LogicEngineRenderer::kRed, 1, 0);
+                }
+            }
+            else
+            {
+                request->send(200, "application/json", "{\"ok\":true,\"sha256\":\"" + sOtaLastDigest + "\"}");
+                scheduleReboot(1000);
+            }
+        },
+        [](AsyncWebServerRequest *request, const String &filename,
+           size_t index, uint8_t *data, size_t len, bool final)
+        {
+            OtaSessionGuard sessionGuard;
+            uint32_t now = millis();
+            if (index == 0)
+            {
+                otaExpireSession(now);
+                otaInProgress = true;
+                otaUploadFailed = false;
+                otaUploadHttpStatus = 500;
+                otaUploadError = "";
+                if (sOtaStream.active)
+                {
+                    otaStreamAbort(sOtaStream, kOtaWriterSink);
+                    Update.abort();
+                    logCapture.println("Update: interrupted session discarded");
+                }
+                unmountFileSystems();
+                {
+                    LedDisplayGuard displayGuard;
+                    FLD.selectSequence(LogicEngineDefaults::NORMAL);
+                    RLD.selectSequence(LogicEngineDefaults::NORMAL);
+                    FLD.setEffectWidthRange(0);
+                    RLD.setEffectWidthRange(0);
+                }
+                logCapture.printf("Delta update: %s\n", filename.c_str());
+                sOtaLastDigest = "";
+                deltaPatchReset(sDeltaPatch);
+            }
+            if (otaUploadFailed)
+            {
+                return;
+            }
+            size_t used = 0;
+            while (used < len)
+            {
+                DeltaPatchResult result;
+                used += deltaPatchFeed(sDeltaPatch, kDeltaPatchIo, data + used, len - used, result);
+                if (result == kDeltaHeaderDone)
+                {
+                    if (!deltaUploadStart(now))
+                        return;
+                }
+                else if (result != kDeltaOk)
+                {
+                    deltaUploadFail(result == kDeltaWriteFailed || result == kDeltaReadFailed ? 500 : 400,
+                                    deltaPatchResultText(result));
+                    return;
+                }
+            }
+            if (sOtaStream.active && sOtaStream.size > 0 && otaStreamProgressDue(sOtaStream, now))
+            {
+                float range = (float)sOtaStream.received / (float)sOtaStream.size;
+                {
+                    LedDisplayGuard displayGuard;
                     FLD.setEffectWidthRange(range);
                     RLD.setEffectWidthRange(range);
-                    broadcastOtaProgress(range);
                 }
+                broadcastOtaProgress(range, otaStreamKbps(sOtaStream));
             }
             if (final)
             {
-                logCapture.printf("Update complete: %u bytes\n", index + len);
-                if (otaUploadFailed)
+                DeltaPatchResult patched = deltaPatchFinish(sDeltaPatch, kDeltaPatchIo);
+                if (patched != kDeltaOk)
+                {
+                    deltaUploadFail(patched == kDeltaWriteFailed ? 500 : 400, deltaPatchResultText(patched));
+                    return;
+                }
+                OtaStreamResult result = otaStreamFinish(sOtaStream, kOtaWriterSink);
+                if (sOtaStream.haveDigest)
+                {
+                    char hex[SHA256_HEX_LEN + 1];
+                    sha256ToHex(sOtaStream.digest, hex);
+                    sOtaLastDigest = hex;
+                }
+                const DeltaPatchStats &st = sDeltaPatch.stats;
+                logCapture.printf("Delta update complete: %u patch bytes -> %u bytes (%u copied, %u patched, "
+                                  "%u literal), sha256 %s\n",
+                                  index + len, sOtaStream.received, st.copiedBytes, st.patchedBytes,
+                                  st.literalBytes, sOtaLastDigest.c_str());
+                if (result != kOtaStreamOk)
                 {
-                    logCapture.println("Update aborted after previous write error");
+                    logCapture.printf("Update rejected: %s\n", otaStreamResultText(result));
+                    Update.abort();
+                    markOtaUploadFailed(result == kOtaStreamWriteFailed ? 500 : 400, otaStreamResultText(result));
                     return;
                 }
                 if (Update.end(true))
@@ -2078,10 +3227,11 @@ static void initAsyncWeb()
                 if (otaUploadError.length() == 0)
                     otaUploadError = "filesystem update failed";
                 request->send(otaUploadHttpStatus, "application/json", otaJson(false, otaUploadError));
-                FLD.selectSequence(LogicEngineDefaults::FAILURE);
-                FLD.setTextMessage("FS Flash Fail");
-                FLD.selectSequence(LogicEngineDefaults::TEXTSCROLLLEFT,
-                                   LogicEngineRenderer::kRed, 1, 0);
+                {
+                    LedDisplayGuard displayGuard;
+                    FLD.selectSequence(LogicEngineDefaults::FAILURE);
+                    selectLogicTextStrip(FLD, "FS Flash Fail", LogicEngineRenderer::kRed, 1, 0);
+                }
             }
             else
             {
@@ -2092,17 +3242,29 @@ static void initAsyncWeb()
         [](AsyncWebServerRequest *request, const String &filename,
            size_t index, uint8_t *data, size_t len, bool final)
         {
+            OtaSessionGuard sessionGuard;
             if (index == 0)
             {
                 otaInProgress = true;
                 otaUploadFailed = false;
                 otaUploadHttpStatus = 500;
                 otaUploadError = "";
+                // A parked firmware session still holds Update; SPIFFS
+                // cannot begin until it is released.
+                if (sOtaStream.active)
+                {
+                    otaStreamAbort(sOtaStream, kOtaWriterSink);
+                    Update.abort();
+                    logCapture.println("Filesystem update: interrupted firmware session discarded");
+                }
                 unmountFileSystems();
-                FLD.selectSequence(LogicEngineDefaults::NORMAL);
-                RLD.selectSequence(LogicEngineDefaults::NORMAL);
-                FLD.setEffectWidthRange(0);
-                RLD.setEffectWidthRange(0);
+                {
+                    LedDisplayGuard displayGuard;
+                    FLD.selectSequence(LogicEngineDefaults::NORMAL);
+                    RLD.selectSequence(LogicEngineDefaults::NORMAL);
+                    FLD.setEffectWidthRange(0);
+                    RLD.setEffectWidthRange(0);
+                }
                 logCapture.printf("Filesystem update: %s\n", filename.c_str());
                 if (!Update.begin(UPDATE_SIZE_UNKNOWN, U_SPIFFS))
                 {
@@ -2128,8 +3290,11 @@ static void initAsyncWeb()
                 if (request->contentLength() > 0)
                 {
                     float range = (float)(index + len) / (float)request->contentLength();
-                    FLD.setEffectWidthRange(range);
-                    RLD.setEffectWidthRange(range);
+                    {
+                        LedDisplayGuard displayGuard;
+                        FLD.setEffectWidthRange(range);
+                        RLD.setEffectWidthRange(range);
+                    }
                     broadcastOtaProgress(range);
                 }
             }
@@ -2173,6 +3338,18 @@ static void asyncWebLoop()
         return;
     }
 
+    domeElementStatusPersistPending(millis());
+    deltaBaseHashStep();
+
+    // A client that drops mid-upload never comes back to the route, so the
+    // parked session (Update begun, SPIFFS unmounted, otaInProgress set)
+    // is released here once the resume window has passed.
+    {
+        OtaSessionGuard sessionGuard(0);
+        if (sessionGuard.held() && otaExpireSession(millis()))
+            mountReadOnlyFileSystem();
+    }
+
     if (ws.count() == 0)
         return;
 
@@ -2228,15 +3405,27 @@ static void broadcastState()
 // ---------------------------------------------------------------
 // Broadcast OTA progress to all connected WebSocket clients
 // ---------------------------------------------------------------
-static void broadcastOtaProgress(float progress)
+static void broadcastOtaProgress(float progress, uint32_t kbps)
 {
     if (ws.count() > 0)
     {
-        String json = "{\"type\":\"ota\",\"progress\":" + String(progress, 2) + "}";
+        String json = "{\"type\":\"ota\",\"progress\":" + String(progress, 2);
+        json += ",\"kbps\":" + String(kbps) + "}";
         ws.textAll(json);
     }
 }
 
+// ---------------------------------------------------------------
+// Broadcast changed dome element status to all connected WebSocket clients
+// ---------------------------------------------------------------
+static void broadcastElementStatusDelta(const int *changed, int changedCount)
+{
+    if (ws.count() > 0)
+    {
+        ws.textAll(domeElementStatusBuildDeltaJson(changed, changedCount, jsonEscape));
+    }
+}
+
 // ---------------------------------------------------------------
 // Get the LogCapture instance — used in .ino to redirect Serial
 // ---------------------------------------------------------------
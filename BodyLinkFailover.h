@@ -0,0 +1,335 @@
+#pragma once
+// BodyLinkFailover.h — transport selection, adaptive heartbeat and command
+// replay for the body link.
+//
+// The link used to call UART dead after a fixed 5 s without #PAHB, so a slip
+// ring dropping out mid-show lost up to 5 s of commands before WiFi took over.
+// Each path now learns the body's heartbeat cadence and is declared dead after
+// BODY_LINK_FAILOVER_MISSES intervals of silence (any received line counts as
+// a sign of life), clamped to BODY_LINK_FAILOVER_MIN_MS..MAX_MS. With the
+// legacy 1 Hz body heartbeat that is 3 s; the dome asks the body for faster
+// heartbeats with "#APHI<ms>", and a body that honours it brings detection
+// under a second. A body that ignores the request keeps the 1 Hz cadence.
+//
+// The dome's own heartbeat is adaptive: every BODY_LINK_HB_IDLE_MS while
+// nothing else is going to the body, but only every BODY_LINK_HB_MAX_MS (the
+// legacy rate) while commands are flowing, since those already show the dome
+// is alive.
+//
+// Every command sent to the body is remembered for BODY_LINK_REPLAY_MAX_AGE_MS,
+// the longest switchover window. When the active path dies, commands sent on
+// it after the body was last heard from are marked pending, as are commands
+// sent while no path was up; the next path to come up replays them in order
+// and records them as sent on it, so they are replayed again if that path
+// dies before the body is heard on it. A command that never went out is only
+// replayed within BODY_LINK_REPLAY_UNSENT_MAX_AGE_MS, so the first link-up
+// after boot or a long outage does not fire stale sounds and panel moves. A
+// command that did arrive just before the path died is sent twice, which is
+// the lesser evil for panel and sequence commands. Commands can be sent from
+// the web task (sleep/wake sync), so the replay buffer is guarded by
+// BODY_LINK_FAILOVER_LOCK, a portMUX on the ESP32; everything else runs on
+// the loop task.
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#define BODY_LINK_FAILOVER_MIN_MS 300
+#define BODY_LINK_FAILOVER_MAX_MS 5000      // the old fixed timeout; used until a cadence is known
+#define BODY_LINK_FAILOVER_MISSES 3
+#define BODY_LINK_HB_IDLE_MS 250
+#define BODY_LINK_HB_MAX_MS 1000
+#define BODY_LINK_HB_REQUEST_MS 250         // cadence asked of the body via "#APHI250"
+#define BODY_LINK_HB_REQUEST_EVERY_MS 5000
+#define BODY_LINK_HB_REQUEST_TRIES 3        // per connection; older bodies ignore it
+#define BODY_LINK_REPLAY_SLOTS 16
+#define BODY_LINK_REPLAY_CMD_MAX 64
+#define BODY_LINK_REPLAY_MAX_AGE_MS BODY_LINK_FAILOVER_MAX_MS
+#define BODY_LINK_REPLAY_UNSENT_MAX_AGE_MS 1000   // about one fast switchover (3 x 250 ms)
+
+#ifndef BODY_LINK_FAILOVER_LOCK
+#define BODY_LINK_FAILOVER_LOCK()
+#define BODY_LINK_FAILOVER_UNLOCK()
+#endif
+
+enum
+{
+    kBodyLinkPathUart = 0,
+    kBodyLinkPathWifi = 1,
+    kBodyLinkPathNone = 2,
+    kBodyLinkPathCount = 2
+};
+
+enum BodyLinkReplayState
+{
+    kBodyLinkReplayFree,
+    kBodyLinkReplaySent,        // went out on entry.path
+    kBodyLinkReplayPending,     // path died (or none was up); replay on the next one
+    kBodyLinkReplayDone         // too old when its turn came; dropped
+};
+
+struct BodyLinkPathState
+{
+    uint32_t lastRxMs;          // any line from the body on this path
+    uint32_t lastHeartbeatMs;
+    uint32_t intervalMs;        // learned body heartbeat cadence (EWMA), 0 = unknown
+    bool alive;
+    uint8_t hbRequests;
+    uint32_t nextHbRequestMs;
+};
+
+struct BodyLinkReplayEntry
+{
+    uint32_t issuedMs;          // first sent (or queued); replay age counts from here
+    uint32_t sentMs;            // last sent, on path
+    uint8_t path;               // kBodyLinkPathNone until it has gone out somewhere
+    uint8_t state;
+    char cmd[BODY_LINK_REPLAY_CMD_MAX + 1];
+};
+
+struct BodyLinkFailoverStats
+{
+    uint32_t failovers;         // active path died and another (or none) took over
+    uint32_t failbacks;         // WiFi -> UART once UART heartbeats return
+    uint32_t lastDetectMs;      // last sign of life -> switch decision
+    uint32_t maxDetectMs;
+    uint32_t totalDetectMs;
+    uint32_t lastRecoveryMs;    // last sign of life on the dead path -> first one after the switch
+    uint32_t maxRecoveryMs;
+    uint32_t replayed;
+    uint32_t replayExpired;     // pending but past its replay age
+    uint32_t unbuffered;        // longer than BODY_LINK_REPLAY_CMD_MAX, not kept
+    uint32_t heartbeatsTx;
+    uint32_t commandsTx;
+};
+
+struct BodyLinkFailover
+{
+    BodyLinkPathState path[kBodyLinkPathCount];
+    uint8_t active;
+    uint32_t switchedMs;
+    uint32_t lastTxMs;
+    uint32_t lastHeartbeatTxMs;
+    bool recoveryPending;
+    uint32_t lostRxMs;
+    BodyLinkReplayEntry replay[BODY_LINK_REPLAY_SLOTS];
+    uint8_t replayNext;
+    BodyLinkFailoverStats stats;
+};
+
+typedef void (*BodyLinkReplayFn)(uint8_t path, const char *cmd, void *ctx);
+
+static inline void bodyLinkFailoverReset(BodyLinkFailover &f)
+{
+    memset(&f, 0, sizeof(f));
+    f.active = kBodyLinkPathNone;
+}
+
+static inline uint32_t bodyLinkFailoverDeadlineMs(const BodyLinkPathState &p)
+{
+    if (p.intervalMs == 0)
+        return BODY_LINK_FAILOVER_MAX_MS;
+    uint32_t deadline = p.intervalMs * BODY_LINK_FAILOVER_MISSES;
+    if (deadline < BODY_LINK_FAILOVER_MIN_MS)
+        return BODY_LINK_FAILOVER_MIN_MS;
+    if (deadline > BODY_LINK_FAILOVER_MAX_MS)
+        return BODY_LINK_FAILOVER_MAX_MS;
+    return deadline;
+}
+
+static inline bool bodyLinkFailoverPathAlive(const BodyLinkFailover &f, uint8_t path, uint32_t now)
+{
+    if (path >= kBodyLinkPathCount)
+        return false;
+    const BodyLinkPathState &p = f.path[path];
+    // Signed: rx can be stamped on another task a tick after the caller's now.
+    return p.lastRxMs != 0 && (int32_t)(now - p.lastRxMs) < (int32_t)bodyLinkFailoverDeadlineMs(p);
+}
+
+static inline void bodyLinkFailoverNoteRx(BodyLinkFailover &f, uint8_t path, uint32_t now, bool heartbeat)
+{
+    if (path >= kBodyLinkPathCount)
+        return;
+    BodyLinkPathState &p = f.path[path];
+    if (heartbeat)
+    {
+        if (p.lastHeartbeatMs != 0)
+        {
+            // Gaps longer than the deadline are outages, not cadence.
+            int32_t gap = (int32_t)(now - p.lastHeartbeatMs);
+            if (gap > 0 && (uint32_t)gap < bodyLinkFailoverDeadlineMs(p))
+                p.intervalMs = p.intervalMs == 0 ? (uint32_t)gap
+                                                 : (uint32_t)((int32_t)p.intervalMs + (gap - (int32_t)p.intervalMs) / 4);
+        }
+        p.lastHeartbeatMs = now;
+    }
+    p.lastRxMs = now;
+    if (f.recoveryPending && (int32_t)(now - f.switchedMs) >= 0)
+    {
+        f.recoveryPending = false;
+        f.stats.lastRecoveryMs = now - f.lostRxMs;
+        if (f.stats.lastRecoveryMs > f.stats.maxRecoveryMs)
+            f.stats.maxRecoveryMs = f.stats.lastRecoveryMs;
+    }
+}
+
+// Records a command sent on `path` (kBodyLinkPathNone when nothing was up, in
+// which case it waits for the next path).
+static inline void bodyLinkFailoverNoteTx(BodyLinkFailover &f, uint8_t path, const char *cmd, uint32_t now)
+{
+    size_t len = strlen(cmd);
+    BODY_LINK_FAILOVER_LOCK();
+    f.lastTxMs = now;
+    f.stats.commandsTx++;
+    if (len > BODY_LINK_REPLAY_CMD_MAX)
+    {
+        f.stats.unbuffered++;
+        BODY_LINK_FAILOVER_UNLOCK();
+        return;
+    }
+    BodyLinkReplayEntry &e = f.replay[f.replayNext];
+    f.replayNext = (f.replayNext + 1) % BODY_LINK_REPLAY_SLOTS;
+    if (e.state == kBodyLinkReplayPending)
+        f.stats.replayExpired++;
+    e.issuedMs = now;
+    e.sentMs = now;
+    e.path = path;
+    e.state = path < kBodyLinkPathCount ? kBodyLinkReplaySent : kBodyLinkReplayPending;
+    memcpy(e.cmd, cmd, len + 1);
+    BODY_LINK_FAILOVER_UNLOCK();
+}
+
+// True when a dome heartbeat should go out now.
+static inline bool bodyLinkFailoverHeartbeatDue(BodyLinkFailover &f, uint32_t now)
+{
+    uint32_t sinceHeartbeat = now - f.lastHeartbeatTxMs;
+    bool due = f.lastHeartbeatTxMs == 0 || sinceHeartbeat >= BODY_LINK_HB_MAX_MS ||
+               (sinceHeartbeat >= BODY_LINK_HB_IDLE_MS && now - f.lastTxMs >= BODY_LINK_HB_IDLE_MS);
+    if (!due)
+        return false;
+    f.lastHeartbeatTxMs = now;
+    f.lastTxMs = now;
+    f.stats.heartbeatsTx++;
+    return true;
+}
+
+// True when the heartbeat going out on `path` should carry
+// "#APHI<BODY_LINK_HB_REQUEST_MS>".
+static inline bool bodyLinkFailoverHeartbeatRequestDue(BodyLinkFailover &f, uint8_t path, uint32_t now)
+{
+    if (path >= kBodyLinkPathCount)
+        return false;
+    BodyLinkPathState &p = f.path[path];
+    if (!p.alive || p.hbRequests >= BODY_LINK_HB_REQUEST_TRIES)
+        return false;
+    if (p.intervalMs != 0 && p.intervalMs <= BODY_LINK_HB_REQUEST_MS * 2)
+        return false;
+    if ((int32_t)(now - p.nextHbRequestMs) < 0)
+        return false;
+    p.hbRequests++;
+    p.nextHbRequestMs = now + BODY_LINK_HB_REQUEST_EVERY_MS;
+    return true;
+}
+
+static inline void bodyLinkFailoverReplay(BodyLinkFailover &f, uint32_t now, BodyLinkReplayFn fn, void *ctx)
+{
+    // Oldest first: the slot after the newest. Each command is copied out
+    // under the lock and sent outside it.
+    BODY_LINK_FAILOVER_LOCK();
+    uint8_t start = f.replayNext;
+    BODY_LINK_FAILOVER_UNLOCK();
+    for (uint8_t i = 0; i < BODY_LINK_REPLAY_SLOTS; i++)
+    {
+        char cmd[BODY_LINK_REPLAY_CMD_MAX + 1];
+        BODY_LINK_FAILOVER_LOCK();
+        BodyLinkReplayEntry &e = f.replay[(start + i) % BODY_LINK_REPLAY_SLOTS];
+        bool send = false;
+        if (e.state == kBodyLinkReplayPending)
+        {
+            uint32_t maxAge = e.path < kBodyLinkPathCount ? BODY_LINK_REPLAY_MAX_AGE_MS
+                                                          : BODY_LINK_REPLAY_UNSENT_MAX_AGE_MS;
+            if (now - e.issuedMs > maxAge)
+            {
+                e.state = kBodyLinkReplayDone;
+                f.stats.replayExpired++;
+            }
+            else
+            {
+                // Sent again: pending once more if this path dies unheard.
+                e.state = kBodyLinkReplaySent;
+                e.path = f.active;
+                e.sentMs = now;
+                f.stats.replayed++;
+                memcpy(cmd, e.cmd, sizeof(cmd));
+                send = true;
+            }
+        }
+        BODY_LINK_FAILOVER_UNLOCK();
+        if (send)
+            fn(f.active, cmd, ctx);
+    }
+}
+
+// Re-evaluates the paths and returns the active one. Call often from the loop
+// task; replays (through fn) happen here.
+static inline uint8_t bodyLinkFailoverUpdate(BodyLinkFailover &f, uint32_t now, bool wifiUsable,
+                                             BodyLinkReplayFn fn, void *ctx)
+{
+    for (uint8_t i = 0; i < kBodyLinkPathCount; i++)
+    {
+        bool alive = bodyLinkFailoverPathAlive(f, i, now);
+        if (alive && !f.path[i].alive)
+            f.path[i].hbRequests = 0;
+        f.path[i].alive = alive;
+    }
+
+    uint8_t want = kBodyLinkPathNone;
+    if (f.path[kBodyLinkPathUart].alive)
+        want = kBodyLinkPathUart;
+    else if (wifiUsable)
+        want = kBodyLinkPathWifi;
+    if (want == f.active)
+        return f.active;
+
+    uint8_t old = f.active;
+    bool oldLost = old == kBodyLinkPathUart ? !f.path[old].alive
+                 : old == kBodyLinkPathWifi ? !wifiUsable
+                 : false;
+    if (oldLost)
+    {
+        uint32_t lastRx = f.path[old].lastRxMs;
+        BODY_LINK_FAILOVER_LOCK();
+        for (uint8_t i = 0; i < BODY_LINK_REPLAY_SLOTS; i++)
+        {
+            BodyLinkReplayEntry &e = f.replay[i];
+            if (e.state == kBodyLinkReplaySent && e.path == old && (int32_t)(e.sentMs - lastRx) >= 0)
+                e.state = kBodyLinkReplayPending;
+        }
+        BODY_LINK_FAILOVER_UNLOCK();
+        // A WiFi peer that was never heard from has no detection time.
+        if (lastRx != 0)
+        {
+            f.stats.failovers++;
+            f.stats.lastDetectMs = now - lastRx;
+            f.stats.totalDetectMs += f.stats.lastDetectMs;
+            if (f.stats.lastDetectMs > f.stats.maxDetectMs)
+                f.stats.maxDetectMs = f.stats.lastDetectMs;
+            f.recoveryPending = true;
+            f.lostRxMs = lastRx;
+        }
+    }
+    else if (old == kBodyLinkPathWifi && want == kBodyLinkPathUart)
+    {
+        f.stats.failbacks++;
+    }
+    f.active = want;
+    f.switchedMs = now;
+    if (want != kBodyLinkPathNone && fn != nullptr)
+        bodyLinkFailoverReplay(f, now, fn, ctx);
+    return f.active;
+}
+
+static inline uint32_t bodyLinkFailoverAvgDetectMs(const BodyLinkFailoverStats &st)
+{
+    return st.failovers == 0 ? 0 : st.totalDetectMs / st.failovers;
+}
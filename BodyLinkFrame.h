@@ -0,0 +1,335 @@
+#pragma once
+// BodyLinkFrame.h — optional framed protocol for the protoR2link UDP transport.
+//
+// The text protocol spends one datagram per Marcduino command, so a DM:
+// sequence that emits `dome=seqon`, a `BD:` cue and a rotation costs three
+// packets, and nothing tells either side that one went missing. The framed
+// protocol carries several length-prefixed commands per datagram, numbers
+// every datagram and acknowledges what arrived, which gives duplicate and
+// out-of-order detection plus loss and round-trip statistics. Nothing is
+// retransmitted; a lost datagram is counted, exactly as a lost text packet
+// would have been dropped silently.
+//
+// Datagram layout (little endian):
+//
+//   0  magic    0xB1 (never the first byte of a text command)
+//   1  flags    kBodyLinkFrame*
+//   2  epoch    sender's session id, changes whenever the sender resets
+//   3  ackEpoch epoch of the peer session that ack/ackBits refer to
+//   4  seq      u16, per-datagram sequence number
+//   6  ack      u16, highest seq received from the peer
+//   8  ackBits  u32, bit n set = seq (ack - 1 - n) was received as well
+//   12 messages [len u8][len bytes], no CR/LF, until the end of the datagram
+//
+// A datagram with kBodyLinkFrameAckRequest is answered promptly (an ack-only
+// datagram if nothing else is going out), so every heartbeat and command
+// batch yields an RTT sample. Ack-only datagrams do not request acks and are
+// not counted towards loss. Negotiation and the fallback to text live in
+// BodyLinkWiFi.h.
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#define BODY_LINK_FRAME_MAGIC 0xB1
+#define BODY_LINK_FRAME_HEADER_BYTES 12
+#define BODY_LINK_FRAME_MAX_BYTES 256
+#define BODY_LINK_FRAME_MAX_MESSAGE 160     // same limit as a text line
+#define BODY_LINK_FRAME_WINDOW 32           // ackBits width and sent-history depth
+#define BODY_LINK_FRAME_COALESCE_MS 5
+
+enum
+{
+    kBodyLinkFrameHeartbeat = 0x01,
+    kBodyLinkFrameAckRequest = 0x02,
+    kBodyLinkFrameAckValid = 0x04
+};
+
+enum BodyLinkFrameResult
+{
+    kBodyLinkFrameAccepted,
+    kBodyLinkFrameDuplicate,
+    kBodyLinkFrameStale,
+    kBodyLinkFrameMalformed
+};
+
+struct BodyLinkFrameStats
+{
+    uint32_t txFrames;
+    uint32_t txMessages;
+    uint32_t rxFrames;
+    uint32_t rxMessages;
+    uint32_t rxDuplicates;
+    uint32_t rxOutOfOrder;
+    uint32_t rxStale;           // older than the window; dropped
+    uint32_t rxGaps;            // seq numbers skipped and not (yet) filled in
+    uint32_t rxMalformed;
+    uint32_t acked;             // tracked datagrams the peer acknowledged
+    uint32_t lost;              // tracked datagrams still unacked when their slot is reused
+    uint32_t rttLastMs;
+    uint32_t rttAvgMs;          // EWMA, 1/8 weight
+    uint32_t rttMaxMs;
+};
+
+struct BodyLinkFrameSent
+{
+    uint16_t seq;
+    uint32_t sentMs;
+    bool tracked;
+    bool acked;
+};
+
+struct BodyLinkFrameSession
+{
+    uint8_t txEpoch;
+    uint16_t txSeq;
+    uint8_t batch[BODY_LINK_FRAME_MAX_BYTES - BODY_LINK_FRAME_HEADER_BYTES];
+    uint16_t batchLen;
+    uint8_t batchMessages;
+    uint32_t batchStartMs;
+    bool heartbeatPending;
+    bool ackPending;
+    BodyLinkFrameSent sent[BODY_LINK_FRAME_WINDOW];
+
+    bool rxStarted;
+    uint8_t rxEpoch;
+    uint16_t rxHighest;
+    uint32_t rxBits;            // bit n set = seq (rxHighest - 1 - n) received
+
+    BodyLinkFrameStats stats;
+};
+
+typedef void (*BodyLinkFrameMessageFn)(const char *msg, void *ctx);
+
+// Starts a new session under a fresh epoch. Statistics are kept so they
+// survive a renegotiation.
+static void bodyLinkFrameReset(BodyLinkFrameSession &s, uint8_t epoch)
+{
+    BodyLinkFrameStats stats = s.stats;
+    memset(&s, 0, sizeof(s));
+    s.stats = stats;
+    s.txEpoch = epoch;
+}
+
+static inline bool bodyLinkFrameIsFramed(const uint8_t *data, size_t len)
+{
+    return len >= BODY_LINK_FRAME_HEADER_BYTES && data[0] == BODY_LINK_FRAME_MAGIC;
+}
+
+static inline void bodyLinkFramePut16(uint8_t *p, uint16_t v)
+{
+    p[0] = uint8_t(v);
+    p[1] = uint8_t(v >> 8);
+}
+
+static inline void bodyLinkFramePut32(uint8_t *p, uint32_t v)
+{
+    bodyLinkFramePut16(p, uint16_t(v));
+    bodyLinkFramePut16(p + 2, uint16_t(v >> 16));
+}
+
+static inline uint16_t bodyLinkFrameGet16(const uint8_t *p)
+{
+    return uint16_t(p[0] | (p[1] << 8));
+}
+
+static inline uint32_t bodyLinkFrameGet32(const uint8_t *p)
+{
+    return bodyLinkFrameGet16(p) | (uint32_t(bodyLinkFrameGet16(p + 2)) << 16);
+}
+
+// Adds one command to the pending batch. Trailing CR/LF is stripped. Returns
+// false when the command does not fit; the caller sends the batch and retries.
+static bool bodyLinkFrameQueue(BodyLinkFrameSession &s, const char *msg, uint32_t now)
+{
+    size_t len = strlen(msg);
+    while (len > 0 && (msg[len - 1] == '\r' || msg[len - 1] == '\n'))
+        len--;
+    if (len == 0)
+        return true;
+    if (len > BODY_LINK_FRAME_MAX_MESSAGE)
+        return false;
+    if (s.batchLen + 1 + len > sizeof(s.batch))
+        return false;
+    if (s.batchMessages == 0)
+        s.batchStartMs = now;
+    s.batch[s.batchLen++] = uint8_t(len);
+    memcpy(&s.batch[s.batchLen], msg, len);
+    s.batchLen += uint16_t(len);
+    s.batchMessages++;
+    return true;
+}
+
+// True when a datagram should go out now: a heartbeat or ack is owed, or the
+// oldest queued command has waited out the coalescing window.
+static bool bodyLinkFrameDue(const BodyLinkFrameSession &s, uint32_t now)
+{
+    if (s.heartbeatPending || s.ackPending)
+        return true;
+    return s.batchMessages > 0 && (now - s.batchStartMs) >= BODY_LINK_FRAME_COALESCE_MS;
+}
+
+// Writes the next datagram (pending batch, heartbeat flag, current acks) into
+// out and returns its length. out must hold BODY_LINK_FRAME_MAX_BYTES.
+static size_t bodyLinkFrameBuild(BodyLinkFrameSession &s, uint32_t now, uint8_t *out)
+{
+    uint8_t flags = 0;
+    if (s.heartbeatPending)
+        flags |= kBodyLinkFrameHeartbeat;
+    if (s.heartbeatPending || s.batchMessages > 0)
+        flags |= kBodyLinkFrameAckRequest;
+    if (s.rxStarted)
+        flags |= kBodyLinkFrameAckValid;
+
+    uint16_t seq = s.txSeq++;
+    out[0] = BODY_LINK_FRAME_MAGIC;
+    out[1] = flags;
+    out[2] = s.txEpoch;
+    out[3] = s.rxEpoch;
+    bodyLinkFramePut16(out + 4, seq);
+    bodyLinkFramePut16(out + 6, s.rxHighest);
+    bodyLinkFramePut32(out + 8, s.rxBits);
+    memcpy(out + BODY_LINK_FRAME_HEADER_BYTES, s.batch, s.batchLen);
+    size_t len = BODY_LINK_FRAME_HEADER_BYTES + s.batchLen;
+
+    BodyLinkFrameSent &slot = s.sent[seq % BODY_LINK_FRAME_WINDOW];
+    if (slot.tracked && !slot.acked)
+        s.stats.lost++;
+    slot.seq = seq;
+    slot.sentMs = now;
+    slot.tracked = (flags & kBodyLinkFrameAckRequest) != 0;
+    slot.acked = false;
+
+    s.stats.txFrames++;
+    s.stats.txMessages += s.batchMessages;
+    s.batchLen = 0;
+    s.batchMessages = 0;
+    s.heartbeatPending = false;
+    s.ackPending = false;
+    return len;
+}
+
+static void bodyLinkFrameAck(BodyLinkFrameSession &s, uint16_t seq, uint32_t now)
+{
+    BodyLinkFrameSent &slot = s.sent[seq % BODY_LINK_FRAME_WINDOW];
+    if (!slot.tracked || slot.acked || slot.seq != seq)
+        return;
+    slot.acked = true;
+    s.stats.acked++;
+    uint32_t rtt = now - slot.sentMs;
+    s.stats.rttLastMs = rtt;
+    s.stats.rttAvgMs = s.stats.acked == 1 ? rtt : (s.stats.rttAvgMs * 7 + rtt) / 8;
+    if (rtt > s.stats.rttMaxMs)
+        s.stats.rttMaxMs = rtt;
+}
+
+// Updates the receive window for seq. Duplicate and stale datagrams must not
+// be delivered; a new epoch means the peer restarted and opens a new window.
+static BodyLinkFrameResult bodyLinkFrameTrack(BodyLinkFrameSession &s, uint8_t epoch, uint16_t seq)
+{
+    if (!s.rxStarted || epoch != s.rxEpoch)
+    {
+        s.rxStarted = true;
+        s.rxEpoch = epoch;
+        s.rxHighest = seq;
+        s.rxBits = 0;
+        return kBodyLinkFrameAccepted;
+    }
+    int16_t diff = int16_t(uint16_t(seq - s.rxHighest));
+    if (diff > 0)
+    {
+        if (diff < BODY_LINK_FRAME_WINDOW)
+            s.rxBits = (s.rxBits << diff) | (1UL << (diff - 1));
+        else if (diff == BODY_LINK_FRAME_WINDOW)
+            s.rxBits = 1UL << (BODY_LINK_FRAME_WINDOW - 1);
+        else
+            s.rxBits = 0;
+        s.stats.rxGaps += uint32_t(diff - 1);
+        s.rxHighest = seq;
+        return kBodyLinkFrameAccepted;
+    }
+    if (diff == 0)
+        return kBodyLinkFrameDuplicate;
+    int n = -diff - 1;
+    if (n >= BODY_LINK_FRAME_WINDOW)
+        return kBodyLinkFrameStale;
+    uint32_t bit = 1UL << n;
+    if (s.rxBits & bit)
+        return kBodyLinkFrameDuplicate;
+    s.rxBits |= bit;
+    s.stats.rxOutOfOrder++;
+    if (s.stats.rxGaps > 0)
+        s.stats.rxGaps--;
+    return kBodyLinkFrameAccepted;
+}
+
+// Consumes one received datagram: applies its acks, runs duplicate/order
+// detection and hands each command to fn. heartbeat reports the flag.
+static BodyLinkFrameResult bodyLinkFrameReceive(BodyLinkFrameSession &s, const uint8_t *data, size_t len,
+                                                uint32_t now, BodyLinkFrameMessageFn fn, void *ctx,
+                                                bool &heartbeat)
+{
+    heartbeat = false;
+    if (!bodyLinkFrameIsFramed(data, len))
+    {
+        s.stats.rxMalformed++;
+        return kBodyLinkFrameMalformed;
+    }
+    for (size_t pos = BODY_LINK_FRAME_HEADER_BYTES; pos < len; pos += 1 + data[pos])
+    {
+        uint8_t msgLen = data[pos];
+        if (msgLen == 0 || msgLen > BODY_LINK_FRAME_MAX_MESSAGE || pos + 1 + msgLen > len)
+        {
+            s.stats.rxMalformed++;
+            return kBodyLinkFrameMalformed;
+        }
+    }
+
+    uint8_t flags = data[1];
+    if ((flags & kBodyLinkFrameAckValid) && data[3] == s.txEpoch)
+    {
+        uint16_t ack = bodyLinkFrameGet16(data + 6);
+        uint32_t bits = bodyLinkFrameGet32(data + 8);
+        bodyLinkFrameAck(s, ack, now);
+        for (int n = 0; n < BODY_LINK_FRAME_WINDOW; n++)
+        {
+            if (bits & (1UL << n))
+                bodyLinkFrameAck(s, uint16_t(ack - 1 - n), now);
+        }
+    }
+
+    BodyLinkFrameResult result = bodyLinkFrameTrack(s, data[2], bodyLinkFrameGet16(data + 4));
+    if (flags & kBodyLinkFrameAckRequest)
+        s.ackPending = true;            // re-ack duplicates too: the first ack may be what was lost
+    if (result == kBodyLinkFrameDuplicate)
+    {
+        s.stats.rxDuplicates++;
+        return result;
+    }
+    if (result == kBodyLinkFrameStale)
+    {
+        s.stats.rxStale++;
+        return result;
+    }
+
+    s.stats.rxFrames++;
+    heartbeat = (flags & kBodyLinkFrameHeartbeat) != 0;
+    char msg[BODY_LINK_FRAME_MAX_MESSAGE + 1];
+    for (size_t pos = BODY_LINK_FRAME_HEADER_BYTES; pos < len; pos += 1 + data[pos])
+    {
+        uint8_t msgLen = data[pos];
+        memcpy(msg, data + pos + 1, msgLen);
+        msg[msgLen] = '\0';
+        s.stats.rxMessages++;
+        if (fn)
+            fn(msg, ctx);
+    }
+    return result;
+}
+
+// Share of tracked datagrams the peer never acknowledged, in percent.
+static uint32_t bodyLinkFrameLossPercent(const BodyLinkFrameStats &stats)
+{
+    uint32_t total = stats.acked + stats.lost;
+    return total == 0 ? 0 : (stats.lost * 100 + total / 2) / total;
+}
@@ -0,0 +1,231 @@
+#pragma once
+// BodyLinkResolver.h — non-blocking mDNS discovery of the body controller.
+//
+// bodyLinkResolvePeer() used to call MDNS.queryHost("protoartoo") from
+// eventLoopTask, which blocks that task (and the asyncWebLoop() log and state
+// broadcasts it runs) for the whole query timeout every 10 s while the body is
+// absent. The resolver is a state machine stepped from the same task: it
+// starts an asynchronous query, polls it without waiting on later steps, and
+// moves on. A host (A record) query for "protoartoo" comes first; if it gets
+// no answer, a DNS-SD browse for _marcduino._udp looks for a protoartoo
+// instance. Failed rounds back off exponentially from
+// BODY_LINK_RESOLVER_BACKOFF_MIN_MS to _MAX_MS. Answers are cached for their
+// TTL (clamped), refreshed at 80 % of it, and reported as expired if the
+// refresh has not succeeded by the time the TTL runs out.
+//
+// The query itself goes through a BodyLinkResolverBackend table: the ESP-IDF
+// mdns_query_async_* API in BodyLinkWiFi.h, a scripted fake in the host test.
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#define BODY_LINK_RESOLVER_QUERY_MS 1000        // per query, enforced by the backend
+#define BODY_LINK_RESOLVER_GRACE_MS 500         // then the resolver gives up on it
+#define BODY_LINK_RESOLVER_BACKOFF_MIN_MS 2000
+#define BODY_LINK_RESOLVER_BACKOFF_MAX_MS 60000
+#define BODY_LINK_RESOLVER_TTL_DEFAULT_S 120    // when the answer carries none
+#define BODY_LINK_RESOLVER_TTL_MIN_S 10
+#define BODY_LINK_RESOLVER_TTL_MAX_S 3600
+
+enum BodyLinkResolveQuery
+{
+    kBodyLinkResolveHost,       // A record for the body's hostname
+    kBodyLinkResolveService     // DNS-SD browse, filtered on the hostname
+};
+
+enum BodyLinkResolvePoll
+{
+    kBodyLinkResolvePending,
+    kBodyLinkResolveFound,
+    kBodyLinkResolveNotFound
+};
+
+enum BodyLinkResolverState
+{
+    kBodyLinkResolverIdle,      // nothing cached, next round due at nextQueryMs
+    kBodyLinkResolverQuerying,
+    kBodyLinkResolverCached
+};
+
+enum BodyLinkResolverEvent
+{
+    kBodyLinkResolverNoEvent,
+    kBodyLinkResolverResolved,  // new or changed address in ipv4
+    kBodyLinkResolverExpired    // cached address ran out without a refresh
+};
+
+struct BodyLinkResolverAnswer
+{
+    uint32_t ipv4;              // lwIP byte order, 0 = none
+    uint32_t ttlSec;
+};
+
+struct BodyLinkResolverBackend
+{
+    bool (*start)(BodyLinkResolveQuery query, uint32_t timeoutMs);
+    BodyLinkResolvePoll (*poll)(BodyLinkResolverAnswer &answer);    // never blocks
+    void (*cancel)();
+};
+
+struct BodyLinkResolverStats
+{
+    uint32_t queries;
+    uint32_t answers;
+    uint32_t misses;            // rounds (host + service) without an answer
+    uint32_t timeouts;          // queries abandoned after the grace period
+    uint32_t refreshes;         // answers that renewed a cached address
+    uint32_t expiries;
+};
+
+struct BodyLinkResolver
+{
+    BodyLinkResolverState state;
+    BodyLinkResolveQuery query;
+    uint32_t queryStartMs;
+    uint32_t nextQueryMs;
+    uint32_t backoffMs;
+    uint32_t ipv4;
+    uint32_t resolvedMs;
+    uint32_t refreshMs;
+    uint32_t expiresMs;
+    bool refreshing;
+    BodyLinkResolverStats stats;
+};
+
+static inline void bodyLinkResolverReset(BodyLinkResolver &r)
+{
+    memset(&r, 0, sizeof(r));
+    r.state = kBodyLinkResolverIdle;
+}
+
+static inline bool bodyLinkResolverDue(uint32_t now, uint32_t at)
+{
+    return (int32_t)(now - at) >= 0;
+}
+
+static inline bool bodyLinkResolverStart(BodyLinkResolver &r, const BodyLinkResolverBackend &b,
+                                         BodyLinkResolveQuery query, uint32_t now)
+{
+    r.stats.queries++;
+    r.query = query;
+    r.queryStartMs = now;
+    if (!b.start(query, BODY_LINK_RESOLVER_QUERY_MS))
+        return false;
+    r.state = kBodyLinkResolverQuerying;
+    return true;
+}
+
+// A round (host query, then the service browse) ended without an answer.
+static inline BodyLinkResolverEvent bodyLinkResolverMiss(BodyLinkResolver &r, uint32_t now)
+{
+    r.stats.misses++;
+    r.backoffMs = r.backoffMs == 0 ? BODY_LINK_RESOLVER_BACKOFF_MIN_MS : r.backoffMs * 2;
+    if (r.backoffMs > BODY_LINK_RESOLVER_BACKOFF_MAX_MS)
+        r.backoffMs = BODY_LINK_RESOLVER_BACKOFF_MAX_MS;
+    r.nextQueryMs = now + r.backoffMs;
+    if (r.refreshing && !bodyLinkResolverDue(now, r.expiresMs))
+    {
+        // Keep serving the cached address; retry the refresh after the backoff
+        // unless that is past the expiry.
+        r.state = kBodyLinkResolverCached;
+        return kBodyLinkResolverNoEvent;
+    }
+    r.state = kBodyLinkResolverIdle;
+    r.refreshing = false;
+    if (r.ipv4 != 0)
+    {
+        r.ipv4 = 0;
+        r.stats.expiries++;
+        return kBodyLinkResolverExpired;
+    }
+    return kBodyLinkResolverNoEvent;
+}
+
+// Steps the resolver; call often from the task that owns it. `wanted` is
+// false while the peer is known some other way (manual IP, learned from
+// traffic) or WiFi is down; any query in flight is cancelled and nothing new
+// starts, but a cached answer still expires on time.
+static inline BodyLinkResolverEvent bodyLinkResolverStep(BodyLinkResolver &r, const BodyLinkResolverBackend &b,
+                                                         uint32_t now, bool wanted)
+{
+    if (r.state == kBodyLinkResolverQuerying)
+    {
+        if (!wanted)
+        {
+            b.cancel();
+            r.state = r.ipv4 != 0 ? kBodyLinkResolverCached : kBodyLinkResolverIdle;
+            return kBodyLinkResolverNoEvent;
+        }
+        BodyLinkResolverAnswer answer = { 0, 0 };
+        BodyLinkResolvePoll result = b.poll(answer);
+        if (result == kBodyLinkResolvePending)
+        {
+            if (now - r.queryStartMs < BODY_LINK_RESOLVER_QUERY_MS + BODY_LINK_RESOLVER_GRACE_MS)
+                return kBodyLinkResolverNoEvent;
+            b.cancel();
+            r.stats.timeouts++;
+            result = kBodyLinkResolveNotFound;
+        }
+        if (result == kBodyLinkResolveFound && answer.ipv4 != 0)
+        {
+            uint32_t ttl = answer.ttlSec == 0 ? BODY_LINK_RESOLVER_TTL_DEFAULT_S : answer.ttlSec;
+            if (ttl < BODY_LINK_RESOLVER_TTL_MIN_S)
+                ttl = BODY_LINK_RESOLVER_TTL_MIN_S;
+            if (ttl > BODY_LINK_RESOLVER_TTL_MAX_S)
+                ttl = BODY_LINK_RESOLVER_TTL_MAX_S;
+            bool changed = answer.ipv4 != r.ipv4;
+            if (r.refreshing)
+                r.stats.refreshes++;
+            r.stats.answers++;
+            r.ipv4 = answer.ipv4;
+            r.resolvedMs = now;
+            r.refreshMs = now + ttl * 800;
+            r.expiresMs = now + ttl * 1000;
+            r.backoffMs = 0;
+            r.refreshing = false;
+            r.state = kBodyLinkResolverCached;
+            return changed ? kBodyLinkResolverResolved : kBodyLinkResolverNoEvent;
+        }
+        if (r.query == kBodyLinkResolveHost && bodyLinkResolverStart(r, b, kBodyLinkResolveService, now))
+            return kBodyLinkResolverNoEvent;
+        return bodyLinkResolverMiss(r, now);
+    }
+
+    if (r.state == kBodyLinkResolverCached)
+    {
+        if (bodyLinkResolverDue(now, r.expiresMs))
+        {
+            r.state = kBodyLinkResolverIdle;
+            r.refreshing = false;
+            r.ipv4 = 0;
+            r.nextQueryMs = now;
+            r.stats.expiries++;
+            return kBodyLinkResolverExpired;
+        }
+        if (!wanted || !bodyLinkResolverDue(now, r.refreshMs) || !bodyLinkResolverDue(now, r.nextQueryMs))
+            return kBodyLinkResolverNoEvent;
+        r.refreshing = true;
+    }
+    else if (!wanted || !bodyLinkResolverDue(now, r.nextQueryMs))
+    {
+        return kBodyLinkResolverNoEvent;
+    }
+
+    if (!bodyLinkResolverStart(r, b, kBodyLinkResolveHost, now))
+        return bodyLinkResolverMiss(r, now);
+    return kBodyLinkResolverNoEvent;
+}
+
+static inline const char *bodyLinkResolverStateName(const BodyLinkResolver &r)
+{
+    switch (r.state)
+    {
+        case kBodyLinkResolverQuerying:
+            return r.query == kBodyLinkResolveHost ? "query_host" : "query_service";
+        case kBodyLinkResolverCached:
+            return r.refreshing ? "refreshing" : "cached";
+        default:
+            return r.backoffMs != 0 ? "backoff" : "idle";
+    }
+}
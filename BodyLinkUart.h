@@ -0,0 +1,291 @@
+#pragma once
+// BodyLinkUart.h — event-driven receive path and baud negotiation for the
+// body-link UART.
+//
+// handleBodySerial() used to poll Serial2 once per mainLoop() pass, so a long
+// loop pass (a sequence step, a filesystem write) left bytes sitting in the
+// driver and stamped heartbeats with the time the loop got round to them. The
+// firmware now feeds received bytes from the UART driver's event callback into
+// a BodyLinkUartReader: the frame detector splits them into CR/LF-terminated
+// lines as they arrive, timestamps each one, records #PAHB heartbeats
+// directly and parks every other line in a small frame ring. The loop task
+// pops frames and hands them to Marcduino ingress, which stays single-threaded.
+//
+// Lines longer than BODY_LINK_UART_FRAME_MAX and lines containing control or
+// non-ASCII bytes (what a baud mismatch or a noisy slip ring produces) are
+// dropped whole and counted instead of being admitted as a truncated command.
+//
+// BodyLinkUartBaud is the dome half of the optional speed-up: once the link is
+// up at the configured baud, the dome offers "#APBR<rate>" with its
+// heartbeats; a body that supports the rate answers "#PABR<rate>" and both
+// switch. A link that does not come back at the new rate within the heartbeat
+// timeout (or is lost later) reverts to the configured baud, and repeated
+// failures back off the offers. The ring lock is a portMUX on the ESP32 and a
+// no-op off it.
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#define BODY_LINK_UART_FRAME_MAX 64         // same limit as the old polled line buffer
+#define BODY_LINK_UART_RING_FRAMES 16       // twice the Marcduino ingress queue
+#define BODY_LINK_UART_OFFER_MS 5000        // between "#APBR" offers
+#define BODY_LINK_UART_BAUD_TIMEOUT_MS 5000 // matches kBodyLinkHeartbeatTimeoutMs
+#define BODY_LINK_UART_MAX_FAILURES 3       // stop offering until reboot after this many
+
+#ifndef BODY_LINK_UART_LOCK
+#define BODY_LINK_UART_LOCK()
+#define BODY_LINK_UART_UNLOCK()
+#endif
+
+struct BodyLinkUartFrame
+{
+    uint32_t rxMs;
+    uint8_t len;
+    char text[BODY_LINK_UART_FRAME_MAX + 1];
+};
+
+struct BodyLinkUartStats
+{
+    uint32_t rxBytes;
+    uint32_t frames;            // lines parked for ingress
+    uint32_t heartbeats;        // "#PAHB" lines, not parked
+    uint32_t overlong;          // lines over BODY_LINK_UART_FRAME_MAX, dropped
+    uint32_t garbage;           // lines with control/non-ASCII bytes, dropped
+    uint32_t ringOverflow;      // complete lines dropped because the ring was full
+    uint32_t ringPeak;
+    uint32_t frameErrors;       // reported by the UART driver
+    uint32_t parityErrors;
+    uint32_t fifoOverflows;
+    uint32_t bufferFull;
+    uint32_t breaks;
+};
+
+struct BodyLinkUartReader
+{
+    // Producer side (UART event task).
+    char line[BODY_LINK_UART_FRAME_MAX + 1];
+    uint8_t lineLen;
+    bool lineOverlong;
+    bool lineGarbage;
+    volatile uint32_t lastHeartbeatMs;
+
+    // Shared, under BODY_LINK_UART_LOCK.
+    BodyLinkUartFrame ring[BODY_LINK_UART_RING_FRAMES];
+    uint8_t head;
+    uint8_t count;
+
+    BodyLinkUartStats stats;
+};
+
+enum BodyLinkUartError
+{
+    kBodyLinkUartFrameError,
+    kBodyLinkUartParityError,
+    kBodyLinkUartFifoOverflow,
+    kBodyLinkUartBufferFull,
+    kBodyLinkUartBreak
+};
+
+static inline void bodyLinkUartReset(BodyLinkUartReader &r)
+{
+    memset(&r, 0, sizeof(r));
+}
+
+static inline void bodyLinkUartPark(BodyLinkUartReader &r, uint32_t now)
+{
+    BODY_LINK_UART_LOCK();
+    if (r.count >= BODY_LINK_UART_RING_FRAMES)
+    {
+        r.stats.ringOverflow++;
+        BODY_LINK_UART_UNLOCK();
+        return;
+    }
+    BodyLinkUartFrame &f = r.ring[(r.head + r.count) % BODY_LINK_UART_RING_FRAMES];
+    f.rxMs = now;
+    f.len = r.lineLen;
+    memcpy(f.text, r.line, r.lineLen + 1);
+    r.count++;
+    r.stats.frames++;
+    if (r.count > r.stats.ringPeak)
+        r.stats.ringPeak = r.count;
+    BODY_LINK_UART_UNLOCK();
+}
+
+static inline void bodyLinkUartEndLine(BodyLinkUartReader &r, uint32_t now)
+{
+    if (r.lineOverlong)
+        r.stats.overlong++;
+    else if (r.lineGarbage)
+        r.stats.garbage++;
+    else if (r.lineLen > 0)
+    {
+        r.line[r.lineLen] = '\0';
+        if (strcmp(r.line, "#PAHB") == 0)
+        {
+            r.lastHeartbeatMs = now;
+            r.stats.heartbeats++;
+        }
+        else
+        {
+            bodyLinkUartPark(r, now);
+        }
+    }
+    r.lineLen = 0;
+    r.lineOverlong = false;
+    r.lineGarbage = false;
+}
+
+// Producer: called from the UART event callback (or the polling fallback)
+// with whatever the driver has buffered.
+static inline void bodyLinkUartFeed(BodyLinkUartReader &r, const uint8_t *data, size_t len, uint32_t now)
+{
+    r.stats.rxBytes += len;
+    for (size_t i = 0; i < len; i++)
+    {
+        uint8_t c = data[i];
+        if (c == '\r' || c == '\n')
+        {
+            bodyLinkUartEndLine(r, now);
+            continue;
+        }
+        if (r.lineOverlong)
+            continue;
+        if (r.lineLen >= BODY_LINK_UART_FRAME_MAX)
+        {
+            r.lineOverlong = true;
+            continue;
+        }
+        if (c < 0x20 || c > 0x7E)
+            r.lineGarbage = true;
+        r.line[r.lineLen++] = (char)c;
+    }
+}
+
+static inline void bodyLinkUartNoteError(BodyLinkUartReader &r, BodyLinkUartError error)
+{
+    switch (error)
+    {
+        case kBodyLinkUartFrameError: r.stats.frameErrors++; break;
+        case kBodyLinkUartParityError: r.stats.parityErrors++; break;
+        case kBodyLinkUartFifoOverflow: r.stats.fifoOverflows++; break;
+        case kBodyLinkUartBufferFull: r.stats.bufferFull++; break;
+        case kBodyLinkUartBreak: r.stats.breaks++; break;
+    }
+    // Whatever was in flight when the driver lost bytes is not trustworthy.
+    if (r.lineLen > 0)
+        r.lineGarbage = true;
+}
+
+// Consumer: called on the loop task.
+static inline bool bodyLinkUartPop(BodyLinkUartReader &r, BodyLinkUartFrame &out)
+{
+    BODY_LINK_UART_LOCK();
+    if (r.count == 0)
+    {
+        BODY_LINK_UART_UNLOCK();
+        return false;
+    }
+    out = r.ring[r.head];
+    r.head = (r.head + 1) % BODY_LINK_UART_RING_FRAMES;
+    r.count--;
+    BODY_LINK_UART_UNLOCK();
+    return true;
+}
+
+// ---------------------------------------------------------------------------
+// Baud negotiation (dome side)
+
+enum BodyLinkUartBaudState
+{
+    kBodyLinkBaudBase,          // at the configured rate, may offer
+    kBodyLinkBaudProbation,     // switched, waiting for the first heartbeat
+    kBodyLinkBaudActive         // switched and confirmed
+};
+
+struct BodyLinkUartBaud
+{
+    uint32_t baseBaud;
+    uint32_t targetBaud;        // 0 or <= baseBaud: negotiation disabled
+    uint32_t currentBaud;
+    BodyLinkUartBaudState state;
+    uint32_t stateSinceMs;
+    uint32_t nextOfferMs;
+    uint8_t failures;
+    uint32_t offers;
+    uint32_t negotiations;
+    uint32_t reverts;
+};
+
+static inline void bodyLinkUartBaudInit(BodyLinkUartBaud &b, uint32_t baseBaud, uint32_t targetBaud)
+{
+    memset(&b, 0, sizeof(b));
+    b.baseBaud = baseBaud;
+    b.targetBaud = targetBaud > baseBaud ? targetBaud : 0;
+    b.currentBaud = baseBaud;
+    b.state = kBodyLinkBaudBase;
+}
+
+// True when the next UART heartbeat should carry "#APBR<targetBaud>".
+static inline bool bodyLinkUartBaudOfferDue(BodyLinkUartBaud &b, uint32_t now, bool linkUp)
+{
+    if (b.targetBaud == 0 || b.state != kBodyLinkBaudBase || !linkUp ||
+        b.failures >= BODY_LINK_UART_MAX_FAILURES)
+        return false;
+    if ((int32_t)(now - b.nextOfferMs) < 0)
+        return false;
+    b.nextOfferMs = now + BODY_LINK_UART_OFFER_MS;
+    b.offers++;
+    return true;
+}
+
+// The body answered "#PABR<rate>". Returns the rate to switch to, or 0.
+static inline uint32_t bodyLinkUartBaudAccept(BodyLinkUartBaud &b, uint32_t rate, uint32_t now)
+{
+    if (b.targetBaud == 0 || rate != b.targetBaud || b.state != kBodyLinkBaudBase)
+        return 0;
+    b.currentBaud = rate;
+    b.state = kBodyLinkBaudProbation;
+    b.stateSinceMs = now;
+    return rate;
+}
+
+// Called with the latest heartbeat time. Returns the rate to switch back to,
+// or 0 when nothing changes.
+static inline uint32_t bodyLinkUartBaudPoll(BodyLinkUartBaud &b, uint32_t now, uint32_t lastHeartbeatMs)
+{
+    if (b.state == kBodyLinkBaudBase)
+        return 0;
+    bool heardSinceSwitch = lastHeartbeatMs != 0 && (int32_t)(lastHeartbeatMs - b.stateSinceMs) > 0;
+    if (b.state == kBodyLinkBaudProbation && heardSinceSwitch)
+    {
+        b.state = kBodyLinkBaudActive;
+        b.negotiations++;
+        b.failures = 0;
+        return 0;
+    }
+    uint32_t since = heardSinceSwitch ? lastHeartbeatMs : b.stateSinceMs;
+    // Signed: the heartbeat is stamped on another task and can be a tick
+    // ahead of the caller's now.
+    if ((int32_t)(now - since) < (int32_t)BODY_LINK_UART_BAUD_TIMEOUT_MS)
+        return 0;
+    if (b.state == kBodyLinkBaudProbation)
+        b.failures++;
+    b.reverts++;
+    b.state = kBodyLinkBaudBase;
+    b.stateSinceMs = now;
+    b.currentBaud = b.baseBaud;
+    // Back off: 5 s, 10 s, 20 s between offers after consecutive failures.
+    b.nextOfferMs = now + (BODY_LINK_UART_OFFER_MS << b.failures);
+    return b.baseBaud;
+}
+
+static inline const char *bodyLinkUartBaudStateName(BodyLinkUartBaudState state)
+{
+    switch (state)
+    {
+        case kBodyLinkBaudProbation: return "probation";
+        case kBodyLinkBaudActive: return "active";
+        default: return "base";
+    }
+}
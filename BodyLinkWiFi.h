@@ -4,8 +4,16 @@
 #include <WiFiUdp.h>
 #ifdef USE_MDNS
 #include <ESPmDNS.h>
+#include <mdns.h>
 #endif
 
+#include "BodyLinkFrame.h"
+static portMUX_TYPE sBodyFailoverMux = portMUX_INITIALIZER_UNLOCKED;
+#define BODY_LINK_FAILOVER_LOCK() portENTER_CRITICAL(&sBodyFailoverMux)
+#define BODY_LINK_FAILOVER_UNLOCK() portEXIT_CRITICAL(&sBodyFailoverMux)
+#include "BodyLinkFailover.h"
+#include "BodyLinkResolver.h"
+
 enum BodyLinkTransport
 {
     BODY_LINK_UART,
@@ -22,9 +30,9 @@ enum BodyLinkPeerSource
 };
 
 static const uint16_t kBodyLinkUdpPort = 4901;
-static const uint16_t kBodyLinkRxBufLen = 64;
+static const uint16_t kBodyLinkRxBufLen = 160; // fits a full-length DT: text command
 static const uint32_t kBodyLinkHeartbeatTimeoutMs = 5000;
-static const uint32_t kBodyLinkMdnResolveCooldownMs = 10000;
+static const uint8_t kBodyLinkFrameOfferEvery = 5; // heartbeats between "#APFR1" offers
 
 static WiFiUDP sBodyUdp;
 static bool sBodyWiFiEnabled = true;
@@ -33,10 +41,45 @@ static bool sBodyMdnsStarted = false;
 static uint32_t sBodyLastSeenUartMs = 0;
 static uint32_t sBodyLastSeenWifiMs = 0;
 static uint32_t sBodyWifiHeartbeatRx = 0;
-static uint32_t sBodyLastMdnsResolveMs = 0;
+static BodyLinkResolver sBodyResolver;
 static IPAddress sBodyPeerIp(0, 0, 0, 0);
 static BodyLinkPeerSource sBodyPeerSource = BODY_LINK_PEER_NONE;
 
+// Framed UDP protocol (BodyLinkFrame.h). While not negotiated, every
+// kBodyLinkFrameOfferEvery-th text heartbeat carries a "#APFR1" line, which
+// older body firmware counts as an unknown message and ignores. A body that
+// speaks v1 answers with "#PAFR1" or simply starts sending framed datagrams.
+// Back to text when framed traffic stops for the heartbeat timeout or the
+// body sends a text "#PAHB" again (e.g. after a reflash).
+static bool sBodyFrameEnabled = false;
+static bool sBodyFramed = false;
+static uint32_t sBodyFrameLastRxMs = 0;
+static uint8_t sBodyFrameOfferCountdown = 0;
+static uint32_t sBodyFrameNegotiations = 0;
+static uint32_t sBodyFrameFallbacks = 0;
+static BodyLinkFrameSession sBodyFrame;
+
+// sBodyFrame and sBodyUdp belong to the loop task (bodyLinkWiFiRx/Flush).
+// bodyLinkWiFiSendUDP() is also reached from the web task (sleep/wake,
+// immediate commands), so sends from any other task are parked here and go
+// out from bodyLinkWiFiFlush() on the next loop pass.
+#define BODY_LINK_TX_PARK_SLOTS 8
+static portMUX_TYPE sBodyTxParkMux = portMUX_INITIALIZER_UNLOCKED;
+static char sBodyTxPark[BODY_LINK_TX_PARK_SLOTS][kBodyLinkRxBufLen + 1];
+static uint8_t sBodyTxParkHead = 0;
+static uint8_t sBodyTxParkCount = 0;
+static TaskHandle_t sBodyLinkLoopTask = nullptr;
+
+// Transport selection (BodyLinkFailover.h). Fed from the mark functions below
+// and re-evaluated by bodyLinkFailoverPoll() in the sketch.
+static BodyLinkFailover bodyLinkFailoverMake()
+{
+    BodyLinkFailover f;
+    bodyLinkFailoverReset(f);
+    return f;
+}
+static BodyLinkFailover sBodyFailover = bodyLinkFailoverMake();
+
 static void marcduinoIngressAdmit(const MarcduinoIngressSource &source, const char *cmd);
 
 static bool bodyLinkIpKnown(const IPAddress &ip)
@@ -87,6 +130,7 @@ static void bodyLinkSetPeer(const IPAddress &ip, BodyLinkPeerSource source)
 static void bodyLinkMarkUartActivity(uint32_t now)
 {
     sBodyLastSeenMs = now;
+    bodyLinkFailoverNoteRx(sBodyFailover, kBodyLinkPathUart, now, false);
 }
 
 static void bodyLinkMarkUartHeartbeat(uint32_t now)
@@ -94,11 +138,13 @@ static void bodyLinkMarkUartHeartbeat(uint32_t now)
     sBodyLastSeenMs = now;
     sBodyLastSeenUartMs = now;
     sBodyHeartbeatRx++;
+    bodyLinkFailoverNoteRx(sBodyFailover, kBodyLinkPathUart, now, true);
 }
 
 static void bodyLinkMarkWifiActivity(uint32_t now)
 {
     sBodyLastSeenMs = now;
+    bodyLinkFailoverNoteRx(sBodyFailover, kBodyLinkPathWifi, now, false);
 }
 
 static void bodyLinkMarkWifiHeartbeat(uint32_t now)
@@ -107,21 +153,12 @@ static void bodyLinkMarkWifiHeartbeat(uint32_t now)
     sBodyLastSeenWifiMs = now;
     sBodyHeartbeatRx++;
     sBodyWifiHeartbeatRx++;
+    bodyLinkFailoverNoteRx(sBodyFailover, kBodyLinkPathWifi, now, true);
 }
 
 static bool bodyLinkReadManualPeer()
 {
-    if (!preferences.isKey(PREFERENCE_BODY_PEER_IP))
-    {
-        if (bodyLinkHasManualPeer())
-        {
-            sBodyPeerIp = IPAddress(0, 0, 0, 0);
-            sBodyPeerSource = BODY_LINK_PEER_NONE;
-        }
-        return false;
-    }
-
-    String manualIp = preferences.getString(PREFERENCE_BODY_PEER_IP, "");
+    String manualIp = configGetString(kCfgBodyPeerIp);
     manualIp.trim();
     if (manualIp.length() == 0)
     {
@@ -147,10 +184,11 @@ static bool bodyLinkReadManualPeer()
 
 static void bodyLinkWiFiInit()
 {
-    if (!preferences.getBool(PREFERENCE_BODY_LINK_ENABLED, BODY_LINK_ENABLED))
+    if (!configGetBool(kCfgBodyLinkEnabled))
         return;
 
-    sBodyWiFiEnabled = preferences.getBool(PREFERENCE_BODY_WIFI_ENABLED, BODY_WIFI_ENABLED);
+    sBodyWiFiEnabled = configGetBool(kCfgBodyWifiEnabled);
+    sBodyFrameEnabled = configGetBool(kCfgBodyFramed);
     if (!sBodyWiFiEnabled)
     {
         DEBUG_PRINTLN(F("[BodyLink] WiFi fallback disabled by preference"));
@@ -191,40 +229,198 @@ static void bodyLinkSetupMDNS()
         DEBUG_PRINTLN(F("[BodyLink] mDNS hostname: astropixelsplus"));
     }
 
-    if (!preferences.getBool(PREFERENCE_BODY_LINK_ENABLED, BODY_LINK_ENABLED))
+    if (!configGetBool(kCfgBodyLinkEnabled))
         return;
 
     MDNS.addService("marcduino", "udp", kBodyLinkUdpPort);
 #endif
 }
 
+#ifdef USE_MDNS
+// BodyLinkResolver backend on the ESP-IDF async query API. The ESPmDNS
+// queryHost() wrapper waits out the whole timeout on the calling task;
+// these calls return at once and the query runs in the mDNS task.
+static mdns_search_once_t *sBodyMdnsSearch = nullptr;
+static BodyLinkResolveQuery sBodyMdnsQuery = kBodyLinkResolveHost;
+
+static void bodyLinkMdnsCancel()
+{
+    if (sBodyMdnsSearch == nullptr)
+        return;
+    mdns_query_async_delete(sBodyMdnsSearch);
+    sBodyMdnsSearch = nullptr;
+}
+
+static bool bodyLinkMdnsStart(BodyLinkResolveQuery query, uint32_t timeoutMs)
+{
+    bodyLinkMdnsCancel();
+    sBodyMdnsQuery = query;
+    if (query == kBodyLinkResolveHost)
+        sBodyMdnsSearch = mdns_query_async_new("protoartoo", NULL, NULL, MDNS_TYPE_A, timeoutMs, 1);
+    else
+        sBodyMdnsSearch = mdns_query_async_new(NULL, "_marcduino", "_udp", MDNS_TYPE_PTR, timeoutMs, 4);
+    return sBodyMdnsSearch != nullptr;
+}
+
+static BodyLinkResolvePoll bodyLinkMdnsPoll(BodyLinkResolverAnswer &answer)
+{
+    if (sBodyMdnsSearch == nullptr)
+        return kBodyLinkResolveNotFound;
+    mdns_result_t *results = nullptr;
+    if (!mdns_query_async_get_results(sBodyMdnsSearch, 0, &results))
+        return kBodyLinkResolvePending;
+
+    BodyLinkResolvePoll found = kBodyLinkResolveNotFound;
+    for (mdns_result_t *r = results; r != nullptr && found == kBodyLinkResolveNotFound; r = r->next)
+    {
+        // Other droids may advertise _marcduino._udp too.
+        if (sBodyMdnsQuery == kBodyLinkResolveService &&
+            (r->hostname == nullptr || strncasecmp(r->hostname, "protoartoo", 10) != 0))
+            continue;
+        for (mdns_ip_addr_t *a = r->addr; a != nullptr; a = a->next)
+        {
+            if (a->addr.type != ESP_IPADDR_TYPE_V4)
+                continue;
+            answer.ipv4 = a->addr.u_addr.ip4.addr;
+            answer.ttlSec = r->ttl;
+            found = kBodyLinkResolveFound;
+            break;
+        }
+    }
+    if (results != nullptr)
+        mdns_query_results_free(results);
+    bodyLinkMdnsCancel();
+    return found;
+}
+
+static const BodyLinkResolverBackend kBodyLinkMdnsBackend = {
+    bodyLinkMdnsStart,
+    bodyLinkMdnsPoll,
+    bodyLinkMdnsCancel
+};
+#endif
+
+// Steps the resolver from eventLoopTask; never waits on the network.
 static void bodyLinkResolvePeer()
 {
 #ifdef USE_MDNS
-    if (!sBodyWiFiEnabled || !wifiActive)
+    if (!sBodyMdnsStarted)
         return;
-    if (!sBodyUdpBound)
+    bool wanted = sBodyWiFiEnabled && wifiActive && sBodyUdpBound && !bodyLinkHasManualPeer() &&
+                  sBodyPeerSource != BODY_LINK_PEER_RX;
+    switch (bodyLinkResolverStep(sBodyResolver, kBodyLinkMdnsBackend, millis(), wanted))
+    {
+    case kBodyLinkResolverResolved:
+        bodyLinkSetPeer(IPAddress(sBodyResolver.ipv4), BODY_LINK_PEER_MDNS);
+        break;
+    case kBodyLinkResolverExpired:
+        if (sBodyPeerSource == BODY_LINK_PEER_MDNS)
+        {
+            DEBUG_PRINTLN(F("[BodyLink] mDNS peer expired"));
+            sBodyPeerIp = IPAddress(0, 0, 0, 0);
+            sBodyPeerSource = BODY_LINK_PEER_NONE;
+        }
+        break;
+    default:
+        break;
+    }
+#endif
+}
+
+static bool bodyLinkFramedSend(uint32_t now)
+{
+    uint8_t datagram[BODY_LINK_FRAME_MAX_BYTES];
+    size_t len = bodyLinkFrameBuild(sBodyFrame, now, datagram);
+    if (!sBodyUdp.beginPacket(sBodyPeerIp, kBodyLinkUdpPort))
+        return false;
+    sBodyUdp.write(datagram, len);
+    return sBodyUdp.endPacket() == 1;
+}
+
+static void bodyLinkFramedEnter(uint32_t now)
+{
+    if (sBodyFramed)
         return;
-    if (bodyLinkHasManualPeer())
+    bodyLinkFrameReset(sBodyFrame, uint8_t(esp_random()));
+    sBodyFramed = true;
+    sBodyFrameLastRxMs = now;
+    sBodyFrameNegotiations++;
+    DEBUG_PRINTLN(F("[BodyLink] Framed UDP protocol v1 negotiated"));
+}
+
+static void bodyLinkFramedLeave(const char *reason)
+{
+    if (!sBodyFramed)
         return;
-    if (sBodyPeerSource == BODY_LINK_PEER_RX)
+    sBodyFramed = false;
+    sBodyFrameFallbacks++;
+    sBodyFrameOfferCountdown = kBodyLinkFrameOfferEvery;
+    DEBUG_PRINT(F("[BodyLink] Framed UDP protocol dropped ("));
+    DEBUG_PRINT(reason);
+    DEBUG_PRINTLN(F("); back to text"));
+
+    // Commands still waiting for the coalescing window go out as text lines.
+    if (sBodyFrame.batchMessages == 0 || !bodyLinkIpKnown(sBodyPeerIp))
         return;
-
-    uint32_t now = millis();
-    if (sBodyLastMdnsResolveMs != 0 && (now - sBodyLastMdnsResolveMs) < kBodyLinkMdnResolveCooldownMs)
+    if (!sBodyUdp.beginPacket(sBodyPeerIp, kBodyLinkUdpPort))
         return;
+    for (uint16_t pos = 0; pos < sBodyFrame.batchLen; pos += 1 + sBodyFrame.batch[pos])
+    {
+        sBodyUdp.write(&sBodyFrame.batch[pos + 1], sBodyFrame.batch[pos]);
+        sBodyUdp.write('\r');
+    }
+    sBodyUdp.endPacket();
+    sBodyFrame.batchLen = 0;
+    sBodyFrame.batchMessages = 0;
+}
 
-    sBodyLastMdnsResolveMs = now;
-    IPAddress ip = MDNS.queryHost("protoartoo");
-    if (bodyLinkIpKnown(ip))
+static bool bodyLinkTxPark(const char *payload)
+{
+    size_t len = strlen(payload);
+    if (len > kBodyLinkRxBufLen)
+        return false;
+    bool parked = false;
+    portENTER_CRITICAL(&sBodyTxParkMux);
+    if (sBodyTxParkCount < BODY_LINK_TX_PARK_SLOTS)
     {
-        bodyLinkSetPeer(ip, BODY_LINK_PEER_MDNS);
+        uint8_t slot = (sBodyTxParkHead + sBodyTxParkCount) % BODY_LINK_TX_PARK_SLOTS;
+        memcpy(sBodyTxPark[slot], payload, len + 1);
+        sBodyTxParkCount++;
+        parked = true;
     }
-#endif
+    portEXIT_CRITICAL(&sBodyTxParkMux);
+    if (!parked)
+        DEBUG_PRINTLN(F("[BodyLink] UDP send queue full; dropping command"));
+    return parked;
+}
+
+static bool bodyLinkTxUnpark(char *out)
+{
+    bool have = false;
+    portENTER_CRITICAL(&sBodyTxParkMux);
+    if (sBodyTxParkCount > 0)
+    {
+        memcpy(out, sBodyTxPark[sBodyTxParkHead], kBodyLinkRxBufLen + 1);
+        sBodyTxParkHead = (sBodyTxParkHead + 1) % BODY_LINK_TX_PARK_SLOTS;
+        sBodyTxParkCount--;
+        have = true;
+    }
+    portEXIT_CRITICAL(&sBodyTxParkMux);
+    return have;
+}
+
+static bool bodyLinkWiFiSendUDP(const char *payload);
+
+static void bodyLinkFramedDeliver(const char *msg, void *ctx)
+{
+    (void)ctx;
+    bodyLinkMarkWifiActivity(millis());
+    marcduinoIngressAdmit(kMarcduinoIngressBodyLinkWifi, msg);
 }
 
 static void bodyLinkWiFiRx()
 {
+    sBodyLinkLoopTask = xTaskGetCurrentTaskHandle();
     if (!sBodyWiFiEnabled || !sBodyUdpBound)
         return;
 
@@ -240,8 +436,8 @@ static void bodyLinkWiFiRx()
             bodyLinkSetPeer(remote, BODY_LINK_PEER_RX);
         }
 
-        char packetBuf[kBodyLinkRxBufLen + 1];
-        int readLen = sBodyUdp.read(packetBuf, kBodyLinkRxBufLen);
+        char packetBuf[BODY_LINK_FRAME_MAX_BYTES + 1];
+        int readLen = sBodyUdp.read(packetBuf, BODY_LINK_FRAME_MAX_BYTES);
         if (readLen < 0)
             continue;
         packetBuf[readLen] = '\0';
@@ -251,6 +447,22 @@ static void bodyLinkWiFiRx()
             sBodyUdp.read();
         }
 
+        if (bodyLinkFrameIsFramed((const uint8_t *)packetBuf, readLen))
+        {
+            if (!sBodyFrameEnabled)
+                continue;
+            uint32_t now = millis();
+            bodyLinkFramedEnter(now);
+            bool heartbeat = false;
+            BodyLinkFrameResult result = bodyLinkFrameReceive(sBodyFrame, (const uint8_t *)packetBuf, readLen,
+                                                              now, bodyLinkFramedDeliver, nullptr, heartbeat);
+            if (result != kBodyLinkFrameMalformed)
+                sBodyFrameLastRxMs = now;
+            if (heartbeat)
+                bodyLinkMarkWifiHeartbeat(now);
+            continue;
+        }
+
         char lineBuf[kBodyLinkRxBufLen + 1];
         uint8_t lineLen = 0;
         for (int i = 0; i <= readLen; i++)
@@ -266,8 +478,14 @@ static void bodyLinkWiFiRx()
                 uint32_t now = millis();
                 if (strcmp(lineBuf, "#PAHB") == 0)
                 {
+                    bodyLinkFramedLeave("peer sent text heartbeat");
                     bodyLinkMarkWifiHeartbeat(now);
                 }
+                else if (strcmp(lineBuf, "#PAFR1") == 0)
+                {
+                    if (sBodyFrameEnabled)
+                        bodyLinkFramedEnter(now);
+                }
                 else
                 {
                     bodyLinkMarkWifiActivity(now);
@@ -289,12 +507,46 @@ static void bodyLinkWiFiRx()
     }
 }
 
+// Sends what other tasks parked, then the framed datagram that is due (acks
+// owed, coalescing window over), and falls back to text when framed traffic
+// from the body has stopped.
+static void bodyLinkWiFiFlush()
+{
+    char parked[kBodyLinkRxBufLen + 1];
+    while (bodyLinkTxUnpark(parked))
+        bodyLinkWiFiSendUDP(parked);
+
+    if (!sBodyFramed)
+        return;
+    uint32_t now = millis();
+    if (now - sBodyFrameLastRxMs >= kBodyLinkHeartbeatTimeoutMs)
+    {
+        bodyLinkFramedLeave("no framed traffic");
+        return;
+    }
+    if (bodyLinkIpKnown(sBodyPeerIp) && bodyLinkFrameDue(sBodyFrame, now))
+        bodyLinkFramedSend(now);
+}
+
 static bool bodyLinkWiFiSendUDP(const char *payload)
 {
     if (!sBodyWiFiEnabled || !sBodyUdpBound || payload == nullptr || payload[0] == '\0')
         return false;
     if (!bodyLinkIpKnown(sBodyPeerIp))
         return false;
+    if (sBodyLinkLoopTask != nullptr && xTaskGetCurrentTaskHandle() != sBodyLinkLoopTask)
+        return bodyLinkTxPark(payload);
+
+    if (sBodyFramed)
+    {
+        // Coalesced with whatever else is sent within BODY_LINK_FRAME_COALESCE_MS;
+        // bodyLinkWiFiFlush() sends the batch.
+        uint32_t now = millis();
+        if (bodyLinkFrameQueue(sBodyFrame, payload, now))
+            return true;
+        bodyLinkFramedSend(now);
+        return bodyLinkFrameQueue(sBodyFrame, payload, now);
+    }
 
     size_t len = strlen(payload);
     bool hasTerminator = (len > 0 && (payload[len - 1] == '\r' || payload[len - 1] == '\n'));
@@ -309,19 +561,51 @@ static bool bodyLinkWiFiSendUDP(const char *payload)
     return sBodyUdp.endPacket() == 1;
 }
 
+// Dome heartbeat over UDP: a framed heartbeat once negotiated (it also
+// carries any queued commands), otherwise "#APHB" plus the periodic offer.
+static bool bodyLinkWiFiSendHeartbeat()
+{
+    if (!sBodyWiFiEnabled || !sBodyUdpBound || !bodyLinkIpKnown(sBodyPeerIp))
+        return false;
+    if (sBodyFramed)
+    {
+        sBodyFrame.heartbeatPending = true;
+        return bodyLinkFramedSend(millis());
+    }
+    bool offer = false;
+    if (sBodyFrameEnabled)
+    {
+        if (sBodyFrameOfferCountdown == 0)
+        {
+            offer = true;
+            sBodyFrameOfferCountdown = kBodyLinkFrameOfferEvery;
+        }
+        sBodyFrameOfferCountdown--;
+    }
+    return bodyLinkWiFiSendUDP(offer ? "#APHB\r#APFR1" : "#APHB");
+}
+
+static bool bodyLinkWifiUsable()
+{
+    return sBodyWiFiEnabled && wifiActive && bodyLinkIpKnown(sBodyPeerIp);
+}
+
+// The path chosen by the last bodyLinkFailoverPoll(); cheap enough for the
+// web task.
 static BodyLinkTransport bodyLinkActiveTransport()
 {
-    if (!preferences.getBool(PREFERENCE_BODY_LINK_ENABLED, BODY_LINK_ENABLED))
+    if (!configGetBool(kCfgBodyLinkEnabled))
         return BODY_LINK_DISCONNECTED;
 
-    uint32_t now = millis();
-    if (sBodyLastSeenUartMs > 0 && (now - sBodyLastSeenUartMs) < kBodyLinkHeartbeatTimeoutMs)
+    switch (sBodyFailover.active)
+    {
+    case kBodyLinkPathUart:
         return BODY_LINK_UART;
-
-    if (sBodyWiFiEnabled && wifiActive && bodyLinkIpKnown(sBodyPeerIp))
+    case kBodyLinkPathWifi:
         return BODY_LINK_WIFI;
-
-    return BODY_LINK_DISCONNECTED;
+    default:
+        return BODY_LINK_DISCONNECTED;
+    }
 }
 
 static const char *bodyLinkGetTransportName()
@@ -359,6 +643,79 @@ static uint32_t bodyLinkUartHeartbeatAgeMs()
     return millis() - sBodyLastSeenUartMs;
 }
 
+static String bodyLinkFramingBuildJson()
+{
+    const BodyLinkFrameStats &st = sBodyFrame.stats;
+    String json = "{\"enabled\":" + String(sBodyFrameEnabled ? "true" : "false");
+    json += ",\"active\":" + String(sBodyFramed ? "true" : "false");
+    json += ",\"negotiations\":" + String(sBodyFrameNegotiations);
+    json += ",\"fallbacks\":" + String(sBodyFrameFallbacks);
+    json += ",\"tx_frames\":" + String(st.txFrames);
+    json += ",\"tx_msgs\":" + String(st.txMessages);
+    json += ",\"rx_frames\":" + String(st.rxFrames);
+    json += ",\"rx_msgs\":" + String(st.rxMessages);
+    json += ",\"duplicates\":" + String(st.rxDuplicates);
+    json += ",\"out_of_order\":" + String(st.rxOutOfOrder);
+    json += ",\"stale\":" + String(st.rxStale);
+    json += ",\"rx_gaps\":" + String(st.rxGaps);
+    json += ",\"malformed\":" + String(st.rxMalformed);
+    json += ",\"acked\":" + String(st.acked);
+    json += ",\"lost\":" + String(st.lost);
+    json += ",\"loss_pct\":" + String(bodyLinkFrameLossPercent(st));
+    json += ",\"rtt_ms\":" + String(st.rttLastMs);
+    json += ",\"rtt_avg_ms\":" + String(st.rttAvgMs);
+    json += ",\"rtt_max_ms\":" + String(st.rttMaxMs) + "}";
+    return json;
+}
+
+static String bodyLinkFailoverBuildJson()
+{
+    const BodyLinkFailoverStats &st = sBodyFailover.stats;
+    const BodyLinkPathState &uart = sBodyFailover.path[kBodyLinkPathUart];
+    const BodyLinkPathState &wifi = sBodyFailover.path[kBodyLinkPathWifi];
+    String json = "{\"uart_hb_interval_ms\":" + String(uart.intervalMs);
+    json += ",\"uart_deadline_ms\":" + String(bodyLinkFailoverDeadlineMs(uart));
+    json += ",\"wifi_hb_interval_ms\":" + String(wifi.intervalMs);
+    json += ",\"wifi_deadline_ms\":" + String(bodyLinkFailoverDeadlineMs(wifi));
+    json += ",\"failovers\":" + String(st.failovers);
+    json += ",\"failbacks\":" + String(st.failbacks);
+    json += ",\"last_detect_ms\":" + String(st.lastDetectMs);
+    json += ",\"avg_detect_ms\":" + String(bodyLinkFailoverAvgDetectMs(st));
+    json += ",\"max_detect_ms\":" + String(st.maxDetectMs);
+    json += ",\"last_recovery_ms\":" + String(st.lastRecoveryMs);
+    json += ",\"max_recovery_ms\":" + String(st.maxRecoveryMs);
+    json += ",\"replayed\":" + String(st.replayed);
+    json += ",\"replay_expired\":" + String(st.replayExpired);
+    json += ",\"unbuffered\":" + String(st.unbuffered);
+    json += ",\"hb_tx\":" + String(st.heartbeatsTx);
+    json += ",\"cmd_tx\":" + String(st.commandsTx) + "}";
+    return json;
+}
+
+static String bodyLinkResolverBuildJson()
+{
+    const BodyLinkResolverStats &st = sBodyResolver.stats;
+    uint32_t now = millis();
+    uint32_t ttlLeft = 0;
+    if (sBodyResolver.state == kBodyLinkResolverCached && !bodyLinkResolverDue(now, sBodyResolver.expiresMs))
+        ttlLeft = sBodyResolver.expiresMs - now;
+    uint32_t nextIn = 0;
+    if (sBodyResolver.state == kBodyLinkResolverIdle && !bodyLinkResolverDue(now, sBodyResolver.nextQueryMs))
+        nextIn = sBodyResolver.nextQueryMs - now;
+    String json = "{\"state\":\"" + String(bodyLinkResolverStateName(sBodyResolver)) + "\"";
+    json += ",\"cached_ip\":\"" + String(sBodyResolver.ipv4 != 0 ? IPAddress(sBodyResolver.ipv4).toString() : String("")) + "\"";
+    json += ",\"ttl_left_ms\":" + String(ttlLeft);
+    json += ",\"backoff_ms\":" + String(sBodyResolver.backoffMs);
+    json += ",\"next_query_ms\":" + String(nextIn);
+    json += ",\"queries\":" + String(st.queries);
+    json += ",\"answers\":" + String(st.answers);
+    json += ",\"misses\":" + String(st.misses);
+    json += ",\"timeouts\":" + String(st.timeouts);
+    json += ",\"refreshes\":" + String(st.refreshes);
+    json += ",\"expiries\":" + String(st.expiries) + "}";
+    return json;
+}
+
 static uint32_t bodyLinkWifiHeartbeatAgeMs()
 {
     if (sBodyLastSeenWifiMs == 0)
@@ -0,0 +1,254 @@
+#pragma once
+// BootSchedule.h — boot timeline and deferred start-up work.
+//
+// setup() used to do everything before the first loop() pass: the full I2C
+// bus scan (with its settle delay), the sound module's serial handshake and
+// the WiFi bring-up all ran before AnimatedEvent::process() drew the first
+// logic frame or moved a servo. The timeline records how long each setup()
+// phase takes, when setup() returned and when mainLoop() finished its first
+// animation pass; /api/diag/boot reports it. Work nothing on the dome needs
+// for its first frame is registered with the deferred scheduler instead and
+// runs from mainLoop() once that frame is out, one step per pass.
+//
+// A deferred task may depend on tasks registered before it (so there are no
+// cycles), may not start before a given time, and returns Done, Yield (not
+// finished or not ready yet: call again after retryMs), Retry (an attempt
+// failed: counts against maxAttempts) or Failed. Tasks that depend on a
+// failed one are skipped.
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#define BOOT_TIMELINE_MAX_PHASES 16
+#define BOOT_SCHED_MAX_TASKS 8
+
+struct BootPhase
+{
+    const char *name;
+    uint32_t startUs;           // micros() since the app started
+    uint32_t durUs;
+};
+
+struct BootTimeline
+{
+    BootPhase phases[BOOT_TIMELINE_MAX_PHASES];
+    uint8_t count;
+    uint8_t dropped;            // phases past BOOT_TIMELINE_MAX_PHASES
+    bool open;                  // phases[count - 1] still running
+    uint32_t setupStartUs;
+    uint32_t setupDoneUs;       // 0 until setup() returns
+    uint32_t firstFrameUs;      // 0 until the first mainLoop() animation pass
+};
+
+static inline void bootTimelineReset(BootTimeline &t, uint32_t nowUs)
+{
+    memset(&t, 0, sizeof(t));
+    t.setupStartUs = nowUs;
+}
+
+static inline void bootTimelineEnd(BootTimeline &t, uint32_t nowUs)
+{
+    if (!t.open)
+        return;
+    BootPhase &p = t.phases[t.count - 1];
+    p.durUs = nowUs - p.startUs;
+    t.open = false;
+}
+
+// Ends the running phase, if any, and starts `name` (a string literal).
+static inline void bootTimelinePhase(BootTimeline &t, const char *name, uint32_t nowUs)
+{
+    bootTimelineEnd(t, nowUs);
+    if (t.count >= BOOT_TIMELINE_MAX_PHASES)
+    {
+        t.dropped++;
+        return;
+    }
+    BootPhase &p = t.phases[t.count++];
+    p.name = name;
+    p.startUs = nowUs;
+    p.durUs = 0;
+    t.open = true;
+}
+
+static inline void bootTimelineSetupDone(BootTimeline &t, uint32_t nowUs)
+{
+    bootTimelineEnd(t, nowUs);
+    t.setupDoneUs = nowUs;
+}
+
+// True the first time only, so the caller can release the deferred work.
+static inline bool bootTimelineFirstFrame(BootTimeline &t, uint32_t nowUs)
+{
+    if (t.firstFrameUs != 0 || t.setupDoneUs == 0)
+        return false;
+    t.firstFrameUs = nowUs != 0 ? nowUs : 1;
+    return true;
+}
+
+enum BootTaskResult
+{
+    kBootTaskDone,
+    kBootTaskYield,             // call again after retryMs; not an attempt
+    kBootTaskRetry,             // attempt failed; call again after retryMs
+    kBootTaskFailed
+};
+
+enum BootTaskState
+{
+    kBootTaskWaiting,           // for the first frame, its deps or notBeforeMs
+    kBootTaskStarted,           // has run, will run again
+    kBootTaskComplete,
+    kBootTaskGaveUp,            // Failed, or out of attempts
+    kBootTaskSkipped            // a dependency gave up
+};
+
+typedef BootTaskResult (*BootTaskFn)(uint32_t &retryMs);
+
+struct BootTask
+{
+    const char *name;
+    BootTaskFn run;
+    uint32_t deps;              // bit i = task i
+    uint32_t notBeforeMs;
+    uint8_t maxAttempts;        // 0 = no limit
+    uint8_t attempts;           // failed ones
+    uint16_t calls;
+    BootTaskState state;
+    uint32_t firstRunMs;
+    uint32_t endMs;             // completed, gave up or skipped
+    uint32_t runUs;             // total time spent inside run()
+};
+
+struct BootScheduler
+{
+    BootTask tasks[BOOT_SCHED_MAX_TASKS];
+    uint8_t count;
+    uint8_t pending;            // not yet complete, given up or skipped
+    uint8_t next;               // round-robin start for the ready scan
+    bool released;
+    uint32_t releasedMs;
+    uint32_t doneMs;            // when the last task finished, 0 while pending
+    uint32_t maxStepUs;         // longest single run() call
+    uint32_t (*clockUs)();
+};
+
+static inline void bootSchedReset(BootScheduler &s, uint32_t (*clockUs)())
+{
+    memset(&s, 0, sizeof(s));
+    s.clockUs = clockUs;
+}
+
+static inline uint32_t bootSchedBit(int id)
+{
+    return id >= 0 ? (uint32_t)1 << id : 0;
+}
+
+// Registers a task; returns its id, or -1 when the table is full or deps
+// names a task that is not registered yet.
+static inline int bootSchedAdd(BootScheduler &s, const char *name, BootTaskFn run, uint32_t deps,
+                               uint32_t notBeforeMs, uint8_t maxAttempts)
+{
+    if (s.count >= BOOT_SCHED_MAX_TASKS || run == nullptr || (deps >> s.count) != 0)
+        return -1;
+    BootTask &task = s.tasks[s.count];
+    memset(&task, 0, sizeof(task));
+    task.name = name;
+    task.run = run;
+    task.deps = deps;
+    task.notBeforeMs = notBeforeMs;
+    task.maxAttempts = maxAttempts;
+    task.state = kBootTaskWaiting;
+    s.pending++;
+    return s.count++;
+}
+
+static inline bool bootSchedFinished(const BootScheduler &s, int id)
+{
+    return id >= 0 && id < s.count && s.tasks[id].state == kBootTaskComplete;
+}
+
+static inline void bootSchedRelease(BootScheduler &s, uint32_t nowMs)
+{
+    if (s.released)
+        return;
+    s.released = true;
+    s.releasedMs = nowMs;
+}
+
+static inline void bootSchedEnd(BootScheduler &s, BootTask &task, BootTaskState state, uint32_t nowMs)
+{
+    task.state = state;
+    task.endMs = nowMs;
+    if (--s.pending == 0)
+        s.doneMs = nowMs != 0 ? nowMs : 1;
+}
+
+// Runs at most one ready task; returns its id, or -1 when nothing was due.
+// Call from mainLoop() on every pass.
+static inline int bootSchedStep(BootScheduler &s, uint32_t nowMs)
+{
+    if (!s.released || s.pending == 0)
+        return -1;
+    for (int n = 0; n < s.count; n++)
+    {
+        int id = (s.next + n) % s.count;
+        BootTask &task = s.tasks[id];
+        if (task.state != kBootTaskWaiting && task.state != kBootTaskStarted)
+            continue;
+        uint32_t blocked = 0;
+        for (int d = 0; d < id; d++)
+        {
+            if ((task.deps & bootSchedBit(d)) == 0)
+                continue;
+            if (s.tasks[d].state == kBootTaskGaveUp || s.tasks[d].state == kBootTaskSkipped)
+            {
+                bootSchedEnd(s, task, kBootTaskSkipped, nowMs);
+                blocked = ~(uint32_t)0;
+                break;
+            }
+            if (s.tasks[d].state != kBootTaskComplete)
+                blocked |= bootSchedBit(d);
+        }
+        if (blocked != 0 || (int32_t)(nowMs - task.notBeforeMs) < 0)
+            continue;
+
+        if (task.calls == 0)
+            task.firstRunMs = nowMs;
+        task.calls++;
+        task.state = kBootTaskStarted;
+        uint32_t retryMs = 0;
+        uint32_t startUs = s.clockUs != nullptr ? s.clockUs() : 0;
+        BootTaskResult result = task.run(retryMs);
+        uint32_t tookUs = s.clockUs != nullptr ? s.clockUs() - startUs : 0;
+        task.runUs += tookUs;
+        if (tookUs > s.maxStepUs)
+            s.maxStepUs = tookUs;
+        s.next = (uint8_t)((id + 1) % s.count);
+
+        if (result == kBootTaskRetry && task.attempts < 255 && ++task.attempts == task.maxAttempts)
+            result = kBootTaskFailed;
+        if (result == kBootTaskDone)
+            bootSchedEnd(s, task, kBootTaskComplete, nowMs);
+        else if (result == kBootTaskFailed)
+            bootSchedEnd(s, task, kBootTaskGaveUp, nowMs);
+        else
+            task.notBeforeMs = nowMs + retryMs;
+        return id;
+    }
+    return -1;
+}
+
+static inline const char *bootTaskStateName(BootTaskState state)
+{
+    switch (state)
+    {
+        case kBootTaskWaiting:  return "waiting";
+        case kBootTaskStarted:  return "started";
+        case kBootTaskComplete: return "done";
+        case kBootTaskGaveUp:   return "failed";
+        case kBootTaskSkipped:  return "skipped";
+    }
+    return "unknown";
+}
@@ -0,0 +1,130 @@
+#pragma once
+// ChunkedJsonStream.h — piecewise JSON bodies for chunked HTTP responses.
+//
+// A route describes its body as a sequence of pieces produced on demand:
+// either bytes it formatted into a small scratch buffer (owned) or a view of
+// memory that already exists, such as the dome layout static cache
+// (borrowed). chunkedJsonFill() copies pieces into the TCP send buffer the
+// web server hands out, so no route needs its whole body in one heap block.
+// An aborted body must not end with the zero-length chunk: the client would
+// take the truncated JSON as a complete 200 response, so the caller drops the
+// connection instead (chunkedJsonFillChunk).
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+enum ChunkedJsonStep
+{
+    kChunkedJsonMore,   // piece filled; call again for the next one
+    kChunkedJsonLast,   // piece filled and it ends the body
+    kChunkedJsonAbort,  // source changed under the stream; end the body now
+};
+
+struct ChunkedJsonPiece
+{
+    const char *data;
+    size_t len;
+    bool owned;   // formatted into route scratch memory rather than borrowed
+};
+
+typedef ChunkedJsonStep (*ChunkedJsonNextFn)(void *ctx, ChunkedJsonPiece &piece);
+
+struct ChunkedJsonCursor
+{
+    ChunkedJsonNextFn next;
+    void *ctx;
+    ChunkedJsonPiece piece;
+    size_t pos;
+    bool finished;
+    bool aborted;
+    uint32_t sent;
+    uint32_t peakOwned;   // largest owned piece: the biggest buffer the route held
+};
+
+// Per-endpoint counters for /api/health. peakPieceBytes is the largest piece
+// a route formatted itself (owned); borrowed pieces cost no allocation. It is
+// the piece length, not the capacity of the buffer holding it.
+struct ChunkedJsonStats
+{
+    uint32_t responses;
+    uint32_t aborted;
+    uint32_t lastBodyBytes;
+    uint32_t peakBodyBytes;
+    uint32_t peakPieceBytes;
+};
+
+// chunkedJsonFillChunk() result for an aborted body: close the connection
+// without sending the terminating chunk.
+static const size_t kChunkedJsonDrop = (size_t)-1;
+
+static inline void chunkedJsonBegin(ChunkedJsonCursor &cursor, ChunkedJsonNextFn next, void *ctx)
+{
+    memset(&cursor, 0, sizeof(cursor));
+    cursor.next = next;
+    cursor.ctx = ctx;
+}
+
+// Ends the body early, e.g. when borrowed memory is about to go away.
+static inline void chunkedJsonAbort(ChunkedJsonCursor &cursor)
+{
+    cursor.piece.data = nullptr;
+    cursor.piece.len = 0;
+    cursor.pos = 0;
+    cursor.finished = true;
+    cursor.aborted = true;
+}
+
+// Fills up to maxLen bytes; returns 0 once the body is complete.
+static size_t chunkedJsonFill(ChunkedJsonCursor &cursor, uint8_t *buffer, size_t maxLen)
+{
+    size_t written = 0;
+    while (written < maxLen)
+    {
+        if (cursor.pos >= cursor.piece.len)
+        {
+            if (cursor.finished) break;
+            cursor.piece.data = nullptr;
+            cursor.piece.len = 0;
+            cursor.piece.owned = false;
+            cursor.pos = 0;
+            ChunkedJsonStep step = cursor.next(cursor.ctx, cursor.piece);
+            if (step == kChunkedJsonAbort)
+            {
+                chunkedJsonAbort(cursor);
+                break;
+            }
+            if (step == kChunkedJsonLast) cursor.finished = true;
+            if (cursor.piece.owned && cursor.piece.len > cursor.peakOwned)
+                cursor.peakOwned = (uint32_t)cursor.piece.len;
+            continue;
+        }
+        size_t n = cursor.piece.len - cursor.pos;
+        if (n > maxLen - written) n = maxLen - written;
+        memcpy(buffer + written, cursor.piece.data + cursor.pos, n);
+        cursor.pos += n;
+        written += n;
+    }
+    cursor.sent += (uint32_t)written;
+    return written;
+}
+
+// chunkedJsonFill() for a chunked response callback: 0 ends the body
+// normally, kChunkedJsonDrop means it was aborted and must not look complete.
+static size_t chunkedJsonFillChunk(ChunkedJsonCursor &cursor, uint8_t *buffer, size_t maxLen)
+{
+    size_t written = chunkedJsonFill(cursor, buffer, maxLen);
+    if (written == 0 && cursor.aborted) return kChunkedJsonDrop;
+    return written;
+}
+
+// Call once per response, when the stream is released.
+static inline void chunkedJsonRecord(ChunkedJsonStats &stats, const ChunkedJsonCursor &cursor)
+{
+    stats.responses++;
+    bool complete = cursor.finished && !cursor.aborted && cursor.pos >= cursor.piece.len;
+    if (!complete) stats.aborted++;
+    stats.lastBodyBytes = cursor.sent;
+    if (cursor.sent > stats.peakBodyBytes) stats.peakBodyBytes = cursor.sent;
+    if (cursor.peakOwned > stats.peakPieceBytes) stats.peakPieceBytes = cursor.peakOwned;
+}
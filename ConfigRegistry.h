@@ -0,0 +1,733 @@
+#pragma once
+// ConfigRegistry.h — typed, schema-driven RAM copy of the "astro" NVS namespace.
+//
+// Every preference the firmware owns is declared once in CONFIG_REGISTRY_SCHEMA
+// with its NVS key, type, default, bounds and flags. configRegistryBegin() reads
+// the namespace into RAM at boot; from then on the getters are array reads, so
+// the USB serial pump, the state broadcast and the body link never touch flash.
+// Setters validate against the schema, write through to the store, update the
+// RAM copy and then call the subscribers for that key.
+//
+// The schema refers to the PREFERENCE_* keys and the compile-time defaults, so
+// this header is included after those defines. The store is a table of function
+// pointers (Preferences on the ESP32, a fake in tools/test_config_registry.py)
+// and the includer supplies CONFIG_REGISTRY_LOCK/UNLOCK. Blob keys (remote pairing data) are declared so the
+// schema covers the whole namespace, but they are not cached; their owners
+// still use Preferences directly.
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#ifndef CONFIG_REGISTRY_LOCK
+#define CONFIG_REGISTRY_LOCK()
+#define CONFIG_REGISTRY_UNLOCK()
+#endif
+
+#define CONFIG_REGISTRY_MAX_TEXT 64
+#define CONFIG_REGISTRY_MAX_LISTENERS 8
+#define CONFIG_REGISTRY_MAX_BATCH_BYTES 2048
+
+enum ConfigType
+{
+    kConfigBool,
+    kConfigInt,
+    kConfigText,
+    kConfigBlob
+};
+
+enum
+{
+    kConfigSensitive = 0x01,    // value is never logged or returned by a read
+    kConfigReboot = 0x02        // read once at boot; a change applies after restart
+};
+
+// CFG_BOOL(id, key, default, flags)
+// CFG_INT(id, key, default, min, max, flags)
+// CFG_TEXT(id, key, default, max length, flags)
+// CFG_BLOB(id, key, flags)
+#define CONFIG_REGISTRY_SCHEMA(CFG_BOOL, CFG_INT, CFG_TEXT, CFG_BLOB) \
+    CFG_BOOL(kCfgRemoteEnabled, PREFERENCE_REMOTE_ENABLED, REMOTE_ENABLED, kConfigReboot) \
+    CFG_TEXT(kCfgRemoteHostname, PREFERENCE_REMOTE_HOSTNAME, SMQ_HOSTNAME, 32, kConfigReboot) \
+    CFG_TEXT(kCfgRemoteSecret, PREFERENCE_REMOTE_SECRET, SMQ_SECRET, 64, kConfigSensitive | kConfigReboot) \
+    CFG_BLOB(kCfgRemotePaired, PREFERENCE_REMOTE_PAIRED, kConfigSensitive | kConfigReboot) \
+    CFG_BLOB(kCfgRemoteLmk, PREFERENCE_REMOTE_LMK, kConfigSensitive | kConfigReboot) \
+    CFG_BOOL(kCfgWifiEnabled, PREFERENCE_WIFI_ENABLED, WIFI_ENABLED, kConfigReboot) \
+    CFG_TEXT(kCfgWifiSsid, PREFERENCE_WIFI_SSID, WIFI_AP_NAME, 32, kConfigReboot) \
+    CFG_TEXT(kCfgWifiPass, PREFERENCE_WIFI_PASS, WIFI_AP_PASSPHRASE, 64, kConfigSensitive | kConfigReboot) \
+    CFG_BOOL(kCfgWifiAccessPoint, PREFERENCE_WIFI_AP, WIFI_ACCESS_POINT, kConfigReboot) \
+    CFG_INT(kCfgMarcSerial2Baud, PREFERENCE_MARCSERIAL2, MARC_SERIAL2_BAUD_RATE, 300, 921600, kConfigReboot) \
+    CFG_BOOL(kCfgMarcSerialPass, PREFERENCE_MARCSERIAL_PASS, MARC_SERIAL_PASS, 0) \
+    CFG_BOOL(kCfgMarcSerialEnabled, PREFERENCE_MARCSERIAL_ENABLED, MARC_SERIAL_ENABLED, kConfigReboot) \
+    CFG_BOOL(kCfgMarcWifiEnabled, PREFERENCE_MARCWIFI_ENABLED, MARC_WIFI_ENABLED, kConfigReboot) \
+    CFG_BOOL(kCfgMarcWifiSerialPass, PREFERENCE_MARCWIFI_SERIAL_PASS, MARC_WIFI_SERIAL_PASS, 0) \
+    CFG_BOOL(kCfgBodyLinkEnabled, PREFERENCE_BODY_LINK_ENABLED, BODY_LINK_ENABLED, kConfigReboot) \
+    CFG_BOOL(kCfgBodyWifiEnabled, PREFERENCE_BODY_WIFI_ENABLED, BODY_WIFI_ENABLED, kConfigReboot) \
+    CFG_TEXT(kCfgBodyPeerIp, PREFERENCE_BODY_PEER_IP, "", 15, 0) \
+    CFG_BOOL(kCfgBodyFramed, PREFERENCE_BODY_FRAMED, BODY_FRAMED_ENABLED, kConfigReboot) \
+    CFG_INT(kCfgBodyUartBaud, PREFERENCE_BODY_UART_BAUD, BODY_UART_BAUD, 0, 921600, kConfigReboot) \
+    CFG_INT(kCfgSoundModule, PREFERENCE_MARCSOUND, MARC_SOUND_PLAYER, 0, MarcSound::kHCR, kConfigReboot) \
+    CFG_INT(kCfgSoundSerial, PREFERENCE_MARCSOUND_SERIAL, MARC_SOUND_SERIAL, 0, 1, kConfigReboot) \
+    CFG_INT(kCfgSoundVolume, PREFERENCE_MARCSOUND_VOLUME, MARC_SOUND_VOLUME, 0, 1000, kConfigReboot) \
+    CFG_INT(kCfgSoundStartup, PREFERENCE_MARCSOUND_STARTUP, MARC_SOUND_STARTUP, 0, 255, kConfigReboot) \
+    CFG_INT(kCfgSoundRandom, PREFERENCE_MARCSOUND_RANDOM, MARC_SOUND_RANDOM, 0, 1, kConfigReboot) \
+    CFG_INT(kCfgSoundRandomMin, PREFERENCE_MARCSOUND_RANDOM_MIN, MARC_SOUND_RANDOM_MIN, 0, 3600000, 0) \
+    CFG_INT(kCfgSoundRandomMax, PREFERENCE_MARCSOUND_RANDOM_MAX, MARC_SOUND_RANDOM_MAX, 0, 3600000, 0) \
+    CFG_BOOL(kCfgSoundLocalEnabled, PREFERENCE_MARCSOUND_LOCAL_ENABLED, MARC_SOUND_LOCAL_ENABLED, 0) \
+    CFG_TEXT(kCfgDroidName, PREFERENCE_DROID_NAME, AP_DROID_NAME, 24, 0) \
+    CFG_BOOL(kCfgBadMotivatorEnabled, PREFERENCE_BADMOTIVATOR_ENABLED, AP_ENABLE_BADMOTIVATOR, kConfigReboot) \
+    CFG_BOOL(kCfgFireStripEnabled, PREFERENCE_FIRESTRIP_ENABLED, AP_ENABLE_FIRESTRIP, kConfigReboot) \
+    CFG_BOOL(kCfgCbiEnabled, PREFERENCE_CBI_ENABLED, AP_ENABLE_CBI, kConfigReboot) \
+    CFG_BOOL(kCfgDataPanelEnabled, PREFERENCE_DATAPANEL_ENABLED, AP_ENABLE_DATAPANEL, kConfigReboot) \
+    CFG_BOOL(kCfgLedRenderTask, PREFERENCE_LED_RENDER_TASK, false, kConfigReboot) \
+    CFG_BOOL(kCfgHoloBootLoop, PREFERENCE_HOLO_BOOT_LOOP, true, kConfigReboot) \
+    CFG_BOOL(kCfgDomeHappySound, PREFERENCE_DOME_HAPPY_SOUND, true, 0)
+
+#define CONFIG_REGISTRY_ID(id, ...) id,
+enum ConfigKeyId
+{
+    CONFIG_REGISTRY_SCHEMA(CONFIG_REGISTRY_ID, CONFIG_REGISTRY_ID, CONFIG_REGISTRY_ID, CONFIG_REGISTRY_ID)
+    kConfigKeyCount
+};
+#undef CONFIG_REGISTRY_ID
+
+struct ConfigKeyDef
+{
+    const char *key;
+    ConfigType type;
+    uint8_t flags;
+    int32_t min;            // int lower bound
+    int32_t max;            // int upper bound, text max length
+    int32_t defInt;         // bool and int default
+    const char *defText;    // text default
+};
+
+#define CONFIG_REGISTRY_DEF_BOOL(id, key, def, flags) { key, kConfigBool, flags, 0, 1, (def) ? 1 : 0, nullptr },
+#define CONFIG_REGISTRY_DEF_INT(id, key, def, lo, hi, flags) { key, kConfigInt, flags, lo, hi, int32_t(def), nullptr },
+#define CONFIG_REGISTRY_DEF_TEXT(id, key, def, maxLen, flags) { key, kConfigText, flags, 0, maxLen, 0, def },
+#define CONFIG_REGISTRY_DEF_BLOB(id, key, flags) { key, kConfigBlob, flags, 0, 0, 0, nullptr },
+static const ConfigKeyDef kConfigSchema[kConfigKeyCount] = {
+    CONFIG_REGISTRY_SCHEMA(CONFIG_REGISTRY_DEF_BOOL, CONFIG_REGISTRY_DEF_INT,
+                           CONFIG_REGISTRY_DEF_TEXT, CONFIG_REGISTRY_DEF_BLOB)
+};
+#undef CONFIG_REGISTRY_DEF_BOOL
+#undef CONFIG_REGISTRY_DEF_INT
+#undef CONFIG_REGISTRY_DEF_TEXT
+#undef CONFIG_REGISTRY_DEF_BLOB
+
+// Text values share one pool sized from the schema: max length + NUL each.
+#define CONFIG_REGISTRY_POOL_NONE(...)
+#define CONFIG_REGISTRY_POOL_TEXT(id, key, def, maxLen, flags) + (maxLen) + 1
+static const size_t kConfigTextPoolBytes = 0 CONFIG_REGISTRY_SCHEMA(
+    CONFIG_REGISTRY_POOL_NONE, CONFIG_REGISTRY_POOL_NONE, CONFIG_REGISTRY_POOL_TEXT, CONFIG_REGISTRY_POOL_NONE);
+#define CONFIG_REGISTRY_CHECK_TEXT(id, key, def, maxLen, flags) \
+    static_assert((maxLen) <= CONFIG_REGISTRY_MAX_TEXT && sizeof(def) <= (maxLen) + 1, "text key " key " exceeds its length");
+CONFIG_REGISTRY_SCHEMA(CONFIG_REGISTRY_POOL_NONE, CONFIG_REGISTRY_POOL_NONE, CONFIG_REGISTRY_CHECK_TEXT, CONFIG_REGISTRY_POOL_NONE)
+#undef CONFIG_REGISTRY_CHECK_TEXT
+#undef CONFIG_REGISTRY_POOL_NONE
+#undef CONFIG_REGISTRY_POOL_TEXT
+
+// Backing store. load* return false when the key is absent, which keeps the
+// schema default; save* return false when the write did not stick.
+struct ConfigStore
+{
+    bool (*loadInt)(const ConfigKeyDef &def, int32_t &value);
+    bool (*loadText)(const ConfigKeyDef &def, char *text, size_t size);
+    bool (*saveInt)(const ConfigKeyDef &def, int32_t value);
+    bool (*saveText)(const ConfigKeyDef &def, const char *text);
+    bool (*clear)();
+};
+
+// Called after a key changed, in the context of the task that wrote it (the
+// web server task for /api/pref), so keep listeners to flag/field updates.
+// Subscribing to kConfigKeyCount receives every change.
+typedef void (*ConfigListenerFn)(ConfigKeyId id, void *ctx);
+
+struct ConfigListener
+{
+    ConfigKeyId id;
+    ConfigListenerFn fn;
+    void *ctx;
+};
+
+struct ConfigRegistryStats
+{
+    uint32_t loaded;            // keys found in the store at boot
+    uint32_t rejected;          // stored values outside the schema, replaced by defaults
+    uint32_t writes;
+    uint32_t writeErrors;
+    uint32_t notifications;
+    uint32_t batches;           // /api/prefs updates applied
+    uint32_t rollbacks;         // batches undone after a store write failed
+};
+
+static int32_t sConfigInt[kConfigKeyCount];
+static char sConfigText[kConfigTextPoolBytes];
+static uint16_t sConfigTextOffset[kConfigKeyCount];
+static ConfigStore sConfigStore;
+static ConfigListener sConfigListeners[CONFIG_REGISTRY_MAX_LISTENERS];
+static uint8_t sConfigListenerCount = 0;
+static ConfigRegistryStats sConfigStats;
+
+static inline const ConfigKeyDef &configKeyDef(ConfigKeyId id)
+{
+    return kConfigSchema[id];
+}
+
+static ConfigKeyId configFindKey(const char *key)
+{
+    for (int i = 0; i < kConfigKeyCount; i++)
+    {
+        if (strcmp(kConfigSchema[i].key, key) == 0)
+            return ConfigKeyId(i);
+    }
+    return kConfigKeyCount;
+}
+
+static void configCopyText(char *out, size_t size, const char *text, size_t maxLen)
+{
+    if (size == 0) return;
+    size_t len = strlen(text);
+    if (len > maxLen) len = maxLen;
+    if (len > size - 1) len = size - 1;
+    memcpy(out, text, len);
+    out[len] = '\0';
+}
+
+static void configResetToDefault(ConfigKeyId id)
+{
+    const ConfigKeyDef &def = kConfigSchema[id];
+    if (def.type == kConfigText)
+        configCopyText(&sConfigText[sConfigTextOffset[id]], def.max + 1, def.defText, def.max);
+    else
+        sConfigInt[id] = def.defInt;
+}
+
+static void configRegistryBegin(const ConfigStore &store)
+{
+    sConfigStore = store;
+    memset(&sConfigStats, 0, sizeof(sConfigStats));
+    size_t offset = 0;
+    for (int i = 0; i < kConfigKeyCount; i++)
+    {
+        const ConfigKeyDef &def = kConfigSchema[i];
+        sConfigTextOffset[i] = uint16_t(offset);
+        if (def.type == kConfigText)
+            offset += def.max + 1;
+        configResetToDefault(ConfigKeyId(i));
+        if (def.type == kConfigBool || def.type == kConfigInt)
+        {
+            int32_t value;
+            if (!store.loadInt(def, value))
+                continue;
+            sConfigStats.loaded++;
+            if (def.type == kConfigBool)
+                sConfigInt[i] = value != 0;
+            else if (value >= def.min && value <= def.max)
+                sConfigInt[i] = value;
+            else
+                sConfigStats.rejected++;
+        }
+        else if (def.type == kConfigText)
+        {
+            char text[CONFIG_REGISTRY_MAX_TEXT + 1];
+            if (!store.loadText(def, text, def.max + 1))
+                continue;
+            sConfigStats.loaded++;
+            configCopyText(&sConfigText[sConfigTextOffset[i]], def.max + 1, text, def.max);
+        }
+    }
+}
+
+static inline bool configGetBool(ConfigKeyId id)
+{
+    return sConfigInt[id] != 0;
+}
+
+static inline int32_t configGetInt(ConfigKeyId id)
+{
+    return sConfigInt[id];
+}
+
+// Copies a text value; returns its length. Writers swap text under the lock,
+// so readers on other tasks never see a half-written value.
+static size_t configGetText(ConfigKeyId id, char *out, size_t size)
+{
+    const ConfigKeyDef &def = kConfigSchema[id];
+    if (def.type != kConfigText)
+    {
+        if (size) out[0] = '\0';
+        return 0;
+    }
+    CONFIG_REGISTRY_LOCK();
+    configCopyText(out, size, &sConfigText[sConfigTextOffset[id]], def.max);
+    CONFIG_REGISTRY_UNLOCK();
+    return strlen(out);
+}
+
+static bool configSubscribe(ConfigKeyId id, ConfigListenerFn fn, void *ctx)
+{
+    if (sConfigListenerCount >= CONFIG_REGISTRY_MAX_LISTENERS)
+        return false;
+    ConfigListener &listener = sConfigListeners[sConfigListenerCount++];
+    listener.id = id;
+    listener.fn = fn;
+    listener.ctx = ctx;
+    return true;
+}
+
+static void configNotify(ConfigKeyId id)
+{
+    for (uint8_t i = 0; i < sConfigListenerCount; i++)
+    {
+        const ConfigListener &listener = sConfigListeners[i];
+        if (listener.id == id || listener.id == kConfigKeyCount)
+        {
+            listener.fn(id, listener.ctx);
+            sConfigStats.notifications++;
+        }
+    }
+}
+
+// Parses and bounds-checks a textual value the way /api/pref receives it.
+// Booleans take 1/0/true/false, integers are unsigned decimal. On success
+// intValue holds the bool/int value; text values are checked for length only.
+static bool configValidate(ConfigKeyId id, const char *text, int32_t &intValue, const char *&errMsg)
+{
+    const ConfigKeyDef &def = kConfigSchema[id];
+    switch (def.type)
+    {
+        case kConfigBool:
+            if (strcmp(text, "1") == 0 || strcmp(text, "true") == 0) { intValue = 1; return true; }
+            if (strcmp(text, "0") == 0 || strcmp(text, "false") == 0) { intValue = 0; return true; }
+            errMsg = "invalid boolean value";
+            return false;
+        case kConfigInt:
+        {
+            int64_t value = 0;
+            size_t len = strlen(text);
+            if (len == 0 || len > 10)
+            {
+                errMsg = "invalid integer value";
+                return false;
+            }
+            for (size_t i = 0; i < len; i++)
+            {
+                if (text[i] < '0' || text[i] > '9')
+                {
+                    errMsg = "invalid integer value";
+                    return false;
+                }
+                value = value * 10 + (text[i] - '0');
+            }
+            if (value < def.min || value > def.max)
+            {
+                errMsg = "value out of range";
+                return false;
+            }
+            intValue = int32_t(value);
+            return true;
+        }
+        case kConfigText:
+            if (strlen(text) > size_t(def.max))
+            {
+                errMsg = "value too long";
+                return false;
+            }
+            intValue = 0;
+            return true;
+        default:
+            errMsg = "key not writable";
+            return false;
+    }
+}
+
+static bool configSetInt(ConfigKeyId id, int32_t value, const char *&errMsg)
+{
+    const ConfigKeyDef &def = kConfigSchema[id];
+    if (def.type == kConfigBool)
+        value = value != 0;
+    else if (def.type != kConfigInt)
+    {
+        errMsg = "key not writable";
+        return false;
+    }
+    else if (value < def.min || value > def.max)
+    {
+        errMsg = "value out of range";
+        return false;
+    }
+    if (sConfigInt[id] == value)
+        return true;
+    if (!sConfigStore.saveInt(def, value))
+    {
+        sConfigStats.writeErrors++;
+        errMsg = "store write failed";
+        return false;
+    }
+    sConfigStats.writes++;
+    sConfigInt[id] = value;
+    configNotify(id);
+    return true;
+}
+
+static inline bool configSetBool(ConfigKeyId id, bool value, const char *&errMsg)
+{
+    return configSetInt(id, value ? 1 : 0, errMsg);
+}
+
+static bool configSetText(ConfigKeyId id, const char *text, const char *&errMsg)
+{
+    const ConfigKeyDef &def = kConfigSchema[id];
+    if (def.type != kConfigText)
+    {
+        errMsg = "key not writable";
+        return false;
+    }
+    if (strlen(text) > size_t(def.max))
+    {
+        errMsg = "value too long";
+        return false;
+    }
+    char *slot = &sConfigText[sConfigTextOffset[id]];
+    if (strcmp(slot, text) == 0)
+        return true;
+    if (!sConfigStore.saveText(def, text))
+    {
+        sConfigStats.writeErrors++;
+        errMsg = "store write failed";
+        return false;
+    }
+    sConfigStats.writes++;
+    CONFIG_REGISTRY_LOCK();
+    configCopyText(slot, def.max + 1, text, def.max);
+    CONFIG_REGISTRY_UNLOCK();
+    configNotify(id);
+    return true;
+}
+
+// Validate-then-write for values arriving as text (REST API, console).
+static bool configSetFromText(ConfigKeyId id, const char *text, const char *&errMsg)
+{
+    int32_t value = 0;
+    if (!configValidate(id, text, value, errMsg))
+        return false;
+    if (kConfigSchema[id].type == kConfigText)
+        return configSetText(id, text, errMsg);
+    return configSetInt(id, value, errMsg);
+}
+
+// Factory reset: clears the store and returns every key to its default,
+// notifying subscribers of the keys whose value actually changed.
+static bool configRegistryReset(const char *&errMsg)
+{
+    if (!sConfigStore.clear())
+    {
+        sConfigStats.writeErrors++;
+        errMsg = "store clear failed";
+        return false;
+    }
+    for (int i = 0; i < kConfigKeyCount; i++)
+    {
+        const ConfigKeyDef &def = kConfigSchema[i];
+        bool changed;
+        if (def.type == kConfigText)
+        {
+            char *slot = &sConfigText[sConfigTextOffset[i]];
+            changed = strcmp(slot, def.defText) != 0;
+            CONFIG_REGISTRY_LOCK();
+            configResetToDefault(ConfigKeyId(i));
+            CONFIG_REGISTRY_UNLOCK();
+        }
+        else
+        {
+            changed = sConfigInt[i] != def.defInt;
+            configResetToDefault(ConfigKeyId(i));
+        }
+        if (changed)
+            configNotify(ConfigKeyId(i));
+    }
+    return true;
+}
+
+// ---- Batch updates (/api/prefs) ----
+//
+// A batch is a flat JSON object of key/value pairs. configParseBatch() checks
+// every pair against the schema in one pass and reports all failures at once;
+// configApplyBatch() then writes the changed keys. NVS has no multi-key
+// transaction, so the batch is made all-or-nothing by hand: nothing is written
+// unless every pair validated, and if a store write fails part way the keys
+// already written are put back to their old values. RAM is only updated once
+// every write succeeded, under one lock, and subscribers run afterwards.
+
+struct ConfigBatchEntry
+{
+    const char *key;            // points into the caller's buffer
+    const char *text;           // value in the form configValidate() takes
+    const char *error;          // nullptr when the pair validated
+    ConfigKeyId id;
+    int32_t value;
+    bool changed;
+};
+
+static const char *configBatchParseString(char *&p, const char *&errMsg)
+{
+    // In-place unescape; the decoded string is never longer than the source.
+    char *out = ++p;
+    const char *start = out;
+    while (*p != '"')
+    {
+        char c = *p++;
+        if (c == '\0' || (unsigned char)c < 0x20)
+        {
+            errMsg = "unterminated string";
+            return nullptr;
+        }
+        if (c == '\\')
+        {
+            c = *p++;
+            switch (c)
+            {
+                case '"': case '\\': case '/': break;
+                case 'b': c = '\b'; break;
+                case 'f': c = '\f'; break;
+                case 'n': c = '\n'; break;
+                case 'r': c = '\r'; break;
+                case 't': c = '\t'; break;
+                case 'u':
+                    errMsg = "unicode escapes not supported";
+                    return nullptr;
+                default:
+                    errMsg = "invalid escape";
+                    return nullptr;
+            }
+        }
+        *out++ = c;
+    }
+    p++;
+    *out = '\0';
+    return start;
+}
+
+static inline void configBatchSkipWs(char *&p)
+{
+    while (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n')
+        p++;
+}
+
+// Parses json (modified in place) into entries and validates each pair.
+// Returns false with errMsg set only when the document itself is malformed;
+// schema failures are left in entry.error and counted in invalid.
+static bool configParseBatch(char *json, ConfigBatchEntry *entries, uint8_t maxEntries,
+                             uint8_t &count, uint8_t &invalid, const char *&errMsg)
+{
+    count = 0;
+    invalid = 0;
+    char *p = json;
+    configBatchSkipWs(p);
+    if (*p != '{')
+    {
+        errMsg = "expected JSON object";
+        return false;
+    }
+    p++;
+    configBatchSkipWs(p);
+    if (*p == '}')
+    {
+        p++;
+    }
+    else
+    {
+        for (;;)
+        {
+            if (*p != '"')
+            {
+                errMsg = "expected key";
+                return false;
+            }
+            const char *key = configBatchParseString(p, errMsg);
+            if (!key) return false;
+            configBatchSkipWs(p);
+            if (*p != ':')
+            {
+                errMsg = "expected ':'";
+                return false;
+            }
+            p++;
+            configBatchSkipWs(p);
+
+            const char *text = nullptr;
+            bool quoted = false;
+            if (*p == '"')
+            {
+                text = configBatchParseString(p, errMsg);
+                if (!text) return false;
+                quoted = true;
+            }
+            else if (strncmp(p, "true", 4) == 0)
+            {
+                text = "1";
+                p += 4;
+            }
+            else if (strncmp(p, "false", 5) == 0)
+            {
+                text = "0";
+                p += 5;
+            }
+            else if (*p >= '0' && *p <= '9')
+            {
+                // Shift the digits one byte left over the ':' or space that
+                // precedes them, so the terminator fits without clobbering
+                // the ',' or '}' that follows.
+                char *start = p;
+                while (*p >= '0' && *p <= '9')
+                    p++;
+                size_t len = size_t(p - start);
+                memmove(start - 1, start, len);
+                start[len - 1] = '\0';
+                text = start - 1;
+            }
+            else if (strncmp(p, "null", 4) == 0 || *p == '-')
+            {
+                // Leave text null; the pair is reported below.
+                p += (*p == '-') ? 1 : 4;
+                while (*p >= '0' && *p <= '9')
+                    p++;
+            }
+            else
+            {
+                errMsg = "unsupported value";
+                return false;
+            }
+
+            if (count >= maxEntries)
+            {
+                errMsg = "too many keys";
+                return false;
+            }
+            ConfigBatchEntry &entry = entries[count++];
+            entry.key = key;
+            entry.text = text;
+            entry.error = nullptr;
+            entry.id = configFindKey(key);
+            entry.value = 0;
+            entry.changed = false;
+            if (entry.id == kConfigKeyCount)
+                entry.error = "unknown key";
+            else if (!text)
+                entry.error = "invalid value";
+            else if (kConfigSchema[entry.id].type == kConfigText && !quoted)
+                entry.error = "expected string";
+            else
+            {
+                for (uint8_t i = 0; i + 1 < count; i++)
+                {
+                    if (entries[i].id == entry.id)
+                    {
+                        entry.error = "duplicate key";
+                        break;
+                    }
+                }
+                if (!entry.error)
+                    configValidate(entry.id, text, entry.value, entry.error);
+            }
+            if (entry.error)
+                invalid++;
+
+            configBatchSkipWs(p);
+            if (*p == ',')
+            {
+                p++;
+                configBatchSkipWs(p);
+                continue;
+            }
+            if (*p == '}')
+            {
+                p++;
+                break;
+            }
+            errMsg = "expected ',' or '}'";
+            return false;
+        }
+    }
+    configBatchSkipWs(p);
+    if (*p != '\0')
+    {
+        errMsg = "trailing data";
+        return false;
+    }
+    return true;
+}
+
+static bool configBatchStoreEntry(const ConfigBatchEntry &entry, bool restore)
+{
+    const ConfigKeyDef &def = kConfigSchema[entry.id];
+    if (def.type == kConfigText)
+        return sConfigStore.saveText(def, restore ? &sConfigText[sConfigTextOffset[entry.id]] : entry.text);
+    return sConfigStore.saveInt(def, restore ? sConfigInt[entry.id] : entry.value);
+}
+
+// Applies a batch that configParseBatch() reported with no invalid entries.
+// Marks entry.changed for the keys whose value differed from the RAM copy.
+static bool configApplyBatch(ConfigBatchEntry *entries, uint8_t count, const char *&errMsg)
+{
+    for (uint8_t i = 0; i < count; i++)
+    {
+        ConfigBatchEntry &entry = entries[i];
+        if (entry.error || entry.id == kConfigKeyCount ||
+            kConfigSchema[entry.id].type == kConfigBlob)
+        {
+            errMsg = "key not writable";
+            return false;
+        }
+        if (kConfigSchema[entry.id].type == kConfigText)
+            entry.changed = strcmp(&sConfigText[sConfigTextOffset[entry.id]], entry.text) != 0;
+        else
+            entry.changed = sConfigInt[entry.id] != entry.value;
+    }
+
+    for (uint8_t i = 0; i < count; i++)
+    {
+        if (!entries[i].changed)
+            continue;
+        if (configBatchStoreEntry(entries[i], false))
+        {
+            sConfigStats.writes++;
+            continue;
+        }
+        // The RAM copy still holds the old values, so it is the undo log.
+        sConfigStats.writeErrors++;
+        sConfigStats.rollbacks++;
+        while (i-- > 0)
+        {
+            if (entries[i].changed && !configBatchStoreEntry(entries[i], true))
+                sConfigStats.writeErrors++;
+        }
+        for (uint8_t j = 0; j < count; j++)
+            entries[j].changed = false;
+        errMsg = "store write failed";
+        return false;
+    }
+
+    CONFIG_REGISTRY_LOCK();
+    for (uint8_t i = 0; i < count; i++)
+    {
+        const ConfigBatchEntry &entry = entries[i];
+        if (!entry.changed)
+            continue;
+        const ConfigKeyDef &def = kConfigSchema[entry.id];
+        if (def.type == kConfigText)
+            configCopyText(&sConfigText[sConfigTextOffset[entry.id]], def.max + 1, entry.text, def.max);
+        else
+            sConfigInt[entry.id] = entry.value;
+    }
+    CONFIG_REGISTRY_UNLOCK();
+
+    sConfigStats.batches++;
+    for (uint8_t i = 0; i < count; i++)
+    {
+        if (entries[i].changed)
+            configNotify(entries[i].id);
+    }
+    return true;
+}
@@ -0,0 +1,505 @@
+#pragma once
+// DeltaPatch.h — streaming applier for delta firmware patches ("APD1").
+//
+// A full OTA moves the whole ~1.3 MB image over the soft-AP. A patch built by
+// tools/firmware_delta.py from the running firmware.bin and the new one
+// describes the new image as copies from the old image, bsdiff-style "add"
+// regions (old bytes plus a sparse byte-wise diff, which covers code that
+// moved and had its addresses relocated) and literal bytes. The format is
+// documented in that tool.
+//
+// The patch arrives in arbitrary multipart chunks; deltaPatchFeed() keeps its
+// parse state between them and never needs more than one chunk in RAM. It
+// stops after the 76-byte header so the caller can check the base digest
+// against the running partition and start the update before any output is
+// produced. Old bytes come from DeltaPatchIo::readOld (the running partition
+// on the ESP32) through a small window; new bytes go to DeltaPatchIo::writeNew
+// (OtaStream, which hashes them and checks the target digest before commit).
+// The base digest itself is taken ahead of time: deltaPatchImageLength() and
+// DeltaPatchBaseHash let the firmware hash its running image in slices from
+// the loop, so the header check is a compare rather than a 1.3 MB read.
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include "Sha256.h"
+
+#define DELTA_PATCH_HEADER_LEN 76
+#define DELTA_PATCH_WINDOW 256          // old-image read window
+#define DELTA_PATCH_OUT_CHUNK 256       // output batched into writes of this size
+#define DELTA_PATCH_IMAGE_HEADER_LEN 24 // esp_image_header_t
+#define DELTA_PATCH_IMAGE_MAX_SEGMENTS 16
+
+enum DeltaPatchOp
+{
+    kDeltaOpEnd = 0,
+    kDeltaOpCopy = 1,
+    kDeltaOpAdd = 2,
+    kDeltaOpLiteral = 3
+};
+
+enum DeltaPatchResult
+{
+    kDeltaOk,
+    kDeltaHeaderDone,           // header parsed; check the base, then feed the rest
+    kDeltaBadMagic,
+    kDeltaBadOp,
+    kDeltaOutOfRange,           // source or output past the declared sizes
+    kDeltaReadFailed,
+    kDeltaWriteFailed,
+    kDeltaTrailingData,
+    kDeltaTruncated
+};
+
+struct DeltaPatchIo
+{
+    bool (*readOld)(void *ctx, uint32_t offset, uint8_t *buf, size_t len);
+    bool (*writeNew)(void *ctx, const uint8_t *data, size_t len);
+    void *ctx;
+};
+
+struct DeltaPatchHeader
+{
+    uint32_t oldSize;
+    uint8_t oldSha[SHA256_DIGEST_LEN];
+    uint32_t newSize;
+    uint8_t newSha[SHA256_DIGEST_LEN];
+};
+
+enum DeltaPatchState
+{
+    kDeltaStateHeader,
+    kDeltaStateOp,
+    kDeltaStateVarint,          // reading op fields into field[]
+    kDeltaStateAddSegment,      // reading an ADD zero-run / count pair
+    kDeltaStateAddBytes,
+    kDeltaStateLiteral,
+    kDeltaStateDone,
+    kDeltaStateFailed
+};
+
+struct DeltaPatchStats
+{
+    uint32_t copies;
+    uint32_t adds;
+    uint32_t literals;
+    uint32_t copiedBytes;       // taken unchanged from the old image
+    uint32_t patchedBytes;      // old byte plus a non-zero diff
+    uint32_t literalBytes;
+};
+
+struct DeltaPatch
+{
+    DeltaPatchState state;
+    uint8_t headerRaw[DELTA_PATCH_HEADER_LEN];
+    uint8_t headerLen;
+    DeltaPatchHeader header;
+
+    uint8_t op;
+    uint8_t fieldsWanted;
+    uint8_t fieldCount;
+    uint32_t field[2];
+    uint32_t varint;
+    uint8_t varintShift;
+
+    uint32_t src;               // next old byte for COPY/ADD
+    uint32_t remaining;         // bytes left in the current op
+    uint32_t segmentCount;      // diff bytes left in the current ADD segment
+
+    uint32_t windowStart;
+    uint16_t windowLen;
+    uint8_t window[DELTA_PATCH_WINDOW];
+    uint8_t out[DELTA_PATCH_OUT_CHUNK];
+    uint16_t outLen;
+    uint32_t produced;
+
+    DeltaPatchResult error;
+    DeltaPatchStats stats;
+};
+
+static inline void deltaPatchReset(DeltaPatch &p)
+{
+    p.state = kDeltaStateHeader;
+    p.headerLen = 0;
+    memset(&p.header, 0, sizeof(p.header));
+    p.fieldCount = 0;
+    p.fieldsWanted = 0;
+    p.varint = 0;
+    p.varintShift = 0;
+    p.remaining = 0;
+    p.segmentCount = 0;
+    p.windowStart = 0;
+    p.windowLen = 0;
+    p.outLen = 0;
+    p.produced = 0;
+    p.error = kDeltaOk;
+    memset(&p.stats, 0, sizeof(p.stats));
+}
+
+static inline uint32_t deltaPatchLe32(const uint8_t *b)
+{
+    return (uint32_t)b[0] | ((uint32_t)b[1] << 8) | ((uint32_t)b[2] << 16) | ((uint32_t)b[3] << 24);
+}
+
+static inline DeltaPatchResult deltaPatchFail(DeltaPatch &p, DeltaPatchResult error)
+{
+    p.state = kDeltaStateFailed;
+    p.error = error;
+    return error;
+}
+
+static inline bool deltaPatchFlush(DeltaPatch &p, const DeltaPatchIo &io)
+{
+    if (p.outLen == 0)
+        return true;
+    bool ok = io.writeNew(io.ctx, p.out, p.outLen);
+    p.outLen = 0;
+    return ok;
+}
+
+static inline bool deltaPatchEmit(DeltaPatch &p, const DeltaPatchIo &io, uint8_t b)
+{
+    p.out[p.outLen++] = b;
+    p.produced++;
+    return p.outLen < DELTA_PATCH_OUT_CHUNK || deltaPatchFlush(p, io);
+}
+
+static inline bool deltaPatchOldByte(DeltaPatch &p, const DeltaPatchIo &io, uint32_t offset, uint8_t &b)
+{
+    if (offset < p.windowStart || offset >= p.windowStart + p.windowLen)
+    {
+        uint32_t len = p.header.oldSize - offset;
+        if (len > DELTA_PATCH_WINDOW)
+            len = DELTA_PATCH_WINDOW;
+        if (!io.readOld(io.ctx, offset, p.window, len))
+            return false;
+        p.windowStart = offset;
+        p.windowLen = len;
+    }
+    b = p.window[offset - p.windowStart];
+    return true;
+}
+
+// Emits `count` old bytes unchanged from p.src.
+static inline DeltaPatchResult deltaPatchCopyOld(DeltaPatch &p, const DeltaPatchIo &io, uint32_t count)
+{
+    for (uint32_t i = 0; i < count; i++)
+    {
+        uint8_t b;
+        if (!deltaPatchOldByte(p, io, p.src++, b))
+            return deltaPatchFail(p, kDeltaReadFailed);
+        if (!deltaPatchEmit(p, io, b))
+            return deltaPatchFail(p, kDeltaWriteFailed);
+    }
+    return kDeltaOk;
+}
+
+static inline DeltaPatchResult deltaPatchStartOp(DeltaPatch &p)
+{
+    const DeltaPatchHeader &h = p.header;
+    if (p.op == kDeltaOpLiteral)
+    {
+        p.remaining = p.field[0];
+        if (p.remaining > h.newSize - p.produced)
+            return deltaPatchFail(p, kDeltaOutOfRange);
+        p.stats.literals++;
+        p.state = p.remaining > 0 ? kDeltaStateLiteral : kDeltaStateOp;
+        return kDeltaOk;
+    }
+    p.src = p.field[0];
+    p.remaining = p.field[1];
+    if (p.src > h.oldSize || p.remaining > h.oldSize - p.src || p.remaining > h.newSize - p.produced)
+        return deltaPatchFail(p, kDeltaOutOfRange);
+    p.state = kDeltaStateOp;
+    return kDeltaOk;
+}
+
+// Feeds patch bytes. Returns the number consumed: all of `len`, or fewer when
+// the header completes (result kDeltaHeaderDone; feed the rest afterwards) or
+// on an error.
+static inline size_t deltaPatchFeed(DeltaPatch &p, const DeltaPatchIo &io, const uint8_t *data, size_t len,
+                                    DeltaPatchResult &result)
+{
+    result = kDeltaOk;
+    size_t i = 0;
+    while (i < len)
+    {
+        switch (p.state)
+        {
+        case kDeltaStateHeader:
+            p.headerRaw[p.headerLen++] = data[i++];
+            if (p.headerLen == DELTA_PATCH_HEADER_LEN)
+            {
+                if (memcmp(p.headerRaw, "APD1", 4) != 0)
+                {
+                    result = deltaPatchFail(p, kDeltaBadMagic);
+                    return i;
+                }
+                p.header.oldSize = deltaPatchLe32(p.headerRaw + 4);
+                memcpy(p.header.oldSha, p.headerRaw + 8, SHA256_DIGEST_LEN);
+                p.header.newSize = deltaPatchLe32(p.headerRaw + 40);
+                memcpy(p.header.newSha, p.headerRaw + 44, SHA256_DIGEST_LEN);
+                p.state = kDeltaStateOp;
+                result = kDeltaHeaderDone;
+                return i;
+            }
+            break;
+
+        case kDeltaStateOp:
+            p.op = data[i++];
+            if (p.op == kDeltaOpEnd)
+            {
+                p.state = kDeltaStateDone;
+                break;
+            }
+            if (p.op > kDeltaOpLiteral)
+            {
+                result = deltaPatchFail(p, kDeltaBadOp);
+                return i;
+            }
+            p.fieldsWanted = p.op == kDeltaOpLiteral ? 1 : 2;
+            p.fieldCount = 0;
+            p.varint = 0;
+            p.varintShift = 0;
+            p.state = kDeltaStateVarint;
+            break;
+
+        case kDeltaStateVarint:
+        case kDeltaStateAddSegment:
+        {
+            uint8_t b = data[i++];
+            if (p.varintShift > 28)
+            {
+                result = deltaPatchFail(p, kDeltaOutOfRange);
+                return i;
+            }
+            p.varint |= (uint32_t)(b & 0x7F) << p.varintShift;
+            p.varintShift += 7;
+            if (b & 0x80)
+                break;
+            p.field[p.fieldCount++] = p.varint;
+            p.varint = 0;
+            p.varintShift = 0;
+            if (p.fieldCount < p.fieldsWanted)
+                break;
+
+            if (p.state == kDeltaStateVarint)
+            {
+                result = deltaPatchStartOp(p);
+                if (result != kDeltaOk)
+                    return i;
+                if (p.op == kDeltaOpCopy)
+                {
+                    p.stats.copies++;
+                    p.stats.copiedBytes += p.remaining;
+                    result = deltaPatchCopyOld(p, io, p.remaining);
+                    if (result != kDeltaOk)
+                        return i;
+                    p.remaining = 0;
+                }
+                else if (p.op == kDeltaOpAdd)
+                {
+                    p.stats.adds++;
+                    if (p.remaining > 0)
+                    {
+                        p.fieldsWanted = 2;
+                        p.fieldCount = 0;
+                        p.state = kDeltaStateAddSegment;
+                    }
+                }
+                break;
+            }
+
+            // ADD segment: zero run, then count diff bytes.
+            uint32_t run = p.field[0];
+            uint32_t count = p.field[1];
+            if (run > p.remaining || count > p.remaining - run)
+            {
+                result = deltaPatchFail(p, kDeltaOutOfRange);
+                return i;
+            }
+            p.stats.copiedBytes += run;
+            result = deltaPatchCopyOld(p, io, run);
+            if (result != kDeltaOk)
+                return i;
+            p.remaining -= run;
+            p.segmentCount = count;
+            p.fieldCount = 0;
+            if (count > 0)
+                p.state = kDeltaStateAddBytes;
+            else if (p.remaining == 0)
+                p.state = kDeltaStateOp;
+            break;
+        }
+
+        case kDeltaStateAddBytes:
+        {
+            uint8_t old;
+            if (!deltaPatchOldByte(p, io, p.src++, old))
+            {
+                result = deltaPatchFail(p, kDeltaReadFailed);
+                return i;
+            }
+            if (data[i] != 0)
+                p.stats.patchedBytes++;
+            else
+                p.stats.copiedBytes++;
+            if (!deltaPatchEmit(p, io, (uint8_t)(old + data[i++])))
+            {
+                result = deltaPatchFail(p, kDeltaWriteFailed);
+                return i;
+            }
+            p.remaining--;
+            if (--p.segmentCount == 0)
+                p.state = p.remaining > 0 ? kDeltaStateAddSegment : kDeltaStateOp;
+            break;
+        }
+
+        case kDeltaStateLiteral:
+        {
+            size_t take = len - i;
+            if (take > p.remaining)
+                take = p.remaining;
+            for (size_t k = 0; k < take; k++)
+            {
+                if (!deltaPatchEmit(p, io, data[i + k]))
+                {
+                    result = deltaPatchFail(p, kDeltaWriteFailed);
+                    return i + k;
+                }
+            }
+            p.stats.literalBytes += take;
+            i += take;
+            p.remaining -= take;
+            if (p.remaining == 0)
+                p.state = kDeltaStateOp;
+            break;
+        }
+
+        case kDeltaStateDone:
+            result = deltaPatchFail(p, kDeltaTrailingData);
+            return i;
+
+        case kDeltaStateFailed:
+            result = p.error;
+            return i;
+        }
+    }
+    return i;
+}
+
+// Flushes buffered output; kDeltaOk only if the end op was seen and exactly
+// newSize bytes came out. The target digest is the caller's check.
+static inline DeltaPatchResult deltaPatchFinish(DeltaPatch &p, const DeltaPatchIo &io)
+{
+    if (p.state == kDeltaStateFailed)
+        return p.error;
+    if (!deltaPatchFlush(p, io))
+        return deltaPatchFail(p, kDeltaWriteFailed);
+    if (p.state != kDeltaStateDone || p.produced != p.header.newSize)
+        return deltaPatchFail(p, kDeltaTruncated);
+    return kDeltaOk;
+}
+
+static inline const char *deltaPatchResultText(DeltaPatchResult result)
+{
+    switch (result)
+    {
+        case kDeltaOk: return "ok";
+        case kDeltaHeaderDone: return "header parsed";
+        case kDeltaBadMagic: return "not a delta patch (APD1)";
+        case kDeltaBadOp: return "unknown patch op";
+        case kDeltaOutOfRange: return "patch op outside the image sizes";
+        case kDeltaReadFailed: return "reading the running image failed";
+        case kDeltaWriteFailed: return "firmware image write failed or exceeded OTA slot";
+        case kDeltaTrailingData: return "data after the end of the patch";
+        case kDeltaTruncated: return "patch ended early";
+    }
+    return "unknown";
+}
+
+// Length of the ESP32 app image at the start of a partition, from its segment
+// headers: the 24-byte image header, each segment's 8-byte header and data,
+// the checksum byte padded to a 16-byte boundary, and the SHA-256 the build
+// appends when header byte 23 is set. That is the firmware.bin a patch was
+// built from, so its digest can be taken before any patch arrives.
+static inline bool deltaPatchImageLength(const DeltaPatchIo &io, uint32_t limit, uint32_t &len)
+{
+    uint8_t header[DELTA_PATCH_IMAGE_HEADER_LEN];
+    if (limit < sizeof(header) || !io.readOld(io.ctx, 0, header, sizeof(header)))
+        return false;
+    if (header[0] != 0xE9 || header[1] == 0 || header[1] > DELTA_PATCH_IMAGE_MAX_SEGMENTS)
+        return false;
+    uint32_t offset = sizeof(header);
+    for (uint8_t i = 0; i < header[1]; i++)
+    {
+        uint8_t segment[8];
+        if (offset > limit - sizeof(segment) || !io.readOld(io.ctx, offset, segment, sizeof(segment)))
+            return false;
+        uint32_t dataLen = deltaPatchLe32(segment + 4);
+        offset += sizeof(segment);
+        if (dataLen > limit - offset)
+            return false;
+        offset += dataLen;
+    }
+    offset = (offset + 16) & ~15u;
+    if (header[23] == 1)
+        offset += SHA256_DIGEST_LEN;
+    if (offset > limit)
+        return false;
+    len = offset;
+    return true;
+}
+
+// SHA-256 of the first `size` bytes of the old image, taken a slice at a time
+// so the caller can spread it over many loop passes.
+struct DeltaPatchBaseHash
+{
+    Sha256 hash;
+    uint32_t size;
+    uint32_t offset;
+    bool ready;
+    uint8_t digest[SHA256_DIGEST_LEN];
+};
+
+static inline void deltaPatchBaseHashBegin(DeltaPatchBaseHash &b, uint32_t size)
+{
+    sha256Init(b.hash);
+    b.size = size;
+    b.offset = 0;
+    b.ready = false;
+}
+
+// Hashes up to `budget` more bytes. False only if a read fails.
+static inline bool deltaPatchBaseHashStep(DeltaPatchBaseHash &b, const DeltaPatchIo &io, uint32_t budget)
+{
+    uint8_t buf[DELTA_PATCH_WINDOW];
+    while (!b.ready && budget > 0)
+    {
+        uint32_t len = b.size - b.offset;
+        if (len > sizeof(buf))
+            len = sizeof(buf);
+        if (len > budget)
+            len = budget;
+        if (len > 0)
+        {
+            if (!io.readOld(io.ctx, b.offset, buf, len))
+                return false;
+            sha256Update(b.hash, buf, len);
+            b.offset += len;
+            budget -= len;
+        }
+        if (b.offset == b.size)
+        {
+            sha256Final(b.hash, b.digest);
+            b.ready = true;
+        }
+    }
+    return true;
+}
+
+// True once the digest is in and matches the patch's declared base.
+static inline bool deltaPatchBaseMatches(const DeltaPatchBaseHash &b, const DeltaPatchHeader &header)
+{
+    return b.ready && b.size == header.oldSize && memcmp(b.digest, header.oldSha, SHA256_DIGEST_LEN) == 0;
+}
@@ -5,6 +5,10 @@
 // panel-servo safety. Command handlers may still accept raw Marcduino commands
 // for compatibility, but disabled panel elements are overlaid onto servo routing
 // as no-op slots so unsafe hardware is not driven.
+//
+// The status table lives in RAM: it is loaded once at boot and every reader
+// uses it. Saves update it immediately and persist it as one packed NVS blob
+// (DomeElementStatusBlob.h) shortly afterwards from the web event loop.
 
 #include <Arduino.h>
 #include <Preferences.h>
@@ -25,8 +29,15 @@
 #define DOME_ELEMENT_STATUS_META_TEMPLATE "es_tid"
 #define DOME_ELEMENT_STATUS_META_REVISION "es_trev"
 #define DOME_ELEMENT_STATUS_META_ORDER_HASH "es_order"
+#define DOME_ELEMENT_STATUS_BLOB_KEY "es_blob"
 #define DOME_ELEMENT_STATUS_MAX_REASON_LEN 96
 #define DOME_ELEMENT_STATUS_MAX_ELEMENTS 64
+// Saves inside this window share one NVS write; a failed write is retried
+// after the retry delay.
+#define DOME_ELEMENT_STATUS_FLUSH_DELAY_MS 250
+#define DOME_ELEMENT_STATUS_FLUSH_RETRY_MS 5000
+
+#include "DomeElementStatusBlob.h"
 
 #if DOME_ELEMENT_STATUS_HAS_GENERATED_LAYOUT
 static_assert(DomeLayout::kElementCount <= DOME_ELEMENT_STATUS_MAX_ELEMENTS,
@@ -48,6 +59,50 @@ struct DomeElementStatusSnapshot
     String reason;
 };
 
+struct DomeElementStatusPersistStats
+{
+    const char *source;     // boot load origin: blob, mismatch, legacy or none
+    bool dirty;
+    bool legacyKeys;        // per-element keys still in NVS; dropped on next flush
+    uint32_t dirtySinceMs;
+    uint32_t retryAtMs;
+    uint32_t stagedSerial;
+    uint32_t saves;
+    uint32_t flushes;
+    uint32_t flushFailures;
+    uint32_t lastFlushUs;
+    uint32_t blobBytes;
+};
+
+// The generation counter lets response caches (the dome layout ETag) and
+// PATCH clients tell whether status changed without touching NVS. It is not
+// persisted: domeElementStatusLoad() starts it from a random per-boot value,
+// so a generation a client saw before a reboot cannot match the reloaded
+// table by coincidence.
+static uint32_t sDomeElementStatusGeneration = 1;
+static DomeElementStatusSnapshot sDomeElementStatusTable[DOME_ELEMENT_STATUS_MAX_ELEMENTS];
+static bool sDomeElementStatusTableLoaded = false;
+static bool sDomeElementStatusTableOk = false;
+static DomeElementStatusPersistStats sDomeElementStatusPersist = {};
+// Packed copy of the table awaiting its NVS write. Saves stage it on the web
+// task and the flush copies it out, both under the mux.
+static uint8_t *sDomeElementStatusPending = nullptr;
+static size_t sDomeElementStatusPendingLen = 0;
+static portMUX_TYPE sDomeElementStatusMux = portMUX_INITIALIZER_UNLOCKED;
+
+static const DomeElementStatusSnapshot *domeElementStatusCached(bool &statusOk);
+
+static inline uint32_t domeElementStatusGeneration()
+{
+    return sDomeElementStatusGeneration;
+}
+
+// Skips 0, which PATCH bodies cannot carry.
+static void domeElementStatusNoteChanged()
+{
+    if (++sDomeElementStatusGeneration == 0) sDomeElementStatusGeneration = 1;
+}
+
 #if DOME_ELEMENT_STATUS_HAS_GENERATED_LAYOUT
 // The generated layout table is the canonical allowlist once available. The
 // generator should keep kDomeLayoutElements in stable template order so NVS
@@ -78,6 +133,12 @@ static inline int domeElementStatusTemplateRevision()
 {
     return DomeLayout::kTemplateRevision;
 }
+
+// Status is keyed by kElements order, which the generated id index reports.
+static inline int domeElementStatusIndexOf(const char *id)
+{
+    return DomeLayout::elementIndexForId(id);
+}
 #else
 // Temporary MK4 allowlist used until GeneratedDomeLayout.h lands. Keep this
 // limited to stable canonical element IDs, not aliases, command targets, or
@@ -118,17 +179,23 @@ static inline int domeElementStatusTemplateRevision()
 {
     return 1;
 }
-#endif
 
-static int domeElementStatusIndexOf(const String &id)
+static int domeElementStatusIndexOf(const char *id)
 {
+    if (!id) return -1;
     for (int i = 0; i < domeElementStatusElementCount(); i++)
     {
         const char *known = domeElementStatusElementId(i);
-        if (known && id == known) return i;
+        if (known && strcmp(id, known) == 0) return i;
     }
     return -1;
 }
+#endif
+
+static inline int domeElementStatusIndexOf(const String &id)
+{
+    return domeElementStatusIndexOf(id.c_str());
+}
 
 static uint32_t domeElementStatusOrderHash()
 {
@@ -209,6 +276,23 @@ static bool domeElementStatusParseBool(const char *&p, bool &out)
     return false;
 }
 
+// Generations are positive 32-bit counters; anything else is rejected rather
+// than wrapped so a typo cannot accidentally match.
+static bool domeElementStatusParseGeneration(const char *&p, uint32_t &out)
+{
+    domeElementStatusSkipWs(p);
+    if (*p < '1' || *p > '9') return false;
+    uint64_t value = 0;
+    while (*p >= '0' && *p <= '9')
+    {
+        value = value * 10 + (uint64_t)(*p - '0');
+        if (value > 0xFFFFFFFFULL) return false;
+        p++;
+    }
+    out = (uint32_t)value;
+    return true;
+}
+
 static bool domeElementStatusExpectChar(const char *&p, char expected,
                                         String &errMsg)
 {
@@ -327,11 +411,52 @@ static bool domeElementStatusParseOneElement(const char *&p,
     return true;
 }
 
-static bool domeElementStatusParseBody(const String &body,
-                                       DomeElementStatusUpdate *updates,
-                                       int maxUpdates,
-                                       int &outCount,
-                                       String &errMsg)
+static bool domeElementStatusParseElements(const char *&p,
+                                           DomeElementStatusUpdate *updates,
+                                           int maxUpdates,
+                                           int &outCount,
+                                           bool *seenIds,
+                                           String &errMsg)
+{
+    if (!domeElementStatusExpectChar(p, '[', errMsg)) return false;
+    domeElementStatusSkipWs(p);
+    if (*p != ']')
+    {
+        while (true)
+        {
+            if (outCount >= maxUpdates)
+            {
+                errMsg = "too many element status updates";
+                return false;
+            }
+            if (!domeElementStatusParseOneElement(p, updates[outCount],
+                                                  seenIds, errMsg))
+            {
+                return false;
+            }
+            outCount++;
+            domeElementStatusSkipWs(p);
+            if (*p == ',')
+            {
+                p++;
+                continue;
+            }
+            if (*p == ']') break;
+            errMsg = "expected ',' or ']' in elements array";
+            return false;
+        }
+    }
+    return domeElementStatusExpectChar(p, ']', errMsg);
+}
+
+// Shared by POST (full body, `generation` not accepted) and PATCH, which
+// must carry the generation the client last saw in `generation`.
+static bool domeElementStatusParseRequest(const String &body,
+                                          DomeElementStatusUpdate *updates,
+                                          int maxUpdates,
+                                          int &outCount,
+                                          uint32_t *generation,
+                                          String &errMsg)
 {
     outCount = 0;
     int elementCount = domeElementStatusElementCount();
@@ -346,6 +471,7 @@ static bool domeElementStatusParseBody(const String &body,
     if (!domeElementStatusExpectChar(p, '{', errMsg)) return false;
 
     bool seenElements = false;
+    bool seenGeneration = false;
     while (true)
     {
         domeElementStatusSkipWs(p);
@@ -358,47 +484,39 @@ static bool domeElementStatusParseBody(const String &body,
         String key;
         if (!domeElementStatusParseJsonString(p, key, errMsg)) return false;
         if (!domeElementStatusExpectChar(p, ':', errMsg)) return false;
-        if (key != "elements")
-        {
-            errMsg = "unknown element-status field: " + key;
-            return false;
-        }
-        if (seenElements)
+        if (generation && key == "generation")
         {
-            errMsg = "duplicate elements field";
-            return false;
+            if (seenGeneration)
+            {
+                errMsg = "duplicate generation field";
+                return false;
+            }
+            if (!domeElementStatusParseGeneration(p, *generation))
+            {
+                errMsg = "generation must be a positive integer";
+                return false;
+            }
+            seenGeneration = true;
         }
-        seenElements = true;
-
-        if (!domeElementStatusExpectChar(p, '[', errMsg)) return false;
-        domeElementStatusSkipWs(p);
-        if (*p != ']')
+        else if (key == "elements")
         {
-            while (true)
+            if (seenElements)
+            {
+                errMsg = "duplicate elements field";
+                return false;
+            }
+            seenElements = true;
+            if (!domeElementStatusParseElements(p, updates, maxUpdates, outCount,
+                                                seenIds, errMsg))
             {
-                if (outCount >= maxUpdates)
-                {
-                    errMsg = "too many element status updates";
-                    return false;
-                }
-                if (!domeElementStatusParseOneElement(p, updates[outCount],
-                                                      seenIds, errMsg))
-                {
-                    return false;
-                }
-                outCount++;
-                domeElementStatusSkipWs(p);
-                if (*p == ',')
-                {
-                    p++;
-                    continue;
-                }
-                if (*p == ']') break;
-                errMsg = "expected ',' or ']' in elements array";
                 return false;
             }
         }
-        if (!domeElementStatusExpectChar(p, ']', errMsg)) return false;
+        else
+        {
+            errMsg = "unknown element-status field: " + key;
+            return false;
+        }
 
         domeElementStatusSkipWs(p);
         if (*p == ',')
@@ -420,6 +538,11 @@ static bool domeElementStatusParseBody(const String &body,
         errMsg = "missing elements array";
         return false;
     }
+    if (generation && !seenGeneration)
+    {
+        errMsg = "missing generation";
+        return false;
+    }
     domeElementStatusSkipWs(p);
     if (*p != '\0')
     {
@@ -429,51 +552,207 @@ static bool domeElementStatusParseBody(const String &body,
     return true;
 }
 
+static bool domeElementStatusParseBody(const String &body,
+                                       DomeElementStatusUpdate *updates,
+                                       int maxUpdates,
+                                       int &outCount,
+                                       String &errMsg)
+{
+    return domeElementStatusParseRequest(body, updates, maxUpdates, outCount,
+                                         nullptr, errMsg);
+}
+
+static void domeElementStatusAppendElementJson(String &json, int index, bool disabled,
+                                               const String &reason,
+                                               DomeElementStatusEscapeFn escapeFn)
+{
+    const char *id = domeElementStatusElementId(index);
+    json += "{\"id\":\"";
+    json += escapeFn(String(id ? id : ""));
+    json += "\",\"disabled\":";
+    json += disabled ? "true" : "false";
+    json += ",\"disabled_reason\":";
+    if (disabled && reason.length() > 0)
+    {
+        json += "\"";
+        json += escapeFn(reason);
+        json += "\"";
+    }
+    else
+    {
+        json += "null";
+    }
+    json += "}";
+}
+
+static void domeElementStatusBlobMetaCurrent(DomeElementStatusBlobMeta &meta)
+{
+    meta.count = (uint8_t)domeElementStatusElementCount();
+    meta.schemaRevision = (uint16_t)domeElementStatusSchemaRevision();
+    meta.templateRevision = (uint16_t)domeElementStatusTemplateRevision();
+    meta.orderHash = domeElementStatusOrderHash();
+    meta.templateIdHash = domeElementStatusBlobHash(domeElementStatusTemplateId());
+}
+
+// Packs a table into the pending buffer and marks it for the write-behind
+// flush. Encodes into scratch first, so a failure (no memory, or a table
+// that does not fit) stages nothing and leaves any earlier pending write
+// intact.
+static bool domeElementStatusStage(const bool *disabled, const char *const *reasons)
+{
+    if (!sDomeElementStatusPending)
+    {
+        sDomeElementStatusPending = (uint8_t *)malloc(DOME_ELEMENT_STATUS_BLOB_MAX_BYTES);
+        if (!sDomeElementStatusPending) return false;
+    }
+    uint8_t *scratch = (uint8_t *)malloc(DOME_ELEMENT_STATUS_BLOB_MAX_BYTES);
+    if (!scratch) return false;
+    DomeElementStatusBlobMeta meta;
+    domeElementStatusBlobMetaCurrent(meta);
+    size_t len = domeElementStatusBlobEncode(meta, disabled, reasons, scratch,
+                                             DOME_ELEMENT_STATUS_BLOB_MAX_BYTES);
+    if (len == 0)
+    {
+        free(scratch);
+        return false;
+    }
+    DomeElementStatusPersistStats &persist = sDomeElementStatusPersist;
+    portENTER_CRITICAL(&sDomeElementStatusMux);
+    memcpy(sDomeElementStatusPending, scratch, len);
+    sDomeElementStatusPendingLen = len;
+    persist.stagedSerial++;
+    if (!persist.dirty)
+    {
+        persist.dirty = true;
+        persist.dirtySinceMs = millis();
+    }
+    portEXIT_CRITICAL(&sDomeElementStatusMux);
+    free(scratch);
+    return true;
+}
+
+// Stages the RAM table as it stands.
+static bool domeElementStatusStagePending()
+{
+    bool disabled[DOME_ELEMENT_STATUS_MAX_ELEMENTS];
+    const char *reasons[DOME_ELEMENT_STATUS_MAX_ELEMENTS];
+    for (int i = 0; i < domeElementStatusElementCount(); i++)
+    {
+        disabled[i] = sDomeElementStatusTable[i].disabled;
+        reasons[i] = sDomeElementStatusTable[i].reason.c_str();
+    }
+    return domeElementStatusStage(disabled, reasons);
+}
+
+// Applies updates to the RAM table, which takes effect for readers at once.
+// NVS is written later by domeElementStatusPersistPending(). Entries that
+// already match the table are skipped; when nothing changes the generation
+// stays put and no write is staged. `changed` (room for
+// DOME_ELEMENT_STATUS_MAX_ELEMENTS) receives the indices that did change, in
+// element order; replacing an unavailable table reports every element.
+//
+// The new table is staged for NVS before it is applied: if staging fails the
+// save returns false with the RAM table and generation untouched, so a 500
+// never leaves a change live.
+//
+// Callers run on the web server task, which is the only writer, so a
+// generation check made just before this call cannot be overtaken.
 static bool domeElementStatusSaveUpdates(const DomeElementStatusUpdate *updates,
-                                         int updateCount)
+                                         int updateCount,
+                                         int *changed = nullptr,
+                                         int *changedCount = nullptr)
 {
-    Preferences prefs;
-    if (!prefs.begin(DOME_ELEMENT_STATUS_NS, false)) return false;
-    bool allOk = true;
-    // Status entries are keyed by generated element index to keep NVS keys
-    // short. Persist the layout identity beside them so a future template/table
-    // revision cannot accidentally read a stale flag for the wrong element.
-    if (prefs.putInt(DOME_ELEMENT_STATUS_META_SCHEMA,
-                     domeElementStatusSchemaRevision()) == 0) allOk = false;
-    if (allOk && prefs.putInt(DOME_ELEMENT_STATUS_META_REVISION,
-                              domeElementStatusTemplateRevision()) == 0) allOk = false;
-    if (allOk && prefs.putULong(DOME_ELEMENT_STATUS_META_ORDER_HASH,
-                                domeElementStatusOrderHash()) == 0) allOk = false;
-    if (allOk && prefs.putString(DOME_ELEMENT_STATUS_META_TEMPLATE,
-                                 domeElementStatusTemplateId()) == 0) allOk = false;
-    for (int i = 0; i < updateCount && allOk; i++)
+    if (changedCount) *changedCount = 0;
+    int count = domeElementStatusElementCount();
+    for (int i = 0; i < updateCount; i++)
     {
-        char disabledKey[12];
-        char reasonKey[12];
-        domeElementStatusKey(disabledKey, sizeof(disabledKey),
-                             DOME_ELEMENT_STATUS_DISABLED_FMT, updates[i].index);
-        domeElementStatusKey(reasonKey, sizeof(reasonKey),
-                             DOME_ELEMENT_STATUS_REASON_FMT, updates[i].index);
+        if (updates[i].index < 0 || updates[i].index >= count) return false;
+    }
+    bool statusOk = false;
+    domeElementStatusCached(statusOk);
+
+    // Build the proposed table. Stored status that was unreadable or written
+    // for another layout starts fresh rather than mixing in flags of unknown
+    // meaning. A later update for the same element wins.
+    bool disabled[DOME_ELEMENT_STATUS_MAX_ELEMENTS];
+    const char *reasons[DOME_ELEMENT_STATUS_MAX_ELEMENTS];
+    for (int i = 0; i < count; i++)
+    {
+        disabled[i] = statusOk && sDomeElementStatusTable[i].disabled;
+        reasons[i] = statusOk ? sDomeElementStatusTable[i].reason.c_str() : "";
+    }
+    for (int i = 0; i < updateCount; i++)
+    {
+        // Dropping the reason on enable keeps GET output from resurrecting an
+        // old maintenance note.
+        disabled[updates[i].index] = updates[i].disabled;
+        reasons[updates[i].index] = updates[i].disabled ? updates[i].reason.c_str() : "";
+    }
 
-        if (prefs.putBool(disabledKey, updates[i].disabled) == 0)
-        {
-            allOk = false;
-            break;
-        }
-        if (!updates[i].disabled || updates[i].reason.length() == 0)
-        {
-            // Missing keys are acceptable; the important persisted truth is the
-            // disabled boolean. Removing stale reasons keeps future GET output
-            // from resurrecting an old maintenance note.
-            if (prefs.isKey(reasonKey)) prefs.remove(reasonKey);
-        }
-        else if (prefs.putString(reasonKey, updates[i].reason) == 0)
-        {
-            allOk = false;
-        }
+    int changes = 0;
+    for (int i = 0; i < count; i++)
+    {
+        // Every element moves from "status unavailable" to a known state.
+        bool differs = !statusOk ||
+                       sDomeElementStatusTable[i].disabled != disabled[i] ||
+                       strcmp(sDomeElementStatusTable[i].reason.c_str(), reasons[i]) != 0;
+        if (!differs) continue;
+        if (changed) changed[changes] = i;
+        changes++;
     }
-    prefs.end();
-    return allOk;
+    if (changedCount) *changedCount = changes;
+    if (changes == 0) return true;
+    if (!domeElementStatusStage(disabled, reasons))
+    {
+        if (changedCount) *changedCount = 0;
+        return false;
+    }
+
+    for (int i = 0; i < count; i++)
+    {
+        DomeElementStatusSnapshot &entry = sDomeElementStatusTable[i];
+        if (entry.disabled == disabled[i] && strcmp(entry.reason.c_str(), reasons[i]) == 0) continue;
+        entry.disabled = disabled[i];
+        entry.reason = reasons[i];
+    }
+    sDomeElementStatusTableOk = true;
+    sDomeElementStatusPersist.saves++;
+    domeElementStatusNoteChanged();
+    return true;
+}
+
+enum DomeElementStatusPatchResult
+{
+    kDomeElementStatusPatchOk,
+    kDomeElementStatusPatchInvalid,     // errMsg says why; 400
+    kDomeElementStatusPatchStale,       // generation moved on; 409
+    kDomeElementStatusPatchSaveFailed   // nothing applied; 500
+};
+
+// PATCH /api/dome/element-status: parses the body, refuses it when the
+// generation it was based on is no longer current, and saves otherwise.
+static DomeElementStatusPatchResult domeElementStatusPatch(const String &body,
+                                                           int *changed,
+                                                           int &changedCount,
+                                                           String &errMsg)
+{
+    changedCount = 0;
+    DomeElementStatusUpdate updates[DOME_ELEMENT_STATUS_MAX_ELEMENTS];
+    int updateCount = 0;
+    uint32_t expectedGeneration = 0;
+    if (!domeElementStatusParseRequest(body, updates, DOME_ELEMENT_STATUS_MAX_ELEMENTS,
+                                       updateCount, &expectedGeneration, errMsg))
+    {
+        return kDomeElementStatusPatchInvalid;
+    }
+    if (expectedGeneration != domeElementStatusGeneration())
+    {
+        errMsg = String("based on ") + expectedGeneration + ", now " + domeElementStatusGeneration();
+        return kDomeElementStatusPatchStale;
+    }
+    if (!domeElementStatusSaveUpdates(updates, updateCount, changed, &changedCount))
+        return kDomeElementStatusPatchSaveFailed;
+    return kDomeElementStatusPatchOk;
 }
 
 static bool domeElementStatusMetadataMatches(Preferences &prefs)
@@ -531,34 +810,186 @@ static bool domeElementStatusReadAll(DomeElementStatusSnapshot *out, int maxCoun
 
 static String domeElementStatusBuildJson(DomeElementStatusEscapeFn escapeFn)
 {
-    DomeElementStatusSnapshot statuses[DOME_ELEMENT_STATUS_MAX_ELEMENTS];
     int count = domeElementStatusElementCount();
-    bool statusOk = domeElementStatusReadAll(statuses, DOME_ELEMENT_STATUS_MAX_ELEMENTS);
-    String json = "{\"elements\":[";
-    json.reserve(32 + (count * 72));
+    bool statusOk = false;
+    const DomeElementStatusSnapshot *statuses = domeElementStatusCached(statusOk);
+    String json = "{\"generation\":";
+    json.reserve(48 + (count * 72));
+    json += domeElementStatusGeneration();
+    json += ",\"elements\":[";
     for (int i = 0; i < count; i++)
     {
         if (i > 0) json += ',';
-        const char *id = domeElementStatusElementId(i);
         bool disabled = statusOk ? statuses[i].disabled : true;
         String reason = statusOk ? statuses[i].reason : "status unavailable";
-        json += "{\"id\":\"";
-        json += escapeFn(String(id ? id : ""));
-        json += "\",\"disabled\":";
-        json += disabled ? "true" : "false";
-        json += ",\"disabled_reason\":";
-        if (disabled && reason.length() > 0)
+        domeElementStatusAppendElementJson(json, i, disabled, reason, escapeFn);
+    }
+    json += "]}";
+    return json;
+}
+
+// WebSocket delta for the elements a save changed, so open pages can patch
+// their copy instead of refetching /api/dome/layout.
+static String domeElementStatusBuildDeltaJson(const int *changed, int changedCount,
+                                              DomeElementStatusEscapeFn escapeFn)
+{
+    String json = "{\"type\":\"elementStatus\",\"generation\":";
+    json.reserve(64 + (changedCount * 72));
+    json += domeElementStatusGeneration();
+    json += ",\"elements\":[";
+    for (int i = 0; i < changedCount; i++)
+    {
+        if (i > 0) json += ',';
+        const DomeElementStatusSnapshot &entry = sDomeElementStatusTable[changed[i]];
+        domeElementStatusAppendElementJson(json, changed[i], entry.disabled, entry.reason,
+                                           escapeFn);
+    }
+    json += "]}";
+    return json;
+}
+
+// Loads the table from the packed blob. Installs that predate the blob
+// still have per-element keys: they are read once through
+// domeElementStatusReadAll() and rewritten as a blob on the next flush.
+// Missing or mismatched status stays unavailable so callers fail closed.
+static void domeElementStatusLoad()
+{
+    DomeElementStatusPersistStats &persist = sDomeElementStatusPersist;
+    int count = domeElementStatusElementCount();
+    bool ok = false;
+    bool haveBlob = false;
+    persist.source = "none";
+    Preferences prefs;
+    if (prefs.begin(DOME_ELEMENT_STATUS_NS, true))
+    {
+        size_t len = prefs.getBytesLength(DOME_ELEMENT_STATUS_BLOB_KEY);
+        haveBlob = len > 0;
+        persist.legacyKeys = prefs.isKey(DOME_ELEMENT_STATUS_META_SCHEMA);
+        uint8_t *blob = haveBlob && len <= DOME_ELEMENT_STATUS_BLOB_MAX_BYTES
+            ? (uint8_t *)malloc(len) : nullptr;
+        char (*reasons)[DOME_ELEMENT_STATUS_MAX_REASON_LEN + 1] =
+            (char (*)[DOME_ELEMENT_STATUS_MAX_REASON_LEN + 1])malloc(
+                DOME_ELEMENT_STATUS_MAX_ELEMENTS * (DOME_ELEMENT_STATUS_MAX_REASON_LEN + 1));
+        bool disabled[DOME_ELEMENT_STATUS_MAX_ELEMENTS];
+        DomeElementStatusBlobMeta meta;
+        domeElementStatusBlobMetaCurrent(meta);
+        if (blob && reasons &&
+            prefs.getBytes(DOME_ELEMENT_STATUS_BLOB_KEY, blob, len) == len &&
+            domeElementStatusBlobDecode(blob, len, meta, disabled, reasons))
         {
-            json += "\"";
-            json += escapeFn(reason);
-            json += "\"";
+            for (int i = 0; i < count; i++)
+            {
+                sDomeElementStatusTable[i].disabled = disabled[i];
+                sDomeElementStatusTable[i].reason = reasons[i];
+            }
+            ok = true;
+            persist.source = "blob";
+            persist.blobBytes = len;
         }
-        else
+        else if (haveBlob)
         {
-            json += "null";
+            persist.source = "mismatch";
         }
-        json += "}";
+        free(blob);
+        free(reasons);
+        prefs.end();
     }
-    json += "]}";
-    return json;
+    if (!haveBlob && persist.legacyKeys)
+    {
+        ok = domeElementStatusReadAll(sDomeElementStatusTable, DOME_ELEMENT_STATUS_MAX_ELEMENTS);
+        persist.source = "legacy";
+    }
+    sDomeElementStatusTableOk = ok;
+    sDomeElementStatusTableLoaded = true;
+    sDomeElementStatusGeneration = esp_random() | 1;
+    if (ok && !haveBlob) domeElementStatusStagePending();
+}
+
+static const DomeElementStatusSnapshot *domeElementStatusCached(bool &statusOk)
+{
+    if (!sDomeElementStatusTableLoaded) domeElementStatusLoad();
+    statusOk = sDomeElementStatusTableOk;
+    return sDomeElementStatusTable;
+}
+
+static void domeElementStatusRemoveLegacyKeys(Preferences &prefs)
+{
+    for (int i = 0; i < DOME_ELEMENT_STATUS_MAX_ELEMENTS; i++)
+    {
+        char key[12];
+        domeElementStatusKey(key, sizeof(key), DOME_ELEMENT_STATUS_DISABLED_FMT, i);
+        if (prefs.isKey(key)) prefs.remove(key);
+        domeElementStatusKey(key, sizeof(key), DOME_ELEMENT_STATUS_REASON_FMT, i);
+        if (prefs.isKey(key)) prefs.remove(key);
+    }
+    static const char *const kMetaKeys[] = {
+        DOME_ELEMENT_STATUS_META_SCHEMA, DOME_ELEMENT_STATUS_META_REVISION,
+        DOME_ELEMENT_STATUS_META_TEMPLATE, DOME_ELEMENT_STATUS_META_ORDER_HASH
+    };
+    for (const char *key : kMetaKeys)
+    {
+        if (prefs.isKey(key)) prefs.remove(key);
+    }
+}
+
+// Writes the staged blob in one NVS put. A save that lands while the write
+// is in flight leaves the table dirty for the next pass.
+static bool domeElementStatusFlush()
+{
+    DomeElementStatusPersistStats &persist = sDomeElementStatusPersist;
+    uint8_t *blob = (uint8_t *)malloc(DOME_ELEMENT_STATUS_BLOB_MAX_BYTES);
+    if (!blob) return false;
+    portENTER_CRITICAL(&sDomeElementStatusMux);
+    size_t len = sDomeElementStatusPendingLen;
+    uint32_t serial = persist.stagedSerial;
+    memcpy(blob, sDomeElementStatusPending, len);
+    portEXIT_CRITICAL(&sDomeElementStatusMux);
+
+    uint32_t startUs = micros();
+    Preferences prefs;
+    bool ok = len > 0 && prefs.begin(DOME_ELEMENT_STATUS_NS, false);
+    if (ok)
+    {
+        ok = prefs.putBytes(DOME_ELEMENT_STATUS_BLOB_KEY, blob, len) == len;
+        if (ok && persist.legacyKeys)
+        {
+            domeElementStatusRemoveLegacyKeys(prefs);
+            persist.legacyKeys = false;
+        }
+        prefs.end();
+    }
+    free(blob);
+    persist.lastFlushUs = micros() - startUs;
+
+    portENTER_CRITICAL(&sDomeElementStatusMux);
+    if (ok && serial == persist.stagedSerial) persist.dirty = false;
+    portEXIT_CRITICAL(&sDomeElementStatusMux);
+    if (ok)
+    {
+        persist.flushes++;
+        persist.blobBytes = len;
+        persist.retryAtMs = 0;
+    }
+    else
+    {
+        persist.flushFailures++;
+        persist.retryAtMs = millis() + DOME_ELEMENT_STATUS_FLUSH_RETRY_MS;
+    }
+    return ok;
+}
+
+// Write-behind step, called from the web event loop.
+static void domeElementStatusPersistPending(uint32_t nowMs)
+{
+    DomeElementStatusPersistStats &persist = sDomeElementStatusPersist;
+    if (!persist.dirty) return;
+    if ((uint32_t)(nowMs - persist.dirtySinceMs) < DOME_ELEMENT_STATUS_FLUSH_DELAY_MS) return;
+    if (persist.retryAtMs != 0 && (int32_t)(nowMs - persist.retryAtMs) < 0) return;
+    domeElementStatusFlush();
+}
+
+// Flushes immediately; used before a reboot.
+static void domeElementStatusPersistNow()
+{
+    if (sDomeElementStatusPersist.dirty) domeElementStatusFlush();
 }
@@ -0,0 +1,131 @@
+#pragma once
+// DomeElementStatusBlob.h — packed NVS form of the dome element status table.
+//
+// One NVS blob replaces the per-element es_d%d/es_r%d keys, so a save is a
+// single write instead of up to 128. The header carries the layout identity
+// the old metadata keys held; a blob written for a different template, schema
+// or element order is refused and the caller fails closed.
+//
+// Layout (little-endian):
+//   [0] version  [1] element count  [2..3] schema revision
+//   [4..5] template revision  [6..9] element order hash  [10..13] template id hash
+//   then per element: flags (bit0 disabled), reason length, reason bytes
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#ifndef DOME_ELEMENT_STATUS_MAX_REASON_LEN
+#define DOME_ELEMENT_STATUS_MAX_REASON_LEN 96
+#endif
+#ifndef DOME_ELEMENT_STATUS_MAX_ELEMENTS
+#define DOME_ELEMENT_STATUS_MAX_ELEMENTS 64
+#endif
+
+#define DOME_ELEMENT_STATUS_BLOB_VERSION 1
+#define DOME_ELEMENT_STATUS_BLOB_HEADER_BYTES 14
+#define DOME_ELEMENT_STATUS_BLOB_FLAG_DISABLED 0x01
+#define DOME_ELEMENT_STATUS_BLOB_MAX_BYTES \
+    (DOME_ELEMENT_STATUS_BLOB_HEADER_BYTES + \
+     DOME_ELEMENT_STATUS_MAX_ELEMENTS * (2 + DOME_ELEMENT_STATUS_MAX_REASON_LEN))
+
+struct DomeElementStatusBlobMeta
+{
+    uint8_t count;
+    uint16_t schemaRevision;
+    uint16_t templateRevision;
+    uint32_t orderHash;
+    uint32_t templateIdHash;
+};
+
+static inline uint32_t domeElementStatusBlobHash(const char *text)
+{
+    uint32_t hash = 2166136261UL;
+    for (const char *p = text; p && *p; p++)
+    {
+        hash ^= (uint8_t)*p;
+        hash *= 16777619UL;
+    }
+    return hash;
+}
+
+static inline void domeElementStatusBlobPut32(uint8_t *p, uint32_t v)
+{
+    for (int i = 0; i < 4; i++) p[i] = (uint8_t)(v >> (8 * i));
+}
+
+static inline uint32_t domeElementStatusBlobGet32(const uint8_t *p)
+{
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+// Packs meta.count entries. Reasons are only kept for disabled elements and
+// are clipped to DOME_ELEMENT_STATUS_MAX_REASON_LEN. Returns the blob length,
+// or 0 if `cap` is too small.
+static size_t domeElementStatusBlobEncode(const DomeElementStatusBlobMeta &meta,
+                                          const bool *disabled,
+                                          const char *const *reasons,
+                                          uint8_t *out, size_t cap)
+{
+    if (cap < DOME_ELEMENT_STATUS_BLOB_HEADER_BYTES || meta.count > DOME_ELEMENT_STATUS_MAX_ELEMENTS)
+        return 0;
+    out[0] = DOME_ELEMENT_STATUS_BLOB_VERSION;
+    out[1] = meta.count;
+    out[2] = (uint8_t)meta.schemaRevision;
+    out[3] = (uint8_t)(meta.schemaRevision >> 8);
+    out[4] = (uint8_t)meta.templateRevision;
+    out[5] = (uint8_t)(meta.templateRevision >> 8);
+    domeElementStatusBlobPut32(out + 6, meta.orderHash);
+    domeElementStatusBlobPut32(out + 10, meta.templateIdHash);
+    size_t len = DOME_ELEMENT_STATUS_BLOB_HEADER_BYTES;
+    for (int i = 0; i < meta.count; i++)
+    {
+        size_t reasonLen = (disabled[i] && reasons[i]) ? strlen(reasons[i]) : 0;
+        if (reasonLen > DOME_ELEMENT_STATUS_MAX_REASON_LEN) reasonLen = DOME_ELEMENT_STATUS_MAX_REASON_LEN;
+        if (len + 2 + reasonLen > cap) return 0;
+        out[len++] = disabled[i] ? DOME_ELEMENT_STATUS_BLOB_FLAG_DISABLED : 0;
+        out[len++] = (uint8_t)reasonLen;
+        if (reasonLen > 0) memcpy(out + len, reasons[i], reasonLen);
+        len += reasonLen;
+    }
+    return len;
+}
+
+// Unpacks a blob written for `expected`. Fails (leaving the outputs
+// unspecified) on any identity mismatch or malformed entry; `reasons` rows
+// are NUL-terminated.
+static bool domeElementStatusBlobDecode(const uint8_t *blob, size_t len,
+                                        const DomeElementStatusBlobMeta &expected,
+                                        bool *disabled,
+                                        char (*reasons)[DOME_ELEMENT_STATUS_MAX_REASON_LEN + 1])
+{
+    if (len < DOME_ELEMENT_STATUS_BLOB_HEADER_BYTES ||
+        blob[0] != DOME_ELEMENT_STATUS_BLOB_VERSION ||
+        blob[1] != expected.count ||
+        (uint16_t)(blob[2] | (blob[3] << 8)) != expected.schemaRevision ||
+        (uint16_t)(blob[4] | (blob[5] << 8)) != expected.templateRevision ||
+        domeElementStatusBlobGet32(blob + 6) != expected.orderHash ||
+        domeElementStatusBlobGet32(blob + 10) != expected.templateIdHash)
+    {
+        return false;
+    }
+    size_t pos = DOME_ELEMENT_STATUS_BLOB_HEADER_BYTES;
+    for (int i = 0; i < expected.count; i++)
+    {
+        if (pos + 2 > len) return false;
+        uint8_t flags = blob[pos++];
+        uint8_t reasonLen = blob[pos++];
+        if ((flags & ~DOME_ELEMENT_STATUS_BLOB_FLAG_DISABLED) != 0 ||
+            reasonLen > DOME_ELEMENT_STATUS_MAX_REASON_LEN ||
+            (reasonLen > 0 && !(flags & DOME_ELEMENT_STATUS_BLOB_FLAG_DISABLED)) ||
+            pos + reasonLen > len)
+        {
+            return false;
+        }
+        disabled[i] = (flags & DOME_ELEMENT_STATUS_BLOB_FLAG_DISABLED) != 0;
+        memcpy(reasons[i], blob + pos, reasonLen);
+        reasons[i][reasonLen] = '\0';
+        pos += reasonLen;
+    }
+    return pos == len;
+}
@@ -0,0 +1,1006 @@
+#pragma once
+// DomeLayoutCompiled.h — compiled binary form of a dome layout template.
+//
+// A custom template is compiled once when it is installed so later serves and
+// validity checks read fixed-size records instead of re-tokenising JSON.
+// tools/generate_dome_layout_header.py --compiled-output writes the same
+// bytes on the host; tools/test_dome_layout_compiled.py checks they match.
+//
+// Layout (little-endian, no padding):
+//   header   60 bytes, field offsets in domeLayoutCompiledReadHeader()
+//   strings  NUL-terminated, de-duplicated, in document order
+//   refs     uint16 string offsets; per element its aliases then capabilities
+//   floats   float32; per element geometry, label anchor, callout, connector
+//   records  20 bytes per element, sorted by (render_order, id)
+// String offset 0xFFFF means null. The CRC32 covers the whole file with the
+// CRC field zeroed.
+
+#include <stdlib.h>
+
+#include "DomeLayoutTemplateStream.h"
+
+#define DOME_LAYOUT_COMPILED_MAGIC "APDL"
+#define DOME_LAYOUT_COMPILED_VERSION 1
+#define DOME_LAYOUT_COMPILED_HEADER_BYTES 60
+#define DOME_LAYOUT_COMPILED_CRC_OFFSET 56
+#define DOME_LAYOUT_COMPILED_RECORD_BYTES 20
+#define DOME_LAYOUT_COMPILED_MAX_BYTES 32768
+#define DOME_LAYOUT_COMPILED_MAX_ALIASES 8
+#define DOME_LAYOUT_COMPILED_MAX_CAPABILITIES 9
+#define DOME_LAYOUT_COMPILED_MAX_FLOATS_PER_ELEMENT 15
+#define DOME_LAYOUT_COMPILED_NULL 0xFFFF
+
+#define DOME_LAYOUT_COMPILED_FLAG_IN_LAYOUT 0x01
+#define DOME_LAYOUT_COMPILED_FLAG_COMMANDABLE 0x02
+#define DOME_LAYOUT_COMPILED_FLAG_LABEL_ANCHOR 0x04
+#define DOME_LAYOUT_COMPILED_FLAG_CALLOUT 0x08
+#define DOME_LAYOUT_COMPILED_FLAG_CONNECTOR 0x10
+
+#define DOME_LAYOUT_COMPILED_GEOMETRY_NONE 0xFF
+
+static const char *const kDomeLayoutCompiledElementTypes[] = { "panel", "holo", "logic", "psi" };
+static const char *const kDomeLayoutCompiledPanelKinds[] = { nullptr, "ring", "pie", "fixed" };
+static const char *const kDomeLayoutCompiledGeometryTypes[] = { "svg_path", "circle", "ellipse", "point" };
+
+struct DomeLayoutCompiledHeader
+{
+    uint16_t elementCount;
+    uint16_t schemaRevision;
+    uint16_t templateRevision;
+    uint16_t templateId;
+    uint16_t templateName;
+    uint16_t model;
+    uint16_t source;
+    uint16_t viewBox;
+    uint16_t refCount;
+    uint32_t stringsOffset;
+    uint32_t stringsSize;
+    uint32_t refsOffset;
+    uint32_t floatsOffset;
+    uint32_t floatCount;
+    uint32_t recordsOffset;
+    uint32_t sourceSize;
+    uint32_t sourceCrc;
+    uint32_t crc;
+};
+
+struct DomeLayoutCompiledRecord
+{
+    uint16_t id;
+    uint16_t label;
+    uint16_t mountedOn;
+    uint16_t svgPath;
+    uint16_t renderOrder;
+    uint16_t refsFirst;
+    uint16_t floatsFirst;
+    uint8_t aliasCount;
+    uint8_t capabilityCount;
+    uint8_t elementType;
+    uint8_t panelKind;
+    uint8_t geometryType;
+    uint8_t flags;
+};
+
+static uint32_t domeLayoutCrc32Update(uint32_t crc, const uint8_t *data, size_t len)
+{
+    crc = ~crc;
+    for (size_t i = 0; i < len; i++)
+    {
+        crc ^= data[i];
+        for (int bit = 0; bit < 8; bit++)
+            crc = (crc >> 1) ^ (0xEDB88320UL & (0U - (crc & 1U)));
+    }
+    return ~crc;
+}
+
+static inline uint16_t domeLayoutCompiledU16(const uint8_t *p)
+{
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static inline uint32_t domeLayoutCompiledU32(const uint8_t *p)
+{
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static inline void domeLayoutCompiledPutU16(uint8_t *p, uint16_t v)
+{
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+}
+
+static inline void domeLayoutCompiledPutU32(uint8_t *p, uint32_t v)
+{
+    for (int i = 0; i < 4; i++) p[i] = (uint8_t)(v >> (8 * i));
+}
+
+static int domeLayoutCompiledFloatCount(const DomeLayoutCompiledRecord &rec)
+{
+    int n = 0;
+    if (rec.geometryType == 1 || rec.geometryType == 3) n += 3;
+    else if (rec.geometryType == 2) n += 5;
+    if (rec.flags & DOME_LAYOUT_COMPILED_FLAG_LABEL_ANCHOR) n += 2;
+    if (rec.flags & DOME_LAYOUT_COMPILED_FLAG_CALLOUT) n += 3;
+    if (rec.flags & DOME_LAYOUT_COMPILED_FLAG_CONNECTOR) n += 2;
+    return n;
+}
+
+static void domeLayoutCompiledReadHeader(const uint8_t *blob, DomeLayoutCompiledHeader &h)
+{
+    h.elementCount = domeLayoutCompiledU16(blob + 6);
+    h.schemaRevision = domeLayoutCompiledU16(blob + 8);
+    h.templateRevision = domeLayoutCompiledU16(blob + 10);
+    h.templateId = domeLayoutCompiledU16(blob + 12);
+    h.templateName = domeLayoutCompiledU16(blob + 14);
+    h.model = domeLayoutCompiledU16(blob + 16);
+    h.source = domeLayoutCompiledU16(blob + 18);
+    h.viewBox = domeLayoutCompiledU16(blob + 20);
+    h.refCount = domeLayoutCompiledU16(blob + 22);
+    h.stringsOffset = domeLayoutCompiledU32(blob + 24);
+    h.stringsSize = domeLayoutCompiledU32(blob + 28);
+    h.refsOffset = domeLayoutCompiledU32(blob + 32);
+    h.floatsOffset = domeLayoutCompiledU32(blob + 36);
+    h.floatCount = domeLayoutCompiledU32(blob + 40);
+    h.recordsOffset = domeLayoutCompiledU32(blob + 44);
+    h.sourceSize = domeLayoutCompiledU32(blob + 48);
+    h.sourceCrc = domeLayoutCompiledU32(blob + 52);
+    h.crc = domeLayoutCompiledU32(blob + DOME_LAYOUT_COMPILED_CRC_OFFSET);
+}
+
+static void domeLayoutCompiledWriteHeader(uint8_t *blob, const DomeLayoutCompiledHeader &h)
+{
+    memcpy(blob, DOME_LAYOUT_COMPILED_MAGIC, 4);
+    blob[4] = DOME_LAYOUT_COMPILED_VERSION;
+    blob[5] = 0;
+    domeLayoutCompiledPutU16(blob + 6, h.elementCount);
+    domeLayoutCompiledPutU16(blob + 8, h.schemaRevision);
+    domeLayoutCompiledPutU16(blob + 10, h.templateRevision);
+    domeLayoutCompiledPutU16(blob + 12, h.templateId);
+    domeLayoutCompiledPutU16(blob + 14, h.templateName);
+    domeLayoutCompiledPutU16(blob + 16, h.model);
+    domeLayoutCompiledPutU16(blob + 18, h.source);
+    domeLayoutCompiledPutU16(blob + 20, h.viewBox);
+    domeLayoutCompiledPutU16(blob + 22, h.refCount);
+    domeLayoutCompiledPutU32(blob + 24, h.stringsOffset);
+    domeLayoutCompiledPutU32(blob + 28, h.stringsSize);
+    domeLayoutCompiledPutU32(blob + 32, h.refsOffset);
+    domeLayoutCompiledPutU32(blob + 36, h.floatsOffset);
+    domeLayoutCompiledPutU32(blob + 40, h.floatCount);
+    domeLayoutCompiledPutU32(blob + 44, h.recordsOffset);
+    domeLayoutCompiledPutU32(blob + 48, h.sourceSize);
+    domeLayoutCompiledPutU32(blob + 52, h.sourceCrc);
+    domeLayoutCompiledPutU32(blob + DOME_LAYOUT_COMPILED_CRC_OFFSET, h.crc);
+}
+
+static void domeLayoutCompiledReadRecord(const uint8_t *blob, const DomeLayoutCompiledHeader &h,
+                                         size_t index, DomeLayoutCompiledRecord &rec)
+{
+    const uint8_t *p = blob + h.recordsOffset + index * DOME_LAYOUT_COMPILED_RECORD_BYTES;
+    rec.id = domeLayoutCompiledU16(p);
+    rec.label = domeLayoutCompiledU16(p + 2);
+    rec.mountedOn = domeLayoutCompiledU16(p + 4);
+    rec.svgPath = domeLayoutCompiledU16(p + 6);
+    rec.renderOrder = domeLayoutCompiledU16(p + 8);
+    rec.refsFirst = domeLayoutCompiledU16(p + 10);
+    rec.floatsFirst = domeLayoutCompiledU16(p + 12);
+    rec.aliasCount = p[14];
+    rec.capabilityCount = p[15];
+    rec.elementType = p[16];
+    rec.panelKind = p[17];
+    rec.geometryType = p[18];
+    rec.flags = p[19];
+}
+
+static void domeLayoutCompiledWriteRecord(uint8_t *p, const DomeLayoutCompiledRecord &rec)
+{
+    domeLayoutCompiledPutU16(p, rec.id);
+    domeLayoutCompiledPutU16(p + 2, rec.label);
+    domeLayoutCompiledPutU16(p + 4, rec.mountedOn);
+    domeLayoutCompiledPutU16(p + 6, rec.svgPath);
+    domeLayoutCompiledPutU16(p + 8, rec.renderOrder);
+    domeLayoutCompiledPutU16(p + 10, rec.refsFirst);
+    domeLayoutCompiledPutU16(p + 12, rec.floatsFirst);
+    p[14] = rec.aliasCount;
+    p[15] = rec.capabilityCount;
+    p[16] = rec.elementType;
+    p[17] = rec.panelKind;
+    p[18] = rec.geometryType;
+    p[19] = rec.flags;
+}
+
+static const char *domeLayoutCompiledString(const uint8_t *blob, const DomeLayoutCompiledHeader &h,
+                                            uint16_t ref)
+{
+    if (ref == DOME_LAYOUT_COMPILED_NULL || ref >= h.stringsSize) return nullptr;
+    return (const char *)blob + h.stringsOffset + ref;
+}
+
+static uint16_t domeLayoutCompiledRef(const uint8_t *blob, const DomeLayoutCompiledHeader &h,
+                                      uint32_t index)
+{
+    return domeLayoutCompiledU16(blob + h.refsOffset + index * 2);
+}
+
+static float domeLayoutCompiledFloat(const uint8_t *blob, const DomeLayoutCompiledHeader &h,
+                                     uint32_t index)
+{
+    float value;
+    memcpy(&value, blob + h.floatsOffset + index * 4, sizeof(value));
+    return value;
+}
+
+static bool domeLayoutCompiledRefOk(const DomeLayoutCompiledHeader &h, uint16_t ref, bool nullable)
+{
+    if (ref == DOME_LAYOUT_COMPILED_NULL) return nullable;
+    return ref < h.stringsSize;
+}
+
+static uint32_t domeLayoutCompiledCrc(const uint8_t *blob, size_t len)
+{
+    static const uint8_t kZero[4] = { 0, 0, 0, 0 };
+    uint32_t crc = domeLayoutCrc32Update(0, blob, DOME_LAYOUT_COMPILED_CRC_OFFSET);
+    crc = domeLayoutCrc32Update(crc, kZero, sizeof(kZero));
+    return domeLayoutCrc32Update(crc, blob + DOME_LAYOUT_COMPILED_HEADER_BYTES,
+                                 len - DOME_LAYOUT_COMPILED_HEADER_BYTES);
+}
+
+// Structural check of a compiled blob: bounds, enums, references and CRC.
+// Everything the decoder below touches is verified here first.
+static bool domeLayoutCompiledCheck(const uint8_t *blob, size_t len, DomeLayoutCompiledHeader &h,
+                                    char *err, size_t errLen)
+{
+    if (len < DOME_LAYOUT_COMPILED_HEADER_BYTES || len > DOME_LAYOUT_COMPILED_MAX_BYTES ||
+        memcmp(blob, DOME_LAYOUT_COMPILED_MAGIC, 4) != 0 || blob[4] != DOME_LAYOUT_COMPILED_VERSION)
+    {
+        snprintf(err, errLen, "not a version %d compiled layout", DOME_LAYOUT_COMPILED_VERSION);
+        return false;
+    }
+    domeLayoutCompiledReadHeader(blob, h);
+    if (domeLayoutCompiledCrc(blob, len) != h.crc)
+    {
+        snprintf(err, errLen, "compiled layout CRC mismatch");
+        return false;
+    }
+    if (h.stringsOffset != DOME_LAYOUT_COMPILED_HEADER_BYTES ||
+        h.stringsSize == 0 || h.stringsSize >= DOME_LAYOUT_COMPILED_NULL ||
+        blob[h.stringsOffset + h.stringsSize - 1] != '\0' ||
+        h.refsOffset != h.stringsOffset + h.stringsSize ||
+        h.floatsOffset != h.refsOffset + (uint32_t)h.refCount * 2 ||
+        h.recordsOffset != h.floatsOffset + h.floatCount * 4 ||
+        h.elementCount == 0 || h.elementCount > DOME_LAYOUT_TEMPLATE_MAX_ELEMENTS ||
+        (size_t)h.recordsOffset + (size_t)h.elementCount * DOME_LAYOUT_COMPILED_RECORD_BYTES != len)
+    {
+        snprintf(err, errLen, "compiled layout sections are inconsistent");
+        return false;
+    }
+    if (!domeLayoutCompiledRefOk(h, h.templateId, false) ||
+        !domeLayoutCompiledRefOk(h, h.templateName, false) ||
+        !domeLayoutCompiledRefOk(h, h.model, true) ||
+        !domeLayoutCompiledRefOk(h, h.source, true) ||
+        !domeLayoutCompiledRefOk(h, h.viewBox, false))
+    {
+        snprintf(err, errLen, "compiled layout header string out of range");
+        return false;
+    }
+    for (uint32_t i = 0; i < h.refCount; i++)
+    {
+        if (!domeLayoutCompiledRefOk(h, domeLayoutCompiledRef(blob, h, i), false))
+        {
+            snprintf(err, errLen, "compiled layout list string out of range");
+            return false;
+        }
+    }
+    for (size_t i = 0; i < h.elementCount; i++)
+    {
+        DomeLayoutCompiledRecord rec;
+        domeLayoutCompiledReadRecord(blob, h, i, rec);
+        bool geometryOk = (rec.flags & DOME_LAYOUT_COMPILED_FLAG_IN_LAYOUT)
+                              ? rec.geometryType <= 3
+                              : rec.geometryType == DOME_LAYOUT_COMPILED_GEOMETRY_NONE;
+        if (!domeLayoutCompiledRefOk(h, rec.id, false) ||
+            !domeLayoutCompiledRefOk(h, rec.label, false) ||
+            !domeLayoutCompiledRefOk(h, rec.mountedOn, true) ||
+            !domeLayoutCompiledRefOk(h, rec.svgPath, rec.geometryType != 0) ||
+            rec.elementType > 3 || rec.panelKind > 3 || !geometryOk ||
+            (uint32_t)rec.refsFirst + rec.aliasCount + rec.capabilityCount > h.refCount ||
+            (uint32_t)rec.floatsFirst + domeLayoutCompiledFloatCount(rec) > h.floatCount)
+        {
+            snprintf(err, errLen, "compiled layout record %u is invalid", (unsigned)i);
+            return false;
+        }
+    }
+    return true;
+}
+
+// Fills a DomeLayoutElement view of record `index` so compiled and bundled
+// layouts share one renderer. String pointers alias the blob; aliases and
+// capabilities are written to the caller's scratch arrays.
+static void domeLayoutCompiledElement(const uint8_t *blob, const DomeLayoutCompiledHeader &h,
+                                      size_t index, DomeLayout::DomeLayoutElement &out,
+                                      const char **aliases, const char **capabilities)
+{
+    DomeLayoutCompiledRecord rec;
+    domeLayoutCompiledReadRecord(blob, h, index, rec);
+    memset(&out, 0, sizeof(out));
+    out.id = domeLayoutCompiledString(blob, h, rec.id);
+    out.label = domeLayoutCompiledString(blob, h, rec.label);
+    out.elementType = kDomeLayoutCompiledElementTypes[rec.elementType];
+    out.panelKind = kDomeLayoutCompiledPanelKinds[rec.panelKind];
+    out.mountedOn = domeLayoutCompiledString(blob, h, rec.mountedOn);
+    out.inLayout = (rec.flags & DOME_LAYOUT_COMPILED_FLAG_IN_LAYOUT) != 0;
+    out.commandable = (rec.flags & DOME_LAYOUT_COMPILED_FLAG_COMMANDABLE) != 0;
+    for (uint8_t i = 0; i < rec.aliasCount; i++)
+        aliases[i] = domeLayoutCompiledString(blob, h, domeLayoutCompiledRef(blob, h, rec.refsFirst + i));
+    for (uint8_t i = 0; i < rec.capabilityCount; i++)
+        capabilities[i] = domeLayoutCompiledString(blob, h,
+            domeLayoutCompiledRef(blob, h, rec.refsFirst + rec.aliasCount + i));
+    out.aliases = aliases;
+    out.aliasCount = rec.aliasCount;
+    out.capabilities = capabilities;
+    out.capabilityCount = rec.capabilityCount;
+    out.renderOrder = rec.renderOrder;
+    out.svgPath = domeLayoutCompiledString(blob, h, rec.svgPath);
+
+    uint32_t f = rec.floatsFirst;
+    switch (rec.geometryType)
+    {
+        case 0:
+            out.geometryType = DomeLayout::DomeLayoutGeometryType::SvgPath;
+            break;
+        case 2:
+            out.geometryType = DomeLayout::DomeLayoutGeometryType::Ellipse;
+            out.cx = domeLayoutCompiledFloat(blob, h, f++);
+            out.cy = domeLayoutCompiledFloat(blob, h, f++);
+            out.rx = domeLayoutCompiledFloat(blob, h, f++);
+            out.ry = domeLayoutCompiledFloat(blob, h, f++);
+            out.rotation = domeLayoutCompiledFloat(blob, h, f++);
+            break;
+        case 1:
+        case 3:
+            out.geometryType = rec.geometryType == 1 ? DomeLayout::DomeLayoutGeometryType::Circle
+                                                     : DomeLayout::DomeLayoutGeometryType::Point;
+            out.cx = domeLayoutCompiledFloat(blob, h, f++);
+            out.cy = domeLayoutCompiledFloat(blob, h, f++);
+            out.r = domeLayoutCompiledFloat(blob, h, f++);
+            break;
+        default:
+            out.geometryType = DomeLayout::DomeLayoutGeometryType::Point;
+            break;
+    }
+    if (rec.flags & DOME_LAYOUT_COMPILED_FLAG_LABEL_ANCHOR)
+    {
+        out.labelAnchor.present = true;
+        out.labelAnchor.x = domeLayoutCompiledFloat(blob, h, f++);
+        out.labelAnchor.y = domeLayoutCompiledFloat(blob, h, f++);
+    }
+    if (rec.flags & DOME_LAYOUT_COMPILED_FLAG_CALLOUT)
+    {
+        out.callout.present = true;
+        out.callout.x = domeLayoutCompiledFloat(blob, h, f++);
+        out.callout.y = domeLayoutCompiledFloat(blob, h, f++);
+        out.callout.r = domeLayoutCompiledFloat(blob, h, f++);
+    }
+    if (rec.flags & DOME_LAYOUT_COMPILED_FLAG_CONNECTOR)
+    {
+        out.callout.connectorPresent = true;
+        out.callout.connectorX = domeLayoutCompiledFloat(blob, h, f++);
+        out.callout.connectorY = domeLayoutCompiledFloat(blob, h, f++);
+    }
+}
+
+// ---------------------------------------------------------------
+// Compiler: a second pass over a template the stream validator accepted.
+// ---------------------------------------------------------------
+
+struct DomeLayoutCompiledElementBuild
+{
+    DomeLayoutCompiledRecord rec;
+    uint16_t aliases[DOME_LAYOUT_COMPILED_MAX_ALIASES];
+    uint16_t capabilities[DOME_LAYOUT_COMPILED_MAX_CAPABILITIES];
+    float floats[DOME_LAYOUT_COMPILED_MAX_FLOATS_PER_ELEMENT];
+};
+
+struct DomeLayoutCompiledBuilder
+{
+    char *strings;
+    size_t stringsLen;
+    size_t stringsCap;
+    uint16_t refs[DOME_LAYOUT_TEMPLATE_MAX_ELEMENTS *
+                  (DOME_LAYOUT_COMPILED_MAX_ALIASES + DOME_LAYOUT_COMPILED_MAX_CAPABILITIES)];
+    uint16_t refCount;
+    float floats[DOME_LAYOUT_TEMPLATE_MAX_ELEMENTS * DOME_LAYOUT_COMPILED_MAX_FLOATS_PER_ELEMENT];
+    uint32_t floatCount;
+    DomeLayoutCompiledRecord records[DOME_LAYOUT_TEMPLATE_MAX_ELEMENTS];
+    uint16_t elementCount;
+    DomeLayoutCompiledHeader header;
+    DomeLayoutStreamReadFn sourceRead;
+    void *sourceCtx;
+    uint32_t sourceCrc;
+    uint32_t sourceBytes;
+};
+
+static size_t domeLayoutCompiledSourceRead(void *ctx, uint8_t *buf, size_t len)
+{
+    DomeLayoutCompiledBuilder *b = (DomeLayoutCompiledBuilder *)ctx;
+    size_t n = b->sourceRead(b->sourceCtx, buf, len);
+    b->sourceCrc = domeLayoutCrc32Update(b->sourceCrc, buf, n);
+    b->sourceBytes += (uint32_t)n;
+    return n;
+}
+
+// Parses a string straight into the string table, then folds it onto an
+// earlier identical entry if there is one.
+static bool domeLayoutCompiledIntern(DomeLayoutTemplateStream &s, DomeLayoutCompiledBuilder &b,
+                                     uint16_t &ref)
+{
+    char *slot = b.strings + b.stringsLen;
+    bool truncated = false;
+    if (!domeLayoutStreamParseString(s, slot, b.stringsCap - b.stringsLen, &truncated)) return false;
+    if (truncated) return domeLayoutStreamFail(s, "compiled string table is full");
+    size_t len = strlen(slot);
+    for (size_t at = 0; at < b.stringsLen; at += strlen(b.strings + at) + 1)
+    {
+        if (strcmp(b.strings + at, slot) == 0)
+        {
+            ref = (uint16_t)at;
+            return true;
+        }
+    }
+    if (b.stringsLen + len + 1 >= DOME_LAYOUT_COMPILED_NULL)
+        return domeLayoutStreamFail(s, "compiled string table is full");
+    ref = (uint16_t)b.stringsLen;
+    b.stringsLen += len + 1;
+    return true;
+}
+
+static bool domeLayoutCompiledInternNullable(DomeLayoutTemplateStream &s, DomeLayoutCompiledBuilder &b,
+                                             uint16_t &ref)
+{
+    domeLayoutStreamSkipWs(s);
+    if (domeLayoutStreamPeek(s) != 'n') return domeLayoutCompiledIntern(s, b, ref);
+    ref = DOME_LAYOUT_COMPILED_NULL;
+    if (!domeLayoutStreamParseLiteral(s, "null")) return domeLayoutStreamFail(s, "expected string or null");
+    return true;
+}
+
+static bool domeLayoutCompiledParseNumber(DomeLayoutTemplateStream &s, float &out)
+{
+    domeLayoutStreamSkipWs(s);
+    char token[32];
+    size_t n = 0;
+    while (true)
+    {
+        int c = domeLayoutStreamPeek(s);
+        if (!((c >= '0' && c <= '9') || c == '-' || c == '+' || c == '.' || c == 'e' || c == 'E')) break;
+        if (n + 1 >= sizeof(token)) return domeLayoutStreamFail(s, "invalid number");
+        token[n++] = (char)domeLayoutStreamTake(s);
+    }
+    token[n] = '\0';
+    char *end = nullptr;
+    double value = strtod(token, &end);
+    if (n == 0 || *end != '\0') return domeLayoutStreamFail(s, "invalid number");
+    out = (float)value;
+    return true;
+}
+
+static int domeLayoutCompiledEnumIndex(const char *value, const char *const *names, int count)
+{
+    for (int i = 0; i < count; i++)
+    {
+        if (names[i] && strcmp(value, names[i]) == 0) return i;
+    }
+    return -1;
+}
+
+// Reads an object of number fields named in `keys` into `values`; `seen`
+// gets one bit per key found. Keys the compiled form does not carry are
+// skipped, as everywhere else in the compiler.
+static bool domeLayoutCompiledNumbers(DomeLayoutTemplateStream &s, DomeLayoutCompiledBuilder &b,
+                                      const char *const *keys, int keyCount, float *values,
+                                      uint32_t &seen, char *geometryType, uint16_t *svgPath)
+{
+    if (!domeLayoutStreamEnter(s)) return false;
+    if (!domeLayoutStreamExpectChar(s, '{')) return false;
+    char key[DOME_LAYOUT_STREAM_MAX_TOKEN + 1];
+    seen = 0;
+    domeLayoutStreamSkipWs(s);
+    while (domeLayoutStreamPeek(s) != '}')
+    {
+        if (!domeLayoutStreamParseKey(s, key, sizeof(key))) return false;
+        int index = domeLayoutCompiledEnumIndex(key, keys, keyCount);
+        if (index >= 0)
+        {
+            if (!domeLayoutCompiledParseNumber(s, values[index])) return false;
+            seen |= 1UL << index;
+        }
+        else if (geometryType && strcmp(key, "type") == 0)
+        {
+            if (!domeLayoutStreamParseString(s, geometryType, 16)) return false;
+        }
+        else if (svgPath && strcmp(key, "d") == 0)
+        {
+            if (!domeLayoutCompiledIntern(s, b, *svgPath)) return false;
+        }
+        else if (!domeLayoutStreamSkipValue(s))
+        {
+            return false;
+        }
+        domeLayoutStreamSkipWs(s);
+        int c = domeLayoutStreamPeek(s);
+        if (c == ',')
+        {
+            domeLayoutStreamTake(s);
+            domeLayoutStreamSkipWs(s);
+            continue;
+        }
+        if (c != '}') return domeLayoutStreamFail(s, "expected ',' or '}'");
+    }
+    domeLayoutStreamTake(s);
+    s.depth--;
+    return true;
+}
+
+static bool domeLayoutCompiledStringList(DomeLayoutTemplateStream &s, DomeLayoutCompiledBuilder &b,
+                                         uint16_t *refs, uint8_t maxCount, uint8_t &count)
+{
+    if (!domeLayoutStreamExpectChar(s, '[')) return false;
+    count = 0;
+    domeLayoutStreamSkipWs(s);
+    while (domeLayoutStreamPeek(s) != ']')
+    {
+        if (count >= maxCount) return domeLayoutStreamFail(s, "too many list entries");
+        if (!domeLayoutCompiledIntern(s, b, refs[count++])) return false;
+        domeLayoutStreamSkipWs(s);
+        if (domeLayoutStreamPeek(s) == ',')
+        {
+            domeLayoutStreamTake(s);
+            domeLayoutStreamSkipWs(s);
+        }
+        else if (domeLayoutStreamPeek(s) != ']')
+        {
+            return domeLayoutStreamFail(s, "expected ',' or ']'");
+        }
+    }
+    domeLayoutStreamTake(s);
+    return true;
+}
+
+static bool domeLayoutCompiledElementObject(DomeLayoutTemplateStream &s, DomeLayoutCompiledBuilder &b)
+{
+    static const char *const kGeometryKeys[] = { "cx", "cy", "r", "rx", "ry", "rotation" };
+    static const char *const kPointKeys[] = { "x", "y" };
+    static const char *const kCalloutKeys[] = { "x", "y", "r" };
+
+    if (b.elementCount >= DOME_LAYOUT_TEMPLATE_MAX_ELEMENTS)
+        return domeLayoutStreamFail(s, "too many layout elements");
+    DomeLayoutCompiledElementBuild e;
+    memset(&e, 0, sizeof(e));
+    e.rec.mountedOn = DOME_LAYOUT_COMPILED_NULL;
+    e.rec.svgPath = DOME_LAYOUT_COMPILED_NULL;
+    e.rec.label = DOME_LAYOUT_COMPILED_NULL;
+    e.rec.geometryType = DOME_LAYOUT_COMPILED_GEOMETRY_NONE;
+    char geometryType[16] = "";
+    float geometry[6] = { 0, 0, 0, 0, 0, 0 };
+    float labelAnchor[2] = { 0, 0 };
+    float callout[3] = { 0, 0, 0 };
+    float connector[2] = { 0, 0 };
+    uint32_t geometrySeen = 0;
+    bool hasGeometry = false;
+    char key[DOME_LAYOUT_STREAM_MAX_TOKEN + 1];
+    char small[16];
+
+    if (!domeLayoutStreamEnter(s)) return false;
+    if (!domeLayoutStreamExpectChar(s, '{')) return false;
+    domeLayoutStreamSkipWs(s);
+    while (domeLayoutStreamPeek(s) != '}')
+    {
+        if (!domeLayoutStreamParseKey(s, key, sizeof(key))) return false;
+        bool flag = false;
+        if (strcmp(key, "id") == 0)
+        {
+            if (!domeLayoutCompiledIntern(s, b, e.rec.id)) return false;
+        }
+        else if (strcmp(key, "label") == 0)
+        {
+            if (!domeLayoutCompiledIntern(s, b, e.rec.label)) return false;
+        }
+        else if (strcmp(key, "mounted_on") == 0)
+        {
+            if (!domeLayoutCompiledInternNullable(s, b, e.rec.mountedOn)) return false;
+        }
+        else if (strcmp(key, "aliases") == 0)
+        {
+            if (!domeLayoutCompiledStringList(s, b, e.aliases, DOME_LAYOUT_COMPILED_MAX_ALIASES,
+                                              e.rec.aliasCount)) return false;
+        }
+        else if (strcmp(key, "capabilities") == 0)
+        {
+            if (!domeLayoutCompiledStringList(s, b, e.capabilities, DOME_LAYOUT_COMPILED_MAX_CAPABILITIES,
+                                              e.rec.capabilityCount)) return false;
+        }
+        else if (strcmp(key, "in_layout") == 0 || strcmp(key, "commandable") == 0)
+        {
+            if (!domeLayoutStreamParseBool(s, flag)) return domeLayoutStreamFail(s, "%s must be boolean", key);
+            uint8_t bit = key[0] == 'i' ? DOME_LAYOUT_COMPILED_FLAG_IN_LAYOUT : DOME_LAYOUT_COMPILED_FLAG_COMMANDABLE;
+            if (flag) e.rec.flags |= bit;
+        }
+        else if (strcmp(key, "element_type") == 0)
+        {
+            if (!domeLayoutStreamParseString(s, small, sizeof(small))) return false;
+            int index = domeLayoutCompiledEnumIndex(small, kDomeLayoutCompiledElementTypes, 4);
+            if (index < 0) return domeLayoutStreamFail(s, "unsupported element_type: %s", small);
+            e.rec.elementType = (uint8_t)index;
+        }
+        else if (strcmp(key, "panel_kind") == 0)
+        {
+            domeLayoutStreamSkipWs(s);
+            if (domeLayoutStreamPeek(s) == 'n')
+            {
+                if (!domeLayoutStreamParseLiteral(s, "null")) return domeLayoutStreamFail(s, "expected string");
+                e.rec.panelKind = 0;
+            }
+            else
+            {
+                if (!domeLayoutStreamParseString(s, small, sizeof(small))) return false;
+                int index = domeLayoutCompiledEnumIndex(small, kDomeLayoutCompiledPanelKinds, 4);
+                if (index < 0) return domeLayoutStreamFail(s, "unsupported panel_kind: %s", small);
+                e.rec.panelKind = (uint8_t)index;
+            }
+        }
+        else if (strcmp(key, "render_order") == 0)
+        {
+            int order = 0;
+            if (!domeLayoutStreamParseInt(s, order) || order < 0 || order > 65535)
+                return domeLayoutStreamFail(s, "render_order must be 0..65535");
+            e.rec.renderOrder = (uint16_t)order;
+        }
+        else if (strcmp(key, "geometry") == 0)
+        {
+            if (!domeLayoutCompiledNumbers(s, b, kGeometryKeys, 6, geometry, geometrySeen,
+                                           geometryType, &e.rec.svgPath)) return false;
+            hasGeometry = true;
+        }
+        else if (strcmp(key, "label_anchor") == 0)
+        {
+            uint32_t seen = 0;
+            if (!domeLayoutCompiledNumbers(s, b, kPointKeys, 2, labelAnchor, seen, nullptr, nullptr)) return false;
+            if (seen != 0x3) return domeLayoutStreamFail(s, "label_anchor requires x and y");
+            e.rec.flags |= DOME_LAYOUT_COMPILED_FLAG_LABEL_ANCHOR;
+        }
+        else if (strcmp(key, "callout") == 0)
+        {
+            // callout carries a nested connector_to object, so it is walked here.
+            if (!domeLayoutStreamEnter(s)) return false;
+            if (!domeLayoutStreamExpectChar(s, '{')) return false;
+            uint32_t seen = 0;
+            domeLayoutStreamSkipWs(s);
+            while (domeLayoutStreamPeek(s) != '}')
+            {
+                if (!domeLayoutStreamParseKey(s, key, sizeof(key))) return false;
+                int index = domeLayoutCompiledEnumIndex(key, kCalloutKeys, 3);
+                if (index >= 0)
+                {
+                    if (!domeLayoutCompiledParseNumber(s, callout[index])) return false;
+                    seen |= 1UL << index;
+                }
+                else if (strcmp(key, "connector_to") == 0)
+                {
+                    uint32_t connectorSeen = 0;
+                    if (!domeLayoutCompiledNumbers(s, b, kPointKeys, 2, connector, connectorSeen,
+                                                   nullptr, nullptr)) return false;
+                    if (connectorSeen != 0x3) return domeLayoutStreamFail(s, "connector_to requires x and y");
+                    e.rec.flags |= DOME_LAYOUT_COMPILED_FLAG_CONNECTOR;
+                }
+                else if (!domeLayoutStreamSkipValue(s))
+                {
+                    return false;
+                }
+                domeLayoutStreamSkipWs(s);
+                if (domeLayoutStreamPeek(s) == ',')
+                {
+                    domeLayoutStreamTake(s);
+                    domeLayoutStreamSkipWs(s);
+                }
+                else if (domeLayoutStreamPeek(s) != '}')
+                {
+                    return domeLayoutStreamFail(s, "expected ',' or '}'");
+                }
+            }
+            domeLayoutStreamTake(s);
+            s.depth--;
+            if (seen != 0x7) return domeLayoutStreamFail(s, "callout requires x, y and r");
+            e.rec.flags |= DOME_LAYOUT_COMPILED_FLAG_CALLOUT;
+        }
+        else if (!domeLayoutStreamSkipValue(s))
+        {
+            return false;
+        }
+        domeLayoutStreamSkipWs(s);
+        int c = domeLayoutStreamPeek(s);
+        if (c == ',')
+        {
+            domeLayoutStreamTake(s);
+            domeLayoutStreamSkipWs(s);
+            continue;
+        }
+        if (c != '}') return domeLayoutStreamFail(s, "expected ',' or '}' in element");
+    }
+    domeLayoutStreamTake(s);
+    s.depth--;
+
+    if (e.rec.label == DOME_LAYOUT_COMPILED_NULL) return domeLayoutStreamFail(s, "element label is required");
+    bool inLayout = (e.rec.flags & DOME_LAYOUT_COMPILED_FLAG_IN_LAYOUT) != 0;
+    if (inLayout != hasGeometry) return domeLayoutStreamFail(s, "geometry must be present exactly when in_layout");
+
+    // Floats go out in a fixed order per element; see the file header.
+    int n = 0;
+    if (hasGeometry)
+    {
+        int type = domeLayoutCompiledEnumIndex(geometryType, kDomeLayoutCompiledGeometryTypes, 4);
+        if (type < 0) return domeLayoutStreamFail(s, "unsupported geometry type: %s", geometryType);
+        e.rec.geometryType = (uint8_t)type;
+        uint32_t need = type == 0 ? 0 : type == 2 ? 0x1B : 0x07;
+        if (type == 3 && !(geometrySeen & 0x4)) geometry[2] = DomeLayout::kDefaultPointMarkerRadius;
+        if (type == 3) geometrySeen |= 0x4;
+        if ((type == 0) != (e.rec.svgPath != DOME_LAYOUT_COMPILED_NULL) ||
+            (geometrySeen & need) != need)
+            return domeLayoutStreamFail(s, "geometry is incomplete for type %s", geometryType);
+        if (type == 1 || type == 3)
+        {
+            e.floats[n++] = geometry[0];
+            e.floats[n++] = geometry[1];
+            e.floats[n++] = geometry[2];
+        }
+        else if (type == 2)
+        {
+            for (int i = 0; i < 2; i++) e.floats[n++] = geometry[i];
+            for (int i = 3; i < 6; i++) e.floats[n++] = geometry[i];
+        }
+    }
+    if (e.rec.flags & DOME_LAYOUT_COMPILED_FLAG_LABEL_ANCHOR)
+    {
+        e.floats[n++] = labelAnchor[0];
+        e.floats[n++] = labelAnchor[1];
+    }
+    if (e.rec.flags & DOME_LAYOUT_COMPILED_FLAG_CALLOUT)
+    {
+        for (int i = 0; i < 3; i++) e.floats[n++] = callout[i];
+    }
+    if (e.rec.flags & DOME_LAYOUT_COMPILED_FLAG_CONNECTOR)
+    {
+        e.floats[n++] = connector[0];
+        e.floats[n++] = connector[1];
+    }
+
+    e.rec.refsFirst = b.refCount;
+    for (uint8_t i = 0; i < e.rec.aliasCount; i++) b.refs[b.refCount++] = e.aliases[i];
+    for (uint8_t i = 0; i < e.rec.capabilityCount; i++) b.refs[b.refCount++] = e.capabilities[i];
+    e.rec.floatsFirst = (uint16_t)b.floatCount;
+    for (int i = 0; i < n; i++) b.floats[b.floatCount++] = e.floats[i];
+    b.records[b.elementCount++] = e.rec;
+    return true;
+}
+
+static bool domeLayoutCompiledRoot(DomeLayoutTemplateStream &s, DomeLayoutCompiledBuilder &b)
+{
+    DomeLayoutCompiledHeader &h = b.header;
+    char key[DOME_LAYOUT_STREAM_MAX_TOKEN + 1];
+    if (!domeLayoutStreamExpectChar(s, '{')) return false;
+    domeLayoutStreamSkipWs(s);
+    while (domeLayoutStreamPeek(s) != '}')
+    {
+        if (!domeLayoutStreamParseKey(s, key, sizeof(key))) return false;
+        int value = 0;
+        if (strcmp(key, "schema_revision") == 0 || strcmp(key, "template_revision") == 0)
+        {
+            if (!domeLayoutStreamParseInt(s, value) || value < 0 || value > 65535)
+                return domeLayoutStreamFail(s, "%s must be 0..65535", key);
+            if (key[0] == 's') h.schemaRevision = (uint16_t)value;
+            else h.templateRevision = (uint16_t)value;
+        }
+        else if (strcmp(key, "template_id") == 0)
+        {
+            if (!domeLayoutCompiledIntern(s, b, h.templateId)) return false;
+        }
+        else if (strcmp(key, "template_name") == 0)
+        {
+            if (!domeLayoutCompiledIntern(s, b, h.templateName)) return false;
+        }
+        else if (strcmp(key, "model") == 0)
+        {
+            if (!domeLayoutCompiledInternNullable(s, b, h.model)) return false;
+        }
+        else if (strcmp(key, "source") == 0)
+        {
+            if (!domeLayoutCompiledInternNullable(s, b, h.source)) return false;
+        }
+        else if (strcmp(key, "coordinate_space") == 0)
+        {
+            if (!domeLayoutStreamExpectChar(s, '{')) return false;
+            domeLayoutStreamSkipWs(s);
+            while (domeLayoutStreamPeek(s) != '}')
+            {
+                if (!domeLayoutStreamParseKey(s, key, sizeof(key))) return false;
+                if (strcmp(key, "viewBox") == 0)
+                {
+                    if (!domeLayoutCompiledIntern(s, b, h.viewBox)) return false;
+                }
+                else if (!domeLayoutStreamSkipValue(s))
+                {
+                    return false;
+                }
+                domeLayoutStreamSkipWs(s);
+                if (domeLayoutStreamPeek(s) == ',')
+                {
+                    domeLayoutStreamTake(s);
+                    domeLayoutStreamSkipWs(s);
+                }
+                else if (domeLayoutStreamPeek(s) != '}')
+                {
+                    return domeLayoutStreamFail(s, "expected ',' or '}'");
+                }
+            }
+            domeLayoutStreamTake(s);
+        }
+        else if (strcmp(key, "elements") == 0)
+        {
+            if (!domeLayoutStreamExpectChar(s, '[')) return false;
+            domeLayoutStreamSkipWs(s);
+            while (domeLayoutStreamPeek(s) != ']')
+            {
+                if (!domeLayoutCompiledElementObject(s, b)) return false;
+                domeLayoutStreamSkipWs(s);
+                if (domeLayoutStreamPeek(s) == ',')
+                {
+                    domeLayoutStreamTake(s);
+                    domeLayoutStreamSkipWs(s);
+                }
+                else if (domeLayoutStreamPeek(s) != ']')
+                {
+                    return domeLayoutStreamFail(s, "expected ',' or ']' in elements array");
+                }
+            }
+            domeLayoutStreamTake(s);
+        }
+        else if (!domeLayoutStreamSkipValue(s))
+        {
+            return false;
+        }
+        domeLayoutStreamSkipWs(s);
+        int c = domeLayoutStreamPeek(s);
+        if (c == ',')
+        {
+            domeLayoutStreamTake(s);
+            domeLayoutStreamSkipWs(s);
+            continue;
+        }
+        if (c != '}') return domeLayoutStreamFail(s, "expected ',' or '}' in template root");
+    }
+    domeLayoutStreamTake(s);
+    if (h.templateId == DOME_LAYOUT_COMPILED_NULL || h.templateName == DOME_LAYOUT_COMPILED_NULL ||
+        h.viewBox == DOME_LAYOUT_COMPILED_NULL || b.elementCount == 0)
+    {
+        return domeLayoutStreamFail(s, "template missing required root fields");
+    }
+    return true;
+}
+
+static bool domeLayoutCompiledRecordBefore(const DomeLayoutCompiledBuilder &b,
+                                           const DomeLayoutCompiledRecord &a,
+                                           const DomeLayoutCompiledRecord &c)
+{
+    if (a.renderOrder != c.renderOrder) return a.renderOrder < c.renderOrder;
+    return strcmp(b.strings + a.id, b.strings + c.id) < 0;
+}
+
+// Compiles the template read from `read` into a malloc'd blob. The builder
+// (about 8 KB) and a string table of `stringsCap` bytes are heap-allocated
+// for the duration of the call. `stringsCap` should be the source size,
+// which the decoded strings can never exceed.
+static bool domeLayoutCompileTemplate(DomeLayoutStreamReadFn read, void *readCtx, size_t stringsCap,
+                                      uint8_t *&blobOut, size_t &blobLen,
+                                      char *err, size_t errLen)
+{
+    blobOut = nullptr;
+    blobLen = 0;
+    DomeLayoutCompiledBuilder *b = (DomeLayoutCompiledBuilder *)calloc(1, sizeof(DomeLayoutCompiledBuilder));
+    char *strings = (char *)malloc(stringsCap + 1);
+    if (!b || !strings)
+    {
+        free(b);
+        free(strings);
+        snprintf(err, errLen, "out of memory compiling layout");
+        return false;
+    }
+    b->strings = strings;
+    b->stringsCap = stringsCap + 1;
+    b->sourceRead = read;
+    b->sourceCtx = readCtx;
+    b->header.templateId = DOME_LAYOUT_COMPILED_NULL;
+    b->header.templateName = DOME_LAYOUT_COMPILED_NULL;
+    b->header.model = DOME_LAYOUT_COMPILED_NULL;
+    b->header.source = DOME_LAYOUT_COMPILED_NULL;
+    b->header.viewBox = DOME_LAYOUT_COMPILED_NULL;
+
+    DomeLayoutStreamResult result;
+    memset(&result, 0, sizeof(result));
+    DomeLayoutTemplateStream s;
+    memset(&s, 0, sizeof(s));
+    s.read = domeLayoutCompiledSourceRead;
+    s.readCtx = b;
+    s.result = &result;
+
+    bool ok = domeLayoutCompiledRoot(s, *b) && !s.failed;
+    if (ok)
+    {
+        domeLayoutStreamSkipWs(s);
+        ok = domeLayoutStreamPeek(s) < 0 && !s.failed;
+        if (!ok) domeLayoutStreamFail(s, "trailing content after template JSON");
+    }
+    if (ok)
+    {
+        // Stable insertion sort; element counts are tiny.
+        for (uint16_t i = 1; i < b->elementCount; i++)
+        {
+            DomeLayoutCompiledRecord rec = b->records[i];
+            int j = i - 1;
+            while (j >= 0 && domeLayoutCompiledRecordBefore(*b, rec, b->records[j]))
+            {
+                b->records[j + 1] = b->records[j];
+                j--;
+            }
+            b->records[j + 1] = rec;
+        }
+        DomeLayoutCompiledHeader &h = b->header;
+        h.elementCount = b->elementCount;
+        h.refCount = b->refCount;
+        h.stringsOffset = DOME_LAYOUT_COMPILED_HEADER_BYTES;
+        h.stringsSize = (uint32_t)b->stringsLen;
+        h.refsOffset = h.stringsOffset + h.stringsSize;
+        h.floatCount = b->floatCount;
+        h.floatsOffset = h.refsOffset + (uint32_t)h.refCount * 2;
+        h.recordsOffset = h.floatsOffset + h.floatCount * 4;
+        h.sourceSize = b->sourceBytes;
+        h.sourceCrc = b->sourceCrc;
+        h.crc = 0;
+        blobLen = h.recordsOffset + (size_t)h.elementCount * DOME_LAYOUT_COMPILED_RECORD_BYTES;
+        if (blobLen > DOME_LAYOUT_COMPILED_MAX_BYTES)
+        {
+            ok = false;
+            domeLayoutStreamFail(s, "compiled layout exceeds %u bytes", (unsigned)DOME_LAYOUT_COMPILED_MAX_BYTES);
+        }
+        else
+        {
+            blobOut = (uint8_t *)malloc(blobLen);
+            ok = blobOut != nullptr;
+            if (!ok) domeLayoutStreamFail(s, "out of memory compiling layout");
+        }
+    }
+    if (ok)
+    {
+        DomeLayoutCompiledHeader &h = b->header;
+        memcpy(blobOut + h.stringsOffset, b->strings, h.stringsSize);
+        for (uint16_t i = 0; i < h.refCount; i++)
+            domeLayoutCompiledPutU16(blobOut + h.refsOffset + i * 2, b->refs[i]);
+        for (uint32_t i = 0; i < h.floatCount; i++)
+        {
+            uint32_t bits;
+            memcpy(&bits, &b->floats[i], sizeof(bits));
+            domeLayoutCompiledPutU32(blobOut + h.floatsOffset + i * 4, bits);
+        }
+        for (uint16_t i = 0; i < h.elementCount; i++)
+            domeLayoutCompiledWriteRecord(blobOut + h.recordsOffset + i * DOME_LAYOUT_COMPILED_RECORD_BYTES,
+                                          b->records[i]);
+        domeLayoutCompiledWriteHeader(blobOut, h);
+        h.crc = domeLayoutCompiledCrc(blobOut, blobLen);
+        domeLayoutCompiledPutU32(blobOut + DOME_LAYOUT_COMPILED_CRC_OFFSET, h.crc);
+    }
+    else
+    {
+        snprintf(err, errLen, "%s", result.error);
+        blobLen = 0;
+    }
+    free(b->strings);
+    free(b);
+    return ok;
+}
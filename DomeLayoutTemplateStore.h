@@ -2,8 +2,11 @@
 // DomeLayoutTemplateStore.h — SPIFFS-backed dome layout template selection.
 //
 // Custom templates are display/layout data only. This storage layer rejects
-// backend fields such as commands, slots, channels, and targets, then composes
-// the selected template with runtime status before it is served externally.
+// backend fields such as commands, slots, channels, and targets. Validation
+// runs through DomeLayoutTemplateStream.h, which reads the file in fixed
+// chunks instead of loading it into a String. An installed template is
+// compiled to DomeLayoutCompiled.h records next to the JSON; serves and checks
+// read those records, and the runtime status overlay is added on top.
 
 #include <Arduino.h>
 #include <Preferences.h>
@@ -16,9 +19,14 @@
 #define DOME_LAYOUT_TEMPLATE_USE_CUSTOM "use_custom"
 #define DOME_LAYOUT_TEMPLATE_PATH "/dome-layout-template.json"
 #define DOME_LAYOUT_TEMPLATE_TMP_PATH "/dome-layout-template.tmp"
+#define DOME_LAYOUT_TEMPLATE_COMPILED_PATH "/dome-layout-template.apdl"
+#define DOME_LAYOUT_TEMPLATE_COMPILED_TMP_PATH "/dome-layout-template.apdt"
 #define DOME_LAYOUT_TEMPLATE_MAX_BYTES 32768
 #define DOME_LAYOUT_TEMPLATE_MAX_ELEMENTS 64
 
+#include "DomeLayoutTemplateStream.h"
+#include "DomeLayoutCompiled.h"
+
 static_assert(DomeLayout::kElementCount <= DOME_LAYOUT_TEMPLATE_MAX_ELEMENTS,
               "Dome layout known identity count exceeds template validator storage");
 
@@ -32,6 +40,7 @@ struct DomeLayoutTemplateInfo
     int schemaRevision;
     int templateRevision;
     size_t sizeBytes;
+    bool compiled;
     String error;
 };
 
@@ -60,98 +69,20 @@ static bool domeLayoutTemplateExpectChar(const char *&p, char expected,
     return true;
 }
 
-static bool domeLayoutTemplateParseInt(const char *&p, int &out)
-{
-    domeLayoutTemplateSkipWs(p);
-    bool negative = false;
-    if (*p == '-')
-    {
-        negative = true;
-        p++;
-    }
-    if (*p < '0' || *p > '9') return false;
-    long value = 0;
-    while (*p >= '0' && *p <= '9')
-    {
-        value = (value * 10) + (*p - '0');
-        if (value > 1000000L) return false;
-        p++;
-    }
-    out = negative ? -(int)value : (int)value;
-    return true;
-}
-
-static bool domeLayoutTemplateParseLiteral(const char *&p, const char *literal)
-{
-    domeLayoutTemplateSkipWs(p);
-    size_t len = strlen(literal);
-    if (strncmp(p, literal, len) != 0) return false;
-    p += len;
-    return true;
-}
-
-static bool domeLayoutTemplateParseBool(const char *&p, bool &out)
-{
-    if (domeLayoutTemplateParseLiteral(p, "true"))
-    {
-        out = true;
-        return true;
-    }
-    if (domeLayoutTemplateParseLiteral(p, "false"))
-    {
-        out = false;
-        return true;
-    }
-    return false;
-}
-
 static int domeLayoutTemplateFindKnownId(const String &id)
 {
-    for (size_t i = 0; i < DomeLayout::kElementCount; i++)
-    {
-        if (id == DomeLayout::kElements[i].id) return (int)i;
-    }
-    return -1;
+    return domeLayoutStreamFindKnownId(id.c_str());
 }
 
 static bool domeLayoutTemplateIsCommandableId(const String &id)
 {
-    for (size_t i = 0; i < DomeLayout::kElementCount; i++)
-    {
-        const DomeLayout::DomeLayoutElement &element = DomeLayout::kElements[i];
-        if (id == element.id) return element.commandable;
-    }
-    return false;
-}
-
-static bool domeLayoutTemplateIsElementType(const String &value)
-{
-    return value == "panel" ||
-           value == "holo" ||
-           value == "logic" ||
-           value == "psi";
-}
-
-static bool domeLayoutTemplateIsPanelKind(const String &value)
-{
-    return value == "ring" ||
-           value == "pie" ||
-           value == "fixed";
+    int index = DomeLayout::elementIndexForId(id.c_str());
+    return index >= 0 && DomeLayout::kElements[index].commandable;
 }
 
 static bool domeLayoutTemplateHasForbiddenBackendKey(const String &key)
 {
-    return key == "cmd" ||
-           key == "command" ||
-           key == "command_target" ||
-           key == "target" ||
-           key == "slot" ||
-           key == "channel" ||
-           key == "bus" ||
-           key == "address" ||
-           key == "spi_chain" ||
-           key == "pca9685_channel" ||
-           key == "servo_channel";
+    return domeLayoutStreamIsForbiddenBackendKey(key.c_str());
 }
 
 static bool domeLayoutTemplateSkipJsonValue(const char *&p, String &errMsg);
@@ -267,7 +198,25 @@ static bool domeLayoutTemplateFindRootString(const String &json, const char *wan
     }
 }
 
-static bool domeLayoutTemplateReadFile(String &out, String &errMsg)
+static void domeLayoutTemplateApplyStreamResult(const DomeLayoutStreamResult &result,
+                                                DomeLayoutTemplateInfo &info)
+{
+    info.schemaRevision = result.schemaRevision;
+    info.templateRevision = result.templateRevision;
+    info.templateId = result.templateId;
+    info.templateName = result.templateName;
+    info.sizeBytes = result.sizeBytes;
+    info.valid = true;
+}
+
+static size_t domeLayoutTemplateReadChunk(void *ctx, uint8_t *buf, size_t len)
+{
+    return ((File *)ctx)->read(buf, len);
+}
+
+// Validates the installed custom template straight from SPIFFS.
+static bool domeLayoutTemplateStreamFile(DomeLayoutTemplateInfo &info,
+                                         String &errMsg)
 {
     if (!SPIFFS.exists(DOME_LAYOUT_TEMPLATE_PATH))
     {
@@ -287,208 +236,167 @@ static bool domeLayoutTemplateReadFile(String &out, String &errMsg)
         errMsg = "custom template size is invalid";
         return false;
     }
-    out = "";
-    out.reserve(size + 1);
-    while (file.available())
+    DomeLayoutStreamResult result;
+    bool ok = domeLayoutTemplateStreamRun(domeLayoutTemplateReadChunk, &file, result);
+    file.close();
+    if (!ok)
     {
-        out += (char)file.read();
-        if (out.length() > DOME_LAYOUT_TEMPLATE_MAX_BYTES)
-        {
-            file.close();
-            errMsg = "custom template is too large";
-            return false;
-        }
+        errMsg = result.error;
+        return false;
     }
-    file.close();
+    domeLayoutTemplateApplyStreamResult(result, info);
     return true;
 }
 
-static bool domeLayoutTemplateValidateElementObject(const char *&p, bool *seenIds,
-                                                    int &seenCount, String &errMsg)
+static void domeLayoutTemplateRemoveCompiled()
 {
-    if (!domeLayoutTemplateExpectChar(p, '{', errMsg)) return false;
-    bool seenId = false;
-    bool seenInLayout = false;
-    bool seenElementType = false;
-    bool seenPanelKind = false;
-    bool seenCommandable = false;
-    bool inLayout = false;
-    String elementType;
-    String panelKind;
-    bool commandable = false;
-    String id;
-
-    while (true)
-    {
-        domeLayoutTemplateSkipWs(p);
-        if (*p == '}') { p++; break; }
-        String key;
-        if (!domeLayoutTemplateParseJsonString(p, key, errMsg)) return false;
-        if (domeLayoutTemplateHasForbiddenBackendKey(key))
-        {
-            errMsg = "template contains backend field: " + key;
-            return false;
-        }
-        if (key == "runtime_state_ts" || key == "layout_source")
-        {
-            errMsg = "template must not define composed runtime field: " + key;
-            return false;
-        }
-        if (key == "active" || key == "disabled" || key == "disabled_reason")
-        {
-            errMsg = "template must not define runtime field: " + key;
-            return false;
-        }
-        if (!domeLayoutTemplateExpectChar(p, ':', errMsg)) return false;
-
-        if (key == "id")
-        {
-            if (!domeLayoutTemplateParseJsonString(p, id, errMsg)) return false;
-            seenId = true;
-        }
-        else if (key == "in_layout")
-        {
-            if (!domeLayoutTemplateParseBool(p, inLayout))
-            {
-                errMsg = "in_layout must be boolean";
-                return false;
-            }
-            seenInLayout = true;
-        }
-        else if (key == "element_type")
-        {
-            if (!domeLayoutTemplateParseJsonString(p, elementType, errMsg)) return false;
-            if (!domeLayoutTemplateIsElementType(elementType))
-            {
-                errMsg = "unsupported element_type: " + elementType;
-                return false;
-            }
-            seenElementType = true;
-        }
-        else if (key == "panel_kind")
-        {
-            domeLayoutTemplateSkipWs(p);
-            if (domeLayoutTemplateParseLiteral(p, "null"))
-            {
-                panelKind = "";
-            }
-            else
-            {
-                if (!domeLayoutTemplateParseJsonString(p, panelKind, errMsg)) return false;
-                if (!domeLayoutTemplateIsPanelKind(panelKind))
-                {
-                    errMsg = "unsupported panel_kind: " + panelKind;
-                    return false;
-                }
-            }
-            seenPanelKind = true;
-        }
-        else if (key == "commandable")
-        {
-            if (!domeLayoutTemplateParseBool(p, commandable))
-            {
-                errMsg = "commandable must be boolean";
-                return false;
-            }
-            seenCommandable = true;
-        }
-        else
-        {
-            if (!domeLayoutTemplateSkipJsonValue(p, errMsg)) return false;
-        }
+    if (SPIFFS.exists(DOME_LAYOUT_TEMPLATE_COMPILED_PATH)) SPIFFS.remove(DOME_LAYOUT_TEMPLATE_COMPILED_PATH);
+    if (SPIFFS.exists(DOME_LAYOUT_TEMPLATE_COMPILED_TMP_PATH)) SPIFFS.remove(DOME_LAYOUT_TEMPLATE_COMPILED_TMP_PATH);
+}
 
-        domeLayoutTemplateSkipWs(p);
-        if (*p == ',') { p++; continue; }
-        if (*p == '}') { p++; break; }
-        errMsg = "expected ',' or '}' in element";
-        return false;
-    }
+// CRC32 of the installed JSON; the compiler records the same value as
+// sourceCrc.
+static bool domeLayoutTemplateInstalledCrc(size_t &size, uint32_t &crc)
+{
+    File file = SPIFFS.open(DOME_LAYOUT_TEMPLATE_PATH, FILE_READ);
+    if (!file) return false;
+    size = file.size();
+    crc = 0;
+    uint8_t buf[DOME_LAYOUT_STREAM_CHUNK];
+    size_t n;
+    while ((n = file.read(buf, sizeof(buf))) > 0)
+        crc = domeLayoutCrc32Update(crc, buf, n);
+    file.close();
+    return true;
+}
 
-    if (!seenId || !seenInLayout || !seenElementType || !seenPanelKind ||
-        !seenCommandable)
-    {
-        errMsg = "element requires id, in_layout, element_type, panel_kind, and commandable";
-        return false;
-    }
-    if (elementType == "panel")
-    {
-        if (!domeLayoutTemplateIsPanelKind(panelKind))
-        {
-            errMsg = "panel_kind is required for panel element: " + id;
-            return false;
-        }
-    }
-    else if (panelKind.length() > 0)
+// Loads the compiled form of the installed template. It is only trusted when
+// it passes the structural/CRC check and its header names the installed
+// source by size and CRC32, so a JSON replaced outside the store (e.g. by a
+// filesystem image) is never served from an old blob. Every write or delete
+// of the JSON through the store removes it first. The caller frees `blob` on
+// success.
+static bool domeLayoutTemplateLoadCompiled(uint8_t *&blob, size_t &len,
+                                           DomeLayoutCompiledHeader &header,
+                                           String &errMsg)
+{
+    blob = nullptr;
+    len = 0;
+    File file = SPIFFS.open(DOME_LAYOUT_TEMPLATE_COMPILED_PATH, FILE_READ);
+    if (!file)
     {
-        errMsg = "panel_kind must be null for non-panel element: " + id;
+        errMsg = "compiled template is not available";
         return false;
     }
-    int index = domeLayoutTemplateFindKnownId(id);
-    if (index < 0)
+    size_t size = file.size();
+    if (size < DOME_LAYOUT_COMPILED_HEADER_BYTES || size > DOME_LAYOUT_COMPILED_MAX_BYTES)
     {
-        errMsg = "unknown dome element id: " + id;
+        file.close();
+        errMsg = "compiled template size is invalid";
         return false;
     }
-    if (seenIds[index])
+    blob = (uint8_t *)malloc(size);
+    if (!blob)
     {
-        errMsg = "duplicate dome element id: " + id;
+        file.close();
+        errMsg = "out of memory loading compiled template";
         return false;
     }
-    if (commandable && !domeLayoutTemplateIsCommandableId(id))
+    size_t got = file.read(blob, size);
+    file.close();
+    char err[DOME_LAYOUT_STREAM_ERR_LEN];
+    bool ok = got == size && domeLayoutCompiledCheck(blob, size, header, err, sizeof(err));
+    if (!ok) errMsg = got == size ? err : "compiled template read was incomplete";
+    else
     {
-        errMsg = "commandable is only valid for known ring/pie panels: " + id;
-        return false;
+        size_t sourceSize = 0;
+        uint32_t sourceCrc = 0;
+        if (!domeLayoutTemplateInstalledCrc(sourceSize, sourceCrc) ||
+            header.sourceSize != sourceSize || header.sourceCrc != sourceCrc)
+        {
+            ok = false;
+            errMsg = "compiled template is stale";
+        }
     }
-    if (!inLayout && commandable)
+    if (!ok)
     {
-        errMsg = "excluded element cannot be commandable: " + id;
+        free(blob);
+        blob = nullptr;
         return false;
     }
-    seenIds[index] = true;
-    seenCount++;
+    len = size;
     return true;
 }
 
-static bool domeLayoutTemplateValidateElementsArray(const char *&p, String &errMsg)
+// Validates the installed JSON, compiles it and stores the result. A failed
+// write of the compiled file is not fatal: the blob is still returned and the
+// next load simply compiles again.
+static bool domeLayoutTemplateCompileInstalled(uint8_t *&blob, size_t &len,
+                                               DomeLayoutCompiledHeader &header,
+                                               String &errMsg)
 {
-    if (!domeLayoutTemplateExpectChar(p, '[', errMsg)) return false;
-    bool seenIds[DOME_LAYOUT_TEMPLATE_MAX_ELEMENTS] = {false};
-    int seenCount = 0;
-    domeLayoutTemplateSkipWs(p);
-    if (*p == ']')
+    blob = nullptr;
+    len = 0;
+    DomeLayoutTemplateInfo info = {};
+    if (!domeLayoutTemplateStreamFile(info, errMsg)) return false;
+    File file = SPIFFS.open(DOME_LAYOUT_TEMPLATE_PATH, FILE_READ);
+    if (!file)
     {
-        errMsg = "elements array is empty";
+        errMsg = "custom template cannot be opened";
         return false;
     }
-    while (true)
+    char err[DOME_LAYOUT_STREAM_ERR_LEN];
+    bool ok = domeLayoutCompileTemplate(domeLayoutTemplateReadChunk, &file, file.size(),
+                                        blob, len, err, sizeof(err));
+    file.close();
+    if (ok) ok = domeLayoutCompiledCheck(blob, len, header, err, sizeof(err));
+    if (!ok)
     {
-        if (seenCount >= DOME_LAYOUT_TEMPLATE_MAX_ELEMENTS)
-        {
-            errMsg = "too many layout elements";
-            return false;
-        }
-        if (!domeLayoutTemplateValidateElementObject(p, seenIds, seenCount, errMsg))
-        {
-            return false;
-        }
-        domeLayoutTemplateSkipWs(p);
-        if (*p == ',') { p++; continue; }
-        if (*p == ']') { p++; break; }
-        errMsg = "expected ',' or ']' in elements array";
+        free(blob);
+        blob = nullptr;
+        len = 0;
+        errMsg = err;
         return false;
     }
-    for (size_t i = 0; i < DomeLayout::kElementCount; i++)
+
+    domeLayoutTemplateRemoveCompiled();
+    File out = SPIFFS.open(DOME_LAYOUT_TEMPLATE_COMPILED_TMP_PATH, FILE_WRITE);
+    if (out)
     {
-        if (!seenIds[i])
+        size_t written = out.write(blob, len);
+        out.close();
+        if (written != len || !SPIFFS.rename(DOME_LAYOUT_TEMPLATE_COMPILED_TMP_PATH,
+                                             DOME_LAYOUT_TEMPLATE_COMPILED_PATH))
         {
-            errMsg = String("template is missing explicit known identity: ") +
-                     DomeLayout::kElements[i].id;
-            return false;
+            SPIFFS.remove(DOME_LAYOUT_TEMPLATE_COMPILED_TMP_PATH);
         }
     }
     return true;
 }
 
+static bool domeLayoutTemplateValidateFile(DomeLayoutTemplateInfo &info, String &errMsg)
+{
+    uint8_t *blob = nullptr;
+    size_t len = 0;
+    DomeLayoutCompiledHeader header;
+    String compiledErr;
+    if (domeLayoutTemplateLoadCompiled(blob, len, header, compiledErr))
+    {
+        // Only templates that passed full validation are ever compiled, so
+        // the header is enough to answer for the installed file.
+        info.schemaRevision = header.schemaRevision;
+        info.templateRevision = header.templateRevision;
+        info.templateId = domeLayoutCompiledString(blob, header, header.templateId);
+        info.templateName = domeLayoutCompiledString(blob, header, header.templateName);
+        info.sizeBytes = header.sourceSize;
+        info.compiled = true;
+        info.valid = true;
+        free(blob);
+        return true;
+    }
+    return domeLayoutTemplateStreamFile(info, errMsg);
+}
+
 static bool domeLayoutTemplateValidateJson(const String &json,
                                            DomeLayoutTemplateInfo &info,
                                            String &errMsg)
@@ -498,132 +406,21 @@ static bool domeLayoutTemplateValidateJson(const String &json,
         errMsg = "template must be 1..32768 bytes";
         return false;
     }
-
-    const char *p = json.c_str();
-    if (!domeLayoutTemplateExpectChar(p, '{', errMsg)) return false;
-
-    bool seenSchema = false;
-    bool seenTemplateId = false;
-    bool seenTemplateName = false;
-    bool seenTemplateRevision = false;
-    bool seenCoordinateSpace = false;
-    bool seenElements = false;
-
-    while (true)
-    {
-        domeLayoutTemplateSkipWs(p);
-        if (*p == '}') { p++; break; }
-        String key;
-        if (!domeLayoutTemplateParseJsonString(p, key, errMsg)) return false;
-        if (domeLayoutTemplateHasForbiddenBackendKey(key))
-        {
-            errMsg = "template contains backend field: " + key;
-            return false;
-        }
-        if (key == "runtime_state_ts" || key == "layout_source")
-        {
-            errMsg = "template must not define composed runtime field: " + key;
-            return false;
-        }
-        if (!domeLayoutTemplateExpectChar(p, ':', errMsg)) return false;
-
-        if (key == "schema_revision")
-        {
-            if (!domeLayoutTemplateParseInt(p, info.schemaRevision))
-            {
-                errMsg = "schema_revision must be integer";
-                return false;
-            }
-            if (info.schemaRevision != DomeLayout::kSchemaRevision)
-            {
-                errMsg = "unsupported schema_revision";
-                return false;
-            }
-            seenSchema = true;
-        }
-        else if (key == "template_id")
-        {
-            if (!domeLayoutTemplateParseJsonString(p, info.templateId, errMsg)) return false;
-            if (info.templateId.length() == 0)
-            {
-                errMsg = "template_id must not be empty";
-                return false;
-            }
-            seenTemplateId = true;
-        }
-        else if (key == "template_name")
-        {
-            if (!domeLayoutTemplateParseJsonString(p, info.templateName, errMsg)) return false;
-            if (info.templateName.length() == 0)
-            {
-                errMsg = "template_name must not be empty";
-                return false;
-            }
-            seenTemplateName = true;
-        }
-        else if (key == "template_revision")
-        {
-            if (!domeLayoutTemplateParseInt(p, info.templateRevision))
-            {
-                errMsg = "template_revision must be integer";
-                return false;
-            }
-            if (info.templateRevision < 1)
-            {
-                errMsg = "template_revision must be positive";
-                return false;
-            }
-            seenTemplateRevision = true;
-        }
-        else if (key == "coordinate_space")
-        {
-            const char *space = p;
-            String viewBox;
-            if (!domeLayoutTemplateFindRootString(String(space), "viewBox", viewBox, errMsg))
-            {
-                return false;
-            }
-            if (viewBox != DomeLayout::kCoordinateSpaceViewBox)
-            {
-                errMsg = "coordinate_space.viewBox must be 0 0 480 480";
-                return false;
-            }
-            if (!domeLayoutTemplateSkipJsonValue(p, errMsg)) return false;
-            seenCoordinateSpace = true;
-        }
-        else if (key == "elements")
-        {
-            if (!domeLayoutTemplateValidateElementsArray(p, errMsg)) return false;
-            seenElements = true;
-        }
-        else
-        {
-            if (!domeLayoutTemplateSkipJsonValue(p, errMsg)) return false;
-        }
-
-        domeLayoutTemplateSkipWs(p);
-        if (*p == ',') { p++; continue; }
-        if (*p == '}') { p++; break; }
-        errMsg = "expected ',' or '}' in template root";
-        return false;
-    }
-    domeLayoutTemplateSkipWs(p);
-    if (*p != '\0')
-    {
-        errMsg = "trailing content after template JSON";
-        return false;
-    }
-    if (!seenSchema || !seenTemplateId || !seenTemplateName ||
-        !seenTemplateRevision || !seenCoordinateSpace || !seenElements)
+    DomeLayoutStreamMemoryReader reader = { json.c_str(), json.length(), 0 };
+    DomeLayoutStreamResult result;
+    if (!domeLayoutTemplateStreamRun(domeLayoutStreamReadMemory, &reader, result))
     {
-        errMsg = "template missing required root fields";
+        errMsg = result.error;
         return false;
     }
-    info.valid = true;
-    info.sizeBytes = json.length();
+    domeLayoutTemplateApplyStreamResult(result, info);
     return true;
 }
 
+// Bumped whenever the installed template or the selection changes so the
+// /api/dome/layout cache knows to recompose its static part.
+static uint32_t sDomeLayoutTemplateGeneration = 0;
+
 static bool domeLayoutTemplateIsCustomSelected()
 {
     Preferences prefs;
@@ -639,6 +436,7 @@ static bool domeLayoutTemplateSetCustomSelected(bool selected)
     if (!prefs.begin(DOME_LAYOUT_TEMPLATE_NS, false)) return false;
     bool ok = prefs.putBool(DOME_LAYOUT_TEMPLATE_USE_CUSTOM, selected) > 0;
     prefs.end();
+    sDomeLayoutTemplateGeneration++;
     return ok;
 }
 
@@ -659,6 +457,7 @@ static bool domeLayoutTemplateWriteCustom(const String &json, String &errMsg)
         errMsg = "template write was incomplete";
         return false;
     }
+    domeLayoutTemplateRemoveCompiled();
     if (SPIFFS.exists(DOME_LAYOUT_TEMPLATE_PATH)) SPIFFS.remove(DOME_LAYOUT_TEMPLATE_PATH);
     if (!SPIFFS.rename(DOME_LAYOUT_TEMPLATE_TMP_PATH, DOME_LAYOUT_TEMPLATE_PATH))
     {
@@ -666,6 +465,7 @@ static bool domeLayoutTemplateWriteCustom(const String &json, String &errMsg)
         errMsg = "cannot promote template file";
         return false;
     }
+    sDomeLayoutTemplateGeneration++;
     return true;
 }
 
@@ -683,17 +483,11 @@ static DomeLayoutTemplateInfo domeLayoutTemplateReadInfo()
         info.valid = true;
         return info;
     }
-    String json;
     String errMsg;
-    if (!domeLayoutTemplateReadFile(json, errMsg))
-    {
-        info.error = errMsg;
-        return info;
-    }
     info = {};
     info.customInstalled = true;
     info.customSelected = domeLayoutTemplateIsCustomSelected();
-    if (!domeLayoutTemplateValidateJson(json, info, errMsg))
+    if (!domeLayoutTemplateValidateFile(info, errMsg))
     {
         info.schemaRevision = DomeLayout::kSchemaRevision;
         info.templateRevision = DomeLayout::kTemplateRevision;
@@ -738,6 +532,8 @@ static String domeLayoutTemplateInfoJson(String (*escapeFn)(const String &))
         json += escapeFn(info.templateName);
         json += "\",\"custom_template_revision\":";
         json += info.templateRevision;
+        json += ",\"custom_compiled\":";
+        json += info.compiled ? "true" : "false";
     }
     json += ",\"size_bytes\":";
     json += (unsigned int)info.sizeBytes;
@@ -0,0 +1,681 @@
+#pragma once
+// DomeLayoutTemplateStream.h — single-pass validator for custom dome layout
+// templates.
+//
+// The template is pulled through a fixed chunk buffer from any reader (SPIFFS
+// file, request body) and checked in one pass. DomeLayoutCompiled.h drives the
+// same tokenizer to build its records; the served layout is always written
+// from those records by DomeLayoutWriter.h. Parser RAM is the struct below
+// plus a bounded recursion depth, whatever the template size. No Arduino
+// types, so the host tests can compile it.
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "GeneratedDomeLayout.h"
+
+#ifndef DOME_LAYOUT_TEMPLATE_MAX_BYTES
+#define DOME_LAYOUT_TEMPLATE_MAX_BYTES 32768
+#endif
+#ifndef DOME_LAYOUT_TEMPLATE_MAX_ELEMENTS
+#define DOME_LAYOUT_TEMPLATE_MAX_ELEMENTS 64
+#endif
+#define DOME_LAYOUT_STREAM_CHUNK 256
+#define DOME_LAYOUT_STREAM_MAX_TOKEN 95
+#define DOME_LAYOUT_STREAM_MAX_DEPTH 12
+#define DOME_LAYOUT_STREAM_ERR_LEN 128
+
+typedef size_t (*DomeLayoutStreamReadFn)(void *ctx, uint8_t *buf, size_t len);
+
+struct DomeLayoutStreamResult
+{
+    int schemaRevision;
+    int templateRevision;
+    char templateId[DOME_LAYOUT_STREAM_MAX_TOKEN + 1];
+    char templateName[DOME_LAYOUT_STREAM_MAX_TOKEN + 1];
+    size_t sizeBytes;
+    int elementCount;
+    uint32_t reads;
+    char error[DOME_LAYOUT_STREAM_ERR_LEN];
+};
+
+struct DomeLayoutTemplateStream
+{
+    DomeLayoutStreamReadFn read;
+    void *readCtx;
+    DomeLayoutStreamResult *result;
+    uint8_t in[DOME_LAYOUT_STREAM_CHUNK];
+    size_t inLen;
+    size_t inPos;
+    size_t consumed;
+    bool eof;
+    bool failed;
+    int depth;
+};
+
+struct DomeLayoutStreamMemoryReader
+{
+    const char *data;
+    size_t len;
+    size_t pos;
+};
+
+static size_t domeLayoutStreamReadMemory(void *ctx, uint8_t *buf, size_t len)
+{
+    DomeLayoutStreamMemoryReader *reader = (DomeLayoutStreamMemoryReader *)ctx;
+    size_t n = reader->len - reader->pos;
+    if (n > len) n = len;
+    memcpy(buf, reader->data + reader->pos, n);
+    reader->pos += n;
+    return n;
+}
+
+static inline int domeLayoutStreamFindKnownId(const char *id)
+{
+    return DomeLayout::elementIndexForId(id);
+}
+
+static bool domeLayoutStreamIsElementType(const char *value)
+{
+    return strcmp(value, "panel") == 0 ||
+           strcmp(value, "holo") == 0 ||
+           strcmp(value, "logic") == 0 ||
+           strcmp(value, "psi") == 0;
+}
+
+static bool domeLayoutStreamIsPanelKind(const char *value)
+{
+    return strcmp(value, "ring") == 0 ||
+           strcmp(value, "pie") == 0 ||
+           strcmp(value, "fixed") == 0;
+}
+
+static bool domeLayoutStreamIsForbiddenBackendKey(const char *key)
+{
+    static const char *const kForbidden[] = {
+        "cmd", "command", "command_target", "target", "slot", "channel",
+        "bus", "address", "spi_chain", "pca9685_channel", "servo_channel",
+    };
+    for (size_t i = 0; i < sizeof(kForbidden) / sizeof(kForbidden[0]); i++)
+    {
+        if (strcmp(key, kForbidden[i]) == 0) return true;
+    }
+    return false;
+}
+
+static bool domeLayoutStreamFail(DomeLayoutTemplateStream &s, const char *fmt, ...)
+{
+    if (!s.failed)
+    {
+        va_list args;
+        va_start(args, fmt);
+        vsnprintf(s.result->error, sizeof(s.result->error), fmt, args);
+        va_end(args);
+        s.failed = true;
+    }
+    return false;
+}
+
+static int domeLayoutStreamPeek(DomeLayoutTemplateStream &s)
+{
+    if (s.failed) return -1;
+    if (s.inPos >= s.inLen)
+    {
+        if (s.eof) return -1;
+        s.inLen = s.read(s.readCtx, s.in, sizeof(s.in));
+        s.inPos = 0;
+        s.result->reads++;
+        if (s.inLen == 0)
+        {
+            s.eof = true;
+            return -1;
+        }
+    }
+    return s.in[s.inPos];
+}
+
+static int domeLayoutStreamTake(DomeLayoutTemplateStream &s)
+{
+    int c = domeLayoutStreamPeek(s);
+    if (c < 0) return c;
+    s.inPos++;
+    if (++s.consumed > DOME_LAYOUT_TEMPLATE_MAX_BYTES)
+    {
+        domeLayoutStreamFail(s, "template must be 1..%u bytes",
+                             (unsigned)DOME_LAYOUT_TEMPLATE_MAX_BYTES);
+        return -1;
+    }
+    return c;
+}
+
+static void domeLayoutStreamSkipWs(DomeLayoutTemplateStream &s)
+{
+    while (true)
+    {
+        int c = domeLayoutStreamPeek(s);
+        if (c != ' ' && c != '\t' && c != '\n' && c != '\r') return;
+        domeLayoutStreamTake(s);
+    }
+}
+
+static bool domeLayoutStreamExpectChar(DomeLayoutTemplateStream &s, char expected)
+{
+    domeLayoutStreamSkipWs(s);
+    if (domeLayoutStreamPeek(s) != expected)
+    {
+        return domeLayoutStreamFail(s, "expected '%c'", expected);
+    }
+    return domeLayoutStreamTake(s) >= 0;
+}
+
+// Parses a JSON string, keeping up to capSize-1 decoded bytes in capture.
+// Longer values (SVG paths) are still validated, just not kept.
+static bool domeLayoutStreamParseString(DomeLayoutTemplateStream &s, char *capture,
+                                        size_t capSize, bool *truncated = nullptr)
+{
+    domeLayoutStreamSkipWs(s);
+    if (domeLayoutStreamPeek(s) != '"') return domeLayoutStreamFail(s, "expected string");
+    domeLayoutStreamTake(s);
+    size_t n = 0;
+    bool cut = false;
+    while (true)
+    {
+        int c = domeLayoutStreamTake(s);
+        if (c < 0) return domeLayoutStreamFail(s, "unterminated string");
+        if (c == '"') break;
+        if (c < 0x20) return domeLayoutStreamFail(s, "string contains control characters");
+        if (c == '\\')
+        {
+            int esc = domeLayoutStreamTake(s);
+            if (esc == '"' || esc == '\\' || esc == '/') c = esc;
+            else if (esc == 'b') c = '\b';
+            else if (esc == 'f') c = '\f';
+            else if (esc == 'n') c = '\n';
+            else if (esc == 'r') c = '\r';
+            else if (esc == 't') c = '\t';
+            else if (esc == 'u')
+                return domeLayoutStreamFail(s, "unicode escapes are not supported in dome templates");
+            else if (esc < 0)
+                return domeLayoutStreamFail(s, "unterminated string");
+            else
+                return domeLayoutStreamFail(s, "invalid string escape");
+        }
+        if (capture && n + 1 < capSize) capture[n++] = (char)c;
+        else cut = true;
+    }
+    if (capture && capSize > 0) capture[n] = '\0';
+    if (truncated) *truncated = cut && capture != nullptr;
+    return true;
+}
+
+static bool domeLayoutStreamParseLiteral(DomeLayoutTemplateStream &s, const char *literal)
+{
+    domeLayoutStreamSkipWs(s);
+    for (const char *l = literal; *l; l++)
+    {
+        if (domeLayoutStreamPeek(s) != *l) return false;
+        domeLayoutStreamTake(s);
+    }
+    return true;
+}
+
+static bool domeLayoutStreamParseBool(DomeLayoutTemplateStream &s, bool &out)
+{
+    domeLayoutStreamSkipWs(s);
+    int c = domeLayoutStreamPeek(s);
+    out = (c == 't');
+    if (c == 't') return domeLayoutStreamParseLiteral(s, "true");
+    if (c == 'f') return domeLayoutStreamParseLiteral(s, "false");
+    return false;
+}
+
+static bool domeLayoutStreamParseInt(DomeLayoutTemplateStream &s, int &out)
+{
+    domeLayoutStreamSkipWs(s);
+    bool negative = false;
+    if (domeLayoutStreamPeek(s) == '-')
+    {
+        negative = true;
+        domeLayoutStreamTake(s);
+    }
+    int c = domeLayoutStreamPeek(s);
+    if (c < '0' || c > '9') return false;
+    long value = 0;
+    while (c >= '0' && c <= '9')
+    {
+        value = (value * 10) + (c - '0');
+        if (value > 1000000L) return false;
+        domeLayoutStreamTake(s);
+        c = domeLayoutStreamPeek(s);
+    }
+    out = negative ? -(int)value : (int)value;
+    return true;
+}
+
+static bool domeLayoutStreamDigits(DomeLayoutTemplateStream &s)
+{
+    int c = domeLayoutStreamPeek(s);
+    if (c < '0' || c > '9') return domeLayoutStreamFail(s, "invalid number");
+    while (c >= '0' && c <= '9')
+    {
+        domeLayoutStreamTake(s);
+        c = domeLayoutStreamPeek(s);
+    }
+    return true;
+}
+
+// Reads an object key and applies the checks every template object shares.
+static bool domeLayoutStreamParseKey(DomeLayoutTemplateStream &s, char *key, size_t keySize)
+{
+    bool truncated = false;
+    if (!domeLayoutStreamParseString(s, key, keySize, &truncated)) return false;
+    if (truncated)
+    {
+        // Longer than any key the template contract knows; never matches.
+        key[0] = '\0';
+    }
+    else if (domeLayoutStreamIsForbiddenBackendKey(key))
+    {
+        return domeLayoutStreamFail(s, "template contains backend field: %s", key);
+    }
+    else if (strcmp(key, "runtime_state_ts") == 0 || strcmp(key, "layout_source") == 0)
+    {
+        return domeLayoutStreamFail(s, "template must not define composed runtime field: %s", key);
+    }
+    return domeLayoutStreamExpectChar(s, ':');
+}
+
+static bool domeLayoutStreamSkipValue(DomeLayoutTemplateStream &s);
+
+static bool domeLayoutStreamEnter(DomeLayoutTemplateStream &s)
+{
+    if (++s.depth > DOME_LAYOUT_STREAM_MAX_DEPTH)
+        return domeLayoutStreamFail(s, "template nesting is too deep");
+    return true;
+}
+
+static bool domeLayoutStreamSkipObject(DomeLayoutTemplateStream &s)
+{
+    if (!domeLayoutStreamEnter(s)) return false;
+    if (!domeLayoutStreamExpectChar(s, '{')) return false;
+    domeLayoutStreamSkipWs(s);
+    if (domeLayoutStreamPeek(s) == '}')
+    {
+        domeLayoutStreamTake(s);
+        s.depth--;
+        return true;
+    }
+    char key[DOME_LAYOUT_STREAM_MAX_TOKEN + 1];
+    while (true)
+    {
+        if (!domeLayoutStreamParseKey(s, key, sizeof(key))) return false;
+        if (!domeLayoutStreamSkipValue(s)) return false;
+        domeLayoutStreamSkipWs(s);
+        int c = domeLayoutStreamTake(s);
+        if (c == ',') continue;
+        if (c == '}') break;
+        if (c < 0) return domeLayoutStreamFail(s, "unterminated object");
+        return domeLayoutStreamFail(s, "expected ',' or '}'");
+    }
+    s.depth--;
+    return true;
+}
+
+static bool domeLayoutStreamSkipArray(DomeLayoutTemplateStream &s)
+{
+    if (!domeLayoutStreamEnter(s)) return false;
+    if (!domeLayoutStreamExpectChar(s, '[')) return false;
+    domeLayoutStreamSkipWs(s);
+    if (domeLayoutStreamPeek(s) == ']')
+    {
+        domeLayoutStreamTake(s);
+        s.depth--;
+        return true;
+    }
+    while (true)
+    {
+        if (!domeLayoutStreamSkipValue(s)) return false;
+        domeLayoutStreamSkipWs(s);
+        int c = domeLayoutStreamTake(s);
+        if (c == ',') continue;
+        if (c == ']') break;
+        if (c < 0) return domeLayoutStreamFail(s, "unterminated array");
+        return domeLayoutStreamFail(s, "expected ',' or ']'");
+    }
+    s.depth--;
+    return true;
+}
+
+static bool domeLayoutStreamSkipValue(DomeLayoutTemplateStream &s)
+{
+    domeLayoutStreamSkipWs(s);
+    int c = domeLayoutStreamPeek(s);
+    if (c == '{') return domeLayoutStreamSkipObject(s);
+    if (c == '[') return domeLayoutStreamSkipArray(s);
+    if (c == '"') return domeLayoutStreamParseString(s, nullptr, 0);
+    if (c == 't' || c == 'f' || c == 'n')
+    {
+        const char *literal = (c == 't') ? "true" : (c == 'f') ? "false" : "null";
+        if (domeLayoutStreamParseLiteral(s, literal)) return true;
+        return domeLayoutStreamFail(s, "invalid JSON value");
+    }
+    if (c == '-' || (c >= '0' && c <= '9'))
+    {
+        if (c == '-') domeLayoutStreamTake(s);
+        if (!domeLayoutStreamDigits(s)) return false;
+        if (domeLayoutStreamPeek(s) == '.')
+        {
+            domeLayoutStreamTake(s);
+            if (!domeLayoutStreamDigits(s)) return false;
+        }
+        c = domeLayoutStreamPeek(s);
+        if (c == 'e' || c == 'E')
+        {
+            domeLayoutStreamTake(s);
+            c = domeLayoutStreamPeek(s);
+            if (c == '+' || c == '-') domeLayoutStreamTake(s);
+            if (!domeLayoutStreamDigits(s)) return false;
+        }
+        return true;
+    }
+    return domeLayoutStreamFail(s, "invalid JSON value");
+}
+
+static bool domeLayoutStreamElement(DomeLayoutTemplateStream &s, bool *seenIds)
+{
+    if (!domeLayoutStreamEnter(s)) return false;
+    if (!domeLayoutStreamExpectChar(s, '{')) return false;
+    bool seenId = false;
+    bool seenInLayout = false;
+    bool seenElementType = false;
+    bool seenPanelKind = false;
+    bool seenCommandable = false;
+    bool inLayout = false;
+    bool commandable = false;
+    char id[DOME_LAYOUT_STREAM_MAX_TOKEN + 1] = "";
+    char elementType[16] = "";
+    char panelKind[16] = "";
+    char key[DOME_LAYOUT_STREAM_MAX_TOKEN + 1];
+
+    domeLayoutStreamSkipWs(s);
+    while (domeLayoutStreamPeek(s) != '}')
+    {
+        if (!domeLayoutStreamParseKey(s, key, sizeof(key))) return false;
+        if (strcmp(key, "active") == 0 || strcmp(key, "disabled") == 0 ||
+            strcmp(key, "disabled_reason") == 0)
+        {
+            return domeLayoutStreamFail(s, "template must not define runtime field: %s", key);
+        }
+
+        if (strcmp(key, "id") == 0)
+        {
+            bool truncated = false;
+            if (!domeLayoutStreamParseString(s, id, sizeof(id), &truncated)) return false;
+            if (truncated) id[0] = '\0';
+            seenId = true;
+        }
+        else if (strcmp(key, "in_layout") == 0)
+        {
+            if (!domeLayoutStreamParseBool(s, inLayout))
+                return domeLayoutStreamFail(s, "in_layout must be boolean");
+            seenInLayout = true;
+        }
+        else if (strcmp(key, "element_type") == 0)
+        {
+            if (!domeLayoutStreamParseString(s, elementType, sizeof(elementType))) return false;
+            if (!domeLayoutStreamIsElementType(elementType))
+                return domeLayoutStreamFail(s, "unsupported element_type: %s", elementType);
+            seenElementType = true;
+        }
+        else if (strcmp(key, "panel_kind") == 0)
+        {
+            domeLayoutStreamSkipWs(s);
+            if (domeLayoutStreamPeek(s) == 'n')
+            {
+                if (!domeLayoutStreamParseLiteral(s, "null"))
+                    return domeLayoutStreamFail(s, "expected string");
+                panelKind[0] = '\0';
+            }
+            else
+            {
+                if (!domeLayoutStreamParseString(s, panelKind, sizeof(panelKind))) return false;
+                if (!domeLayoutStreamIsPanelKind(panelKind))
+                    return domeLayoutStreamFail(s, "unsupported panel_kind: %s", panelKind);
+            }
+            seenPanelKind = true;
+        }
+        else if (strcmp(key, "commandable") == 0)
+        {
+            if (!domeLayoutStreamParseBool(s, commandable))
+                return domeLayoutStreamFail(s, "commandable must be boolean");
+            seenCommandable = true;
+        }
+        else if (!domeLayoutStreamSkipValue(s))
+        {
+            return false;
+        }
+
+        domeLayoutStreamSkipWs(s);
+        int c = domeLayoutStreamPeek(s);
+        if (c == ',')
+        {
+            domeLayoutStreamTake(s);
+            domeLayoutStreamSkipWs(s);
+            continue;
+        }
+        if (c == '}') break;
+        return domeLayoutStreamFail(s, "expected ',' or '}' in element");
+    }
+
+    if (!seenId || !seenInLayout || !seenElementType || !seenPanelKind || !seenCommandable)
+    {
+        return domeLayoutStreamFail(s,
+            "element requires id, in_layout, element_type, panel_kind, and commandable");
+    }
+    if (strcmp(elementType, "panel") == 0)
+    {
+        if (!domeLayoutStreamIsPanelKind(panelKind))
+            return domeLayoutStreamFail(s, "panel_kind is required for panel element: %s", id);
+    }
+    else if (panelKind[0] != '\0')
+    {
+        return domeLayoutStreamFail(s, "panel_kind must be null for non-panel element: %s", id);
+    }
+    int index = domeLayoutStreamFindKnownId(id);
+    if (index < 0) return domeLayoutStreamFail(s, "unknown dome element id: %s", id);
+    if (seenIds[index]) return domeLayoutStreamFail(s, "duplicate dome element id: %s", id);
+    if (commandable && !DomeLayout::kElements[index].commandable)
+        return domeLayoutStreamFail(s, "commandable is only valid for known ring/pie panels: %s", id);
+    if (!inLayout && commandable)
+        return domeLayoutStreamFail(s, "excluded element cannot be commandable: %s", id);
+    seenIds[index] = true;
+    s.result->elementCount++;
+    domeLayoutStreamTake(s);
+    s.depth--;
+    return true;
+}
+
+static bool domeLayoutStreamElements(DomeLayoutTemplateStream &s)
+{
+    if (!domeLayoutStreamEnter(s)) return false;
+    if (!domeLayoutStreamExpectChar(s, '[')) return false;
+    bool seenIds[DOME_LAYOUT_TEMPLATE_MAX_ELEMENTS] = {false};
+    domeLayoutStreamSkipWs(s);
+    if (domeLayoutStreamPeek(s) == ']') return domeLayoutStreamFail(s, "elements array is empty");
+    while (true)
+    {
+        if (s.result->elementCount >= DOME_LAYOUT_TEMPLATE_MAX_ELEMENTS)
+            return domeLayoutStreamFail(s, "too many layout elements");
+        if (!domeLayoutStreamElement(s, seenIds)) return false;
+        domeLayoutStreamSkipWs(s);
+        int c = domeLayoutStreamTake(s);
+        if (c == ',') continue;
+        if (c == ']') break;
+        return domeLayoutStreamFail(s, "expected ',' or ']' in elements array");
+    }
+    for (size_t i = 0; i < DomeLayout::kElementCount; i++)
+    {
+        if (!seenIds[i])
+        {
+            return domeLayoutStreamFail(s, "template is missing explicit known identity: %s",
+                                        DomeLayout::kElements[i].id);
+        }
+    }
+    s.depth--;
+    return true;
+}
+
+static bool domeLayoutStreamCoordinateSpace(DomeLayoutTemplateStream &s)
+{
+    if (!domeLayoutStreamEnter(s)) return false;
+    if (!domeLayoutStreamExpectChar(s, '{')) return false;
+    char key[DOME_LAYOUT_STREAM_MAX_TOKEN + 1];
+    char viewBox[32] = "";
+    bool seenViewBox = false;
+    domeLayoutStreamSkipWs(s);
+    while (domeLayoutStreamPeek(s) != '}')
+    {
+        if (!domeLayoutStreamParseKey(s, key, sizeof(key))) return false;
+        if (strcmp(key, "viewBox") == 0 && !seenViewBox)
+        {
+            bool truncated = false;
+            if (!domeLayoutStreamParseString(s, viewBox, sizeof(viewBox), &truncated)) return false;
+            seenViewBox = !truncated;
+        }
+        else if (!domeLayoutStreamSkipValue(s))
+        {
+            return false;
+        }
+        domeLayoutStreamSkipWs(s);
+        int c = domeLayoutStreamPeek(s);
+        if (c == ',')
+        {
+            domeLayoutStreamTake(s);
+            domeLayoutStreamSkipWs(s);
+            continue;
+        }
+        if (c == '}') break;
+        return domeLayoutStreamFail(s, "expected ',' or '}'");
+    }
+    domeLayoutStreamTake(s);
+    if (!seenViewBox || strcmp(viewBox, DomeLayout::kCoordinateSpaceViewBox) != 0)
+        return domeLayoutStreamFail(s, "coordinate_space.viewBox must be 0 0 480 480");
+    s.depth--;
+    return true;
+}
+
+static bool domeLayoutStreamRoot(DomeLayoutTemplateStream &s)
+{
+    DomeLayoutStreamResult &r = *s.result;
+    if (!domeLayoutStreamExpectChar(s, '{')) return false;
+
+    bool seenSchema = false;
+    bool seenTemplateId = false;
+    bool seenTemplateName = false;
+    bool seenTemplateRevision = false;
+    bool seenCoordinateSpace = false;
+    bool seenElements = false;
+    char key[DOME_LAYOUT_STREAM_MAX_TOKEN + 1];
+
+    domeLayoutStreamSkipWs(s);
+    while (domeLayoutStreamPeek(s) != '}')
+    {
+        if (!domeLayoutStreamParseKey(s, key, sizeof(key))) return false;
+
+        if (strcmp(key, "schema_revision") == 0)
+        {
+            if (!domeLayoutStreamParseInt(s, r.schemaRevision))
+                return domeLayoutStreamFail(s, "schema_revision must be integer");
+            if (r.schemaRevision != DomeLayout::kSchemaRevision)
+                return domeLayoutStreamFail(s, "unsupported schema_revision");
+            seenSchema = true;
+        }
+        else if (strcmp(key, "template_id") == 0)
+        {
+            if (!domeLayoutStreamParseString(s, r.templateId, sizeof(r.templateId))) return false;
+            if (r.templateId[0] == '\0') return domeLayoutStreamFail(s, "template_id must not be empty");
+            seenTemplateId = true;
+        }
+        else if (strcmp(key, "template_name") == 0)
+        {
+            if (!domeLayoutStreamParseString(s, r.templateName, sizeof(r.templateName))) return false;
+            if (r.templateName[0] == '\0') return domeLayoutStreamFail(s, "template_name must not be empty");
+            seenTemplateName = true;
+        }
+        else if (strcmp(key, "template_revision") == 0)
+        {
+            if (!domeLayoutStreamParseInt(s, r.templateRevision))
+                return domeLayoutStreamFail(s, "template_revision must be integer");
+            if (r.templateRevision < 1)
+                return domeLayoutStreamFail(s, "template_revision must be positive");
+            seenTemplateRevision = true;
+        }
+        else if (strcmp(key, "coordinate_space") == 0)
+        {
+            if (!domeLayoutStreamCoordinateSpace(s)) return false;
+            seenCoordinateSpace = true;
+        }
+        else if (strcmp(key, "elements") == 0)
+        {
+            if (!domeLayoutStreamElements(s)) return false;
+            seenElements = true;
+        }
+        else if (!domeLayoutStreamSkipValue(s))
+        {
+            return false;
+        }
+
+        domeLayoutStreamSkipWs(s);
+        int c = domeLayoutStreamPeek(s);
+        if (c == ',')
+        {
+            domeLayoutStreamTake(s);
+            domeLayoutStreamSkipWs(s);
+            continue;
+        }
+        if (c == '}') break;
+        return domeLayoutStreamFail(s, "expected ',' or '}' in template root");
+    }
+    domeLayoutStreamTake(s);
+    domeLayoutStreamSkipWs(s);
+    if (domeLayoutStreamPeek(s) >= 0)
+        return domeLayoutStreamFail(s, "trailing content after template JSON");
+    if (!seenSchema || !seenTemplateId || !seenTemplateName ||
+        !seenTemplateRevision || !seenCoordinateSpace || !seenElements)
+    {
+        return domeLayoutStreamFail(s, "template missing required root fields");
+    }
+    return true;
+}
+
+// Validates one template. On failure result.error holds the first problem.
+static bool domeLayoutTemplateStreamRun(DomeLayoutStreamReadFn read, void *readCtx,
+                                        DomeLayoutStreamResult &result)
+{
+    memset(&result, 0, sizeof(result));
+    DomeLayoutTemplateStream s;
+    s.read = read;
+    s.readCtx = readCtx;
+    s.result = &result;
+    s.inLen = 0;
+    s.inPos = 0;
+    s.consumed = 0;
+    s.eof = false;
+    s.failed = false;
+    s.depth = 0;
+
+    domeLayoutStreamSkipWs(s);
+    if (domeLayoutStreamPeek(s) < 0)
+    {
+        if (!s.failed)
+            domeLayoutStreamFail(s, "template must be 1..%u bytes",
+                                 (unsigned)DOME_LAYOUT_TEMPLATE_MAX_BYTES);
+        return false;
+    }
+    bool ok = domeLayoutStreamRoot(s) && !s.failed;
+    result.sizeBytes = s.consumed;
+    return ok;
+}
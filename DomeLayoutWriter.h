@@ -0,0 +1,255 @@
+#pragma once
+// DomeLayoutWriter.h — serializer for the static part of /api/dome/layout.
+//
+// The bundled MK4 table and compiled custom templates both reach clients
+// through domeLayoutWriteStatic(), so a layout serves the same bytes whichever
+// path produced its element records. Output goes to a sink in small pieces;
+// splice() marks where the per-request runtime overlay goes (runtime_state_ts,
+// and each element's active/disabled fields right after "commandable").
+
+#include <stdio.h>
+#include <string.h>
+
+#include "GeneratedDomeLayout.h"
+
+struct DomeLayoutSink
+{
+    void (*write)(void *ctx, const char *data, size_t len);
+    // `id` is nullptr for the runtime_state_ts splice.
+    bool (*splice)(void *ctx, const char *id, bool commandable);
+    void *ctx;
+};
+
+// Header fields shared by the bundled table and a compiled custom template.
+struct DomeLayoutStaticMeta
+{
+    int schemaRevision;
+    const char *templateId;
+    const char *templateName;
+    int templateRevision;
+    const char *model;
+    const char *source;
+    const char *layoutSource;
+    const char *viewBox;
+};
+
+typedef void (*DomeLayoutElementAtFn)(void *ctx, size_t index, DomeLayout::DomeLayoutElement &out);
+
+static void domeLayoutWriteRaw(const DomeLayoutSink &sink, const char *text)
+{
+    sink.write(sink.ctx, text, strlen(text));
+}
+
+// Same escaping as jsonEscape() in AsyncWebInterface.h.
+static void domeLayoutWriteEscaped(const DomeLayoutSink &sink, const char *value)
+{
+    static const char kHex[] = "0123456789ABCDEF";
+    char buf[64];
+    size_t n = 0;
+    for (const char *p = value; *p; p++)
+    {
+        if (n + 6 > sizeof(buf))
+        {
+            sink.write(sink.ctx, buf, n);
+            n = 0;
+        }
+        char c = *p;
+        char esc = 0;
+        if (c == '"') esc = '"';
+        else if (c == '\\') esc = '\\';
+        else if (c == '\b') esc = 'b';
+        else if (c == '\f') esc = 'f';
+        else if (c == '\n') esc = 'n';
+        else if (c == '\r') esc = 'r';
+        else if (c == '\t') esc = 't';
+        if (esc)
+        {
+            buf[n++] = '\\';
+            buf[n++] = esc;
+        }
+        else if ((unsigned char)c < 0x20)
+        {
+            memcpy(buf + n, "\\u00", 4);
+            n += 4;
+            buf[n++] = kHex[(c >> 4) & 0x0F];
+            buf[n++] = kHex[c & 0x0F];
+        }
+        else
+        {
+            buf[n++] = c;
+        }
+    }
+    if (n > 0) sink.write(sink.ctx, buf, n);
+}
+
+static void domeLayoutWriteString(const DomeLayoutSink &sink, const char *value)
+{
+    domeLayoutWriteRaw(sink, "\"");
+    domeLayoutWriteEscaped(sink, value ? value : "");
+    domeLayoutWriteRaw(sink, "\"");
+}
+
+static void domeLayoutWriteKey(const DomeLayoutSink &sink, const char *key)
+{
+    domeLayoutWriteRaw(sink, ",\"");
+    domeLayoutWriteRaw(sink, key);
+    domeLayoutWriteRaw(sink, "\":");
+}
+
+static void domeLayoutWriteInt(const DomeLayoutSink &sink, int value)
+{
+    char buf[16];
+    snprintf(buf, sizeof(buf), "%d", value);
+    domeLayoutWriteRaw(sink, buf);
+}
+
+// One decimal, like String(value, 1) on the controller.
+static void domeLayoutWriteNumber(const DomeLayoutSink &sink, float value)
+{
+    char buf[24];
+    snprintf(buf, sizeof(buf), "%.1f", (double)value);
+    domeLayoutWriteRaw(sink, buf);
+}
+
+static void domeLayoutWriteFloat(const DomeLayoutSink &sink, const char *key, float value)
+{
+    domeLayoutWriteKey(sink, key);
+    domeLayoutWriteNumber(sink, value);
+}
+
+static void domeLayoutWriteNullableString(const DomeLayoutSink &sink, const char *key, const char *value)
+{
+    domeLayoutWriteKey(sink, key);
+    if (value) domeLayoutWriteString(sink, value);
+    else domeLayoutWriteRaw(sink, "null");
+}
+
+static void domeLayoutWriteStringArray(const DomeLayoutSink &sink, const char *key,
+                                       const char *const *values, size_t count)
+{
+    domeLayoutWriteKey(sink, key);
+    domeLayoutWriteRaw(sink, "[");
+    for (size_t i = 0; i < count; i++)
+    {
+        if (i > 0) domeLayoutWriteRaw(sink, ",");
+        domeLayoutWriteString(sink, values[i]);
+    }
+    domeLayoutWriteRaw(sink, "]");
+}
+
+static void domeLayoutWritePoint(const DomeLayoutSink &sink, const char *key,
+                                 const DomeLayout::DomeLayoutPoint &point)
+{
+    if (!point.present) return;
+    domeLayoutWriteKey(sink, key);
+    domeLayoutWriteRaw(sink, "{\"x\":");
+    domeLayoutWriteNumber(sink, point.x);
+    domeLayoutWriteFloat(sink, "y", point.y);
+    domeLayoutWriteRaw(sink, "}");
+}
+
+static void domeLayoutWriteGeometry(const DomeLayoutSink &sink, const DomeLayout::DomeLayoutElement &element)
+{
+    if (!element.inLayout) return;
+    domeLayoutWriteRaw(sink, ",\"geometry\":{\"type\":");
+    switch (element.geometryType)
+    {
+        case DomeLayout::DomeLayoutGeometryType::SvgPath:
+            domeLayoutWriteRaw(sink, "\"svg_path\",\"d\":");
+            domeLayoutWriteString(sink, element.svgPath);
+            break;
+        case DomeLayout::DomeLayoutGeometryType::Circle:
+            domeLayoutWriteRaw(sink, "\"circle\"");
+            domeLayoutWriteFloat(sink, "cx", element.cx);
+            domeLayoutWriteFloat(sink, "cy", element.cy);
+            domeLayoutWriteFloat(sink, "r", element.r);
+            break;
+        case DomeLayout::DomeLayoutGeometryType::Ellipse:
+            domeLayoutWriteRaw(sink, "\"ellipse\"");
+            domeLayoutWriteFloat(sink, "cx", element.cx);
+            domeLayoutWriteFloat(sink, "cy", element.cy);
+            domeLayoutWriteFloat(sink, "rx", element.rx);
+            domeLayoutWriteFloat(sink, "ry", element.ry);
+            domeLayoutWriteFloat(sink, "rotation", element.rotation);
+            break;
+        case DomeLayout::DomeLayoutGeometryType::Point:
+            domeLayoutWriteRaw(sink, "\"point\"");
+            domeLayoutWriteFloat(sink, "cx", element.cx);
+            domeLayoutWriteFloat(sink, "cy", element.cy);
+            domeLayoutWriteFloat(sink, "r", element.r);
+            break;
+    }
+    domeLayoutWriteRaw(sink, "}");
+}
+
+static void domeLayoutWriteCallout(const DomeLayoutSink &sink, const DomeLayout::DomeLayoutCallout &callout)
+{
+    if (!callout.present) return;
+    domeLayoutWriteRaw(sink, ",\"callout\":{\"x\":");
+    domeLayoutWriteNumber(sink, callout.x);
+    domeLayoutWriteFloat(sink, "y", callout.y);
+    domeLayoutWriteFloat(sink, "r", callout.r);
+    if (callout.connectorPresent)
+    {
+        domeLayoutWriteRaw(sink, ",\"connector_to\":{\"x\":");
+        domeLayoutWriteNumber(sink, callout.connectorX);
+        domeLayoutWriteFloat(sink, "y", callout.connectorY);
+        domeLayoutWriteRaw(sink, "}");
+    }
+    domeLayoutWriteRaw(sink, "}");
+}
+
+// Writes the static layout for `count` element records. False if the sink
+// refused a splice.
+static bool domeLayoutWriteStatic(const DomeLayoutSink &sink, const DomeLayoutStaticMeta &meta,
+                                  size_t count, DomeLayoutElementAtFn elementAt, void *ctx)
+{
+    domeLayoutWriteRaw(sink, "{\"schema_revision\":");
+    domeLayoutWriteInt(sink, meta.schemaRevision);
+    domeLayoutWriteKey(sink, "template_id");
+    domeLayoutWriteString(sink, meta.templateId);
+    domeLayoutWriteKey(sink, "template_name");
+    domeLayoutWriteString(sink, meta.templateName);
+    domeLayoutWriteKey(sink, "template_revision");
+    domeLayoutWriteInt(sink, meta.templateRevision);
+    domeLayoutWriteNullableString(sink, "model", meta.model);
+    domeLayoutWriteNullableString(sink, "source", meta.source);
+    domeLayoutWriteKey(sink, "layout_source");
+    domeLayoutWriteString(sink, meta.layoutSource);
+    domeLayoutWriteRaw(sink, ",\"coordinate_space\":{\"viewBox\":");
+    domeLayoutWriteString(sink, meta.viewBox);
+    domeLayoutWriteRaw(sink, "},\"runtime_state_ts\":");
+    if (!sink.splice(sink.ctx, nullptr, false)) return false;
+    domeLayoutWriteRaw(sink, ",\"elements\":[");
+
+    for (size_t i = 0; i < count; i++)
+    {
+        DomeLayout::DomeLayoutElement element;
+        elementAt(ctx, i, element);
+        if (i > 0) domeLayoutWriteRaw(sink, ",");
+        domeLayoutWriteRaw(sink, "{\"id\":");
+        domeLayoutWriteString(sink, element.id);
+        domeLayoutWriteKey(sink, "label");
+        domeLayoutWriteString(sink, element.label);
+        domeLayoutWriteKey(sink, "element_type");
+        domeLayoutWriteString(sink, element.elementType);
+        domeLayoutWriteNullableString(sink, "panel_kind", element.panelKind);
+        domeLayoutWriteNullableString(sink, "mounted_on", element.mountedOn);
+        domeLayoutWriteKey(sink, "in_layout");
+        domeLayoutWriteRaw(sink, element.inLayout ? "true" : "false");
+        domeLayoutWriteKey(sink, "commandable");
+        domeLayoutWriteRaw(sink, element.commandable ? "true" : "false");
+        if (!sink.splice(sink.ctx, element.id, element.commandable)) return false;
+        domeLayoutWriteStringArray(sink, "aliases", element.aliases, element.aliasCount);
+        domeLayoutWriteStringArray(sink, "capabilities", element.capabilities, element.capabilityCount);
+        domeLayoutWriteKey(sink, "render_order");
+        domeLayoutWriteInt(sink, element.renderOrder);
+        domeLayoutWriteGeometry(sink, element);
+        domeLayoutWritePoint(sink, "label_anchor", element.labelAnchor);
+        domeLayoutWriteCallout(sink, element.callout);
+        domeLayoutWriteRaw(sink, "}");
+    }
+
+    domeLayoutWriteRaw(sink, "]}");
+    return true;
+}
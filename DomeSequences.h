@@ -391,15 +391,21 @@ static bool parseVisualByte(const char *token, uint8_t maxValue, uint8_t &out)
 
 static bool parseVisualLogicColor(const char *token, LogicEngineRenderer::ColorVal &out)
 {
-    if (token == nullptr || token[0] == '\0' || strcmp(token, "DEFAULT") == 0) { out = LogicEngineRenderer::kDefault; return true; }
-    if (strcmp(token, "RED") == 0)    { out = LogicEngineRenderer::kRed; return true; }
-    if (strcmp(token, "BLUE") == 0)   { out = LogicEngineRenderer::kBlue; return true; }
-    if (strcmp(token, "GREEN") == 0)  { out = LogicEngineRenderer::kGreen; return true; }
-    if (strcmp(token, "YELLOW") == 0) { out = LogicEngineRenderer::kYellow; return true; }
-    if (strcmp(token, "ORANGE") == 0) { out = LogicEngineRenderer::kOrange; return true; }
-    if (strcmp(token, "PURPLE") == 0) { out = LogicEngineRenderer::kPurple; return true; }
-    if (strcmp(token, "WHITE") == 0)  { out = LogicEngineRenderer::kDefault; return true; } // ReelTwo logics have no white ColorVal.
-    return false;
+    const LedNamedColor *named = ledPaletteFindNamedColor(token);
+    if (named == nullptr) return false;
+    switch (named->id)
+    {
+        case kLedColorRed:    out = LogicEngineRenderer::kRed; break;
+        case kLedColorOrange: out = LogicEngineRenderer::kOrange; break;
+        case kLedColorYellow: out = LogicEngineRenderer::kYellow; break;
+        case kLedColorGreen:  out = LogicEngineRenderer::kGreen; break;
+        case kLedColorBlue:   out = LogicEngineRenderer::kBlue; break;
+        case kLedColorPurple: out = LogicEngineRenderer::kPurple; break;
+        case kLedColorWhite:  // ReelTwo logics have no white ColorVal.
+        case kLedColorDefault:
+        default:              out = LogicEngineRenderer::kDefault; break;
+    }
+    return true;
 }
 
 static bool parseVisualLogicMode(const char *token, uint8_t &out)
@@ -440,6 +446,7 @@ static void rejectVisualAuthoringCommand(const char *family, const char *cmd, co
     if (strcmp(family, "DL") == 0) sVisualAuthoringLogic.rejectCount++;
     else if (strcmp(family, "DT") == 0) sVisualAuthoringText.rejectCount++;
     else if (strcmp(family, "DH") == 0) sVisualAuthoringHolo.rejectCount++;
+    else if (strcmp(family, "DA") == 0) sVisualAuthoringSprite.rejectCount++;
     logCapture.printf("[%s][reject] %s cmd=%s\n", family, reason ? reason : "invalid", cmd ? cmd : "");
 }
 
@@ -489,7 +496,7 @@ static int8_t hexValue(char c)
 static bool decodeVisualText(const char *encoded, char *decoded, size_t decodedSize, uint8_t &decodedLen)
 {
     if (encoded == nullptr || decoded == nullptr || decodedSize == 0) return false;
-    if (strlen(encoded) == 0 || strlen(encoded) > 40) return false;
+    if (strlen(encoded) == 0 || strlen(encoded) > LOGIC_TEXT_MAX_ENCODED) return false;
     size_t out = 0;
     uint8_t newlineCount = 0;
     for (size_t i = 0; encoded[i] != '\0'; ++i)
@@ -513,7 +520,7 @@ static bool decodeVisualText(const char *encoded, char *decoded, size_t decodedS
         {
             return false;
         }
-        if (out + 1 >= decodedSize || out >= 32) return false;
+        if (out + 1 >= decodedSize || out >= LOGIC_TEXT_MAX_CHARS) return false;
         decoded[out++] = char(c);
     }
     if (out == 0) return false;
@@ -527,17 +534,20 @@ static bool validVisualTextTarget(const char *target)
     return strcmp(target, "FLD") == 0 || strcmp(target, "RLD") == 0 || strcmp(target, "LOGIC") == 0;
 }
 
-static void selectVisualTextTarget(const char *target, const char *text, LogicEngineRenderer::ColorVal color, uint8_t speed, uint8_t duration)
+static void selectVisualTextTarget(const char *target, const char *text, const LedNamedColor &color, uint8_t speed, uint8_t duration)
 {
+    // The glyph strip draws RGB directly, so WHITE is real white here; DEFAULT
+    // keeps the blue used by the status scrolls.
+    const LedNamedColor &rgb = (color.id == kLedColorDefault) ? *ledPaletteFindNamedColor("BLUE") : color;
     if (strcmp(target, "FLD") == 0 || strcmp(target, "LOGIC") == 0)
-        FLD.selectScrollTextLeft(text, color, speed, duration);
+        selectLogicTextStripRgb(FLD, text, rgb.r, rgb.g, rgb.b, speed, duration);
     if (strcmp(target, "RLD") == 0 || strcmp(target, "LOGIC") == 0)
-        RLD.selectScrollTextLeft(text, color, speed, duration);
+        selectLogicTextStripRgb(RLD, text, rgb.r, rgb.g, rgb.b, speed, duration);
 }
 
 static bool applyVisualTextCommand(const char *cmd)
 {
-    char buf[64];
+    char buf[LOGIC_TEXT_MAX_COMMAND + 1];
     strlcpy(buf, cmd, sizeof(buf));
     char *fields[6] = {};
     uint8_t count = splitVisualFields(buf, fields, SizeOfArray(fields));
@@ -550,17 +560,17 @@ static bool applyVisualTextCommand(const char *cmd)
         return true;
     }
     if (!validVisualTextTarget(target)) { rejectVisualAuthoringCommand("DT", cmd, "bad-target"); return true; }
-    LogicEngineRenderer::ColorVal color;
-    if (!parseVisualLogicColor(colorName, color)) { rejectVisualAuthoringCommand("DT", cmd, "bad-color"); return true; }
+    const LedNamedColor *color = ledPaletteFindNamedColor(colorName);
+    if (color == nullptr) { rejectVisualAuthoringCommand("DT", cmd, "bad-color"); return true; }
     uint8_t duration = 0;
     uint8_t speed = 0;
     if (!parseVisualByte(fields[3], 99, duration)) { rejectVisualAuthoringCommand("DT", cmd, "bad-duration"); return true; }
     if (!parseVisualByte(fields[4], 9, speed)) { rejectVisualAuthoringCommand("DT", cmd, "bad-speed"); return true; }
-    char decoded[33];
+    char decoded[LOGIC_TEXT_MAX_CHARS + 1];
     uint8_t decodedLen = 0;
     if (!decodeVisualText(fields[5], decoded, sizeof(decoded), decodedLen)) { rejectVisualAuthoringCommand("DT", cmd, "bad-text"); return true; }
 
-    selectVisualTextTarget(target, decoded, color, speed, duration);
+    selectVisualTextTarget(target, decoded, *color, speed, duration);
     strlcpy(sVisualAuthoringText.lastCmd, cmd, sizeof(sVisualAuthoringText.lastCmd));
     strlcpy(sVisualAuthoringText.target, target, sizeof(sVisualAuthoringText.target));
     strlcpy(sVisualAuthoringText.color, colorName, sizeof(sVisualAuthoringText.color));
@@ -585,16 +595,11 @@ static bool parseVisualHoloTarget(const char *target, char &code, uint8_t &proje
 static bool parseVisualHoloColor(const char *token, uint8_t &colorIndex, bool &isRandom)
 {
     isRandom = false;
-    if (token == nullptr || token[0] == '\0' || strcmp(token, "DEFAULT") == 0) { colorIndex = 0; return true; }
-    if (strcmp(token, "RANDOM") == 0) { colorIndex = 0; isRandom = true; return true; }
-    if (strcmp(token, "RED") == 0)    { colorIndex = 1; return true; }
-    if (strcmp(token, "ORANGE") == 0) { colorIndex = 2; return true; }
-    if (strcmp(token, "YELLOW") == 0) { colorIndex = 7; return true; }
-    if (strcmp(token, "GREEN") == 0)  { colorIndex = 3; return true; }
-    if (strcmp(token, "BLUE") == 0)   { colorIndex = 5; return true; }
-    if (strcmp(token, "PURPLE") == 0) { colorIndex = 6; return true; }
-    if (strcmp(token, "WHITE") == 0)  { colorIndex = 9; return true; }
-    return false;
+    if (token != nullptr && strcmp(token, "RANDOM") == 0) { colorIndex = 0; isRandom = true; return true; }
+    const LedNamedColor *named = ledPaletteFindNamedColor(token);
+    if (named == nullptr) return false;
+    colorIndex = named->holoIndex;
+    return true;
 }
 
 static void processVisualHoloCommand(char targetCode, const char *verb, uint8_t value = 0, bool withPipe = false)
@@ -709,21 +714,77 @@ static bool applyVisualHoloCommand(const char *cmd)
     return true;
 }
 
+static void selectVisualSpriteTarget(const char *target, const char *name, uint8_t duration)
+{
+    if (strcmp(target, "FLD") == 0 || strcmp(target, "LOGIC") == 0 || strcmp(target, "ALL") == 0)
+    {
+        logicSpriteBind(static_cast<LogicEngineRenderer *>(&FLD), name);
+        FLD.selectSequence(LOGICSPRITE, LogicEngineRenderer::kDefault, 0, duration);
+    }
+    if (strcmp(target, "RLD") == 0 || strcmp(target, "LOGIC") == 0 || strcmp(target, "ALL") == 0)
+    {
+        logicSpriteBind(static_cast<LogicEngineRenderer *>(&RLD), name);
+        RLD.selectSequence(LOGICSPRITE, LogicEngineRenderer::kDefault, 0, duration);
+    }
+    if (strcmp(target, "FPSI") == 0 || strcmp(target, "PSI") == 0 || strcmp(target, "ALL") == 0)
+    {
+        logicSpriteBind(static_cast<LogicEngineRenderer *>(&frontPSI), name);
+        frontPSI.selectSequence(LOGICSPRITE, LogicEngineRenderer::kDefault, 0, duration);
+    }
+    if (strcmp(target, "RPSI") == 0 || strcmp(target, "PSI") == 0 || strcmp(target, "ALL") == 0)
+    {
+        logicSpriteBind(static_cast<LogicEngineRenderer *>(&rearPSI), name);
+        rearPSI.selectSequence(LOGICSPRITE, LogicEngineRenderer::kDefault, 0, duration);
+    }
+}
+
+// DA:<target>:<sprite>[:<durationSec>] plays /sprites/<sprite>.lsa.
+static bool applyVisualSpriteCommand(const char *cmd)
+{
+    char buf[64];
+    strlcpy(buf, cmd, sizeof(buf));
+    char *fields[5] = {};
+    uint8_t count = splitVisualFields(buf, fields, SizeOfArray(fields));
+    if (count < 3 || count > 4) { rejectVisualAuthoringCommand("DA", cmd, "field-count"); return true; }
+    const char *target = fields[1];
+    const char *name = fields[2];
+    if (!isVisualEnumToken(target)) { rejectVisualAuthoringCommand("DA", cmd, "bad-enum-token"); return true; }
+    if (!validVisualLogicTarget(target)) { rejectVisualAuthoringCommand("DA", cmd, "bad-target"); return true; }
+    if (!logicSpriteValidName(name)) { rejectVisualAuthoringCommand("DA", cmd, "bad-name"); return true; }
+    uint8_t duration = 0;
+    if (count == 4 && !parseVisualByte(fields[3], 99, duration)) { rejectVisualAuthoringCommand("DA", cmd, "bad-duration"); return true; }
+    LogicSpriteHeader header;
+    if (!logicSpriteLoadHeader(name, header)) { rejectVisualAuthoringCommand("DA", cmd, "missing-sprite"); return true; }
+
+    selectVisualSpriteTarget(target, name, duration);
+    strlcpy(sVisualAuthoringSprite.lastCmd, cmd, sizeof(sVisualAuthoringSprite.lastCmd));
+    strlcpy(sVisualAuthoringSprite.target, target, sizeof(sVisualAuthoringSprite.target));
+    strlcpy(sVisualAuthoringSprite.name, name, sizeof(sVisualAuthoringSprite.name));
+    sVisualAuthoringSprite.duration = duration;
+    sVisualAuthoringSprite.applyCount++;
+    sVisualAuthoringSprite.lastAppliedMs = millis();
+    logCapture.printf("[DA] applied target=%s sprite=%s duration=%u\n", target, name, duration);
+    return true;
+}
+
 static bool applyDomeVisualAuthoringCommand(const char *source, const char *cmd)
 {
     (void)source;
     if (cmd == nullptr) return false;
     size_t len = strlen(cmd);
-    if (len > 63)
+    // DT: carries free text and gets a longer line than the enum-only families.
+    if (len > LOGIC_TEXT_MAX_COMMAND || (len > 63 && strncmp(cmd, "DT:", 3) != 0))
     {
         if (strncmp(cmd, "DL:", 3) == 0) { rejectVisualAuthoringCommand("DL", cmd, "too-long"); return true; }
         if (strncmp(cmd, "DT:", 3) == 0) { rejectVisualAuthoringCommand("DT", cmd, "too-long"); return true; }
         if (strncmp(cmd, "DH:", 3) == 0) { rejectVisualAuthoringCommand("DH", cmd, "too-long"); return true; }
+        if (strncmp(cmd, "DA:", 3) == 0) { rejectVisualAuthoringCommand("DA", cmd, "too-long"); return true; }
         return false;
     }
     if (strncmp(cmd, "DL:", 3) == 0) return applyVisualLogicCommand(cmd);
     if (strncmp(cmd, "DT:", 3) == 0) return applyVisualTextCommand(cmd);
     if (strncmp(cmd, "DH:", 3) == 0) return applyVisualHoloCommand(cmd);
+    if (strncmp(cmd, "DA:", 3) == 0) return applyVisualSpriteCommand(cmd);
     return false;
 }
 
@@ -747,7 +808,7 @@ ANIMATION(domePiesOpen)
     DO_START()
     DO_ONCE({ cancelPanelRelease(DOME_PIE_RELEASE_MASK); domeBeginSequence(12); dome_PiesOpen = true; })
     DO_WAIT_MILLIS(100)
-    DO_ONCE({ if (preferences.getBool("dm_happy_sound", true)) domeSendToBody("HAPPY"); })
+    DO_ONCE({ if (configGetBool(kCfgDomeHappySound)) domeSendToBody("HAPPY"); })
     // iteration 1
     DO_ONCE({ domeStaggerMove(piePanels,    6, DOME_PIE_PANEL_OPEN, DOME_MOVE_FASTSPEED, DOME_MOVE_FASTSPEED); })
     DO_WAIT_MILLIS(DOME_PIE_OPEN_WAVE_MS)
@@ -776,7 +837,7 @@ ANIMATION(domePiesClose)
         domeBeginSequence(12);
         dome_PiesOpen = false;
         domeResetHolos();
-        if (preferences.getBool("dm_happy_sound", true))
+        if (configGetBool(kCfgDomeHappySound))
             domeSendToBody("HAPPY");
         domeStaggerMove(piePanels, 6, DOME_PANEL_CLOSE, DOME_MOVE_SPEED, DOME_MOVE_SPEED);
     })
@@ -853,7 +914,7 @@ ANIMATION(domeLowOpen)
         cancelPanelRelease(RING_PANELS_MASK);
         domeBeginSequence(15);
         dome_LowOpen = true;
-        if (preferences.getBool("dm_happy_sound", true))
+        if (configGetBool(kCfgDomeHappySound))
             domeSendToBody("HAPPY");
     })
     // iteration 1
@@ -883,7 +944,7 @@ ANIMATION(domeLowClose)
         domeBeginSequence(15);
         dome_LowOpen = false;
         domeResetHolos();
-        if (preferences.getBool("dm_happy_sound", true))
+        if (configGetBool(kCfgDomeHappySound))
             domeSendToBody("HAPPY");
     })
     DO_ONCE({ domeLowCloseAll(); })
@@ -904,7 +965,7 @@ ANIMATION(domeAllClose)
         cancelPanelRelease(ALL_DOME_PANELS_MASK);
         domeBeginSequence(10);
         dome_AllOpen = false;
-        if (preferences.getBool("dm_happy_sound", true))
+        if (configGetBool(kCfgDomeHappySound))
             domeSendToBody("HAPPY");
         domeStaggerMove(allPanels, 13, DOME_PANEL_CLOSE, DOME_MOVE_SPEED, DOME_MOVE_SPEED);
     })
@@ -934,7 +995,7 @@ ANIMATION(domeAllOpen)
         cancelPanelRelease(ALL_DOME_PANELS_MASK);
         domeBeginSequence(10);
         dome_AllOpen = true;
-        if (preferences.getBool("dm_happy_sound", true))
+        if (configGetBool(kCfgDomeHappySound))
             domeSendToBody("HAPPY");
         domeStaggerMove(piePanels, 6, DOME_PIE_PANEL_OPEN, DOME_MOVE_SPEED, DOME_MOVE_SPEED);
     })
@@ -1075,7 +1136,7 @@ ANIMATION(domeScream)
     DO_WAIT_MILLIS(2800)
     DO_ONCE({
         dome_AllOpen = false;
-        if (preferences.getBool("dm_happy_sound", true))
+        if (configGetBool(kCfgDomeHappySound))
             domeSendToBody("HAPPY");
         domeStaggerMove(allPanels, 13, DOME_PANEL_CLOSE, DOME_MOVE_SPEED, 0);
     })
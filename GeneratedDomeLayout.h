@@ -2,6 +2,7 @@
 
 #include <stddef.h>
 #include <stdint.h>
+#include <string.h>
 
 // Generated by tools/generate_dome_layout_header.py.
 // Edit templates/dome-layouts/mr-baddeley-complex-dome-mk4.json instead.
@@ -916,4 +917,87 @@ static constexpr DomeLayoutElement kElements[] = {
 
 static constexpr size_t kElementCount = sizeof(kElements) / sizeof(kElements[0]);
 
+struct DomeLayoutIdIndexEntry {
+    const char *id;
+    int8_t elementIndex;
+    int8_t panelSlot;
+};
+
+// kElements ids in strcmp() order, for binary search.
+static constexpr DomeLayoutIdIndexEntry kIdIndex[] = {
+    { "FLD", 16, -1 },
+    { "FPSI", 13, -1 },
+    { "HP1", 11, -1 },
+    { "HP2", 0, -1 },
+    { "HP3", 23, -1 },
+    { "MP", 5, -1 },
+    { "P1", 10, 0 },
+    { "P10", 18, -1 },
+    { "P11", 17, 5 },
+    { "P12", 15, -1 },
+    { "P13", 14, 6 },
+    { "P14", 12, -1 },
+    { "P2", 9, 1 },
+    { "P3", 8, 2 },
+    { "P4", 7, 3 },
+    { "P5", 6, -1 },
+    { "P6", 4, -1 },
+    { "P7", 3, 4 },
+    { "P8", 1, -1 },
+    { "P9", 19, -1 },
+    { "PP1", 25, 8 },
+    { "PP2", 24, 9 },
+    { "PP3", 22, 12 },
+    { "PP4", 21, 10 },
+    { "PP5", 27, 7 },
+    { "PP6", 26, 11 },
+    { "RLD", 20, -1 },
+    { "RPSI", 2, -1 },
+};
+
+static constexpr size_t kIdIndexCount = sizeof(kIdIndex) / sizeof(kIdIndex[0]);
+
+// Panel servo slot -> kElements index (WiringConfig.h kPanelSlotLabels order).
+static constexpr int8_t kPanelSlotElementIndex[] = {
+    10,  // P1
+    9,  // P2
+    8,  // P3
+    7,  // P4
+    3,  // P7
+    17,  // P11
+    14,  // P13
+    27,  // PP5
+    25,  // PP1
+    24,  // PP2
+    21,  // PP4
+    26,  // PP6
+    22,  // PP3
+};
+
+static constexpr size_t kPanelSlotCount = sizeof(kPanelSlotElementIndex) / sizeof(kPanelSlotElementIndex[0]);
+
+static inline const DomeLayoutIdIndexEntry *findId(const char *id) {
+    if (!id) return nullptr;
+    size_t lo = 0;
+    size_t hi = kIdIndexCount;
+    while (lo < hi) {
+        size_t mid = (lo + hi) / 2;
+        int cmp = strcmp(id, kIdIndex[mid].id);
+        if (cmp == 0) return &kIdIndex[mid];
+        if (cmp < 0) hi = mid;
+        else lo = mid + 1;
+    }
+    return nullptr;
+}
+
+static inline int elementIndexForId(const char *id) {
+    const DomeLayoutIdIndexEntry *entry = findId(id);
+    return entry ? entry->elementIndex : -1;
+}
+
+static inline int panelSlotForId(const char *id) {
+    const DomeLayoutIdIndexEntry *entry = findId(id);
+    return entry ? entry->panelSlot : -1;
+}
+
 }  // namespace DomeLayout
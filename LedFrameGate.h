@@ -0,0 +1,214 @@
+#pragma once
+// LedFrameGate.h — suppress identical NeoPixel frames before they reach RMT.
+//
+// Logic displays, PSIs and HoloLights push a full frame on every animation
+// tick even when the effect (solid colour, held text, Lights Out, Quiet mood)
+// produced the same pixels as last time. Each gated output keeps an FNV-1a
+// hash of the last frame it pushed; an identical frame is counted as skipped
+// and not transmitted. A slow keepalive still re-sends an unchanged frame so a
+// pixel corrupted by line noise cannot stay wrong indefinitely.
+//
+// The only library-coupled piece is LedFrameGated<>, which sits between a
+// ReelTwo display class and its driver by overriding show(). Build with
+// -DAP_ENABLE_LED_FRAME_GATE=0 to fall back to the plain display classes.
+
+#include <Arduino.h>
+
+#include "LedRenderTask.h"
+
+#ifndef AP_ENABLE_LED_FRAME_GATE
+#define AP_ENABLE_LED_FRAME_GATE 1
+#endif
+
+#define LED_FRAME_GATE_MAX_OUTPUTS 8
+#define LED_FRAME_GATE_KEEPALIVE_MS 1000
+
+struct LedFrameGateStats
+{
+    const char *name;
+    uint32_t lastHash;
+    uint32_t lastPushMs;
+    uint32_t pushed;
+    uint32_t skipped;
+    uint32_t keepalive;
+    bool primed;
+};
+
+static LedFrameGateStats *sLedFrameGates[LED_FRAME_GATE_MAX_OUTPUTS];
+static uint8_t sLedFrameGateCount = 0;
+
+static uint32_t ledFrameGateHash(const uint8_t *data, size_t len)
+{
+    uint32_t hash = 2166136261UL;
+    for (size_t i = 0; i < len; i++)
+    {
+        hash ^= data[i];
+        hash *= 16777619UL;
+    }
+    return hash;
+}
+
+static void ledFrameGateRegister(LedFrameGateStats *gate)
+{
+    if (gate == nullptr || sLedFrameGateCount >= LED_FRAME_GATE_MAX_OUTPUTS)
+        return;
+    sLedFrameGates[sLedFrameGateCount++] = gate;
+}
+
+// Returns true when the frame must be transmitted. A null/empty frame is always
+// pushed so an output whose buffer cannot be inspected behaves as before.
+static bool ledFrameGateShouldPush(LedFrameGateStats &gate, const uint8_t *frame,
+                                   size_t len, uint32_t nowMs)
+{
+    if (frame == nullptr || len == 0)
+    {
+        gate.pushed++;
+        gate.lastPushMs = nowMs;
+        return true;
+    }
+
+    uint32_t hash = ledFrameGateHash(frame, len);
+    if (gate.primed && hash == gate.lastHash)
+    {
+        if ((uint32_t)(nowMs - gate.lastPushMs) < LED_FRAME_GATE_KEEPALIVE_MS)
+        {
+            gate.skipped++;
+            return false;
+        }
+        gate.keepalive++;
+    }
+
+    gate.primed = true;
+    gate.lastHash = hash;
+    gate.lastPushMs = nowMs;
+    gate.pushed++;
+    return true;
+}
+
+static String ledFrameGateBuildJson()
+{
+    String json = "{\"enabled\":";
+    json += (AP_ENABLE_LED_FRAME_GATE ? "true" : "false");
+    json += ",\"keepalive_ms\":" + String(LED_FRAME_GATE_KEEPALIVE_MS);
+    json += ",\"outputs\":[";
+    for (uint8_t i = 0; i < sLedFrameGateCount; i++)
+    {
+        const LedFrameGateStats &gate = *sLedFrameGates[i];
+        uint32_t total = gate.pushed + gate.skipped;
+        if (i > 0) json += ",";
+        json += "{\"name\":\"" + String(gate.name) + "\"";
+        json += ",\"pushed\":" + String(gate.pushed);
+        json += ",\"skipped\":" + String(gate.skipped);
+        json += ",\"keepalive\":" + String(gate.keepalive);
+        json += ",\"skip_pct\":" + String(total > 0 ? (uint32_t)((uint64_t)gate.skipped * 100 / total) : 0);
+        json += "}";
+    }
+    json += "]}";
+    return json;
+}
+
+#if AP_ENABLE_LED_FRAME_GATE
+// Wraps a ReelTwo LED output. The display keeps rendering exactly as before;
+// only the final show() is elided when the pixel buffer hashes the same as the
+// last transmitted frame. Relies on the display exposing its raw pixel buffer
+// via getPixels()/numPixels() (NeoPixel-style) and pushing through a virtual
+// show(), which is the case for the LogicEngine and HoloLights classes.
+//
+// The wrapper is also the render-task seam (LedRenderTask.h): when the task is
+// active, animate() runs there and show() only marks the frame ready; the loop
+// core's animate() commits it.
+template <class DISPLAY, uint8_t BYTES_PER_PIXEL = 3>
+class LedFrameGated : public DISPLAY, public LedRenderTarget
+{
+public:
+    template <typename... Args>
+    LedFrameGated(const char *name, Args &&...args) :
+        DISPLAY(static_cast<Args &&>(args)...)
+    {
+        fGate = LedFrameGateStats{name, 0, 0, 0, 0, 0, false};
+        ledFrameGateRegister(&fGate);
+        ledRenderTaskRegister(this);
+    }
+
+    virtual void animate() override
+    {
+        if (!ledRenderTaskActive())
+        {
+            DISPLAY::animate();
+            return;
+        }
+        // Loop core: commit the frame the render task finished, if any. A
+        // state change in progress on another task keeps it for the next pass.
+        if (!fFrameReady) return;
+        LedDisplayGuard guard(0);
+        portENTER_CRITICAL(&sLedRenderMux);
+        bool canCommit = guard.held() && fFrameReady && fOwner == kOwnerNone;
+        if (!canCommit) sLedRenderStats.busySkips++;
+        else fOwner = kOwnerCommit;
+        portEXIT_CRITICAL(&sLedRenderMux);
+        if (!canCommit) return;
+
+        pushFrame();
+        portENTER_CRITICAL(&sLedRenderMux);
+        fFrameReady = false;
+        fOwner = kOwnerNone;
+        sLedRenderStats.commits++;
+        portEXIT_CRITICAL(&sLedRenderMux);
+    }
+
+    virtual void renderOffLoop() override
+    {
+        portENTER_CRITICAL(&sLedRenderMux);
+        bool canRender = (fOwner == kOwnerNone);
+        if (canRender) fOwner = kOwnerRender;
+        portEXIT_CRITICAL(&sLedRenderMux);
+        if (!canRender) return;
+
+        {
+            LedDisplayGuard guard;
+            DISPLAY::animate();
+        }
+        portENTER_CRITICAL(&sLedRenderMux);
+        fOwner = kOwnerNone;
+        portEXIT_CRITICAL(&sLedRenderMux);
+    }
+
+    virtual void show() override
+    {
+        if (ledRenderTaskIsCurrent())
+        {
+            if (fFrameReady) sLedRenderStats.overwritten++;
+            fFrameReady = true;
+            return;
+        }
+        pushFrame();
+    }
+
+    const LedFrameGateStats &frameGateStats() const { return fGate; }
+
+private:
+    enum
+    {
+        kOwnerNone,
+        kOwnerRender,
+        kOwnerCommit
+    };
+
+    void pushFrame()
+    {
+        const uint8_t *frame = (const uint8_t *)DISPLAY::getPixels();
+        size_t len = (size_t)DISPLAY::numPixels() * BYTES_PER_PIXEL;
+        if (ledFrameGateShouldPush(fGate, frame, len, millis()))
+            DISPLAY::show();
+    }
+
+    LedFrameGateStats fGate;
+    volatile bool fFrameReady = false;
+    volatile uint8_t fOwner = kOwnerNone;
+};
+#define LED_FRAME_GATED(...) LedFrameGated<__VA_ARGS__>
+#define LED_FRAME_GATE_NAME(name) name,
+#else
+#define LED_FRAME_GATED(...) __VA_ARGS__
+#define LED_FRAME_GATE_NAME(name)
+#endif
@@ -0,0 +1,170 @@
+#pragma once
+// LedPalette.h — shared colour tables for logic, PSI and holo effects.
+//
+// One place for the colour maths that effects and Marcduino colour parsers
+// used to carry privately: the 1536-step RGB hue wheel (computed, not tabled —
+// each step is a linear ramp), the ramp palettes used by Fade & Scroll, an HSV
+// helper on top of the wheel, and the named colours accepted by DL:/DT:/DH:
+// together with their holo colour indices.
+
+#include <stdint.h>
+#include <string.h>
+
+#define LED_PALETTE_WHEEL_STEPS 1536
+
+// Hue wheel: red -> yellow -> green -> cyan -> blue -> magenta -> red, 256
+// steps per segment. Matches the LUT formerly built by PlasmaEffect.h and the
+// RGB palette in FadeAndScrollEffect.h.
+static inline void ledPaletteWheel(uint16_t pos, uint8_t &r, uint8_t &g, uint8_t &b)
+{
+    pos %= LED_PALETTE_WHEEL_STEPS;
+    uint8_t i = uint8_t(pos & 0xFF);
+    switch (pos >> 8)
+    {
+        case 0:  r = 255;     g = i;       b = 0;       break;
+        case 1:  r = 255 - i; g = 255;     b = 0;       break;
+        case 2:  r = 0;       g = 255;     b = i;       break;
+        case 3:  r = 0;       g = 255 - i; b = 255;     break;
+        case 4:  r = i;       g = 0;       b = 255;     break;
+        default: r = 255;     g = 0;       b = 255 - i; break;
+    }
+}
+
+static inline uint8_t ledPaletteScale8(uint8_t value, uint8_t scale)
+{
+    return uint8_t(((uint16_t)value * (uint16_t)(scale + 1)) >> 8);
+}
+
+// 8-bit HSV on top of the wheel: hue 0-255 spans the full wheel.
+static inline void ledPaletteHsv(uint8_t hue, uint8_t sat, uint8_t val,
+                                 uint8_t &r, uint8_t &g, uint8_t &b)
+{
+    ledPaletteWheel(uint16_t(hue) * 6, r, g, b);
+    uint8_t desat = uint8_t(255 - sat);
+    r = ledPaletteScale8(uint8_t(ledPaletteScale8(r, sat) + desat), val);
+    g = ledPaletteScale8(uint8_t(ledPaletteScale8(g, sat) + desat), val);
+    b = ledPaletteScale8(uint8_t(ledPaletteScale8(b, sat) + desat), val);
+}
+
+// Fade & Scroll ramp palettes. Lengths and contents match the per-effect
+// new CRGB[] tables they replace.
+enum LedRampPalette
+{
+    kLedRampWheel,
+    kLedRampRed,
+    kLedRampGreen,
+    kLedRampBlue,
+    kLedRampWhite,
+    kLedRampHalf,
+    kLedRampLast = kLedRampHalf
+};
+
+static inline int ledRampPaletteLength(LedRampPalette palette)
+{
+    switch (palette)
+    {
+        case kLedRampWheel: return LED_PALETTE_WHEEL_STEPS;
+        case kLedRampHalf:  return 768;
+        default:            return 512;
+    }
+}
+
+static inline void ledRampPaletteSample(LedRampPalette palette, int pos,
+                                        uint8_t &r, uint8_t &g, uint8_t &b)
+{
+    int len = ledRampPaletteLength(palette);
+    if (pos < 0) pos = 0;
+    if (pos >= len) pos = len - 1;
+    if (palette == kLedRampWheel)
+    {
+        ledPaletteWheel(uint16_t(pos), r, g, b);
+        return;
+    }
+    if (palette == kLedRampHalf)
+    {
+        uint8_t i = uint8_t(pos & 0x7F);
+        switch (pos >> 7)
+        {
+            case 0:  r = 254 - 2 * i; g = 0;           b = 127 - i;     break;
+            case 1:  r = i;           g = 2 * i;       b = 0;           break;
+            case 2:  r = 127 - i;     g = 254 - 2 * i; b = 0;           break;
+            case 3:  r = 0;           g = i;           b = 2 * i;       break;
+            case 4:  r = 0;           g = 127 - i;     b = 254 - 2 * i; break;
+            default: r = 2 * i;       g = 0;           b = i;           break;
+        }
+        return;
+    }
+    uint8_t level = (pos < 256) ? uint8_t(pos) : uint8_t(511 - pos);
+    r = (palette == kLedRampRed || palette == kLedRampWhite) ? level : 0;
+    g = (palette == kLedRampGreen || palette == kLedRampWhite) ? level : 0;
+    b = (palette == kLedRampBlue || palette == kLedRampWhite) ? level : 0;
+}
+
+// Named colours shared by the visual authoring parsers. holoIndex is the
+// HoloLights colour number used by HPx005<n>; DEFAULT maps to 0 (random).
+enum LedNamedColorId
+{
+    kLedColorDefault,
+    kLedColorRed,
+    kLedColorOrange,
+    kLedColorYellow,
+    kLedColorGreen,
+    kLedColorBlue,
+    kLedColorPurple,
+    kLedColorWhite
+};
+
+struct LedNamedColor
+{
+    const char *name;
+    LedNamedColorId id;
+    uint8_t r;
+    uint8_t g;
+    uint8_t b;
+    uint8_t holoIndex;
+};
+
+static const LedNamedColor kLedNamedColors[] = {
+    { "DEFAULT", kLedColorDefault, 0,   0,   0,   0 },
+    { "RED",     kLedColorRed,     255, 0,   0,   1 },
+    { "ORANGE",  kLedColorOrange,  255, 128, 0,   2 },
+    { "YELLOW",  kLedColorYellow,  255, 255, 0,   7 },
+    { "GREEN",   kLedColorGreen,   0,   255, 0,   3 },
+    { "BLUE",    kLedColorBlue,    0,   0,   255, 5 },
+    { "PURPLE",  kLedColorPurple,  128, 0,   255, 6 },
+    { "WHITE",   kLedColorWhite,   255, 255, 255, 9 },
+};
+
+// An empty/null token resolves to DEFAULT, matching the DL:/DT:/DH: grammar.
+static const LedNamedColor *ledPaletteFindNamedColor(const char *token)
+{
+    if (token == nullptr || token[0] == '\0') return &kLedNamedColors[0];
+    for (size_t i = 0; i < sizeof(kLedNamedColors) / sizeof(kLedNamedColors[0]); i++)
+    {
+        if (strcmp(token, kLedNamedColors[i].name) == 0) return &kLedNamedColors[i];
+    }
+    return nullptr;
+}
+
+// Nearest HoloLights colour index for an *ONxx RGB payload. Classifies by the
+// dominant channel first, then by the secondary channels; near-black is 0.
+static uint8_t ledPaletteHoloIndexForRgb(uint16_t r, uint16_t g, uint16_t b)
+{
+    if (r < 16 && g < 16 && b < 16) return 0;
+    if (r >= g && r >= b)
+    {
+        if (g > 180 && b < 100) return 7;
+        if (b > 180 && g > 180) return 8;
+        if (b > 140) return 6;
+        return 1;
+    }
+    if (g >= r && g >= b)
+    {
+        if (r > 180 && b < 100) return 2;
+        if (b > 160) return 4;
+        return 3;
+    }
+    if (r > 160 && g > 160) return 9;
+    if (r > 140) return 6;
+    return 5;
+}
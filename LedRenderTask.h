@@ -0,0 +1,215 @@
+#pragma once
+// LedRenderTask.h — optional core-0 render pass for the LED outputs.
+//
+// By default every display renders and transmits from AnimatedEvent::process()
+// on the Arduino loop core, sharing it with servo dispatch and command
+// draining. With the "ledrtask" preference set (takes effect at boot), a task
+// pinned to core 0 runs each gated output's animate() instead; the output's
+// show() then only marks its frame ready, and the loop core commits (transmits)
+// the ready frame the next time AnimatedEvent::process() reaches it.
+//
+// Handoff is an ownership flag per output guarded by a short critical section:
+// the render task never touches an output the loop core is committing, and the
+// loop core skips an output the render task is mid-frame on.
+//
+// Display state (sequence, text, effect width) is shared with every task that
+// issues commands: the loop drains the Marcduino queue and runs sequences, the
+// web task handles immediate visual commands, sleep/wake and OTA feedback, and
+// the event task admits WiFi Marcduino input. While the render task runs, they
+// hold LedDisplayGuard around the state change only, and the render task takes
+// it per output around animate(), so a change waits at most one output's
+// render. The loop's commit only tries the lock and leaves the frame ready for
+// the next pass if it is busy; the rest of AnimatedEvent::process() (servos,
+// sound) runs unlocked. Without the render task the guard is a no-op.
+//
+// Main-loop period statistics are collected in both modes so the effect of the
+// render task on jitter can be compared from /api/health.
+
+#include <Arduino.h>
+
+#ifndef AP_ENABLE_LED_RENDER_TASK
+#define AP_ENABLE_LED_RENDER_TASK 1
+#endif
+
+#define LED_RENDER_TASK_MAX_TARGETS 8
+#define LED_RENDER_TASK_STACK 4096
+#define LED_RENDER_TASK_CORE 0
+#define LED_RENDER_JITTER_WINDOW_MS 10000
+#define LED_RENDER_JITTER_SLOW_US 5000
+
+class LedRenderTarget
+{
+public:
+    // Called on the render task. Renders one frame if the output is not being
+    // committed by the loop core.
+    virtual void renderOffLoop() = 0;
+};
+
+struct LedRenderTaskStats
+{
+    uint32_t passes;
+    uint32_t passUsLast;
+    uint32_t passUsMax;
+    uint32_t commits;
+    uint32_t busySkips;
+    uint32_t overwritten;
+};
+
+struct LedMainLoopJitter
+{
+    uint32_t lastUs;
+    uint32_t samples;
+    uint32_t avgUs;        // EMA, 1/16 weight
+    uint32_t maxUs;
+    uint32_t windowMaxUs;
+    uint32_t lastWindowMaxUs;
+    uint32_t windowStartMs;
+    uint32_t slowCount;    // periods over LED_RENDER_JITTER_SLOW_US
+};
+
+static LedRenderTarget *sLedRenderTargets[LED_RENDER_TASK_MAX_TARGETS];
+static uint8_t sLedRenderTargetCount = 0;
+static TaskHandle_t sLedRenderTaskHandle = nullptr;
+static volatile bool sLedRenderTaskActive = false;
+static portMUX_TYPE sLedRenderMux = portMUX_INITIALIZER_UNLOCKED;
+static SemaphoreHandle_t sLedDisplayMutex = nullptr;
+static LedRenderTaskStats sLedRenderStats;
+static LedMainLoopJitter sLedMainLoopJitter;
+
+// Create the display lock. Call first thing in setup(), before any other task
+// that can issue display commands is started.
+static void ledDisplayLockInit()
+{
+    if (sLedDisplayMutex == nullptr)
+        sLedDisplayMutex = xSemaphoreCreateRecursiveMutex();
+}
+
+// Scoped hold of the display lock while the render task runs. Recursive,
+// because command handlers nest (a sequence step can dispatch further
+// Marcduino commands). With waitTicks = 0 it only tries; check held().
+class LedDisplayGuard
+{
+public:
+    explicit LedDisplayGuard(TickType_t waitTicks = portMAX_DELAY) :
+        fHeld(sLedRenderTaskActive && sLedDisplayMutex != nullptr &&
+              xSemaphoreTakeRecursive(sLedDisplayMutex, waitTicks) == pdTRUE)
+    {
+    }
+
+    ~LedDisplayGuard()
+    {
+        if (fHeld)
+            xSemaphoreGiveRecursive(sLedDisplayMutex);
+    }
+
+    bool held() const { return fHeld; }
+
+private:
+    LedDisplayGuard(const LedDisplayGuard &);
+    LedDisplayGuard &operator=(const LedDisplayGuard &);
+
+    bool fHeld;
+};
+
+static void ledRenderTaskRegister(LedRenderTarget *target)
+{
+    if (target == nullptr || sLedRenderTargetCount >= LED_RENDER_TASK_MAX_TARGETS)
+        return;
+    sLedRenderTargets[sLedRenderTargetCount++] = target;
+}
+
+static inline bool ledRenderTaskActive()
+{
+    return sLedRenderTaskActive;
+}
+
+static inline bool ledRenderTaskIsCurrent()
+{
+    return sLedRenderTaskHandle != nullptr && xTaskGetCurrentTaskHandle() == sLedRenderTaskHandle;
+}
+
+static void ledRenderTaskLoop(void *)
+{
+    for (;;)
+    {
+        uint32_t start = micros();
+        for (uint8_t i = 0; i < sLedRenderTargetCount; i++)
+            sLedRenderTargets[i]->renderOffLoop();
+        uint32_t elapsed = micros() - start;
+        sLedRenderStats.passes++;
+        sLedRenderStats.passUsLast = elapsed;
+        if (elapsed > sLedRenderStats.passUsMax)
+            sLedRenderStats.passUsMax = elapsed;
+        vTaskDelay(1);
+    }
+}
+
+// Start the render task. Call once from setup() after the displays are set up.
+static bool ledRenderTaskBegin()
+{
+#if AP_ENABLE_LED_RENDER_TASK
+    if (sLedRenderTaskHandle != nullptr) return true;
+    if (sLedRenderTargetCount == 0) return false; // frame gate wrappers compiled out
+    // Active before the task exists, so its first animate() already takes the lock.
+    sLedRenderTaskActive = true;
+    if (xTaskCreatePinnedToCore(ledRenderTaskLoop, "LedRender", LED_RENDER_TASK_STACK,
+                                NULL, 1, &sLedRenderTaskHandle, LED_RENDER_TASK_CORE) != pdPASS)
+    {
+        sLedRenderTaskActive = false;
+        sLedRenderTaskHandle = nullptr;
+        return false;
+    }
+    return true;
+#else
+    return false;
+#endif
+}
+
+// Call once per mainLoop() iteration to sample the loop period.
+static void ledRenderNoteMainLoop()
+{
+    uint32_t nowUs = micros();
+    LedMainLoopJitter &j = sLedMainLoopJitter;
+    if (j.samples++ == 0)
+    {
+        j.lastUs = nowUs;
+        j.windowStartMs = millis();
+        return;
+    }
+    uint32_t period = nowUs - j.lastUs;
+    j.lastUs = nowUs;
+    j.avgUs = (j.samples == 2) ? period : j.avgUs + ((int32_t)(period - j.avgUs) >> 4);
+    if (period > j.maxUs) j.maxUs = period;
+    if (period > j.windowMaxUs) j.windowMaxUs = period;
+    if (period > LED_RENDER_JITTER_SLOW_US) j.slowCount++;
+    uint32_t nowMs = millis();
+    if ((uint32_t)(nowMs - j.windowStartMs) >= LED_RENDER_JITTER_WINDOW_MS)
+    {
+        j.lastWindowMaxUs = j.windowMaxUs;
+        j.windowMaxUs = 0;
+        j.windowStartMs = nowMs;
+    }
+}
+
+static String ledRenderTaskBuildJson()
+{
+    const LedMainLoopJitter &j = sLedMainLoopJitter;
+    String json = "{\"available\":";
+    json += (AP_ENABLE_LED_RENDER_TASK ? "true" : "false");
+    json += ",\"active\":" + String(sLedRenderTaskActive ? "true" : "false");
+    json += ",\"passes\":" + String(sLedRenderStats.passes);
+    json += ",\"pass_us_last\":" + String(sLedRenderStats.passUsLast);
+    json += ",\"pass_us_max\":" + String(sLedRenderStats.passUsMax);
+    json += ",\"commits\":" + String(sLedRenderStats.commits);
+    json += ",\"busy_skips\":" + String(sLedRenderStats.busySkips);
+    json += ",\"overwritten\":" + String(sLedRenderStats.overwritten);
+    json += ",\"main_loop\":{";
+    json += "\"avg_us\":" + String(j.avgUs);
+    json += ",\"max_us\":" + String(j.maxUs);
+    json += ",\"window_max_us\":" + String(j.lastWindowMaxUs);
+    json += ",\"slow_count\":" + String(j.slowCount);
+    json += ",\"slow_threshold_us\":" + String(LED_RENDER_JITTER_SLOW_US);
+    json += ",\"samples\":" + String(j.samples);
+    json += "}}";
+    return json;
+}
@@ -0,0 +1,167 @@
+#pragma once
+// LogicSpriteFormat.h — .lsa indexed-colour RLE sprite format.
+//
+// Parsing, validation and frame decoding for the sprites LogicSpriteStore.h
+// keeps on SPIFFS. Everything works on a byte buffer holding the whole file,
+// so the store can validate an upload or a cached copy without touching
+// flash per frame.
+//
+// File layout (little-endian):
+//   header   16 bytes  "APSA", version, width, height, palette count,
+//                      frame count (u16), flags, reserved, default delay ms
+//                      (u16), reserved (u16)
+//   palette  palette count x RGB
+//   frames   frame count x { offset u32, length u16, delay ms u16 }
+//   data     per frame: (run - 1, palette index) byte pairs covering
+//            width x height pixels row-major
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#define LOGIC_SPRITE_MAGIC "APSA"
+#define LOGIC_SPRITE_VERSION 1
+#define LOGIC_SPRITE_HEADER_BYTES 16
+#define LOGIC_SPRITE_FRAME_ENTRY_BYTES 8
+#define LOGIC_SPRITE_MAX_BYTES 16384
+#define LOGIC_SPRITE_MAX_PIXELS 256
+#define LOGIC_SPRITE_MAX_PALETTE 16
+#define LOGIC_SPRITE_MAX_FRAMES 255
+#define LOGIC_SPRITE_MAX_NAME 24
+#define LOGIC_SPRITE_MIN_DELAY_MS 20
+#define LOGIC_SPRITE_ERR_LEN 48
+
+#define LOGIC_SPRITE_FLAG_LOOP 0x01
+
+struct LogicSpriteHeader
+{
+    uint8_t width;
+    uint8_t height;
+    uint8_t paletteCount;
+    uint8_t flags;
+    uint16_t frameCount;
+    uint16_t defaultDelayMs;
+    uint8_t palette[LOGIC_SPRITE_MAX_PALETTE][3];
+};
+
+static inline uint16_t logicSpriteU16(const uint8_t *p)
+{
+    return uint16_t(p[0] | (p[1] << 8));
+}
+
+static inline uint32_t logicSpriteU32(const uint8_t *p)
+{
+    return uint32_t(p[0]) | (uint32_t(p[1]) << 8) | (uint32_t(p[2]) << 16) | (uint32_t(p[3]) << 24);
+}
+
+static bool logicSpriteValidName(const char *name)
+{
+    if (name == nullptr || name[0] == '\0') return false;
+    size_t len = 0;
+    for (const char *p = name; *p != '\0'; ++p, ++len)
+    {
+        char c = *p;
+        bool ok = (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ||
+                  (c >= '0' && c <= '9') || c == '_' || c == '-';
+        if (!ok || len >= LOGIC_SPRITE_MAX_NAME) return false;
+    }
+    return true;
+}
+
+static bool logicSpriteFail(char *err, size_t errLen, const char *msg)
+{
+    if (err != nullptr && errLen > 0) snprintf(err, errLen, "%s", msg);
+    return false;
+}
+
+// Parses the fixed header. The palette is copied too when `len` covers it.
+static bool logicSpriteParseHeader(const uint8_t *data, size_t len, LogicSpriteHeader &out,
+                                   char *err, size_t errLen)
+{
+    if (len < LOGIC_SPRITE_HEADER_BYTES) return logicSpriteFail(err, errLen, "sprite too short");
+    if (memcmp(data, LOGIC_SPRITE_MAGIC, 4) != 0) return logicSpriteFail(err, errLen, "bad sprite magic");
+    if (data[4] != LOGIC_SPRITE_VERSION) return logicSpriteFail(err, errLen, "unsupported sprite version");
+    out.width = data[5];
+    out.height = data[6];
+    out.paletteCount = data[7];
+    out.frameCount = logicSpriteU16(data + 8);
+    out.flags = data[10];
+    out.defaultDelayMs = logicSpriteU16(data + 12);
+    if (out.width == 0 || out.height == 0 || out.width * out.height > LOGIC_SPRITE_MAX_PIXELS)
+        return logicSpriteFail(err, errLen, "sprite geometry out of range");
+    if (out.paletteCount == 0 || out.paletteCount > LOGIC_SPRITE_MAX_PALETTE)
+        return logicSpriteFail(err, errLen, "sprite palette out of range");
+    if (out.frameCount == 0 || out.frameCount > LOGIC_SPRITE_MAX_FRAMES)
+        return logicSpriteFail(err, errLen, "sprite frame count out of range");
+    size_t paletteBytes = size_t(out.paletteCount) * 3;
+    if (len >= LOGIC_SPRITE_HEADER_BYTES + paletteBytes)
+        memcpy(out.palette, data + LOGIC_SPRITE_HEADER_BYTES, paletteBytes);
+    return true;
+}
+
+// Decodes one RLE frame into palette indices. Rejects runs that overflow the
+// frame, indices past the palette, and frames that do not cover every pixel.
+static bool logicSpriteDecodeFrame(const uint8_t *rle, size_t rleLen, uint8_t paletteCount,
+                                   uint8_t *pixels, size_t pixelCount)
+{
+    if ((rleLen & 1) != 0) return false;
+    size_t out = 0;
+    for (size_t i = 0; i < rleLen; i += 2)
+    {
+        size_t run = size_t(rle[i]) + 1;
+        uint8_t index = rle[i + 1];
+        if (index >= paletteCount || out + run > pixelCount) return false;
+        memset(pixels + out, index, run);
+        out += run;
+    }
+    return out == pixelCount;
+}
+
+// Decodes `frame` of a whole-file buffer. delayMs receives the frame's
+// display time (falling back to the sprite default, floored at
+// LOGIC_SPRITE_MIN_DELAY_MS).
+static bool logicSpriteFrameAt(const uint8_t *data, size_t len, const LogicSpriteHeader &header,
+                               uint16_t frame, uint8_t *pixels, uint16_t &delayMs)
+{
+    if (frame >= header.frameCount) return false;
+    size_t tableOffset = LOGIC_SPRITE_HEADER_BYTES + size_t(header.paletteCount) * 3;
+    size_t dataOffset = tableOffset + size_t(header.frameCount) * LOGIC_SPRITE_FRAME_ENTRY_BYTES;
+    if (dataOffset > len) return false;
+    const uint8_t *entry = data + tableOffset + size_t(frame) * LOGIC_SPRITE_FRAME_ENTRY_BYTES;
+    uint32_t offset = logicSpriteU32(entry);
+    uint16_t length = logicSpriteU16(entry + 4);
+    if (offset < dataOffset || offset > len || length > len - offset) return false;
+    if (!logicSpriteDecodeFrame(data + offset, length, header.paletteCount, pixels,
+                                size_t(header.width) * header.height))
+        return false;
+    uint16_t frameDelay = logicSpriteU16(entry + 6);
+    delayMs = frameDelay ? frameDelay : header.defaultDelayMs;
+    if (delayMs < LOGIC_SPRITE_MIN_DELAY_MS) delayMs = LOGIC_SPRITE_MIN_DELAY_MS;
+    return true;
+}
+
+// Full structural check used on upload and when a sprite is cached: header,
+// palette and frame table in bounds, and every frame decodes to exactly
+// width x height pixels.
+static bool logicSpriteValidate(const uint8_t *data, size_t len, LogicSpriteHeader &header,
+                                char *err, size_t errLen)
+{
+    if (len > LOGIC_SPRITE_MAX_BYTES) return logicSpriteFail(err, errLen, "sprite too large");
+    if (!logicSpriteParseHeader(data, len, header, err, errLen)) return false;
+    size_t tableOffset = LOGIC_SPRITE_HEADER_BYTES + size_t(header.paletteCount) * 3;
+    size_t dataOffset = tableOffset + size_t(header.frameCount) * LOGIC_SPRITE_FRAME_ENTRY_BYTES;
+    if (dataOffset > len) return logicSpriteFail(err, errLen, "sprite frame table truncated");
+
+    uint8_t pixels[LOGIC_SPRITE_MAX_PIXELS];
+    for (uint16_t f = 0; f < header.frameCount; f++)
+    {
+        uint16_t delayMs;
+        if (!logicSpriteFrameAt(data, len, header, f, pixels, delayMs))
+        {
+            if (err != nullptr && errLen > 0) snprintf(err, errLen, "sprite frame %u does not decode", f);
+            return false;
+        }
+    }
+    return true;
+}
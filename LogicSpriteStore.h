@@ -0,0 +1,302 @@
+#pragma once
+// LogicSpriteStore.h — indexed-colour RLE animations for logic/PSI displays.
+//
+// Sprites live on SPIFFS as /sprites/<name>.lsa (format in
+// LogicSpriteFormat.h) and are uploaded through /api/sprites (or built offline
+// with tools/make_logic_sprite.py). Playing a sprite reads and validates the
+// whole file once into a small RAM cache; each frame step then RLE-decodes
+// from that copy, so playback never touches flash after the first frame.
+//
+// The effect runs on the render task while uploads and deletes arrive on
+// async_tcp, so the cache is guarded by sLogicSpriteMux. Frames are decoded and
+// the header copied out under the lock (at most 256 bytes of memset); file
+// reads and free() happen outside it.
+
+#include <Arduino.h>
+#include "FS.h"
+#include "SPIFFS.h"
+
+#include "LogicSpriteFormat.h"
+
+#define LOGIC_SPRITE_DIR "/sprites"
+#define LOGIC_SPRITE_EXT ".lsa"
+#define LOGIC_SPRITE_CACHE_SLOTS 2
+#define LOGIC_SPRITE_MAX_BINDINGS 4
+
+struct LogicSpriteCacheSlot
+{
+    char name[LOGIC_SPRITE_MAX_NAME + 1];
+    LogicSpriteHeader header;
+    uint8_t *data;      // whole validated file
+    size_t len;
+    uint32_t lastUseMs;
+    bool valid;
+};
+
+// Request-scoped upload buffer for POST /api/sprites. Oversized bodies keep a
+// header-only buffer (capacity 0) so the handler can answer 413.
+struct LogicSpriteUpload
+{
+    size_t len;
+    size_t total;
+    size_t capacity;
+    uint8_t data[];
+};
+
+static LogicSpriteCacheSlot sLogicSpriteCache[LOGIC_SPRITE_CACHE_SLOTS];
+static portMUX_TYPE sLogicSpriteMux = portMUX_INITIALIZER_UNLOCKED;
+static uint32_t sLogicSpriteCacheHits = 0;
+static uint32_t sLogicSpriteCacheMisses = 0;
+static uint32_t sLogicSpriteFramesDecoded = 0;
+static uint32_t sLogicSpriteDecodeErrors = 0;
+
+static String logicSpritePath(const char *name)
+{
+    return String(LOGIC_SPRITE_DIR) + "/" + name + LOGIC_SPRITE_EXT;
+}
+
+static void logicSpriteInvalidate(const char *name)
+{
+    uint8_t *drop[LOGIC_SPRITE_CACHE_SLOTS] = {};
+    portENTER_CRITICAL(&sLogicSpriteMux);
+    for (uint8_t i = 0; i < LOGIC_SPRITE_CACHE_SLOTS; i++)
+    {
+        LogicSpriteCacheSlot &slot = sLogicSpriteCache[i];
+        if (slot.valid && (name == nullptr || strcmp(slot.name, name) == 0))
+        {
+            drop[i] = slot.data;
+            slot.data = nullptr;
+            slot.len = 0;
+            slot.valid = false;
+        }
+    }
+    portEXIT_CRITICAL(&sLogicSpriteMux);
+    for (uint8_t i = 0; i < LOGIC_SPRITE_CACHE_SLOTS; i++) free(drop[i]);
+}
+
+// Cache lookup under the lock; copies the header out and, with `pixels`,
+// decodes `frame` from the cached file. Returns -1 on a miss.
+static int logicSpriteCachedFrame(const char *name, LogicSpriteHeader &header, uint16_t frame,
+                                  uint8_t *pixels, uint16_t &delayMs)
+{
+    int result = -1;
+    portENTER_CRITICAL(&sLogicSpriteMux);
+    for (uint8_t i = 0; i < LOGIC_SPRITE_CACHE_SLOTS; i++)
+    {
+        LogicSpriteCacheSlot &slot = sLogicSpriteCache[i];
+        if (!slot.valid || strcmp(slot.name, name) != 0) continue;
+        slot.lastUseMs = millis();
+        sLogicSpriteCacheHits++;
+        header = slot.header;
+        result = 1;
+        if (pixels != nullptr)
+        {
+            result = logicSpriteFrameAt(slot.data, slot.len, slot.header, frame, pixels, delayMs) ? 1 : 0;
+            if (result) sLogicSpriteFramesDecoded++;
+            else sLogicSpriteDecodeErrors++;
+        }
+        break;
+    }
+    portEXIT_CRITICAL(&sLogicSpriteMux);
+    return result;
+}
+
+// Reads and validates the sprite file and installs it in the least recently
+// used slot.
+static bool logicSpriteCacheLoad(const char *name)
+{
+    portENTER_CRITICAL(&sLogicSpriteMux);
+    sLogicSpriteCacheMisses++;
+    portEXIT_CRITICAL(&sLogicSpriteMux);
+
+    File file = SPIFFS.open(logicSpritePath(name), "r");
+    if (!file) return false;
+    size_t len = file.size();
+    uint8_t *data = (len > 0 && len <= LOGIC_SPRITE_MAX_BYTES) ? (uint8_t *)malloc(len) : nullptr;
+    bool ok = data != nullptr && file.read(data, len) == len;
+    file.close();
+    LogicSpriteHeader header;
+    char err[LOGIC_SPRITE_ERR_LEN] = "sprite unreadable";
+    ok = ok && logicSpriteValidate(data, len, header, err, sizeof(err));
+    if (!ok)
+    {
+        free(data);
+        logCapture.printf("[SPRITE] %s rejected: %s\n", name, err);
+        return false;
+    }
+
+    uint8_t *drop;
+    portENTER_CRITICAL(&sLogicSpriteMux);
+    uint8_t victim = 0;
+    for (uint8_t i = 0; i < LOGIC_SPRITE_CACHE_SLOTS; i++)
+    {
+        LogicSpriteCacheSlot &slot = sLogicSpriteCache[i];
+        if (slot.valid && strcmp(slot.name, name) == 0)
+        {
+            // Another task cached it meanwhile; replace that copy.
+            victim = i;
+            break;
+        }
+        if (!slot.valid || (sLogicSpriteCache[victim].valid && slot.lastUseMs < sLogicSpriteCache[victim].lastUseMs))
+            victim = i;
+    }
+    LogicSpriteCacheSlot &slot = sLogicSpriteCache[victim];
+    drop = slot.data;
+    strlcpy(slot.name, name, sizeof(slot.name));
+    slot.header = header;
+    slot.data = data;
+    slot.len = len;
+    slot.lastUseMs = millis();
+    slot.valid = true;
+    portEXIT_CRITICAL(&sLogicSpriteMux);
+    free(drop);
+    return true;
+}
+
+// Copies the sprite's header and palette, loading it into the cache on a miss.
+static bool logicSpriteLoadHeader(const char *name, LogicSpriteHeader &header)
+{
+    if (!logicSpriteValidName(name)) return false;
+    uint16_t delayMs;
+    if (logicSpriteCachedFrame(name, header, 0, nullptr, delayMs) > 0) return true;
+    return logicSpriteCacheLoad(name) && logicSpriteCachedFrame(name, header, 0, nullptr, delayMs) > 0;
+}
+
+// Decodes one frame from the cached copy (loading it on a miss). `header`
+// receives the header the pixels belong to, so a sprite replaced mid-play is
+// never drawn with the old palette or geometry.
+static bool logicSpriteReadFrame(const char *name, uint16_t frame, LogicSpriteHeader &header,
+                                 uint8_t *pixels, uint16_t &delayMs)
+{
+    if (!logicSpriteValidName(name)) return false;
+    int result = logicSpriteCachedFrame(name, header, frame, pixels, delayMs);
+    if (result < 0 && logicSpriteCacheLoad(name))
+        result = logicSpriteCachedFrame(name, header, frame, pixels, delayMs);
+    return result > 0;
+}
+
+static bool logicSpriteWrite(const char *name, const uint8_t *data, size_t len, String &errMsg)
+{
+    if (!logicSpriteValidName(name)) { errMsg = "invalid sprite name"; return false; }
+    LogicSpriteHeader header;
+    char err[LOGIC_SPRITE_ERR_LEN];
+    if (!logicSpriteValidate(data, len, header, err, sizeof(err)))
+    {
+        errMsg = err;
+        return false;
+    }
+
+    if (!SPIFFS.exists(LOGIC_SPRITE_DIR)) SPIFFS.mkdir(LOGIC_SPRITE_DIR);
+    String path = logicSpritePath(name);
+    String tmpPath = String(LOGIC_SPRITE_DIR) + "/" + name + ".tmp";
+    File file = SPIFFS.open(tmpPath, "w");
+    if (!file) { errMsg = "sprite open failed"; return false; }
+    size_t written = file.write(data, len);
+    file.close();
+    if (written != len)
+    {
+        SPIFFS.remove(tmpPath);
+        errMsg = "sprite write failed";
+        return false;
+    }
+    SPIFFS.remove(path);
+    if (!SPIFFS.rename(tmpPath, path))
+    {
+        SPIFFS.remove(tmpPath);
+        errMsg = "sprite rename failed";
+        return false;
+    }
+    logicSpriteInvalidate(name);
+    return true;
+}
+
+static bool logicSpriteRemove(const char *name)
+{
+    if (!logicSpriteValidName(name)) return false;
+    logicSpriteInvalidate(name);
+    return SPIFFS.remove(logicSpritePath(name));
+}
+
+static String logicSpriteListJson()
+{
+    String json = "{\"sprites\":[";
+    bool first = true;
+    File dir = SPIFFS.open(LOGIC_SPRITE_DIR);
+    if (dir && dir.isDirectory())
+    {
+        for (File f = dir.openNextFile(); f; f = dir.openNextFile())
+        {
+            String fname = f.name();
+            int slash = fname.lastIndexOf('/');
+            if (slash >= 0) fname = fname.substring(slash + 1);
+            if (!fname.endsWith(LOGIC_SPRITE_EXT)) continue;
+            uint8_t head[LOGIC_SPRITE_HEADER_BYTES];
+            LogicSpriteHeader header;
+            size_t got = f.read(head, sizeof(head));
+            if (!first) json += ",";
+            first = false;
+            json += "{\"name\":\"" + fname.substring(0, fname.length() - strlen(LOGIC_SPRITE_EXT)) + "\"";
+            json += ",\"bytes\":" + String((uint32_t)f.size());
+            if (logicSpriteParseHeader(head, got, header, nullptr, 0))
+            {
+                json += ",\"width\":" + String(header.width);
+                json += ",\"height\":" + String(header.height);
+                json += ",\"frames\":" + String(header.frameCount);
+                json += ",\"loop\":" + String((header.flags & LOGIC_SPRITE_FLAG_LOOP) ? "true" : "false");
+            }
+            json += "}";
+        }
+    }
+    portENTER_CRITICAL(&sLogicSpriteMux);
+    uint32_t hits = sLogicSpriteCacheHits;
+    uint32_t misses = sLogicSpriteCacheMisses;
+    uint32_t decoded = sLogicSpriteFramesDecoded;
+    uint32_t errors = sLogicSpriteDecodeErrors;
+    portEXIT_CRITICAL(&sLogicSpriteMux);
+    json += "],\"cache\":{\"hits\":" + String(hits);
+    json += ",\"misses\":" + String(misses);
+    json += ",\"frames_decoded\":" + String(decoded);
+    json += ",\"decode_errors\":" + String(errors);
+    json += "}}";
+    return json;
+}
+
+// Which sprite each renderer should play when it enters the sprite effect.
+// Keyed by renderer address so this header stays independent of ReelTwo types.
+struct LogicSpriteBinding
+{
+    const void *renderer;
+    char name[LOGIC_SPRITE_MAX_NAME + 1];
+};
+
+static LogicSpriteBinding sLogicSpriteBindings[LOGIC_SPRITE_MAX_BINDINGS];
+
+static void logicSpriteBind(const void *renderer, const char *name)
+{
+    LogicSpriteBinding *freeSlot = nullptr;
+    for (uint8_t i = 0; i < LOGIC_SPRITE_MAX_BINDINGS; i++)
+    {
+        if (sLogicSpriteBindings[i].renderer == renderer)
+        {
+            strlcpy(sLogicSpriteBindings[i].name, name, sizeof(sLogicSpriteBindings[i].name));
+            return;
+        }
+        if (freeSlot == nullptr && sLogicSpriteBindings[i].renderer == nullptr)
+            freeSlot = &sLogicSpriteBindings[i];
+    }
+    if (freeSlot != nullptr)
+    {
+        freeSlot->renderer = renderer;
+        strlcpy(freeSlot->name, name, sizeof(freeSlot->name));
+    }
+}
+
+static const char *logicSpriteBindingFor(const void *renderer)
+{
+    for (uint8_t i = 0; i < LOGIC_SPRITE_MAX_BINDINGS; i++)
+    {
+        if (sLogicSpriteBindings[i].renderer == renderer)
+            return sLogicSpriteBindings[i].name;
+    }
+    return nullptr;
+}
@@ -0,0 +1,417 @@
+#pragma once
+// LogicTextStrip.h — pre-rasterised glyph strips for scrolling logic text.
+//
+// A message is rasterised once, when it is set, into a strip of column
+// bitmasks (bit 0 = top row) using a proportional Latin font: 5 rows, or 4
+// rows (capitals only) on displays shorter than that, such as the 27x4 RLD.
+// The LOGICTEXTSTRIP effect then scrolls by blitting a display-wide window of
+// that strip, so each frame step costs width x height pixel writes and no
+// glyph lookups, and frames between steps are left untouched.
+//
+// Only DT: text and the firmware's own messages (boot droid name, sleep/wake,
+// OTA failure) use the strip; Marcduino @1M/@3M text and Aurabesh stay on the
+// ReelTwo renderer.
+//
+// Each bound renderer owns one strip buffer sized for LOGIC_TEXT_MAX_CHARS,
+// allocated on first use and reused for every later message so rebinding while
+// a render pass is running can at worst tear one frame, never free memory that
+// is being read.
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define LOGIC_TEXT_GLYPH_ROWS 5
+#define LOGIC_TEXT_SHORT_GLYPH_ROWS 4
+#define LOGIC_TEXT_GLYPH_MAX_WIDTH 5
+#define LOGIC_TEXT_GLYPH_GAP 1
+#define LOGIC_TEXT_MAX_CHARS 96
+#define LOGIC_TEXT_MAX_ENCODED 128
+#define LOGIC_TEXT_MAX_COMMAND 159
+#define LOGIC_TEXT_MAX_LINES 2
+#define LOGIC_TEXT_MAX_COLUMNS (LOGIC_TEXT_MAX_CHARS * (LOGIC_TEXT_GLYPH_MAX_WIDTH + LOGIC_TEXT_GLYPH_GAP))
+#define LOGIC_TEXT_MAX_BINDINGS 2
+#define LOGIC_TEXT_DEFAULT_STEP_MS 40
+#define LOGIC_TEXT_STATUS_STEP_UNIT_MS 12
+
+struct LogicTextGlyph
+{
+    uint8_t width;
+    uint8_t columns[LOGIC_TEXT_GLYPH_MAX_WIDTH];
+};
+
+// Printable ASCII 0x20-0x7E. Anything else renders as '?'.
+static const LogicTextGlyph kLogicTextFont5[95] = {
+    { 2, { 0x00, 0x00, 0x00, 0x00, 0x00 } }, // space
+    { 1, { 0x17, 0x00, 0x00, 0x00, 0x00 } }, // !
+    { 3, { 0x03, 0x00, 0x03, 0x00, 0x00 } }, // "
+    { 5, { 0x0A, 0x1F, 0x0A, 0x1F, 0x0A } }, // #
+    { 4, { 0x12, 0x1D, 0x17, 0x09, 0x00 } }, // $
+    { 4, { 0x11, 0x08, 0x04, 0x13, 0x00 } }, // %
+    { 4, { 0x0A, 0x15, 0x0A, 0x10, 0x00 } }, // &
+    { 1, { 0x03, 0x00, 0x00, 0x00, 0x00 } }, // '
+    { 2, { 0x0E, 0x11, 0x00, 0x00, 0x00 } }, // (
+    { 2, { 0x11, 0x0E, 0x00, 0x00, 0x00 } }, // )
+    { 3, { 0x05, 0x02, 0x05, 0x00, 0x00 } }, // *
+    { 3, { 0x04, 0x0E, 0x04, 0x00, 0x00 } }, // +
+    { 2, { 0x10, 0x08, 0x00, 0x00, 0x00 } }, // ,
+    { 3, { 0x04, 0x04, 0x04, 0x00, 0x00 } }, // -
+    { 1, { 0x10, 0x00, 0x00, 0x00, 0x00 } }, // .
+    { 4, { 0x08, 0x04, 0x02, 0x01, 0x00 } }, // /
+    { 4, { 0x0E, 0x11, 0x11, 0x0E, 0x00 } }, // 0
+    { 3, { 0x12, 0x1F, 0x10, 0x00, 0x00 } }, // 1
+    { 4, { 0x19, 0x15, 0x15, 0x12, 0x00 } }, // 2
+    { 4, { 0x11, 0x15, 0x15, 0x0A, 0x00 } }, // 3
+    { 4, { 0x07, 0x04, 0x04, 0x1F, 0x00 } }, // 4
+    { 4, { 0x17, 0x15, 0x15, 0x09, 0x00 } }, // 5
+    { 4, { 0x0E, 0x15, 0x15, 0x08, 0x00 } }, // 6
+    { 4, { 0x01, 0x19, 0x05, 0x03, 0x00 } }, // 7
+    { 4, { 0x0A, 0x15, 0x15, 0x0A, 0x00 } }, // 8
+    { 4, { 0x02, 0x15, 0x15, 0x0E, 0x00 } }, // 9
+    { 1, { 0x0A, 0x00, 0x00, 0x00, 0x00 } }, // :
+    { 2, { 0x10, 0x0A, 0x00, 0x00, 0x00 } }, // ;
+    { 3, { 0x04, 0x0A, 0x11, 0x00, 0x00 } }, // <
+    { 3, { 0x0A, 0x0A, 0x0A, 0x00, 0x00 } }, // =
+    { 3, { 0x11, 0x0A, 0x04, 0x00, 0x00 } }, // >
+    { 4, { 0x01, 0x15, 0x05, 0x02, 0x00 } }, // ?
+    { 5, { 0x0E, 0x11, 0x15, 0x0B, 0x0E } }, // @
+    { 4, { 0x1E, 0x05, 0x05, 0x1E, 0x00 } }, // A
+    { 4, { 0x1F, 0x15, 0x15, 0x0A, 0x00 } }, // B
+    { 4, { 0x0E, 0x11, 0x11, 0x11, 0x00 } }, // C
+    { 4, { 0x1F, 0x11, 0x11, 0x0E, 0x00 } }, // D
+    { 4, { 0x1F, 0x15, 0x15, 0x11, 0x00 } }, // E
+    { 4, { 0x1F, 0x05, 0x05, 0x01, 0x00 } }, // F
+    { 4, { 0x0E, 0x11, 0x15, 0x1D, 0x00 } }, // G
+    { 4, { 0x1F, 0x04, 0x04, 0x1F, 0x00 } }, // H
+    { 3, { 0x11, 0x1F, 0x11, 0x00, 0x00 } }, // I
+    { 4, { 0x08, 0x10, 0x10, 0x0F, 0x00 } }, // J
+    { 4, { 0x1F, 0x04, 0x0A, 0x11, 0x00 } }, // K
+    { 4, { 0x1F, 0x10, 0x10, 0x10, 0x00 } }, // L
+    { 5, { 0x1F, 0x02, 0x04, 0x02, 0x1F } }, // M
+    { 4, { 0x1F, 0x02, 0x04, 0x1F, 0x00 } }, // N
+    { 4, { 0x0E, 0x11, 0x11, 0x0E, 0x00 } }, // O
+    { 4, { 0x1F, 0x05, 0x05, 0x02, 0x00 } }, // P
+    { 4, { 0x0E, 0x11, 0x09, 0x16, 0x00 } }, // Q
+    { 4, { 0x1F, 0x05, 0x0D, 0x12, 0x00 } }, // R
+    { 4, { 0x12, 0x15, 0x15, 0x09, 0x00 } }, // S
+    { 3, { 0x01, 0x1F, 0x01, 0x00, 0x00 } }, // T
+    { 4, { 0x0F, 0x10, 0x10, 0x0F, 0x00 } }, // U
+    { 5, { 0x07, 0x08, 0x10, 0x08, 0x07 } }, // V
+    { 5, { 0x1F, 0x08, 0x04, 0x08, 0x1F } }, // W
+    { 5, { 0x11, 0x0A, 0x04, 0x0A, 0x11 } }, // X
+    { 5, { 0x01, 0x02, 0x1C, 0x02, 0x01 } }, // Y
+    { 4, { 0x19, 0x15, 0x15, 0x13, 0x00 } }, // Z
+    { 2, { 0x1F, 0x11, 0x00, 0x00, 0x00 } }, // [
+    { 4, { 0x01, 0x02, 0x04, 0x08, 0x00 } }, // backslash
+    { 2, { 0x11, 0x1F, 0x00, 0x00, 0x00 } }, // ]
+    { 3, { 0x02, 0x01, 0x02, 0x00, 0x00 } }, // ^
+    { 4, { 0x10, 0x10, 0x10, 0x10, 0x00 } }, // _
+    { 2, { 0x01, 0x02, 0x00, 0x00, 0x00 } }, // `
+    { 4, { 0x0C, 0x12, 0x12, 0x1E, 0x00 } }, // a
+    { 4, { 0x1F, 0x12, 0x12, 0x0C, 0x00 } }, // b
+    { 3, { 0x0C, 0x12, 0x12, 0x00, 0x00 } }, // c
+    { 4, { 0x0C, 0x12, 0x12, 0x1F, 0x00 } }, // d
+    { 4, { 0x0C, 0x16, 0x16, 0x14, 0x00 } }, // e
+    { 3, { 0x04, 0x1E, 0x05, 0x00, 0x00 } }, // f
+    { 4, { 0x02, 0x15, 0x15, 0x0F, 0x00 } }, // g
+    { 4, { 0x1F, 0x02, 0x02, 0x1C, 0x00 } }, // h
+    { 1, { 0x1D, 0x00, 0x00, 0x00, 0x00 } }, // i
+    { 3, { 0x08, 0x10, 0x0D, 0x00, 0x00 } }, // j
+    { 3, { 0x1F, 0x04, 0x1A, 0x00, 0x00 } }, // k
+    { 2, { 0x0F, 0x10, 0x00, 0x00, 0x00 } }, // l
+    { 5, { 0x1E, 0x02, 0x1C, 0x02, 0x1C } }, // m
+    { 4, { 0x1E, 0x02, 0x02, 0x1C, 0x00 } }, // n
+    { 4, { 0x0C, 0x12, 0x12, 0x0C, 0x00 } }, // o
+    { 4, { 0x1F, 0x05, 0x05, 0x02, 0x00 } }, // p
+    { 4, { 0x02, 0x05, 0x05, 0x1F, 0x00 } }, // q
+    { 3, { 0x1E, 0x04, 0x02, 0x00, 0x00 } }, // r
+    { 4, { 0x10, 0x16, 0x1A, 0x02, 0x00 } }, // s
+    { 3, { 0x02, 0x0F, 0x12, 0x00, 0x00 } }, // t
+    { 4, { 0x0E, 0x10, 0x10, 0x1E, 0x00 } }, // u
+    { 3, { 0x0E, 0x10, 0x0E, 0x00, 0x00 } }, // v
+    { 5, { 0x0E, 0x10, 0x0C, 0x10, 0x0E } }, // w
+    { 3, { 0x12, 0x0C, 0x12, 0x00, 0x00 } }, // x
+    { 4, { 0x03, 0x14, 0x14, 0x0F, 0x00 } }, // y
+    { 4, { 0x12, 0x1A, 0x16, 0x12, 0x00 } }, // z
+    { 3, { 0x04, 0x0E, 0x11, 0x00, 0x00 } }, // {
+    { 1, { 0x1F, 0x00, 0x00, 0x00, 0x00 } }, // |
+    { 3, { 0x11, 0x0E, 0x04, 0x00, 0x00 } }, // }
+    { 4, { 0x04, 0x02, 0x04, 0x02, 0x00 } }, // ~
+};
+
+// 4-row capitals for short displays: 0x20-0x60 and 0x7B-0x7E. Lower case is
+// drawn as upper case.
+static const LogicTextGlyph kLogicTextFont4[69] = {
+    { 2, { 0x00, 0x00, 0x00, 0x00, 0x00 } }, // space
+    { 1, { 0x0B, 0x00, 0x00, 0x00, 0x00 } }, // !
+    { 3, { 0x03, 0x00, 0x03, 0x00, 0x00 } }, // "
+    { 4, { 0x0A, 0x0F, 0x0A, 0x0F, 0x00 } }, // #
+    { 3, { 0x0A, 0x0F, 0x05, 0x00, 0x00 } }, // $
+    { 3, { 0x0D, 0x00, 0x0B, 0x00, 0x00 } }, // %
+    { 3, { 0x0A, 0x05, 0x0A, 0x00, 0x00 } }, // &
+    { 1, { 0x03, 0x00, 0x00, 0x00, 0x00 } }, // '
+    { 2, { 0x06, 0x09, 0x00, 0x00, 0x00 } }, // (
+    { 2, { 0x09, 0x06, 0x00, 0x00, 0x00 } }, // )
+    { 3, { 0x05, 0x02, 0x05, 0x00, 0x00 } }, // *
+    { 3, { 0x02, 0x07, 0x02, 0x00, 0x00 } }, // +
+    { 2, { 0x08, 0x04, 0x00, 0x00, 0x00 } }, // ,
+    { 3, { 0x02, 0x02, 0x02, 0x00, 0x00 } }, // -
+    { 1, { 0x08, 0x00, 0x00, 0x00, 0x00 } }, // .
+    { 3, { 0x08, 0x06, 0x01, 0x00, 0x00 } }, // /
+    { 3, { 0x0F, 0x09, 0x0F, 0x00, 0x00 } }, // 0
+    { 3, { 0x0A, 0x0F, 0x08, 0x00, 0x00 } }, // 1
+    { 3, { 0x09, 0x0D, 0x0A, 0x00, 0x00 } }, // 2
+    { 3, { 0x09, 0x0B, 0x0F, 0x00, 0x00 } }, // 3
+    { 3, { 0x07, 0x04, 0x0F, 0x00, 0x00 } }, // 4
+    { 3, { 0x0B, 0x0B, 0x05, 0x00, 0x00 } }, // 5
+    { 3, { 0x0F, 0x0A, 0x0E, 0x00, 0x00 } }, // 6
+    { 3, { 0x01, 0x0D, 0x03, 0x00, 0x00 } }, // 7
+    { 3, { 0x0F, 0x0B, 0x0F, 0x00, 0x00 } }, // 8
+    { 3, { 0x07, 0x05, 0x0F, 0x00, 0x00 } }, // 9
+    { 1, { 0x0A, 0x00, 0x00, 0x00, 0x00 } }, // :
+    { 2, { 0x08, 0x02, 0x00, 0x00, 0x00 } }, // ;
+    { 2, { 0x02, 0x05, 0x00, 0x00, 0x00 } }, // <
+    { 3, { 0x0A, 0x0A, 0x0A, 0x00, 0x00 } }, // =
+    { 2, { 0x05, 0x02, 0x00, 0x00, 0x00 } }, // >
+    { 3, { 0x01, 0x0B, 0x03, 0x00, 0x00 } }, // ?
+    { 4, { 0x0F, 0x01, 0x07, 0x07, 0x00 } }, // @
+    { 3, { 0x0E, 0x05, 0x0E, 0x00, 0x00 } }, // A
+    { 3, { 0x0F, 0x0B, 0x0E, 0x00, 0x00 } }, // B
+    { 3, { 0x0F, 0x09, 0x09, 0x00, 0x00 } }, // C
+    { 3, { 0x0F, 0x09, 0x06, 0x00, 0x00 } }, // D
+    { 3, { 0x0F, 0x0B, 0x09, 0x00, 0x00 } }, // E
+    { 3, { 0x0F, 0x05, 0x01, 0x00, 0x00 } }, // F
+    { 3, { 0x0F, 0x09, 0x0D, 0x00, 0x00 } }, // G
+    { 3, { 0x0F, 0x02, 0x0F, 0x00, 0x00 } }, // H
+    { 3, { 0x09, 0x0F, 0x09, 0x00, 0x00 } }, // I
+    { 3, { 0x0C, 0x08, 0x0F, 0x00, 0x00 } }, // J
+    { 3, { 0x0F, 0x02, 0x0D, 0x00, 0x00 } }, // K
+    { 3, { 0x0F, 0x08, 0x08, 0x00, 0x00 } }, // L
+    { 5, { 0x0F, 0x02, 0x04, 0x02, 0x0F } }, // M
+    { 4, { 0x0F, 0x02, 0x04, 0x0F, 0x00 } }, // N
+    { 3, { 0x0F, 0x09, 0x0F, 0x00, 0x00 } }, // O
+    { 3, { 0x0F, 0x05, 0x07, 0x00, 0x00 } }, // P
+    { 4, { 0x07, 0x05, 0x0F, 0x08, 0x00 } }, // Q
+    { 3, { 0x0F, 0x05, 0x0B, 0x00, 0x00 } }, // R
+    { 3, { 0x0A, 0x09, 0x05, 0x00, 0x00 } }, // S
+    { 3, { 0x01, 0x0F, 0x01, 0x00, 0x00 } }, // T
+    { 3, { 0x0F, 0x08, 0x0F, 0x00, 0x00 } }, // U
+    { 3, { 0x07, 0x08, 0x07, 0x00, 0x00 } }, // V
+    { 5, { 0x07, 0x08, 0x06, 0x08, 0x07 } }, // W
+    { 3, { 0x09, 0x06, 0x09, 0x00, 0x00 } }, // X
+    { 3, { 0x03, 0x0C, 0x03, 0x00, 0x00 } }, // Y
+    { 3, { 0x0D, 0x09, 0x0B, 0x00, 0x00 } }, // Z
+    { 2, { 0x0F, 0x09, 0x00, 0x00, 0x00 } }, // [
+    { 3, { 0x01, 0x06, 0x08, 0x00, 0x00 } }, // backslash
+    { 2, { 0x09, 0x0F, 0x00, 0x00, 0x00 } }, // ]
+    { 3, { 0x02, 0x01, 0x02, 0x00, 0x00 } }, // ^
+    { 3, { 0x08, 0x08, 0x08, 0x00, 0x00 } }, // _
+    { 2, { 0x01, 0x02, 0x00, 0x00, 0x00 } }, // `
+    { 2, { 0x02, 0x0F, 0x00, 0x00, 0x00 } }, // {
+    { 1, { 0x0F, 0x00, 0x00, 0x00, 0x00 } }, // |
+    { 2, { 0x0F, 0x02, 0x00, 0x00, 0x00 } }, // }
+    { 4, { 0x04, 0x02, 0x04, 0x02, 0x00 } }, // ~
+};
+
+struct LogicTextStrip
+{
+    uint8_t lineCount;
+    uint8_t glyphRows;                 // 5, or 4 on short displays
+    uint16_t columnCount;              // widest line; shorter lines are zero-padded
+    uint16_t lineColumns[LOGIC_TEXT_MAX_LINES];
+    uint8_t rgb[3];
+    uint16_t stepMs;                   // one column per step
+    uint8_t *columns;                  // lineCount x columnCount, line-major
+};
+
+struct LogicTextStripStats
+{
+    uint32_t builds;
+    uint32_t buildFailures;
+    uint32_t truncated;
+    uint32_t blits;
+    uint32_t lastBuildUs;
+    uint16_t lastColumns;
+};
+
+struct LogicTextBinding
+{
+    const void *renderer;
+    LogicTextStrip strip;
+};
+
+static LogicTextBinding sLogicTextBindings[LOGIC_TEXT_MAX_BINDINGS];
+static LogicTextStripStats sLogicTextStripStats;
+
+static inline const LogicTextGlyph &logicTextGlyph(char c, uint8_t rows = LOGIC_TEXT_GLYPH_ROWS)
+{
+    unsigned char u = (unsigned char)c;
+    if (u < 0x20 || u > 0x7E) u = '?';
+    if (rows >= LOGIC_TEXT_GLYPH_ROWS) return kLogicTextFont5[u - 0x20];
+    if (u >= 'a' && u <= 'z') u -= 'a' - 'A';
+    return kLogicTextFont4[u > 'z' ? u - 0x20 - 26 : u - 0x20];
+}
+
+// Glyph height for a display (or line band) of `height` rows.
+static inline uint8_t logicTextGlyphRowsFor(unsigned height)
+{
+    return height < LOGIC_TEXT_GLYPH_ROWS ? LOGIC_TEXT_SHORT_GLYPH_ROWS : LOGIC_TEXT_GLYPH_ROWS;
+}
+
+// Columns needed for one line of text, including the gap between glyphs.
+static uint16_t logicTextMeasure(const char *text, size_t len, uint8_t rows = LOGIC_TEXT_GLYPH_ROWS)
+{
+    uint16_t cols = 0;
+    for (size_t i = 0; i < len; i++)
+        cols += logicTextGlyph(text[i], rows).width + (i + 1 < len ? LOGIC_TEXT_GLYPH_GAP : 0);
+    return cols;
+}
+
+static void logicTextRasterise(const char *text, size_t len, uint8_t rows, uint8_t *out)
+{
+    for (size_t i = 0; i < len; i++)
+    {
+        const LogicTextGlyph &g = logicTextGlyph(text[i], rows);
+        memcpy(out, g.columns, g.width);
+        out += g.width + LOGIC_TEXT_GLYPH_GAP;
+    }
+}
+
+// Rasterises text into strip for a display `displayHeight` rows tall. One '\n'
+// splits the message into two lines on displays tall enough for two 5-row
+// lines; otherwise it is drawn as a space. Text past LOGIC_TEXT_MAX_CHARS is
+// dropped and counted.
+static bool logicTextStripBuild(LogicTextStrip &strip, const char *text, unsigned displayHeight)
+{
+    bool multiLine = displayHeight >= LOGIC_TEXT_MAX_LINES * LOGIC_TEXT_GLYPH_ROWS;
+    if (strip.columns == nullptr)
+    {
+        strip.columns = (uint8_t *)malloc(LOGIC_TEXT_MAX_LINES * LOGIC_TEXT_MAX_COLUMNS);
+        if (strip.columns == nullptr)
+        {
+            sLogicTextStripStats.buildFailures++;
+            return false;
+        }
+    }
+    char buf[LOGIC_TEXT_MAX_CHARS + 1];
+    size_t len = strlen(text != nullptr ? text : "");
+    if (len > LOGIC_TEXT_MAX_CHARS)
+    {
+        sLogicTextStripStats.truncated++;
+        len = LOGIC_TEXT_MAX_CHARS;
+    }
+    memcpy(buf, text != nullptr ? text : "", len);
+    buf[len] = '\0';
+
+    const char *lines[LOGIC_TEXT_MAX_LINES] = { buf, nullptr };
+    size_t lineLen[LOGIC_TEXT_MAX_LINES] = { len, 0 };
+    strip.lineCount = 1;
+    char *nl = strchr(buf, '\n');
+    if (nl != nullptr && multiLine)
+    {
+        lines[1] = nl + 1;
+        lineLen[0] = size_t(nl - buf);
+        lineLen[1] = len - lineLen[0] - 1;
+        strip.lineCount = 2;
+    }
+    else if (nl != nullptr)
+    {
+        *nl = ' ';
+    }
+
+    strip.glyphRows = logicTextGlyphRowsFor(displayHeight / strip.lineCount);
+    strip.columnCount = 0;
+    for (uint8_t l = 0; l < strip.lineCount; l++)
+    {
+        strip.lineColumns[l] = logicTextMeasure(lines[l], lineLen[l], strip.glyphRows);
+        if (strip.lineColumns[l] > strip.columnCount)
+            strip.columnCount = strip.lineColumns[l];
+    }
+    memset(strip.columns, 0, size_t(strip.lineCount) * strip.columnCount);
+    for (uint8_t l = 0; l < strip.lineCount; l++)
+        logicTextRasterise(lines[l], lineLen[l], strip.glyphRows, strip.columns + size_t(l) * strip.columnCount);
+
+    sLogicTextStripStats.builds++;
+    sLogicTextStripStats.lastColumns = strip.columnCount;
+    return true;
+}
+
+// Milliseconds per one-column scroll step for the DT: speed field. Speed 0 is
+// the default; 1 is the fastest and 9 the slowest.
+static inline uint16_t logicTextStepMs(uint8_t speed)
+{
+    return speed == 0 ? LOGIC_TEXT_DEFAULT_STEP_MS : uint16_t(10 + 10 * (speed > 9 ? 9 : speed));
+}
+
+// Step for the firmware status scrolls. `scale` is kStatusScrollSpeedScale (or
+// 1 for the OTA failure text) and multiplies a fixed unit, so a larger scale
+// scrolls more slowly; the sleep/wake banners must cross both displays inside
+// kSleepTransitionScrollMs at the default scale.
+static inline uint16_t logicTextStatusStepMs(uint8_t scale)
+{
+    return uint16_t(LOGIC_TEXT_STATUS_STEP_UNIT_MS * (scale == 0 ? 1 : scale));
+}
+
+// Draws the width-column window starting at strip column `offset` (negative
+// offsets are blank lead-in). Each line gets an equal horizontal band and the
+// glyphs are centred in it.
+template <class SET_PIXEL>
+static void logicTextStripBlit(const LogicTextStrip &strip, int offset, unsigned width, unsigned height,
+                               SET_PIXEL setPixel)
+{
+    unsigned band = strip.lineCount > 0 ? height / strip.lineCount : height;
+    unsigned glyphRows = strip.glyphRows != 0 ? strip.glyphRows : LOGIC_TEXT_GLYPH_ROWS;
+    unsigned pad = band > glyphRows ? (band - glyphRows) / 2 : 0;
+    for (unsigned x = 0; x < width; x++)
+    {
+        int src = offset + int(x);
+        bool inStrip = src >= 0 && src < int(strip.columnCount);
+        for (uint8_t l = 0; l < strip.lineCount; l++)
+        {
+            uint8_t col = inStrip ? strip.columns[size_t(l) * strip.columnCount + src] : 0;
+            unsigned top = l * band;
+            for (unsigned row = 0; row < band; row++)
+            {
+                unsigned glyphRow = row - pad;
+                bool on = row >= pad && glyphRow < glyphRows && ((col >> glyphRow) & 1);
+                setPixel(x, top + row, on);
+            }
+        }
+    }
+    sLogicTextStripStats.blits++;
+}
+
+static LogicTextStrip *logicTextStripFor(const void *renderer)
+{
+    for (uint8_t i = 0; i < LOGIC_TEXT_MAX_BINDINGS; i++)
+    {
+        if (sLogicTextBindings[i].renderer == renderer)
+            return &sLogicTextBindings[i].strip;
+    }
+    return nullptr;
+}
+
+// Builds text into the renderer's strip (claiming a binding on first use).
+static bool logicTextStripBind(const void *renderer, const char *text, unsigned displayHeight,
+                               uint8_t r, uint8_t g, uint8_t b, uint16_t stepMs)
+{
+    LogicTextStrip *strip = logicTextStripFor(renderer);
+    for (uint8_t i = 0; strip == nullptr && i < LOGIC_TEXT_MAX_BINDINGS; i++)
+    {
+        if (sLogicTextBindings[i].renderer == nullptr)
+        {
+            sLogicTextBindings[i].renderer = renderer;
+            strip = &sLogicTextBindings[i].strip;
+        }
+    }
+    if (strip == nullptr)
+    {
+        sLogicTextStripStats.buildFailures++;
+        return false;
+    }
+    strip->rgb[0] = r;
+    strip->rgb[1] = g;
+    strip->rgb[2] = b;
+    strip->stepMs = stepMs;
+    return logicTextStripBuild(*strip, text, displayHeight);
+}
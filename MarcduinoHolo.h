@@ -45,31 +45,6 @@ static bool parseColorIndexPayload(const char *cmd, uint8_t &colorIndex)
     return true;
 }
 
-static uint8_t rgbToHoloColorIndex(uint16_t r, uint16_t g, uint16_t b)
-{
-    if (r < 16 && g < 16 && b < 16) return 0;
-    if (r >= g && r >= b)
-    {
-        if (g > 180 && b < 100) return 7;
-        if (b > 180 && g > 180) return 8;
-        if (b > 140) return 6;
-        return 1;
-    }
-    if (g >= r && g >= b)
-    {
-        if (r > 180 && b < 100) return 2;
-        if (b > 160) return 4;
-        return 3;
-    }
-    if (b >= r && b >= g)
-    {
-        if (r > 160 && g > 160) return 9;
-        if (r > 140) return 6;
-        return 5;
-    }
-    return 9;
-}
-
 static void sendHoloLedSetColor(uint8_t projector, uint8_t colorIndex)
 {
     char cmd[16];
@@ -110,7 +85,7 @@ MARCDUINO_ACTION(AllHoloOn, *ON00, ({
                      }
                      else if (parseRgbPayload(cmd, r, g, b, brightness) && brightness > 0)
                      {
-                         sendHoloLedSetColor(0, rgbToHoloColorIndex(r, g, b));
+                         sendHoloLedSetColor(0, ledPaletteHoloIndexForRgb(r, g, b));
                      }
                      else
                      {
@@ -137,7 +112,7 @@ MARCDUINO_ACTION(FrontHoloOn, *ON01, ({
                      }
                      else if (parseRgbPayload(cmd, r, g, b, brightness) && brightness > 0)
                      {
-                         sendHoloLedSetColor(1, rgbToHoloColorIndex(r, g, b));
+                         sendHoloLedSetColor(1, ledPaletteHoloIndexForRgb(r, g, b));
                      }
                      else
                      {
@@ -164,7 +139,7 @@ MARCDUINO_ACTION(RearHoloOn, *ON02, ({
                      }
                      else if (parseRgbPayload(cmd, r, g, b, brightness) && brightness > 0)
                      {
-                         sendHoloLedSetColor(2, rgbToHoloColorIndex(r, g, b));
+                         sendHoloLedSetColor(2, ledPaletteHoloIndexForRgb(r, g, b));
                      }
                      else
                      {
@@ -191,7 +166,7 @@ MARCDUINO_ACTION(TopHoloOn, *ON03, ({
                      }
                      else if (parseRgbPayload(cmd, r, g, b, brightness) && brightness > 0)
                      {
-                         sendHoloLedSetColor(3, rgbToHoloColorIndex(r, g, b));
+                         sendHoloLedSetColor(3, ledPaletteHoloIndexForRgb(r, g, b));
                      }
                      else
                      {
@@ -609,7 +584,7 @@ MARCDUINO_ACTION(HoloColorSetCompat, *CO, ({
                      }
                      else
                      {
-                         uint8_t colorIndex = rgbToHoloColorIndex(r, g, b);
+                         uint8_t colorIndex = ledPaletteHoloIndexForRgb(r, g, b);
                          sendHoloLedSetColor(projector, colorIndex);
                      }
                  }))
@@ -254,6 +254,7 @@ static void marcduinoIngressAdmit(const MarcduinoIngressSource &source, const ch
     logCapture.printf("[CMD][%s] %s\n", label, cmd);
     if (handleImmediateServoMoveCommand(label, cmd))
         return;
+    LedDisplayGuard displayGuard;
     if (applyDomeVisualPresetCommand(label, cmd))
         return;
     if (applyDomeVisualAuthoringCommand(label, cmd))
@@ -269,6 +270,7 @@ static void drainMarcduinoCommandQueue()
     char source[24];
     char cmd[CONSOLE_BUFFER_SIZE];
     bool suppressBodyLinkEgress = false;
+    LedDisplayGuard displayGuard;
     while (dequeueMarcduinoCommand(source, sizeof(source), cmd, sizeof(cmd), &suppressBodyLinkEgress))
     {
         logCapture.printf("[CMD][%s][dispatch] %s\n", source, cmd);
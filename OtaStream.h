@@ -0,0 +1,294 @@
+#pragma once
+// OtaStream.h — buffered, hashed and resumable firmware upload pipeline.
+//
+// The /upload/firmware handler used to pass every multipart chunk straight to
+// Update.write() on the async_tcp task, so each flash sector erase stalled the
+// TCP receive path, and it broadcast progress on every chunk. OtaStream sits
+// between the two: chunks are copied into two OTA_STREAM_BLOCK (one flash
+// sector) buffers; a full buffer is handed to the sink while the other one
+// fills, so at most one sector write is in flight and the receive path only
+// waits when it has filled a whole sector ahead of the writer. Every byte is
+// hashed with SHA-256 on the way in, and otaStreamFinish() compares the digest
+// with the one the client supplied before the caller commits the image.
+//
+// A session outlives its HTTP request. If the connection drops, the bytes
+// received so far (including the partly filled buffer) stay put, and a new
+// request carrying ?offset=<received> and the same size and digest carries on
+// from there. Sessions idle for OTA_STREAM_RESUME_WINDOW_MS are expired by
+// the caller. Stats cover throughput, stalls (gaps between chunks over
+// OTA_STREAM_STALL_MS, including the one a resume bridges) and resumes.
+//
+// The sink is a function-pointer table like ConfigStore: the firmware sink
+// queues blocks for a writer task that calls Update.write();
+// tools/test_ota_stream.py uses one that writes late, so a buffer reused
+// before its write completes would show up as a corrupt image.
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include "Sha256.h"
+
+#define OTA_STREAM_BLOCK 4096                   // SPI flash sector
+#define OTA_STREAM_PROGRESS_MS 250              // between progress broadcasts
+#define OTA_STREAM_STALL_MS 500                 // chunk gap counted as a stall
+#define OTA_STREAM_RESUME_WINDOW_MS 120000      // idle session kept for a resume
+
+struct OtaStreamSink
+{
+    // Takes a full (or final, partial) block. The buffer stays owned by the
+    // sink until the next reclaim().
+    bool (*submit)(void *ctx, const uint8_t *block, size_t len);
+    // Waits for the submitted block to be written; false if the write failed.
+    bool (*reclaim)(void *ctx);
+    void *ctx;
+};
+
+enum OtaStreamResult
+{
+    kOtaStreamOk,
+    kOtaStreamNotActive,
+    kOtaStreamBadOffset,        // resume offset is not where the session is
+    kOtaStreamMismatch,         // resume with a different size or digest
+    kOtaStreamTooLarge,         // more bytes than the declared size
+    kOtaStreamWriteFailed,
+    kOtaStreamIncomplete,       // finished short of the declared size
+    kOtaStreamDigestMismatch
+};
+
+struct OtaStreamStats
+{
+    uint32_t blocks;            // sink writes
+    uint32_t resumes;
+    uint32_t stalls;
+    uint32_t stallMs;
+    uint32_t maxGapMs;
+    uint32_t elapsedMs;         // first chunk to last chunk
+};
+
+struct OtaStream
+{
+    uint8_t buf[2][OTA_STREAM_BLOCK];
+    uint8_t fill;               // buffer being filled
+    uint16_t fillLen;
+    bool inFlight;              // the other buffer is with the sink
+    uint16_t inFlightLen;
+    bool active;
+    bool failed;
+    uint32_t size;              // declared image size, 0 = unknown
+    uint32_t received;          // bytes accepted and hashed
+    uint32_t written;           // bytes the sink confirmed
+    bool haveExpected;
+    uint8_t expected[SHA256_DIGEST_LEN];
+    bool haveDigest;
+    uint8_t digest[SHA256_DIGEST_LEN];
+    Sha256 hash;
+    uint32_t startMs;
+    uint32_t lastChunkMs;
+    uint32_t lastProgressMs;
+    OtaStreamStats stats;
+};
+
+static inline void otaStreamReset(OtaStream &s)
+{
+    // The buffers are left alone; they are only read up to fillLen.
+    s.fill = 0;
+    s.fillLen = 0;
+    s.inFlight = false;
+    s.inFlightLen = 0;
+    s.active = false;
+    s.failed = false;
+    s.size = 0;
+    s.received = 0;
+    s.written = 0;
+    s.haveExpected = false;
+    s.haveDigest = false;
+    s.startMs = 0;
+    s.lastChunkMs = 0;
+    s.lastProgressMs = 0;
+    memset(&s.stats, 0, sizeof(s.stats));
+}
+
+// expectedHex may be null or empty (no verification). Returns false for a
+// malformed digest.
+static inline bool otaStreamBegin(OtaStream &s, uint32_t size, const char *expectedHex, uint32_t now)
+{
+    otaStreamReset(s);
+    if (expectedHex != nullptr && expectedHex[0] != '\0')
+    {
+        if (!sha256FromHex(expectedHex, s.expected))
+            return false;
+        s.haveExpected = true;
+    }
+    sha256Init(s.hash);
+    s.size = size;
+    s.active = true;
+    s.startMs = now;
+    s.lastChunkMs = now;
+    return true;
+}
+
+static inline OtaStreamResult otaStreamResume(OtaStream &s, uint32_t offset, uint32_t size,
+                                              const char *expectedHex, uint32_t now)
+{
+    if (!s.active || s.failed)
+        return kOtaStreamNotActive;
+    if (offset != s.received)
+        return kOtaStreamBadOffset;
+    if (size != 0 && size != s.size)
+        return kOtaStreamMismatch;
+    if (expectedHex != nullptr && expectedHex[0] != '\0')
+    {
+        uint8_t expected[SHA256_DIGEST_LEN];
+        if (!sha256FromHex(expectedHex, expected) || !s.haveExpected ||
+            memcmp(expected, s.expected, SHA256_DIGEST_LEN) != 0)
+            return kOtaStreamMismatch;
+    }
+    s.stats.resumes++;
+    (void)now;
+    return kOtaStreamOk;
+}
+
+static inline bool otaStreamReclaim(OtaStream &s, const OtaStreamSink &sink)
+{
+    if (!s.inFlight)
+        return true;
+    s.inFlight = false;
+    if (!sink.reclaim(sink.ctx))
+        return false;
+    s.written += s.inFlightLen;
+    return true;
+}
+
+// Hands the filling buffer to the sink and switches to the other one, after
+// the sink has given that one back.
+static inline bool otaStreamSubmit(OtaStream &s, const OtaStreamSink &sink)
+{
+    uint16_t len = s.fillLen;
+    uint8_t block = s.fill;
+    if (!otaStreamReclaim(s, sink))
+        return false;
+    if (!sink.submit(sink.ctx, s.buf[block], len))
+        return false;
+    s.inFlight = true;
+    s.inFlightLen = len;
+    s.stats.blocks++;
+    s.fill ^= 1;
+    s.fillLen = 0;
+    return true;
+}
+
+static inline OtaStreamResult otaStreamWrite(OtaStream &s, const OtaStreamSink &sink,
+                                             const uint8_t *data, size_t len, uint32_t now)
+{
+    if (!s.active || s.failed)
+        return kOtaStreamNotActive;
+    if (s.size != 0 && s.received + len > s.size)
+    {
+        s.failed = true;
+        return kOtaStreamTooLarge;
+    }
+
+    uint32_t gap = now - s.lastChunkMs;
+    if (gap > s.stats.maxGapMs)
+        s.stats.maxGapMs = gap;
+    if (gap > OTA_STREAM_STALL_MS)
+    {
+        s.stats.stalls++;
+        s.stats.stallMs += gap;
+    }
+    s.lastChunkMs = now;
+    s.stats.elapsedMs = now - s.startMs;
+
+    sha256Update(s.hash, data, len);
+    s.received += len;
+    while (len > 0)
+    {
+        size_t take = OTA_STREAM_BLOCK - s.fillLen;
+        if (take > len)
+            take = len;
+        memcpy(s.buf[s.fill] + s.fillLen, data, take);
+        s.fillLen += take;
+        data += take;
+        len -= take;
+        if (s.fillLen == OTA_STREAM_BLOCK && !otaStreamSubmit(s, sink))
+        {
+            s.failed = true;
+            return kOtaStreamWriteFailed;
+        }
+    }
+    return kOtaStreamOk;
+}
+
+// Flushes the last partial block, waits for the writer and checks size and
+// digest. The caller commits (Update.end) only on kOtaStreamOk, and aborts
+// otherwise. The session is closed either way.
+static inline OtaStreamResult otaStreamFinish(OtaStream &s, const OtaStreamSink &sink)
+{
+    if (!s.active)
+        return kOtaStreamNotActive;
+    s.active = false;
+    if (s.failed)
+    {
+        otaStreamReclaim(s, sink);
+        return kOtaStreamWriteFailed;
+    }
+    if ((s.fillLen > 0 && !otaStreamSubmit(s, sink)) || !otaStreamReclaim(s, sink))
+    {
+        s.failed = true;
+        return kOtaStreamWriteFailed;
+    }
+    sha256Final(s.hash, s.digest);
+    s.haveDigest = true;
+    if (s.size != 0 && s.received != s.size)
+        return kOtaStreamIncomplete;
+    if (s.haveExpected && memcmp(s.digest, s.expected, SHA256_DIGEST_LEN) != 0)
+        return kOtaStreamDigestMismatch;
+    return kOtaStreamOk;
+}
+
+// Drops the session after waiting for any write in flight; the caller aborts
+// the partition update.
+static inline void otaStreamAbort(OtaStream &s, const OtaStreamSink &sink)
+{
+    otaStreamReclaim(s, sink);
+    s.active = false;
+    s.failed = true;
+}
+
+static inline bool otaStreamExpired(const OtaStream &s, uint32_t now)
+{
+    return s.active && now - s.lastChunkMs >= OTA_STREAM_RESUME_WINDOW_MS;
+}
+
+// True at most every OTA_STREAM_PROGRESS_MS, and for the last byte.
+static inline bool otaStreamProgressDue(OtaStream &s, uint32_t now)
+{
+    bool done = s.size != 0 && s.received == s.size;
+    if (!done && s.lastProgressMs != 0 && now - s.lastProgressMs < OTA_STREAM_PROGRESS_MS)
+        return false;
+    s.lastProgressMs = now == 0 ? 1 : now;
+    return true;
+}
+
+static inline uint32_t otaStreamKbps(const OtaStream &s)
+{
+    if (s.stats.elapsedMs == 0)
+        return 0;
+    return (uint32_t)((uint64_t)s.received * 1000 / 1024 / s.stats.elapsedMs);
+}
+
+static inline const char *otaStreamResultText(OtaStreamResult result)
+{
+    switch (result)
+    {
+        case kOtaStreamOk: return "ok";
+        case kOtaStreamNotActive: return "no upload session to resume";
+        case kOtaStreamBadOffset: return "resume offset does not match received bytes";
+        case kOtaStreamMismatch: return "resume size or sha256 does not match the session";
+        case kOtaStreamTooLarge: return "more data than the declared size";
+        case kOtaStreamWriteFailed: return "firmware image write failed or exceeded OTA slot";
+        case kOtaStreamIncomplete: return "image shorter than the declared size";
+        case kOtaStreamDigestMismatch: return "sha256 mismatch";
+    }
+    return "unknown";
+}
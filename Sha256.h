@@ -0,0 +1,166 @@
+#pragma once
+// Sha256.h — incremental SHA-256 (FIPS 180-4) without platform dependencies.
+//
+// Used to hash images as they stream through OTA so the digest can be checked
+// before the new partition is marked bootable. The ESP32 has a SHA
+// accelerator behind mbedTLS, but the upload path is bounded by WiFi, not by
+// hashing, and a plain implementation lets the host tests
+// (tools/test_ota_stream.py) run the exact code the firmware does.
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#define SHA256_DIGEST_LEN 32
+#define SHA256_HEX_LEN 64
+
+struct Sha256
+{
+    uint32_t state[8];
+    uint64_t length;            // bytes hashed so far
+    uint8_t block[64];
+    uint8_t blockLen;
+};
+
+static inline uint32_t sha256Rotr(uint32_t x, uint8_t n)
+{
+    return (x >> n) | (x << (32 - n));
+}
+
+static inline void sha256Compress(Sha256 &h, const uint8_t *p)
+{
+    static const uint32_t k[64] = {
+        0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+        0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+        0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+        0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+        0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+        0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+        0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+        0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+    };
+    uint32_t w[64];
+    for (uint8_t i = 0; i < 16; i++)
+        w[i] = ((uint32_t)p[i * 4] << 24) | ((uint32_t)p[i * 4 + 1] << 16) | ((uint32_t)p[i * 4 + 2] << 8) | p[i * 4 + 3];
+    for (uint8_t i = 16; i < 64; i++)
+    {
+        uint32_t s0 = sha256Rotr(w[i - 15], 7) ^ sha256Rotr(w[i - 15], 18) ^ (w[i - 15] >> 3);
+        uint32_t s1 = sha256Rotr(w[i - 2], 17) ^ sha256Rotr(w[i - 2], 19) ^ (w[i - 2] >> 10);
+        w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+    }
+    uint32_t a = h.state[0], b = h.state[1], c = h.state[2], d = h.state[3];
+    uint32_t e = h.state[4], f = h.state[5], g = h.state[6], hh = h.state[7];
+    for (uint8_t i = 0; i < 64; i++)
+    {
+        uint32_t t1 = hh + (sha256Rotr(e, 6) ^ sha256Rotr(e, 11) ^ sha256Rotr(e, 25)) + ((e & f) ^ (~e & g)) + k[i] + w[i];
+        uint32_t t2 = (sha256Rotr(a, 2) ^ sha256Rotr(a, 13) ^ sha256Rotr(a, 22)) + ((a & b) ^ (a & c) ^ (b & c));
+        hh = g;
+        g = f;
+        f = e;
+        e = d + t1;
+        d = c;
+        c = b;
+        b = a;
+        a = t1 + t2;
+    }
+    h.state[0] += a;
+    h.state[1] += b;
+    h.state[2] += c;
+    h.state[3] += d;
+    h.state[4] += e;
+    h.state[5] += f;
+    h.state[6] += g;
+    h.state[7] += hh;
+}
+
+static inline void sha256Init(Sha256 &h)
+{
+    static const uint32_t iv[8] = {
+        0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+    };
+    memcpy(h.state, iv, sizeof(iv));
+    h.length = 0;
+    h.blockLen = 0;
+}
+
+static inline void sha256Update(Sha256 &h, const uint8_t *data, size_t len)
+{
+    h.length += len;
+    if (h.blockLen > 0)
+    {
+        size_t take = 64 - h.blockLen;
+        if (take > len)
+            take = len;
+        memcpy(h.block + h.blockLen, data, take);
+        h.blockLen += take;
+        data += take;
+        len -= take;
+        if (h.blockLen < 64)
+            return;
+        sha256Compress(h, h.block);
+        h.blockLen = 0;
+    }
+    for (; len >= 64; data += 64, len -= 64)
+        sha256Compress(h, data);
+    memcpy(h.block, data, len);
+    h.blockLen = len;
+}
+
+static inline void sha256Final(Sha256 &h, uint8_t out[SHA256_DIGEST_LEN])
+{
+    uint64_t bits = h.length * 8;
+    h.block[h.blockLen++] = 0x80;
+    if (h.blockLen > 56)
+    {
+        memset(h.block + h.blockLen, 0, 64 - h.blockLen);
+        sha256Compress(h, h.block);
+        h.blockLen = 0;
+    }
+    memset(h.block + h.blockLen, 0, 56 - h.blockLen);
+    for (uint8_t i = 0; i < 8; i++)
+        h.block[56 + i] = (uint8_t)(bits >> (56 - i * 8));
+    sha256Compress(h, h.block);
+    for (uint8_t i = 0; i < 8; i++)
+    {
+        out[i * 4] = (uint8_t)(h.state[i] >> 24);
+        out[i * 4 + 1] = (uint8_t)(h.state[i] >> 16);
+        out[i * 4 + 2] = (uint8_t)(h.state[i] >> 8);
+        out[i * 4 + 3] = (uint8_t)h.state[i];
+    }
+}
+
+static inline void sha256ToHex(const uint8_t digest[SHA256_DIGEST_LEN], char out[SHA256_HEX_LEN + 1])
+{
+    static const char hex[] = "0123456789abcdef";
+    for (uint8_t i = 0; i < SHA256_DIGEST_LEN; i++)
+    {
+        out[i * 2] = hex[digest[i] >> 4];
+        out[i * 2 + 1] = hex[digest[i] & 0x0F];
+    }
+    out[SHA256_HEX_LEN] = '\0';
+}
+
+// Accepts upper or lower case; false unless exactly 64 hex digits.
+static inline bool sha256FromHex(const char *text, uint8_t digest[SHA256_DIGEST_LEN])
+{
+    if (text == nullptr || strlen(text) != SHA256_HEX_LEN)
+        return false;
+    for (uint8_t i = 0; i < SHA256_HEX_LEN; i++)
+    {
+        char c = text[i];
+        uint8_t v;
+        if (c >= '0' && c <= '9')
+            v = c - '0';
+        else if (c >= 'a' && c <= 'f')
+            v = c - 'a' + 10;
+        else if (c >= 'A' && c <= 'F')
+            v = c - 'A' + 10;
+        else
+            return false;
+        if (i % 2 == 0)
+            digest[i / 2] = v << 4;
+        else
+            digest[i / 2] |= v;
+    }
+    return true;
+}
@@ -0,0 +1,185 @@
+#pragma once
+// WebAssetManifest.h — the list of web assets on SPIFFS and their digests.
+//
+// /upload/filesystem replaces the whole SPIFFS partition, so changing one page
+// meant a full image and lost the user's files (the custom dome layout, logic
+// sprites). The per-file asset API (WebAssetStore.h) updates single files
+// instead, and this manifest tells tools/web_asset_sync.py what the controller
+// already has. tools/build_web_assets.py writes it into the staged tree as
+// /webfs.mf, one "<sha256 hex> <size> <path>" line per stored file, and the
+// asset API rewrites it after every file it installs or removes.
+//
+// webAssetPathAllowed() is the boundary between assets and user data: only
+// top-level files with a web extension can be written or removed through the
+// API. Anything in a directory (/sprites/...), the dome layout template files
+// and the manifest's own /webfs.* files are never touched.
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "Sha256.h"
+
+#define WEB_ASSET_MANIFEST_PATH "/webfs.mf"
+#define WEB_ASSET_MANIFEST_TMP_PATH "/webfs.mf.tmp"
+#define WEB_ASSET_UPLOAD_TMP_PATH "/webfs.up.tmp"
+#define WEB_ASSET_BUILD_ID_PATH "/webfs.id"
+#define WEB_ASSET_BUILD_ID_TMP_PATH "/webfs.id.tmp"
+#define WEB_ASSET_PATH_MAX 31           // SPIFFS_OBJ_NAME_LEN without the NUL
+#define WEB_ASSET_MANIFEST_MAX 40
+#define WEB_ASSET_LINE_MAX (SHA256_HEX_LEN + 1 + 10 + 1 + WEB_ASSET_PATH_MAX + 1)
+
+struct WebAssetEntry
+{
+    char path[WEB_ASSET_PATH_MAX + 1];
+    uint32_t size;
+    uint8_t sha[SHA256_DIGEST_LEN];
+};
+
+struct WebAssetManifest
+{
+    WebAssetEntry entries[WEB_ASSET_MANIFEST_MAX];
+    uint8_t count;
+};
+
+static inline bool webAssetEndsWith(const char *text, size_t len, const char *suffix)
+{
+    size_t n = strlen(suffix);
+    return len >= n && memcmp(text + len - n, suffix, n) == 0;
+}
+
+static inline bool webAssetPathAllowed(const char *path)
+{
+    static const char *const kExtensions[] = {".html", ".css", ".js", ".json", ".png", ".ico", ".svg", ".txt"};
+    static const char *const kReserved[] = {"/webfs.", "/dome-layout-template."};
+    if (path == nullptr || path[0] != '/')
+        return false;
+    size_t len = strlen(path);
+    if (len < 2 || len > WEB_ASSET_PATH_MAX || strchr(path + 1, '/') != nullptr || strstr(path, "..") != nullptr)
+        return false;
+    for (size_t i = 1; i < len; i++)
+    {
+        char c = path[i];
+        if (!((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') ||
+              c == '.' || c == '-' || c == '_'))
+            return false;
+    }
+    for (size_t i = 0; i < sizeof(kReserved) / sizeof(kReserved[0]); i++)
+    {
+        if (strncmp(path, kReserved[i], strlen(kReserved[i])) == 0)
+            return false;
+    }
+    if (webAssetEndsWith(path, len, ".gz"))
+        len -= 3;
+    for (size_t i = 0; i < sizeof(kExtensions) / sizeof(kExtensions[0]); i++)
+    {
+        if (webAssetEndsWith(path, len, kExtensions[i]))
+            return true;
+    }
+    return false;
+}
+
+static inline void webAssetManifestReset(WebAssetManifest &m)
+{
+    m.count = 0;
+}
+
+static inline int webAssetManifestFind(const WebAssetManifest &m, const char *path)
+{
+    for (int i = 0; i < m.count; i++)
+    {
+        if (strcmp(m.entries[i].path, path) == 0)
+            return i;
+    }
+    return -1;
+}
+
+// Adds or replaces an entry; false when the path is not an asset or the
+// manifest is full.
+static inline bool webAssetManifestSet(WebAssetManifest &m, const char *path, uint32_t size,
+                                       const uint8_t sha[SHA256_DIGEST_LEN])
+{
+    if (!webAssetPathAllowed(path))
+        return false;
+    int i = webAssetManifestFind(m, path);
+    if (i < 0)
+    {
+        if (m.count >= WEB_ASSET_MANIFEST_MAX)
+            return false;
+        i = m.count++;
+        strcpy(m.entries[i].path, path);
+    }
+    m.entries[i].size = size;
+    memcpy(m.entries[i].sha, sha, SHA256_DIGEST_LEN);
+    return true;
+}
+
+static inline bool webAssetManifestRemove(WebAssetManifest &m, const char *path)
+{
+    int i = webAssetManifestFind(m, path);
+    if (i < 0)
+        return false;
+    m.entries[i] = m.entries[--m.count];
+    return true;
+}
+
+// Parses one manifest line (without the newline). Lines that do not parse or
+// name a non-asset path are skipped by the caller.
+static inline bool webAssetManifestParseLine(const char *line, size_t len, WebAssetEntry &entry)
+{
+    char hex[SHA256_HEX_LEN + 1];
+    if (len < SHA256_HEX_LEN + 4 || line[SHA256_HEX_LEN] != ' ')
+        return false;
+    memcpy(hex, line, SHA256_HEX_LEN);
+    hex[SHA256_HEX_LEN] = '\0';
+    if (!sha256FromHex(hex, entry.sha))
+        return false;
+    const char *p = line + SHA256_HEX_LEN + 1;
+    const char *end = line + len;
+    uint32_t size = 0;
+    if (p >= end || *p < '0' || *p > '9')
+        return false;
+    while (p < end && *p >= '0' && *p <= '9')
+        size = size * 10 + (uint32_t)(*p++ - '0');
+    if (p >= end || *p != ' ')
+        return false;
+    p++;
+    size_t pathLen = (size_t)(end - p);
+    if (pathLen == 0 || pathLen > WEB_ASSET_PATH_MAX)
+        return false;
+    memcpy(entry.path, p, pathLen);
+    entry.path[pathLen] = '\0';
+    entry.size = size;
+    return webAssetPathAllowed(entry.path);
+}
+
+// Loads a whole manifest text; returns the number of entries kept.
+static inline int webAssetManifestParse(WebAssetManifest &m, const char *text, size_t len)
+{
+    webAssetManifestReset(m);
+    size_t start = 0;
+    while (start < len)
+    {
+        size_t end = start;
+        while (end < len && text[end] != '\n')
+            end++;
+        size_t lineLen = end - start;
+        if (lineLen > 0 && text[start + lineLen - 1] == '\r')
+            lineLen--;
+        WebAssetEntry entry;
+        if (webAssetManifestParseLine(text + start, lineLen, entry))
+            webAssetManifestSet(m, entry.path, entry.size, entry.sha);
+        start = end + 1;
+    }
+    return m.count;
+}
+
+// Writes "<sha256 hex> <size> <path>\n" into out (WEB_ASSET_LINE_MAX bytes);
+// returns the length.
+static inline size_t webAssetManifestFormatLine(const WebAssetEntry &entry, char *out)
+{
+    char hex[SHA256_HEX_LEN + 1];
+    sha256ToHex(entry.sha, hex);
+    return (size_t)snprintf(out, WEB_ASSET_LINE_MAX, "%s %u %s\n", hex, (unsigned)entry.size, entry.path);
+}
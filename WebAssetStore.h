@@ -0,0 +1,328 @@
+#pragma once
+// WebAssetStore.h — per-file web asset updates on SPIFFS.
+//
+// Installs single web assets without touching the rest of the partition. An
+// upload streams into WEB_ASSET_UPLOAD_TMP_PATH while it is hashed, and is
+// promoted with the same remove + rename as domeLayoutTemplateWriteCustom()
+// only when its size and SHA-256 match what the client declared, so a page is
+// either the old file or the complete new one. The manifest (WebAssetManifest.h)
+// is rewritten the same way after each file, which lets an interrupted sync
+// pick up where it stopped; if that rewrite fails the file is still installed
+// and the upload reports it, so the next sync only sends it again. Commit
+// removes assets the new build no longer has and records its build id, also
+// by rename, for the static handler's ETag.
+// Paths outside webAssetPathAllowed() (dome layout template, sprites) are
+// refused, so user data survives a web UI update.
+
+#include <Arduino.h>
+#include "FS.h"
+#include "SPIFFS.h"
+#include "WebAssetManifest.h"
+
+// One upload at a time, owned by the request that began it until that
+// request is answered or disconnects; another request meanwhile gets 409. The
+// body callback that writes it cannot answer the request, so a failure is kept
+// here for the owner's response handler.
+struct WebAssetUpload
+{
+    const void *owner;
+    File file;
+    Sha256 hash;
+    char path[WEB_ASSET_PATH_MAX + 1];
+    uint8_t expected[SHA256_DIGEST_LEN];
+    uint32_t size;
+    uint32_t received;
+    bool active;
+    bool failed;
+    int httpStatus;
+    String error;
+    String manifestError;   // set when the file went live but the manifest did not follow
+};
+
+static WebAssetManifest sWebAssetManifest;
+static bool sWebAssetManifestLoaded = false;
+static WebAssetUpload sWebAssetUpload;
+static uint32_t sWebAssetInstalled = 0;
+static uint32_t sWebAssetRemoved = 0;
+
+static void webAssetManifestLoad()
+{
+    if (sWebAssetManifestLoaded)
+        return;
+    sWebAssetManifestLoaded = true;
+    webAssetManifestReset(sWebAssetManifest);
+    File file = SPIFFS.open(WEB_ASSET_MANIFEST_PATH, FILE_READ);
+    if (!file)
+        return;
+    String text = file.readString();
+    file.close();
+    webAssetManifestParse(sWebAssetManifest, text.c_str(), text.length());
+}
+
+// On failure httpStatus is 507 for a short write (filesystem full), else 500.
+static bool webAssetManifestSave(String &errMsg, int &httpStatus)
+{
+    if (SPIFFS.exists(WEB_ASSET_MANIFEST_TMP_PATH)) SPIFFS.remove(WEB_ASSET_MANIFEST_TMP_PATH);
+    File file = SPIFFS.open(WEB_ASSET_MANIFEST_TMP_PATH, FILE_WRITE);
+    if (!file)
+    {
+        errMsg = "cannot open temporary manifest";
+        httpStatus = 500;
+        return false;
+    }
+    bool ok = true;
+    char line[WEB_ASSET_LINE_MAX];
+    for (int i = 0; i < sWebAssetManifest.count && ok; i++)
+    {
+        size_t len = webAssetManifestFormatLine(sWebAssetManifest.entries[i], line);
+        ok = file.write((const uint8_t *)line, len) == len;
+    }
+    file.close();
+    if (!ok)
+    {
+        SPIFFS.remove(WEB_ASSET_MANIFEST_TMP_PATH);
+        errMsg = "manifest write was incomplete";
+        httpStatus = 507;
+        return false;
+    }
+    if (SPIFFS.exists(WEB_ASSET_MANIFEST_PATH)) SPIFFS.remove(WEB_ASSET_MANIFEST_PATH);
+    if (!SPIFFS.rename(WEB_ASSET_MANIFEST_TMP_PATH, WEB_ASSET_MANIFEST_PATH))
+    {
+        SPIFFS.remove(WEB_ASSET_MANIFEST_TMP_PATH);
+        errMsg = "cannot promote manifest";
+        httpStatus = 500;
+        return false;
+    }
+    return true;
+}
+
+static bool webAssetOwnedBy(const void *owner)
+{
+    return owner != nullptr && sWebAssetUpload.owner == owner;
+}
+
+// Ends owner's session: drops the temporary file of an upload that never
+// finished (connection lost, update started) and lets the next request begin.
+static void webAssetRelease(const void *owner)
+{
+    if (!webAssetOwnedBy(owner))
+        return;
+    if (sWebAssetUpload.active)
+    {
+        sWebAssetUpload.file.close();
+        sWebAssetUpload.active = false;
+        SPIFFS.remove(WEB_ASSET_UPLOAD_TMP_PATH);
+    }
+    sWebAssetUpload.owner = nullptr;
+}
+
+static bool webAssetFail(int httpStatus, const String &error)
+{
+    if (sWebAssetUpload.active)
+    {
+        sWebAssetUpload.file.close();
+        sWebAssetUpload.active = false;
+        SPIFFS.remove(WEB_ASSET_UPLOAD_TMP_PATH);
+    }
+    sWebAssetUpload.failed = true;
+    sWebAssetUpload.httpStatus = httpStatus;
+    sWebAssetUpload.error = error;
+    return false;
+}
+
+// False without touching the session when another request owns it.
+static bool webAssetBegin(const void *owner, const String &path, uint32_t size, const String &sha256)
+{
+    if (sWebAssetUpload.owner != nullptr && sWebAssetUpload.owner != owner)
+        return false;
+    webAssetRelease(owner);
+    sWebAssetUpload.owner = owner;
+    sWebAssetUpload.failed = false;
+    sWebAssetUpload.error = "";
+    sWebAssetUpload.manifestError = "";
+    sWebAssetUpload.path[0] = '\0';
+    if (!webAssetPathAllowed(path.c_str()))
+        return webAssetFail(400, "not a web asset path");
+    if (!sha256FromHex(sha256.c_str(), sWebAssetUpload.expected))
+        return webAssetFail(400, "sha256 must be 64 hex digits");
+    if (SPIFFS.exists(WEB_ASSET_UPLOAD_TMP_PATH)) SPIFFS.remove(WEB_ASSET_UPLOAD_TMP_PATH);
+    sWebAssetUpload.file = SPIFFS.open(WEB_ASSET_UPLOAD_TMP_PATH, FILE_WRITE);
+    if (!sWebAssetUpload.file)
+        return webAssetFail(500, "cannot open temporary asset file");
+    strcpy(sWebAssetUpload.path, path.c_str());
+    sha256Init(sWebAssetUpload.hash);
+    sWebAssetUpload.size = size;
+    sWebAssetUpload.received = 0;
+    sWebAssetUpload.active = true;
+    return true;
+}
+
+static bool webAssetWrite(const uint8_t *data, size_t len)
+{
+    WebAssetUpload &u = sWebAssetUpload;
+    if (!u.active)
+        return false;
+    if (u.received + len > u.size)
+        return webAssetFail(400, "more data than the declared size");
+    if (u.file.write(data, len) != len)
+        return webAssetFail(507, "asset write failed (filesystem full?)");
+    sha256Update(u.hash, data, len);
+    u.received += len;
+    return true;
+}
+
+// Verifies and promotes the upload; on false, error and httpStatus say why
+// and the old file is untouched. True means the new file is live, even when
+// manifestError says the manifest could not record it.
+static bool webAssetFinish()
+{
+    WebAssetUpload &u = sWebAssetUpload;
+    if (u.failed)
+        return false;
+    if (!u.active)
+        return webAssetFail(400, "no asset upload in progress");
+    uint8_t digest[SHA256_DIGEST_LEN];
+    sha256Final(u.hash, digest);
+    if (u.received != u.size)
+        return webAssetFail(400, "asset shorter than the declared size");
+    if (memcmp(digest, u.expected, SHA256_DIGEST_LEN) != 0)
+        return webAssetFail(400, "sha256 mismatch");
+    u.file.close();
+    u.active = false;
+    if (SPIFFS.exists(u.path)) SPIFFS.remove(u.path);
+    if (!SPIFFS.rename(WEB_ASSET_UPLOAD_TMP_PATH, u.path))
+    {
+        SPIFFS.remove(WEB_ASSET_UPLOAD_TMP_PATH);
+        return webAssetFail(500, "cannot promote asset file");
+    }
+    sWebAssetInstalled++;
+    webAssetManifestLoad();
+    if (!webAssetManifestSet(sWebAssetManifest, u.path, u.size, digest))
+        u.manifestError = "asset manifest is full";
+    else
+    {
+        int httpStatus;
+        webAssetManifestSave(u.manifestError, httpStatus);
+    }
+    return true;
+}
+
+static bool webAssetBuildIdSave(const String &buildId, String &errMsg, int &httpStatus)
+{
+    if (SPIFFS.exists(WEB_ASSET_BUILD_ID_TMP_PATH)) SPIFFS.remove(WEB_ASSET_BUILD_ID_TMP_PATH);
+    File file = SPIFFS.open(WEB_ASSET_BUILD_ID_TMP_PATH, FILE_WRITE);
+    if (!file)
+    {
+        errMsg = "cannot open temporary build id";
+        httpStatus = 500;
+        return false;
+    }
+    bool ok = file.print(buildId + "\n") == buildId.length() + 1;
+    file.close();
+    if (!ok)
+    {
+        SPIFFS.remove(WEB_ASSET_BUILD_ID_TMP_PATH);
+        errMsg = "build id write was incomplete";
+        httpStatus = 507;
+        return false;
+    }
+    if (SPIFFS.exists(WEB_ASSET_BUILD_ID_PATH)) SPIFFS.remove(WEB_ASSET_BUILD_ID_PATH);
+    if (!SPIFFS.rename(WEB_ASSET_BUILD_ID_TMP_PATH, WEB_ASSET_BUILD_ID_PATH))
+    {
+        SPIFFS.remove(WEB_ASSET_BUILD_ID_TMP_PATH);
+        errMsg = "cannot promote build id";
+        httpStatus = 500;
+        return false;
+    }
+    return true;
+}
+
+// Removes the comma-separated assets the new build dropped and records its
+// build id. Names that are not assets are refused (400) before anything
+// changes; a filesystem failure after that is 500, or 507 when it ran full.
+static bool webAssetCommit(const String &buildId, const String &removeCsv, String &errMsg, int &httpStatus)
+{
+    httpStatus = 400;
+    bool buildOk = buildId.length() <= 16;
+    for (size_t i = 0; i < buildId.length(); i++)
+        buildOk = buildOk && isxdigit((unsigned char)buildId[i]);
+    if (!buildOk)
+    {
+        errMsg = "invalid build id";
+        return false;
+    }
+    webAssetManifestLoad();
+    for (int pass = 0; pass < 2; pass++)
+    {
+        int start = 0;
+        while (start < (int)removeCsv.length())
+        {
+            int comma = removeCsv.indexOf(',', start);
+            if (comma < 0) comma = removeCsv.length();
+            String path = removeCsv.substring(start, comma);
+            start = comma + 1;
+            if (path.length() == 0)
+                continue;
+            if (pass == 0 && !webAssetPathAllowed(path.c_str()))
+            {
+                errMsg = "not a web asset path: " + path;
+                return false;
+            }
+            if (pass == 1)
+            {
+                if (SPIFFS.exists(path) && SPIFFS.remove(path)) sWebAssetRemoved++;
+                webAssetManifestRemove(sWebAssetManifest, path.c_str());
+            }
+        }
+    }
+    if (!webAssetManifestSave(errMsg, httpStatus))
+        return false;
+    return buildId.length() == 0 || webAssetBuildIdSave(buildId, errMsg, httpStatus);
+}
+
+// Every asset on SPIFFS with the digest from the manifest, or "" where the
+// manifest has no entry of that size (older images, files put there by hand).
+static String webAssetListJson()
+{
+    webAssetManifestLoad();
+    String build;
+    File id = SPIFFS.open(WEB_ASSET_BUILD_ID_PATH, FILE_READ);
+    if (id)
+    {
+        build = id.readStringUntil('\n');
+        build.trim();
+        id.close();
+    }
+    String json = "{\"build\":\"" + build + "\"";
+    json += ",\"manifest\":" + String(SPIFFS.exists(WEB_ASSET_MANIFEST_PATH) ? "true" : "false");
+    json += ",\"total_bytes\":" + String((uint32_t)SPIFFS.totalBytes());
+    json += ",\"used_bytes\":" + String((uint32_t)SPIFFS.usedBytes());
+    json += ",\"installed\":" + String(sWebAssetInstalled);
+    json += ",\"removed\":" + String(sWebAssetRemoved);
+    json += ",\"files\":[";
+    uint32_t userFiles = 0;
+    bool first = true;
+    File dir = SPIFFS.open("/");
+    if (dir && dir.isDirectory())
+    {
+        for (File f = dir.openNextFile(); f; f = dir.openNextFile())
+        {
+            String path = f.path();
+            if (!webAssetPathAllowed(path.c_str()))
+            {
+                if (!path.startsWith("/webfs.")) userFiles++;
+                continue;
+            }
+            uint32_t size = (uint32_t)f.size();
+            char hex[SHA256_HEX_LEN + 1] = "";
+            int i = webAssetManifestFind(sWebAssetManifest, path.c_str());
+            if (i >= 0 && sWebAssetManifest.entries[i].size == size)
+                sha256ToHex(sWebAssetManifest.entries[i].sha, hex);
+            if (!first) json += ",";
+            first = false;
+            json += "{\"path\":\"" + path + "\",\"size\":" + String(size) + ",\"sha256\":\"" + hex + "\"}";
+        }
+    }
+    json += "],\"user_files\":" + String(userFiles) + "}";
+    return json;
+}
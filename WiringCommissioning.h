@@ -270,52 +270,66 @@ static bool wiringCommissioningPanelSlotActive(int slot)
     return actives[slot];
 }
 
-static String wiringCommissioningBuildConfigJson(WiringBoardId id)
+// Channel/active state for one board, read once per GET so a streamed
+// response reports a consistent snapshot.
+struct WiringConfigSnapshot
 {
-    const WiringBoardSpec &spec = wiringBoardSpec(id);
     uint8_t channels[NUM_PANEL_SLOTS];
     bool actives[NUM_PANEL_SLOTS];
+};
+
+static_assert(NUM_HOLO_SLOTS <= NUM_PANEL_SLOTS, "WiringConfigSnapshot is sized for the panel board");
+
+static void wiringCommissioningReadConfig(WiringBoardId id, WiringConfigSnapshot &out)
+{
+    const WiringBoardSpec &spec = wiringBoardSpec(id);
     wiringConfigRead(spec.nvsNamespace,
                      spec.channelKeyFormat,
                      spec.activeKeyFormat,
                      spec.slotCount,
                      spec.defaultChannels,
                      spec.defaultActives,
-                     channels,
-                     actives);
+                     out.channels,
+                     out.actives);
+}
 
-    String json = "{";
-    json.reserve(64 + spec.slotCount * 80);
-    json += "\"board\":\"";
+// GET /api/<board>/config is emitted in pieces: the head, then one slot
+// object per call, then "]}".
+static void wiringCommissioningAppendConfigHead(WiringBoardId id, String &json)
+{
+    const WiringBoardSpec &spec = wiringBoardSpec(id);
+    json += "{\"board\":\"";
     json += spec.board;
     json += "\",\"slot_count\":";
     json += spec.slotCount;
     json += ",\"slots\":[";
-    for (int i = 0; i < spec.slotCount; i++)
+}
+
+static void wiringCommissioningAppendConfigSlot(WiringBoardId id,
+                                                const WiringConfigSnapshot &config,
+                                                int i, String &json)
+{
+    const WiringBoardSpec &spec = wiringBoardSpec(id);
+    if (i > 0) json += ',';
+    json += "{\"index\":";
+    json += i;
+    if (spec.labelFn)
     {
-        if (i > 0) json += ',';
-        json += "{\"index\":";
-        json += i;
-        if (spec.labelFn)
-        {
-            json += ",\"label\":\"";
-            json += wiringCommissioningJsonEscape(spec.labelFn(i));
-            json += '"';
-        }
-        json += ",\"channel\":";
-        json += channels[i];
-        json += ",\"active\":";
-        json += actives[i] ? "true" : "false";
-        if (spec.commandFn)
-        {
-            json += ",\"cmd\":\"";
-            json += wiringCommissioningJsonEscape(spec.commandFn(i));
-            json += '"';
-        }
-        json += '}';
+        json += ",\"label\":\"";
+        json += wiringCommissioningJsonEscape(spec.labelFn(i));
+        json += '"';
     }
-    json += "]}";
-    return json;
+    json += ",\"channel\":";
+    json += config.channels[i];
+    json += ",\"active\":";
+    json += config.actives[i] ? "true" : "false";
+    if (spec.commandFn)
+    {
+        json += ",\"cmd\":\"";
+        json += wiringCommissioningJsonEscape(spec.commandFn(i));
+        json += '"';
+    }
+    json += '}';
 }
 
 // Raw servo test state and helpers. These intentionally bypass ServoDispatch
@@ -423,6 +437,10 @@ static void wiringCommissioningHoloSweepPoll()
     sWiringHoloSweepDeadline = millis() + WIRING_HOLO_SWEEP_HOLD_MS;
 }
 
+// Bumped after every applied config save; layout consumers that cache
+// per-slot active state compare against it.
+static uint32_t sWiringConfigGeneration = 0;
+
 static bool wiringCommissioningSaveConfigFromBody(WiringBoardId id,
                                                   const String &body,
                                                   int &httpStatus,
@@ -471,6 +489,7 @@ static bool wiringCommissioningSaveConfigFromBody(WiringBoardId id,
 
     wiringStopRawServoTestBeforeApply(spec);
     int activeCount = wiringApplyBoardConfig(spec, channels, actives);
+    sWiringConfigGeneration++;
     logCapture.printf("[API] %s saved and applied: %d active, %d inactive\n",
                        spec.configPathName,
                        activeCount,
@@ -87,6 +87,9 @@
         if (msg.type === 'ota' && typeof window.onOtaProgress === 'function') {
           window.onOtaProgress(msg.progress);
         }
+        if (msg.type === 'elementStatus' && typeof window.onElementStatus === 'function') {
+          window.onElementStatus(msg);
+        }
       } catch(e) { /* ignore parse errors */ }
     };
   }
@@ -5,17 +5,6 @@ static inline int iabs(int a)
 
 static bool LogicEffectFadeAndScroll(LogicEngineRenderer& r)
 {
-    enum Palette
-    {
-        kPaletteRGB,
-        kPaletteRed,
-        kPaletteGreen,
-        kPaletteBlue,
-        kPaletteWhite,
-        kPaletteHalf,
-        kPaletteLast = kPaletteHalf,
-        kPaletteRandom
-    };
     enum Direction
     {
         kForward,
@@ -47,9 +36,8 @@ static bool LogicEffectFadeAndScroll(LogicEngineRenderer& r)
         int fs_index = 0;
         Type fs_scroll_type = kRandomType;
         Direction fs_dir = kRandomDirection;
-        Palette fs_palette = Palette(random(int(kPaletteLast) + 1));
+        LedRampPalette fs_palette = LedRampPalette(random(int(kLedRampLast) + 1));
         int* fs_height = NULL;
-        CRGB* fs_lut = NULL;
         int fs_lut_len = 0;
 
         FadeObject(LogicEngineRenderer& r)
@@ -61,71 +49,9 @@ static bool LogicEffectFadeAndScroll(LogicEngineRenderer& r)
                 fs_dir = Direction(random(int(kLastDirection) + 1));
             if (fs_scroll_type == kRandomType)
                 fs_scroll_type = Type(random(int(kTypeLast) + 1));
-            switch (fs_palette)
-            {
-                case kPaletteRGB:
-                    fs_lut = new CRGB[fs_lut_len = 1536];
-                    for (int i = 0; i < 256; i++)
-                    {
-                        fs_lut[i].setRGB(255, i, 0);
-                        fs_lut[i + 256].setRGB(255 - i, 255, 0);
-                        fs_lut[i + 512].setRGB(0, 255, i);
-                        fs_lut[i + 768].setRGB(0, 255 - i, 255);
-                        fs_lut[i + 1024].setRGB(i, 0, 255);
-                        fs_lut[i + 1280].setRGB(255, 0, 255 - i);
-                    }
-                    break;
-                case kPaletteRed:
-                    fs_lut = new CRGB[fs_lut_len = 512];
-                    for (int i = 0; i < 256; i++)
-                    {
-                        fs_lut[i].setRGB(i, 0, 0);
-                        fs_lut[i + 256].setRGB(255 - i, 0, 0);
-                    }
-                    break;
-                case kPaletteGreen:
-                    fs_lut = new CRGB[fs_lut_len = 512];
-                    for (int i = 0; i < 256; i++)
-                    {
-                        fs_lut[i + 0].setRGB(0, i, 0);
-                        fs_lut[i + 256].setRGB(0, 255 - i, 0);
-                    }
-                    break;
-                case kPaletteBlue:
-                    fs_lut = new CRGB[fs_lut_len = 512];
-                    for (int i = 0; i < 256; i++)
-                    {
-                        fs_lut[i + 0].setRGB(0, 0, i);
-                        fs_lut[i + 256].setRGB(0, 0, 255 - i);
-                    }
-                    break;
-                case kPaletteWhite:
-                    fs_lut = new CRGB[fs_lut_len = 512];
-                    for (int i = 0; i < 256; i++)
-                    {
-                        fs_lut[i + 0].setRGB(i, i, i);
-                        fs_lut[i + 256].setRGB(255 - i, 255 - i, 255 - i);
-                    }
-                    break;
-                case kPaletteHalf:
-                    fs_lut = new CRGB[fs_lut_len = 768];
-                    for (int i = 0; i < 128; i++)
-                    {
-                        fs_lut[i + 0].setRGB(254 - 2 * i, 0, 127 - i);
-                        fs_lut[i + 128].setRGB(i, 2 * i, 0);
-                        fs_lut[i + 256].setRGB(127 - i, 254 - 2 * i, 0);
-                        fs_lut[i + 384].setRGB(0, i, 2 * i);
-                        fs_lut[i + 512].setRGB(0, 127 - i, 254 - 2 * i);
-                        fs_lut[i + 640].setRGB(2 * i, 0, i);
-                    }
-                    break;
-                case kPaletteRandom:
-                    /* ignore */
-                    break;
-            }
-            if (fs_lut == nullptr && fs_palette != kPaletteRandom) return;
+            fs_lut_len = ledRampPaletteLength(fs_palette);
             fs_height = new int[w * h];
-            if (fs_height == nullptr) { delete[] fs_lut; fs_lut = nullptr; return; }
+            if (fs_height == nullptr) return;
             switch (fs_scroll_type)
             {
                 case kFlat:
@@ -246,8 +172,6 @@ static bool LogicEffectFadeAndScroll(LogicEngineRenderer& r)
 
         virtual ~FadeObject() override
         {
-            if (fs_lut != NULL)
-                delete[] fs_lut;
             if (fs_height != NULL)
                 delete[] fs_height;
         }
@@ -258,7 +182,7 @@ static bool LogicEffectFadeAndScroll(LogicEngineRenderer& r)
         r.setEffectObject(new FadeObject(r));
     }
     FadeObject* obj = (FadeObject*)r.getEffectObject();
-    if (obj == nullptr || obj->fs_height == nullptr || obj->fs_lut == nullptr) return true;
+    if (obj == nullptr || obj->fs_height == nullptr) return true;
     unsigned h = r.height();
     unsigned w = r.width();
 
@@ -273,8 +197,9 @@ static bool LogicEffectFadeAndScroll(LogicEngineRenderer& r)
                     obj->fs_height[obj->fs_index] = obj->fs_height[obj->fs_index] + obj->fs_speed;
                     if (obj->fs_height[obj->fs_index] > obj->fs_lut_len - 1)
                         obj->fs_height[obj->fs_index] = 0;
-                    CRGB color = obj->fs_lut[obj->fs_height[obj->fs_index]];
-                    r.setPixelRGB(x, y, color.r, color.g, color.b);
+                    uint8_t red, green, blue;
+                    ledRampPaletteSample(obj->fs_palette, obj->fs_height[obj->fs_index], red, green, blue);
+                    r.setPixelRGB(x, y, red, green, blue);
                 }
             }
             break;
@@ -287,8 +212,9 @@ static bool LogicEffectFadeAndScroll(LogicEngineRenderer& r)
                     obj->fs_height[obj->fs_index] = obj->fs_height[obj->fs_index] - obj->fs_speed;
                     if (obj->fs_height[obj->fs_index] < 0)
                         obj->fs_height[obj->fs_index] = obj->fs_lut_len - 1;
-                    CRGB color = obj->fs_lut[obj->fs_height[obj->fs_index]];
-                    r.setPixelRGB(x, y, color.r, color.g, color.b);
+                    uint8_t red, green, blue;
+                    ledRampPaletteSample(obj->fs_palette, obj->fs_height[obj->fs_index], red, green, blue);
+                    r.setPixelRGB(x, y, red, green, blue);
                 }
             }
             break;
@@ -6,49 +6,7 @@ static bool LogicEffectPlasma(LogicEngineRenderer& r)
         int plasma_step_width = 1;
         int plasma_cell_size_x = 3;
         int plasma_cell_size_y = 3;
-        uint8_t plasma_lut[1537][3];
         float plasma_counter = 0.0F;
-
-        PlasmaObject()
-        {
-            int i;
-            for (i = 0; i < 256; i++)
-            {
-                plasma_lut[i + 0][0] = 255;
-                plasma_lut[i + 0][1] = i;
-                plasma_lut[i + 0][2] = 0;
-            }
-            for (i = 0; i < 256; i++)
-            {
-                plasma_lut[i + 256][0] = 255 - i;
-                plasma_lut[i + 256][1] = 255;
-                plasma_lut[i + 256][2] = 0;
-            }
-            for (i = 0; i < 256; i++)
-            {
-                plasma_lut[i + 512][0] = 0;
-                plasma_lut[i + 512][1] = 255;
-                plasma_lut[i + 512][2] = i;
-            }
-            for (i = 0; i < 256; i++)
-            {
-                plasma_lut[i + 768][0] = 0;
-                plasma_lut[i + 768][1] = 255 - i;
-                plasma_lut[i + 768][2] = 255;
-            }
-            for (i = 0; i < 256; i++)
-            {
-                plasma_lut[i + 1024][0] = i;
-                plasma_lut[i + 1024][1] = 0;
-                plasma_lut[i + 1024][2] = 255;
-            }
-            for (i = 0; i < 256; i++)
-            {
-                plasma_lut[i + 1280][0] = 255;
-                plasma_lut[i + 1280][1] = 0;
-                plasma_lut[i + 1280][2] = 255 - i;
-            }
-        }
     };
 
     if (r.hasEffectChanged())
@@ -78,11 +36,9 @@ static bool LogicEffectPlasma(LogicEngineRenderer& r)
             int pixel = (int)((s1 + s2 + s3) / 3.0);
             if (pixel < 0) pixel = 0;
             if (pixel > 1536) pixel = 1536;
-            r.setPixelRGB(
-                x, y,
-                obj->plasma_lut[pixel][0],
-                obj->plasma_lut[pixel][1],
-                obj->plasma_lut[pixel][2]);
+            uint8_t red, green, blue;
+            ledPaletteWheel(uint16_t(pixel), red, green, blue);
+            r.setPixelRGB(x, y, red, green, blue);
         }
     }
     return true;
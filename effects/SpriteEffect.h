@@ -0,0 +1,73 @@
+static bool LogicEffectSprite(LogicEngineRenderer& r)
+{
+    class SpriteObject : public LogicEffectObject
+    {
+    public:
+        char name[LOGIC_SPRITE_MAX_NAME + 1] = "";
+        LogicSpriteHeader header = {};
+        uint8_t pixels[LOGIC_SPRITE_MAX_PIXELS];
+        uint16_t frame = 0;
+        uint16_t delayMs = 0;
+        uint32_t frameStartMs = 0;
+        bool drawn = false;
+        bool finished = false;
+
+        SpriteObject(const char* spriteName)
+        {
+            if (spriteName != nullptr)
+                strlcpy(name, spriteName, sizeof(name));
+        }
+    };
+
+    if (r.hasEffectChanged())
+    {
+        r.setEffectObject(new SpriteObject(logicSpriteBindingFor(&r)));
+        r.clear();
+    }
+    SpriteObject* obj = (SpriteObject*)r.getEffectObject();
+    if (obj == nullptr || obj->finished) return true;
+
+    uint32_t now = millis();
+    if (obj->drawn && (uint32_t)(now - obj->frameStartMs) < obj->delayMs) return true;
+
+    if (obj->drawn)
+    {
+        if (obj->frame + 1 < obj->header.frameCount)
+        {
+            obj->frame++;
+        }
+        else if (obj->header.flags & LOGIC_SPRITE_FLAG_LOOP)
+        {
+            obj->frame = 0;
+        }
+        else
+        {
+            // Hold the last frame until the sequence duration ends it.
+            obj->finished = true;
+            return true;
+        }
+    }
+    // Decoded from the RAM copy in LogicSpriteStore.h; the header comes back
+    // with the pixels so a replaced sprite is drawn consistently.
+    if (!logicSpriteReadFrame(obj->name, obj->frame, obj->header, obj->pixels, obj->delayMs))
+    {
+        obj->finished = true;
+        return true;
+    }
+    obj->frameStartMs = now;
+    obj->drawn = true;
+
+    // Sprites are drawn from the top-left corner and clipped to the display.
+    const LogicSpriteHeader& header = obj->header;
+    unsigned h = min((unsigned)r.height(), (unsigned)header.height);
+    unsigned w = min((unsigned)r.width(), (unsigned)header.width);
+    for (unsigned y = 0; y < h; y++)
+    {
+        for (unsigned x = 0; x < w; x++)
+        {
+            const uint8_t* rgb = header.palette[obj->pixels[y * header.width + x]];
+            r.setPixelRGB(x, y, rgb[0], rgb[1], rgb[2]);
+        }
+    }
+    return true;
+}
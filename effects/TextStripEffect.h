@@ -0,0 +1,48 @@
+static bool LogicEffectTextStrip(LogicEngineRenderer& r)
+{
+    class TextStripObject : public LogicEffectObject
+    {
+    public:
+        int offset;
+        uint32_t stepStartMs = 0;
+        bool drawn = false;
+
+        TextStripObject(int startOffset) :
+            offset(startOffset)
+        {
+        }
+    };
+
+    if (r.hasEffectChanged())
+    {
+        // Start with the text just off the right edge, like TEXTSCROLLLEFT.
+        r.setEffectObject(new TextStripObject(-int(r.width())));
+        r.clear();
+    }
+    TextStripObject* obj = (TextStripObject*)r.getEffectObject();
+    const LogicTextStrip* strip = logicTextStripFor(&r);
+    if (obj == nullptr || strip == nullptr || strip->columns == nullptr) return true;
+
+    uint32_t now = millis();
+    if (obj->drawn)
+    {
+        if ((uint32_t)(now - obj->stepStartMs) < strip->stepMs) return true;
+        if (++obj->offset >= int(strip->columnCount))
+            obj->offset = -int(r.width());
+    }
+    obj->stepStartMs = now;
+    obj->drawn = true;
+
+    const uint8_t red = strip->rgb[0];
+    const uint8_t green = strip->rgb[1];
+    const uint8_t blue = strip->rgb[2];
+    logicTextStripBlit(*strip, obj->offset, r.width(), r.height(),
+        [&r, red, green, blue](unsigned x, unsigned y, bool on)
+        {
+            if (on)
+                r.setPixelRGB(x, y, red, green, blue);
+            else
+                r.setPixelRGB(x, y, 0, 0, 0);
+        });
+    return true;
+}
@@ -0,0 +1,418 @@
+#!/usr/bin/env python3
+"""Stage data/ for the SPIFFS image with content-hashed, gzip-precompressed assets.
+
+`make buildfs` runs this before packing the filesystem. Pages are bundled
+first: the scripts every page loads become one core bundle, the stylesheet is
+inlined per page with unused rules dropped, and HTML/CSS/JS are minified
+(web_minify.py; --no-bundle skips this). Shared assets that a
+page references (style.css, app.js, images, ...) are renamed to
+name.<hash>.ext and every reference is rewritten, so the firmware can send
+them with a year-long immutable Cache-Control. Pages keep their names and
+revalidate against the build id in /webfs.id. Text files are stored only as
+.gz; the firmware sends them with Content-Encoding: gzip. /webfs.mf lists
+every stored file with its SHA-256 for per-file updates (web_asset_sync.py).
+
+Run with --report to compare first and repeat page loads against a host
+simulation of the firmware's static handler, or --report --host IP to measure
+a dome running a staged image.
+"""
+
+from __future__ import annotations
+
+import argparse
+import gzip
+import hashlib
+import http.client
+import re
+import shutil
+import sys
+import threading
+import time
+from http.server import BaseHTTPRequestHandler, ThreadingHTTPServer
+from pathlib import Path
+
+from web_minify import MinifyError, minify_css, minify_html, minify_js, parse_css, prune_css, render_css
+
+
+ROOT = Path(__file__).resolve().parents[1]
+DEFAULT_SOURCE = ROOT / "data"
+DEFAULT_OUTPUT = ROOT / ".pio" / "webfs"
+BUILD_ID_FILE = "webfs.id"
+# "<sha256> <size> <path>" per stored file; WebAssetManifest.h reads it and
+# tools/web_asset_sync.py diffs against it.
+MANIFEST_FILE = "webfs.mf"
+MANIFEST_MAX = 40   # WEB_ASSET_MANIFEST_MAX
+
+HASH_LEN = 8
+# SPIFFS_OBJ_NAME_LEN is 32 including the NUL terminator.
+SPIFFS_MAX_PATH = 31
+GZIP_TYPES = {".html", ".css", ".js", ".svg", ".json", ".txt"}
+PAGE_TYPES = {".html"}
+# Leaves first so a file's hash covers the rewritten names it references.
+HASH_ORDER = {".png": 0, ".ico": 0, ".svg": 0, ".css": 1, ".js": 2}
+CONTENT_TYPES = {
+    ".html": "text/html",
+    ".css": "text/css",
+    ".js": "application/javascript",
+    ".json": "application/json",
+    ".png": "image/png",
+    ".ico": "image/x-icon",
+    ".svg": "image/svg+xml",
+    ".txt": "text/plain",
+}
+IMMUTABLE = "public, max-age=31536000, immutable"
+HASHED_NAME = re.compile(r"\.[0-9a-f]{%d}\.[a-z0-9]+$" % HASH_LEN)
+
+
+class AssetError(ValueError):
+    pass
+
+
+def content_hash(data: bytes) -> str:
+    return hashlib.sha256(data).hexdigest()[:HASH_LEN]
+
+
+def hashed_name(name: str, data: bytes) -> str:
+    stem, dot, ext = name.rpartition(".")
+    return f"{stem}.{content_hash(data)}.{ext}" if dot else f"{name}.{content_hash(data)}"
+
+
+def gzip_bytes(data: bytes) -> bytes:
+    # mtime=0 keeps the output, and so the image, reproducible.
+    return gzip.compress(data, compresslevel=9, mtime=0)
+
+
+def reference_pattern(names: list[str]) -> re.Pattern:
+    alternatives = "|".join(re.escape(name) for name in sorted(names, key=len, reverse=True))
+    return re.compile(r"""(["'(])/(%s)(?=["')?#])""" % alternatives)
+
+
+def rewrite_references(text: str, renames: dict[str, str]) -> str:
+    if not renames:
+        return text
+    return reference_pattern(list(renames)).sub(
+        lambda m: f"{m.group(1)}/{renames[m.group(2)]}", text)
+
+
+def referenced_names(sources: dict[str, bytes]) -> set[str]:
+    text = "\n".join(data.decode("utf-8", "replace") for name, data in sources.items()
+                     if Path(name).suffix in GZIP_TYPES)
+    pattern = reference_pattern(list(sources))
+    return {m.group(2) for m in pattern.finditer(text)}
+
+
+# ---------------------------------------------------------------
+# Per-page bundling
+# ---------------------------------------------------------------
+
+CORE_BUNDLE = "core.js"
+SCRIPT_TAG = re.compile(r"""<script src="/([\w.-]+\.js)"></script>""")
+SCRIPT_RUN = re.compile(r"""(?:[ \t]*<script src="/[\w.-]+\.js"></script>\s*)+""")
+STYLESHEET_TAG = re.compile(r"""[ \t]*<link rel="stylesheet" href="/([\w.-]+\.css)">\n?""")
+
+
+def page_script_run(html: str) -> tuple[re.Match | None, list[str]]:
+    run = SCRIPT_RUN.search(html)
+    return run, (SCRIPT_TAG.findall(run.group(0)) if run else [])
+
+
+def bundle_pages(sources: dict[str, bytes]) -> dict[str, bytes]:
+    """Rewrites pages to load one shared core bundle and inline the rules of
+    each local stylesheet they use, then minifies every HTML/CSS/JS file.
+    Files that end up referenced by nothing are dropped."""
+    text = {name: data.decode("utf-8") for name, data in sources.items() if Path(name).suffix in GZIP_TYPES}
+    pages = sorted(name for name in text if Path(name).suffix in PAGE_TYPES)
+    if CORE_BUNDLE in sources:
+        raise AssetError(f"{CORE_BUNDLE} is reserved for the generated script bundle")
+
+    # Scripts every page loads first, in the same order, become core.js.
+    runs = {page: page_script_run(text[page])[1] for page in pages}
+    core: list[str] = []
+    loaded = [run for run in runs.values() if run]
+    if loaded:
+        for index, name in enumerate(loaded[0]):
+            if all(len(run) > index and run[index] == name for run in loaded) and name in text:
+                core.append(name)
+            else:
+                break
+    out = dict(sources)
+    consumed: set[str] = set()
+    if len(core) >= 2:
+        # A lone ';' keeps `})()` from running into the next file's `(function`.
+        bundle = "\n;".join(minify_js(text[name]).rstrip("\n") for name in core) + "\n"
+        out[CORE_BUNDLE] = bundle.encode("utf-8")
+        consumed.update(core)
+
+    for page in pages:
+        html = text[page]
+        run, scripts = page_script_run(html)
+        if run and len(core) >= 2 and len(loaded) == len(pages):
+            tags = [f'<script src="/{CORE_BUNDLE}"></script>']
+            tags += [f'<script src="/{name}"></script>' for name in scripts[len(core):]]
+            indent = run.group(0)[:len(run.group(0)) - len(run.group(0).lstrip(" \t"))]
+            html = html[:run.start()] + "".join(indent + tag + "\n" for tag in tags) + html[run.end():]
+        corpus = html + "".join(text.get(name, "") for name in scripts)
+
+        def inline(match: re.Match) -> str:
+            name = match.group(1)
+            if name not in text:
+                return match.group(0)
+            consumed.add(name)
+            rules = prune_css(parse_css(text[name]), STYLESHEET_TAG.sub("", corpus))
+            return f"<style>{render_css(rules)}</style>\n"
+
+        out[page] = STYLESHEET_TAG.sub(inline, html).encode("utf-8")
+
+    remaining = {name: data for name, data in out.items()
+                 if Path(name).suffix in GZIP_TYPES and name not in consumed}
+    still_referenced = referenced_names(remaining)
+    for name in consumed:
+        if name not in still_referenced:
+            del out[name]
+
+    minifiers = {".html": minify_html, ".css": minify_css, ".js": minify_js}
+    for name, data in out.items():
+        minify = minifiers.get(Path(name).suffix)
+        if minify:
+            try:
+                out[name] = minify(data.decode("utf-8")).encode("utf-8")
+            except MinifyError as exc:
+                raise AssetError(f"{name}: {exc}") from exc
+    return out
+
+
+def stage(source: Path, output: Path, bundle: bool = True) -> dict:
+    """Writes the staged tree; returns {"files": {served_path: stored_path}, "renames", "build_id"}."""
+    sources = {p.name: p.read_bytes() for p in sorted(source.iterdir()) if p.is_file()}
+    if not sources:
+        raise AssetError(f"no files in {source}")
+    if bundle:
+        sources = bundle_pages(sources)
+    referenced = referenced_names(sources)
+    hashable = sorted((name for name in referenced
+                       if Path(name).suffix not in PAGE_TYPES and Path(name).suffix in HASH_ORDER),
+                      key=lambda name: (HASH_ORDER[Path(name).suffix], name))
+
+    renames: dict[str, str] = {}
+    contents: dict[str, bytes] = {}
+    for name in hashable:
+        data = sources[name]
+        if Path(name).suffix in GZIP_TYPES:
+            data = rewrite_references(data.decode("utf-8"), renames).encode("utf-8")
+        renames[name] = hashed_name(name, data)
+        contents[renames[name]] = data
+    for name, data in sources.items():
+        if name in renames:
+            continue
+        if Path(name).suffix in GZIP_TYPES:
+            data = rewrite_references(data.decode("utf-8"), renames).encode("utf-8")
+        contents[name] = data
+
+    if len(contents) > MANIFEST_MAX:
+        raise AssetError(f"{len(contents)} files; the asset manifest holds {MANIFEST_MAX}")
+    if output.exists():
+        shutil.rmtree(output)
+    output.mkdir(parents=True)
+    files: dict[str, str] = {}
+    manifest: list[str] = []
+    build = hashlib.sha256()
+    for name in sorted(contents):
+        data = contents[name]
+        stored = name
+        if Path(name).suffix in GZIP_TYPES:
+            packed = gzip_bytes(data)
+            if len(packed) < len(data):
+                stored, data = name + ".gz", packed
+        if len("/" + stored) > SPIFFS_MAX_PATH:
+            raise AssetError(f"/{stored} is longer than the {SPIFFS_MAX_PATH}-character SPIFFS limit")
+        (output / stored).write_bytes(data)
+        files["/" + name] = "/" + stored
+        manifest.append(f"{hashlib.sha256(data).hexdigest()} {len(data)} /{stored}\n")
+        build.update(stored.encode("utf-8") + b"\0" + hashlib.sha256(data).digest())
+    build_id = build.hexdigest()[:HASH_LEN]
+    (output / BUILD_ID_FILE).write_text(build_id + "\n", encoding="ascii")
+    (output / MANIFEST_FILE).write_text("".join(manifest), encoding="ascii")
+    return {"files": files, "renames": renames, "build_id": build_id}
+
+
+# ---------------------------------------------------------------
+# Host simulation of handleStaticAsset() and the page-load report
+# ---------------------------------------------------------------
+
+def make_handler(root: Path, staged: bool):
+    build_id = (root / BUILD_ID_FILE).read_text().strip() if (root / BUILD_ID_FILE).exists() else ""
+
+    class Handler(BaseHTTPRequestHandler):
+        def log_message(self, *args) -> None:
+            pass
+
+        def do_GET(self) -> None:
+            path = self.path.split("?", 1)[0]
+            if path.endswith("/"):
+                path += "index.html"
+            raw = root / path.lstrip("/")
+            packed = root / (path.lstrip("/") + ".gz")
+            accepts_gzip = "gzip" in self.headers.get("Accept-Encoding", "")
+            use_gzip = packed.is_file() and (accepts_gzip or not raw.is_file())
+            file = packed if use_gzip else raw
+            if ".." in path or not file.is_file():
+                self.send_response(404)
+                self.send_header("Content-Length", "0")
+                self.end_headers()
+                return
+            headers = {"Content-Type": CONTENT_TYPES.get(Path(path).suffix, "text/plain")}
+            etag = ""
+            if staged:
+                match = HASHED_NAME.search(path)
+                if match:
+                    etag = '"' + match.group(0)[1:1 + HASH_LEN] + '"'
+                    headers["Cache-Control"] = IMMUTABLE
+                else:
+                    etag = f'"w{build_id}"' if build_id else ""
+                    headers["Cache-Control"] = "no-cache"
+                if etag:
+                    headers["ETag"] = etag
+            if etag and self.headers.get("If-None-Match") == etag:
+                self.send_response(304)
+                for key, value in headers.items():
+                    if key != "Content-Type":
+                        self.send_header(key, value)
+                self.send_header("Content-Length", "0")
+                self.end_headers()
+                return
+            body = file.read_bytes()
+            self.send_response(200)
+            for key, value in headers.items():
+                self.send_header(key, value)
+            if use_gzip:
+                self.send_header("Content-Encoding", "gzip")
+            self.send_header("Content-Length", str(len(body)))
+            self.end_headers()
+            self.wfile.write(body)
+
+    return Handler
+
+
+def serve(root: Path, staged: bool) -> ThreadingHTTPServer:
+    server = ThreadingHTTPServer(("127.0.0.1", 0), make_handler(root, staged))
+    threading.Thread(target=server.serve_forever, daemon=True).start()
+    return server
+
+
+class BrowserCache:
+    """Enough of a browser cache to replay a page load: immutable entries are
+    reused without a request, everything else revalidates with If-None-Match."""
+
+    def __init__(self) -> None:
+        self.entries: dict[str, tuple[str, bool]] = {}
+
+    def load(self, host: str, port: int, page: str) -> dict:
+        stats = {"requests": 0, "bytes": 0, "not_modified": 0, "ms": 0.0}
+        start = time.perf_counter()
+        body = self.fetch(host, port, page, stats)
+        text = gzip.decompress(body).decode("utf-8") if body[:2] == b"\x1f\x8b" else body.decode("utf-8")
+        refs = re.findall(r"""(?:src|href)=["'](/[^"'?#]+\.(?:css|js|png|svg))["']""", text)
+        for ref in dict.fromkeys(refs):
+            self.fetch(host, port, ref, stats)
+        stats["ms"] = (time.perf_counter() - start) * 1000.0
+        return stats
+
+    def fetch(self, host: str, port: int, path: str, stats: dict) -> bytes:
+        cached = self.entries.get(path)
+        if cached and cached[1]:
+            return b""
+        conn = http.client.HTTPConnection(host, port, timeout=10)
+        headers = {"Accept-Encoding": "gzip"}
+        if cached and cached[0]:
+            headers["If-None-Match"] = cached[0]
+        conn.request("GET", path, headers=headers)
+        response = conn.getresponse()
+        body = response.read()
+        head = sum(len(k) + len(v) + 4 for k, v in response.getheaders()) + 17
+        stats["requests"] += 1
+        stats["bytes"] += head + len(body)
+        if response.status == 304:
+            stats["not_modified"] += 1
+        elif response.status == 200:
+            immutable = "immutable" in (response.getheader("Cache-Control") or "")
+            self.entries[path] = (response.getheader("ETag") or "", immutable)
+        conn.close()
+        return body
+
+
+def page_loads(host: str, port: int, pages: list[str]) -> dict[str, tuple[dict, dict]]:
+    results = {}
+    for page in pages:
+        cache = BrowserCache()
+        results[page] = (cache.load(host, port, page), cache.load(host, port, page))
+    return results
+
+
+def report(source: Path, output: Path, host: str | None) -> int:
+    result = stage(source, output)
+    pages = sorted(p for p in result["files"] if p.endswith(".html"))
+    runs = []
+    if host:
+        target, _, port = host.partition(":")
+        runs.append(("device", page_loads(target, int(port or 80), pages)))
+    else:
+        unbundled = output.with_name(output.name + "-unbundled")
+        stage(source, unbundled, bundle=False)
+        servers = [("data/ as-is", serve(source, staged=False)),
+                   ("hashed+gzip", serve(unbundled, staged=True)),
+                   ("bundled", serve(output, staged=True))]
+        try:
+            for label, server in servers:
+                runs.append((label, page_loads("127.0.0.1", server.server_port, pages)))
+        finally:
+            for _, server in servers:
+                server.shutdown()
+            shutil.rmtree(unbundled, ignore_errors=True)
+
+    raw_total = sum(p.stat().st_size for p in source.iterdir() if p.is_file())
+    staged_total = sum(p.stat().st_size for p in output.iterdir() if p.is_file())
+    print(f"Static web assets ({'device ' + host if host else 'host simulation'})")
+    print(f"  SPIFFS payload: {raw_total} B in data/ -> {staged_total} B staged "
+          f"(build {result['build_id']}, {len(result['renames'])} hashed assets)")
+    print("  first page load (requests / bytes on air, cold cache)")
+    print(f"  {'page':<16}" + "".join(f"{label:>20}" for label, _ in runs))
+    totals = {label: [0, 0, 0, 0] for label, _ in runs}
+    for page in pages:
+        row = f"  {page:<16}"
+        for label, loads in runs:
+            first, repeat = loads[page]
+            row += f"{first['requests']:>6} / {first['bytes']:>9} B"
+            t = totals[label]
+            t[0] += first["requests"]; t[1] += first["bytes"]; t[2] += repeat["requests"]; t[3] += repeat["bytes"]
+        print(row)
+    for label, t in totals.items():
+        print(f"  {label}: first loads {t[0]} requests / {t[1]} B, repeat loads {t[2]} requests / {t[3]} B")
+    return 0
+
+
+def parse_args() -> argparse.Namespace:
+    parser = argparse.ArgumentParser(description="Stage data/ as a hashed, gzip-precompressed SPIFFS tree.")
+    parser.add_argument("--source", type=Path, default=DEFAULT_SOURCE)
+    parser.add_argument("--output", type=Path, default=DEFAULT_OUTPUT)
+    parser.add_argument("--no-bundle", action="store_true", help="hash and compress only; keep pages as written")
+    parser.add_argument("--report", action="store_true", help="compare page loads before and after staging")
+    parser.add_argument("--host", help="with --report, measure a dome at IP[:port] instead of the host simulation")
+    return parser.parse_args()
+
+
+def main() -> int:
+    args = parse_args()
+    try:
+        if args.report:
+            return report(args.source, args.output, args.host)
+        result = stage(args.source, args.output, bundle=not args.no_bundle)
+    except (AssetError, OSError, UnicodeDecodeError) as exc:
+        print(f"build_web_assets: {exc}", file=sys.stderr)
+        return 1
+    print(f"Staged {len(result['files'])} files into {args.output} "
+          f"(build {result['build_id']}, {len(result['renames'])} hashed assets)")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,257 @@
+#!/usr/bin/env python3
+"""Build and apply AstroPixelsPlus delta firmware patches (DeltaPatch.h format).
+
+A patch turns the firmware.bin the controller is running into a new one, so an
+OTA over the soft-AP moves the differences instead of the whole image:
+
+    python3 tools/firmware_delta.py make old/firmware.bin new/firmware.bin -o update.apd
+    python3 tools/http_ota_upload.py delta --file update.apd
+
+Format (little-endian; varints are unsigned LEB128):
+
+    "APD1"  u32 old_size  sha256(old)  u32 new_size  sha256(new)
+    ops...  0x00
+
+    0x01 COPY     varint src, varint len          new += old[src:src+len]
+    0x02 ADD      varint src, varint len, then     new += old[src:src+len] + diff
+                  (varint zero_run, varint count, count diff bytes)...
+                  until zero_run + count covers len
+    0x03 LITERAL  varint len, len bytes
+
+ADD is the bsdiff idea: code that moved keeps most bytes and changes a few
+(relocated addresses), so the diff against the old bytes is mostly zeros,
+which the zero-run encoding drops. The controller checks sha256(old) against
+its running partition before writing anything, and sha256(new) before
+committing the result.
+"""
+
+from __future__ import annotations
+
+import argparse
+import hashlib
+import struct
+import sys
+from pathlib import Path
+
+
+MAGIC = b"APD1"
+OP_END, OP_COPY, OP_ADD, OP_LITERAL = 0, 1, 2, 3
+ANCHOR = 8          # bytes that must match exactly to start a region
+INDEX_STEP = 4      # old positions indexed (firmware data is mostly 4-aligned)
+FUZZ_SLACK = 32     # stop extending once this far below the best score
+
+
+def varint(value: int) -> bytes:
+    out = bytearray()
+    while True:
+        byte = value & 0x7F
+        value >>= 7
+        if value:
+            out.append(byte | 0x80)
+        else:
+            out.append(byte)
+            return bytes(out)
+
+
+def read_varint(data: bytes, pos: int) -> tuple[int, int]:
+    value = shift = 0
+    while True:
+        if pos >= len(data):
+            raise ValueError("truncated varint")
+        byte = data[pos]
+        pos += 1
+        value |= (byte & 0x7F) << shift
+        if not byte & 0x80:
+            return value, pos
+        shift += 7
+        if shift > 28:
+            raise ValueError("varint too long")
+
+
+def build_index(old: bytes) -> dict[bytes, int]:
+    index: dict[bytes, int] = {}
+    for pos in range(0, len(old) - ANCHOR + 1, INDEX_STEP):
+        index.setdefault(old[pos:pos + ANCHOR], pos)
+    return index
+
+
+def extend(old: bytes, new: bytes, src: int, dst: int) -> tuple[int, int]:
+    """Fuzzy forward match as in bsdiff: the length maximising matches minus
+    mismatches. Returns (length, exact matches in it)."""
+    best_len = best_score = score = matched = best_matched = 0
+    limit = min(len(old) - src, len(new) - dst)
+    i = 0
+    while i < limit:
+        if old[src + i] == new[dst + i]:
+            score += 1
+            matched += 1
+        else:
+            score -= 1
+        i += 1
+        if score > best_score:
+            best_score, best_len, best_matched = score, i, matched
+        elif score < best_score - FUZZ_SLACK:
+            break
+    return best_len, best_matched
+
+
+def encode_add(old: bytes, new: bytes, src: int, dst: int, length: int) -> bytes:
+    out = bytearray()
+    i = 0
+    while i < length:
+        run = 0
+        while i + run < length and old[src + i + run] == new[dst + i + run]:
+            run += 1
+        i += run
+        start = i
+        # Keep short equal stretches inside the literal diff bytes; each
+        # segment header costs at least two bytes.
+        while i < length:
+            if old[src + i] == new[dst + i]:
+                tail = 0
+                while tail < 3 and i + tail < length and old[src + i + tail] == new[dst + i + tail]:
+                    tail += 1
+                if tail >= 3 or i + tail == length:
+                    break
+                i += tail
+                continue
+            i += 1
+        out += varint(run) + varint(i - start)
+        out += bytes((new[dst + k] - old[src + k]) & 0xFF for k in range(start, i))
+    return bytes(out)
+
+
+def make_patch(old: bytes, new: bytes) -> bytes:
+    index = build_index(old)
+    out = bytearray(MAGIC)
+    out += struct.pack("<I", len(old)) + hashlib.sha256(old).digest()
+    out += struct.pack("<I", len(new)) + hashlib.sha256(new).digest()
+
+    def flush_literal(start: int, end: int) -> None:
+        if end > start:
+            out.append(OP_LITERAL)
+            out.extend(varint(end - start) + new[start:end])
+
+    pos = literal_start = 0
+    shift = 0           # old - new offset of the last region
+    while pos + ANCHOR <= len(new):
+        anchor = new[pos:pos + ANCHOR]
+        src = pos + shift
+        if not (0 <= src <= len(old) - ANCHOR and old[src:src + ANCHOR] == anchor):
+            src = index.get(anchor, -1)
+        if src < 0:
+            pos += 1
+            continue
+        # Grow backwards into the pending literal while bytes match.
+        back = 0
+        while pos - back > literal_start and src - back > 0 and new[pos - back - 1] == old[src - back - 1]:
+            back += 1
+        dst, src = pos - back, src - back
+        length, matched = extend(old, new, src, dst)
+        if length < ANCHOR:
+            pos += 1
+            continue
+        flush_literal(literal_start, dst)
+        if matched == length:
+            out.append(OP_COPY)
+            out += varint(src) + varint(length)
+        else:
+            out.append(OP_ADD)
+            out += varint(src) + varint(length) + encode_add(old, new, src, dst, length)
+        shift = src - dst
+        pos = literal_start = dst + length
+    flush_literal(literal_start, len(new))
+    out.append(OP_END)
+    return bytes(out)
+
+
+def parse_header(patch: bytes) -> tuple[int, bytes, int, bytes]:
+    if len(patch) < 76 or patch[:4] != MAGIC:
+        raise ValueError("not an APD1 patch")
+    old_size = struct.unpack_from("<I", patch, 4)[0]
+    new_size = struct.unpack_from("<I", patch, 40)[0]
+    return old_size, patch[8:40], new_size, patch[44:76]
+
+
+def apply_patch(old: bytes, patch: bytes) -> bytes:
+    old_size, old_sha, new_size, new_sha = parse_header(patch)
+    if len(old) < old_size or hashlib.sha256(old[:old_size]).digest() != old_sha:
+        raise ValueError("base image does not match the patch")
+    new = bytearray()
+    pos = 76
+    while True:
+        if pos >= len(patch):
+            raise ValueError("truncated patch")
+        op = patch[pos]
+        pos += 1
+        if op == OP_END:
+            break
+        if op == OP_LITERAL:
+            length, pos = read_varint(patch, pos)
+            new += patch[pos:pos + length]
+            pos += length
+            continue
+        if op not in (OP_COPY, OP_ADD):
+            raise ValueError(f"bad op {op}")
+        src, pos = read_varint(patch, pos)
+        length, pos = read_varint(patch, pos)
+        if src + length > old_size:
+            raise ValueError("source range outside the base image")
+        if op == OP_COPY:
+            new += old[src:src + length]
+            continue
+        done = 0
+        while done < length:
+            run, pos = read_varint(patch, pos)
+            count, pos = read_varint(patch, pos)
+            new += old[src + done:src + done + run]
+            done += run
+            for k in range(count):
+                new.append((old[src + done + k] + patch[pos + k]) & 0xFF)
+            pos += count
+            done += count
+    if pos != len(patch):
+        raise ValueError("trailing data after end op")
+    if len(new) != new_size or hashlib.sha256(new).digest() != new_sha:
+        raise ValueError("patched image does not match the target digest")
+    return bytes(new)
+
+
+def parse_args(argv: list[str]) -> argparse.Namespace:
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    sub = parser.add_subparsers(dest="command", required=True)
+    make = sub.add_parser("make", help="build a patch from two firmware.bin files")
+    make.add_argument("old")
+    make.add_argument("new")
+    make.add_argument("-o", "--output", required=True)
+    apply = sub.add_parser("apply", help="apply a patch on the host (for checking)")
+    apply.add_argument("old")
+    apply.add_argument("patch")
+    apply.add_argument("-o", "--output", required=True)
+    return parser.parse_args(argv)
+
+
+def main(argv: list[str]) -> int:
+    args = parse_args(argv)
+    try:
+        if args.command == "make":
+            old = Path(args.old).read_bytes()
+            new = Path(args.new).read_bytes()
+            patch = make_patch(old, new)
+            apply_patch(old, patch)         # never ship a patch that does not round-trip
+            Path(args.output).write_bytes(patch)
+            print(f"{args.output}: {len(patch)} bytes for a {len(new)} byte image "
+                  f"({100 * len(patch) / max(len(new), 1):.1f} %)")
+            print(f"base sha256 {hashlib.sha256(old).hexdigest()}")
+        else:
+            new = apply_patch(Path(args.old).read_bytes(), Path(args.patch).read_bytes())
+            Path(args.output).write_bytes(new)
+            print(f"{args.output}: {len(new)} bytes, sha256 {hashlib.sha256(new).hexdigest()}")
+    except (OSError, ValueError) as exc:
+        print(f"error: {exc}", file=sys.stderr)
+        return 1
+    return 0
+
+
+if __name__ == "__main__":
+    raise SystemExit(main(sys.argv[1:]))
@@ -8,7 +8,9 @@ import difflib
 import json
 import math
 import re
+import struct
 import sys
+import zlib
 from pathlib import Path
 from typing import Any
 
@@ -16,6 +18,12 @@ from typing import Any
 ROOT = Path(__file__).resolve().parents[1]
 DEFAULT_TEMPLATE = ROOT / "templates/dome-layouts/mr-baddeley-complex-dome-mk4.json"
 DEFAULT_OUTPUT = ROOT / "GeneratedDomeLayout.h"
+# Panel servo slot order is owned by the firmware wiring table; the id index
+# maps layout ids onto it so runtime lookups need no string scans.
+PANEL_SLOT_SOURCE = ROOT / "WiringConfig.h"
+PANEL_SLOT_LABELS_RE = re.compile(
+    r"kPanelSlotLabels\[NUM_PANEL_SLOTS\]\s*=\s*\{(?P<body>.*?)\};", re.S
+)
 DEFAULT_TEMPLATE_ID = "mr-baddeley-complex-dome-mk4"
 DEFAULT_TEMPLATE_NAME = "Mr Baddeley Complex Dome MK4"
 DEFAULT_TEMPLATE_REVISION = 1
@@ -450,12 +458,99 @@ def emit_string_array(lines: list[str], name: str, values: list[str]) -> str:
     return name
 
 
-def render_header(template: dict[str, Any]) -> str:
+def load_panel_slot_labels(source: Path = PANEL_SLOT_SOURCE) -> list[str]:
+    match = PANEL_SLOT_LABELS_RE.search(source.read_text(encoding="utf-8"))
+    if not match:
+        raise ValidationError(f"kPanelSlotLabels not found in {source}")
+    return re.findall(r'"([^"]*)"', match.group("body"))
+
+
+def render_id_index(element_ids: list[str], panel_slot_labels: list[str]) -> list[str]:
+    """Sorted id -> (element index, panel slot) table plus its lookup helpers.
+
+    The element index doubles as the operator status index, which is keyed by
+    kElements order.
+    """
+    if len(element_ids) > 127:
+        raise ValidationError("id index stores element indices as int8_t")
+    unknown = [label for label in panel_slot_labels if label not in element_ids]
+    if unknown:
+        raise ValidationError(f"panel slots without layout elements: {', '.join(unknown)}")
+    # Byte order, matching strcmp() in the firmware lookup.
+    ordered = sorted(range(len(element_ids)), key=lambda i: element_ids[i].encode("utf-8"))
+    lines = [
+        "struct DomeLayoutIdIndexEntry {",
+        "    const char *id;",
+        "    int8_t elementIndex;",
+        "    int8_t panelSlot;",
+        "};",
+        "",
+        "// kElements ids in strcmp() order, for binary search.",
+        "static constexpr DomeLayoutIdIndexEntry kIdIndex[] = {",
+    ]
+    for index in ordered:
+        element_id = element_ids[index]
+        slot = panel_slot_labels.index(element_id) if element_id in panel_slot_labels else -1
+        lines.append(f"    {{ {cpp_string(element_id)}, {index}, {slot} }},")
+    lines.extend(
+        [
+            "};",
+            "",
+            "static constexpr size_t kIdIndexCount = sizeof(kIdIndex) / sizeof(kIdIndex[0]);",
+            "",
+            "// Panel servo slot -> kElements index (WiringConfig.h kPanelSlotLabels order).",
+            "static constexpr int8_t kPanelSlotElementIndex[] = {",
+        ]
+    )
+    for label in panel_slot_labels:
+        lines.append(f"    {element_ids.index(label)},  // {label}")
+    lines.extend(
+        [
+            "};",
+            "",
+            "static constexpr size_t kPanelSlotCount = "
+            "sizeof(kPanelSlotElementIndex) / sizeof(kPanelSlotElementIndex[0]);",
+            "",
+            "static inline const DomeLayoutIdIndexEntry *findId(const char *id) {",
+            "    if (!id) return nullptr;",
+            "    size_t lo = 0;",
+            "    size_t hi = kIdIndexCount;",
+            "    while (lo < hi) {",
+            "        size_t mid = (lo + hi) / 2;",
+            "        int cmp = strcmp(id, kIdIndex[mid].id);",
+            "        if (cmp == 0) return &kIdIndex[mid];",
+            "        if (cmp < 0) hi = mid;",
+            "        else lo = mid + 1;",
+            "    }",
+            "    return nullptr;",
+            "}",
+            "",
+            "static inline int elementIndexForId(const char *id) {",
+            "    const DomeLayoutIdIndexEntry *entry = findId(id);",
+            "    return entry ? entry->elementIndex : -1;",
+            "}",
+            "",
+            "static inline int panelSlotForId(const char *id) {",
+            "    const DomeLayoutIdIndexEntry *entry = findId(id);",
+            "    return entry ? entry->panelSlot : -1;",
+            "}",
+            "",
+        ]
+    )
+    return lines
+
+
+def render_header(
+    template: dict[str, Any], panel_slot_labels: list[str] | None = None
+) -> str:
+    if panel_slot_labels is None:
+        panel_slot_labels = load_panel_slot_labels()
     lines: list[str] = [
         "#pragma once",
         "",
         "#include <stddef.h>",
         "#include <stdint.h>",
+        "#include <string.h>",
         "",
         "// Generated by tools/generate_dome_layout_header.py.",
         "// Edit templates/dome-layouts/mr-baddeley-complex-dome-mk4.json instead.",
@@ -587,13 +682,171 @@ def render_header(template: dict[str, Any]) -> str:
             "",
             "static constexpr size_t kElementCount = sizeof(kElements) / sizeof(kElements[0]);",
             "",
-            "}  // namespace DomeLayout",
-            "",
         ]
     )
+    lines.extend(
+        render_id_index([element["id"] for element in template["elements"]], panel_slot_labels)
+    )
+    lines.extend(["}  // namespace DomeLayout", ""])
     return "\n".join(lines)
 
 
+# Compiled binary layout, byte-for-byte what DomeLayoutCompiled.h produces on
+# the controller. Strings and lists follow the raw template's document order,
+# so this walks the parsed JSON rather than the normalized template.
+COMPILED_MAGIC = b"APDL"
+COMPILED_VERSION = 1
+COMPILED_HEADER_BYTES = 60
+COMPILED_NULL = 0xFFFF
+COMPILED_ELEMENT_TYPES = ["panel", "holo", "logic", "psi"]
+COMPILED_PANEL_KINDS = [None, "ring", "pie", "fixed"]
+COMPILED_GEOMETRY_TYPES = ["svg_path", "circle", "ellipse", "point"]
+COMPILED_FLAG_IN_LAYOUT = 0x01
+COMPILED_FLAG_COMMANDABLE = 0x02
+COMPILED_FLAG_LABEL_ANCHOR = 0x04
+COMPILED_FLAG_CALLOUT = 0x08
+COMPILED_FLAG_CONNECTOR = 0x10
+
+
+class CompiledStrings:
+    def __init__(self) -> None:
+        self.data = bytearray()
+        self.offsets: dict[bytes, int] = {}
+
+    def intern(self, value: str | None) -> int:
+        if value is None:
+            return COMPILED_NULL
+        encoded = value.encode("utf-8")
+        if encoded not in self.offsets:
+            self.offsets[encoded] = len(self.data)
+            self.data += encoded + b"\0"
+        return self.offsets[encoded]
+
+
+def compile_element(
+    element: dict[str, Any], strings: CompiledStrings, refs: list[int], floats: list[float]
+) -> bytes:
+    ids = {"id": 0, "label": 0, "mounted_on": COMPILED_NULL, "d": COMPILED_NULL}
+    aliases: list[int] = []
+    capabilities: list[int] = []
+    for field, item in element.items():
+        if field in ("id", "label", "mounted_on"):
+            ids[field] = strings.intern(item)
+        elif field == "aliases":
+            aliases = [strings.intern(alias) for alias in item]
+        elif field == "capabilities":
+            capabilities = [strings.intern(capability) for capability in item]
+        elif field == "geometry" and "d" in item:
+            ids["d"] = strings.intern(item["d"])
+
+    flags = 0
+    if element["in_layout"]:
+        flags |= COMPILED_FLAG_IN_LAYOUT
+    if element["commandable"]:
+        flags |= COMPILED_FLAG_COMMANDABLE
+    element_floats: list[float] = []
+    geometry_type = 0xFF
+    geometry = element.get("geometry")
+    if geometry is not None:
+        geometry_type = COMPILED_GEOMETRY_TYPES.index(geometry["type"])
+        if geometry["type"] == "ellipse":
+            element_floats += [geometry["cx"], geometry["cy"], geometry["rx"],
+                               geometry["ry"], geometry.get("rotation", 0)]
+        elif geometry["type"] != "svg_path":
+            element_floats += [geometry["cx"], geometry["cy"], geometry.get("r", 6)]
+    if "label_anchor" in element:
+        flags |= COMPILED_FLAG_LABEL_ANCHOR
+        element_floats += [element["label_anchor"]["x"], element["label_anchor"]["y"]]
+    callout = element.get("callout")
+    if callout is not None:
+        flags |= COMPILED_FLAG_CALLOUT
+        element_floats += [callout["x"], callout["y"], callout["r"]]
+        if "connector_to" in callout:
+            flags |= COMPILED_FLAG_CONNECTOR
+            element_floats += [callout["connector_to"]["x"], callout["connector_to"]["y"]]
+
+    record = struct.pack(
+        "<7H6B",
+        ids["id"],
+        ids["label"],
+        ids["mounted_on"],
+        ids["d"],
+        element["render_order"],
+        len(refs),
+        len(floats),
+        len(aliases),
+        len(capabilities),
+        COMPILED_ELEMENT_TYPES.index(element["element_type"]),
+        COMPILED_PANEL_KINDS.index(element["panel_kind"]),
+        geometry_type,
+        flags,
+    )
+    refs += aliases + capabilities
+    floats += [float(number) for number in element_floats]
+    return record
+
+
+def compile_layout(raw: bytes) -> bytes:
+    data = json.loads(raw.decode("utf-8"))
+    validate_template(data)
+    strings = CompiledStrings()
+    header: dict[str, int] = {}
+    refs: list[int] = []
+    floats: list[float] = []
+    records: list[tuple[tuple[int, bytes], bytes]] = []
+
+    for key, value in data.items():
+        if key in ("template_id", "template_name", "model", "source"):
+            header[key] = strings.intern(value)
+        elif key == "coordinate_space":
+            header["viewBox"] = strings.intern(value["viewBox"])
+        elif key == "elements":
+            for element in value:
+                record = compile_element(element, strings, refs, floats)
+                sort_key = (element["render_order"], element["id"].encode("utf-8"))
+                records.append((sort_key, record))
+
+    records.sort(key=lambda item: item[0])
+    strings_offset = COMPILED_HEADER_BYTES
+    refs_offset = strings_offset + len(strings.data)
+    floats_offset = refs_offset + 2 * len(refs)
+    records_offset = floats_offset + 4 * len(floats)
+    body = (
+        bytes(strings.data)
+        + struct.pack(f"<{len(refs)}H", *refs)
+        + struct.pack(f"<{len(floats)}f", *floats)
+        + b"".join(record for _, record in records)
+    )
+
+    def pack_header(crc: int) -> bytes:
+        return COMPILED_MAGIC + struct.pack(
+            "<BBHHH6H9I",
+            COMPILED_VERSION,
+            0,
+            len(records),
+            data["schema_revision"],
+            data["template_revision"],
+            header["template_id"],
+            header["template_name"],
+            header.get("model", COMPILED_NULL),
+            header.get("source", COMPILED_NULL),
+            header["viewBox"],
+            len(refs),
+            strings_offset,
+            len(strings.data),
+            refs_offset,
+            floats_offset,
+            len(floats),
+            records_offset,
+            len(raw),
+            zlib.crc32(raw),
+            crc,
+        )
+
+    crc = zlib.crc32(pack_header(0) + body)
+    return pack_header(crc) + body
+
+
 def load_and_validate(
     template_path: Path, *, enforce_default_identity: bool = False
 ) -> dict[str, Any]:
@@ -613,6 +866,11 @@ def parse_args() -> argparse.Namespace:
     )
     parser.add_argument("--template", type=Path, default=DEFAULT_TEMPLATE)
     parser.add_argument("--output", type=Path, default=DEFAULT_OUTPUT)
+    parser.add_argument(
+        "--compiled-output",
+        type=Path,
+        help="Write the compiled binary layout (.apdl) for --template instead of the header",
+    )
     parser.add_argument(
         "--check",
         action="store_true",
@@ -624,6 +882,11 @@ def parse_args() -> argparse.Namespace:
 def main() -> int:
     args = parse_args()
     try:
+        if args.compiled_output:
+            compiled = compile_layout(args.template.read_bytes())
+            args.compiled_output.write_bytes(compiled)
+            print(f"compiled {args.compiled_output} ({len(compiled)} bytes)")
+            return 0
         rendered = load_and_render(args.template)
         if args.check:
             existing = args.output.read_text(encoding="utf-8")
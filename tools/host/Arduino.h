@@ -0,0 +1,92 @@
+#pragma once
+// tools/host/Arduino.h — just enough of the Arduino core for host tests.
+//
+// Some firmware headers (DomeElementStatus.h) keep their logic next to
+// String and FreeRTOS calls. Test harnesses add tools/host to the include
+// path ahead of the repo root so those headers compile unchanged with g++.
+// Only what those headers use is here. millis(), esp_random() and malloc()
+// are driven by the test through the host* variables.
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <string>
+
+static uint32_t hostMillis = 0;
+static uint32_t hostRandom = 0x12345678;
+static int hostMallocFailAfter = -1;    // malloc() calls that succeed before one fails
+
+static inline uint32_t millis() { return hostMillis; }
+static inline uint32_t micros() { return hostMillis * 1000; }
+static inline uint32_t esp_random() { return hostRandom; }
+
+static inline void *hostMalloc(size_t len)
+{
+    if (hostMallocFailAfter == 0)
+    {
+        hostMallocFailAfter = -1;
+        return nullptr;
+    }
+    if (hostMallocFailAfter > 0) hostMallocFailAfter--;
+    return ::malloc(len);
+}
+#define malloc hostMalloc
+
+typedef int portMUX_TYPE;
+#define portMUX_INITIALIZER_UNLOCKED 0
+#define portENTER_CRITICAL(mux) ((void)(mux))
+#define portEXIT_CRITICAL(mux) ((void)(mux))
+
+class String
+{
+public:
+    String(const char *text = "") : fText(text ? text : "") {}
+    String(const std::string &text) : fText(text) {}
+    explicit String(char c) : fText(1, c) {}
+    explicit String(int value) : fText(std::to_string(value)) {}
+    explicit String(unsigned value) : fText(std::to_string(value)) {}
+    explicit String(long value) : fText(std::to_string(value)) {}
+    explicit String(unsigned long value) : fText(std::to_string(value)) {}
+
+    const char *c_str() const { return fText.c_str(); }
+    size_t length() const { return fText.size(); }
+    void reserve(size_t len) { fText.reserve(len); }
+    char operator[](size_t i) const { return i < fText.size() ? fText[i] : '\0'; }
+
+    String substring(size_t from) const { return from < fText.size() ? fText.substr(from) : std::string(); }
+
+    void trim()
+    {
+        size_t start = 0;
+        size_t end = fText.size();
+        while (start < end && isspace((unsigned char)fText[start])) start++;
+        while (end > start && isspace((unsigned char)fText[end - 1])) end--;
+        fText = fText.substr(start, end - start);
+    }
+
+    String &operator+=(const String &other) { fText += other.fText; return *this; }
+    String &operator+=(const char *text) { fText += text; return *this; }
+    String &operator+=(char c) { fText += c; return *this; }
+    String &operator+=(int value) { fText += std::to_string(value); return *this; }
+    String &operator+=(unsigned value) { fText += std::to_string(value); return *this; }
+    String &operator+=(long value) { fText += std::to_string(value); return *this; }
+    String &operator+=(unsigned long value) { fText += std::to_string(value); return *this; }
+
+    bool operator==(const String &other) const { return fText == other.fText; }
+    bool operator==(const char *text) const { return fText == text; }
+    bool operator!=(const String &other) const { return fText != other.fText; }
+
+    friend String operator+(String lhs, const String &rhs) { lhs += rhs; return lhs; }
+    friend String operator+(String lhs, const char *rhs) { lhs += rhs; return lhs; }
+    friend String operator+(String lhs, char rhs) { lhs += rhs; return lhs; }
+    friend String operator+(String lhs, int rhs) { lhs += rhs; return lhs; }
+    friend String operator+(String lhs, unsigned rhs) { lhs += rhs; return lhs; }
+    friend String operator+(String lhs, unsigned long rhs) { lhs += rhs; return lhs; }
+    friend String operator+(const char *lhs, const String &rhs) { return String(lhs) + rhs; }
+
+private:
+    std::string fText;
+};
@@ -0,0 +1,68 @@
+#pragma once
+// tools/host/Preferences.h — in-memory NVS for host tests (see Arduino.h).
+//
+// Every Preferences object shares one store keyed "namespace/key", so a
+// harness can save, then load again as after a reboot.
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "Arduino.h"
+
+static std::map<std::string, std::vector<uint8_t> > hostNvs;
+
+class Preferences
+{
+public:
+    bool begin(const char *ns, bool readOnly = false)
+    {
+        fNs = ns;
+        fReadOnly = readOnly;
+        return true;
+    }
+
+    void end() {}
+
+    bool isKey(const char *key) const { return hostNvs.count(path(key)) != 0; }
+
+    size_t getBytesLength(const char *key) const
+    {
+        auto it = hostNvs.find(path(key));
+        return it == hostNvs.end() ? 0 : it->second.size();
+    }
+
+    size_t getBytes(const char *key, void *buf, size_t len) const
+    {
+        auto it = hostNvs.find(path(key));
+        if (it == hostNvs.end() || it->second.size() > len) return 0;
+        memcpy(buf, it->second.data(), it->second.size());
+        return it->second.size();
+    }
+
+    size_t putBytes(const char *key, const void *buf, size_t len)
+    {
+        if (fReadOnly) return 0;
+        const uint8_t *bytes = (const uint8_t *)buf;
+        hostNvs[path(key)] = std::vector<uint8_t>(bytes, bytes + len);
+        return len;
+    }
+
+    bool remove(const char *key)
+    {
+        return !fReadOnly && hostNvs.erase(path(key)) != 0;
+    }
+
+    // Legacy per-element keys are only read by the migration path; the host
+    // store never holds them.
+    int32_t getInt(const char *, int32_t fallback = 0) const { return fallback; }
+    uint32_t getULong(const char *, uint32_t fallback = 0) const { return fallback; }
+    bool getBool(const char *, bool fallback = false) const { return fallback; }
+    String getString(const char *, const String &fallback = String()) const { return fallback; }
+
+private:
+    std::string path(const char *key) const { return fNs + "/" + key; }
+
+    std::string fNs;
+    bool fReadOnly = false;
+};
@@ -0,0 +1,99 @@
+#!/usr/bin/env python3
+"""Shared plumbing for the host tests that compile a firmware header with g++.
+
+Each tools/test_*.py that exercises a host-compilable header embeds a small
+C++ harness, builds it once per test class and drives it through argv/stdin.
+This module holds the parts every one of those files needs: the compiler
+invocation, the skip when g++ is missing, and the temporary build directory
+used by both the unittest classes and the --report entry points.
+"""
+
+from __future__ import annotations
+
+import shutil
+import subprocess
+import tempfile
+import unittest
+from contextlib import contextmanager
+from pathlib import Path
+from typing import Iterator, Sequence
+
+
+ROOT = Path(__file__).resolve().parents[1]
+HOST_SHIMS = ROOT / "tools" / "host"
+
+CXXFLAGS = ["-std=gnu++11", "-O2", "-Wall"]
+
+
+def have_gxx() -> bool:
+    return shutil.which("g++") is not None
+
+
+def compile_harness(workdir: Path, name: str, source: str, *,
+                    flags: Sequence[str] = (), includes: Sequence[Path] = (),
+                    host_shims: bool = False, link: bool = True) -> Path:
+    """Build `source` as workdir/name and return the binary.
+
+    host_shims puts tools/host (Arduino.h, Preferences.h) ahead of the repo
+    root. With link=False the object file is returned instead, for tests
+    that inspect what the compiler emitted.
+    """
+    cpp = workdir / f"{name}.cpp"
+    cpp.write_text(source, encoding="utf-8")
+    args = ["g++"] + CXXFLAGS + list(flags)
+    if host_shims:
+        args += ["-I", str(HOST_SHIMS)]
+    args += ["-I", str(ROOT)]
+    for path in includes:
+        args += ["-I", str(path)]
+    if not link:
+        obj = workdir / f"{name}.o"
+        subprocess.run(args + ["-c", str(cpp), "-o", str(obj)], check=True)
+        return obj
+    binary = workdir / name
+    subprocess.run(args + [str(cpp), "-o", str(binary)], check=True)
+    return binary
+
+
+def run_harness(binary: Path, *args: str, stdin: str | None = None) -> list[str]:
+    out = subprocess.run([str(binary)] + list(args), input=stdin, check=True,
+                         capture_output=True, text=True).stdout
+    return out.splitlines()
+
+
+class HarnessTestCase(unittest.TestCase):
+    """Builds cls.build(workdir) once per class into cls.binary.
+
+    Subclasses either set HARNESS_NAME/HARNESS or override build(). The
+    whole class is skipped when g++ is not installed.
+    """
+
+    HARNESS_NAME = ""
+    HARNESS = ""
+    workdir: Path
+    binary: Path
+
+    @classmethod
+    def build(cls, workdir: Path) -> Path:
+        return compile_harness(workdir, cls.HARNESS_NAME, cls.HARNESS)
+
+    @classmethod
+    def setUpClass(cls) -> None:
+        if not have_gxx():
+            raise unittest.SkipTest(f"g++ not available for {cls.__name__}")
+        cls._tmp = tempfile.TemporaryDirectory()
+        cls.workdir = Path(cls._tmp.name)
+        cls.binary = cls.build(cls.workdir)
+
+    @classmethod
+    def tearDownClass(cls) -> None:
+        cls._tmp.cleanup()
+
+
+@contextmanager
+def report_workdir() -> Iterator[Path]:
+    """Temporary build directory for a --report run; exits 1 without g++."""
+    if not have_gxx():
+        raise SystemExit("g++ not available")
+    with tempfile.TemporaryDirectory() as tmp:
+        yield Path(tmp)
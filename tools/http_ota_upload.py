@@ -1,9 +1,21 @@
 #!/usr/bin/env python3
-"""Upload AstroPixelsPlus firmware/SPIFFS images through the web OTA API."""
+"""Upload AstroPixelsPlus firmware/SPIFFS images through the web OTA API.
+
+Firmware uploads carry the image size and SHA-256; the controller checks the
+digest before committing the image. If the connection drops mid-upload, the
+tool reads the received offset from /api/ota/status and sends the rest
+(--resume-retries). --drop-after cuts the first attempt short to exercise that
+path.
+
+"delta" uploads a patch from tools/firmware_delta.py; the controller applies
+it against the running image and checks the new image's digest itself.
+"""
 
 from __future__ import annotations
 
 import argparse
+import hashlib
+import http.client
 import json
 import mimetypes
 import os
@@ -20,14 +32,24 @@ KINDS = {
         "endpoint": "/upload/firmware",
         "field": "firmware",
         "probe": "/api/health",
+        "resumable": True,
+    },
+    "delta": {
+        "endpoint": "/upload/firmware-delta",
+        "field": "patch",
+        "probe": "/api/health",
+        "resumable": False,
     },
     "filesystem": {
         "endpoint": "/upload/filesystem",
         "field": "filesystem",
         "probe": "/api/health",
+        "resumable": False,
     },
 }
 
+STATUS_PATH = "/api/ota/status"
+
 
 def normalize_base_url(host: str) -> str:
     if "://" not in host:
@@ -38,13 +60,9 @@ def normalize_base_url(host: str) -> str:
     return host.rstrip("/")
 
 
-def multipart_body(field: str, path: str) -> tuple[bytes, str]:
+def multipart_body(field: str, filename: str, payload: bytes) -> tuple[bytes, str]:
     boundary = "----AstroPixelsPlusOTA" + uuid.uuid4().hex
-    filename = os.path.basename(path)
     content_type = mimetypes.guess_type(filename)[0] or "application/octet-stream"
-    with open(path, "rb") as f:
-        payload = f.read()
-
     head = (
         f"--{boundary}\r\n"
         f'Content-Disposition: form-data; name="{field}"; filename="{filename}"\r\n'
@@ -63,10 +81,7 @@ def decode_response(data: bytes) -> dict:
         return {"raw": data.decode("utf-8", errors="replace")}
 
 
-def upload(base_url: str, kind: str, path: str, timeout: float) -> None:
-    meta = KINDS[kind]
-    body, boundary = multipart_body(meta["field"], path)
-    url = base_url + meta["endpoint"]
+def post(url: str, body: bytes, boundary: str, timeout: float) -> tuple[int, dict]:
     req = urllib.request.Request(
         url,
         data=body,
@@ -76,25 +91,104 @@ def upload(base_url: str, kind: str, path: str, timeout: float) -> None:
             "Content-Length": str(len(body)),
         },
     )
-
-    print(f"Uploading {kind} image: {path} ({os.path.getsize(path)} bytes)")
-    print(f"POST {url}")
     try:
         with urllib.request.urlopen(req, timeout=timeout) as resp:
-            status = resp.status
-            payload = decode_response(resp.read())
+            return resp.status, decode_response(resp.read())
     except urllib.error.HTTPError as exc:
-        payload = decode_response(exc.read())
-        error = payload.get("error") or payload.get("raw") or exc.reason
-        raise RuntimeError(f"upload rejected with HTTP {exc.code}: {error}") from exc
-    except urllib.error.URLError as exc:
-        raise RuntimeError(f"upload failed: {exc.reason}") from exc
+        return exc.code, decode_response(exc.read())
+
+
+def post_truncated(url: str, body: bytes, boundary: str, send_bytes: int, timeout: float) -> None:
+    """Declare the full body, send only part of it, then drop the connection."""
+    parsed = urllib.parse.urlparse(url)
+    conn = http.client.HTTPConnection(parsed.hostname, parsed.port or 80, timeout=timeout)
+    try:
+        conn.putrequest("POST", parsed.path + ("?" + parsed.query if parsed.query else ""))
+        conn.putheader("Content-Type", f"multipart/form-data; boundary={boundary}")
+        conn.putheader("Content-Length", str(len(body)))
+        conn.endheaders()
+        conn.send(body[:send_bytes])
+    finally:
+        conn.close()
+
 
-    if status != 200 or payload.get("ok") is not True:
-        error = payload.get("error") or payload.get("raw") or f"unexpected response {payload!r}"
-        raise RuntimeError(f"upload failed with HTTP {status}: {error}")
+def ota_status(base_url: str, timeout: float) -> dict:
+    with urllib.request.urlopen(base_url + STATUS_PATH, timeout=timeout) as resp:
+        return decode_response(resp.read())
 
-    print("Upload accepted; controller should reboot shortly.")
+
+def upload(base_url: str, kind: str, path: str, timeout: float,
+           resume_retries: int = 3, drop_after: int = 0) -> None:
+    meta = KINDS[kind]
+    filename = os.path.basename(path)
+    with open(path, "rb") as f:
+        payload = f.read()
+    url = base_url + meta["endpoint"]
+    digest = hashlib.sha256(payload).hexdigest()
+
+    print(f"Uploading {kind} image: {path} ({len(payload)} bytes)")
+    if meta["resumable"]:
+        print(f"sha256 {digest}")
+    print(f"POST {url}")
+
+    offset = 0
+    attempts = 0
+    while True:
+        query = ""
+        if meta["resumable"]:
+            query = "?" + urllib.parse.urlencode(
+                {"size": len(payload), "sha256": digest, **({"offset": offset} if offset else {})})
+        body, boundary = multipart_body(meta["field"], filename, payload[offset:])
+        started = time.monotonic()
+        try:
+            if drop_after and attempts == 0:
+                head_len = body.index(b"\r\n\r\n") + 4
+                post_truncated(url + query, body, boundary, head_len + drop_after, timeout)
+                raise ConnectionError(f"connection dropped after {drop_after} bytes (--drop-after)")
+            status, response = post(url + query, body, boundary, timeout)
+        except (urllib.error.URLError, ConnectionError, TimeoutError, http.client.HTTPException) as exc:
+            reason = getattr(exc, "reason", exc)
+            attempts += 1
+            if not meta["resumable"] or attempts > resume_retries:
+                raise RuntimeError(f"upload failed: {reason}") from exc
+            time.sleep(0.5)
+            try:
+                state = ota_status(base_url, timeout=5)
+            except (urllib.error.URLError, TimeoutError) as status_exc:
+                raise RuntimeError(f"upload failed: {reason}; status unavailable") from status_exc
+            if not state.get("active"):
+                raise RuntimeError(f"upload failed: {reason}; controller has no session to resume")
+            offset = int(state.get("offset", 0))
+            print(f"Upload interrupted ({reason}); resuming at byte {offset}")
+            continue
+
+        if status == 409 and meta["resumable"] and "offset" in response and attempts < resume_retries:
+            attempts += 1
+            offset = int(response["offset"])
+            print(f"Controller is at byte {offset}; resuming there")
+            continue
+        if status == 503 and "retry" in str(response.get("error", "")) and attempts < resume_retries:
+            # Delta: the controller is still hashing its running image after boot.
+            attempts += 1
+            print("Controller is still hashing its running firmware; retrying in 2 s")
+            time.sleep(2)
+            continue
+        if status != 200 or response.get("ok") is not True:
+            error = response.get("error") or response.get("raw") or f"unexpected response {response!r}"
+            raise RuntimeError(f"upload rejected with HTTP {status}: {error}")
+        break
+
+    elapsed = time.monotonic() - started
+    sent = len(payload) - offset
+    print(f"Upload accepted; {sent} bytes in last request, {sent / 1024 / max(elapsed, 0.001):.1f} KB/s.")
+    if meta["resumable"]:
+        try:
+            state = ota_status(base_url, timeout=3)
+            print(f"Controller: {state.get('kbps', 0)} KB/s, {state.get('stall_ms', 0)} ms stalled, "
+                  f"{state.get('resumes', 0)} resumes")
+        except (urllib.error.URLError, TimeoutError):
+            pass
+    print("Controller should reboot shortly.")
 
 
 def wait_for_controller(base_url: str, probe_path: str, timeout: float) -> None:
@@ -127,6 +221,10 @@ def parse_args(argv: list[str]) -> argparse.Namespace:
                         help="time to wait for /api/health after upload")
     parser.add_argument("--no-wait", action="store_true",
                         help="do not wait for controller to come back online")
+    parser.add_argument("--resume-retries", type=int, default=3,
+                        help="times to resume an interrupted firmware upload (default: 3)")
+    parser.add_argument("--drop-after", type=int, default=0, metavar="BYTES",
+                        help="testing: drop the first firmware attempt after BYTES of image data")
     return parser.parse_args(argv)
 
 
@@ -138,7 +236,7 @@ def main(argv: list[str]) -> int:
 
     try:
         base_url = normalize_base_url(args.host)
-        upload(base_url, args.kind, args.file, args.upload_timeout)
+        upload(base_url, args.kind, args.file, args.upload_timeout, args.resume_retries, args.drop_after)
         if not args.no_wait:
             wait_for_controller(base_url, KINDS[args.kind]["probe"], args.reboot_timeout)
     except Exception as exc:
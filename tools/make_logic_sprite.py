@@ -0,0 +1,156 @@
+#!/usr/bin/env python3
+"""Build or inspect logic sprite animations (.lsa) for LogicSpriteStore.h.
+
+Input is a small JSON description so show designers can draw frames as text:
+
+    {
+      "width": 8, "height": 5, "loop": true, "delay_ms": 120,
+      "palette": {".": "#000000", "R": "#ff0000", "B": "#0040ff"},
+      "frames": [
+        {"rows": ["R.......", ".R......", "..R.....", "...R....", "....R..."]},
+        {"rows": ["B.......", ".B......", "..B.....", "...B....", "....B..."], "delay_ms": 300}
+      ]
+    }
+
+Usage:
+    python3 tools/make_logic_sprite.py build sweep.json -o sweep.lsa
+    python3 tools/make_logic_sprite.py info sweep.lsa
+    curl -X POST --data-binary @sweep.lsa "http://<dome>/api/sprites?name=sweep"
+"""
+
+from __future__ import annotations
+
+import argparse
+import json
+import struct
+import sys
+from pathlib import Path
+
+MAGIC = b"APSA"
+VERSION = 1
+HEADER = struct.Struct("<4sBBBBHBBHH")
+FRAME_ENTRY = struct.Struct("<IHH")
+FLAG_LOOP = 0x01
+MAX_BYTES = 16384
+MAX_PIXELS = 256
+MAX_PALETTE = 16
+MAX_FRAMES = 255
+
+
+class SpriteError(ValueError):
+    pass
+
+
+def parse_colour(value: str) -> tuple[int, int, int]:
+    text = value.lstrip("#")
+    if len(text) != 6:
+        raise SpriteError(f"colour {value!r} must be #rrggbb")
+    return tuple(int(text[i:i + 2], 16) for i in (0, 2, 4))  # type: ignore[return-value]
+
+
+def rle_encode(indices: list[int]) -> bytes:
+    out = bytearray()
+    i = 0
+    while i < len(indices):
+        run = 1
+        while i + run < len(indices) and run < 256 and indices[i + run] == indices[i]:
+            run += 1
+        out += bytes((run - 1, indices[i]))
+        i += run
+    return bytes(out)
+
+
+def rle_decode(data: bytes, palette_count: int, pixel_count: int) -> list[int]:
+    if len(data) % 2:
+        raise SpriteError("odd RLE length")
+    out: list[int] = []
+    for i in range(0, len(data), 2):
+        run, index = data[i] + 1, data[i + 1]
+        if index >= palette_count or len(out) + run > pixel_count:
+            raise SpriteError("RLE run out of range")
+        out.extend([index] * run)
+    if len(out) != pixel_count:
+        raise SpriteError("frame does not cover every pixel")
+    return out
+
+
+def build(spec: dict) -> bytes:
+    width, height = int(spec["width"]), int(spec["height"])
+    if width <= 0 or height <= 0 or width * height > MAX_PIXELS:
+        raise SpriteError(f"geometry {width}x{height} exceeds {MAX_PIXELS} pixels")
+    legend = list(spec["palette"].items())
+    if not 0 < len(legend) <= MAX_PALETTE:
+        raise SpriteError(f"palette must have 1-{MAX_PALETTE} entries")
+    index_of = {char: i for i, (char, _) in enumerate(legend)}
+    frames = spec["frames"]
+    if not 0 < len(frames) <= MAX_FRAMES:
+        raise SpriteError(f"sprite must have 1-{MAX_FRAMES} frames")
+
+    encoded = []
+    for n, frame in enumerate(frames):
+        rows = frame["rows"]
+        if len(rows) != height or any(len(row) != width for row in rows):
+            raise SpriteError(f"frame {n} is not {width}x{height}")
+        try:
+            indices = [index_of[ch] for row in rows for ch in row]
+        except KeyError as exc:
+            raise SpriteError(f"frame {n} uses undefined palette key {exc}") from None
+        encoded.append((rle_encode(indices), int(frame.get("delay_ms", 0))))
+
+    flags = FLAG_LOOP if spec.get("loop", True) else 0
+    header = HEADER.pack(MAGIC, VERSION, width, height, len(legend), len(frames), flags, 0,
+                         int(spec.get("delay_ms", 100)), 0)
+    palette = b"".join(bytes(parse_colour(colour)) for _, colour in legend)
+    data_offset = len(header) + len(palette) + FRAME_ENTRY.size * len(encoded)
+    table = bytearray()
+    payload = bytearray()
+    for rle, delay in encoded:
+        table += FRAME_ENTRY.pack(data_offset + len(payload), len(rle), delay)
+        payload += rle
+    blob = header + palette + bytes(table) + bytes(payload)
+    if len(blob) > MAX_BYTES:
+        raise SpriteError(f"sprite is {len(blob)} bytes, limit is {MAX_BYTES}")
+    return blob
+
+
+def inspect(blob: bytes) -> dict:
+    magic, version, width, height, pal, frames, flags, _, delay, _ = HEADER.unpack_from(blob)
+    if magic != MAGIC or version != VERSION:
+        raise SpriteError("not a version 1 logic sprite")
+    table = HEADER.size + pal * 3
+    for f in range(frames):
+        offset, length, _ = FRAME_ENTRY.unpack_from(blob, table + f * FRAME_ENTRY.size)
+        rle_decode(blob[offset:offset + length], pal, width * height)
+    raw = width * height * 3 * frames
+    return {
+        "width": width, "height": height, "palette": pal, "frames": frames,
+        "loop": bool(flags & FLAG_LOOP), "delay_ms": delay,
+        "bytes": len(blob), "raw_rgb_bytes": raw,
+    }
+
+
+def main() -> int:
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    sub = parser.add_subparsers(dest="command", required=True)
+    build_cmd = sub.add_parser("build", help="encode a JSON sprite description")
+    build_cmd.add_argument("spec", type=Path)
+    build_cmd.add_argument("-o", "--output", type=Path, required=True)
+    info_cmd = sub.add_parser("info", help="validate and describe an .lsa file")
+    info_cmd.add_argument("sprite", type=Path)
+    args = parser.parse_args()
+
+    try:
+        if args.command == "build":
+            blob = build(json.loads(args.spec.read_text(encoding="utf-8")))
+            args.output.write_bytes(blob)
+            print(json.dumps(inspect(blob)))
+        else:
+            print(json.dumps(inspect(args.sprite.read_bytes())))
+    except (SpriteError, KeyError, struct.error) as exc:
+        print(f"error: {exc}", file=sys.stderr)
+        return 1
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
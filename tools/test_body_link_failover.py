@@ -0,0 +1,263 @@
+#!/usr/bin/env python3
+"""Host tests for BodyLinkFailover.h, body-link transport selection.
+
+The harness simulates a show: the body heartbeats over UART, the dome sends
+commands, the slip ring drops out and comes back, and WiFi comes and goes.
+Time advances in 10 ms ticks with the selector polled every tick, as
+mainLoop() does.
+"""
+
+from __future__ import annotations
+
+import sys
+import unittest
+from pathlib import Path
+
+
+ROOT = Path(__file__).resolve().parents[1]
+sys.path.insert(0, str(ROOT / "tools"))
+
+from host_harness import HarnessTestCase, run_harness  # noqa: E402
+
+HARNESS = r"""
+#include <stdio.h>
+#include "BodyLinkFailover.h"
+
+static BodyLinkFailover f;
+static uint32_t now = 0;
+static bool wifiUsable = true;
+static uint8_t lastActive = kBodyLinkPathNone;
+
+static const char *pathName(uint8_t p)
+{
+    return p == kBodyLinkPathUart ? "uart" : p == kBodyLinkPathWifi ? "wifi" : "none";
+}
+
+static void replay(uint8_t path, const char *cmd, void *)
+{
+    printf("P %u %s %s\n", now, pathName(path), cmd);
+}
+
+static void poll()
+{
+    uint8_t active = bodyLinkFailoverUpdate(f, now, wifiUsable, replay, nullptr);
+    if (active != lastActive)
+        printf("T %u %s\n", now, pathName(active));
+    lastActive = active;
+}
+
+static void send(const char *cmd)
+{
+    poll();
+    bodyLinkFailoverNoteTx(f, f.active, cmd, now);
+}
+
+// Runs until `until`, with the body heartbeating every `hbMs` on `hbPath`
+// (kBodyLinkPathNone = silent) and counting dome heartbeats.
+static uint32_t run(uint32_t until, uint8_t hbPath, uint32_t hbMs, uint32_t cmdEveryMs = 0)
+{
+    uint32_t heartbeats = 0;
+    for (; now < until; now += 10)
+    {
+        if (hbPath != kBodyLinkPathNone && now % hbMs == 0)
+            bodyLinkFailoverNoteRx(f, hbPath, now, true);
+        poll();
+        if (cmdEveryMs != 0 && now % cmdEveryMs == 0)
+            send(":SE00");
+        if (f.active != kBodyLinkPathNone && bodyLinkFailoverHeartbeatDue(f, now))
+        {
+            heartbeats++;
+            if (bodyLinkFailoverHeartbeatRequestDue(f, f.active, now))
+                printf("H %u %s\n", now, pathName(f.active));
+        }
+    }
+    return heartbeats;
+}
+
+static void stats(const char *tag)
+{
+    const BodyLinkFailoverStats &st = f.stats;
+    printf("S %s failovers=%u failbacks=%u detect=%u maxdetect=%u recovery=%u replayed=%u expired=%u unbuffered=%u uartint=%u uartdl=%u\n",
+           tag, st.failovers, st.failbacks, st.lastDetectMs, st.maxDetectMs, st.lastRecoveryMs, st.replayed,
+           st.replayExpired, st.unbuffered, f.path[kBodyLinkPathUart].intervalMs,
+           bodyLinkFailoverDeadlineMs(f.path[kBodyLinkPathUart]));
+}
+
+int main()
+{
+    bodyLinkFailoverReset(f);
+    wifiUsable = false;
+
+    // Legacy 1 Hz body: UART comes up, cadence learned, deadline 3 s.
+    run(1000, kBodyLinkPathNone, 0);
+    uint32_t idle = run(11000, kBodyLinkPathUart, 1000);
+    printf("D idle_heartbeats %u\n", idle);
+    uint32_t busy = run(21000, kBodyLinkPathUart, 1000, 100);
+    printf("D busy_heartbeats %u\n", busy);
+    stats("legacy");
+
+    // Legacy body drops out: declared dead 3 s after its last heartbeat.
+    wifiUsable = true;
+    run(21500, kBodyLinkPathUart, 1000);
+    run(26000, kBodyLinkPathNone, 0);
+    stats("legacy_drop");
+
+    // UART back; the body now honours #APHI250.
+    run(40000, kBodyLinkPathUart, 250);
+    stats("fast");
+
+    // Mid-show drop: the last UART heartbeat was at 39750. Commands keep
+    // going out on UART until the deadline, then go over WiFi; the body is
+    // heard on WiFi at 40700.
+    run(40100, kBodyLinkPathNone, 0);
+    send(":SE01");
+    run(40400, kBodyLinkPathNone, 0);
+    send(":SE02");
+    send("$12");
+    run(40600, kBodyLinkPathNone, 0);
+    send(":SE03");
+    run(40700, kBodyLinkPathNone, 0);
+    bodyLinkFailoverNoteRx(f, kBodyLinkPathWifi, now, true);
+    run(41000, kBodyLinkPathNone, 0);
+    stats("midshow");
+
+    // UART returns while WiFi is fine: failback, nothing replayed.
+    run(42000, kBodyLinkPathUart, 250);
+    stats("failback");
+
+    // Both paths gone: commands wait, the stale one expires.
+    wifiUsable = false;
+    run(45000, kBodyLinkPathNone, 0);
+    send(":OP01");
+    now += 6000;
+    send(":OP02");
+    char longCmd[80];
+    memset(longCmd, 'X', 70);
+    longCmd[70] = '\0';
+    send(longCmd);
+    now += 100;
+    run(now + 30, kBodyLinkPathUart, 10);
+    stats("none");
+
+    // UART gone again. An unsent command 2 s old is dropped; a fresh one is
+    // replayed when UART is heard once, and again on WiFi when UART dies
+    // before the body is heard after the replay.
+    printf("D stale_start %u\n", now);
+    run(now + 1000, kBodyLinkPathNone, 0);
+    send(":OP03");
+    now += 2000;
+    send(":OP04");
+    now += 100;
+    bodyLinkFailoverNoteRx(f, kBodyLinkPathUart, now, true);
+    poll();
+    wifiUsable = true;
+    run(now + 1000, kBodyLinkPathNone, 0);
+    stats("rereplay");
+    return 0;
+}
+"""
+
+
+class BodyLinkFailoverTests(HarnessTestCase):
+    HARNESS_NAME = "failover_harness"
+    HARNESS = HARNESS
+
+    @classmethod
+    def setUpClass(cls) -> None:
+        super().setUpClass()
+        cls.lines = run_harness(cls.binary)
+
+    def value(self, key: str) -> str:
+        for line in self.lines:
+            if line.startswith(f"D {key} "):
+                return line.split(" ", 2)[2]
+        self.fail(f"missing {key}")
+
+    def stats(self, tag: str) -> dict[str, int]:
+        for line in self.lines:
+            if line.startswith(f"S {tag} "):
+                return {k: int(v) for k, v in (f.split("=") for f in line.split()[2:])}
+        self.fail(f"missing stats {tag}")
+
+    def transitions(self) -> list[tuple[int, str]]:
+        return [(int(line.split()[1]), line.split()[2]) for line in self.lines if line.startswith("T ")]
+
+    def replays(self) -> list[tuple[int, str, str]]:
+        out = []
+        for line in self.lines:
+            if line.startswith("P "):
+                _, t, path, cmd = line.split(" ", 3)
+                out.append((int(t), path, cmd))
+        return out
+
+    def test_heartbeat_is_fast_when_idle_and_piggybacked_when_busy(self) -> None:
+        # 10 s idle at 250 ms; 10 s with a command every 100 ms at 1 s.
+        self.assertEqual(self.value("idle_heartbeats"), "40")
+        self.assertEqual(self.value("busy_heartbeats"), "10")
+
+    def test_legacy_cadence_gives_three_second_detection(self) -> None:
+        legacy = self.stats("legacy")
+        self.assertEqual(legacy["uartint"], 1000)
+        self.assertEqual(legacy["uartdl"], 3000)
+        drop = self.stats("legacy_drop")
+        self.assertEqual(drop["failovers"], 1)
+        self.assertEqual(drop["detect"], 3000)
+        self.assertIn((24000, "wifi"), self.transitions())
+
+    def test_faster_heartbeats_are_requested_a_bounded_number_of_times(self) -> None:
+        requests = [line for line in self.lines if line.startswith("H ")]
+        # Three per connection on the legacy body; one after the reconnect
+        # until the 250 ms cadence is learned; one on WiFi once it is heard.
+        self.assertEqual(len([r for r in requests if int(r.split()[1]) < 21000]), 3)
+        after = [r for r in requests if int(r.split()[1]) >= 26000]
+        self.assertEqual([r.split()[2] for r in after], ["uart", "wifi"])
+
+    def test_midshow_drop_switches_in_under_a_second_and_replays(self) -> None:
+        fast = self.stats("fast")
+        # EWMA with integer steps settles within a few ms of the cadence.
+        self.assertAlmostEqual(fast["uartint"], 250, delta=5)
+        self.assertAlmostEqual(fast["uartdl"], 750, delta=15)
+        switch = [t for t, path in self.transitions() if 40000 < t < 41000]
+        self.assertEqual(len(switch), 1)
+        self.assertLess(switch[0] - 39750, 1000)
+        # Sent after the last UART heartbeat: replayed in order on WiFi.
+        # :SE03 went out on WiFi in the first place.
+        self.assertEqual(self.replays()[:3], [
+            (switch[0], "wifi", ":SE01"),
+            (switch[0], "wifi", ":SE02"),
+            (switch[0], "wifi", "$12"),
+        ])
+        midshow = self.stats("midshow")
+        self.assertEqual(midshow["failovers"], 2)
+        self.assertEqual(midshow["detect"], switch[0] - 39750)
+        self.assertEqual(midshow["maxdetect"], 3000)
+        self.assertEqual(midshow["recovery"], 40700 - 39750)
+        self.assertEqual(midshow["replayed"], 3)
+
+    def test_failback_to_uart_does_not_replay(self) -> None:
+        failback = self.stats("failback")
+        # One after the legacy drop, one here.
+        self.assertEqual(failback["failbacks"], 2)
+        self.assertEqual(failback["replayed"], 3)
+        self.assertIn((41000, "uart"), self.transitions())
+        self.assertEqual([r for r in self.replays() if 41000 <= r[0] <= 42000], [])
+
+    def test_commands_sent_with_no_path_wait_for_the_next(self) -> None:
+        none = self.stats("none")
+        stale_start = int(self.value("stale_start"))
+        replays = [r for r in self.replays() if 42000 < r[0] <= stale_start]
+        self.assertEqual([(path, cmd) for _, path, cmd in replays], [("uart", ":OP02")])
+        self.assertEqual(none["expired"], 1)
+        self.assertEqual(none["unbuffered"], 1)
+
+    def test_stale_unsent_commands_are_dropped_and_replays_survive_a_second_drop(self) -> None:
+        stale_start = int(self.value("stale_start"))
+        replays = [(path, cmd) for t, path, cmd in self.replays() if t > stale_start]
+        self.assertEqual(replays, [("uart", ":OP04"), ("wifi", ":OP04")])
+        rereplay = self.stats("rereplay")
+        self.assertEqual(rereplay["expired"], 2)
+        self.assertEqual(rereplay["replayed"], self.stats("none")["replayed"] + 2)
+
+
+if __name__ == "__main__":
+    unittest.main()
@@ -0,0 +1,251 @@
+#!/usr/bin/env python3
+"""Host tests for BodyLinkFrame.h, the framed protoR2link UDP protocol.
+
+Two sessions (dome and body) exchange datagrams through the harness, which
+drops, duplicates and reorders them on purpose.
+"""
+
+from __future__ import annotations
+
+import sys
+import unittest
+from pathlib import Path
+
+
+ROOT = Path(__file__).resolve().parents[1]
+sys.path.insert(0, str(ROOT / "tools"))
+
+from host_harness import HarnessTestCase, run_harness  # noqa: E402
+
+HARNESS = r"""
+#include <stdio.h>
+#include "BodyLinkFrame.h"
+
+struct Datagram { uint8_t data[BODY_LINK_FRAME_MAX_BYTES]; size_t len; };
+
+static void printMessage(const char *msg, void *ctx)
+{
+    printf("M %s %s\n", (const char *)ctx, msg);
+}
+
+static Datagram build(BodyLinkFrameSession &s, uint32_t now)
+{
+    Datagram d;
+    d.len = bodyLinkFrameBuild(s, now, d.data);
+    return d;
+}
+
+static const char *resultName(BodyLinkFrameResult r)
+{
+    switch (r)
+    {
+        case kBodyLinkFrameAccepted: return "accepted";
+        case kBodyLinkFrameDuplicate: return "duplicate";
+        case kBodyLinkFrameStale: return "stale";
+        default: return "malformed";
+    }
+}
+
+static void deliver(BodyLinkFrameSession &to, const Datagram &d, uint32_t now, const char *who)
+{
+    bool heartbeat = false;
+    BodyLinkFrameResult r = bodyLinkFrameReceive(to, d.data, d.len, now, printMessage, (void *)who, heartbeat);
+    printf("R %s %s%s\n", who, resultName(r), heartbeat ? " hb" : "");
+}
+
+static void stats(const char *who, const BodyLinkFrameSession &s)
+{
+    const BodyLinkFrameStats &st = s.stats;
+    printf("S %s tx=%u msgs=%u rx=%u rxmsgs=%u dup=%u ooo=%u stale=%u gaps=%u bad=%u acked=%u lost=%u loss=%u rtt=%u avg=%u max=%u\n",
+           who, st.txFrames, st.txMessages, st.rxFrames, st.rxMessages, st.rxDuplicates, st.rxOutOfOrder,
+           st.rxStale, st.rxGaps, st.rxMalformed, st.acked, st.lost, bodyLinkFrameLossPercent(st),
+           st.rttLastMs, st.rttAvgMs, st.rttMaxMs);
+}
+
+int main()
+{
+    static BodyLinkFrameSession dome, body;
+    bodyLinkFrameReset(dome, 7);
+    bodyLinkFrameReset(body, 9);
+
+    // Coalescing: three commands inside the window go out as one datagram.
+    bodyLinkFrameQueue(dome, "dome=seqon,12\r", 100);
+    bodyLinkFrameQueue(dome, "BD:HAPPY", 101);
+    bodyLinkFrameQueue(dome, "dome=rot\r\n", 103);
+    printf("D due_early %d\n", bodyLinkFrameDue(dome, 104));
+    printf("D due_window %d\n", bodyLinkFrameDue(dome, 105));
+    Datagram batch = build(dome, 105);
+    printf("D batch_len %u\n", (unsigned)batch.len);
+    deliver(body, batch, 110, "body");
+    printf("D body_owes_ack %d\n", bodyLinkFrameDue(body, 110));
+    Datagram ack = build(body, 110);
+    printf("D ack_len %u flags %u\n", (unsigned)ack.len, ack.data[1]);
+    deliver(dome, ack, 117, "dome");
+    printf("D first_rtt %u\n", dome.stats.rttLastMs);
+    printf("D dome_owes_ack %d\n", bodyLinkFrameDue(dome, 117));
+
+    // A full batch refuses the next command so the caller flushes first.
+    char big[BODY_LINK_FRAME_MAX_MESSAGE + 1];
+    memset(big, 'X', BODY_LINK_FRAME_MAX_MESSAGE);
+    big[BODY_LINK_FRAME_MAX_MESSAGE] = '\0';
+    printf("D queue_big %d\n", bodyLinkFrameQueue(dome, big, 200));
+    printf("D queue_overflow %d\n", bodyLinkFrameQueue(dome, big, 200));
+    big[BODY_LINK_FRAME_MAX_MESSAGE - 10] = '\0';
+    printf("D queue_too_long_for_rest %d\n", bodyLinkFrameQueue(dome, big, 200));
+    Datagram full = build(dome, 200);
+    printf("D full_len %u\n", (unsigned)full.len);
+
+    // Duplicate and out-of-order delivery.
+    deliver(body, full, 201, "body");
+    deliver(body, full, 202, "body");
+    bodyLinkFrameQueue(dome, ":SE01", 300);
+    Datagram a = build(dome, 305);
+    bodyLinkFrameQueue(dome, ":SE02", 306);
+    Datagram b = build(dome, 311);
+    deliver(body, b, 312, "body");
+    stats("body", body);
+    deliver(body, a, 313, "body");
+    deliver(body, a, 314, "body");
+    Datagram acks = build(body, 320);
+    deliver(dome, acks, 330, "dome");
+    stats("dome", dome);
+
+    // Heartbeats the body never acknowledges are counted as lost once their
+    // slot in the sent history is reused.
+    for (int i = 0; i < 40; i++)
+    {
+        dome.heartbeatPending = true;
+        Datagram hb = build(dome, 1000 + i * 1000);
+        if (i == 0 || i == 39) deliver(body, hb, 1001 + i * 1000, "body");
+    }
+    stats("dome", dome);
+
+    // Now far older than the body's window: stale, not delivered.
+    deliver(body, a, 50000, "body");
+
+    // Malformed: truncated message, zero-length message, wrong magic.
+    bodyLinkFrameQueue(dome, "#APSL", 60000);
+    Datagram bad = build(dome, 60005);
+    bad.len -= 1;
+    deliver(body, bad, 60006, "body");
+    bad.len += 1;
+    bad.data[BODY_LINK_FRAME_HEADER_BYTES] = 0;
+    deliver(body, bad, 60007, "body");
+    bad.data[0] = '#';
+    deliver(body, bad, 60008, "body");
+
+    // The dome restarts under a new epoch: seq 0 is new data, not a duplicate,
+    // and acks the body still holds for the old epoch acknowledge nothing.
+    uint32_t ackedBefore = dome.stats.acked;
+    bodyLinkFrameReset(dome, 8);
+    bodyLinkFrameQueue(dome, "#APWU", 70000);
+    Datagram fresh = build(dome, 70005);
+    Datagram oldAcks = build(body, 70006);
+    deliver(dome, oldAcks, 70007, "dome");
+    printf("D acked_from_old_epoch %u\n", dome.stats.acked - ackedBefore);
+    deliver(body, fresh, 70010, "body");
+    Datagram newAck = build(body, 70012);
+    deliver(dome, newAck, 70020, "dome");
+    stats("dome", dome);
+    stats("body", body);
+    return 0;
+}
+"""
+
+
+class BodyLinkFrameTests(HarnessTestCase):
+    HARNESS_NAME = "frame_harness"
+    HARNESS = HARNESS
+
+    @classmethod
+    def setUpClass(cls) -> None:
+        super().setUpClass()
+        cls.lines = run_harness(cls.binary)
+
+    def value(self, key: str) -> str:
+        for line in self.lines:
+            if line.startswith(f"D {key} "):
+                return line.split(" ", 2)[2]
+        self.fail(f"missing {key}")
+
+    def stats(self, who: str) -> list[dict[str, int]]:
+        out = []
+        for line in self.lines:
+            if line.startswith(f"S {who} "):
+                out.append({k: int(v) for k, v in (f.split("=") for f in line.split()[2:])})
+        return out
+
+    def test_commands_are_coalesced_within_the_window(self) -> None:
+        self.assertEqual(self.value("due_early"), "0")
+        self.assertEqual(self.value("due_window"), "1")
+        # 12-byte header + three length-prefixed commands, CR/LF stripped.
+        self.assertEqual(self.value("batch_len"), str(12 + 14 + 9 + 9))
+        start = self.lines.index("D batch_len 44") + 1
+        self.assertEqual(self.lines[start:start + 4], [
+            "M body dome=seqon,12",
+            "M body BD:HAPPY",
+            "M body dome=rot",
+            "R body accepted",
+        ])
+
+    def test_ack_is_sent_promptly_and_gives_rtt(self) -> None:
+        self.assertEqual(self.value("body_owes_ack"), "1")
+        # Ack-only: header, no messages, AckValid without AckRequest.
+        self.assertEqual(self.value("ack_len"), "12 flags 4")
+        self.assertEqual(self.value("dome_owes_ack"), "0")
+        self.assertEqual(self.value("first_rtt"), "12")
+
+    def test_full_batch_rejects_the_next_command(self) -> None:
+        self.assertEqual(self.value("queue_big"), "1")
+        self.assertEqual(self.value("queue_overflow"), "0")
+        self.assertEqual(self.value("queue_too_long_for_rest"), "0")
+        self.assertEqual(self.value("full_len"), str(12 + 1 + 160))
+
+    def test_duplicates_and_reordering_are_detected(self) -> None:
+        results = [line for line in self.lines if line.startswith("R body")]
+        self.assertEqual(results[1:6], [
+            "R body accepted",
+            "R body duplicate",
+            "R body accepted",   # b arrives first, a's seq becomes a gap
+            "R body accepted",   # a, out of order
+            "R body duplicate",
+        ])
+        self.assertEqual(sum(1 for line in self.lines if line == "M body :SE01"), 1)
+        first = self.stats("body")[0]
+        self.assertEqual(first["gaps"], 1)
+        final = self.stats("body")[-1]
+        self.assertEqual(final["dup"], 2)
+        self.assertEqual(final["ooo"], 1)
+
+    def test_unacked_heartbeats_count_as_loss(self) -> None:
+        after_acks, after_heartbeats, _ = self.stats("dome")
+        self.assertEqual(after_acks["acked"], 4)
+        self.assertEqual(after_acks["lost"], 0)
+        # 40 heartbeats into a 32-slot history; the body saw two of them but
+        # never sent anything back, so 8 slots were reused unacked.
+        self.assertEqual(after_heartbeats["lost"], 8)
+        self.assertEqual(after_heartbeats["loss"], 67)
+
+    def test_stale_and_malformed_datagrams_are_dropped(self) -> None:
+        results = [line for line in self.lines if line.startswith("R body")]
+        self.assertEqual(results[6:12], [
+            "R body accepted hb",
+            "R body accepted hb",
+            "R body stale",
+            "R body malformed",
+            "R body malformed",
+            "R body malformed",
+        ])
+        self.assertNotIn("M body #APSL", self.lines)
+        self.assertEqual(self.stats("body")[-1]["bad"], 3)
+
+    def test_new_epoch_starts_a_fresh_window(self) -> None:
+        self.assertEqual(self.value("acked_from_old_epoch"), "0")
+        self.assertIn("M body #APWU", self.lines)
+        results = [line for line in self.lines if line.startswith("R body")]
+        self.assertEqual(results[-1], "R body accepted")
+        self.assertEqual(self.stats("dome")[-1]["acked"], 5)
+
+
+if __name__ == "__main__":
+    unittest.main()
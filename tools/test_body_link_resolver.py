@@ -0,0 +1,262 @@
+#!/usr/bin/env python3
+"""Host tests for BodyLinkResolver.h, non-blocking body peer discovery.
+
+The harness steps the resolver every 10 ms, as eventLoopTask does, against a
+scripted fake of the ESP-IDF async mDNS backend: a query either answers after
+a delay, completes empty at its timeout, or hangs.
+"""
+
+from __future__ import annotations
+
+import sys
+import unittest
+from pathlib import Path
+
+
+ROOT = Path(__file__).resolve().parents[1]
+sys.path.insert(0, str(ROOT / "tools"))
+
+from host_harness import HarnessTestCase, run_harness  # noqa: E402
+
+HARNESS = r"""
+#include <stdio.h>
+#include "BodyLinkResolver.h"
+
+enum FakeMode { kAbsent, kHostAnswers, kServiceAnswers, kHangs };
+
+static BodyLinkResolver r;
+static uint32_t now = 0;
+static bool wanted = true;
+static FakeMode mode = kAbsent;
+static uint32_t answerIp = 0x2A01A8C0;     // 192.168.1.42, lwIP order
+static uint32_t answerTtl = 120;
+static uint32_t answerDelayMs = 30;
+static bool inFlight = false;
+static BodyLinkResolveQuery inFlightQuery;
+static uint32_t startedMs = 0;
+static uint32_t queryTimeoutMs = 0;
+static unsigned callsThisStep = 0;
+static unsigned maxCallsPerStep = 0;
+static unsigned cancels = 0;
+
+static bool fakeStart(BodyLinkResolveQuery query, uint32_t timeoutMs)
+{
+    callsThisStep++;
+    inFlight = true;
+    inFlightQuery = query;
+    startedMs = now;
+    queryTimeoutMs = timeoutMs;
+    printf("Q %u %s\n", now, query == kBodyLinkResolveHost ? "host" : "service");
+    return true;
+}
+
+static BodyLinkResolvePoll fakePoll(BodyLinkResolverAnswer &answer)
+{
+    callsThisStep++;
+    if (!inFlight)
+        return kBodyLinkResolveNotFound;
+    bool answers = (mode == kHostAnswers && inFlightQuery == kBodyLinkResolveHost) ||
+                   (mode == kServiceAnswers && inFlightQuery == kBodyLinkResolveService);
+    if (answers && now - startedMs >= answerDelayMs)
+    {
+        answer.ipv4 = answerIp;
+        answer.ttlSec = answerTtl;
+        inFlight = false;
+        return kBodyLinkResolveFound;
+    }
+    if (mode != kHangs && now - startedMs >= queryTimeoutMs)
+    {
+        inFlight = false;
+        return kBodyLinkResolveNotFound;
+    }
+    return kBodyLinkResolvePending;
+}
+
+static void fakeCancel()
+{
+    callsThisStep++;
+    cancels++;
+    inFlight = false;
+}
+
+static const BodyLinkResolverBackend kFake = { fakeStart, fakePoll, fakeCancel };
+
+static void run(uint32_t until)
+{
+    for (; now < until; now += 10)
+    {
+        callsThisStep = 0;
+        BodyLinkResolverEvent ev = bodyLinkResolverStep(r, kFake, now, wanted);
+        if (callsThisStep > maxCallsPerStep)
+            maxCallsPerStep = callsThisStep;
+        if (ev == kBodyLinkResolverResolved)
+            printf("E %u resolved %08x\n", now, r.ipv4);
+        else if (ev == kBodyLinkResolverExpired)
+            printf("E %u expired\n", now);
+    }
+}
+
+static void stats(const char *tag)
+{
+    const BodyLinkResolverStats &st = r.stats;
+    printf("S %s queries=%u answers=%u misses=%u timeouts=%u refreshes=%u expiries=%u backoff=%u cancels=%u\n",
+           tag, st.queries, st.answers, st.misses, st.timeouts, st.refreshes, st.expiries, r.backoffMs, cancels);
+    printf("N %s %s\n", tag, bodyLinkResolverStateName(r));
+}
+
+int main()
+{
+    bodyLinkResolverReset(r);
+
+    // Body absent for five minutes: rounds back off to the cap.
+    run(300000);
+    stats("absent");
+
+    // Body appears; answers the host query.
+    mode = kHostAnswers;
+    run(400000);
+    stats("found");
+
+    // Still there at refresh time (80 % of 120 s after it was found).
+    run(520000);
+    stats("refreshed");
+
+    // Body leaves: refreshes fail until the TTL runs out.
+    mode = kAbsent;
+    run(700000);
+    stats("left");
+
+    // Back, but only reachable through the DNS-SD browse.
+    mode = kServiceAnswers;
+    answerIp = 0x2B01A8C0;
+    answerTtl = 2;                      // clamped up to 10 s
+    run(800000);
+    stats("service");
+
+    // Peer learned from traffic: discovery paused, in-flight query cancelled.
+    mode = kHangs;
+    bodyLinkResolverReset(r);
+    cancels = 0;
+    run(800500);
+    wanted = false;
+    run(801000);
+    stats("paused");
+
+    // Backend that never completes: abandoned after the grace period.
+    wanted = true;
+    run(806000);
+    stats("hang");
+
+    printf("D max_calls_per_step %u\n", maxCallsPerStep);
+    return 0;
+}
+"""
+
+
+class BodyLinkResolverTests(HarnessTestCase):
+    HARNESS_NAME = "resolver_harness"
+    HARNESS = HARNESS
+
+    @classmethod
+    def setUpClass(cls) -> None:
+        super().setUpClass()
+        cls.lines = run_harness(cls.binary)
+
+    def value(self, key: str) -> str:
+        for line in self.lines:
+            if line.startswith(f"D {key} "):
+                return line.split(" ", 2)[2]
+        self.fail(f"missing {key}")
+
+    def stats(self, tag: str) -> dict[str, int]:
+        for line in self.lines:
+            if line.startswith(f"S {tag} "):
+                return {k: int(v) for k, v in (f.split("=") for f in line.split()[2:])}
+        self.fail(f"missing stats {tag}")
+
+    def state(self, tag: str) -> str:
+        for line in self.lines:
+            if line.startswith(f"N {tag} "):
+                return line.split()[2]
+        self.fail(f"missing state {tag}")
+
+    def queries(self, start: int, end: int) -> list[tuple[int, str]]:
+        out = []
+        for line in self.lines:
+            if line.startswith("Q "):
+                t, kind = int(line.split()[1]), line.split()[2]
+                if start <= t < end:
+                    out.append((t, kind))
+        return out
+
+    def events(self) -> list[tuple[int, str]]:
+        return [(int(line.split()[1]), line.split(" ", 2)[2]) for line in self.lines if line.startswith("E ")]
+
+    def test_each_step_makes_a_bounded_number_of_backend_calls(self) -> None:
+        # A poll, a cancel if it hung, then possibly starting the service
+        # browse; nothing waits.
+        self.assertLessEqual(int(self.value("max_calls_per_step")), 3)
+
+    def test_absent_body_backs_off_exponentially_to_the_cap(self) -> None:
+        hosts = [t for t, kind in self.queries(0, 300000) if kind == "host"]
+        services = [t for t, kind in self.queries(0, 300000) if kind == "service"]
+        self.assertEqual(hosts[:4], [0, 4000, 10000, 20000])
+        self.assertEqual([s - h for h, s in zip(hosts, services)], [1000] * len(hosts))
+        gaps = [b - a for a, b in zip(hosts, hosts[1:])]
+        # 2 s host + service, then 2, 4, 8, 16, 32 s backoff, capped at 60 s.
+        self.assertEqual(gaps[:6], [4000, 6000, 10000, 18000, 34000, 62000])
+        self.assertTrue(all(g == 62000 for g in gaps[6:]))
+        absent = self.stats("absent")
+        self.assertEqual(absent["backoff"], 60000)
+        self.assertEqual(absent["answers"], 0)
+        self.assertEqual(self.state("absent"), "backoff")
+
+    def test_answer_is_cached_and_refreshed_before_the_ttl(self) -> None:
+        resolved = [(t, ev) for t, ev in self.events() if ev.startswith("resolved")]
+        first = resolved[0]
+        self.assertEqual(first[1], "resolved 2a01a8c0")
+        # Found within one backoff period of the body appearing.
+        self.assertLess(first[0] - 300000, 62000)
+        found = self.stats("found")
+        self.assertEqual(found["backoff"], 0)
+        self.assertEqual(self.state("found"), "cached")
+        # No traffic while cached; one host query at 80 % of the TTL.
+        refresh = self.queries(first[0] + 10, 520000)
+        self.assertEqual(refresh[0], (first[0] + 96000, "host"))
+        refreshed = self.stats("refreshed")
+        self.assertGreaterEqual(refreshed["refreshes"], 1)
+        # Same address: no second resolved event.
+        self.assertEqual(len([t for t, _ in resolved if t < 520000]), 1)
+
+    def test_cached_address_expires_when_refreshes_fail(self) -> None:
+        expired = [t for t, ev in self.events() if ev == "expired"]
+        self.assertEqual(len(expired), 1)
+        last_answer = max(t for t, kind in self.queries(0, 520000) if kind == "host") + 30
+        self.assertEqual(expired[0], last_answer + 120000)
+        # Refreshes retried with backoff in the meantime.
+        retries = [t for t, kind in self.queries(last_answer, expired[0]) if kind == "host"]
+        self.assertGreaterEqual(len(retries), 3)
+        self.assertEqual(self.stats("left")["expiries"], 1)
+
+    def test_service_browse_is_the_fallback(self) -> None:
+        resolved = [(t, ev) for t, ev in self.events() if ev == "resolved 2b01a8c0"]
+        self.assertTrue(resolved)
+        t = resolved[0][0]
+        # Host query first, service browse after its timeout, answer 30 ms later.
+        kinds = [kind for _, kind in self.queries(t - 1100, t)]
+        self.assertEqual(kinds, ["host", "service"])
+        # TTL of 2 s clamped to 10 s: refreshed every 8 s.
+        later = [q for q in self.queries(t + 10, t + 20000) if q[1] == "host"]
+        self.assertEqual(later[0][0], t + 8000)
+
+    def test_unwanted_or_hung_queries_are_cancelled(self) -> None:
+        paused = self.stats("paused")
+        self.assertEqual(paused["cancels"], 1)
+        self.assertEqual(self.queries(800500, 801000), [])
+        hang = self.stats("hang")
+        self.assertGreaterEqual(hang["timeouts"], 2)
+        self.assertEqual(hang["cancels"], 1 + hang["timeouts"])
+
+
+if __name__ == "__main__":
+    unittest.main()
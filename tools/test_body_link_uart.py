@@ -0,0 +1,254 @@
+#!/usr/bin/env python3
+"""Host tests for BodyLinkUart.h, the body-link UART frame detector and baud
+negotiation.
+
+The harness feeds byte streams split at awkward points, fills the frame ring
+and walks the dome side of the baud negotiation through success, a failed
+switch and a link lost after switching.
+"""
+
+from __future__ import annotations
+
+import sys
+import unittest
+from pathlib import Path
+
+
+ROOT = Path(__file__).resolve().parents[1]
+sys.path.insert(0, str(ROOT / "tools"))
+
+from host_harness import HarnessTestCase, run_harness  # noqa: E402
+
+HARNESS = r"""
+#include <stdio.h>
+#include "BodyLinkUart.h"
+
+static void feed(BodyLinkUartReader &r, const char *text, uint32_t now)
+{
+    bodyLinkUartFeed(r, (const uint8_t *)text, strlen(text), now);
+}
+
+static void drain(BodyLinkUartReader &r, const char *tag)
+{
+    BodyLinkUartFrame f;
+    while (bodyLinkUartPop(r, f))
+        printf("F %s %u %u %s\n", tag, f.rxMs, f.len, f.text);
+}
+
+static void stats(const char *tag, const BodyLinkUartReader &r)
+{
+    const BodyLinkUartStats &st = r.stats;
+    printf("S %s bytes=%u frames=%u hb=%u overlong=%u garbage=%u ring=%u peak=%u frame=%u fifo=%u breaks=%u lasthb=%u\n",
+           tag, st.rxBytes, st.frames, st.heartbeats, st.overlong, st.garbage, st.ringOverflow, st.ringPeak,
+           st.frameErrors, st.fifoOverflows, st.breaks, r.lastHeartbeatMs);
+}
+
+static void baud(const char *tag, const BodyLinkUartBaud &b)
+{
+    printf("B %s state=%s baud=%u offers=%u ok=%u reverts=%u failures=%u\n",
+           tag, bodyLinkUartBaudStateName(b.state), b.currentBaud, b.offers, b.negotiations, b.reverts, b.failures);
+}
+
+int main()
+{
+    static BodyLinkUartReader r;
+    bodyLinkUartReset(r);
+
+    // Lines split across driver reads, CR/LF and bare LF, empty lines.
+    feed(r, ":SE0", 10);
+    feed(r, "1\r\n#PA", 11);
+    feed(r, "HB\r", 12);
+    feed(r, "\r\n\n", 13);
+    feed(r, "BD:HAPPY\n", 14);
+    drain(r, "split");
+    stats("split", r);
+
+    // Overlong: dropped whole, the tail is not admitted as a new command.
+    char big[100];
+    memset(big, 'A', 80);
+    big[80] = '\0';
+    feed(r, big, 20);
+    feed(r, "BBBB\r:OP01\r", 21);
+    // Exactly 64 bytes still fits.
+    memset(big, 'C', 64);
+    big[64] = '\r';
+    big[65] = '\0';
+    feed(r, big, 22);
+    drain(r, "long");
+
+    // Garbage from a baud mismatch, then a clean line.
+    const uint8_t noise[] = { 0x00, 0xFF, ':', 0x80, 'S', '\r', ':', 'S', 'E', '0', '2', '\r' };
+    bodyLinkUartFeed(r, noise, sizeof(noise), 30);
+    // A driver error mid-line taints that line only.
+    feed(r, ":SE0", 31);
+    bodyLinkUartNoteError(r, kBodyLinkUartFrameError);
+    feed(r, "3\r:SE04\r", 32);
+    bodyLinkUartNoteError(r, kBodyLinkUartFifoOverflow);
+    bodyLinkUartNoteError(r, kBodyLinkUartBreak);
+    drain(r, "noise");
+    stats("noise", r);
+
+    // Ring full: the newest lines are dropped and counted; heartbeats still land.
+    for (int i = 0; i < BODY_LINK_UART_RING_FRAMES + 3; i++)
+    {
+        char line[16];
+        snprintf(line, sizeof(line), ":SE%02d\r", i);
+        feed(r, line, 40 + i);
+    }
+    feed(r, "#PAHB\r", 99);
+    BodyLinkUartFrame first;
+    bodyLinkUartPop(r, first);
+    printf("D ring_first %s\n", first.text);
+    feed(r, ":SE99\r", 100);
+    int popped = 0;
+    BodyLinkUartFrame last;
+    while (bodyLinkUartPop(r, last))
+        popped++;
+    printf("D ring_popped %d last %s\n", popped, last.text);
+    stats("ring", r);
+
+    // Baud negotiation: disabled when the target is not above the base.
+    BodyLinkUartBaud off;
+    bodyLinkUartBaudInit(off, 9600, 9600);
+    printf("D offer_disabled %d\n", bodyLinkUartBaudOfferDue(off, 1000, true));
+
+    BodyLinkUartBaud b;
+    bodyLinkUartBaudInit(b, 9600, 115200);
+    printf("D offer_link_down %d\n", bodyLinkUartBaudOfferDue(b, 1000, false));
+    printf("D offer_first %d\n", bodyLinkUartBaudOfferDue(b, 1000, true));
+    printf("D offer_too_soon %d\n", bodyLinkUartBaudOfferDue(b, 2000, true));
+    printf("D accept_wrong_rate %u\n", bodyLinkUartBaudAccept(b, 57600, 2100));
+    printf("D accept %u\n", bodyLinkUartBaudAccept(b, 115200, 2200));
+    printf("D accept_again %u\n", bodyLinkUartBaudAccept(b, 115200, 2300));
+    printf("D offer_while_switched %d\n", bodyLinkUartBaudOfferDue(b, 7000, true));
+    // A heartbeat from before the switch does not confirm the new rate.
+    printf("D poll_old_hb %u\n", bodyLinkUartBaudPoll(b, 2500, 2200));
+    baud("probation", b);
+    printf("D poll_new_hb %u\n", bodyLinkUartBaudPoll(b, 3300, 3200));
+    baud("active", b);
+    printf("D poll_hb_ahead %u\n", bodyLinkUartBaudPoll(b, 4000, 4001));
+    // Link lost after switching: revert, not a failure.
+    printf("D poll_lost %u\n", bodyLinkUartBaudPoll(b, 9300, 4001));
+    baud("lost", b);
+
+    // Body never answers at the new rate: three failures with growing backoff,
+    // then no more offers.
+    uint32_t now = 20000;
+    for (int attempt = 0; attempt < 4; attempt++)
+    {
+        uint32_t wait = 0;
+        while (!bodyLinkUartBaudOfferDue(b, now, true) && wait < 60000)
+        {
+            now += 1000;
+            wait += 1000;
+        }
+        if (wait >= 60000)
+        {
+            printf("D attempt%d_offer none\n", attempt);
+            break;
+        }
+        printf("D attempt%d_waited %u\n", attempt, wait);
+        bodyLinkUartBaudAccept(b, 115200, now);
+        printf("D attempt%d_poll_early %u\n", attempt, bodyLinkUartBaudPoll(b, now + 4999, 0));
+        now += 5000;
+        printf("D attempt%d_poll_timeout %u\n", attempt, bodyLinkUartBaudPoll(b, now, 0));
+    }
+    baud("failed", b);
+    return 0;
+}
+"""
+
+
+class BodyLinkUartTests(HarnessTestCase):
+    HARNESS_NAME = "uart_harness"
+    HARNESS = HARNESS
+
+    @classmethod
+    def setUpClass(cls) -> None:
+        super().setUpClass()
+        cls.lines = run_harness(cls.binary)
+
+    def value(self, key: str) -> str:
+        for line in self.lines:
+            if line.startswith(f"D {key} "):
+                return line.split(" ", 2)[2]
+        self.fail(f"missing {key}")
+
+    def frames(self, tag: str) -> list[str]:
+        return [line.split(" ", 2)[2] for line in self.lines if line.startswith(f"F {tag} ")]
+
+    def stats(self, tag: str) -> dict[str, int]:
+        for line in self.lines:
+            if line.startswith(f"S {tag} "):
+                return {k: int(v) for k, v in (f.split("=") for f in line.split()[2:])}
+        self.fail(f"missing stats {tag}")
+
+    def baud(self, tag: str) -> dict[str, str]:
+        for line in self.lines:
+            if line.startswith(f"B {tag} "):
+                return dict(f.split("=") for f in line.split()[2:])
+        self.fail(f"missing baud {tag}")
+
+    def test_lines_split_across_reads_are_reassembled(self) -> None:
+        # Stamped with the time the terminator arrived.
+        self.assertEqual(self.frames("split"), ["11 5 :SE01", "14 8 BD:HAPPY"])
+        st = self.stats("split")
+        self.assertEqual(st["hb"], 1)
+        self.assertEqual(st["lasthb"], 12)
+        self.assertEqual(st["frames"], 2)
+
+    def test_overlong_lines_are_dropped_whole(self) -> None:
+        self.assertEqual(self.frames("long"), ["21 5 :OP01", "22 64 " + "C" * 64])
+
+    def test_garbage_and_driver_errors_drop_the_line(self) -> None:
+        self.assertEqual(self.frames("noise"), ["30 5 :SE02", "32 5 :SE04"])
+        st = self.stats("noise")
+        self.assertEqual(st["overlong"], 1)
+        self.assertEqual(st["garbage"], 2)
+        self.assertEqual(st["frame"], 1)
+        self.assertEqual(st["fifo"], 1)
+        self.assertEqual(st["breaks"], 1)
+
+    def test_full_ring_drops_newest_and_counts(self) -> None:
+        self.assertEqual(self.value("ring_first"), ":SE00")
+        # 16 parked, 3 dropped; one popped makes room for :SE99.
+        self.assertEqual(self.value("ring_popped"), "16 last :SE99")
+        st = self.stats("ring")
+        self.assertEqual(st["ring"], 3)
+        self.assertEqual(st["peak"], 16)
+        self.assertEqual(st["lasthb"], 99)
+
+    def test_successful_negotiation(self) -> None:
+        self.assertEqual(self.value("offer_disabled"), "0")
+        self.assertEqual(self.value("offer_link_down"), "0")
+        self.assertEqual(self.value("offer_first"), "1")
+        self.assertEqual(self.value("offer_too_soon"), "0")
+        self.assertEqual(self.value("accept_wrong_rate"), "0")
+        self.assertEqual(self.value("accept"), "115200")
+        self.assertEqual(self.value("accept_again"), "0")
+        self.assertEqual(self.value("offer_while_switched"), "0")
+        self.assertEqual(self.value("poll_old_hb"), "0")
+        self.assertEqual(self.baud("probation")["state"], "probation")
+        self.assertEqual(self.value("poll_new_hb"), "0")
+        active = self.baud("active")
+        self.assertEqual((active["state"], active["baud"], active["ok"]), ("active", "115200", "1"))
+        self.assertEqual(self.value("poll_hb_ahead"), "0")
+
+    def test_lost_link_reverts_without_counting_a_failure(self) -> None:
+        self.assertEqual(self.value("poll_lost"), "9600")
+        lost = self.baud("lost")
+        self.assertEqual((lost["state"], lost["baud"], lost["reverts"], lost["failures"]), ("base", "9600", "1", "0"))
+
+    def test_failed_switches_back_off_then_stop(self) -> None:
+        # The first offer is due at once; later ones wait 10 s and 20 s.
+        self.assertEqual([self.value(f"attempt{i}_waited") for i in range(3)], ["0", "10000", "20000"])
+        for i in range(3):
+            self.assertEqual(self.value(f"attempt{i}_poll_early"), "0")
+            self.assertEqual(self.value(f"attempt{i}_poll_timeout"), "9600")
+        self.assertEqual(self.value("attempt3_offer"), "none")
+        failed = self.baud("failed")
+        self.assertEqual((failed["state"], failed["failures"], failed["ok"]), ("base", "3", "1"))
+
+
+if __name__ == "__main__":
+    unittest.main()
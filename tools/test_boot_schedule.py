@@ -0,0 +1,293 @@
+#!/usr/bin/env python3
+"""Host tests for BootSchedule.h, the boot timeline and deferred start-up work.
+
+The harness replays a boot: setup() phases on a fake microsecond clock, then
+mainLoop() passes every 2 ms that draw a frame and step the scheduler. The
+deferred tasks stand in for the sketch's: a sliced I2C scan, a sound module
+that answers on its third try, WiFi that connects some time after bring-up,
+and the web server and mDNS that wait for it.
+"""
+
+from __future__ import annotations
+
+import sys
+import unittest
+from pathlib import Path
+
+
+ROOT = Path(__file__).resolve().parents[1]
+sys.path.insert(0, str(ROOT / "tools"))
+
+from host_harness import HarnessTestCase, run_harness  # noqa: E402
+
+HARNESS = r"""
+#include <stdio.h>
+#include "BootSchedule.h"
+
+static uint32_t nowUs = 0;
+static uint32_t clockUs() { return nowUs; }
+static uint32_t nowMs() { return nowUs / 1000; }
+
+static BootTimeline t;
+static BootScheduler s;
+static int scanSlices = 0;
+static int soundTries = 0;
+static int soundFailUntil = 3;
+static bool wifiActive = false;
+static uint32_t wifiConnectAtMs = 0;
+static const char *scenario = "boot";
+
+static BootTaskResult taskScan(uint32_t &retryMs)
+{
+    nowUs += 1500;                              // 16 probes
+    if (++scanSlices < 8)
+    {
+        retryMs = 0;
+        return kBootTaskYield;
+    }
+    return kBootTaskDone;
+}
+
+static BootTaskResult taskSound(uint32_t &retryMs)
+{
+    nowUs += 20000;                             // serial handshake
+    if (++soundTries < soundFailUntil)
+    {
+        retryMs = 1000;
+        return soundTries >= 5 ? kBootTaskFailed : kBootTaskRetry;
+    }
+    return kBootTaskDone;
+}
+
+static BootTaskResult taskWifi(uint32_t &)
+{
+    nowUs += 90000;                             // radio init
+    wifiConnectAtMs = nowMs() + 2500;
+    return kBootTaskDone;
+}
+
+static BootTaskResult taskWaitWifi(uint32_t &retryMs)
+{
+    if (!wifiActive)
+    {
+        retryMs = 100;
+        return kBootTaskYield;
+    }
+    nowUs += 30000;
+    return kBootTaskDone;
+}
+
+static BootTaskResult taskNever(uint32_t &retryMs)
+{
+    retryMs = 10;
+    return kBootTaskRetry;
+}
+
+static void phase(const char *name, uint32_t us)
+{
+    bootTimelinePhase(t, name, nowUs);
+    nowUs += us;
+}
+
+static void loopUntil(uint32_t ms)
+{
+    while (nowMs() < ms)
+    {
+        nowUs += 2000;                          // one mainLoop() pass
+        if (wifiConnectAtMs != 0 && nowMs() >= wifiConnectAtMs)
+            wifiActive = true;
+        if (bootTimelineFirstFrame(t, nowUs))
+        {
+            bootSchedRelease(s, nowMs());
+            printf("F %u\n", nowUs);
+        }
+        uint32_t at = nowMs();
+        int id = bootSchedStep(s, at);
+        if (id >= 0)
+            printf("R %s %u %s %s\n", scenario, at, s.tasks[id].name, bootTaskStateName(s.tasks[id].state));
+    }
+}
+
+static void dump(const char *tag)
+{
+    printf("T %s setup_start=%u setup_done=%u first_frame=%u dropped=%u\n",
+           tag, t.setupStartUs, t.setupDoneUs, t.firstFrameUs, t.dropped);
+    for (int i = 0; i < t.count; i++)
+        printf("P %s %s %u %u\n", tag, t.phases[i].name, t.phases[i].startUs, t.phases[i].durUs);
+    printf("S %s pending=%u released=%u done=%u max_step=%u\n",
+           tag, s.pending, s.releasedMs, s.doneMs, s.maxStepUs);
+    for (int i = 0; i < s.count; i++)
+    {
+        const BootTask &k = s.tasks[i];
+        printf("K %s %s state=%s calls=%u attempts=%u first=%u end=%u run=%u\n", tag, k.name,
+               bootTaskStateName(k.state), k.calls, k.attempts, k.firstRunMs, k.endMs, k.runUs);
+    }
+}
+
+int main()
+{
+    // ---- Normal boot ----
+    nowUs = 310000;                             // app start to setup()
+    bootTimelineReset(t, nowUs);
+    bootSchedReset(s, clockUs);
+    phase("console", 4000);
+    phase("config", 25000);
+    phase("serial2", 1000);
+    phase("filesystem", 60000);
+    phase("wiring", 8000);
+    int scan = bootSchedAdd(s, "i2c_scan", taskScan, 0, 0, 0);
+    phase("servos", 12000);
+    int sound = bootSchedAdd(s, "sound", taskSound, 0, nowMs() + 3000, 0);
+    phase("logic", 3000);
+    int wifi = bootSchedAdd(s, "wifi", taskWifi, 0, 0, 0);
+    int web = bootSchedAdd(s, "web", taskWaitWifi, bootSchedBit(wifi), 0, 0);
+    int mdns = bootSchedAdd(s, "mdns", taskWaitWifi, bootSchedBit(web), 0, 0);
+    phase("tasks", 2000);
+    bootTimelineSetupDone(t, nowUs);
+    printf("D ids %d %d %d %d %d\n", scan, sound, wifi, web, mdns);
+    printf("D before_release %d\n", bootSchedStep(s, nowMs()));
+    loopUntil(10000);
+    dump("boot");
+
+    // ---- Registration rules ----
+    BootScheduler r;
+    bootSchedReset(r, clockUs);
+    int a = bootSchedAdd(r, "a", taskScan, 0, 0, 0);
+    printf("D forward_dep %d\n", bootSchedAdd(r, "b", taskScan, bootSchedBit(1), 0, 0));
+    printf("D self_dep %d\n", bootSchedAdd(r, "b", taskScan, bootSchedBit(a) | bootSchedBit(1), 0, 0));
+    int full = 0;
+    while (bootSchedAdd(r, "x", taskScan, 0, 0, 0) >= 0)
+        full++;
+    printf("D capacity %d\n", 1 + full);
+
+    // ---- A dependency that gives up ----
+    scenario = "fail";
+    nowUs = 0;
+    bootTimelineReset(t, nowUs);
+    bootSchedReset(s, clockUs);
+    int flaky = bootSchedAdd(s, "flaky", taskNever, 0, 0, 3);
+    int child = bootSchedAdd(s, "child", taskScan, bootSchedBit(flaky), 0, 0);
+    bootSchedAdd(s, "grandchild", taskScan, bootSchedBit(child), 0, 0);
+    scanSlices = 0;
+    bootSchedAdd(s, "independent", taskScan, 0, 0, 0);
+    phase("only", 1000);
+    for (int i = 0; i < BOOT_TIMELINE_MAX_PHASES + 2; i++)
+        phase("extra", 10);
+    bootTimelineSetupDone(t, nowUs);
+    loopUntil(200);
+    dump("fail");
+    printf("D second_first_frame %d\n", bootTimelineFirstFrame(t, nowUs) ? 1 : 0);
+    return 0;
+}
+"""
+
+
+class BootScheduleTests(HarnessTestCase):
+    HARNESS_NAME = "boot_harness"
+    HARNESS = HARNESS
+
+    @classmethod
+    def setUpClass(cls) -> None:
+        super().setUpClass()
+        cls.lines = run_harness(cls.binary)
+
+    def value(self, key: str) -> str:
+        for line in self.lines:
+            if line.startswith(f"D {key} "):
+                return line.split(" ", 2)[2]
+        self.fail(f"missing {key}")
+
+    def fields(self, prefix: str, tag: str, name: str | None = None) -> dict[str, int | str]:
+        for line in self.lines:
+            parts = line.split()
+            if parts[:2] != [prefix, tag] or (name is not None and parts[2] != name):
+                continue
+            out: dict[str, int | str] = {}
+            for f in parts[2:]:
+                if "=" in f:
+                    k, v = f.split("=")
+                    out[k] = int(v) if v.isdigit() else v
+            return out
+        self.fail(f"missing {prefix} {tag} {name}")
+
+    def phases(self, tag: str) -> list[tuple[str, int, int]]:
+        return [(p[2], int(p[3]), int(p[4])) for p in (line.split() for line in self.lines)
+                if p[:2] == ["P", tag]]
+
+    def runs(self, tag: str = "boot") -> list[tuple[int, str, str]]:
+        return [(int(p[2]), p[3], p[4]) for p in (line.split() for line in self.lines) if p[:2] == ["R", tag]]
+
+    def test_setup_phases_are_contiguous_and_timed(self) -> None:
+        phases = self.phases("boot")
+        self.assertEqual([p[0] for p in phases],
+                         ["console", "config", "serial2", "filesystem", "wiring", "servos", "logic", "tasks"])
+        self.assertEqual(phases[0][1], 310000)
+        for (_, start, dur), (_, nxt, _) in zip(phases, phases[1:]):
+            self.assertEqual(start + dur, nxt)
+        self.assertEqual([p[2] for p in phases], [4000, 25000, 1000, 60000, 8000, 12000, 3000, 2000])
+        timeline = self.fields("T", "boot")
+        self.assertEqual(timeline["setup_done"], 310000 + 115000)
+
+    def test_nothing_runs_before_the_first_frame(self) -> None:
+        self.assertEqual(int(self.value("before_release")), -1)
+        first_frame = int(self.lines[[line.startswith("F ") for line in self.lines].index(True)].split()[1])
+        # First mainLoop() pass after setup(): no deferred work ahead of it.
+        self.assertEqual(first_frame, 310000 + 115000 + 2000)
+        self.assertEqual(self.fields("T", "boot")["first_frame"], first_frame)
+        self.assertTrue(all(t * 1000 >= first_frame for t, _, _ in self.runs()))
+
+    def test_one_step_per_pass_and_slices_stay_short(self) -> None:
+        times = [t for t, _, _ in self.runs()]
+        self.assertEqual(len(times), len(set(times)))
+        stats = self.fields("S", "boot")
+        # The longest step is the WiFi bring-up; the scan never holds the loop
+        # for more than one 16-address slice.
+        self.assertEqual(stats["max_step"], 90000)
+        scan = self.fields("K", "boot", "i2c_scan")
+        self.assertEqual((scan["state"], scan["calls"], scan["run"]), ("done", 8, 8 * 1500))
+
+    def test_dependencies_and_not_before_are_honoured(self) -> None:
+        order = {(name, state): t for t, name, state in self.runs() if state in ("done", "failed")}
+        wifi = self.fields("K", "boot", "wifi")
+        web = self.fields("K", "boot", "web")
+        mdns = self.fields("K", "boot", "mdns")
+        self.assertGreater(web["first"], wifi["end"])
+        self.assertGreaterEqual(web["end"], wifi["end"] + 2500)
+        self.assertGreater(mdns["first"], web["end"] - 1)
+        self.assertLess(order[("web", "done")], order[("mdns", "done")])
+        # Web polls every 100 ms while WiFi connects; polls are not attempts.
+        self.assertGreaterEqual(web["calls"], 20)
+        self.assertEqual(web["attempts"], 0)
+        sound = self.fields("K", "boot", "sound")
+        self.assertGreaterEqual(sound["first"], 425 + 3000 - 115 - 2)
+        self.assertEqual((sound["state"], sound["calls"], sound["attempts"]), ("done", 3, 2))
+        self.assertGreaterEqual(sound["end"] - sound["first"], 2000)
+
+    def test_all_tasks_finish(self) -> None:
+        stats = self.fields("S", "boot")
+        self.assertEqual(stats["pending"], 0)
+        self.assertEqual(stats["done"], max(t for t, _, _ in self.runs()))
+        self.assertEqual(self.value("ids"), "0 1 2 3 4")
+
+    def test_registration_rejects_forward_deps_and_overflow(self) -> None:
+        self.assertEqual(int(self.value("forward_dep")), -1)
+        self.assertEqual(int(self.value("self_dep")), -1)
+        self.assertEqual(int(self.value("capacity")), 8)
+
+    def test_dependents_of_a_failed_task_are_skipped(self) -> None:
+        flaky = self.fields("K", "fail", "flaky")
+        self.assertEqual((flaky["state"], flaky["calls"], flaky["attempts"]), ("failed", 3, 3))
+        self.assertEqual(self.fields("K", "fail", "child")["state"], "skipped")
+        self.assertEqual(self.fields("K", "fail", "child")["calls"], 0)
+        self.assertEqual(self.fields("K", "fail", "grandchild")["state"], "skipped")
+        self.assertEqual(self.fields("K", "fail", "independent")["state"], "done")
+        self.assertEqual(self.fields("S", "fail")["pending"], 0)
+
+    def test_timeline_is_bounded_and_first_frame_fires_once(self) -> None:
+        self.assertEqual(len(self.phases("fail")), 16)
+        self.assertEqual(self.fields("T", "fail")["dropped"], 3)
+        self.assertEqual(int(self.value("second_first_frame")), 0)
+
+
+if __name__ == "__main__":
+    unittest.main()
@@ -0,0 +1,196 @@
+#!/usr/bin/env python3
+"""Host tests for ChunkedJsonStream.h, the piecewise body writer behind the
+chunked JSON GET routes.
+
+Run with --report to compare the largest contiguous allocation per response
+before and after streaming.
+"""
+
+from __future__ import annotations
+
+import sys
+import unittest
+from pathlib import Path
+
+
+ROOT = Path(__file__).resolve().parents[1]
+sys.path.insert(0, str(ROOT / "tools"))
+
+from host_harness import HarnessTestCase, compile_harness, report_workdir, run_harness  # noqa: E402
+
+HARNESS = r"""
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "ChunkedJsonStream.h"
+
+// stdin: one piece per line, "o <text>" (owned) or "b <text>" (borrowed);
+// "o -" is an empty piece. argv: buffer size, then optionally the piece index
+// at which the source aborts. Prints the body on one line, then the stats.
+struct Source
+{
+    char text[64][300];
+    bool owned[64];
+    int count;
+    int index;
+    int abortAt;
+};
+
+static ChunkedJsonStep next(void *ctx, ChunkedJsonPiece &piece)
+{
+    Source &src = *(Source *)ctx;
+    if (src.index == src.abortAt) return kChunkedJsonAbort;
+    int i = src.index++;
+    piece.data = src.text[i];
+    piece.len = strlen(src.text[i]);
+    piece.owned = src.owned[i];
+    return src.index >= src.count ? kChunkedJsonLast : kChunkedJsonMore;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 2) return 2;
+    static Source src;
+    src.abortAt = argc > 2 ? atoi(argv[2]) : -1;
+    char line[300];
+    while (src.count < 64 && fgets(line, sizeof(line), stdin))
+    {
+        line[strcspn(line, "\n")] = '\0';
+        if (strlen(line) < 2) continue;
+        const char *text = line + 2;
+        if (strcmp(text, "-") == 0) text = "";
+        src.owned[src.count] = line[0] == 'o';
+        snprintf(src.text[src.count], sizeof(src.text[0]), "%s", text);
+        src.count++;
+    }
+    ChunkedJsonCursor cursor;
+    chunkedJsonBegin(cursor, next, &src);
+    size_t cap = (size_t)atoi(argv[1]);
+    static uint8_t buffer[4096];
+    unsigned fills = 0;
+    size_t end;
+    // Drives the cursor the way the chunked response callback does: 0 means
+    // send the terminating chunk, kChunkedJsonDrop means reset instead.
+    for (;;)
+    {
+        size_t n = chunkedJsonFillChunk(cursor, buffer, cap);
+        if (n == 0 || n == kChunkedJsonDrop)
+        {
+            end = n;
+            break;
+        }
+        if (n > cap) return 3;
+        fwrite(buffer, 1, n, stdout);
+        fills++;
+        if (fills > 100000) return 4;
+    }
+    // A finished cursor keeps reporting the same end.
+    if (chunkedJsonFillChunk(cursor, buffer, cap) != end) return 5;
+    ChunkedJsonStats stats;
+    memset(&stats, 0, sizeof(stats));
+    chunkedJsonRecord(stats, cursor);
+    printf("\nfills %u\nresponses %u\naborted %u\nbody %u\npeak_piece %u\nterminated %u\n",
+           fills, stats.responses, stats.aborted, stats.lastBodyBytes, stats.peakPieceBytes,
+           end == 0 ? 1u : 0u);
+    return 0;
+}
+"""
+
+
+def run_stream(binary: Path, pieces: list[tuple[str, str]], cap: int,
+               abort_at: int | None = None) -> tuple[str, dict[str, int]]:
+    stdin = "".join(f"{kind} {text or '-'}\n" for kind, text in pieces)
+    args = [str(cap)] + ([str(abort_at)] if abort_at is not None else [])
+    out = "\n".join(run_harness(binary, *args, stdin=stdin))
+    body, _, tail = out.rpartition("\nfills ")
+    stats = dict(line.split(" ", 1) for line in ("fills " + tail).splitlines())
+    return body, {key: int(value) for key, value in stats.items()}
+
+
+class ChunkedJsonStreamTests(HarnessTestCase):
+    HARNESS_NAME = "chunked_harness"
+    HARNESS = HARNESS
+
+    PIECES = [
+        ("b", '{"schema_version":1,"elements":['),
+        ("o", '"runtime_state_ts":1234,'),
+        ("b", '{"id":"P1","label":"Panel 1"'),
+        ("o", ',"disabled":false}'),
+        ("b", ',{"id":"P2"'),
+        ("o", ',"disabled":true,"reason":"servo_jammed"}'),
+        ("b", "]}"),
+    ]
+
+    def test_body_is_identical_at_every_buffer_size(self) -> None:
+        expected = "".join(text for _, text in self.PIECES)
+        for cap in list(range(1, 40)) + [len(expected) - 1, len(expected), 1436]:
+            body, stats = run_stream(self.binary, self.PIECES, cap)
+            self.assertEqual(body, expected, cap)
+            self.assertEqual(stats["body"], len(expected))
+            self.assertEqual(stats["aborted"], 0)
+            self.assertEqual(stats["terminated"], 1)
+            self.assertEqual(stats["fills"], -(-len(expected) // cap), cap)
+
+    def test_peak_piece_counts_owned_pieces_only(self) -> None:
+        _, stats = run_stream(self.binary, self.PIECES, 64)
+        owned = max(len(text) for kind, text in self.PIECES if kind == "o")
+        self.assertEqual(stats["peak_piece"], owned)
+        _, stats = run_stream(self.binary, [("b", "x" * 200), ("b", "y" * 200)], 64)
+        self.assertEqual(stats["peak_piece"], 0)
+
+    def test_empty_pieces_are_skipped(self) -> None:
+        pieces = [("o", ""), ("b", "[1"), ("o", ""), ("o", ""), ("b", ",2]"), ("o", "")]
+        for cap in (1, 2, 8):
+            body, stats = run_stream(self.binary, pieces, cap)
+            self.assertEqual(body, "[1,2]")
+            self.assertEqual(stats["aborted"], 0)
+        body, stats = run_stream(self.binary, [("o", "")], 8)
+        self.assertEqual((body, stats["fills"], stats["aborted"]), ("", 0, 0))
+
+    def test_abort_truncates_and_is_counted(self) -> None:
+        body, stats = run_stream(self.binary, self.PIECES, 16, abort_at=3)
+        self.assertEqual(body, "".join(text for _, text in self.PIECES[:3]))
+        self.assertEqual(stats["aborted"], 1)
+        self.assertEqual(stats["body"], len(body))
+        body, stats = run_stream(self.binary, self.PIECES, 16, abort_at=0)
+        self.assertEqual((body, stats["aborted"]), ("", 1))
+
+    def test_aborted_body_never_sends_the_terminating_chunk(self) -> None:
+        for abort_at in range(len(self.PIECES)):
+            for cap in (1, 7, 16, 1436):
+                body, stats = run_stream(self.binary, self.PIECES, cap, abort_at=abort_at)
+                self.assertEqual(stats["terminated"], 0, (abort_at, cap))
+                self.assertEqual(body, "".join(text for _, text in self.PIECES[:abort_at]))
+
+
+def report() -> int:
+    from generate_dome_layout_header import DEFAULT_TEMPLATE
+
+    # The layout cache keeps the composed template minus the overlay; each
+    # element adds one overlay piece (~60 B with a short reason).
+    static_bytes = len(DEFAULT_TEMPLATE.read_bytes())
+    elements = DEFAULT_TEMPLATE.read_text(encoding="utf-8").count('"id"')
+    overlay = ',"disabled":true,"reason":"servo_jammed","active":true}'
+    pieces: list[tuple[str, str]] = []
+    chunk = max(1, static_bytes // (elements + 1))
+    for _ in range(elements):
+        pieces.append(("b", "x" * min(chunk, 290)))
+        pieces.append(("o", overlay))
+    with report_workdir() as workdir:
+        binary = compile_harness(workdir, "chunked_harness", HARNESS)
+        _, stats = run_stream(binary, pieces, 1436)
+    layout_body = static_bytes + elements * len(overlay)
+    log_body = 50 * (120 + 8) + 32
+    print("Chunked JSON GET responses: largest contiguous allocation per response")
+    print(f"  dome_layout ({elements} elements): before ~{layout_body} B body String copied from the cache; "
+          f"after {stats['peak_piece']} B overlay scratch, static text borrowed")
+    print(f"  logs (50 x 120 char lines, worst case): before ~{log_body} B; after one line (~130 B)")
+    print("  panels/holos config: before the full slot array; after one slot object (~40 B)")
+    print("  diag_i2c: before the whole report; after the largest of 3 sections")
+    return 0
+
+
+if __name__ == "__main__":
+    if "--report" in sys.argv:
+        sys.exit(report())
+    unittest.main()
@@ -0,0 +1,511 @@
+#!/usr/bin/env python3
+"""Host tests for ConfigRegistry.h, the typed RAM copy of the NVS preferences.
+
+The schema is compiled against the real PREFERENCE_* keys and compile-time
+defaults lifted from AstroPixelsPlus.ino, then exercised with a fake store,
+including /api/prefs batches (per-key validation errors and rollback).
+Run with --report for the schema table and RAM footprint.
+"""
+
+from __future__ import annotations
+
+import re
+import sys
+import unittest
+from pathlib import Path
+
+
+ROOT = Path(__file__).resolve().parents[1]
+sys.path.insert(0, str(ROOT / "tools"))
+
+from host_harness import HarnessTestCase, compile_harness, report_workdir, run_harness  # noqa: E402
+
+HEADER = ROOT / "ConfigRegistry.h"
+SKETCH = ROOT / "AstroPixelsPlus.ino"
+
+# NVS key names are limited to 15 characters.
+NVS_KEY_MAX = 15
+
+HARNESS = r"""
+#include <stdio.h>
+#include <string.h>
+#include "ConfigRegistry.h"
+
+// Fake store: a flat table keyed like NVS, with write counting and an
+// injectable failure.
+struct FakeEntry { char key[16]; bool text; int32_t value; char str[80]; };
+static FakeEntry sFake[64];
+static int sFakeCount = 0;
+static int sFakeWrites = 0;
+static bool sFakeFail = false;
+static int sFakeFailAt = -1;    // fail the save once sFakeWrites reaches this, then recover
+
+static FakeEntry *fakeFind(const char *key)
+{
+    for (int i = 0; i < sFakeCount; i++)
+        if (strcmp(sFake[i].key, key) == 0) return &sFake[i];
+    return nullptr;
+}
+static FakeEntry *fakeSlot(const char *key)
+{
+    FakeEntry *e = fakeFind(key);
+    if (!e) { e = &sFake[sFakeCount++]; memset(e, 0, sizeof(*e)); strcpy(e->key, key); }
+    return e;
+}
+static void fakePutInt(const char *key, int32_t v) { FakeEntry *e = fakeSlot(key); e->text = false; e->value = v; }
+static void fakePutText(const char *key, const char *s) { FakeEntry *e = fakeSlot(key); e->text = true; strcpy(e->str, s); }
+
+static bool fakeLoadInt(const ConfigKeyDef &def, int32_t &value)
+{
+    FakeEntry *e = fakeFind(def.key);
+    if (!e || e->text) return false;
+    value = e->value;
+    return true;
+}
+static bool fakeLoadText(const ConfigKeyDef &def, char *text, size_t size)
+{
+    FakeEntry *e = fakeFind(def.key);
+    if (!e || !e->text) return false;
+    snprintf(text, size, "%s", e->str);
+    return true;
+}
+static bool fakeFailNow()
+{
+    if (sFakeFailAt >= 0 && sFakeWrites >= sFakeFailAt) { sFakeFailAt = -1; return true; }
+    return sFakeFail;
+}
+
+static bool fakeSaveInt(const ConfigKeyDef &def, int32_t value)
+{
+    if (fakeFailNow()) return false;
+    sFakeWrites++;
+    fakePutInt(def.key, value);
+    return true;
+}
+static bool fakeSaveText(const ConfigKeyDef &def, const char *text)
+{
+    if (fakeFailNow()) return false;
+    sFakeWrites++;
+    fakePutText(def.key, text);
+    return true;
+}
+static bool fakeClear() { sFakeCount = 0; return !sFakeFail; }
+
+static const ConfigStore kFakeStore = { fakeLoadInt, fakeLoadText, fakeSaveInt, fakeSaveText, fakeClear };
+
+static int sHeard[kConfigKeyCount + 1];
+static void onChange(ConfigKeyId id, void *ctx) { sHeard[id]++; (*(int *)ctx)++; }
+
+static void printValue(ConfigKeyId id)
+{
+    char text[CONFIG_REGISTRY_MAX_TEXT + 1];
+    const ConfigKeyDef &def = configKeyDef(id);
+    if (def.type == kConfigText) { configGetText(id, text, sizeof(text)); printf("V %s \"%s\"\n", def.key, text); }
+    else if (def.type != kConfigBlob) printf("V %s %d\n", def.key, (int)configGetInt(id));
+}
+
+static void trySet(const char *key, const char *value)
+{
+    const char *err = "";
+    ConfigKeyId id = configFindKey(key);
+    if (id == kConfigKeyCount) err = "unknown key";
+    bool ok = id != kConfigKeyCount && configSetFromText(id, value, err);
+    printf("S %s %s %s\n", key, ok ? "ok" : "err", ok ? "-" : err);
+}
+
+// Parses and applies one /api/prefs body the way the web handler does.
+static void tryBatch(const char *json)
+{
+    char buf[CONFIG_REGISTRY_MAX_BATCH_BYTES + 1];
+    snprintf(buf, sizeof(buf), "%s", json);
+    ConfigBatchEntry entries[kConfigKeyCount];
+    uint8_t count = 0, invalid = 0;
+    const char *err = "";
+    if (!configParseBatch(buf, entries, kConfigKeyCount, count, invalid, err))
+    {
+        printf("B malformed %s\n", err);
+        return;
+    }
+    if (invalid)
+    {
+        printf("B invalid %u\n", invalid);
+        for (uint8_t i = 0; i < count; i++)
+            if (entries[i].error) printf("E %s %s\n", entries[i].key, entries[i].error);
+        return;
+    }
+    if (!configApplyBatch(entries, count, err))
+    {
+        printf("B failed %s\n", err);
+        return;
+    }
+    printf("B ok");
+    for (uint8_t i = 0; i < count; i++)
+        if (entries[i].changed) printf(" %s", entries[i].key);
+    printf("\n");
+}
+
+int main(int argc, char **argv)
+{
+    const char *mode = argc > 1 ? argv[1] : "";
+    if (strcmp(mode, "schema") == 0)
+    {
+        for (int i = 0; i < kConfigKeyCount; i++)
+        {
+            const ConfigKeyDef &d = kConfigSchema[i];
+            printf("K %s %d %d %d %d %d \"%s\"\n", d.key, (int)d.type, (int)d.flags, (int)d.min, (int)d.max,
+                   (int)d.defInt, d.defText ? d.defText : "");
+        }
+        printf("R pool %u\nR ints %u\nR offsets %u\nR listeners %u\n", (unsigned)kConfigTextPoolBytes,
+               (unsigned)sizeof(sConfigInt), (unsigned)sizeof(sConfigTextOffset), (unsigned)sizeof(sConfigListeners));
+        return 0;
+    }
+    if (strcmp(mode, "batch") == 0)
+    {
+        configRegistryBegin(kFakeStore);
+        int anyCalls = 0;
+        configSubscribe(kConfigKeyCount, onChange, &anyCalls);
+        tryBatch("{ \"mvolume\": 750, \"wifi\":false, \"dname\":\"R2\\\"D2\", \"mserial2\":\"2400\", \"mrandom\":true }");
+        printValue(kCfgSoundVolume);
+        printValue(kCfgWifiEnabled);
+        printValue(kCfgDroidName);
+        printf("C writes %d\nC calls %d\n", sFakeWrites, anyCalls);
+        tryBatch("{}");
+        tryBatch("{\"mvolume\":1001,\"nokey\":1,\"ssid\":5,\"ap\":\"maybe\",\"rpaired\":\"x\","
+                 "\"dname\":null,\"wifi\":true,\"wifi\":false,\"mserial2\":-5,\"mvolume\":10}");
+        tryBatch("{\"mvolume\":1");
+        tryBatch("[1]");
+        tryBatch("{\"mvolume\" 1}");
+        tryBatch("{\"dname\":\"\\u0041\"}");
+        tryBatch("{\"mvolume\":1} x");
+        tryBatch("{\"mvolume\":1,}");
+        printf("C writes %d\nC calls %d\n", sFakeWrites, anyCalls);
+        // Third write fails: the first two are restored, RAM and listeners untouched.
+        sFakeWrites = 0;
+        sFakeFailAt = 2;
+        tryBatch("{\"mvolume\":100,\"ssid\":\"Shop\",\"ap\":false,\"dname\":\"X\"}");
+        FakeEntry *volume = fakeFind("mvolume");
+        FakeEntry *ssid = fakeFind("ssid");
+        printf("C stored_volume %d\nC stored_ssid %s\n", volume ? (int)volume->value : -1,
+               ssid ? (ssid->text ? ssid->str : "int") : "none");
+        printValue(kCfgSoundVolume);
+        printValue(kCfgWifiSsid);
+        printValue(kCfgWifiAccessPoint);
+        printf("C calls %d\nC batches %u\nC rollbacks %u\n", anyCalls,
+               (unsigned)sConfigStats.batches, (unsigned)sConfigStats.rollbacks);
+        return 0;
+    }
+    if (strcmp(mode, "defaults") == 0)
+    {
+        configRegistryBegin(kFakeStore);
+        printf("C loaded %u\n", (unsigned)sConfigStats.loaded);
+        for (int i = 0; i < kConfigKeyCount; i++) printValue(ConfigKeyId(i));
+        return 0;
+    }
+    // Stored values: some valid, one out of range, one too long.
+    fakePutInt("mvolume", 700);
+    fakePutInt("msound", 9);
+    fakePutInt("wifi", 0);
+    fakePutInt("mbodylink", 5);
+    fakePutText("dname", "A name that is much longer than the limit");
+    fakePutText("ssid", "Workshop");
+    configRegistryBegin(kFakeStore);
+    printf("C loaded %u\nC rejected %u\n", (unsigned)sConfigStats.loaded, (unsigned)sConfigStats.rejected);
+    printValue(kCfgSoundVolume);
+    printValue(kCfgSoundModule);
+    printValue(kCfgWifiEnabled);
+    printValue(kCfgBodyLinkEnabled);
+    printValue(kCfgDroidName);
+    printValue(kCfgWifiSsid);
+
+    int volumeCalls = 0, anyCalls = 0;
+    configSubscribe(kCfgSoundVolume, onChange, &volumeCalls);
+    configSubscribe(kConfigKeyCount, onChange, &anyCalls);
+
+    sFakeWrites = 0;
+    trySet("mvolume", "250");
+    trySet("mvolume", "250");        // unchanged: no write, no notification
+    trySet("mvolume", "1001");
+    trySet("mvolume", "-1");
+    trySet("mvolume", "12a");
+    trySet("mvolume", "");
+    trySet("mvolume", "99999999999");
+    trySet("wifi", "true");
+    trySet("wifi", "on");
+    trySet("ap", "0");
+    trySet("dname", "R2-Q5");
+    trySet("dname", "0123456789012345678901234");
+    trySet("rpaired", "1");
+    trySet("nokey", "1");
+    printf("C writes %d\nC volume_calls %d\nC any_calls %d\n", sFakeWrites, volumeCalls, anyCalls);
+    printValue(kCfgSoundVolume);
+    printValue(kCfgWifiEnabled);
+    printValue(kCfgDroidName);
+    FakeEntry *stored = fakeFind("mvolume");
+    printf("C stored_volume %d\n", stored ? (int)stored->value : -1);
+
+    sFakeFail = true;
+    trySet("mvolume", "300");
+    trySet("ssid", "Other");
+    sFakeFail = false;
+    printValue(kCfgSoundVolume);
+    printValue(kCfgWifiSsid);
+    printf("C write_errors %u\n", (unsigned)sConfigStats.writeErrors);
+
+    memset(sHeard, 0, sizeof(sHeard));
+    const char *err = "";
+    printf("C reset %d\n", configRegistryReset(err) ? 1 : 0);
+    printf("C store_after_reset %d\n", sFakeCount);
+    printValue(kCfgSoundVolume);
+    printValue(kCfgWifiSsid);
+    printValue(kCfgDroidName);
+    for (int i = 0; i < kConfigKeyCount; i++)
+        if (sHeard[i]) printf("N %s %d\n", kConfigSchema[i].key, sHeard[i]);
+    return 0;
+}
+"""
+
+
+def sketch_defines() -> dict[str, str]:
+    """First plain `#define NAME value` for each name in the sketch."""
+    defines: dict[str, str] = {}
+    for line in SKETCH.read_text(encoding="utf-8").splitlines():
+        m = re.match(r"#define\s+(\w+)[ \t]+(.+)$", line)
+        if not m:
+            continue
+        value = re.sub(r"\s*(//.*|/\*.*\*/)\s*$", "", m.group(2)).strip()
+        defines.setdefault(m.group(1), value)
+    return defines
+
+
+def preference_defines() -> list[tuple[str, str]]:
+    text = SKETCH.read_text(encoding="utf-8")
+    return re.findall(r'^#define (PREFERENCE_\w+)\s+"([^"]+)"', text, re.M)
+
+
+def schema_entries() -> list[tuple[str, str, str]]:
+    text = HEADER.read_text(encoding="utf-8")
+    return re.findall(r"CFG_(BOOL|INT|TEXT|BLOB)\((\w+), (PREFERENCE_\w+)", text)
+
+
+def schema_block() -> str:
+    text = HEADER.read_text(encoding="utf-8")
+    start = text.index("#define CONFIG_REGISTRY_SCHEMA(")
+    return text[start:text.index("\n\n", start)]
+
+
+def prelude() -> str:
+    """Sketch defines the schema refers to, plus the MarcSound module enum."""
+    defines = sketch_defines()
+    wanted: list[str] = []
+    pending = re.findall(r"\b[A-Z][A-Z0-9_]+\b", schema_block())
+    while pending:
+        name = pending.pop(0)
+        if name in defines and name not in wanted:
+            wanted.append(name)
+            pending.extend(re.findall(r"\b[A-Z][A-Z0-9_]+\b", defines[name]))
+    sound = (ROOT / "MarcduinoSound.h").read_text(encoding="utf-8")
+    module = re.search(r"enum Module\s*\{[^}]*\};", sound)
+    assert module is not None
+    lines = [f"struct MarcSound {{ {module.group(0)} }};"]
+    lines += [f"#define {name} {defines[name]}" for name in reversed(wanted)]
+    return "\n".join(lines) + "\n"
+
+
+def build_harness(workdir: Path) -> Path:
+    return compile_harness(workdir, "config_harness", prelude() + HARNESS)
+
+
+class ConfigHarnessTestCase(HarnessTestCase):
+    @classmethod
+    def build(cls, workdir: Path) -> Path:
+        return build_harness(workdir)
+
+
+class ConfigSchemaTests(unittest.TestCase):
+    def test_every_preference_define_is_in_the_schema(self) -> None:
+        defines = preference_defines()
+        names = [name for name, _ in defines]
+        keys = [key for _, key in defines]
+        self.assertEqual(len(names), len(set(names)), "duplicate PREFERENCE_* define")
+        self.assertEqual(len(keys), len(set(keys)), "two defines share an NVS key")
+        schema = [name for _, _, name in schema_entries()]
+        self.assertEqual(len(schema), len(set(schema)), "key declared twice in the schema")
+        self.assertEqual(sorted(schema), sorted(names))
+        for key in keys:
+            self.assertLessEqual(len(key), NVS_KEY_MAX, key)
+
+
+class ConfigRegistryTests(ConfigHarnessTestCase):
+    @classmethod
+    def setUpClass(cls) -> None:
+        super().setUpClass()
+        cls.schema = run_harness(cls.binary, "schema")
+        cls.defaults = run_harness(cls.binary, "defaults")
+        cls.lines = run_harness(cls.binary)
+
+    def tagged(self, lines: list[str], tag: str) -> dict[str, str]:
+        return dict(line[2:].split(" ", 1) for line in lines if line.startswith(tag + " "))
+
+    def test_schema_keys_match_sketch_values(self) -> None:
+        keys = {line.split()[1] for line in self.schema if line.startswith("K ")}
+        self.assertEqual(keys, {key for _, key in preference_defines()})
+
+    def test_defaults_come_from_the_sketch(self) -> None:
+        values = self.tagged(self.defaults, "V")
+        defines = sketch_defines()
+        self.assertEqual(self.tagged(self.defaults, "C")["loaded"], "0")
+        self.assertEqual(values["mserial2"], defines["MARC_SERIAL2_BAUD_RATE"])
+        self.assertEqual(values["mvolume"], defines["MARC_SOUND_VOLUME"])
+        self.assertEqual(values["mrandommax"], defines["MARC_SOUND_RANDOM_MAX"])
+        self.assertEqual(values["ssid"], defines["WIFI_AP_NAME"])
+        self.assertEqual(values["rhost"], defines["SMQ_HOSTNAME"])
+        self.assertEqual(values["msound"], "0")
+        self.assertEqual(values["mbodylink"], "1")
+        self.assertEqual(values["holo_boot_loop"], "1")
+        self.assertEqual(values["dm_happy_sound"], "1")
+        self.assertEqual(values["ledrtask"], "0")
+        self.assertEqual(values["bodypeerip"], '""')
+        self.assertNotIn("rpaired", values)
+
+    def test_stored_values_are_loaded_and_bounded(self) -> None:
+        counts = self.tagged(self.lines, "C")
+        self.assertEqual(counts["loaded"], "6")
+        self.assertEqual(counts["rejected"], "1")
+        values = {}
+        for line in self.lines:
+            if line.startswith("V "):
+                key, value = line[2:].split(" ", 1)
+                values.setdefault(key, value)
+        self.assertEqual(values["mvolume"], "700")
+        self.assertEqual(values["msound"], "0")          # 9 is not a sound module
+        self.assertEqual(values["wifi"], "0")
+        self.assertEqual(values["mbodylink"], "1")
+        self.assertEqual(values["dname"], '"A name that is much long"')
+        self.assertEqual(values["ssid"], '"Workshop"')
+
+    def test_writes_are_validated_against_the_schema(self) -> None:
+        results = [line.split(" ", 3)[1:] for line in self.lines if line.startswith("S ")]
+        self.assertEqual(results[:14], [
+            ["mvolume", "ok", "-"],
+            ["mvolume", "ok", "-"],
+            ["mvolume", "err", "value out of range"],
+            ["mvolume", "err", "invalid integer value"],
+            ["mvolume", "err", "invalid integer value"],
+            ["mvolume", "err", "invalid integer value"],
+            ["mvolume", "err", "invalid integer value"],
+            ["wifi", "ok", "-"],
+            ["wifi", "err", "invalid boolean value"],
+            ["ap", "ok", "-"],
+            ["dname", "ok", "-"],
+            ["dname", "err", "value too long"],
+            ["rpaired", "err", "key not writable"],
+            ["nokey", "err", "unknown key"],
+        ])
+
+    def test_write_through_and_notifications(self) -> None:
+        counts = self.tagged(self.lines, "C")
+        # mvolume, wifi, ap, dname: one store write each; the repeat is free.
+        self.assertEqual(counts["writes"], "4")
+        self.assertEqual(counts["volume_calls"], "1")
+        self.assertEqual(counts["any_calls"], "4")
+        self.assertEqual(counts["stored_volume"], "250")
+        values = [line for line in self.lines if line.startswith("V ")]
+        self.assertIn("V mvolume 250", values)
+        self.assertIn('V dname "R2-Q5"', values)
+
+    def test_failed_store_write_leaves_ram_unchanged(self) -> None:
+        results = [line for line in self.lines if line.startswith("S ")]
+        self.assertEqual(results[14:], ["S mvolume err store write failed", "S ssid err store write failed"])
+        self.assertEqual(self.tagged(self.lines, "C")["write_errors"], "2")
+        after = self.lines[self.lines.index("S ssid err store write failed") + 1:]
+        self.assertEqual(after[:2], ["V mvolume 250", 'V ssid "Workshop"'])
+
+    def test_reset_restores_defaults_and_notifies_changed_keys(self) -> None:
+        counts = self.tagged(self.lines, "C")
+        self.assertEqual(counts["reset"], "1")
+        self.assertEqual(counts["store_after_reset"], "0")
+        tail = self.lines[self.lines.index("C store_after_reset 0") + 1:]
+        self.assertEqual(tail[:3], ["V mvolume 500", 'V ssid "AstroPixels"', 'V dname "AstroPixels"'])
+        notified = self.tagged(tail, "N")
+        # wifi was already set back to its default, so it stays quiet.
+        self.assertEqual(sorted(notified), ["ap", "dname", "mvolume", "ssid"])
+
+
+class ConfigBatchTests(ConfigHarnessTestCase):
+    @classmethod
+    def setUpClass(cls) -> None:
+        super().setUpClass()
+        cls.lines = run_harness(cls.binary, "batch")
+
+    def test_valid_batch_writes_only_changed_keys(self) -> None:
+        # mserial2 and mrandom already hold their defaults: not written, not reported.
+        self.assertEqual(self.lines[0], "B ok mvolume wifi dname")
+        self.assertEqual(self.lines[1:4], ["V mvolume 750", "V wifi 0", "V dname \"R2\"D2\""])
+        self.assertEqual(self.lines[4:6], ["C writes 3", "C calls 3"])
+        self.assertEqual(self.lines[6], "B ok")
+
+    def test_every_invalid_pair_is_reported_and_nothing_is_written(self) -> None:
+        start = self.lines.index("B invalid 9")
+        errors = self.lines[start + 1:start + 10]
+        self.assertEqual(errors, [
+            "E mvolume value out of range",
+            "E nokey unknown key",
+            "E ssid expected string",
+            "E ap invalid boolean value",
+            "E rpaired key not writable",
+            "E dname invalid value",
+            "E wifi duplicate key",
+            "E mserial2 invalid value",
+            "E mvolume duplicate key",
+        ])
+
+    def test_malformed_documents_are_rejected(self) -> None:
+        malformed = [line for line in self.lines if line.startswith("B malformed")]
+        self.assertEqual(malformed, [
+            "B malformed expected ',' or '}'",
+            "B malformed expected JSON object",
+            "B malformed expected ':'",
+            "B malformed unicode escapes not supported",
+            "B malformed trailing data",
+            "B malformed expected key",
+        ])
+        counts = [line for line in self.lines if line.startswith("C writes") or line.startswith("C calls")]
+        self.assertEqual(counts[2:4], ["C writes 3", "C calls 3"])
+
+    def test_failed_write_rolls_the_batch_back(self) -> None:
+        start = self.lines.index("B failed store write failed")
+        self.assertEqual(self.lines[start + 1:], [
+            "C stored_volume 750",
+            "C stored_ssid AstroPixels",
+            "V mvolume 750",
+            'V ssid "AstroPixels"',
+            "V ap 1",
+            "C calls 3",
+            "C batches 2",
+            "C rollbacks 1",
+        ])
+
+
+def report() -> int:
+    with report_workdir() as workdir:
+        binary = build_harness(workdir)
+        names = {0: "bool", 1: "int", 2: "text", 3: "blob"}
+        print(f"{'key':<16} {'type':<5} {'flags':<16} {'bounds':<16} default")
+        for line in run_harness(binary, "schema"):
+            if line.startswith("K "):
+                key, kind, flags, lo, hi, defint, deftext = line[2:].split(" ", 6)
+                tags = [t for bit, t in ((1, "sensitive"), (2, "reboot")) if int(flags) & bit]
+                kind_name = names[int(kind)]
+                bounds = f"{lo}..{hi}" if kind_name == "int" else (f"len {hi}" if kind_name == "text" else "")
+                default = deftext if kind_name == "text" else ("" if kind_name == "blob" else defint)
+                print(f"{key:<16} {kind_name:<5} {','.join(tags):<16} {bounds:<16} {default}")
+            elif line.startswith("R "):
+                _, what, size = line.split()
+                print(f"ram {what}: {size} bytes")
+    return 0
+
+
+if __name__ == "__main__":
+    if "--report" in sys.argv:
+        sys.exit(report())
+    unittest.main()
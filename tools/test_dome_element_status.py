@@ -0,0 +1,294 @@
+#!/usr/bin/env python3
+"""Host tests for DomeElementStatus.h, the POST/PATCH /api/dome/element-status core.
+
+The header is compiled unchanged against the tools/host Arduino and
+Preferences stand-ins. A harness replays a script of saves, patches and
+reboots and reports what the routes would answer: the parsed request, the
+409 on a stale generation, which elements a save really changed, the
+WebSocket delta, that a failed save leaves nothing applied, and that NVS is
+only written by the write-behind flush.
+"""
+
+from __future__ import annotations
+
+import json
+import sys
+import unittest
+from pathlib import Path
+
+
+ROOT = Path(__file__).resolve().parents[1]
+sys.path.insert(0, str(ROOT / "tools"))
+
+from host_harness import HarnessTestCase, compile_harness, run_harness  # noqa: E402
+
+HARNESS = r"""
+#include <iostream>
+#include <string>
+#include "DomeElementStatus.h"
+
+static String escape(const String &in)
+{
+    String out;
+    for (size_t i = 0; i < in.length(); i++)
+    {
+        char c = in[i];
+        if (c == '"' || c == '\\') out += '\\';
+        out += c;
+    }
+    return out;
+}
+
+static String changedJson(const int *changed, int count)
+{
+    String json = "[";
+    for (int i = 0; i < count; i++)
+    {
+        if (i > 0) json += ',';
+        json += String("\"") + domeElementStatusElementId(changed[i]) + "\"";
+    }
+    return json + "]";
+}
+
+// What a reboot does to this module: the RAM table and staged write are
+// gone, NVS keeps whatever the last flush wrote. reboot() in the sketch
+// flushes first.
+static void reboot(uint32_t seed, bool flush)
+{
+    if (flush) domeElementStatusPersistNow();
+    free(sDomeElementStatusPending);
+    sDomeElementStatusPending = nullptr;
+    sDomeElementStatusPendingLen = 0;
+    sDomeElementStatusPersist = DomeElementStatusPersistStats();
+    sDomeElementStatusTableLoaded = false;
+    sDomeElementStatusGeneration = 1;
+    hostRandom = seed;
+    domeElementStatusLoad();
+}
+
+int main()
+{
+    // Start from a saved all-enabled table, as on a commissioned dome.
+    domeElementStatusLoad();
+    domeElementStatusSaveUpdates(nullptr, 0);
+    std::string line;
+    while (std::getline(std::cin, line))
+    {
+        size_t space = line.find(' ');
+        std::string cmd = line.substr(0, space);
+        String arg = space == std::string::npos ? String() : String(line.substr(space + 1));
+        int changed[DOME_ELEMENT_STATUS_MAX_ELEMENTS];
+        int changedCount = 0;
+        String errMsg;
+        String out;
+        if (cmd == "post")
+        {
+            DomeElementStatusUpdate updates[DOME_ELEMENT_STATUS_MAX_ELEMENTS];
+            int updateCount = 0;
+            if (!domeElementStatusParseBody(arg, updates, DOME_ELEMENT_STATUS_MAX_ELEMENTS,
+                                            updateCount, errMsg))
+                out = String("{\"status\":400,\"error\":\"") + escape(errMsg) + "\"}";
+            else if (!domeElementStatusSaveUpdates(updates, updateCount, changed, &changedCount))
+                out = String("{\"status\":500,\"changed\":") + changedCount + "}";
+            else
+                out = String("{\"status\":200,\"updated\":") + updateCount +
+                      ",\"changed\":" + changedJson(changed, changedCount) +
+                      ",\"delta\":" + domeElementStatusBuildDeltaJson(changed, changedCount, escape) + "}";
+        }
+        else if (cmd == "patch")
+        {
+            DomeElementStatusPatchResult result = domeElementStatusPatch(arg, changed, changedCount, errMsg);
+            if (result == kDomeElementStatusPatchInvalid)
+                out = String("{\"status\":400,\"error\":\"") + escape(errMsg) + "\"}";
+            else if (result == kDomeElementStatusPatchStale)
+                out = String("{\"status\":409,\"current\":") + domeElementStatusBuildJson(escape) + "}";
+            else if (result == kDomeElementStatusPatchSaveFailed)
+                out = String("{\"status\":500,\"changed\":") + changedCount + "}";
+            else
+                out = String("{\"status\":200,\"changed\":") + changedJson(changed, changedCount) +
+                      ",\"delta\":" + domeElementStatusBuildDeltaJson(changed, changedCount, escape) + "}";
+        }
+        else if (cmd == "get")
+        {
+            out = domeElementStatusBuildJson(escape);
+        }
+        else if (cmd == "failalloc")
+        {
+            // failalloc <n>: the next n allocations succeed, then one fails.
+            hostMallocFailAfter = atoi(arg.c_str());
+            out = "{}";
+        }
+        else if (cmd == "wipe")
+        {
+            // Erased NVS: status is unavailable until the next save.
+            hostNvs.clear();
+            reboot(1, false);
+            out = "{}";
+        }
+        else if (cmd == "reboot" || cmd == "crash")
+        {
+            // crash: power lost before the write-behind flush.
+            reboot((uint32_t)strtoul(arg.c_str(), nullptr, 10), cmd == "reboot");
+            out = "{}";
+        }
+        else
+        {
+            return 2;
+        }
+        printf("%s\n", out.c_str());
+    }
+    return 0;
+}
+"""
+
+
+def elements(*pairs: tuple) -> list[dict]:
+    entries = []
+    for pair in pairs:
+        entry = {"id": pair[0], "disabled": pair[1]}
+        if len(pair) > 2:
+            entry["disabled_reason"] = pair[2]
+        entries.append(entry)
+    return entries
+
+
+class DomeElementStatusTests(HarnessTestCase):
+    @classmethod
+    def build(cls, workdir: Path) -> Path:
+        return compile_harness(workdir, "dome_element_status_harness", HARNESS,
+                               flags=["-Wno-unused-function"], host_shims=True)
+
+    def run_script(self, *commands: str) -> list[dict]:
+        lines = run_harness(self.binary, stdin="\n".join(commands) + "\n")
+        return [json.loads(line) for line in lines]
+
+    def post(self, *pairs: tuple) -> str:
+        return "post " + json.dumps({"elements": elements(*pairs)})
+
+    def patch(self, generation: int, *pairs: tuple) -> str:
+        return "patch " + json.dumps({"generation": generation, "elements": elements(*pairs)})
+
+    def generation(self) -> int:
+        return self.run_script("get")[0]["generation"]
+
+    def test_patch_against_the_current_generation_applies(self) -> None:
+        gen = self.generation()
+        get, patched, after = self.run_script("get", self.patch(gen, ("PP3", True, "linkage")), "get")
+        self.assertEqual(get["generation"], gen)
+        self.assertEqual(patched["status"], 200)
+        self.assertEqual(patched["changed"], ["PP3"])
+        self.assertEqual(after["generation"], gen + 1)
+        entry = next(e for e in after["elements"] if e["id"] == "PP3")
+        self.assertEqual(entry, {"id": "PP3", "disabled": True, "disabled_reason": "linkage"})
+
+    def test_stale_generation_gets_409_with_the_current_table(self) -> None:
+        gen = self.generation()
+        first, stale, get = self.run_script(self.patch(gen, ("P1", True)),
+                                            self.patch(gen, ("P2", True)), "get")
+        self.assertEqual(first["status"], 200)
+        self.assertEqual(stale["status"], 409)
+        self.assertEqual(stale["current"], get)
+        self.assertEqual(get["generation"], gen + 1)
+        disabled = [e["id"] for e in get["elements"] if e["disabled"]]
+        self.assertEqual(disabled, ["P1"])
+
+    def test_unchanged_entries_are_not_counted(self) -> None:
+        gen = self.generation()
+        first, again, mixed = self.run_script(
+            self.post(("P1", True, "bent"), ("P2", False)),
+            self.patch(gen + 1, ("P1", True, "bent"), ("P2", False)),
+            self.patch(gen + 1, ("P1", True, "bent"), ("P3", True)))
+        # P2 was already enabled, so only P1 changed.
+        self.assertEqual(first["updated"], 2)
+        self.assertEqual(first["changed"], ["P1"])
+        # Nothing changes and the generation stays, so the next patch still applies.
+        self.assertEqual(again["changed"], [])
+        self.assertEqual(again["delta"]["generation"], gen + 1)
+        self.assertEqual(mixed["changed"], ["P3"])
+        self.assertEqual(mixed["delta"]["generation"], gen + 2)
+
+    def test_delta_lists_only_changed_elements_with_the_new_generation(self) -> None:
+        gen = self.generation()
+        (patched,) = self.run_script(self.patch(gen, ("HP2", True, 'says "no"'), ("P4", False)))
+        self.assertEqual(patched["delta"], {
+            "type": "elementStatus",
+            "generation": gen + 1,
+            "elements": [{"id": "HP2", "disabled": True, "disabled_reason": 'says "no"'}],
+        })
+
+    def test_enabling_drops_the_reason(self) -> None:
+        gen = self.generation()
+        _, enabled = self.run_script(self.patch(gen, ("P5", True, "loose")),
+                                     self.patch(gen + 1, ("P5", False)))
+        self.assertEqual(enabled["delta"]["elements"],
+                         [{"id": "P5", "disabled": False, "disabled_reason": None}])
+
+    def test_parse_errors(self) -> None:
+        cases = {
+            'patch {"elements":[]}': "missing generation",
+            'patch {"generation":0,"elements":[]}': "generation must be a positive integer",
+            'patch {"generation":4294967296,"elements":[]}': "generation must be a positive integer",
+            'patch {"generation":1,"generation":1,"elements":[]}': "duplicate generation field",
+            'post {"generation":1,"elements":[]}': "unknown element-status field: generation",
+            'post {"elements":[{"id":"NOPE","disabled":true}]}': "unknown dome element id: NOPE",
+            'post {"elements":[{"id":"P1","disabled":true},{"id":"P1","disabled":false}]}':
+                "duplicate dome element id: P1",
+            'post {"elements":[{"id":"P1"}]}': "element requires id and disabled",
+            'post {"elements":[{"id":"P1","disabled":1}]}': "disabled must be true or false",
+            'post {"elements":[{"id":"P1","disabled":true,"disabled_reason":"' + "x" * 97 + '"}]}':
+                "disabled_reason exceeds 96 characters",
+            'post {"elements":[]} x': "trailing content after JSON object",
+            'post {}': "missing elements array",
+        }
+        results = self.run_script(*cases)
+        for (command, error), result in zip(cases.items(), results):
+            with self.subTest(command=command[:40]):
+                self.assertEqual(result, {"status": 400, "error": error})
+
+    def test_failed_staging_applies_nothing(self) -> None:
+        gen = self.generation()
+        # The pending buffer exists after the first save; the scratch buffer
+        # of the second is the allocation that fails.
+        first, _, failed, get = self.run_script(self.patch(gen, ("P6", True)), "failalloc 0",
+                                                self.patch(gen + 1, ("P7", True)), "get")
+        self.assertEqual(first["status"], 200)
+        self.assertEqual(failed, {"status": 500, "changed": 0})
+        self.assertEqual(get["generation"], gen + 1)
+        self.assertEqual([e["id"] for e in get["elements"] if e["disabled"]], ["P6"])
+
+    def test_generation_does_not_repeat_across_reboots(self) -> None:
+        # Both boots would otherwise start at the same value, so a client
+        # holding the first boot's generation could patch the second boot's
+        # table unseen.
+        before, _, _, after, stale = self.run_script(
+            "get", "reboot 1000", "reboot 2000", "get",
+            self.patch(self.generation(), ("P8", True)))
+        self.assertNotEqual(before["generation"], after["generation"])
+        self.assertEqual(stale["status"], 409)
+
+    def test_first_save_over_unavailable_status_reports_every_element(self) -> None:
+        _, unavailable, saved = self.run_script("wipe", "get", self.post(("P9", True)))
+        self.assertTrue(all(e["disabled"] and e["disabled_reason"] == "status unavailable"
+                            for e in unavailable["elements"]))
+        ids = [e["id"] for e in unavailable["elements"]]
+        self.assertEqual(saved["changed"], ids)
+        states = {e["id"]: e["disabled"] for e in saved["delta"]["elements"]}
+        self.assertEqual([i for i, disabled in states.items() if disabled], ["P9"])
+
+    def test_saves_reach_nvs_only_when_flushed(self) -> None:
+        # The route answers from RAM; NVS is written behind it, so a save
+        # that was never flushed is gone after a power cut.
+        _, saved, _, get = self.run_script("reboot 5", self.post(("P10", True)), "crash 6", "get")
+        self.assertEqual(saved["changed"], ["P10"])
+        entry = next(e for e in get["elements"] if e["id"] == "P10")
+        self.assertFalse(entry["disabled"])
+
+    def test_status_survives_a_reboot(self) -> None:
+        gen = self.generation()
+        _, _, get = self.run_script(self.patch(gen, ("FLD", True, "cracked")), "reboot 77", "get")
+        entry = next(e for e in get["elements"] if e["id"] == "FLD")
+        self.assertEqual(entry["disabled_reason"], "cracked")
+
+
+if __name__ == "__main__":
+    unittest.main()
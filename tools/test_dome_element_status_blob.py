@@ -0,0 +1,182 @@
+#!/usr/bin/env python3
+"""Host tests for DomeElementStatusBlob.h, the packed NVS form of the dome
+element status table.
+
+Run with --report to compare NVS traffic against the per-element keys.
+"""
+
+from __future__ import annotations
+
+import sys
+import unittest
+from pathlib import Path
+
+
+ROOT = Path(__file__).resolve().parents[1]
+sys.path.insert(0, str(ROOT / "tools"))
+
+from host_harness import HarnessTestCase, compile_harness, report_workdir, run_harness  # noqa: E402
+
+HARNESS = r"""
+#include <stdio.h>
+#include <stdlib.h>
+#include "DomeElementStatusBlob.h"
+
+// stdin: count schema revision orderHash templateIdHash, then per element
+// "<disabled> <reason|->". Mode "e" prints the blob as hex; mode "d" reads a
+// hex blob from argv[2] and decodes it against the stdin identity.
+int main(int argc, char **argv)
+{
+    if (argc < 2) return 2;
+    DomeElementStatusBlobMeta meta;
+    unsigned count, schema, revision;
+    unsigned long orderHash, idHash;
+    if (scanf("%u %u %u %lu %lu", &count, &schema, &revision, &orderHash, &idHash) != 5) return 2;
+    meta.count = (uint8_t)count;
+    meta.schemaRevision = (uint16_t)schema;
+    meta.templateRevision = (uint16_t)revision;
+    meta.orderHash = (uint32_t)orderHash;
+    meta.templateIdHash = (uint32_t)idHash;
+    if (argv[1][0] == 'e')
+    {
+        static bool disabled[DOME_ELEMENT_STATUS_MAX_ELEMENTS];
+        static char reasonText[DOME_ELEMENT_STATUS_MAX_ELEMENTS][256];
+        static const char *reasons[DOME_ELEMENT_STATUS_MAX_ELEMENTS];
+        for (unsigned i = 0; i < count && i < DOME_ELEMENT_STATUS_MAX_ELEMENTS; i++)
+        {
+            int flag = 0;
+            if (scanf("%d %255s", &flag, reasonText[i]) != 2) return 2;
+            disabled[i] = flag != 0;
+            reasons[i] = (reasonText[i][0] == '-' && reasonText[i][1] == '\0') ? "" : reasonText[i];
+        }
+        static uint8_t blob[DOME_ELEMENT_STATUS_BLOB_MAX_BYTES];
+        size_t cap = argc > 2 ? (size_t)atoi(argv[2]) : sizeof(blob);
+        size_t len = domeElementStatusBlobEncode(meta, disabled, reasons, blob, cap);
+        if (len == 0)
+        {
+            printf("ERR\n");
+            return 0;
+        }
+        for (size_t i = 0; i < len; i++) printf("%02x", blob[i]);
+        printf("\n");
+        return 0;
+    }
+    if (argv[1][0] == 'd' && argc > 2)
+    {
+        static uint8_t blob[DOME_ELEMENT_STATUS_BLOB_MAX_BYTES + 16];
+        size_t len = 0;
+        for (const char *p = argv[2]; p[0] && p[1] && len < sizeof(blob); p += 2)
+        {
+            unsigned byte;
+            sscanf(p, "%2x", &byte);
+            blob[len++] = (uint8_t)byte;
+        }
+        static bool disabled[DOME_ELEMENT_STATUS_MAX_ELEMENTS];
+        static char reasons[DOME_ELEMENT_STATUS_MAX_ELEMENTS][DOME_ELEMENT_STATUS_MAX_REASON_LEN + 1];
+        if (!domeElementStatusBlobDecode(blob, len, meta, disabled, reasons))
+        {
+            printf("ERR\n");
+            return 0;
+        }
+        for (unsigned i = 0; i < count; i++) printf("%d %s\n", disabled[i] ? 1 : 0, reasons[i]);
+        return 0;
+    }
+    return 2;
+}
+"""
+
+META = (28, 1, 1, 0xDEADBEEF, 0x12345678)
+
+
+class DomeElementStatusBlobTests(HarnessTestCase):
+    HARNESS_NAME = "blob_harness"
+    HARNESS = HARNESS
+
+    def stdin_for(self, meta: tuple, entries: list[tuple[int, str]]) -> str:
+        lines = [" ".join(str(value) for value in meta)]
+        lines += [f"{flag} {reason or '-'}" for flag, reason in entries]
+        return "\n".join(lines) + "\n"
+
+    def encode(self, entries: list[tuple[int, str]], meta: tuple = META, cap: int | None = None) -> str:
+        args = ["e"] + ([str(cap)] if cap is not None else [])
+        return "\n".join(run_harness(self.binary, *args, stdin=self.stdin_for(meta, entries))).strip()
+
+    def decode(self, blob: str, meta: tuple = META) -> list[str] | None:
+        lines = run_harness(self.binary, "d", blob, stdin=self.stdin_for(meta, []))
+        if lines == ["ERR"]:
+            return None
+        return lines
+
+    def sample(self) -> list[tuple[int, str]]:
+        entries = [(0, "")] * META[0]
+        entries[3] = (1, "servo_jammed")
+        entries[17] = (1, "")
+        return entries
+
+    def test_roundtrip_preserves_flags_and_reasons(self) -> None:
+        blob = self.encode(self.sample())
+        self.assertEqual(len(blob) // 2, 14 + 2 * META[0] + len("servo_jammed"))
+        lines = self.decode(blob)
+        self.assertIsNotNone(lines)
+        self.assertEqual(lines[3], "1 servo_jammed")
+        self.assertEqual(lines[17].rstrip(), "1")
+        self.assertEqual(sum(1 for line in lines if line.startswith("1")), 2)
+
+    def test_reason_is_dropped_for_enabled_elements(self) -> None:
+        entries = self.sample()
+        entries[5] = (0, "stale")
+        self.assertEqual(self.encode(entries), self.encode(self.sample()))
+
+    def test_reason_is_clipped(self) -> None:
+        entries = self.sample()
+        entries[0] = (1, "x" * 200)
+        lines = self.decode(self.encode(entries))
+        self.assertEqual(lines[0], "1 " + "x" * 96)
+
+    def test_identity_mismatch_is_rejected(self) -> None:
+        blob = self.encode(self.sample())
+        for field in range(1, len(META)):
+            other = list(META)
+            other[field] += 1
+            self.assertIsNone(self.decode(blob, tuple(other)), field)
+        self.assertIsNone(self.decode(self.encode(self.sample()[:-1], (27,) + META[1:])))
+
+    def test_malformed_blobs_are_rejected(self) -> None:
+        blob = self.encode(self.sample())
+        self.assertIsNone(self.decode(blob[:-2]))
+        self.assertIsNone(self.decode(blob + "00"))
+        self.assertIsNone(self.decode("02" + blob[2:]))
+        # Reason bytes on an enabled entry.
+        self.assertIsNone(self.decode(blob[:28] + "0001" + "41" + blob[32:]))
+        # Unknown flag bits.
+        self.assertIsNone(self.decode(blob[:28] + "02" + blob[30:]))
+
+    def test_encode_refuses_short_buffer(self) -> None:
+        full = self.encode(self.sample())
+        self.assertEqual(self.encode(self.sample(), cap=len(full) // 2), full)
+        self.assertEqual(self.encode(self.sample(), cap=len(full) // 2 - 1), "ERR")
+
+
+def report() -> int:
+    with report_workdir() as workdir:
+        binary = compile_harness(workdir, "blob_harness", HARNESS)
+        print("Dome element status persistence report")
+        for count, disabled in ((28, 2), (64, 8), (64, 64)):
+            entries = "\n".join(
+                f"1 reason_{i:02d}" if i < disabled else "0 -" for i in range(count))
+            stdin = f"{count} 1 1 1 1\n{entries}\n"
+            blob = run_harness(binary, "e", stdin=stdin)[0]
+            legacy_ops = 2 * count + 5
+            legacy_bytes = count + sum(len(f"reason_{i:02d}") + 1 for i in range(disabled))
+            print(f"  {count} elements, {disabled} disabled")
+            print(f"    before: prefs.begin + {legacy_ops} key writes per save "
+                  f"(~{legacy_bytes} B payload across {2 * count} keys), on the request task")
+            print(f"    after:  1 putBytes of {len(blob) // 2} B, debounced 250 ms, "
+                  f"from the web event loop; reads served from RAM")
+    return 0
+
+
+if __name__ == "__main__":
+    if "--report" in sys.argv:
+        sys.exit(report())
+    unittest.main()
@@ -0,0 +1,345 @@
+#!/usr/bin/env python3
+"""Host tests for DomeLayoutCompiled.h, the binary compiled dome layout.
+
+The firmware compiler and tools/generate_dome_layout_header.py must produce
+identical bytes for the same template. Run with --report to compare source,
+compiled and decode costs over templates/dome-layouts/*.json.
+"""
+
+from __future__ import annotations
+
+import json
+import struct
+import sys
+import unittest
+import zlib
+from pathlib import Path
+
+from generate_dome_layout_header import ValidationError, compile_layout, validate_template
+from host_harness import HarnessTestCase, compile_harness, report_workdir, run_harness
+
+
+ROOT = Path(__file__).resolve().parents[1]
+TEMPLATE_DIR = ROOT / "templates/dome-layouts"
+TEMPLATE_PATH = TEMPLATE_DIR / "mr-baddeley-complex-dome-mk4.json"
+
+HARNESS = r"""
+#include <stdlib.h>
+#include <time.h>
+#include <string>
+#include "DomeLayoutCompiled.h"
+
+static size_t readFile(void *ctx, uint8_t *buf, size_t len)
+{
+    return fread(buf, 1, len, (FILE *)ctx);
+}
+
+static std::string slurp(const char *path)
+{
+    std::string data;
+    FILE *file = fopen(path, "rb");
+    if (!file) { perror(path); exit(2); }
+    char chunk[512];
+    size_t n;
+    while ((n = fread(chunk, 1, sizeof(chunk), file)) > 0) data.append(chunk, n);
+    fclose(file);
+    return data;
+}
+
+static bool compileFile(const char *path, uint8_t *&blob, size_t &len, char *err, size_t errLen)
+{
+    FILE *file = fopen(path, "rb");
+    if (!file) { perror(path); exit(2); }
+    fseek(file, 0, SEEK_END);
+    size_t size = (size_t)ftell(file);
+    fseek(file, 0, SEEK_SET);
+    bool ok = domeLayoutCompileTemplate(readFile, file, size, blob, len, err, errLen);
+    fclose(file);
+    return ok;
+}
+
+static void printNullable(const char *value)
+{
+    printf("%s|", value ? value : "~");
+}
+
+static void dump(const uint8_t *blob, const DomeLayoutCompiledHeader &h)
+{
+    printf("H %u|%u|%s|%s|", h.schemaRevision, h.templateRevision,
+           domeLayoutCompiledString(blob, h, h.templateId),
+           domeLayoutCompiledString(blob, h, h.templateName));
+    printNullable(domeLayoutCompiledString(blob, h, h.model));
+    printNullable(domeLayoutCompiledString(blob, h, h.source));
+    printf("%s\n", domeLayoutCompiledString(blob, h, h.viewBox));
+    const char *aliases[DOME_LAYOUT_COMPILED_MAX_ALIASES];
+    const char *capabilities[DOME_LAYOUT_COMPILED_MAX_CAPABILITIES];
+    for (size_t i = 0; i < h.elementCount; i++)
+    {
+        DomeLayout::DomeLayoutElement e;
+        domeLayoutCompiledElement(blob, h, i, e, aliases, capabilities);
+        printf("E %s|%s|%s|", e.id, e.label, e.elementType);
+        printNullable(e.panelKind);
+        printNullable(e.mountedOn);
+        printf("%d|%d|%d|", e.inLayout ? 1 : 0, e.commandable ? 1 : 0, e.renderOrder);
+        for (size_t a = 0; a < e.aliasCount; a++) printf("%s%s", a ? "," : "", e.aliases[a]);
+        printf("|");
+        for (size_t c = 0; c < e.capabilityCount; c++) printf("%s%s", c ? "," : "", e.capabilities[c]);
+        printf("|%d|", (int)e.geometryType);
+        printNullable(e.svgPath);
+        printf("%.9g %.9g %.9g %.9g %.9g %.9g|", e.cx, e.cy, e.r, e.rx, e.ry, e.rotation);
+        printf("%d %.9g %.9g|", e.labelAnchor.present ? 1 : 0, e.labelAnchor.x, e.labelAnchor.y);
+        printf("%d %.9g %.9g %.9g %d %.9g %.9g\n", e.callout.present ? 1 : 0, e.callout.x,
+               e.callout.y, e.callout.r, e.callout.connectorPresent ? 1 : 0,
+               e.callout.connectorX, e.callout.connectorY);
+    }
+}
+
+static double nowUs()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 3) return 2;
+    const char *mode = argv[1];
+    char err[DOME_LAYOUT_STREAM_ERR_LEN];
+    uint8_t *blob = nullptr;
+    size_t len = 0;
+    DomeLayoutCompiledHeader h;
+    if (mode[0] == 'c')
+    {
+        // compile <template.json> <out.apdl>; validated first, as on upload
+        if (argc < 4) return 2;
+        std::string body = slurp(argv[2]);
+        DomeLayoutStreamMemoryReader reader = { body.data(), body.size(), 0 };
+        DomeLayoutStreamResult result;
+        if (!domeLayoutTemplateStreamRun(domeLayoutStreamReadMemory, &reader, result))
+        {
+            printf("ERR %s\n", result.error);
+            return 0;
+        }
+        if (!compileFile(argv[2], blob, len, err, sizeof(err)))
+        {
+            printf("ERR %s\n", err);
+            return 0;
+        }
+        FILE *out = fopen(argv[3], "wb");
+        fwrite(blob, 1, len, out);
+        fclose(out);
+        printf("OK %u\n", (unsigned)len);
+        free(blob);
+        return 0;
+    }
+    if (mode[0] == 'v' || mode[0] == 'd')
+    {
+        // verify|dump <compiled.apdl>
+        std::string data = slurp(argv[2]);
+        if (!domeLayoutCompiledCheck((const uint8_t *)data.data(), data.size(), h, err, sizeof(err)))
+        {
+            printf("ERR %s\n", err);
+            return 0;
+        }
+        if (mode[0] == 'd') dump((const uint8_t *)data.data(), h);
+        else printf("OK %u %u %08x\n", h.elementCount, (unsigned)h.sourceSize, (unsigned)h.sourceCrc);
+        return 0;
+    }
+    if (mode[0] == 'b')
+    {
+        // bench <template.json>
+        const int kIterations = 400;
+        bool ok = true;
+        double t0 = nowUs();
+        for (int i = 0; i < kIterations; i++)
+        {
+            free(blob);
+            ok &= compileFile(argv[2], blob, len, err, sizeof(err));
+        }
+        double t1 = nowUs();
+        const char *aliases[DOME_LAYOUT_COMPILED_MAX_ALIASES];
+        const char *capabilities[DOME_LAYOUT_COMPILED_MAX_CAPABILITIES];
+        float sink = 0;
+        for (int i = 0; ok && i < kIterations; i++)
+        {
+            ok &= domeLayoutCompiledCheck(blob, len, h, err, sizeof(err));
+            for (size_t e = 0; e < h.elementCount; e++)
+            {
+                DomeLayout::DomeLayoutElement element;
+                domeLayoutCompiledElement(blob, h, e, element, aliases, capabilities);
+                sink += element.cx;
+            }
+        }
+        double t2 = nowUs();
+        printf("ok %d\nerror %s\ncompiled_bytes %u\ncompile_us %.1f\ndecode_us %.1f\n"
+               "builder_bytes %u\nsink %g\n",
+               ok ? 1 : 0, ok ? "-" : err, (unsigned)len, (t1 - t0) / kIterations,
+               (t2 - t1) / kIterations, (unsigned)sizeof(DomeLayoutCompiledBuilder), sink);
+        free(blob);
+        return 0;
+    }
+    return 2;
+}
+"""
+
+
+def load_template() -> dict:
+    return json.loads(TEMPLATE_PATH.read_text(encoding="utf-8"))
+
+
+def f32(value: float) -> str:
+    return "%.9g" % struct.unpack("<f", struct.pack("<f", float(value)))[0]
+
+
+def expected_dump(raw: bytes) -> list[str]:
+    template = validate_template(json.loads(raw.decode("utf-8")))
+    nullable = lambda value: "~" if value is None else value  # noqa: E731
+    lines = [
+        "H {}|{}|{}|{}|{}|{}|{}".format(
+            template["schema_revision"], template["template_revision"],
+            template["template_id"], template["template_name"],
+            nullable(template.get("model")), nullable(template.get("source")),
+            template["coordinate_space"]["viewBox"],
+        )
+    ]
+    geometry_enum = {"svg_path": 0, "circle": 1, "ellipse": 2, "point": 3}
+    for e in template["elements"]:
+        geometry = e.get("geometry", {"type": "point"})
+        anchor = e.get("label_anchor")
+        callout = e.get("callout")
+        connector = callout.get("connector_to") if callout else None
+        numbers = " ".join(f32(geometry.get(key, 0)) for key in ("cx", "cy", "r", "rx", "ry", "rotation"))
+        anchor_text = f"1 {f32(anchor['x'])} {f32(anchor['y'])}" if anchor else "0 0 0"
+        if callout:
+            callout_text = "1 {} {} {} {} {} {}".format(
+                f32(callout["x"]), f32(callout["y"]), f32(callout["r"]),
+                1 if connector else 0,
+                f32(connector["x"]) if connector else "0", f32(connector["y"]) if connector else "0",
+            )
+        else:
+            callout_text = "0 0 0 0 0 0 0"
+        lines.append("E " + "|".join([
+            e["id"], e["label"], e["element_type"], nullable(e["panel_kind"]),
+            nullable(e["mounted_on"]), str(int(e["in_layout"])), str(int(e["commandable"])),
+            str(e["render_order"]), ",".join(e["aliases"]), ",".join(e["capabilities"]),
+            str(geometry_enum[geometry["type"]]), nullable(geometry.get("d")), numbers,
+            anchor_text, callout_text,
+        ]))
+    return lines
+
+
+class DomeLayoutCompiledTests(HarnessTestCase):
+    HARNESS_NAME = "compiled_harness"
+    HARNESS = HARNESS
+
+    def harness(self, *args: str) -> str:
+        return "\n".join(run_harness(self.binary, *args))
+
+    def firmware_compile(self, raw: bytes) -> bytes:
+        source = self.workdir / "template.json"
+        output = self.workdir / "firmware.apdl"
+        source.write_bytes(raw)
+        if output.exists():
+            output.unlink()
+        out = self.harness("compile", str(source), str(output)).strip()
+        self.assertTrue(out.startswith("OK "), out)
+        return output.read_bytes()
+
+    def check(self, blob: bytes, mode: str = "verify") -> str:
+        path = self.workdir / "check.apdl"
+        path.write_bytes(blob)
+        return self.harness(mode, str(path))
+
+    def test_host_tool_and_firmware_compile_identical_bytes(self) -> None:
+        raw = TEMPLATE_PATH.read_bytes()
+        self.assertEqual(self.firmware_compile(raw), compile_layout(raw))
+        for indent in (None, 1, 4):
+            variant = json.dumps(load_template(), indent=indent).encode("utf-8")
+            self.assertEqual(self.firmware_compile(variant), compile_layout(variant), indent)
+
+    def test_defaults_are_materialized_identically(self) -> None:
+        template = load_template()
+        for element in template["elements"]:
+            geometry = element.get("geometry", {})
+            if geometry.get("type") == "ellipse":
+                geometry.pop("rotation", None)
+        raw = json.dumps(template).encode("utf-8")
+        self.assertEqual(self.firmware_compile(raw), compile_layout(raw))
+
+    def test_decoded_records_match_the_template(self) -> None:
+        raw = TEMPLATE_PATH.read_bytes()
+        lines = self.check(compile_layout(raw), "dump").splitlines()
+        self.assertEqual(lines, expected_dump(raw))
+
+    def test_header_records_source_identity(self) -> None:
+        raw = TEMPLATE_PATH.read_bytes()
+        blob = compile_layout(raw)
+        out = self.check(blob).split()
+        self.assertEqual(out, ["OK", "28", str(len(raw)), "%08x" % zlib.crc32(raw)])
+        self.assertLess(len(blob), len(raw) // 4)
+
+    def test_check_rejects_corruption(self) -> None:
+        blob = bytearray(compile_layout(TEMPLATE_PATH.read_bytes()))
+        flipped = bytearray(blob)
+        flipped[-3] ^= 0x40
+        self.assertIn("CRC mismatch", self.check(bytes(flipped)))
+        self.assertIn("not a version 1", self.check(bytes(blob[:40])))
+        self.assertIn("sections are inconsistent", self.check(self.recrc(blob[:-20])))
+        bad_enum = bytearray(blob)
+        bad_enum[-4] = 9  # element_type of the last record
+        self.assertIn("record 27 is invalid", self.check(self.recrc(bad_enum)))
+        bad_ref = bytearray(blob)
+        bad_ref[-20:-18] = struct.pack("<H", 0x7000)
+        self.assertIn("record 27 is invalid", self.check(self.recrc(bad_ref)))
+
+    @staticmethod
+    def recrc(blob: bytes | bytearray) -> bytes:
+        data = bytearray(blob)
+        data[56:60] = b"\0\0\0\0"
+        data[56:60] = struct.pack("<I", zlib.crc32(bytes(data)))
+        return bytes(data)
+
+    def test_host_tool_rejects_invalid_templates(self) -> None:
+        template = load_template()
+        template["elements"][0]["id"] = "XX9"
+        with self.assertRaises(ValidationError):
+            compile_layout(json.dumps(template).encode("utf-8"))
+
+    def test_extra_keys_are_dropped_from_firmware_output(self) -> None:
+        template = load_template()
+        raw = json.dumps(template).encode("utf-8")
+        template["notes"] = {"author": "x", "tags": ["a", "b"]}
+        template["elements"][0]["geometry"]["hint"] = 3
+        extra = json.dumps(template).encode("utf-8")
+        baseline = self.check(self.firmware_compile(raw), "dump")
+        self.assertEqual(self.check(self.firmware_compile(extra), "dump"), baseline)
+
+
+def report() -> int:
+    with report_workdir() as workdir:
+        binary = compile_harness(workdir, "compiled_harness", HARNESS)
+        print("Compiled dome layout report")
+        for path in sorted(TEMPLATE_DIR.glob("*.json")):
+            stats = dict(line.split(" ", 1) for line in run_harness(binary, "bench", str(path)))
+            size = path.stat().st_size
+            print(f"  {path.name} ({size} B)")
+            if stats["ok"] != "1":
+                print(f"    not a firmware template: {stats['error']}")
+                continue
+            try:
+                host = len(compile_layout(path.read_bytes()))
+            except ValidationError as exc:
+                host = f"rejected ({exc})"
+            print(f"    compiled {stats['compiled_bytes']} B (host tool {host}); "
+                  f"compile {float(stats['compile_us']):.1f} us once per upload, "
+                  f"builder {stats['builder_bytes']} B transient")
+            print(f"    check + decode all records {float(stats['decode_us']):.1f} us on host, "
+                  "no JSON tokenising")
+    return 0
+
+
+if __name__ == "__main__":
+    if "--report" in sys.argv:
+        sys.exit(report())
+    unittest.main()
@@ -0,0 +1,195 @@
+#!/usr/bin/env python3
+"""Host tests for the generated dome layout id index (DomeLayout::findId).
+
+Run with --report to benchmark per-build id lookups at 64 elements, the
+element status table's limit, against the linear strcmp scans it replaced.
+"""
+
+from __future__ import annotations
+
+import sys
+import unittest
+from pathlib import Path
+
+from generate_dome_layout_header import (
+    DEFAULT_OUTPUT,
+    DEFAULT_TEMPLATE,
+    ValidationError,
+    load_and_render,
+    load_panel_slot_labels,
+    render_id_index,
+)
+from host_harness import HarnessTestCase, compile_harness, report_workdir, run_harness
+
+
+BENCH_ELEMENTS = 64
+
+HARNESS = r"""
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "GeneratedDomeLayout.h"
+
+namespace Synthetic {
+#include "synthetic_index.inc"
+}
+
+static const char *kSyntheticSlotLabels[] = {
+#include "synthetic_slots.inc"
+};
+static const size_t kSyntheticSlotCount = sizeof(kSyntheticSlotLabels) / sizeof(kSyntheticSlotLabels[0]);
+
+static const char *kSyntheticIds[] = {
+#include "synthetic_ids.inc"
+};
+static const size_t kSyntheticCount = sizeof(kSyntheticIds) / sizeof(kSyntheticIds[0]);
+
+static double nowUs()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+// What a layout build did before the index: one scan of the element table for
+// the status index and one of the panel slot labels, per element.
+static int linearBuild()
+{
+    int sum = 0;
+    for (size_t e = 0; e < kSyntheticCount; e++)
+    {
+        const char *id = kSyntheticIds[e];
+        for (size_t i = 0; i < kSyntheticCount; i++)
+            if (strcmp(id, kSyntheticIds[i]) == 0) { sum += (int)i; break; }
+        for (size_t i = 0; i < kSyntheticSlotCount; i++)
+            if (strcmp(id, kSyntheticSlotLabels[i]) == 0) { sum += (int)i; break; }
+    }
+    return sum;
+}
+
+static int indexedBuild()
+{
+    int sum = 0;
+    for (size_t e = 0; e < kSyntheticCount; e++)
+    {
+        const Synthetic::DomeLayoutIdIndexEntry *entry = Synthetic::findId(kSyntheticIds[e]);
+        if (entry) sum += entry->elementIndex + (entry->panelSlot >= 0 ? entry->panelSlot : 0);
+    }
+    return sum;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 2) return 2;
+    if (argv[1][0] == 'c')
+    {
+        // Every generated element resolves to itself.
+        for (size_t i = 0; i < DomeLayout::kElementCount; i++)
+        {
+            const DomeLayout::DomeLayoutIdIndexEntry *entry = DomeLayout::findId(DomeLayout::kElements[i].id);
+            if (!entry || entry->elementIndex != (int)i) { printf("miss %s\n", DomeLayout::kElements[i].id); return 1; }
+            printf("%s %d %d\n", entry->id, entry->elementIndex, entry->panelSlot);
+        }
+        for (size_t slot = 0; slot < DomeLayout::kPanelSlotCount; slot++)
+        {
+            int index = DomeLayout::kPanelSlotElementIndex[slot];
+            if (DomeLayout::panelSlotForId(DomeLayout::kElements[index].id) != (int)slot) { printf("slot %u\n", (unsigned)slot); return 1; }
+        }
+        for (size_t i = 0; i < kSyntheticCount; i++)
+        {
+            if (Synthetic::elementIndexForId(kSyntheticIds[i]) != (int)i) { printf("synthetic %s\n", kSyntheticIds[i]); return 1; }
+        }
+        return 0;
+    }
+    if (argv[1][0] == 'l')
+    {
+        for (int i = 2; i < argc; i++) printf("%d\n", DomeLayout::elementIndexForId(argv[i]));
+        return 0;
+    }
+    if (argv[1][0] == 'b')
+    {
+        const int kIterations = 20000;
+        volatile int sink = 0;
+        double t0 = nowUs();
+        for (int i = 0; i < kIterations; i++) sink += linearBuild();
+        double t1 = nowUs();
+        for (int i = 0; i < kIterations; i++) sink += indexedBuild();
+        double t2 = nowUs();
+        printf("elements %u\nlinear_us %.3f\nindexed_us %.3f\nlinear_strcmp %u\nindex_bytes %u\n",
+               (unsigned)kSyntheticCount, (t1 - t0) / kIterations, (t2 - t1) / kIterations,
+               (unsigned)(kSyntheticCount * (kSyntheticCount + kSyntheticSlotCount) / 2),
+               (unsigned)sizeof(Synthetic::kIdIndex));
+        return sink == 42 ? 3 : 0;
+    }
+    return 2;
+}
+"""
+
+
+def synthetic_ids(count: int) -> list[str]:
+    # Mixed-length ids shaped like the real ones, in a non-sorted order.
+    prefixes = ["P", "PP", "HP", "LD", "PSI"]
+    ids = [f"{prefixes[i % len(prefixes)]}{i * 7 % 97}" for i in range(count)]
+    assert len(set(ids)) == count
+    return ids
+
+
+def build_harness(workdir: Path) -> Path:
+    ids = synthetic_ids(BENCH_ELEMENTS)
+    slots = [element_id for element_id in ids if element_id.startswith("P")][:24]
+    (workdir / "synthetic_index.inc").write_text("\n".join(render_id_index(ids, slots)) + "\n")
+    (workdir / "synthetic_slots.inc").write_text("".join(f'"{label}",\n' for label in slots))
+    (workdir / "synthetic_ids.inc").write_text("".join(f'"{value}",\n' for value in ids))
+    return compile_harness(workdir, "id_index_harness", HARNESS, includes=[workdir])
+
+
+class GeneratedIdIndexTests(unittest.TestCase):
+    def test_generated_header_is_current(self) -> None:
+        self.assertEqual(DEFAULT_OUTPUT.read_text(encoding="utf-8"), load_and_render(DEFAULT_TEMPLATE))
+
+    def test_panel_slots_come_from_wiring_config(self) -> None:
+        labels = load_panel_slot_labels()
+        self.assertEqual(labels[:4], ["P1", "P2", "P3", "P4"])
+        self.assertEqual(len(labels), 13)
+
+    def test_unknown_panel_slot_label_is_rejected(self) -> None:
+        with self.assertRaises(ValidationError):
+            render_id_index(["P1", "P2"], ["P1", "P9"])
+
+
+class IdIndexLookupTests(HarnessTestCase):
+    @classmethod
+    def build(cls, workdir: Path) -> Path:
+        return build_harness(workdir)
+
+    def test_every_element_and_panel_slot_resolves(self) -> None:
+        rows = [line.split() for line in run_harness(self.binary, "check")]
+        slots = {row[0]: int(row[2]) for row in rows}
+        labels = load_panel_slot_labels()
+        for slot, label in enumerate(labels):
+            self.assertEqual(slots.pop(label), slot)
+        self.assertTrue(all(slot == -1 for slot in slots.values()))
+
+    def test_unknown_and_near_miss_ids_are_not_found(self) -> None:
+        out = run_harness(self.binary, "lookup", "", "P0", "P15", "PP7", "p1", "P1 ", "HP")
+        self.assertEqual(out, ["-1"] * 7)
+        self.assertNotEqual(run_harness(self.binary, "lookup", "P1"), ["-1"])
+
+
+def report() -> int:
+    with report_workdir() as workdir:
+        binary = build_harness(workdir)
+        stats = dict(line.split(" ", 1) for line in run_harness(binary, "bench"))
+        linear = float(stats["linear_us"])
+        indexed = float(stats["indexed_us"])
+        print(f"Dome layout id lookups per layout build ({stats['elements']} elements, host)")
+        print(f"  before: linear scans, ~{stats['linear_strcmp']} strcmp calls, {linear:.3f} us")
+        print(f"  after:  sorted index, <= 7 strcmp per id, {indexed:.3f} us "
+              f"({linear / indexed:.1f}x); index {stats['index_bytes']} B on host, half that on the ESP32")
+    return 0
+
+
+if __name__ == "__main__":
+    if "--report" in sys.argv:
+        sys.exit(report())
+    unittest.main()
@@ -0,0 +1,233 @@
+#!/usr/bin/env python3
+"""Host tests for DomeLayoutTemplateStream.h, the firmware's streaming
+custom-template validator.
+
+Run with --report to benchmark it over templates/dome-layouts/*.json.
+"""
+
+from __future__ import annotations
+
+import copy
+import json
+import sys
+import unittest
+from pathlib import Path
+
+
+ROOT = Path(__file__).resolve().parents[1]
+sys.path.insert(0, str(ROOT / "tools"))
+
+from host_harness import HarnessTestCase, compile_harness, report_workdir, run_harness  # noqa: E402
+
+TEMPLATE_DIR = ROOT / "templates/dome-layouts"
+TEMPLATE_PATH = TEMPLATE_DIR / "mr-baddeley-complex-dome-mk4.json"
+
+HARNESS = r"""
+#include <stdlib.h>
+#include <time.h>
+#include <string>
+#include "DomeLayoutTemplateStream.h"
+
+struct FileReader
+{
+    FILE *file;
+    size_t maxRead;
+    uint32_t calls;
+};
+
+static size_t readFile(void *ctx, uint8_t *buf, size_t len)
+{
+    FileReader *reader = (FileReader *)ctx;
+    reader->calls++;
+    if (len > reader->maxRead) len = reader->maxRead;
+    return fread(buf, 1, len, reader->file);
+}
+
+static bool run(const char *path, size_t maxRead, DomeLayoutStreamResult &result, uint32_t &calls)
+{
+    FileReader reader = { fopen(path, "rb"), maxRead, 0 };
+    if (!reader.file) { perror(path); exit(2); }
+    bool ok = domeLayoutTemplateStreamRun(readFile, &reader, result);
+    fclose(reader.file);
+    calls = reader.calls;
+    return ok;
+}
+
+static double nowUs()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 3) return 2;
+    const char *mode = argv[1];
+    const char *path = argv[2];
+    size_t maxRead = argc > 3 ? (size_t)atoi(argv[3]) : DOME_LAYOUT_STREAM_CHUNK;
+    DomeLayoutStreamResult result;
+    uint32_t calls = 0;
+    if (mode[0] == 'v')
+    {
+        bool ok = run(path, maxRead, result, calls);
+        if (!ok)
+        {
+            printf("ERR %s\n", result.error);
+            return 0;
+        }
+        printf("OK %s|%s|%d|%d|%d|%u|%u\n", result.templateId, result.templateName,
+               result.schemaRevision, result.templateRevision, result.elementCount,
+               (unsigned)result.sizeBytes, (unsigned)calls);
+        return 0;
+    }
+    if (mode[0] == 'm')
+    {
+        // Upload path: the request body is already in RAM.
+        std::string body;
+        FILE *file = fopen(path, "rb");
+        if (!file) return 2;
+        char chunk[512];
+        size_t n;
+        while ((n = fread(chunk, 1, sizeof(chunk), file)) > 0) body.append(chunk, n);
+        fclose(file);
+        DomeLayoutStreamMemoryReader reader = { body.data(), body.size(), 0 };
+        bool ok = domeLayoutTemplateStreamRun(domeLayoutStreamReadMemory, &reader, result);
+        if (ok) printf("OK %d\n", result.elementCount);
+        else printf("ERR %s\n", result.error);
+        return 0;
+    }
+    if (mode[0] == 'b')
+    {
+        const int kIterations = 400;
+        bool ok = true;
+        double t0 = nowUs();
+        for (int i = 0; i < kIterations; i++) ok &= run(path, maxRead, result, calls);
+        double t1 = nowUs();
+        printf("ok %d\nerror %s\nbytes %u\nreads %u\n"
+               "validate_us %.1f\nparser_bytes %u\nresult_bytes %u\n",
+               ok ? 1 : 0, ok ? "-" : result.error, (unsigned)result.sizeBytes, (unsigned)calls,
+               (t1 - t0) / kIterations,
+               (unsigned)sizeof(DomeLayoutTemplateStream), (unsigned)sizeof(DomeLayoutStreamResult));
+        return 0;
+    }
+    return 2;
+}
+"""
+
+
+def load_template() -> dict:
+    return json.loads(TEMPLATE_PATH.read_text(encoding="utf-8"))
+
+
+class DomeLayoutStreamTests(HarnessTestCase):
+    HARNESS_NAME = "stream_harness"
+    HARNESS = HARNESS
+
+    def run_mode(self, mode: str, text: str, max_read: int | None = None) -> str:
+        path = self.workdir / "template.json"
+        path.write_text(text, encoding="utf-8")
+        args = [mode, str(path)]
+        if max_read is not None:
+            args.append(str(max_read))
+        return "\n".join(run_harness(self.binary, *args))
+
+    def validate(self, template: dict | str) -> str:
+        text = template if isinstance(template, str) else json.dumps(template, indent=2)
+        return self.run_mode("validate", text).strip()
+
+    def assertRejected(self, template: dict | str, message: str) -> None:
+        out = self.validate(template)
+        self.assertTrue(out.startswith("ERR "), out)
+        self.assertIn(message, out)
+
+    def test_bundled_template_validates_with_chunked_reads(self) -> None:
+        text = TEMPLATE_PATH.read_text(encoding="utf-8")
+        out = self.run_mode("validate", text).strip()
+        self.assertTrue(out.startswith("OK "), out)
+        template_id, name, schema, revision, elements, size, reads = out[3:].split("|")
+        self.assertEqual(template_id, "mr-baddeley-complex-dome-mk4")
+        self.assertEqual(name, "Mr Baddeley Complex Dome MK4")
+        self.assertEqual((schema, revision, elements), ("1", "1", "28"))
+        self.assertEqual(int(size), len(text.encode("utf-8")))
+        # One read per 256-byte chunk plus the EOF probe.
+        self.assertEqual(int(reads), len(text) // 256 + 2 if len(text) % 256 else len(text) // 256 + 1)
+
+    def test_memory_reader_matches_file_reader(self) -> None:
+        text = TEMPLATE_PATH.read_text(encoding="utf-8")
+        self.assertEqual(self.run_mode("memory", text).strip(), "OK 28")
+        broken = text.replace('"PP3"', '"PP99"', 1)
+        self.assertEqual(self.run_mode("memory", broken).strip(),
+                         self.run_mode("validate", broken).strip())
+
+    def test_rejects_backend_fields_at_any_depth(self) -> None:
+        template = load_template()
+        template["elements"][0]["geometry"]["slot"] = 3
+        self.assertRejected(template, "template contains backend field: slot")
+
+    def test_rejects_runtime_fields(self) -> None:
+        template = load_template()
+        template["elements"][1]["active"] = True
+        self.assertRejected(template, "template must not define runtime field: active")
+        template = load_template()
+        template["runtime_state_ts"] = 5
+        self.assertRejected(template, "template must not define composed runtime field")
+
+    def test_rejects_identity_problems(self) -> None:
+        template = load_template()
+        template["elements"][0]["id"] = "XX9"
+        self.assertRejected(template, "unknown dome element id: XX9")
+        template = load_template()
+        template["elements"].append(copy.deepcopy(template["elements"][0]))
+        self.assertRejected(template, "duplicate dome element id")
+        template = load_template()
+        del template["elements"][-1]
+        self.assertRejected(template, "template is missing explicit known identity")
+
+    def test_rejects_malformed_json(self) -> None:
+        text = json.dumps(load_template())
+        self.assertRejected(text + " {}", "trailing content after template JSON")
+        self.assertRejected(text[:-40], "")
+        self.assertRejected(text.replace('"MK4"', '"MK\\u0034"', 1), "unicode escapes")
+        self.assertRejected("", "template must be 1..32768 bytes")
+
+    def test_rejects_oversize_and_deep_nesting(self) -> None:
+        template = load_template()
+        template["notes"] = "x" * 40000
+        self.assertRejected(template, "template must be 1..32768 bytes")
+        template = load_template()
+        nested: list = []
+        for _ in range(20):
+            nested = [nested]
+        template["extra"] = nested
+        self.assertRejected(template, "template nesting is too deep")
+
+    def test_rejects_wrong_view_box(self) -> None:
+        template = load_template()
+        template["coordinate_space"]["viewBox"] = "0 0 100 100"
+        self.assertRejected(template, "coordinate_space.viewBox must be 0 0 480 480")
+
+
+def report() -> int:
+    with report_workdir() as workdir:
+        binary = compile_harness(workdir, "stream_harness", HARNESS)
+        print("Custom dome layout template stream report")
+        for path in sorted(TEMPLATE_DIR.glob("*.json")):
+            stats = dict(line.split(" ", 1) for line in run_harness(binary, "bench", str(path)))
+            size = path.stat().st_size
+            print(f"  {path.name} ({size} B)")
+            if stats["ok"] != "1":
+                print(f"    not a firmware template: {stats['error']}")
+                continue
+            print(f"    before: {size} per-byte file.read() calls; String copy of ~{size} B "
+                  f"(file) + per-element substrings")
+            print(f"    after:  {stats['reads']} chunked reads; parser state "
+                  f"{stats['parser_bytes']} B + result {stats['result_bytes']} B, independent of size")
+            print(f"            validate {float(stats['validate_us']):.1f} us on host")
+    return 0
+
+
+if __name__ == "__main__":
+    if "--report" in sys.argv:
+        sys.exit(report())
+    unittest.main()
@@ -0,0 +1,185 @@
+#!/usr/bin/env python3
+"""Host tests for DomeLayoutWriter.h, the /api/dome/layout serializer.
+
+The bundled MK4 table and a compiled custom template go through the same
+writer, so compiling the MK4 template must serve the same bytes as the
+bundled layout apart from layout_source.
+"""
+
+from __future__ import annotations
+
+import json
+import subprocess
+import sys
+import unittest
+from pathlib import Path
+
+
+ROOT = Path(__file__).resolve().parents[1]
+sys.path.insert(0, str(ROOT / "tools"))
+
+from host_harness import HarnessTestCase  # noqa: E402
+
+TEMPLATE_PATH = ROOT / "templates/dome-layouts/mr-baddeley-complex-dome-mk4.json"
+
+HARNESS = r"""
+#include <stdlib.h>
+#include <string>
+#include "DomeLayoutCompiled.h"
+#include "DomeLayoutWriter.h"
+
+static void sinkWrite(void *ctx, const char *data, size_t len)
+{
+    ((std::string *)ctx)->append(data, len);
+}
+
+// Placeholders keep the output valid JSON where the runtime overlay goes.
+static bool sinkSplice(void *ctx, const char *id, bool commandable)
+{
+    std::string *out = (std::string *)ctx;
+    if (id == nullptr) out->append("0");
+    else out->append(commandable ? ",\"overlay\":1" : ",\"overlay\":0");
+    return true;
+}
+
+static void bundledElementAt(void *, size_t index, DomeLayout::DomeLayoutElement &out)
+{
+    out = DomeLayout::kElements[index];
+}
+
+struct CompiledView
+{
+    const uint8_t *blob;
+    const DomeLayoutCompiledHeader *header;
+    const char *aliases[DOME_LAYOUT_COMPILED_MAX_ALIASES];
+    const char *capabilities[DOME_LAYOUT_COMPILED_MAX_CAPABILITIES];
+};
+
+static void compiledElementAt(void *ctx, size_t index, DomeLayout::DomeLayoutElement &out)
+{
+    CompiledView *view = (CompiledView *)ctx;
+    domeLayoutCompiledElement(view->blob, *view->header, index, out, view->aliases, view->capabilities);
+}
+
+static size_t readFile(void *ctx, uint8_t *buf, size_t len)
+{
+    return fread(buf, 1, len, (FILE *)ctx);
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 3) return 2;
+    const char *label = argv[2];
+    std::string out;
+    DomeLayoutSink sink = { sinkWrite, sinkSplice, &out };
+    if (argv[1][0] == 'b')
+    {
+        // bundled <layout_source>
+        DomeLayoutStaticMeta meta = {
+            DomeLayout::kSchemaRevision, DomeLayout::kTemplateId, DomeLayout::kTemplateName,
+            DomeLayout::kTemplateRevision, DomeLayout::kModel, DomeLayout::kSource,
+            label, DomeLayout::kCoordinateSpaceViewBox
+        };
+        domeLayoutWriteStatic(sink, meta, DomeLayout::kElementCount, bundledElementAt, nullptr);
+    }
+    else
+    {
+        // compiled <layout_source> <template.json>
+        if (argc < 4) return 2;
+        FILE *file = fopen(argv[3], "rb");
+        if (!file) { perror(argv[3]); return 2; }
+        fseek(file, 0, SEEK_END);
+        size_t size = (size_t)ftell(file);
+        fseek(file, 0, SEEK_SET);
+        uint8_t *blob = nullptr;
+        size_t len = 0;
+        char err[DOME_LAYOUT_STREAM_ERR_LEN];
+        bool ok = domeLayoutCompileTemplate(readFile, file, size, blob, len, err, sizeof(err));
+        fclose(file);
+        if (!ok)
+        {
+            printf("ERR %s\n", err);
+            return 0;
+        }
+        DomeLayoutCompiledHeader header;
+        if (!domeLayoutCompiledCheck(blob, len, header, err, sizeof(err)))
+        {
+            printf("ERR %s\n", err);
+            return 0;
+        }
+        DomeLayoutStaticMeta meta = {
+            (int)header.schemaRevision,
+            domeLayoutCompiledString(blob, header, header.templateId),
+            domeLayoutCompiledString(blob, header, header.templateName),
+            (int)header.templateRevision,
+            domeLayoutCompiledString(blob, header, header.model),
+            domeLayoutCompiledString(blob, header, header.source),
+            label,
+            domeLayoutCompiledString(blob, header, header.viewBox)
+        };
+        CompiledView view = {};
+        view.blob = blob;
+        view.header = &header;
+        domeLayoutWriteStatic(sink, meta, header.elementCount, compiledElementAt, &view);
+        free(blob);
+    }
+    fwrite(out.data(), 1, out.size(), stdout);
+    return 0;
+}
+"""
+
+
+class DomeLayoutWriterTests(HarnessTestCase):
+    HARNESS_NAME = "dome_layout_writer_harness"
+    HARNESS = HARNESS
+
+    def harness(self, *args: str) -> bytes:
+        return subprocess.run([str(self.binary), *args], check=True,
+                              capture_output=True).stdout
+
+    def compiled(self, template: dict, label: str = "custom") -> bytes:
+        path = self.workdir / "template.json"
+        path.write_text(json.dumps(template), encoding="utf-8")
+        out = self.harness("compiled", label, str(path))
+        self.assertFalse(out.startswith(b"ERR "), out)
+        return out
+
+    def test_compiled_mk4_matches_bundled_byte_for_byte(self) -> None:
+        bundled = self.harness("bundled", "custom")
+        compiled = self.harness("compiled", "custom", str(TEMPLATE_PATH))
+        self.assertEqual(compiled, bundled)
+
+    def test_output_is_json_in_served_key_order(self) -> None:
+        layout = json.loads(self.harness("bundled", "bundled"))
+        self.assertEqual(list(layout), [
+            "schema_revision", "template_id", "template_name", "template_revision",
+            "model", "source", "layout_source", "coordinate_space",
+            "runtime_state_ts", "elements",
+        ])
+        self.assertEqual(layout["layout_source"], "bundled")
+        first = layout["elements"][0]
+        keys = list(first)
+        self.assertEqual(keys[keys.index("commandable") + 1], "overlay")
+
+    def test_unknown_template_keys_are_not_echoed(self) -> None:
+        template = json.loads(TEMPLATE_PATH.read_text(encoding="utf-8"))
+        template["x_vendor_note"] = "not part of the schema"
+        template["elements"][0]["x_element_note"] = "also dropped"
+        out = self.compiled(template)
+        self.assertNotIn(b"x_vendor_note", out)
+        self.assertNotIn(b"x_element_note", out)
+        self.assertEqual(out, self.harness("bundled", "custom"))
+
+    def test_missing_model_and_source_are_served_as_null(self) -> None:
+        template = json.loads(TEMPLATE_PATH.read_text(encoding="utf-8"))
+        template.pop("model", None)
+        template.pop("source", None)
+        layout = json.loads(self.compiled(template))
+        self.assertIn("model", layout)
+        self.assertIn("source", layout)
+        self.assertIsNone(layout["model"])
+        self.assertIsNone(layout["source"])
+
+
+if __name__ == "__main__":
+    unittest.main()
@@ -0,0 +1,357 @@
+#!/usr/bin/env python3
+"""Host tests for tools/firmware_delta.py and DeltaPatch.h, the delta OTA path.
+
+Synthetic firmware pairs model a rebuild: code inserted mid-image shifts
+everything after it and relocates the absolute addresses that point past it,
+strings change, and the image grows. Patches built by the tool are applied
+both by the tool and by a C++ harness that feeds DeltaPatch.h in uneven
+chunks into OtaStream (as /upload/firmware-delta does); the results must hash
+to the new image. The base digest is taken ahead of time in slices, the way
+the firmware hashes its running image from the loop, and the image length it
+hashes is read from the ESP32 image headers. Malformed patches must be refused.
+"""
+
+from __future__ import annotations
+
+import hashlib
+import importlib.util
+import random
+import struct
+import subprocess
+import sys
+import tempfile
+import unittest
+from pathlib import Path
+
+
+ROOT = Path(__file__).resolve().parents[1]
+sys.path.insert(0, str(ROOT / "tools"))
+
+from host_harness import compile_harness, have_gxx, run_harness  # noqa: E402
+
+TOOL = ROOT / "tools" / "firmware_delta.py"
+UPLOAD_TOOL = ROOT / "tools" / "http_ota_upload.py"
+
+HARNESS = r"""
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+#include "DeltaPatch.h"
+#include "OtaStream.h"
+
+static std::vector<uint8_t> readFile(const char *path)
+{
+    std::vector<uint8_t> out;
+    FILE *f = fopen(path, "rb");
+    int c;
+    while ((c = fgetc(f)) != EOF)
+        out.push_back((uint8_t)c);
+    fclose(f);
+    return out;
+}
+
+static std::vector<uint8_t> oldImage;
+static std::vector<uint8_t> newImage;
+static unsigned reads;
+static OtaStream stream;
+
+static bool readOld(void *, uint32_t offset, uint8_t *buf, size_t len)
+{
+    reads++;
+    if (offset + len > oldImage.size())
+        return false;
+    memcpy(buf, &oldImage[offset], len);
+    return true;
+}
+
+static bool sinkSubmit(void *, const uint8_t *block, size_t len)
+{
+    newImage.insert(newImage.end(), block, block + len);
+    return true;
+}
+
+static bool sinkReclaim(void *)
+{
+    return true;
+}
+
+static const OtaStreamSink kSink = { sinkSubmit, sinkReclaim, nullptr };
+
+static bool writeNew(void *, const uint8_t *data, size_t len)
+{
+    return otaStreamWrite(stream, kSink, data, len, 0) == kOtaStreamOk;
+}
+
+static const DeltaPatchIo kIo = { readOld, writeNew, nullptr };
+
+int main(int argc, char **argv)
+{
+    if (strcmp(argv[1], "imagelen") == 0)
+    {
+        // imagelen <partition.bin>
+        oldImage = readFile(argv[2]);
+        uint32_t len = 0;
+        if (deltaPatchImageLength(kIo, (uint32_t)oldImage.size(), len))
+            printf("D image_len %u\n", len);
+        else
+            printf("D image_len -1\n");
+        return 0;
+    }
+    oldImage = readFile(argv[1]);
+    std::vector<uint8_t> patch = readFile(argv[2]);
+    srand(48);
+
+    // The firmware hashes its running image before any patch arrives, in
+    // slices from the loop; uneven budgets stand in for the loop passes.
+    DeltaPatchBaseHash base;
+    deltaPatchBaseHashBegin(base, (uint32_t)oldImage.size());
+    while (!base.ready)
+    {
+        if (!deltaPatchBaseHashStep(base, kIo, 1 + rand() % 5000))
+            return 1;
+    }
+
+    DeltaPatch p;
+    deltaPatchReset(p);
+    size_t pos = 0;
+    int feedResult = kDeltaOk;
+    int baseOk = -1;
+    while (pos < patch.size() && feedResult == kDeltaOk)
+    {
+        size_t n = 1 + rand() % 1460;
+        if (n > patch.size() - pos)
+            n = patch.size() - pos;
+        size_t used = 0;
+        while (used < n)
+        {
+            DeltaPatchResult r;
+            used += deltaPatchFeed(p, kIo, &patch[pos + used], n - used, r);
+            if (r == kDeltaHeaderDone)
+            {
+                baseOk = deltaPatchBaseMatches(base, p.header);
+                char hex[SHA256_HEX_LEN + 1];
+                sha256ToHex(p.header.newSha, hex);
+                otaStreamBegin(stream, p.header.newSize, hex, 0);
+                if (!baseOk)
+                    break;
+            }
+            else if (r != kDeltaOk)
+            {
+                feedResult = r;
+                break;
+            }
+        }
+        if (baseOk == 0)
+            break;
+        pos += n;
+    }
+    printf("D base_ok %d\n", baseOk);
+    printf("D feed %d\n", feedResult);
+    if (baseOk != 1 || feedResult != kDeltaOk)
+        return 0;
+    printf("D finish %d\n", deltaPatchFinish(p, kIo));
+    printf("D stream %d\n", otaStreamFinish(stream, kSink));
+    char hex[SHA256_HEX_LEN + 1];
+    sha256ToHex(stream.digest, hex);
+    printf("D digest %s\n", hex);
+    FILE *f = fopen(argv[3], "wb");
+    fwrite(newImage.data(), 1, newImage.size(), f);
+    fclose(f);
+    printf("S stats copies=%u adds=%u literals=%u copied=%u patched=%u literal=%u produced=%u reads=%u\n",
+           p.stats.copies, p.stats.adds, p.stats.literals, p.stats.copiedBytes, p.stats.patchedBytes,
+           p.stats.literalBytes, p.produced, reads);
+    return 0;
+}
+"""
+
+
+def load(name: str, path: Path):
+    spec = importlib.util.spec_from_file_location(name, path)
+    module = importlib.util.module_from_spec(spec)
+    spec.loader.exec_module(module)
+    return module
+
+
+def synthetic_firmware(size: int, seed: int) -> bytes:
+    """Code-like words with ~1 in 8 being absolute addresses into the image."""
+    rng = random.Random(seed)
+    base = 0x400D0000
+    words = []
+    for _ in range(size // 4):
+        if rng.random() < 0.125:
+            words.append(base + rng.randrange(0, size) & ~3)
+        else:
+            words.append(rng.getrandbits(32))
+    return struct.pack(f"<{len(words)}I", *words)
+
+
+def rebuild(old: bytes, seed: int) -> bytes:
+    """The same firmware after a small source change."""
+    rng = random.Random(seed)
+    base = 0x400D0000
+    insert_at = (len(old) * 2 // 5) & ~3
+    inserted = bytes(rng.getrandbits(8) for _ in range(2048))
+    words = list(struct.unpack(f"<{len(old) // 4}I", old))
+    # Relocate the addresses that point past the inserted code.
+    for i, w in enumerate(words):
+        if base <= w < base + len(old) and w - base >= insert_at:
+            words[i] = w + len(inserted)
+    body = bytearray(struct.pack(f"<{len(words)}I", *words))
+    # A changed version string and a few tweaked constants.
+    body[1024:1056] = b"AstroPixelsPlus 2026.10.18-dirty\0"[:32]
+    for _ in range(20):
+        at = rng.randrange(0, len(body) - 4) & ~3
+        body[at:at + 4] = rng.getrandbits(32).to_bytes(4, "little")
+    body[insert_at:insert_at] = inserted
+    return bytes(body) + bytes(rng.getrandbits(8) for _ in range(3000))
+
+
+class FirmwareDeltaTests(unittest.TestCase):
+    @classmethod
+    def setUpClass(cls) -> None:
+        cls.tool = load("firmware_delta", TOOL)
+        cls._tmp = tempfile.TemporaryDirectory()
+        cls.tmp = Path(cls._tmp.name)
+        cls.old = synthetic_firmware(300_000, 48)
+        cls.new = rebuild(cls.old, 49)
+        cls.patch = cls.tool.make_patch(cls.old, cls.new)
+        cls.old_path = cls.tmp / "old.bin"
+        cls.old_path.write_bytes(cls.old)
+        # The tool tests run without a compiler; only the harness needs g++.
+        cls.binary = compile_harness(cls.tmp, "delta_harness", HARNESS) if have_gxx() else None
+
+    @classmethod
+    def tearDownClass(cls) -> None:
+        cls._tmp.cleanup()
+
+    def apply_patch(self, patch: bytes, old_path: Path | None = None) -> tuple[dict, dict, bytes]:
+        if self.binary is None:
+            self.skipTest("g++ not available for the DeltaPatch.h harness")
+        patch_path = self.tmp / "case.apd"
+        out_path = self.tmp / "case.out"
+        patch_path.write_bytes(patch)
+        out_path.unlink(missing_ok=True)
+        lines = run_harness(self.binary, str(old_path or self.old_path), str(patch_path), str(out_path))
+        values = {line.split()[1]: line.split()[2] for line in lines if line.startswith("D ")}
+        stats = {}
+        for line in lines:
+            if line.startswith("S stats "):
+                stats = {k: int(v) for k, v in (f.split("=") for f in line.split()[2:])}
+        return values, stats, out_path.read_bytes() if out_path.exists() else b""
+
+    def header_only(self, ops: bytes) -> bytes:
+        return self.patch[:76] + ops
+
+    def test_patch_is_a_small_fraction_of_the_image(self) -> None:
+        self.assertLess(len(self.patch), len(self.new) // 10)
+
+    def test_tool_applies_its_own_patch(self) -> None:
+        self.assertEqual(self.tool.apply_patch(self.old, self.patch), self.new)
+
+    def test_streaming_applier_reproduces_the_new_image(self) -> None:
+        values, stats, out = self.apply_patch(self.patch)
+        self.assertEqual(values["base_ok"], "1")
+        self.assertEqual(values["feed"], "0")
+        self.assertEqual(values["finish"], "0")
+        self.assertEqual(values["stream"], "0")
+        self.assertEqual(values["digest"], hashlib.sha256(self.new).hexdigest())
+        self.assertEqual(hashlib.sha256(out).digest(), hashlib.sha256(self.new).digest())
+        self.assertEqual(stats["produced"], len(self.new))
+        self.assertEqual(stats["copied"] + stats["patched"] + stats["literal"], len(self.new))
+        # Relocated regions are ADDs, the inserted code and tail are literals.
+        self.assertGreater(stats["adds"], 0)
+        self.assertGreaterEqual(stats["literal"], 2048 + 3000)
+        # The old image is read through the window, not byte by byte.
+        self.assertLess(stats["reads"], len(self.new) // 64)
+
+    def test_identical_images_give_a_tiny_patch(self) -> None:
+        patch = self.tool.make_patch(self.old, self.old)
+        self.assertLess(len(patch), 100)
+        values, stats, out = self.apply_patch(patch)
+        self.assertEqual(values["stream"], "0")
+        self.assertEqual(out, self.old)
+        self.assertEqual(stats["copies"], 1)
+
+    def test_wrong_base_is_refused_before_any_output(self) -> None:
+        other = self.tmp / "other.bin"
+        other.write_bytes(synthetic_firmware(300_000, 7))
+        values, _, out = self.apply_patch(self.patch, other)
+        self.assertEqual(values["base_ok"], "0")
+        self.assertEqual(out, b"")
+        with self.assertRaises(ValueError):
+            self.tool.apply_patch(other.read_bytes(), self.patch)
+
+    def test_malformed_patches_are_refused(self) -> None:
+        old_size = len(self.old)
+        cases = {
+            "bad_magic": (b"XPD1" + self.patch[4:], "2"),
+            "bad_op": (self.header_only(b"\x09"), "3"),
+            "copy_past_end": (self.header_only(b"\x01" + self.tool.varint(old_size - 4) +
+                                               self.tool.varint(8) + b"\x00"), "4"),
+            "literal_past_new_size": (self.header_only(b"\x03" + self.tool.varint(len(self.new) + 1)), "4"),
+            "add_segment_overrun": (self.header_only(b"\x02\x00\x04\x02\x05"), "4"),
+            # produced + length would wrap past 2^32 and look in range.
+            "literal_length_wraps": (self.header_only(b"\x01" + self.tool.varint(0) + self.tool.varint(8) +
+                                                      b"\x03" + self.tool.varint(0xFFFFFFFC)), "4"),
+            "trailing_data": (self.patch + b"\x00", "7"),
+        }
+        for name, (patch, expected) in cases.items():
+            with self.subTest(name):
+                values, _, _ = self.apply_patch(patch)
+                self.assertEqual(values["feed"], expected)
+
+    def test_truncated_patch_fails_at_finish(self) -> None:
+        values, _, _ = self.apply_patch(self.patch[:-40])
+        self.assertEqual(values["feed"], "0")
+        self.assertEqual(values["finish"], "8")
+
+    def test_cli_round_trip(self) -> None:
+        new_path = self.tmp / "new.bin"
+        new_path.write_bytes(self.new)
+        patch_path = self.tmp / "cli.apd"
+        out_path = self.tmp / "cli.bin"
+        subprocess.run(["python3", str(TOOL), "make", str(self.old_path), str(new_path), "-o", str(patch_path)],
+                       check=True, capture_output=True)
+        subprocess.run(["python3", str(TOOL), "apply", str(self.old_path), str(patch_path), "-o", str(out_path)],
+                       check=True, capture_output=True)
+        self.assertEqual(out_path.read_bytes(), self.new)
+
+    def esp_image(self, segments: list[bytes], hash_appended: bool = True) -> bytes:
+        """An ESP32 app image laid out the way esptool elf2image writes it."""
+        header = bytes([0xE9, len(segments), 2, 0x20]) + struct.pack("<I", 0x40080000) + bytes(15)
+        header += bytes([1 if hash_appended else 0])
+        body = bytearray(header)
+        for n, data in enumerate(segments):
+            body += struct.pack("<II", 0x3F400000 + n * 0x10000, len(data)) + data
+        body += bytes(15 - len(body) % 16) + b"\xef"
+        if hash_appended:
+            body += hashlib.sha256(body).digest()
+        return bytes(body)
+
+    def image_len(self, partition: bytes) -> int:
+        if self.binary is None:
+            self.skipTest("g++ not available for the DeltaPatch.h harness")
+        path = self.tmp / "partition.bin"
+        path.write_bytes(partition)
+        return int(run_harness(self.binary, "imagelen", str(path))[0].split()[2])
+
+    def test_image_length_matches_the_built_image(self) -> None:
+        for sizes, appended in (([1000, 4096, 333], True), ([16, 15], False), ([17], True)):
+            with self.subTest(sizes=sizes, appended=appended):
+                image = self.esp_image([bytes([n]) * size for n, size in enumerate(sizes)], appended)
+                self.assertEqual(self.image_len(image + b"\xff" * 8192), len(image))
+
+    def test_image_length_rejects_a_bad_header(self) -> None:
+        image = self.esp_image([bytes(64)])
+        self.assertEqual(self.image_len(b"\x00" + image[1:] + b"\xff" * 64), -1)
+        # Cut short: the appended digest would run past the partition.
+        self.assertEqual(self.image_len(self.esp_image([bytes(64)])[:-40]), -1)
+        self.assertEqual(self.image_len(image[:20]), -1)
+
+    def test_upload_tool_kind(self) -> None:
+        kinds = load("http_ota_upload", UPLOAD_TOOL).KINDS
+        self.assertEqual(kinds["delta"]["endpoint"], "/upload/firmware-delta")
+        self.assertEqual(kinds["delta"]["field"], "patch")
+
+if __name__ == "__main__":
+    unittest.main()
@@ -0,0 +1,190 @@
+#!/usr/bin/env python3
+"""Host tests for LedPalette.h against the per-effect tables it replaced.
+
+Run with --report to print a size/speed comparison instead of the tests.
+"""
+
+from __future__ import annotations
+
+import sys
+import unittest
+from pathlib import Path
+
+
+ROOT = Path(__file__).resolve().parents[1]
+sys.path.insert(0, str(ROOT / "tools"))
+
+from host_harness import HarnessTestCase, compile_harness, report_workdir, run_harness  # noqa: E402
+
+HARNESS = r"""
+#include <stdio.h>
+#include <time.h>
+#include "LedPalette.h"
+
+static double nowNs()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+int main(int argc, char **argv)
+{
+    uint8_t r, g, b;
+    if (argc > 1 && argv[1][0] == 'b')
+    {
+        // Table lookup as the old effects did it vs. computing the wheel.
+        static uint8_t lut[1537][3];
+        for (int i = 0; i < 1536; i++) ledPaletteWheel(uint16_t(i), lut[i][0], lut[i][1], lut[i][2]);
+        const int kIterations = 20000000;
+        volatile uint32_t sink = 0;
+        double t0 = nowNs();
+        for (int i = 0; i < kIterations; i++) { int p = (i * 7) % 1536; sink += lut[p][0] + lut[p][1] + lut[p][2]; }
+        double t1 = nowNs();
+        for (int i = 0; i < kIterations; i++) { ledPaletteWheel(uint16_t((i * 7) % 1536), r, g, b); sink += r + g + b; }
+        double t2 = nowNs();
+        printf("lut_ns %.3f\ncomputed_ns %.3f\n", (t1 - t0) / kIterations, (t2 - t1) / kIterations);
+        printf("named_bytes %u\n", (unsigned)sizeof(kLedNamedColors));
+        return sink == 0xFFFFFFFF;
+    }
+    for (int i = 0; i < 1536; i++)
+    {
+        ledPaletteWheel(uint16_t(i), r, g, b);
+        printf("W %d %u %u %u\n", i, r, g, b);
+    }
+    for (int p = 0; p <= kLedRampLast; p++)
+    {
+        int len = ledRampPaletteLength(LedRampPalette(p));
+        for (int i = 0; i < len; i++)
+        {
+            ledRampPaletteSample(LedRampPalette(p), i, r, g, b);
+            printf("P %d %d %u %u %u\n", p, i, r, g, b);
+        }
+    }
+    for (int rr = 0; rr < 256; rr += 4)
+        for (int gg = 0; gg < 256; gg += 4)
+            for (int bb = 0; bb < 256; bb += 4)
+                printf("H %d %d %d %u\n", rr, gg, bb, ledPaletteHoloIndexForRgb(rr, gg, bb));
+    const char *names[] = { "", "DEFAULT", "RED", "ORANGE", "YELLOW", "GREEN", "BLUE", "PURPLE", "WHITE", "PINK" };
+    for (unsigned i = 0; i < sizeof(names) / sizeof(names[0]); i++)
+    {
+        const LedNamedColor *c = ledPaletteFindNamedColor(names[i]);
+        printf("N %s %d %d\n", names[i][0] ? names[i] : "-", c ? (int)c->id : -1, c ? (int)c->holoIndex : -1);
+    }
+    return 0;
+}
+"""
+
+
+def legacy_wheel() -> list[tuple[int, int, int]]:
+    lut = []
+    for seg in range(6):
+        for i in range(256):
+            lut.append([
+                (255, i, 0), (255 - i, 255, 0), (0, 255, i),
+                (0, 255 - i, 255), (i, 0, 255), (255, 0, 255 - i),
+            ][seg])
+    return lut
+
+
+def legacy_ramp(palette: int) -> list[tuple[int, int, int]]:
+    if palette == 0:
+        return legacy_wheel()
+    if palette == 5:
+        lut = [None] * 768
+        for i in range(128):
+            lut[i] = (254 - 2 * i, 0, 127 - i)
+            lut[i + 128] = (i, 2 * i, 0)
+            lut[i + 256] = (127 - i, 254 - 2 * i, 0)
+            lut[i + 384] = (0, i, 2 * i)
+            lut[i + 512] = (0, 127 - i, 254 - 2 * i)
+            lut[i + 640] = (2 * i, 0, i)
+        return lut
+    mask = {1: (1, 0, 0), 2: (0, 1, 0), 3: (0, 0, 1), 4: (1, 1, 1)}[palette]
+    levels = list(range(256)) + [255 - i for i in range(256)]
+    return [tuple(level * m for m in mask) for level in levels]
+
+
+def legacy_holo_index(r: int, g: int, b: int) -> int:
+    if r < 16 and g < 16 and b < 16:
+        return 0
+    if r >= g and r >= b:
+        if g > 180 and b < 100:
+            return 7
+        if b > 180 and g > 180:
+            return 8
+        if b > 140:
+            return 6
+        return 1
+    if g >= r and g >= b:
+        if r > 180 and b < 100:
+            return 2
+        if b > 160:
+            return 4
+        return 3
+    if r > 160 and g > 160:
+        return 9
+    if r > 140:
+        return 6
+    return 5
+
+
+LEGACY_HOLO_NAMES = {
+    "-": 0, "DEFAULT": 0, "RED": 1, "ORANGE": 2, "YELLOW": 7,
+    "GREEN": 3, "BLUE": 5, "PURPLE": 6, "WHITE": 9,
+}
+
+
+class LedPaletteTests(HarnessTestCase):
+    HARNESS_NAME = "palette_harness"
+    HARNESS = HARNESS
+
+    @classmethod
+    def setUpClass(cls) -> None:
+        super().setUpClass()
+        cls.lines = run_harness(cls.binary)
+
+    def rows(self, tag: str) -> list[list[str]]:
+        return [line.split()[1:] for line in self.lines if line.startswith(tag + " ")]
+
+    def test_wheel_matches_legacy_plasma_lut(self) -> None:
+        expected = legacy_wheel()
+        for idx, r, g, b in self.rows("W"):
+            self.assertEqual((int(r), int(g), int(b)), expected[int(idx)], f"wheel step {idx}")
+
+    def test_ramp_palettes_match_legacy_fade_and_scroll_tables(self) -> None:
+        rows = self.rows("P")
+        for palette in range(6):
+            expected = legacy_ramp(palette)
+            got = [tuple(int(v) for v in row[2:]) for row in rows if int(row[0]) == palette]
+            self.assertEqual(got, expected, f"palette {palette}")
+
+    def test_holo_index_matches_legacy_classifier(self) -> None:
+        for r, g, b, index in self.rows("H"):
+            self.assertEqual(int(index), legacy_holo_index(int(r), int(g), int(b)), f"rgb {r},{g},{b}")
+
+    def test_named_colours_keep_visual_authoring_holo_indices(self) -> None:
+        for name, color_id, holo in self.rows("N"):
+            if name == "PINK":
+                self.assertEqual(int(color_id), -1)
+                continue
+            self.assertEqual(int(holo), LEGACY_HOLO_NAMES[name], name)
+
+
+def report() -> int:
+    with report_workdir() as workdir:
+        binary = compile_harness(workdir, "palette_harness", HARNESS)
+        stats = dict(line.split() for line in run_harness(binary, "bench"))
+    print("LED palette size/speed report")
+    print("  before: PlasmaEffect LUT          4611 B heap per effect object (1537 x 3)")
+    print("          FadeAndScroll palette     1536-4608 B heap per effect object")
+    print(f"  after:  kLedNamedColors           {stats['named_bytes']:>4} B flash")
+    print("          wheel / ramp palettes        0 B (computed per sample)")
+    print(f"  host lookup cost: table {float(stats['lut_ns']):.2f} ns/px, computed {float(stats['computed_ns']):.2f} ns/px")
+    return 0
+
+
+if __name__ == "__main__":
+    if "--report" in sys.argv:
+        sys.exit(report())
+    unittest.main()
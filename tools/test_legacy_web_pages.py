@@ -0,0 +1,335 @@
+#!/usr/bin/env python3
+"""Host tests for WebPages.h, the legacy setup pages rendered from flash
+tables, and the PlatformIO env that compiles them into the firmware.
+
+Run with --report for the measured static-init and per-page streaming numbers.
+"""
+
+from __future__ import annotations
+
+import configparser
+import re
+import shutil
+import subprocess
+import sys
+import unittest
+from html.parser import HTMLParser
+from pathlib import Path
+
+
+ROOT = Path(__file__).resolve().parents[1]
+sys.path.insert(0, str(ROOT / "tools"))
+
+from host_harness import HarnessTestCase, compile_harness, report_workdir  # noqa: E402
+
+HARNESS = r"""
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "WebPages.h"
+
+#ifdef STRESS_PAGE
+// Far past the old ~44 WButton boot ceiling; still a constant table.
+#define B4(n) LWButton("Open " n, ":OP" n), LWButton("Close " n, ":CL" n), \
+              LWButton("Flap " n, ":OF" n), LWButton("Wave " n, ":OW" n)
+#define B20(n) B4(n "1"), B4(n "2"), B4(n "3"), B4(n "4"), B4(n "5")
+constexpr LegacyWebControl kStressContents[] = {
+    LWHeading("Stress"), B20("0"), B20("1"), B20("2"), B20("3"), B20("4"),
+    B20("5"), B20("6"), B20("7"), B20("8"), B20("9")};
+constexpr LegacyWebPage kStressPage = {"/stress", "Stress", kStressContents,
+                                       legacyWebCount(kStressContents)};
+#endif
+
+static int render(const LegacyWebPage *page, size_t cap)
+{
+    static LegacyWebStream stream;
+    legacyWebBegin(stream, page);
+    ChunkedJsonCursor cursor;
+    chunkedJsonBegin(cursor, legacyWebPageNext, &stream);
+    static uint8_t buffer[4096];
+    for (unsigned fills = 0;; fills++)
+    {
+        size_t n = chunkedJsonFill(cursor, buffer, cap);
+        if (n == 0) break;
+        if (n > cap || fills > 1000000) return 3;
+        fwrite(buffer, 1, n, stdout);
+    }
+    ChunkedJsonStats stats;
+    memset(&stats, 0, sizeof(stats));
+    chunkedJsonRecord(stats, cursor);
+    printf("\n--stats\nbody %u\npeak_piece %u\naborted %u\ntruncated %u\n",
+           stats.lastBodyBytes, stats.peakPieceBytes, stats.aborted, (unsigned)stream.truncated);
+    return 0;
+}
+
+static size_t textBytes(const char *s) { return s ? strlen(s) + 1 : 0; }
+
+// argv: "sizes", or a buffer size and a page path.
+int main(int argc, char **argv)
+{
+    if (argc == 2 && strcmp(argv[1], "sizes") == 0)
+    {
+        size_t tables = sizeof(kLegacyWebPages), strings = 0;
+        unsigned controls = 0, buttons = 0;
+        for (size_t p = 0; p < legacyWebCount(kLegacyWebPages); p++)
+        {
+            const LegacyWebPage &page = kLegacyWebPages[p];
+            tables += page.controlCount * sizeof(LegacyWebControl);
+            strings += textBytes(page.path) + textBytes(page.title);
+            for (size_t c = 0; c < page.controlCount; c++)
+            {
+                const LegacyWebControl &control = page.controls[c];
+                controls++;
+                if (control.kind == kLegacyWebButton || control.kind == kLegacyWebSave ||
+                    control.kind == kLegacyWebPost)
+                    buttons++;
+                strings += textBytes(control.label) + textBytes(control.id) + textBytes(control.action);
+                tables += control.optionCount * sizeof(LegacyWebOption);
+                for (size_t o = 0; o < control.optionCount; o++)
+                    strings += textBytes(control.options[o].label) + textBytes(control.options[o].value);
+            }
+        }
+        printf("pages %u\ncontrols %u\nbuttons %u\ntables %u\nstrings %u\nscratch %u\n",
+               (unsigned)legacyWebCount(kLegacyWebPages), controls, buttons, (unsigned)tables,
+               (unsigned)strings, (unsigned)sizeof(LegacyWebStream));
+        return 0;
+    }
+    if (argc < 3) return 2;
+    const LegacyWebPage *page = legacyWebFindPage(argv[2]);
+#ifdef STRESS_PAGE
+    if (strcmp(argv[2], "/stress") == 0) page = &kStressPage;
+#endif
+    if (page == nullptr) return 1;
+    return render(page, (size_t)atoi(argv[1]));
+}
+"""
+
+VOID_TAGS = {"meta", "hr", "input", "br", "path"}
+
+
+def build_harness(workdir: Path, stress: bool = False) -> tuple[Path, Path]:
+    """The harness binary, plus its object file for the static-init check."""
+    name = "legacy_stress" if stress else "legacy_harness"
+    flags = ["-Wno-unused-function"] + (["-DSTRESS_PAGE"] if stress else [])
+    obj = compile_harness(workdir, name, HARNESS, flags=flags, link=False)
+    return compile_harness(workdir, name, HARNESS, flags=flags), obj
+
+
+def render(binary: Path, path: str, cap: int = 1436) -> tuple[str, dict[str, int]]:
+    result = subprocess.run([str(binary), str(cap), path], capture_output=True, text=True)
+    if result.returncode != 0:
+        raise LookupError(f"{path}: exit {result.returncode}")
+    body, _, tail = result.stdout.rpartition("\n--stats\n")
+    stats = dict(line.split(" ", 1) for line in tail.splitlines())
+    return body, {key: int(value) for key, value in stats.items()}
+
+
+def sizes(binary: Path) -> dict[str, int]:
+    out = subprocess.run([str(binary), "sizes"], check=True, capture_output=True, text=True).stdout
+    return {key: int(value) for key, value in (line.split(" ", 1) for line in out.splitlines())}
+
+
+def page_paths() -> list[str]:
+    source = (ROOT / "WebPages.h").read_text(encoding="utf-8")
+    paths = re.findall(r'LEGACY_WEB_PAGE\(LEGACY_WEB_ROOT( "[^"]+")?,', source)
+    return ["/legacy" + (suffix.strip().strip('"') if suffix else "") for suffix in paths]
+
+
+def dynamic_initialisers(obj: Path) -> list[str]:
+    out = subprocess.run(["nm", str(obj)], check=True, capture_output=True, text=True).stdout
+    return [line for line in out.splitlines() if "_GLOBAL__sub_I" in line]
+
+
+class PageParser(HTMLParser):
+    def __init__(self) -> None:
+        super().__init__()
+        self.stack: list[str] = []
+        self.errors: list[str] = []
+        self.elements: list[tuple[str, dict[str, str | None]]] = []
+        self.options: dict[str, list[str]] = {}
+        self.scripts: list[str] = []
+        self._select: str | None = None
+        self._in_script = False
+
+    def handle_starttag(self, tag: str, attrs: list[tuple[str, str | None]]) -> None:
+        attributes = dict(attrs)
+        self.elements.append((tag, attributes))
+        if tag == "select":
+            self._select = attributes.get("id")
+            self.options[self._select or ""] = []
+        if tag == "option" and self._select is not None:
+            self.options[self._select].append(attributes.get("value") or "")
+        self._in_script = tag == "script"
+        if tag not in VOID_TAGS:
+            self.stack.append(tag)
+
+    def handle_endtag(self, tag: str) -> None:
+        if tag in VOID_TAGS:
+            return
+        if not self.stack or self.stack[-1] != tag:
+            self.errors.append(f"unexpected </{tag}> with open {self.stack}")
+            return
+        self.stack.pop()
+        if tag == "select":
+            self._select = None
+        self._in_script = False
+
+    def handle_data(self, data: str) -> None:
+        if self._in_script:
+            self.scripts.append(data)
+
+
+def parse(body: str) -> PageParser:
+    parser = PageParser()
+    parser.feed(body)
+    parser.close()
+    return parser
+
+
+def allowed_pref_keys() -> set[str]:
+    """Keys /api/pref accepts: every non-blob entry of the config registry schema."""
+    ino = (ROOT / "AstroPixelsPlus.ino").read_text(encoding="utf-8")
+    schema = (ROOT / "ConfigRegistry.h").read_text(encoding="utf-8")
+    keys = dict(re.findall(r'^#define (PREFERENCE_\w+)\s+"([^"]+)"', ino, re.M))
+    return {keys[name] for name in re.findall(r'CFG_(?:BOOL|INT|TEXT)\(\w+, (PREFERENCE_\w+)', schema)}
+
+
+class LegacyWebPageTests(HarnessTestCase):
+    @classmethod
+    def build(cls, workdir: Path) -> Path:
+        binary, cls.obj = build_harness(workdir)
+        return binary
+
+    @classmethod
+    def setUpClass(cls) -> None:
+        super().setUpClass()
+        cls.paths = page_paths()
+        cls.pages = {path: render(cls.binary, path) for path in cls.paths}
+
+    def test_every_page_is_identical_at_every_buffer_size(self) -> None:
+        self.assertEqual(len(self.paths), 10)
+        for path, (body, stats) in self.pages.items():
+            for cap in (1, 7, 64, 512):
+                self.assertEqual(render(self.binary, path, cap)[0], body, f"{path} at {cap}")
+            self.assertEqual(stats["body"], len(body.encode("utf-8")), path)
+            self.assertEqual(stats["truncated"], 0, path)
+            self.assertEqual(stats["aborted"], 0, path)
+            # Only one control is ever formatted at a time.
+            self.assertLess(stats["peak_piece"], 256, path)
+
+    def test_pages_are_well_formed(self) -> None:
+        for path, (body, _) in self.pages.items():
+            self.assertTrue(body.startswith("<!DOCTYPE html>\n"), path)
+            self.assertTrue(body.endswith("</html>\n"), path)
+            parsed = parse(body)
+            self.assertEqual(parsed.errors, [], path)
+            self.assertEqual(parsed.stack, [], path)
+            ids = [attrs["id"] for _, attrs in parsed.elements if attrs.get("id")]
+            self.assertEqual(len(ids), len(set(ids)), path)
+
+    def test_paths_resolve_with_or_without_trailing_slash(self) -> None:
+        self.assertEqual(render(self.binary, "/legacy/")[0], self.pages["/legacy"][0])
+        self.assertEqual(render(self.binary, "/legacy/sound/")[0], self.pages["/legacy/sound"][0])
+        for path in ("/legacy/nope", "/legacyx", "/", "/legacy/sound/x"):
+            with self.assertRaises(LookupError, msg=path):
+                render(self.binary, path)
+
+    def test_links_point_at_pages(self) -> None:
+        for path, (body, _) in self.pages.items():
+            for tag, attrs in parse(body).elements:
+                href = attrs.get("href")
+                if tag == "a" and href and href.startswith("/legacy"):
+                    self.assertIn(href, self.pages, f"{path} -> {href}")
+
+    def test_preference_fields_use_allowed_keys(self) -> None:
+        allowed = allowed_pref_keys()
+        seen = set()
+        for path, (body, _) in self.pages.items():
+            parsed = parse(body)
+            prefs = [attrs["id"] for _, attrs in parsed.elements if "data-pref" in attrs]
+            for key in prefs:
+                self.assertIn(key, allowed, path)
+            seen.update(prefs)
+            saves = [attrs for _, attrs in parsed.elements if "data-save" in attrs]
+            self.assertEqual(bool(prefs), bool(saves), path)
+        self.assertTrue({"mserial2", "msound", "mvolume", "ssid", "pass", "rhost"} <= seen)
+
+    def test_command_templates_reference_fields_on_the_page(self) -> None:
+        commands = 0
+        for path, (body, _) in self.pages.items():
+            parsed = parse(body)
+            ids = {attrs["id"] for _, attrs in parsed.elements if attrs.get("id")}
+            runs = [attrs["data-run"] for _, attrs in parsed.elements if attrs.get("data-run")]
+            for _, attrs in parsed.elements:
+                if "data-run-select" in attrs:
+                    runs.extend(parsed.options[attrs["id"]])
+            for template in runs:
+                for command in template.split("|"):
+                    commands += 1
+                    for field, _ in re.findall(r"\{(\w+)(?::(\d))?\}", command):
+                        self.assertIn(field, ids, f"{path}: {command}")
+                    literal = re.sub(r"\{[^}]*\}", "", command)
+                    self.assertRegex(literal, r"^([:*@][A-Z0-9]|D\d{3}$)", f"{path}: {command}")
+        self.assertGreater(commands, 60)
+
+    def test_logic_apply_builds_an_aple_command(self) -> None:
+        parsed = parse(self.pages["/legacy/logics"][0])
+        runs = [attrs["data-run"] for _, attrs in parsed.elements if attrs.get("data-run")]
+        self.assertIn("@APLE1{frontseq:2}{frontcolor}{fldspeed}{fldseconds:2}|@1M{fronttext}", runs)
+        self.assertEqual(parsed.options["frontseq"][-1], "99")
+        self.assertEqual(parsed.options["frontcolor"], [str(i) for i in range(10)])
+
+    def test_tables_need_no_dynamic_initialisation(self) -> None:
+        self.assertEqual(dynamic_initialisers(self.obj), [])
+
+    def test_button_count_is_not_capped(self) -> None:
+        binary, obj = build_harness(self.workdir, stress=True)
+        self.assertEqual(dynamic_initialisers(obj), [])
+        body, stats = render(binary, "/stress", 1436)
+        self.assertEqual(body.count("<button "), 200)
+        self.assertLess(stats["peak_piece"], 256)
+
+    def test_page_script_parses(self) -> None:
+        node = shutil.which("node")
+        if node is None:
+            self.skipTest("node not available")
+        script = self.workdir / "legacy.js"
+        script.write_text("".join(parse(self.pages["/legacy/sound"][0]).scripts), encoding="utf-8")
+        result = subprocess.run([node, "--check", str(script)], capture_output=True, text=True)
+        self.assertEqual(result.returncode, 0, result.stderr)
+
+
+class BuildConfigTests(unittest.TestCase):
+    def test_a_platformio_env_compiles_the_pages(self) -> None:
+        config = configparser.ConfigParser(interpolation=None)
+        config.read(ROOT / "platformio.ini", encoding="utf-8")
+        env = config["env:astropixelsplus-legacy-pages"]
+        self.assertEqual(env["extends"], "env:astropixelsplus")
+        flags = env["build_flags"].split()
+        self.assertEqual(flags[0], "${env:astropixelsplus.build_flags}")
+        self.assertIn("-DUSE_LEGACY_WEB_PAGES", flags)
+
+
+def report() -> int:
+    with report_workdir() as workdir:
+        binary, obj = build_harness(workdir)
+        counts = sizes(binary)
+        initialisers = len(dynamic_initialisers(obj))
+        pages = {path: render(binary, path) for path in page_paths()}
+    print("Legacy setup pages: heap taken during global construction")
+    print("  default build: 0 B before and after; it never compiled WebPages.h")
+    print(f"  legacy-pages build: {initialisers} dynamic initialisers, {counts['pages']} pages / "
+          f"{counts['controls']} controls / {counts['buttons']} buttons as constant tables "
+          f"({counts['tables']} B descriptors + {counts['strings']} B strings, host sizes)")
+    print("  device check: boot_free_heap in /api/health should match between the astropixelsplus")
+    print("  and astropixelsplus-legacy-pages builds (not measured here)")
+    print(f"Per request: one {counts['scratch']} B stream, body written in pieces")
+    for path, (_, stats) in pages.items():
+        print(f"  {path:<18} body {stats['body']:>5} B, largest piece {stats['peak_piece']:>3} B")
+    return 0
+
+
+if __name__ == "__main__":
+    if "--report" in sys.argv:
+        sys.exit(report())
+    unittest.main()
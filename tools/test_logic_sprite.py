@@ -0,0 +1,163 @@
+#!/usr/bin/env python3
+"""Host tests for LogicSpriteFormat.h, the .lsa decoder behind /api/sprites.
+
+Sprites are built with tools/make_logic_sprite.py, so the encoder and the
+firmware decoder are checked against each other, and hand-corrupted blobs
+must be rejected before they reach the sprite cache.
+"""
+
+from __future__ import annotations
+
+import struct
+import sys
+import unittest
+from pathlib import Path
+
+
+ROOT = Path(__file__).resolve().parents[1]
+sys.path.insert(0, str(ROOT / "tools"))
+
+import make_logic_sprite as sprite  # noqa: E402
+from host_harness import HarnessTestCase, run_harness  # noqa: E402
+
+
+HARNESS = r"""
+#include <stdlib.h>
+#include "LogicSpriteFormat.h"
+
+int main(int argc, char **argv)
+{
+    if (argc < 2) return 2;
+    FILE *file = fopen(argv[1], "rb");
+    if (!file) { perror(argv[1]); return 2; }
+    static uint8_t data[LOGIC_SPRITE_MAX_BYTES * 2];
+    size_t len = fread(data, 1, sizeof(data), file);
+    fclose(file);
+
+    LogicSpriteHeader header;
+    char err[LOGIC_SPRITE_ERR_LEN];
+    if (!logicSpriteValidate(data, len, header, err, sizeof(err)))
+    {
+        printf("ERR %s\n", err);
+        return 0;
+    }
+    printf("OK %u %u %u %u %u\n", header.width, header.height, header.paletteCount,
+           header.frameCount, header.flags);
+    for (unsigned i = 0; i < header.paletteCount; i++)
+        printf("P %u %u %u\n", header.palette[i][0], header.palette[i][1], header.palette[i][2]);
+    uint8_t pixels[LOGIC_SPRITE_MAX_PIXELS];
+    for (uint16_t f = 0; f < header.frameCount; f++)
+    {
+        uint16_t delayMs = 0;
+        if (!logicSpriteFrameAt(data, len, header, f, pixels, delayMs)) return 1;
+        printf("F %u ", delayMs);
+        for (unsigned i = 0; i < unsigned(header.width) * header.height; i++)
+            printf("%x", pixels[i]);
+        printf("\n");
+    }
+    return 0;
+}
+"""
+
+
+def spec(frames: list[dict], **extra) -> dict:
+    base = {
+        "width": 4,
+        "height": 2,
+        "palette": {".": "#000000", "r": "#ff0000", "b": "#0000ff"},
+        "frames": frames,
+    }
+    base.update(extra)
+    return base
+
+
+TWO_FRAMES = spec([
+    {"rows": ["r..r", ".bb."], "delay_ms": 250},
+    {"rows": ["rrrr", "...."]},
+], delay_ms=80)
+
+
+class LogicSpriteDecoderTests(HarnessTestCase):
+    HARNESS_NAME = "logic_sprite_harness"
+    HARNESS = HARNESS
+
+    def decode(self, blob: bytes) -> list[str]:
+        path = self.workdir / "sprite.lsa"
+        path.write_bytes(blob)
+        return run_harness(self.binary, str(path))
+
+    def assertRejected(self, blob: bytes, message: str) -> None:
+        self.assertEqual(self.decode(blob), [f"ERR {message}"])
+
+    def frame_table(self, blob: bytes) -> int:
+        return sprite.HEADER.size + blob[7] * 3
+
+    def test_frames_decode_to_the_source_rows(self) -> None:
+        lines = self.decode(sprite.build(TWO_FRAMES))
+        self.assertEqual(lines[0], "OK 4 2 3 2 1")
+        frames = [line for line in lines if line.startswith("F ")]
+        self.assertEqual(frames, ["F 250 10010220", "F 80 11110000"])
+
+    def test_palette_is_copied_with_the_header(self) -> None:
+        lines = self.decode(sprite.build(TWO_FRAMES))
+        self.assertEqual([line for line in lines if line.startswith("P ")],
+                         ["P 0 0 0", "P 255 0 0", "P 0 0 255"])
+
+    def test_delay_is_floored_at_the_minimum(self) -> None:
+        lines = self.decode(sprite.build(spec([{"rows": ["....", "...."]}], delay_ms=5)))
+        self.assertEqual(lines[-1], "F 20 00000000")
+
+    def test_long_runs_split_across_rle_pairs(self) -> None:
+        rows = ["r" * 16 for _ in range(16)]
+        blob = sprite.build(spec([{"rows": rows}], width=16, height=16))
+        self.assertEqual(self.decode(blob)[-1], "F 100 " + "1" * 256)
+
+    def test_bad_magic_is_rejected(self) -> None:
+        blob = bytearray(sprite.build(TWO_FRAMES))
+        blob[0:4] = b"NOPE"
+        self.assertRejected(bytes(blob), "bad sprite magic")
+
+    def test_oversized_sprite_is_rejected(self) -> None:
+        blob = sprite.build(TWO_FRAMES) + bytes(sprite.MAX_BYTES)
+        self.assertRejected(blob, "sprite too large")
+
+    def test_truncated_frame_table_is_rejected(self) -> None:
+        blob = sprite.build(TWO_FRAMES)
+        self.assertRejected(blob[:self.frame_table(blob) + 4], "sprite frame table truncated")
+
+    def test_run_past_the_frame_is_rejected(self) -> None:
+        blob = bytearray(sprite.build(TWO_FRAMES))
+        offset, _, _ = sprite.FRAME_ENTRY.unpack_from(blob, self.frame_table(blob))
+        blob[offset] = 200
+        self.assertRejected(bytes(blob), "sprite frame 0 does not decode")
+
+    def test_index_past_the_palette_is_rejected(self) -> None:
+        blob = bytearray(sprite.build(TWO_FRAMES))
+        offset, _, _ = sprite.FRAME_ENTRY.unpack_from(blob, self.frame_table(blob))
+        blob[offset + 1] = 3
+        self.assertRejected(bytes(blob), "sprite frame 0 does not decode")
+
+    def test_odd_rle_length_is_rejected(self) -> None:
+        blob = bytearray(sprite.build(TWO_FRAMES))
+        entry = self.frame_table(blob) + sprite.FRAME_ENTRY.size
+        offset, length, delay = sprite.FRAME_ENTRY.unpack_from(blob, entry)
+        struct.pack_into(sprite.FRAME_ENTRY.format, blob, entry, offset, length - 1, delay)
+        self.assertRejected(bytes(blob), "sprite frame 1 does not decode")
+
+    def test_frame_offset_out_of_bounds_is_rejected(self) -> None:
+        blob = bytearray(sprite.build(TWO_FRAMES))
+        entry = self.frame_table(blob) + sprite.FRAME_ENTRY.size
+        _, length, delay = sprite.FRAME_ENTRY.unpack_from(blob, entry)
+        struct.pack_into(sprite.FRAME_ENTRY.format, blob, entry, len(blob), length, delay)
+        self.assertRejected(bytes(blob), "sprite frame 1 does not decode")
+
+    def test_frame_offset_inside_the_table_is_rejected(self) -> None:
+        blob = bytearray(sprite.build(TWO_FRAMES))
+        entry = self.frame_table(blob)
+        _, length, delay = sprite.FRAME_ENTRY.unpack_from(blob, entry)
+        struct.pack_into(sprite.FRAME_ENTRY.format, blob, entry, entry, length, delay)
+        self.assertRejected(bytes(blob), "sprite frame 0 does not decode")
+
+
+if __name__ == "__main__":
+    unittest.main()
@@ -0,0 +1,314 @@
+#!/usr/bin/env python3
+"""Host tests for the LogicTextStrip.h glyph strip cache.
+
+Run with --report to print the per-frame cost of scrolling at each DT: speed,
+strip blit vs. re-rasterising the message every frame.
+"""
+
+from __future__ import annotations
+
+import argparse
+import re
+import sys
+import unittest
+from pathlib import Path
+
+
+ROOT = Path(__file__).resolve().parents[1]
+sys.path.insert(0, str(ROOT / "tools"))
+
+from host_harness import HarnessTestCase, compile_harness, report_workdir, run_harness  # noqa: E402
+
+HARNESS = r"""
+#include <stdio.h>
+#include <time.h>
+#include "LogicTextStrip.h"
+
+static double nowNs()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static uint8_t sFrame[16][32];
+
+static void dumpStrip(const char *tag, const LogicTextStrip &s)
+{
+    printf("%s lines=%u cols=%u", tag, s.lineCount, s.columnCount);
+    for (unsigned i = 0; i < unsigned(s.lineCount) * s.columnCount; i++) printf(" %u", s.columns[i]);
+    printf("\n");
+}
+
+static void blitToFrame(const LogicTextStrip &s, int offset, unsigned w, unsigned h)
+{
+    logicTextStripBlit(s, offset, w, h, [](unsigned x, unsigned y, bool on) { sFrame[y][x] = on; });
+}
+
+static void bench(unsigned w, unsigned h, int iterations)
+{
+    static const char *kMessage = "General Kenobi, you are a bold one\nHello there";
+    LogicTextStrip s = {};
+    logicTextStripBuild(s, kMessage, h);
+    volatile uint32_t sink = 0;
+    auto setPixel = [&sink](unsigned x, unsigned y, bool on) { sink += on ? x + y : 0; };
+
+    double t0 = nowNs();
+    for (int i = 0; i < iterations; i++)
+        logicTextStripBlit(s, i % s.columnCount, w, h, setPixel);
+    double t1 = nowNs();
+    // Legacy model: rasterise the message again before every frame.
+    LogicTextStrip scratch = {};
+    for (int i = 0; i < iterations; i++)
+    {
+        logicTextStripBuild(scratch, kMessage, h);
+        logicTextStripBlit(scratch, i % scratch.columnCount, w, h, setPixel);
+    }
+    double t2 = nowNs();
+    printf("bench %ux%u blit_ns %.1f raster_ns %.1f build_ns %.1f\n", w, h,
+           (t1 - t0) / iterations, (t2 - t1) / iterations, (t2 - t1 - (t1 - t0)) / iterations);
+    free(s.columns);
+    free(scratch.columns);
+}
+
+int main(int argc, char **argv)
+{
+    if (argc > 1 && argv[1][0] == 'b')
+    {
+        bench(9, 10, 200000);
+        bench(27, 4, 200000);
+        for (uint8_t speed = 0; speed <= 9; speed++) printf("step %u %u\n", speed, logicTextStepMs(speed));
+        printf("font_bytes %u\n", (unsigned)(sizeof(kLogicTextFont5) + sizeof(kLogicTextFont4)));
+        printf("strip_bytes %u\n", (unsigned)(LOGIC_TEXT_MAX_LINES * LOGIC_TEXT_MAX_COLUMNS));
+        return 0;
+    }
+    for (int c = 0x20; c <= 0x7E; c++)
+    {
+        const LogicTextGlyph &g = logicTextGlyph(char(c));
+        printf("G %d %u", c, g.width);
+        for (int i = 0; i < LOGIC_TEXT_GLYPH_MAX_WIDTH; i++) printf(" %u", g.columns[i]);
+        printf("\n");
+        const LogicTextGlyph &g4 = logicTextGlyph(char(c), LOGIC_TEXT_SHORT_GLYPH_ROWS);
+        printf("G4 %d %u", c, g4.width);
+        for (int i = 0; i < LOGIC_TEXT_GLYPH_MAX_WIDTH; i++) printf(" %u", g4.columns[i]);
+        printf("\n");
+    }
+    LogicTextStrip s = {};
+    logicTextStripBuild(s, "HI", 5);
+    dumpStrip("S1", s);
+    logicTextStripBuild(s, "A\nB", 10);
+    dumpStrip("S2", s);
+    logicTextStripBuild(s, "A\nB", 5);
+    dumpStrip("S3", s);
+    logicTextStripBuild(s, "Hi", 4);
+    dumpStrip("S4", s);
+    memset(sFrame, 7, sizeof(sFrame));
+    blitToFrame(s, 0, 8, 4);
+    for (int y = 0; y < 4; y++)
+    {
+        printf("Q%d ", y);
+        for (int x = 0; x < 8; x++) printf("%c", sFrame[y][x] == 1 ? '#' : sFrame[y][x] == 0 ? '.' : '?');
+        printf("\n");
+    }
+    // Scroll time for a status banner: the effect starts one display width
+    // off the right edge and steps until the last column has left.
+    static const char *kBanners[] = { "GOING TO SLEEP...", "WAKING UP..." };
+    static const unsigned kDisplays[][2] = { { 9, 10 }, { 27, 4 } };
+    for (uint8_t scale = 1; scale <= 9; scale++)
+    {
+        for (unsigned b = 0; b < 2; b++)
+        {
+            for (unsigned d = 0; d < 2; d++)
+            {
+                logicTextStripBuild(s, kBanners[b], kDisplays[d][1]);
+                unsigned steps = kDisplays[d][0] + s.columnCount;
+                printf("ST %u %u %u %u\n", scale, b, d, steps * logicTextStatusStepMs(scale));
+            }
+        }
+    }
+    printf("M %u %u\n", logicTextMeasure("HI", 2), logicTextMeasure("\x01", 1));
+
+    char longText[LOGIC_TEXT_MAX_CHARS + 25];
+    memset(longText, 'W', sizeof(longText) - 1);
+    longText[sizeof(longText) - 1] = '\0';
+    uint32_t truncBefore = sLogicTextStripStats.truncated;
+    logicTextStripBuild(s, longText, 5);
+    printf("L %u %u\n", s.columnCount, sLogicTextStripStats.truncated - truncBefore);
+
+    logicTextStripBuild(s, "HI", 5);
+    memset(sFrame, 7, sizeof(sFrame));
+    blitToFrame(s, -4, 4, 5);
+    unsigned lit = 0;
+    for (int y = 0; y < 5; y++) for (int x = 0; x < 4; x++) lit += sFrame[y][x];
+    printf("B0 %u\n", lit);
+    memset(sFrame, 7, sizeof(sFrame));
+    blitToFrame(s, 0, 8, 7);
+    for (int y = 0; y < 7; y++)
+    {
+        printf("R%d ", y);
+        for (int x = 0; x < 8; x++) printf("%c", sFrame[y][x] == 1 ? '#' : sFrame[y][x] == 0 ? '.' : '?');
+        printf("\n");
+    }
+
+    const void *fld = &s;
+    const void *rld = &lit;
+    const void *psi = &truncBefore;
+    bool boundFld = logicTextStripBind(fld, "X", 10, 1, 2, 3, 4);
+    bool boundRld = logicTextStripBind(rld, "Y", 5, 0, 0, 0, 0);
+    bool boundPsi = logicTextStripBind(psi, "Z", 5, 0, 0, 0, 0);
+    printf("K %d %d %d\n", boundFld, boundRld, boundPsi);
+    const LogicTextStrip *bound = logicTextStripFor(fld);
+    printf("KB %u %u %u %u %u\n", bound->rgb[0], bound->rgb[1], bound->rgb[2], bound->stepMs, bound->lineCount);
+    for (uint8_t speed = 0; speed <= 10; speed++) printf("T %u %u\n", speed, logicTextStepMs(speed));
+    free(s.columns);
+    return 0;
+}
+"""
+
+
+class LogicTextStripTests(HarnessTestCase):
+    HARNESS_NAME = "text_strip_harness"
+    HARNESS = HARNESS
+
+    @classmethod
+    def setUpClass(cls) -> None:
+        super().setUpClass()
+        cls.lines = run_harness(cls.binary)
+
+    def rows(self, tag: str) -> list[list[str]]:
+        return [line.split()[1:] for line in self.lines if line.startswith(tag + " ")]
+
+    def strip(self, tag: str) -> tuple[int, int, list[int]]:
+        fields = self.rows(tag)[0]
+        return int(fields[0].split("=")[1]), int(fields[1].split("=")[1]), [int(v) for v in fields[2:]]
+
+    def test_font_covers_printable_ascii_within_five_rows(self) -> None:
+        glyphs = self.rows("G")
+        self.assertEqual(len(glyphs), 95)
+        for code, width, *columns in glyphs:
+            width = int(width)
+            cols = [int(c) for c in columns]
+            self.assertTrue(1 <= width <= 5, chr(int(code)))
+            self.assertTrue(all(c < 32 for c in cols), chr(int(code)))
+            self.assertTrue(all(c == 0 for c in cols[width:]), chr(int(code)))
+            if chr(int(code)) != " ":
+                self.assertTrue(any(cols[:width]), chr(int(code)))
+
+    def test_short_font_covers_printable_ascii_within_four_rows(self) -> None:
+        glyphs = {chr(int(code)): (int(width), [int(c) for c in columns])
+                  for code, width, *columns in self.rows("G4")}
+        self.assertEqual(len(glyphs), 95)
+        for ch, (width, cols) in glyphs.items():
+            self.assertTrue(1 <= width <= 5, ch)
+            self.assertTrue(all(c < 16 for c in cols), ch)
+            self.assertTrue(all(c == 0 for c in cols[width:]), ch)
+            if ch != " ":
+                self.assertTrue(any(cols[:width]), ch)
+        for ch in "abcdefghijklmnopqrstuvwxyz":
+            self.assertEqual(glyphs[ch], glyphs[ch.upper()], ch)
+
+    def test_four_row_display_shows_every_glyph_row(self) -> None:
+        glyphs = {chr(int(row[0])): [int(c) for c in row[2:2 + int(row[1])]] for row in self.rows("G4")}
+        _, cols, data = self.strip("S4")
+        self.assertEqual(data, glyphs["H"] + [0] + glyphs["I"])
+        frame = [self.rows(f"Q{y}")[0][0] for y in range(4)]
+        for x in range(8):
+            column = data[x] if x < cols else 0
+            for y in range(4):
+                self.assertEqual(frame[y][x] == "#", bool(column >> y & 1), (x, y))
+        self.assertIn("#", frame[3])
+
+    def test_status_banners_fit_the_sleep_transition(self) -> None:
+        sketch = (ROOT / "AstroPixelsPlus.ino").read_text(encoding="utf-8")
+        scale = int(re.search(r"kStatusScrollSpeedScale = (\d+);", sketch).group(1))
+        window = int(re.search(r"kSleepTransitionScrollMs = (\d+);", sketch).group(1))
+        times: dict[int, list[int]] = {}
+        for row in self.rows("ST"):
+            times.setdefault(int(row[0]), []).append(int(row[3]))
+        self.assertLessEqual(max(times[scale]), window)
+        self.assertLess(max(times[1]), max(times[scale]))
+        self.assertLess(max(times[scale]), max(times[9]))
+
+    def test_strip_is_glyph_columns_with_gap(self) -> None:
+        glyphs = {chr(int(row[0])): [int(c) for c in row[2:2 + int(row[1])]] for row in self.rows("G")}
+        lines, cols, data = self.strip("S1")
+        self.assertEqual(lines, 1)
+        self.assertEqual(data, glyphs["H"] + [0] + glyphs["I"])
+        self.assertEqual(cols, len(data))
+        self.assertEqual(self.rows("M")[0], [str(cols), str(len(glyphs["?"]))])
+
+    def test_newline_splits_only_on_tall_displays(self) -> None:
+        lines, cols, data = self.strip("S2")
+        self.assertEqual((lines, len(data)), (2, 2 * cols))
+        lines, _, _ = self.strip("S3")
+        self.assertEqual(lines, 1)
+
+    def test_long_messages_truncate_at_limit(self) -> None:
+        header = (ROOT / "LogicTextStrip.h").read_text(encoding="utf-8")
+        max_chars = int(re.search(r"#define LOGIC_TEXT_MAX_CHARS (\d+)", header).group(1))
+        self.assertGreater(max_chars, 32)
+        columns, truncated = (int(v) for v in self.rows("L")[0])
+        self.assertEqual(columns, max_chars * 6 - 1)
+        self.assertEqual(truncated, 1)
+
+    def test_blit_draws_window_and_centres_glyph_rows(self) -> None:
+        self.assertEqual(self.rows("B0")[0], ["0"])
+        frame = [self.rows(f"R{y}")[0][0] for y in range(7)]
+        self.assertEqual(frame[0], "........")
+        self.assertEqual(frame[6], "........")
+        self.assertEqual(frame[1], "#..#.###")
+        self.assertEqual(frame[3], "####..#.")
+
+    def test_bindings_are_per_renderer_and_bounded(self) -> None:
+        self.assertEqual(self.rows("K")[0], ["1", "1", "0"])
+        self.assertEqual(self.rows("KB")[0], ["1", "2", "3", "4", "1"])
+
+    def test_step_interval_tracks_speed(self) -> None:
+        steps = {int(s): int(ms) for s, ms in self.rows("T")}
+        self.assertEqual(steps[0], 40)
+        self.assertLess(steps[1], steps[9])
+        self.assertEqual(steps[10], steps[9])
+
+    def test_text_paths_use_strip_limits(self) -> None:
+        body = (ROOT / "BodyLinkWiFi.h").read_text(encoding="utf-8")
+        rx = int(re.search(r"kBodyLinkRxBufLen = (\d+)", body).group(1))
+        header = (ROOT / "LogicTextStrip.h").read_text(encoding="utf-8")
+        max_cmd = int(re.search(r"#define LOGIC_TEXT_MAX_COMMAND (\d+)", header).group(1))
+        self.assertGreaterEqual(rx, max_cmd)
+
+
+def report(frame_hz: int) -> int:
+    with report_workdir() as workdir:
+        binary = compile_harness(workdir, "text_strip_harness", HARNESS)
+        out = run_harness(binary, "bench")
+    benches = []
+    steps = {}
+    sizes = {}
+    for line in out:
+        parts = line.split()
+        if parts[0] == "bench":
+            benches.append((parts[1], float(parts[3]), float(parts[5])))
+        elif parts[0] == "step":
+            steps[int(parts[1])] = int(parts[2])
+        else:
+            sizes[parts[0]] = int(parts[1])
+    print("Logic text strip report (host timings; relative, not ESP32 absolute)")
+    print(f"  font {sizes['font_bytes']} B flash, strip buffer {sizes['strip_bytes']} B heap per bound display")
+    print(f"  legacy model re-rasterises every rendered frame at {frame_hz} Hz; the strip blits once per step")
+    for window, blit_ns, raster_ns in benches:
+        print(f"  window {window}: blit {blit_ns:.0f} ns, rasterise+blit {raster_ns:.0f} ns per frame")
+        print("    speed  step_ms  steps/s  strip us/s  legacy us/s")
+        for speed in sorted(steps):
+            per_s = 1000.0 / steps[speed]
+            print(f"    {speed:>5}  {steps[speed]:>7}  {per_s:>7.1f}  {per_s * blit_ns / 1000:>10.1f}"
+                  f"  {frame_hz * raster_ns / 1000:>11.1f}")
+    return 0
+
+
+if __name__ == "__main__":
+    if "--report" in sys.argv:
+        parser = argparse.ArgumentParser()
+        parser.add_argument("--report", action="store_true")
+        parser.add_argument("--frame-hz", type=int, default=100)
+        sys.exit(report(parser.parse_args().frame_hz))
+    unittest.main()
@@ -144,7 +144,7 @@ class MarcduinoIngressSeamTests(unittest.TestCase):
         command_admission_section = block_between(
             async_web,
             "static bool guardSleep(AsyncWebServerRequest *request, const char *cmd)",
-            "static bool isSensitivePrefKey",
+            "static String jsonEscape(const String &in)",
         )
         self.assertNotIn("parseTwoDigitTarget", command_admission_section)
         self.assertNotIn("movePanelMaskToValue", command_admission_section)
@@ -190,19 +190,19 @@ class MarcduinoIngressSeamTests(unittest.TestCase):
         )
         heartbeat = block_between(
             body_serial,
-            'if (strcmp(sBuf, "#PAHB") == 0)',
-            "else",
+            "while (sBodyUartHeartbeatsSeen != heartbeats)",
+            "BodyLinkUartFrame frame;",
         )
         command = block_between(
             body_serial,
-            "bodyLinkMarkUartActivity(now);",
-            "sBufLen = 0;",
+            "while (bodyLinkUartPop(sBodyUart, frame))",
+            "bodyLinkUartBaudPoll(",
         )
 
         self.assertNotIn("marcduinoIngressAdmit", heartbeat)
-        self.assertIn("marcduinoIngressAdmit(kMarcduinoIngressBodyLinkUart, sBuf);", command)
+        self.assertIn("marcduinoIngressAdmit(kMarcduinoIngressBodyLinkUart, frame.text);", command)
         self.assertLess(
-            command.index("marcduinoIngressAdmit(kMarcduinoIngressBodyLinkUart, sBuf);"),
+            command.index("marcduinoIngressAdmit(kMarcduinoIngressBodyLinkUart, frame.text);"),
             command.index("drainMarcduinoCommandQueue();"),
         )
 
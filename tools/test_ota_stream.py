@@ -0,0 +1,395 @@
+#!/usr/bin/env python3
+"""Host tests for Sha256.h and OtaStream.h, the firmware upload pipeline.
+
+The harness streams random images through OtaStream in uneven chunks into a
+sink that only copies a block when it is reclaimed, so a buffer reused too
+early corrupts the output. It covers digest checks, resume by offset, stall
+and progress accounting. tools/http_ota_upload.py is run against a local fake
+of /upload/firmware with a dropped first attempt to exercise resume.
+"""
+
+from __future__ import annotations
+
+import contextlib
+import hashlib
+import importlib.util
+import io
+import json
+import random
+import sys
+import threading
+import unittest
+import urllib.parse
+from http.server import BaseHTTPRequestHandler, ThreadingHTTPServer
+from pathlib import Path
+
+
+ROOT = Path(__file__).resolve().parents[1]
+sys.path.insert(0, str(ROOT / "tools"))
+
+from host_harness import HarnessTestCase, run_harness  # noqa: E402
+
+TOOL = ROOT / "tools" / "http_ota_upload.py"
+
+HARNESS = r"""
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+#include "OtaStream.h"
+
+static std::vector<uint8_t> readFile(const char *path)
+{
+    std::vector<uint8_t> out;
+    FILE *f = fopen(path, "rb");
+    int c;
+    while ((c = fgetc(f)) != EOF)
+        out.push_back((uint8_t)c);
+    fclose(f);
+    return out;
+}
+
+// Writes a block only when it is reclaimed, from the pointer it was given.
+struct LateSink
+{
+    std::vector<uint8_t> out;
+    const uint8_t *pending;
+    size_t pendingLen;
+    unsigned failAtBlock;       // 0 = never
+    unsigned blocks;
+};
+static LateSink sink;
+
+static bool lateSubmit(void *, const uint8_t *block, size_t len)
+{
+    sink.pending = block;
+    sink.pendingLen = len;
+    return true;
+}
+
+static bool lateReclaim(void *)
+{
+    sink.blocks++;
+    if (sink.failAtBlock != 0 && sink.blocks == sink.failAtBlock)
+        return false;
+    sink.out.insert(sink.out.end(), sink.pending, sink.pending + sink.pendingLen);
+    return true;
+}
+
+static const OtaStreamSink kSink = { lateSubmit, lateReclaim, nullptr };
+static OtaStream s;
+
+static void resetSink()
+{
+    sink.out.clear();
+    sink.pending = nullptr;
+    sink.pendingLen = 0;
+    sink.failAtBlock = 0;
+    sink.blocks = 0;
+}
+
+static const char *hexOf(const uint8_t digest[SHA256_DIGEST_LEN])
+{
+    static char hex[SHA256_HEX_LEN + 1];
+    sha256ToHex(digest, hex);
+    return hex;
+}
+
+// Feeds [from, to) in chunks of 1..1460 bytes, one every stepMs.
+static OtaStreamResult feed(const std::vector<uint8_t> &img, size_t from, size_t to, uint32_t &now,
+                            uint32_t stepMs, unsigned &progress)
+{
+    size_t pos = from;
+    while (pos < to)
+    {
+        size_t n = 1 + rand() % 1460;
+        if (n > to - pos)
+            n = to - pos;
+        OtaStreamResult r = otaStreamWrite(s, kSink, &img[pos], n, now);
+        if (r != kOtaStreamOk)
+            return r;
+        if (otaStreamProgressDue(s, now))
+            progress++;
+        pos += n;
+        now += stepMs;
+    }
+    return kOtaStreamOk;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc >= 3 && strcmp(argv[1], "sha") == 0)
+    {
+        // Hash each file in uneven pieces.
+        for (int i = 2; i < argc; i++)
+        {
+            std::vector<uint8_t> data = readFile(argv[i]);
+            Sha256 h;
+            sha256Init(h);
+            size_t pos = 0;
+            while (pos < data.size())
+            {
+                size_t n = 1 + rand() % 97;
+                if (n > data.size() - pos)
+                    n = data.size() - pos;
+                sha256Update(h, &data[pos], n);
+                pos += n;
+            }
+            uint8_t digest[SHA256_DIGEST_LEN];
+            sha256Final(h, digest);
+            printf("H %s %s\n", argv[i], hexOf(digest));
+        }
+        return 0;
+    }
+
+    const char *path = argv[1];
+    const char *digestHex = argv[2];
+    std::vector<uint8_t> img = readFile(path);
+    uint32_t now = 1000;
+    unsigned progress = 0;
+    srand(7);
+
+    // Straight through, 2 ms per chunk.
+    resetSink();
+    otaStreamBegin(s, img.size(), digestHex, now);
+    OtaStreamResult r = feed(img, 0, img.size(), now, 2, progress);
+    printf("D plain_write %d\n", r);
+    printf("D plain_finish %d\n", otaStreamFinish(s, kSink));
+    printf("D plain_match %d\n", sink.out == img ? 1 : 0);
+    printf("D plain_digest %s\n", hexOf(s.digest));
+    printf("S plain blocks=%u written=%u kbps=%u elapsed=%u stalls=%u progress=%u\n", s.stats.blocks, s.written,
+           otaStreamKbps(s), s.stats.elapsedMs, s.stats.stalls, progress);
+
+    // Interrupted at an odd offset, resumed 5 s later.
+    resetSink();
+    progress = 0;
+    now = 100000;
+    otaStreamBegin(s, img.size(), digestHex, now);
+    size_t cut = img.size() / 3 + 17;
+    feed(img, 0, cut, now, 2, progress);
+    now += 5000;
+    printf("D resume_bad_offset %d\n", otaStreamResume(s, cut - 1, img.size(), digestHex, now));
+    printf("D resume_bad_size %d\n", otaStreamResume(s, cut, img.size() + 1, digestHex, now));
+    printf("D resume_bad_digest %d\n",
+           otaStreamResume(s, cut, img.size(), "00000000000000000000000000000000000000000000000000000000000000ff", now));
+    printf("D resume_ok %d\n", otaStreamResume(s, cut, img.size(), digestHex, now));
+    r = feed(img, cut, img.size(), now, 2, progress);
+    printf("D resume_write %d\n", r);
+    printf("D resume_finish %d\n", otaStreamFinish(s, kSink));
+    printf("D resume_match %d\n", sink.out == img ? 1 : 0);
+    printf("S resume resumes=%u stalls=%u stallms=%u maxgap=%u\n", s.stats.resumes, s.stats.stalls,
+           s.stats.stallMs, s.stats.maxGapMs);
+
+    // Wrong digest: everything written, finish refuses.
+    resetSink();
+    otaStreamBegin(s, img.size(), "ffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffff", now);
+    feed(img, 0, img.size(), now, 2, progress);
+    printf("D wrong_digest %d\n", otaStreamFinish(s, kSink));
+    printf("D malformed_digest %d\n", otaStreamBegin(s, img.size(), "abc", now) ? 1 : 0);
+
+    // No digest and no size (the browser form): accepted as received.
+    resetSink();
+    otaStreamBegin(s, 0, "", now);
+    feed(img, 0, img.size(), now, 2, progress);
+    printf("D unverified_finish %d\n", otaStreamFinish(s, kSink));
+    printf("D unverified_match %d\n", sink.out == img ? 1 : 0);
+
+    // Size limits.
+    otaStreamBegin(s, 100, nullptr, now);
+    printf("D too_large %d\n", otaStreamWrite(s, kSink, &img[0], 101, now));
+    otaStreamBegin(s, 5000, nullptr, now);
+    otaStreamWrite(s, kSink, &img[0], 4999, now);
+    printf("D incomplete %d\n", otaStreamFinish(s, kSink));
+
+    // Sink failure on the third block.
+    resetSink();
+    sink.failAtBlock = 3;
+    otaStreamBegin(s, img.size(), digestHex, now);
+    printf("D write_failed %d\n", feed(img, 0, img.size(), now, 2, progress));
+    printf("D write_failed_finish %d\n", otaStreamFinish(s, kSink));
+
+    // Idle sessions expire.
+    otaStreamBegin(s, img.size(), digestHex, now);
+    otaStreamWrite(s, kSink, &img[0], 10, now);
+    printf("D expired_early %d\n", otaStreamExpired(s, now + OTA_STREAM_RESUME_WINDOW_MS - 1) ? 1 : 0);
+    printf("D expired_late %d\n", otaStreamExpired(s, now + OTA_STREAM_RESUME_WINDOW_MS) ? 1 : 0);
+    return 0;
+}
+"""
+
+
+def load_tool():
+    spec = importlib.util.spec_from_file_location("http_ota_upload", TOOL)
+    module = importlib.util.module_from_spec(spec)
+    spec.loader.exec_module(module)
+    return module
+
+
+class FakeController(BaseHTTPRequestHandler):
+    """The /upload/firmware resume protocol, modelled in Python."""
+
+    session: dict = {}
+    requests: list = []
+    committed: bytes | None = None
+
+    def log_message(self, *args) -> None:
+        pass
+
+    def reply(self, status: int, payload: dict) -> None:
+        body = json.dumps(payload).encode("utf-8")
+        try:
+            self.send_response(status)
+            self.send_header("Content-Type", "application/json")
+            self.send_header("Content-Length", str(len(body)))
+            self.end_headers()
+            self.wfile.write(body)
+        except (BrokenPipeError, ConnectionResetError):
+            pass
+
+    def do_GET(self) -> None:
+        s = FakeController.session
+        self.reply(200, {"active": bool(s.get("active")), "offset": len(s.get("data", b"")), "kbps": 42})
+
+    def do_POST(self) -> None:
+        url = urllib.parse.urlparse(self.path)
+        query = dict(urllib.parse.parse_qsl(url.query))
+        length = int(self.headers["Content-Length"])
+        raw = b""
+        while len(raw) < length:
+            chunk = self.rfile.read(length - len(raw))
+            if not chunk:
+                break
+            raw += chunk
+        boundary = self.headers["Content-Type"].split("boundary=")[1].encode("ascii")
+        part = raw[raw.index(b"\r\n\r\n") + 4:]
+        complete = len(raw) == length
+        if complete:
+            part = part[: -len(b"\r\n--" + boundary + b"--\r\n")]
+        offset = int(query.get("offset", 0))
+        FakeController.requests.append((offset, len(part), complete))
+        s = FakeController.session
+        if offset == 0:
+            s.clear()
+            s.update({"active": True, "data": b"", "size": int(query["size"]), "sha256": query["sha256"]})
+        elif not s.get("active") or offset != len(s["data"]):
+            self.reply(409, {"ok": False, "error": "resume offset does not match received bytes",
+                             "offset": len(s.get("data", b""))})
+            return
+        s["data"] += part
+        if not complete:
+            return
+        s["active"] = False
+        digest = hashlib.sha256(s["data"]).hexdigest()
+        if digest != s["sha256"] or len(s["data"]) != s["size"]:
+            self.reply(400, {"ok": False, "error": "sha256 mismatch"})
+            return
+        FakeController.committed = s["data"]
+        self.reply(200, {"ok": True, "sha256": digest})
+
+
+class OtaStreamTests(HarnessTestCase):
+    HARNESS_NAME = "ota_harness"
+    HARNESS = HARNESS
+
+    @classmethod
+    def setUpClass(cls) -> None:
+        super().setUpClass()
+        rng = random.Random(47)
+        cls.image = bytes(rng.getrandbits(8) for _ in range(150_001))
+        cls.image_path = cls.workdir / "firmware.bin"
+        cls.image_path.write_bytes(cls.image)
+        cls.digest = hashlib.sha256(cls.image).hexdigest()
+        cls.lines = run_harness(cls.binary, str(cls.image_path), cls.digest)
+
+    def value(self, key: str) -> str:
+        for line in self.lines:
+            if line.startswith(f"D {key} "):
+                return line.split(" ", 2)[2]
+        self.fail(f"missing {key}")
+
+    def stats(self, tag: str) -> dict[str, int]:
+        for line in self.lines:
+            if line.startswith(f"S {tag} "):
+                return {k: int(v) for k, v in (f.split("=") for f in line.split()[2:])}
+        self.fail(f"missing stats {tag}")
+
+    def test_sha256_matches_hashlib(self) -> None:
+        samples = {}
+        rng = random.Random(256)
+        for n in (0, 1, 3, 55, 56, 63, 64, 65, 119, 120, 1000, 70_000):
+            path = self.workdir / f"sha_{n}.bin"
+            data = bytes(rng.getrandbits(8) for _ in range(n))
+            path.write_bytes(data)
+            samples[str(path)] = hashlib.sha256(data).hexdigest()
+        out = run_harness(self.binary, "sha", *samples)
+        got = {line.split()[1]: line.split()[2] for line in out}
+        self.assertEqual(got, samples)
+
+    def test_image_streams_through_both_buffers_intact(self) -> None:
+        self.assertEqual(self.value("plain_write"), "0")
+        self.assertEqual(self.value("plain_finish"), "0")
+        self.assertEqual(self.value("plain_match"), "1")
+        self.assertEqual(self.value("plain_digest"), self.digest)
+        plain = self.stats("plain")
+        self.assertEqual(plain["blocks"], -(-len(self.image) // 4096))
+        self.assertEqual(plain["written"], len(self.image))
+        self.assertEqual(plain["stalls"], 0)
+        # ~730 bytes every 2 ms.
+        self.assertGreater(plain["kbps"], 250)
+        self.assertLess(plain["kbps"], 450)
+
+    def test_progress_is_rate_limited(self) -> None:
+        plain = self.stats("plain")
+        # One per 250 ms of upload plus the final 100 %, not one per chunk.
+        self.assertLessEqual(plain["progress"], plain["elapsed"] // 250 + 2)
+        self.assertGreaterEqual(plain["progress"], plain["elapsed"] // 250)
+
+    def test_resume_by_offset(self) -> None:
+        self.assertEqual(self.value("resume_bad_offset"), "2")
+        self.assertEqual(self.value("resume_bad_size"), "3")
+        self.assertEqual(self.value("resume_bad_digest"), "3")
+        self.assertEqual(self.value("resume_ok"), "0")
+        self.assertEqual(self.value("resume_write"), "0")
+        self.assertEqual(self.value("resume_finish"), "0")
+        self.assertEqual(self.value("resume_match"), "1")
+        resume = self.stats("resume")
+        self.assertEqual(resume["resumes"], 1)
+        self.assertEqual(resume["stalls"], 1)
+        self.assertEqual(resume["maxgap"], 5002)
+        self.assertEqual(resume["stallms"], 5002)
+
+    def test_digest_size_and_write_failures_are_refused(self) -> None:
+        self.assertEqual(self.value("wrong_digest"), "7")
+        self.assertEqual(self.value("malformed_digest"), "0")
+        self.assertEqual(self.value("unverified_finish"), "0")
+        self.assertEqual(self.value("unverified_match"), "1")
+        self.assertEqual(self.value("too_large"), "4")
+        self.assertEqual(self.value("incomplete"), "6")
+        self.assertEqual(self.value("write_failed"), "5")
+        self.assertEqual(self.value("write_failed_finish"), "5")
+        self.assertEqual(self.value("expired_early"), "0")
+        self.assertEqual(self.value("expired_late"), "1")
+
+    def test_upload_tool_resumes_after_a_dropped_connection(self) -> None:
+        tool = load_tool()
+        FakeController.session = {}
+        FakeController.requests = []
+        FakeController.committed = None
+        server = ThreadingHTTPServer(("127.0.0.1", 0), FakeController)
+        thread = threading.Thread(target=server.serve_forever, daemon=True)
+        thread.start()
+        try:
+            base = f"http://127.0.0.1:{server.server_address[1]}"
+            with contextlib.redirect_stdout(io.StringIO()) as out:
+                tool.upload(base, "firmware", str(self.image_path), timeout=10, resume_retries=2,
+                            drop_after=60_000)
+        finally:
+            server.shutdown()
+            server.server_close()
+        self.assertEqual(FakeController.committed, self.image)
+        self.assertEqual(FakeController.requests[0], (0, 60_000, False))
+        self.assertEqual(FakeController.requests[1], (60_000, len(self.image) - 60_000, True))
+        self.assertIn("resuming at byte 60000", out.getvalue())
+
+
+if __name__ == "__main__":
+    unittest.main()
@@ -0,0 +1,331 @@
+#!/usr/bin/env python3
+"""Host tests for per-file web asset updates (WebAssetManifest.h, web_asset_sync.py).
+
+A C++ harness checks the asset/user-data path boundary and reads the manifest
+that build_web_assets.py stages. tools/web_asset_sync.py is then run against a
+local fake of the /api/assets endpoints holding a previous build plus user
+files: only changed files may be sent, pages after the assets they reference,
+dropped files removed, and user files left untouched.
+"""
+
+from __future__ import annotations
+
+import contextlib
+import hashlib
+import io
+import json
+import re
+import shutil
+import sys
+import tempfile
+import threading
+import unittest
+import urllib.parse
+from http.server import BaseHTTPRequestHandler, ThreadingHTTPServer
+from pathlib import Path
+
+
+ROOT = Path(__file__).resolve().parents[1]
+sys.path.insert(0, str(ROOT / "tools"))
+
+import web_asset_sync  # noqa: E402
+from build_web_assets import DEFAULT_SOURCE, MANIFEST_FILE, MANIFEST_MAX, stage  # noqa: E402
+from host_harness import compile_harness, have_gxx, run_harness  # noqa: E402
+
+HARNESS = r"""
+#include <stdio.h>
+#include <string>
+#include "WebAssetManifest.h"
+
+int main(int argc, char **argv)
+{
+    if (argc >= 3 && strcmp(argv[1], "paths") == 0)
+    {
+        for (int i = 2; i < argc; i++)
+            printf("P %d %s\n", webAssetPathAllowed(argv[i]) ? 1 : 0, argv[i]);
+        return 0;
+    }
+
+    // Parse the manifest on stdin and write it back out.
+    std::string text;
+    int c;
+    while ((c = getchar()) != EOF)
+        text.push_back((char)c);
+    static WebAssetManifest m;
+    printf("D parsed %d\n", webAssetManifestParse(m, text.data(), text.size()));
+    char line[WEB_ASSET_LINE_MAX];
+    for (int i = 0; i < m.count; i++)
+    {
+        webAssetManifestFormatLine(m.entries[i], line);
+        printf("L %s", line);
+    }
+
+    // Capacity and removal.
+    uint8_t sha[SHA256_DIGEST_LEN] = {0};
+    webAssetManifestReset(m);
+    int added = 0;
+    char path[32];
+    for (int i = 0; i < WEB_ASSET_MANIFEST_MAX + 5; i++)
+    {
+        snprintf(path, sizeof(path), "/page%d.html", i);
+        added += webAssetManifestSet(m, path, (uint32_t)i, sha) ? 1 : 0;
+    }
+    printf("D added %d\n", added);
+    printf("D replace %d\n", webAssetManifestSet(m, "/page3.html", 99, sha) ? 1 : 0);
+    printf("D replaced_size %u\n", m.entries[webAssetManifestFind(m, "/page3.html")].size);
+    printf("D remove %d\n", webAssetManifestRemove(m, "/page3.html") ? 1 : 0);
+    printf("D remove_again %d\n", webAssetManifestRemove(m, "/page3.html") ? 1 : 0);
+    printf("D count %d\n", m.count);
+    printf("D user_path %d\n", webAssetManifestSet(m, "/dome-layout-template.json", 1, sha) ? 1 : 0);
+    return 0;
+}
+"""
+
+ASSET_NAME = re.compile(r"^/[A-Za-z0-9._-]+\.(html|css|js|json|png|ico|svg|txt)(\.gz)?$")
+
+
+def allowed(path: str) -> bool:
+    """webAssetPathAllowed(), for the fake controller."""
+    return (len(path) <= 31 and ".." not in path and bool(ASSET_NAME.match(path))
+            and not path.startswith(("/webfs.", "/dome-layout-template.")))
+
+
+class FakeController(BaseHTTPRequestHandler):
+    """The /api/assets endpoints over an in-memory SPIFFS."""
+
+    fs: dict[str, bytes] = {}
+    manifest: dict[str, tuple[int, str]] = {}
+    build = ""
+    log: list[tuple[str, str]] = []
+    manifest_full = False
+
+    def log_message(self, *args) -> None:
+        pass
+
+    def reply(self, status: int, payload: dict) -> None:
+        body = json.dumps(payload).encode("utf-8")
+        self.send_response(status)
+        self.send_header("Content-Type", "application/json")
+        self.send_header("Content-Length", str(len(body)))
+        self.end_headers()
+        self.wfile.write(body)
+
+    def listing(self) -> dict:
+        files = []
+        for path, data in sorted(self.fs.items()):
+            if not allowed(path):
+                continue
+            meta = self.manifest.get(path)
+            files.append({"path": path, "size": len(data),
+                          "sha256": meta[1] if meta and meta[0] == len(data) else ""})
+        user = sum(1 for p in self.fs if not allowed(p) and not p.startswith("/webfs."))
+        return {"build": FakeController.build, "files": files, "user_files": user}
+
+    def do_GET(self) -> None:
+        self.reply(200, self.listing())
+
+    def do_POST(self) -> None:
+        url = urllib.parse.urlparse(self.path)
+        body = self.rfile.read(int(self.headers.get("Content-Length", 0)))
+        if url.path == "/api/assets/file":
+            query = dict(urllib.parse.parse_qsl(url.query))
+            path = query.get("path", "")
+            if not allowed(path):
+                self.reply(400, {"ok": False, "error": "not a web asset path"})
+                return
+            digest = hashlib.sha256(body).hexdigest()
+            if digest != query.get("sha256"):
+                self.reply(400, {"ok": False, "error": "sha256 mismatch"})
+                return
+            FakeController.log.append(("upload", path))
+            self.fs[path] = body
+            if FakeController.manifest_full and path not in self.manifest:
+                self.reply(200, {"ok": True, "path": path, "manifest": False, "warning": "asset manifest is full"})
+                return
+            self.manifest[path] = (len(body), digest)
+            self.reply(200, {"ok": True, "path": path, "manifest": True})
+            return
+        form = dict(urllib.parse.parse_qsl(body.decode("ascii")))
+        removes = [p for p in form.get("remove", "").split(",") if p]
+        if not all(allowed(p) for p in removes):
+            self.reply(400, {"ok": False, "error": "not a web asset path"})
+            return
+        for path in removes:
+            FakeController.log.append(("remove", path))
+            self.fs.pop(path, None)
+            self.manifest.pop(path, None)
+        FakeController.build = form.get("build", "")
+        self.reply(200, self.listing())
+
+
+def staged_tree(source: Path, out: Path) -> dict[str, bytes]:
+    stage(source, out)
+    return {"/" + p.name: p.read_bytes() for p in out.iterdir()}
+
+
+class WebAssetSyncTests(unittest.TestCase):
+    @classmethod
+    def setUpClass(cls) -> None:
+        cls._tmp = tempfile.TemporaryDirectory()
+        cls.tmp = Path(cls._tmp.name)
+        cls.old = staged_tree(DEFAULT_SOURCE, cls.tmp / "old")
+        cls.source = cls.tmp / "src"
+        shutil.copytree(DEFAULT_SOURCE, cls.source)
+        app = cls.source / "app.js"
+        app.write_text(app.read_text(encoding="utf-8") + "\nwindow.apSyncTest = 1;\n", encoding="utf-8")
+        cls.new = staged_tree(cls.source, cls.tmp / "new")
+        cls.user = {
+            "/dome-layout-template.json": b'{"templateId":"mine"}',
+            "/dome-layout-template.apdl": b"APDL",
+            "/sprites/blink.lsa": b"APSA....",
+        }
+        cls.binary = compile_harness(cls.tmp, "asset_harness", HARNESS) if have_gxx() else None
+
+    @classmethod
+    def tearDownClass(cls) -> None:
+        cls._tmp.cleanup()
+
+    def harness(self, *args: str, stdin: str = "") -> list[str]:
+        if self.binary is None:
+            self.skipTest("g++ not available for the WebAssetManifest.h harness")
+        return run_harness(self.binary, *args, stdin=stdin)
+
+    def install(self, tree: dict[str, bytes], with_manifest: bool = True) -> None:
+        FakeController.fs = {p: d for p, d in tree.items()}
+        FakeController.fs.update(self.user)
+        FakeController.manifest = {}
+        FakeController.build = ""
+        FakeController.manifest_full = False
+        if with_manifest:
+            for line in tree["/" + MANIFEST_FILE].decode("ascii").splitlines():
+                digest, size, path = line.split(" ", 2)
+                FakeController.manifest[path] = (int(size), digest)
+            FakeController.build = tree["/webfs.id"].decode("ascii").strip()
+        FakeController.log = []
+
+    def run_sync(self, source: Path) -> dict:
+        server = ThreadingHTTPServer(("127.0.0.1", 0), FakeController)
+        thread = threading.Thread(target=server.serve_forever, daemon=True)
+        thread.start()
+        self.output = io.StringIO()
+        try:
+            with contextlib.redirect_stdout(self.output):
+                return web_asset_sync.sync(f"http://127.0.0.1:{server.server_address[1]}", source, timeout=10)
+        finally:
+            server.shutdown()
+            server.server_close()
+
+    def assets(self) -> dict[str, bytes]:
+        return {p: d for p, d in FakeController.fs.items() if allowed(p)}
+
+    def expected_assets(self, tree: dict[str, bytes]) -> dict[str, bytes]:
+        return {p: d for p, d in tree.items() if allowed(p)}
+
+    def test_path_boundary_between_assets_and_user_data(self) -> None:
+        cases = {
+            "/index.html.gz": 1, "/app.1a2b3c4d.js.gz": 1, "/icons8-r2-d2-color-32.png": 1, "/notes.txt": 1,
+            "/dome-layout-template.json": 0, "/dome-layout-template.apdl": 0, "/sprites/blink.lsa": 0,
+            "/sprites/x.html": 0, "/webfs.mf": 0, "/webfs.id": 0, "/webfs.up.tmp": 0, "/firmware.bin": 0,
+            "index.html": 0, "/../x.html": 0, "/a b.html": 0, "/" + "x" * 26 + ".html": 0,
+        }
+        lines = self.harness("paths", *cases)
+        got = {line.split(" ", 2)[2]: int(line.split()[1]) for line in lines}
+        self.assertEqual(got, cases)
+        for path, expected in cases.items():
+            self.assertEqual(allowed(path), bool(expected), path)
+
+    def test_staged_manifest_lists_every_stored_file(self) -> None:
+        out = self.tmp / "old"
+        lines = (out / MANIFEST_FILE).read_text(encoding="ascii").splitlines()
+        stored = {p for p in self.old if not p.startswith("/webfs.")}
+        self.assertEqual({line.split(" ", 2)[2] for line in lines}, stored)
+        for line in lines:
+            digest, size, path = line.split(" ", 2)
+            self.assertEqual(hashlib.sha256(self.old[path]).hexdigest(), digest)
+            self.assertEqual(len(self.old[path]), int(size))
+        self.assertLessEqual(len(lines), MANIFEST_MAX)
+
+    def test_firmware_reads_the_staged_manifest(self) -> None:
+        text = self.old["/" + MANIFEST_FILE].decode("ascii")
+        lines = self.harness(stdin=text + "garbage line\n" + "0" * 64 + " 5 /sprites/blink.lsa\n")
+        self.assertIn(f"D parsed {len(text.splitlines())}", lines)
+        self.assertEqual("".join(line[2:] + "\n" for line in lines if line.startswith("L ")), text)
+
+    def test_manifest_capacity_and_removal(self) -> None:
+        lines = self.harness(stdin="")
+        values = {line.split()[1]: line.split()[2] for line in lines if line.startswith("D ")}
+        self.assertEqual(values["added"], str(MANIFEST_MAX))
+        self.assertEqual(values["replace"], "1")
+        self.assertEqual(values["replaced_size"], "99")
+        self.assertEqual(values["remove"], "1")
+        self.assertEqual(values["remove_again"], "0")
+        self.assertEqual(values["count"], str(MANIFEST_MAX - 1))
+        self.assertEqual(values["user_path"], "0")
+
+    def test_only_changed_files_are_sent_and_user_data_survives(self) -> None:
+        self.install(self.old)
+        result = self.run_sync(self.source)
+        self.assertEqual(self.assets(), self.expected_assets(self.new))
+        for path, data in self.user.items():
+            self.assertEqual(FakeController.fs[path], data)
+        changed = {p for p, d in self.expected_assets(self.new).items() if self.old.get(p) != d}
+        self.assertEqual(set(result["uploads"]), changed)
+        self.assertLess(result["bytes"], sum(len(d) for d in self.expected_assets(self.new).values()))
+        dropped = set(self.expected_assets(self.old)) - set(self.expected_assets(self.new))
+        self.assertTrue(dropped, "the old app bundle name should be dropped")
+        self.assertEqual(set(result["removes"]), dropped)
+        self.assertEqual(FakeController.build, self.new["/webfs.id"].decode("ascii").strip())
+
+    def test_one_page_edit_sends_one_file(self) -> None:
+        source = self.tmp / "page-src"
+        if not source.exists():
+            shutil.copytree(DEFAULT_SOURCE, source)
+            page = source / "sound.html"
+            page.write_text(page.read_text(encoding="utf-8").replace("</body>", "<p>sync test</p></body>"),
+                            encoding="utf-8")
+        self.install(self.old)
+        result = self.run_sync(source)
+        self.assertEqual(result["uploads"], ["/sound.html.gz"])
+        self.assertEqual(result["removes"], [])
+
+    def test_pages_are_uploaded_after_assets_and_removals_come_last(self) -> None:
+        self.install(self.old)
+        self.run_sync(self.source)
+        kinds = [(op, path.replace(".gz", "").endswith(".html")) for op, path in FakeController.log]
+        first_page = next(i for i, (op, page) in enumerate(kinds) if op == "upload" and page)
+        self.assertTrue(all(page for op, page in kinds[first_page:] if op == "upload"))
+        first_remove = next(i for i, (op, _) in enumerate(kinds) if op == "remove")
+        self.assertTrue(all(op == "remove" for op, _ in kinds[first_remove:]))
+
+    def test_second_sync_sends_nothing(self) -> None:
+        self.install(self.new)
+        result = self.run_sync(self.source)
+        self.assertEqual(result["uploads"], [])
+        self.assertEqual(result["removes"], [])
+        self.assertEqual(FakeController.log, [])
+
+    def test_controller_without_manifest_gets_every_file(self) -> None:
+        self.install(self.old, with_manifest=False)
+        result = self.run_sync(self.source)
+        self.assertEqual(set(result["uploads"]), set(self.expected_assets(self.new)))
+        self.assertEqual(self.assets(), self.expected_assets(self.new))
+        self.assertIn("/dome-layout-template.json", FakeController.fs)
+
+    def test_file_installed_without_manifest_entry_is_a_warning(self) -> None:
+        self.install(self.old)
+        FakeController.manifest_full = True
+        result = self.run_sync(self.source)
+        self.assertEqual(self.assets(), self.expected_assets(self.new))
+        self.assertEqual(FakeController.build, self.new["/webfs.id"].decode("ascii").strip())
+        unrecorded = [p for p in result["uploads"] if p not in self.old]
+        self.assertTrue(unrecorded, "the new app bundle name should have no manifest entry")
+        for path in unrecorded:
+            self.assertIn(f"warning: {path} installed without a manifest entry", self.output.getvalue())
+        FakeController.manifest_full = False
+        again = self.run_sync(self.source)
+        self.assertEqual(again["uploads"], unrecorded)
+        self.assertEqual(again["removes"], [])
+
+
+if __name__ == "__main__":
+    unittest.main()
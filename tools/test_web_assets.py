@@ -0,0 +1,144 @@
+#!/usr/bin/env python3
+"""Tests for tools/build_web_assets.py, the hashed/gzip SPIFFS staging step.
+
+Run with --report for the before/after page-load comparison.
+"""
+
+from __future__ import annotations
+
+import gzip
+import http.client
+import re
+import shutil
+import sys
+import tempfile
+import unittest
+from pathlib import Path
+
+from build_web_assets import (
+    BUILD_ID_FILE,
+    DEFAULT_SOURCE,
+    HASH_LEN,
+    IMMUTABLE,
+    SPIFFS_MAX_PATH,
+    AssetError,
+    report,
+    serve,
+    stage,
+)
+
+
+def unpack(path: Path) -> bytes:
+    data = path.read_bytes()
+    return gzip.decompress(data) if path.suffix == ".gz" else data
+
+
+class StageTests(unittest.TestCase):
+    def setUp(self) -> None:
+        self._tmp = tempfile.TemporaryDirectory()
+        self.tmp = Path(self._tmp.name)
+        self.out = self.tmp / "webfs"
+        # Bundling is covered by test_web_bundle.py; these check hashing and gzip.
+        self.result = stage(DEFAULT_SOURCE, self.out, bundle=False)
+
+    def tearDown(self) -> None:
+        self._tmp.cleanup()
+
+    def test_shared_assets_are_hashed_and_references_rewritten(self) -> None:
+        renames = self.result["renames"]
+        for name in ("style.css", "app.js", "shell.js", "wiring-config.js", "r2d2dome.svg"):
+            self.assertRegex(renames[name], r"\.[0-9a-f]{%d}\." % HASH_LEN)
+        for served, stored in self.result["files"].items():
+            if not served.endswith((".html", ".js", ".css")):
+                continue
+            text = unpack(self.out / stored.lstrip("/")).decode("utf-8")
+            for original, hashed in renames.items():
+                self.assertNotRegex(text, r"""["'(]/%s["')]""" % re.escape(original), served)
+            for ref in re.findall(r"""["'(]/([\w.-]+\.[0-9a-f]{8}\.\w+)["')]""", text):
+                self.assertIn("/" + ref, self.result["files"], f"{served} -> {ref}")
+
+    def test_staged_files_match_sources(self) -> None:
+        renames = self.result["renames"]
+        reverse = {"/" + hashed: "/" + name for name, hashed in renames.items()}
+        for served, stored in self.result["files"].items():
+            source = (DEFAULT_SOURCE / reverse.get(served, served).lstrip("/")).read_bytes()
+            staged = unpack(self.out / stored.lstrip("/"))
+            for name, hashed in renames.items():
+                # Only quoted references; prose mentioning a file name stays.
+                source = re.sub(rb"""(["'(])/%s(?=["')?#])""" % re.escape(name).encode(),
+                                rb"\1/" + hashed.encode(), source)
+            self.assertEqual(staged, source, served)
+        self.assertTrue(self.result["files"]["/panels.html"].endswith(".gz"))
+        self.assertFalse(self.result["files"]["/icons8-r2-d2-color-32.png"].endswith(".gz"))
+
+    def test_paths_fit_spiffs(self) -> None:
+        for path in self.out.iterdir():
+            self.assertLessEqual(len("/" + path.name), SPIFFS_MAX_PATH, path.name)
+
+    def test_build_is_reproducible_and_hashes_track_content(self) -> None:
+        again = stage(DEFAULT_SOURCE, self.tmp / "again", bundle=False)
+        self.assertEqual(again, self.result)
+        source = self.tmp / "src"
+        shutil.copytree(DEFAULT_SOURCE, source)
+        (source / "app.js").write_text((source / "app.js").read_text() + "\n// changed\n")
+        changed = stage(source, self.tmp / "changed", bundle=False)
+        self.assertNotEqual(changed["renames"]["app.js"], self.result["renames"]["app.js"])
+        self.assertEqual(changed["renames"]["style.css"], self.result["renames"]["style.css"])
+        self.assertNotEqual(changed["build_id"], self.result["build_id"])
+        self.assertEqual((self.tmp / "changed" / BUILD_ID_FILE).read_text().strip(), changed["build_id"])
+
+    def test_long_hashed_name_is_rejected(self) -> None:
+        source = self.tmp / "long"
+        source.mkdir()
+        (source / "index.html").write_text('<script src="/a-very-long-script-name.js"></script>')
+        (source / "a-very-long-script-name.js").write_text("var x = 1;\n")
+        with self.assertRaises(AssetError):
+            stage(source, self.tmp / "long-out", bundle=False)
+
+
+class StaticHandlerSimulationTests(unittest.TestCase):
+    @classmethod
+    def setUpClass(cls) -> None:
+        cls._tmp = tempfile.TemporaryDirectory()
+        cls.out = Path(cls._tmp.name) / "webfs"
+        cls.result = stage(DEFAULT_SOURCE, cls.out, bundle=False)
+        cls.server = serve(cls.out, staged=True)
+
+    @classmethod
+    def tearDownClass(cls) -> None:
+        cls.server.shutdown()
+        cls._tmp.cleanup()
+
+    def get(self, path: str, **headers: str) -> http.client.HTTPResponse:
+        conn = http.client.HTTPConnection("127.0.0.1", self.server.server_port, timeout=10)
+        conn.request("GET", path, headers=headers)
+        response = conn.getresponse()
+        response.body = response.read()
+        conn.close()
+        return response
+
+    def test_hashed_asset_is_gzip_and_immutable(self) -> None:
+        path = "/" + self.result["renames"]["style.css"]
+        response = self.get(path, **{"Accept-Encoding": "gzip, deflate"})
+        self.assertEqual(response.status, 200)
+        self.assertEqual(response.getheader("Content-Encoding"), "gzip")
+        self.assertEqual(response.getheader("Content-Type"), "text/css")
+        self.assertEqual(response.getheader("Cache-Control"), IMMUTABLE)
+        self.assertEqual(gzip.decompress(response.body), (DEFAULT_SOURCE / "style.css").read_bytes())
+        again = self.get(path, **{"If-None-Match": response.getheader("ETag")})
+        self.assertEqual((again.status, again.body), (304, b""))
+
+    def test_page_revalidates_against_build_id(self) -> None:
+        response = self.get("/", **{"Accept-Encoding": "gzip"})
+        self.assertEqual(response.getheader("Cache-Control"), "no-cache")
+        self.assertEqual(response.getheader("ETag"), f'"w{self.result["build_id"]}"')
+        self.assertEqual(self.get("/index.html", **{"If-None-Match": response.getheader("ETag")}).status, 304)
+        self.assertEqual(self.get("/index.html", **{"If-None-Match": '"wdeadbeef"'}).status, 200)
+        self.assertEqual(self.get("/missing.html").status, 404)
+
+
+if __name__ == "__main__":
+    if "--report" in sys.argv:
+        with tempfile.TemporaryDirectory() as tmp:
+            sys.exit(report(DEFAULT_SOURCE, Path(tmp) / "webfs", None))
+    unittest.main()
@@ -0,0 +1,183 @@
+#!/usr/bin/env python3
+"""Tests for the per-page bundling step of tools/build_web_assets.py and the
+minifiers in tools/web_minify.py.
+
+Staged scripts are syntax-checked with `node --check` when node is installed.
+Run with --report for request counts and bytes per page load.
+"""
+
+from __future__ import annotations
+
+import gzip
+import re
+import shutil
+import subprocess
+import sys
+import tempfile
+import unittest
+from pathlib import Path
+
+from build_web_assets import CORE_BUNDLE, DEFAULT_SOURCE, SCRIPT_TAG, AssetError, report, stage
+from web_minify import (
+    MinifyError,
+    css_selectors,
+    minify_css,
+    minify_html,
+    minify_js,
+    parse_css,
+    prune_css,
+)
+
+
+def unpack(path: Path) -> str:
+    data = path.read_bytes()
+    return (gzip.decompress(data) if path.suffix == ".gz" else data).decode("utf-8")
+
+
+class MinifyJsTests(unittest.TestCase):
+    def test_comments_and_indentation_go_but_lines_stay(self) -> None:
+        src = "// head\nfunction f(a, b) {\n    /* sum */ return a + b; // tail\n}\n\n\nvar x = 1\nvar y = 2\n"
+        self.assertEqual(minify_js(src), "function f(a,b){\nreturn a+b;\n}\nvar x=1\nvar y=2\n")
+
+    def test_strings_templates_and_regexes_are_verbatim(self) -> None:
+        src = (
+            "var s = 'a // not a comment' + \"b /* nor */\";\n"
+            "var t = `x ${ y + `in ${ z }` }  /* kept */ `;\n"
+            "var r = /\\/\\/[a-z /]+/g.test(s) ? 1 : 2;\n"
+            "var d = a / b / c;\n"
+            "if (x) { return /}/.source }\n"
+        )
+        out = minify_js(src)
+        self.assertIn("'a // not a comment'", out)
+        self.assertIn('"b /* nor */"', out)
+        self.assertIn("`x ${y+`in ${z}`}  /* kept */ `", out)
+        self.assertIn("/\\/\\/[a-z /]+/g.test", out)
+        self.assertIn("a/b/c", out)
+        self.assertIn("return/}/.source", out)
+
+    def test_operators_that_would_merge_keep_a_space(self) -> None:
+        self.assertEqual(minify_js("a = b + +c; d = e - -f; g = h + ++i;").strip(),
+                         "a=b+ +c;d=e- -f;g=h+ ++i;")
+        self.assertEqual(minify_js("return typeof x;").strip(), "return typeof x;")
+
+    def test_unterminated_input_is_rejected(self) -> None:
+        for src in ("var s = 'open;\n", "/* open", "var t = `open ${ x"):
+            with self.assertRaises(MinifyError, msg=src):
+                minify_js(src)
+
+
+class MinifyCssTests(unittest.TestCase):
+    def test_whitespace_comments_and_last_semicolon(self) -> None:
+        src = "/* c */\n.a ,\n.b > .c {\n  color : red ;\n  margin: 0 auto;\n}\n"
+        self.assertEqual(minify_css(src), ".a,.b>.c{color:red;margin:0 auto}")
+
+    def test_strings_calc_and_descendant_pseudo_are_kept(self) -> None:
+        src = '.a :hover { content: "  /* x */  "; width: calc(100% - 2px); }\n@media (max-width: 399px) { .b { top: 0 } }'
+        self.assertEqual(minify_css(src),
+                         '.a :hover{content:"  /* x */  ";width:calc(100% - 2px)}@media (max-width: 399px){.b{top:0}}')
+
+    def test_prune_keeps_used_dynamic_and_element_rules(self) -> None:
+        css = parse_css(
+            ".used{a:1}.unused{b:2}.status-ok{c:3}div>span{d:4}.used,.unused2{e:5}"
+            "a[href$=\".png\"]{f:6}.x:not(.missing){g:7}#page{h:8}@media (x){.unused{i:9}.used{j:10}}"
+        )
+        corpus = '<div class="used x" id="page"></div><script>el.className = \'status-\' + s;</script>'
+        self.assertEqual(css_selectors(prune_css(css, corpus)),
+                         [".used", ".status-ok", "div>span", ".used", 'a[href$=".png"]', ".x:not(.missing)",
+                          "#page", ".used"])
+
+
+class MinifyHtmlTests(unittest.TestCase):
+    def test_markup_collapses_but_raw_text_and_attributes_do_not(self) -> None:
+        src = (
+            "<!DOCTYPE html>\n<div   class=\"a  b\"\n     id=x>\n   hello   <b>world</b>\n</div>"
+            "<!-- gone -->\n<pre>  keep\n   this  </pre>\n"
+            "<script>\n  var a = 1; // c\n</script>\n<script type=\"text/template\">  raw  </script>"
+        )
+        self.assertEqual(
+            minify_html(src),
+            "<!DOCTYPE html>\n<div class=\"a  b\" id=x>\nhello <b>world</b>\n</div>\n"
+            "<pre>  keep\n   this  </pre>\n<script>var a=1;</script>\n<script type=\"text/template\">  raw  </script>\n",
+        )
+
+
+class BundleTests(unittest.TestCase):
+    @classmethod
+    def setUpClass(cls) -> None:
+        cls._tmp = tempfile.TemporaryDirectory()
+        cls.tmp = Path(cls._tmp.name)
+        cls.out = cls.tmp / "webfs"
+        cls.result = stage(DEFAULT_SOURCE, cls.out)
+        cls.pages = {served: unpack(cls.out / stored.lstrip("/"))
+                     for served, stored in cls.result["files"].items() if served.endswith(".html")}
+
+    @classmethod
+    def tearDownClass(cls) -> None:
+        cls._tmp.cleanup()
+
+    def test_every_page_loads_the_core_bundle_first(self) -> None:
+        core = "/" + self.result["renames"][CORE_BUNDLE]
+        for page, html in self.pages.items():
+            scripts = re.findall(r'<script src="(/[^"]+)"></script>', html)
+            self.assertEqual(scripts[0], core, page)
+            self.assertNotIn("/shell.", html)
+            self.assertNotIn("/app.", html)
+        self.assertIn("/" + self.result["renames"]["wiring-config.js"], self.pages["/panels.html"])
+        self.assertNotIn("wiring-config", self.pages["/index.html"])
+        # The core is shell.js then app.js, the order every page loaded them in.
+        source = (DEFAULT_SOURCE / "index.html").read_text()
+        self.assertEqual(SCRIPT_TAG.findall(source)[:2], ["shell.js", "app.js"])
+
+    def test_stylesheet_is_inlined_and_pruned_per_page(self) -> None:
+        for page, html in self.pages.items():
+            self.assertNotIn('rel="stylesheet"', html, page)
+            self.assertIn("<style>:root{", html, page)
+        self.assertIn(".aple-color-grid", self.pages["/logics.html"])
+        self.assertNotIn(".aple-color-grid", self.pages["/sound.html"])
+        self.assertNotIn(".subtitle{", "".join(self.pages.values()))
+        # Consumed sources are not shipped.
+        for name in ("style.css", "shell.js", "app.js"):
+            self.assertNotIn("/" + name, self.result["files"])
+
+    def test_build_is_reproducible(self) -> None:
+        self.assertEqual(stage(DEFAULT_SOURCE, self.tmp / "again"), self.result)
+
+    def test_reserved_bundle_name_is_rejected(self) -> None:
+        source = self.tmp / "reserved"
+        source.mkdir()
+        (source / "index.html").write_text("<p>x</p>")
+        (source / CORE_BUNDLE).write_text("var x;")
+        with self.assertRaises(AssetError):
+            stage(source, self.tmp / "reserved-out")
+
+    def test_staged_scripts_parse(self) -> None:
+        node = shutil.which("node")
+        if node is None:
+            self.skipTest("node not available")
+        scripts = self.tmp / "scripts"
+        scripts.mkdir(exist_ok=True)
+        count = 0
+        for served, stored in self.result["files"].items():
+            if not served.endswith((".js", ".html")):
+                continue
+            text = unpack(self.out / stored.lstrip("/"))
+            if served.endswith(".js"):
+                bodies = [text]
+            elif served.endswith(".html"):
+                bodies = [m.group(1) for m in re.finditer(r"<script>(.*?)</script>", text, re.S)]
+            else:
+                continue
+            for body in bodies:
+                path = scripts / f"s{count}.js"
+                path.write_text(body)
+                result = subprocess.run([node, "--check", str(path)], capture_output=True, text=True)
+                self.assertEqual(result.returncode, 0, f"{served}: {result.stderr}")
+                count += 1
+        self.assertGreater(count, 10)
+
+
+if __name__ == "__main__":
+    if "--report" in sys.argv:
+        with tempfile.TemporaryDirectory() as tmp:
+            sys.exit(report(DEFAULT_SOURCE, Path(tmp) / "webfs", None))
+    unittest.main()
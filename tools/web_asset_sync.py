@@ -0,0 +1,143 @@
+#!/usr/bin/env python3
+"""Update the controller's web UI file by file instead of reflashing SPIFFS.
+
+Stages data/ with build_web_assets.py, compares the staged manifest with
+GET /api/assets, and uploads only the files whose SHA-256 differs. Each file
+is installed atomically on the controller (temporary file, then rename).
+Hashed assets go first and pages last, so a page never references a file
+that is not there yet; files the new build dropped are removed at the end
+together with the new build id. User data (the custom dome layout, logic
+sprites) is not an asset and is left alone.
+
+    python3 tools/web_asset_sync.py --host astropixelsplus.local
+    python3 tools/web_asset_sync.py --dry-run
+"""
+
+from __future__ import annotations
+
+import argparse
+import json
+import sys
+import tempfile
+import urllib.error
+import urllib.parse
+import urllib.request
+from pathlib import Path
+
+sys.path.insert(0, str(Path(__file__).resolve().parent))
+
+from build_web_assets import BUILD_ID_FILE, DEFAULT_SOURCE, MANIFEST_FILE, AssetError, stage  # noqa: E402
+
+
+LIST_PATH = "/api/assets"
+FILE_PATH = "/api/assets/file"
+COMMIT_PATH = "/api/assets/commit"
+
+
+def normalize_base_url(host: str) -> str:
+    if "://" not in host:
+        host = "http://" + host
+    return host.rstrip("/")
+
+
+def read_manifest(root: Path) -> dict[str, tuple[int, str]]:
+    files = {}
+    for line in (root / MANIFEST_FILE).read_text(encoding="ascii").splitlines():
+        digest, size, path = line.split(" ", 2)
+        files[path] = (int(size), digest)
+    return files
+
+
+def plan(local: dict[str, tuple[int, str]], device: list[dict]) -> tuple[list[str], list[str]]:
+    """Returns (paths to upload, pages last; paths to remove)."""
+    remote = {f["path"]: (int(f["size"]), f.get("sha256", "")) for f in device}
+    uploads = [path for path, meta in local.items() if remote.get(path) != meta]
+    uploads.sort(key=lambda path: (path.replace(".gz", "").endswith(".html"), path))
+    removes = sorted(path for path in remote if path not in local)
+    return uploads, removes
+
+
+def request_json(req: urllib.request.Request, timeout: float) -> tuple[int, dict]:
+    try:
+        with urllib.request.urlopen(req, timeout=timeout) as resp:
+            return resp.status, json.loads(resp.read() or b"{}")
+    except urllib.error.HTTPError as exc:
+        try:
+            return exc.code, json.loads(exc.read() or b"{}")
+        except json.JSONDecodeError:
+            return exc.code, {}
+
+
+def sync(base_url: str, source: Path, timeout: float, dry_run: bool = False) -> dict:
+    with tempfile.TemporaryDirectory() as tmp:
+        staged = Path(tmp) / "webfs"
+        stage(source, staged)
+        local = read_manifest(staged)
+        build_id = (staged / BUILD_ID_FILE).read_text(encoding="ascii").strip()
+
+        status, device = request_json(urllib.request.Request(base_url + LIST_PATH), timeout)
+        if status != 200:
+            raise RuntimeError(f"GET {LIST_PATH} returned HTTP {status}")
+        uploads, removes = plan(local, device.get("files", []))
+        sent = sum(local[path][0] for path in uploads)
+        total = sum(size for size, _ in local.values())
+        print(f"Build {build_id}: {len(uploads)} of {len(local)} files changed "
+              f"({sent} of {total} bytes), {len(removes)} to remove; "
+              f"controller build {device.get('build') or '-'}, "
+              f"{device.get('user_files', 0)} user files kept")
+        for path in uploads:
+            print(f"  upload {path} ({local[path][0]} bytes)")
+        for path in removes:
+            print(f"  remove {path}")
+        if dry_run:
+            return {"uploads": uploads, "removes": removes, "bytes": sent}
+        if not uploads and not removes and device.get("build") == build_id:
+            print("Controller is up to date.")
+            return {"uploads": [], "removes": [], "bytes": 0}
+
+        for path in uploads:
+            size, digest = local[path]
+            query = urllib.parse.urlencode({"path": path, "sha256": digest})
+            req = urllib.request.Request(base_url + FILE_PATH + "?" + query,
+                                         data=(staged / path.lstrip("/")).read_bytes(), method="POST",
+                                         headers={"Content-Type": "application/octet-stream"})
+            status, reply = request_json(req, timeout)
+            if status != 200 or reply.get("ok") is not True:
+                raise RuntimeError(f"{path} rejected with HTTP {status}: {reply.get('error', reply)}")
+            if reply.get("manifest") is False:
+                # Installed, but the controller could not record its digest; the
+                # next sync sees no sha256 for it and sends it again.
+                print(f"  warning: {path} installed without a manifest entry: {reply.get('warning', '')}")
+
+        body = urllib.parse.urlencode({"build": build_id, "remove": ",".join(removes)}).encode("ascii")
+        req = urllib.request.Request(base_url + COMMIT_PATH, data=body, method="POST",
+                                     headers={"Content-Type": "application/x-www-form-urlencoded"})
+        status, reply = request_json(req, timeout)
+        if status != 200:
+            raise RuntimeError(f"commit rejected with HTTP {status}: {reply.get('error', reply)}")
+        print(f"Controller now at build {reply.get('build', build_id)}.")
+        return {"uploads": uploads, "removes": removes, "bytes": sent}
+
+
+def parse_args(argv: list[str]) -> argparse.Namespace:
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--host", default="astropixelsplus.local",
+                        help="controller host, IP, or base URL (default: astropixelsplus.local)")
+    parser.add_argument("--source", type=Path, default=DEFAULT_SOURCE, help="web source tree (default: data/)")
+    parser.add_argument("--timeout", type=float, default=30, help="per-request timeout in seconds")
+    parser.add_argument("--dry-run", action="store_true", help="show what would change and stop")
+    return parser.parse_args(argv)
+
+
+def main(argv: list[str]) -> int:
+    args = parse_args(argv)
+    try:
+        sync(normalize_base_url(args.host), args.source, args.timeout, args.dry_run)
+    except (AssetError, OSError, RuntimeError, ValueError) as exc:
+        print(f"error: {exc}", file=sys.stderr)
+        return 1
+    return 0
+
+
+if __name__ == "__main__":
+    raise SystemExit(main(sys.argv[1:]))
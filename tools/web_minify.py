@@ -0,0 +1,448 @@
+#!/usr/bin/env python3
+"""Conservative HTML/CSS/JS minifiers for the web UI staging step.
+
+No third-party packages. The JS pass only drops comments and collapses
+whitespace; it keeps line breaks so automatic semicolon insertion behaves as
+in the source. The CSS pass can also drop rules whose class or id selectors
+never appear in a page (prune_css). Used by tools/build_web_assets.py.
+"""
+
+from __future__ import annotations
+
+import re
+
+
+class MinifyError(ValueError):
+    pass
+
+
+# ---------------------------------------------------------------
+# JavaScript
+# ---------------------------------------------------------------
+
+_REGEX_AFTER = set("(,=:[!&|?{};+-*%<>~^")
+_REGEX_AFTER_WORDS = {
+    "return", "typeof", "case", "do", "else", "in", "of", "new", "delete",
+    "void", "throw", "instanceof", "yield", "await",
+}
+
+
+def _is_word(ch: str) -> bool:
+    return ch.isalnum() or ch in "_$" or ord(ch) > 127
+
+
+def _skip_quoted(src: str, i: int) -> int:
+    """Returns the index just past the string starting at src[i]."""
+    quote = src[i]
+    i += 1
+    while i < len(src):
+        ch = src[i]
+        if ch == "\\":
+            i += 2
+            continue
+        if ch == quote:
+            return i + 1
+        if ch == "\n" and quote != "`":
+            break
+        i += 1
+    raise MinifyError(f"unterminated string at offset {i}")
+
+
+def _skip_regex(src: str, i: int) -> int:
+    in_class = False
+    i += 1
+    while i < len(src):
+        ch = src[i]
+        if ch == "\\":
+            i += 2
+            continue
+        if ch == "\n":
+            break
+        if ch == "[":
+            in_class = True
+        elif ch == "]":
+            in_class = False
+        elif ch == "/" and not in_class:
+            i += 1
+            while i < len(src) and _is_word(src[i]):
+                i += 1
+            return i
+        i += 1
+    raise MinifyError(f"unterminated regular expression at offset {i}")
+
+
+def _scan_template(src: str, i: int) -> tuple[int, bool]:
+    """Copies template text from i; returns (end, opened_substitution)."""
+    while i < len(src):
+        ch = src[i]
+        if ch == "\\":
+            i += 2
+            continue
+        if ch == "`":
+            return i + 1, False
+        if ch == "$" and i + 1 < len(src) and src[i + 1] == "{":
+            return i + 2, True
+        i += 1
+    raise MinifyError("unterminated template literal")
+
+
+def minify_js(src: str) -> str:
+    out: list[str] = []
+    last = ""          # last significant character written
+    word = ""          # identifier/keyword being written, or the last one
+    pending = ""       # "", " " or "\n": whitespace seen since `last`
+    depth = 0
+    templates: list[int] = []   # brace depth at each open ${
+    i = 0
+    n = len(src)
+
+    def emit(text: str, first: str) -> None:
+        nonlocal pending, last
+        if pending and out:
+            if pending == "\n":
+                out.append("\n")
+            elif (_is_word(last) and _is_word(first)) or (last in "+-/" and first == last):
+                out.append(" ")
+        pending = ""
+        out.append(text)
+        last = text[-1]
+
+    while i < n:
+        ch = src[i]
+        if ch in " \t\r\n\f\v":
+            if ch == "\n":
+                pending = "\n"
+            elif not pending:
+                pending = " "
+            i += 1
+            continue
+        if ch == "/" and src.startswith("//", i):
+            end = src.find("\n", i)
+            i = n if end < 0 else end
+            continue
+        if ch == "/" and src.startswith("/*", i):
+            end = src.find("*/", i + 2)
+            if end < 0:
+                raise MinifyError("unterminated comment")
+            if "\n" in src[i:end]:
+                pending = "\n"
+            elif not pending:
+                pending = " "
+            i = end + 2
+            continue
+        if ch in "'\"":
+            end = _skip_quoted(src, i)
+            emit(src[i:end], ch)
+            word = ""
+            i = end
+            continue
+        if ch == "`" or (ch == "}" and templates and templates[-1] == depth):
+            if ch == "}":
+                templates.pop()
+            end, opened = _scan_template(src, i + 1)
+            emit(src[i:end], ch)
+            if opened:
+                templates.append(depth)
+            word = ""
+            i = end
+            continue
+        if ch == "/" and (not last or last in _REGEX_AFTER or
+                          (_is_word(last) and word in _REGEX_AFTER_WORDS)):
+            end = _skip_regex(src, i)
+            emit(src[i:end], ch)
+            word = ""
+            i = end
+            continue
+        if _is_word(ch):
+            end = i
+            while end < n and _is_word(src[end]):
+                end += 1
+            word = src[i:end]
+            emit(word, ch)
+            i = end
+            continue
+        if ch == "{":
+            depth += 1
+        elif ch == "}":
+            depth -= 1
+        emit(ch, ch)
+        word = ""
+        i += 1
+    if templates:
+        raise MinifyError("unterminated template substitution")
+    return "".join(out).strip() + "\n"
+
+
+# ---------------------------------------------------------------
+# CSS
+# ---------------------------------------------------------------
+
+def _strip_css_comments(src: str) -> str:
+    out = []
+    i = 0
+    while i < len(src):
+        ch = src[i]
+        if ch in "'\"":
+            end = _skip_quoted(src, i)
+            out.append(src[i:end])
+            i = end
+        elif src.startswith("/*", i):
+            end = src.find("*/", i + 2)
+            if end < 0:
+                raise MinifyError("unterminated CSS comment")
+            out.append(" ")
+            i = end + 2
+        else:
+            out.append(ch)
+            i += 1
+    return "".join(out)
+
+
+def _collapse(text: str, tight: str) -> str:
+    """Collapses whitespace outside strings and drops it around `tight` characters."""
+    out: list[str] = []
+    i = 0
+    space = False
+    while i < len(text):
+        ch = text[i]
+        if ch.isspace():
+            space = True
+            i += 1
+            continue
+        if ch in "'\"":
+            end = _skip_quoted(text, i)
+            piece = text[i:end]
+            i = end
+        else:
+            piece = ch
+            i += 1
+        if space and out and out[-1][-1] not in tight and piece[0] not in tight:
+            out.append(" ")
+        space = False
+        out.append(piece)
+    return "".join(out)
+
+
+def _find_outside(text: str, i: int, targets: str) -> int:
+    parens = 0
+    while i < len(text):
+        ch = text[i]
+        if ch in "'\"":
+            i = _skip_quoted(text, i)
+            continue
+        if ch == "(":
+            parens += 1
+        elif ch == ")":
+            parens -= 1
+        elif parens == 0 and ch in targets:
+            return i
+        i += 1
+    return -1
+
+
+def _matching_brace(text: str, i: int) -> int:
+    depth = 0
+    while i < len(text):
+        ch = text[i]
+        if ch in "'\"":
+            i = _skip_quoted(text, i)
+            continue
+        if ch == "{":
+            depth += 1
+        elif ch == "}":
+            depth -= 1
+            if depth == 0:
+                return i
+        i += 1
+    raise MinifyError("unbalanced braces in CSS")
+
+
+def parse_css(src: str) -> list:
+    """Returns [(prelude, body)] where body is a nested list for grouping
+    at-rules, a declaration string for rules, or None for statements."""
+    return _parse_css_block(_strip_css_comments(src))
+
+
+def _parse_css_block(src: str) -> list:
+    nodes = []
+    i = 0
+    while True:
+        while i < len(src) and src[i].isspace():
+            i += 1
+        if i >= len(src):
+            return nodes
+        stop = _find_outside(src, i, "{;}")
+        if stop < 0 or src[stop] == "}":
+            raise MinifyError("unexpected end of CSS block")
+        prelude = src[i:stop].strip()
+        if src[stop] == ";":
+            nodes.append((prelude, None))
+            i = stop + 1
+            continue
+        end = _matching_brace(src, stop)
+        body = src[stop + 1:end]
+        if re.match(r"@(media|supports|document|layer)\b", prelude):
+            nodes.append((prelude, _parse_css_block(body)))
+        else:
+            nodes.append((prelude, body))
+        i = end + 1
+
+
+def _minify_declarations(body: str) -> str:
+    decls = []
+    i = 0
+    while i <= len(body):
+        stop = _find_outside(body, i, ";")
+        if stop < 0:
+            stop = len(body)
+        decl = body[i:stop].strip()
+        if decl:
+            name, colon, value = decl.partition(":")
+            decls.append(name.strip() + colon + _collapse(value.strip(), ",") if colon else _collapse(decl, ","))
+        i = stop + 1
+    return ";".join(decls)
+
+
+def render_css(nodes: list) -> str:
+    out = []
+    for prelude, body in nodes:
+        if body is None:
+            out.append(_collapse(prelude, "") + ";")
+        elif isinstance(body, list):
+            inner = render_css(body)
+            if inner:
+                out.append(_collapse(prelude, "") + "{" + inner + "}")
+        elif prelude.startswith("@"):
+            inner = render_css(_parse_css_block(body)) if "{" in body else _minify_declarations(body)
+            out.append(_collapse(prelude, "") + "{" + inner + "}")
+        else:
+            out.append(_collapse(prelude, ",>") + "{" + _minify_declarations(body) + "}")
+    return "".join(out)
+
+
+def minify_css(src: str) -> str:
+    return render_css(parse_css(src))
+
+
+_SELECTOR_NAMES = re.compile(r"([.#])(-?[A-Za-z_][\w-]*)")
+
+
+def selector_is_used(selector: str, words: set[str], prefixes: set[str]) -> bool:
+    # Attribute values and :not() arguments never have to be present.
+    bare = re.sub(r"\[[^\]]*\]", "", selector)
+    bare = re.sub(r":not\([^)]*\)", "", bare)
+    for _, name in _SELECTOR_NAMES.findall(bare):
+        if name in words:
+            continue
+        # 'status-' + state builds status-ok at runtime.
+        if any(name.startswith(prefix) for prefix in prefixes):
+            continue
+        return False
+    return True
+
+
+def prune_css(nodes: list, corpus: str) -> list:
+    """Drops rules whose every selector names a class or id missing from corpus."""
+    tokens = set(re.findall(r"[\w-]+", corpus))
+    words = {token for token in tokens if not token.endswith("-")}
+    prefixes = {token for token in tokens if token.endswith("-") and len(token) > 2}
+    kept = []
+    for prelude, body in nodes:
+        if isinstance(body, list):
+            inner = prune_css(body, corpus)
+            if inner:
+                kept.append((prelude, inner))
+        elif body is None or prelude.startswith("@"):
+            kept.append((prelude, body))
+        else:
+            parts = []
+            i = 0
+            while True:
+                stop = _find_outside(prelude, i, ",")
+                part = prelude[i:] if stop < 0 else prelude[i:stop]
+                if selector_is_used(part, words, prefixes):
+                    parts.append(part.strip())
+                if stop < 0:
+                    break
+                i = stop + 1
+            if parts:
+                kept.append((",".join(parts), body))
+    return kept
+
+
+def css_selectors(nodes: list) -> list[str]:
+    out = []
+    for prelude, body in nodes:
+        if isinstance(body, list):
+            out.extend(css_selectors(body))
+        elif body is not None and not prelude.startswith("@"):
+            out.append(_collapse(prelude, ",>"))
+    return out
+
+
+# ---------------------------------------------------------------
+# HTML
+# ---------------------------------------------------------------
+
+_RAW_TEXT = re.compile(r"<(script|style|pre|textarea)\b([^>]*)>(.*?)</\1\s*>", re.S | re.I)
+
+
+def _minify_markup(text: str) -> str:
+    text = re.sub(r"<!--(?!\[).*?-->", "", text, flags=re.S)
+    out: list[str] = []
+    i = 0
+    while i < len(text):
+        ch = text[i]
+        if ch == "<":
+            # Inside a tag: collapse whitespace but leave quoted values alone.
+            end = i + 1
+            while end < len(text) and text[end] != ">":
+                if text[end] in "'\"":
+                    close = text.find(text[end], end + 1)
+                    end = len(text) if close < 0 else close
+                end += 1
+            out.append(_collapse_tag(text[i:end + 1]))
+            i = end + 1
+            continue
+        end = text.find("<", i)
+        end = len(text) if end < 0 else end
+        out.append(re.sub(r"\s+", lambda m: "\n" if "\n" in m.group(0) else " ", text[i:end]))
+        i = end
+    return "".join(out)
+
+
+def _collapse_tag(tag: str) -> str:
+    out = []
+    i = 0
+    while i < len(tag):
+        ch = tag[i]
+        if ch in "'\"":
+            close = tag.find(ch, i + 1)
+            close = len(tag) - 1 if close < 0 else close
+            out.append(tag[i:close + 1])
+            i = close + 1
+        elif ch.isspace():
+            while i < len(tag) and tag[i].isspace():
+                i += 1
+            if out and i < len(tag) and tag[i] not in ">/" and not out[-1].endswith("="):
+                out.append(" ")
+        else:
+            out.append(ch)
+            i += 1
+    return "".join(out)
+
+
+def minify_html(src: str) -> str:
+    out = []
+    pos = 0
+    for match in _RAW_TEXT.finditer(src):
+        out.append(_minify_markup(src[pos:match.start()]))
+        name, attrs, body = match.group(1).lower(), match.group(2), match.group(3)
+        if name == "script" and body.strip() and not re.search(r"\btype\s*=", attrs):
+            body = minify_js(body).rstrip("\n")
+        elif name == "style":
+            body = minify_css(body)
+        out.append(_collapse_tag(f"<{match.group(1)}{attrs}>") + body + f"</{match.group(1)}>")
+        pos = match.end()
+    out.append(_minify_markup(src[pos:]))
+    return "".join(out).strip() + "\n"
@@ -3,8 +3,8 @@
 
 /////////////////////////////////////////////////////////////////////////
 
-WSVG rseriesSVG(
-R"RAW(
+// R-Series logo shown at the foot of every legacy page (WebPages.h).
+static const char kRSeriesSVG[] = R"RAW(
 <svg version="1.0" xmlns="http://www.w3.org/2000/svg"
  width="64.000000pt" height="64.000000pt" viewBox="0 0 64.000000 64.000000"
  preserveAspectRatio="xMidYMid meet">
@@ -39,6 +39,6 @@ l57 24 1155 -3 1155 -2 55 -26z"/>
 -188 262 -337 331 -135 63 -157 66 -605 71 l-408 5 0 -2499z"/>
 </g>
 </svg>
-)RAW");
+)RAW";
 
 #endif